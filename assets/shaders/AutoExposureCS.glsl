@@ -0,0 +1,72 @@
+#version 460
+
+/*
+
+	Reduces the luminance histogram to the average log luminance of the frame with a parallel reduction in shared memory,
+	adapts the luminance towards it over time, and derives the exposure from the adapted luminance
+	Also clears the histogram, so that the next frame can accumulate into it again
+	Source: https://bruop.github.io/exposure/
+
+*/
+
+#include "Common.glsl"
+
+layout(set = DESCRIPTOR_SET_STORAGE_BUFFER, binding = 0, std430) restrict buffer AutoExposureRWSSBOs
+{
+	AutoExposureData data;
+} g_auto_exposure_rw_ssbos[];
+
+layout(std140, push_constant) uniform PushConsts
+{
+	layout(offset = 0) uint buffer_index;
+	layout(offset = 4) uint num_pixels;
+	layout(offset = 8) float delta_time;
+} push;
+
+layout(local_size_x = LUMINANCE_HISTOGRAM_NUM_BINS) in;
+
+shared float s_weighted_counts[LUMINANCE_HISTOGRAM_NUM_BINS];
+
+// Maps the average scene luminance to middle grey, from the saturation based exposure with a sensor sensitivity of 100 and a calibration constant of 12.5
+// Source: https://seblagarde.files.wordpress.com/2015/07/course_notes_moving_frostbite_to_pbr_v32.pdf
+float LuminanceToExposure(float luminance)
+{
+	return 1.0 / (9.6 * luminance);
+}
+
+void main()
+{
+	uint bin = gl_LocalInvocationIndex;
+	uint bin_count = g_auto_exposure_rw_ssbos[push.buffer_index].data.histogram[bin];
+
+	s_weighted_counts[bin] = float(bin_count) * float(bin);
+	g_auto_exposure_rw_ssbos[push.buffer_index].data.histogram[bin] = 0;
+	barrier();
+
+	for (uint stride = LUMINANCE_HISTOGRAM_NUM_BINS / 2; stride > 0; stride >>= 1)
+	{
+		if (bin < stride)
+			s_weighted_counts[bin] += s_weighted_counts[bin + stride];
+
+		barrier();
+	}
+
+	if (bin == 0)
+	{
+		// Bin 0 has a weight of 0, but the pixels in it should not count towards the average either
+		float num_measured_pixels = max(float(push.num_pixels) - float(bin_count), 1.0);
+		float average_bin = s_weighted_counts[0] / num_measured_pixels - 1.0;
+		float average_log_luminance = (average_bin / float(LUMINANCE_HISTOGRAM_NUM_BINS - 2)) * settings.postfx_auto_exposure_log_luminance_range +
+			settings.postfx_auto_exposure_min_log_luminance;
+		float average_luminance = exp2(average_log_luminance);
+
+		float adapted_luminance = g_auto_exposure_rw_ssbos[push.buffer_index].data.adapted_luminance;
+		if (adapted_luminance <= 0.0 || isnan(adapted_luminance) || isinf(adapted_luminance))
+			adapted_luminance = average_luminance;
+		else
+			adapted_luminance += (average_luminance - adapted_luminance) * (1.0 - exp(-push.delta_time * settings.postfx_auto_exposure_adaptation_rate));
+
+		g_auto_exposure_rw_ssbos[push.buffer_index].data.adapted_luminance = adapted_luminance;
+		g_auto_exposure_rw_ssbos[push.buffer_index].data.exposure = LuminanceToExposure(adapted_luminance);
+	}
+}
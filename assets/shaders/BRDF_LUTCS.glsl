@@ -2,31 +2,22 @@
 
 /*
 
-	This shader generates the BRDF look-up table (BRDF integration map) used in image-based lighting for the specular light
+	This compute shader generates the BRDF look-up table (BRDF integration map) used in image-based lighting for the specular light
 
 */
 
 #include "BRDF.glsl"
 
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rg16f) uniform restrict writeonly image2D g_outputs[];
+
 layout(std140, push_constant) uniform PushConsts
 {
 	layout(offset = 0) uint num_samples;
+	layout(offset = 4) uint dst_texture_index;
+	layout(offset = 8) uint dst_resolution;
 } push;
 
-layout(location = 0) in vec2 tex_coord;
-
-layout(location = 0) out vec2 out_color;
-
-float GeometrySchlickGGX(float NdotV, float roughness)
-{
-    float a = roughness;
-    float k = (a * a) / 2.0;
-
-    float nom   = NdotV;
-    float denom = NdotV * (1.0 - k) + k;
-
-    return nom / denom;
-}
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
 
 float G_SchlicksmithGGX(float NoL, float NoV, float roughness)
 {
@@ -59,7 +50,6 @@ vec2 IntegrateBRDF(float NoV, float roughness)
 			float G_Vis = (G * dotVH) / (dotNH * dotNV);
 			float Fc = pow(1.0 - dotVH, 5.0);
 
-			//LUT += vec2(G_Vis * Fc, G_Vis);
 			LUT += vec2((1.0 - Fc) * G_Vis, Fc * G_Vis);
 		}
 	}
@@ -69,6 +59,12 @@ vec2 IntegrateBRDF(float NoV, float roughness)
 
 void main()
 {
+	uvec2 texel = gl_GlobalInvocationID.xy;
+	if (texel.x >= push.dst_resolution || texel.y >= push.dst_resolution)
+		return;
+
+	vec2 tex_coord = (vec2(texel) + 0.5) / float(push.dst_resolution);
 	vec2 integrated_brdf = IntegrateBRDF(tex_coord.s, tex_coord.t);
-	out_color = integrated_brdf;
+
+	imageStore(g_outputs[push.dst_texture_index], ivec2(texel), vec4(integrated_brdf, 0.0, 0.0));
 }
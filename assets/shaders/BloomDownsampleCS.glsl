@@ -0,0 +1,110 @@
+#version 460
+
+/*
+
+	Downsamples the bloom chain with the dual filter downsample, a weighted sum of five bilinear taps around the destination texel
+	The source texels a workgroup needs are loaded into shared memory once, since neighbouring threads share most of their taps
+	The first downsample from the post-processing source uses a Karis average on every tap, to keep single very bright pixels from flickering
+	Source: https://community.arm.com/cfs-file/__key/communityserver-blogs-components-weblogfiles/00-00-00-20-66/siggraph2015_2D00_mmg_2D00_marius_2D00_notes.pdf
+	Source: https://www.iryoku.com/next-generation-post-processing-in-call-of-duty-advanced-warfare/
+
+*/
+
+#include "Common.glsl"
+
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16f) uniform restrict readonly image2D g_inputs[];
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16f) uniform restrict writeonly image2D g_outputs[];
+
+layout(std140, push_constant) uniform PushConsts
+{
+	layout(offset = 0) uint src_index;
+	layout(offset = 4) uint dst_index;
+	layout(offset = 8) uint src_width;
+	layout(offset = 12) uint src_height;
+	layout(offset = 16) uint dst_width;
+	layout(offset = 20) uint dst_height;
+	layout(offset = 24) uint use_karis_average;
+} push;
+
+layout(local_size_x = POST_PROCESS_GROUP_SIZE, local_size_y = POST_PROCESS_GROUP_SIZE) in;
+
+// The source is about twice the size of the destination, plus one texel of filter footprint and one texel of bilinear footprint on each side
+const uint TILE_SIZE = 2 * POST_PROCESS_GROUP_SIZE + 4;
+shared vec3 s_tile[TILE_SIZE][TILE_SIZE];
+
+ivec2 GetTileOrigin(vec2 src_scale)
+{
+	return ivec2(floor((vec2(gl_WorkGroupID.xy * POST_PROCESS_GROUP_SIZE) + 0.5) * src_scale - 1.5));
+}
+
+void LoadTile(ivec2 tile_origin)
+{
+	ivec2 max_texel_pos = ivec2(push.src_width, push.src_height) - 1;
+
+	for (uint i = gl_LocalInvocationIndex; i < TILE_SIZE * TILE_SIZE; i += POST_PROCESS_GROUP_SIZE * POST_PROCESS_GROUP_SIZE)
+	{
+		ivec2 tile_pos = ivec2(i % TILE_SIZE, i / TILE_SIZE);
+		s_tile[tile_pos.y][tile_pos.x] = imageLoad(g_inputs[push.src_index], clamp(tile_origin + tile_pos, ivec2(0), max_texel_pos)).rgb;
+	}
+
+	barrier();
+}
+
+vec3 LoadFromTile(ivec2 tile_pos)
+{
+	tile_pos = clamp(tile_pos, ivec2(0), ivec2(TILE_SIZE - 1));
+	return s_tile[tile_pos.y][tile_pos.x];
+}
+
+vec3 SampleTileBilinear(vec2 src_pos, ivec2 tile_origin)
+{
+	vec2 src_texel = src_pos - 0.5;
+	ivec2 base = ivec2(floor(src_texel)) - tile_origin;
+	vec2 frac = src_texel - floor(src_texel);
+
+	vec3 c00 = LoadFromTile(base);
+	vec3 c10 = LoadFromTile(base + ivec2(1, 0));
+	vec3 c01 = LoadFromTile(base + ivec2(0, 1));
+	vec3 c11 = LoadFromTile(base + ivec2(1, 1));
+
+	return mix(mix(c00, c10, frac.x), mix(c01, c11, frac.x), frac.y);
+}
+
+float KarisWeight(vec3 color)
+{
+	return 1.0 / (1.0 + dot(color, vec3(0.2126, 0.7152, 0.0722)));
+}
+
+void main()
+{
+	vec2 src_scale = vec2(push.src_width, push.src_height) / vec2(push.dst_width, push.dst_height);
+	ivec2 tile_origin = GetTileOrigin(src_scale);
+	LoadTile(tile_origin);
+
+	const ivec2 texel_pos = ivec2(gl_GlobalInvocationID.xy);
+	if (any(greaterThanEqual(texel_pos, ivec2(push.dst_width, push.dst_height))))
+		return;
+
+	vec2 src_pos = (vec2(texel_pos) + 0.5) * src_scale;
+
+	vec3 taps[5] = {
+		SampleTileBilinear(src_pos, tile_origin),
+		SampleTileBilinear(src_pos + vec2(-1.0, -1.0), tile_origin),
+		SampleTileBilinear(src_pos + vec2(1.0, -1.0), tile_origin),
+		SampleTileBilinear(src_pos + vec2(-1.0, 1.0), tile_origin),
+		SampleTileBilinear(src_pos + vec2(1.0, 1.0), tile_origin)
+	};
+	float weights[5] = { 4.0, 1.0, 1.0, 1.0, 1.0 };
+
+	vec3 result = vec3(0.0);
+	float total_weight = 0.0;
+
+	for (uint i = 0; i < 5; ++i)
+	{
+		float weight = weights[i] * (push.use_karis_average != 0 ? KarisWeight(taps[i]) : 1.0);
+		result += taps[i] * weight;
+		total_weight += weight;
+	}
+
+	imageStore(g_outputs[push.dst_index], texel_pos, vec4(result / total_weight, 1.0));
+}
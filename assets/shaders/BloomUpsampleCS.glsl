@@ -0,0 +1,95 @@
+#version 460
+
+/*
+
+	Upsamples the bloom chain with a 3x3 tent filter, and adds the result to the next larger mip
+	The source texels a workgroup needs are loaded into shared memory once, since neighbouring threads share most of their taps
+	Source: https://www.iryoku.com/next-generation-post-processing-in-call-of-duty-advanced-warfare/
+
+*/
+
+#include "Common.glsl"
+
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16f) uniform restrict readonly image2D g_inputs[];
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16f) uniform restrict image2D g_read_writes[];
+
+layout(std140, push_constant) uniform PushConsts
+{
+	layout(offset = 0) uint src_index;
+	layout(offset = 4) uint dst_index;
+	layout(offset = 8) uint src_width;
+	layout(offset = 12) uint src_height;
+	layout(offset = 16) uint dst_width;
+	layout(offset = 20) uint dst_height;
+} push;
+
+layout(local_size_x = POST_PROCESS_GROUP_SIZE, local_size_y = POST_PROCESS_GROUP_SIZE) in;
+
+// The source is at most the size of the destination, plus one texel of filter footprint and one texel of bilinear footprint on each side
+const uint TILE_SIZE = POST_PROCESS_GROUP_SIZE + 4;
+shared vec3 s_tile[TILE_SIZE][TILE_SIZE];
+
+ivec2 GetTileOrigin(vec2 src_scale)
+{
+	return ivec2(floor((vec2(gl_WorkGroupID.xy * POST_PROCESS_GROUP_SIZE) + 0.5) * src_scale - 1.5));
+}
+
+void LoadTile(ivec2 tile_origin)
+{
+	ivec2 max_texel_pos = ivec2(push.src_width, push.src_height) - 1;
+
+	for (uint i = gl_LocalInvocationIndex; i < TILE_SIZE * TILE_SIZE; i += POST_PROCESS_GROUP_SIZE * POST_PROCESS_GROUP_SIZE)
+	{
+		ivec2 tile_pos = ivec2(i % TILE_SIZE, i / TILE_SIZE);
+		s_tile[tile_pos.y][tile_pos.x] = imageLoad(g_inputs[push.src_index], clamp(tile_origin + tile_pos, ivec2(0), max_texel_pos)).rgb;
+	}
+
+	barrier();
+}
+
+vec3 LoadFromTile(ivec2 tile_pos)
+{
+	tile_pos = clamp(tile_pos, ivec2(0), ivec2(TILE_SIZE - 1));
+	return s_tile[tile_pos.y][tile_pos.x];
+}
+
+vec3 SampleTileBilinear(vec2 src_pos, ivec2 tile_origin)
+{
+	vec2 src_texel = src_pos - 0.5;
+	ivec2 base = ivec2(floor(src_texel)) - tile_origin;
+	vec2 frac = src_texel - floor(src_texel);
+
+	vec3 c00 = LoadFromTile(base);
+	vec3 c10 = LoadFromTile(base + ivec2(1, 0));
+	vec3 c01 = LoadFromTile(base + ivec2(0, 1));
+	vec3 c11 = LoadFromTile(base + ivec2(1, 1));
+
+	return mix(mix(c00, c10, frac.x), mix(c01, c11, frac.x), frac.y);
+}
+
+void main()
+{
+	vec2 src_scale = vec2(push.src_width, push.src_height) / vec2(push.dst_width, push.dst_height);
+	ivec2 tile_origin = GetTileOrigin(src_scale);
+	LoadTile(tile_origin);
+
+	const ivec2 texel_pos = ivec2(gl_GlobalInvocationID.xy);
+	if (any(greaterThanEqual(texel_pos, ivec2(push.dst_width, push.dst_height))))
+		return;
+
+	vec2 src_pos = (vec2(texel_pos) + 0.5) * src_scale;
+
+	vec3 result = vec3(0.0);
+	for (int y = -1; y <= 1; ++y)
+	{
+		for (int x = -1; x <= 1; ++x)
+		{
+			float weight = (x == 0 ? 2.0 : 1.0) * (y == 0 ? 2.0 : 1.0);
+			result += SampleTileBilinear(src_pos + vec2(x, y), tile_origin) * weight;
+		}
+	}
+	result /= 16.0;
+
+	vec3 dst_color = imageLoad(g_read_writes[push.dst_index], texel_pos).rgb;
+	imageStore(g_read_writes[push.dst_index], texel_pos, vec4(dst_color + result, 1.0));
+}
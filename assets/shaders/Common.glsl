@@ -24,11 +24,30 @@ layout(set = DESCRIPTOR_SET_STORAGE_BUFFER, binding = 0, std430) readonly buffer
 	Vertex vertices[];
 } g_vertex_ssbos[];
 
+// Index buffers are bound as raw 32-bit words, 16-bit indices are unpacked in GetVertexIndex
+layout(set = DESCRIPTOR_SET_STORAGE_BUFFER, binding = 0, std430) readonly buffer IndexSSBOs
+{
+	uint indices[];
+} g_index_ssbos[];
+
 layout(set = DESCRIPTOR_SET_STORAGE_BUFFER, binding = 0, std430) readonly buffer InstanceSSBOs
 {
 	InstanceData instance_data[];
 } g_instance_ssbos[];
 
+layout(set = DESCRIPTOR_SET_STORAGE_BUFFER, binding = 0, std430) readonly buffer AreaLightSSBOs
+{
+	GPUAreaLight area_lights[];
+} g_area_light_ssbos[];
+
+// Per cluster light count, followed by LIGHT_CLUSTER_MAX_LIGHTS light indices for each cluster
+// The light count includes the lights that did not fit, so it needs to be clamped to LIGHT_CLUSTER_MAX_LIGHTS
+layout(set = DESCRIPTOR_SET_STORAGE_BUFFER, binding = 0, std430) readonly buffer LightClusterSSBOs
+{
+	uint light_counts[LIGHT_CLUSTERS_TOTAL];
+	uint light_indices[];
+} g_light_cluster_ssbos[];
+
 layout(set = DESCRIPTOR_SET_ACCELERATION_STRUCTURES, binding = 0) uniform accelerationStructureEXT g_tlas_scene[];
 
 vec3 GetVertexPos(uint buffer_index, uint vertex_index)
@@ -55,6 +74,17 @@ vec4 GetVertexTangent(uint buffer_index, uint vertex_index)
 	return vec4(vertex.tangent[0], vertex.tangent[1], vertex.tangent[2], vertex.tangent[3]);
 }
 
+uint GetVertexIndex(uint buffer_index, uint index_stride, uint index)
+{
+	if (index_stride == 2)
+	{
+		uint packed_indices = g_index_ssbos[buffer_index].indices[index >> 1];
+		return (index & 1u) == 0u ? (packed_indices & 0xFFFFu) : (packed_indices >> 16u);
+	}
+
+	return g_index_ssbos[buffer_index].indices[index];
+}
+
 mat4 GetInstanceTransform(uint buffer_index, uint instance_index)
 {
 	InstanceData instance = g_instance_ssbos[buffer_index].instance_data[instance_index];
@@ -66,6 +96,23 @@ mat4 GetInstanceTransform(uint buffer_index, uint instance_index)
 	);
 }
 
+mat4 GetInstancePrevTransform(uint buffer_index, uint instance_index)
+{
+	InstanceData instance = g_instance_ssbos[buffer_index].instance_data[instance_index];
+	return mat4(
+		instance.prev_transform[0][0], instance.prev_transform[0][1], instance.prev_transform[0][2], instance.prev_transform[0][3],
+		instance.prev_transform[1][0], instance.prev_transform[1][1], instance.prev_transform[1][2], instance.prev_transform[1][3],
+		instance.prev_transform[2][0], instance.prev_transform[2][1], instance.prev_transform[2][2], instance.prev_transform[2][3],
+		instance.prev_transform[3][0], instance.prev_transform[3][1], instance.prev_transform[3][2], instance.prev_transform[3][3]
+	);
+}
+
+// Screen space motion from the previous frame to the current frame in UV units, from unjittered clip space positions
+vec2 GetVelocity(vec4 clip_pos, vec4 prev_clip_pos)
+{
+	return (clip_pos.xy / clip_pos.w - prev_clip_pos.xy / prev_clip_pos.w) * 0.5;
+}
+
 uint GetInstanceMaterialIndex(uint buffer_index, uint instance_index)
 {
 	InstanceData instance = g_instance_ssbos[buffer_index].instance_data[instance_index];
@@ -94,8 +141,8 @@ layout(set = DESCRIPTOR_SET_UBO, binding = RESERVED_DESCRIPTOR_UBO_LIGHTS, std14
 	uint num_area_lights;
 	uint ltc1_index;
 	uint ltc2_index;
-
-	GPUAreaLight area_lights[MAX_AREA_LIGHTS];
+	uint area_light_buffer_index;
+	uint light_cluster_buffer_index;
 };
 
 layout(set = DESCRIPTOR_SET_UBO, binding = RESERVED_DESCRIPTOR_UBO_MATERIALS) uniform MaterialUBO
@@ -103,8 +150,35 @@ layout(set = DESCRIPTOR_SET_UBO, binding = RESERVED_DESCRIPTOR_UBO_MATERIALS) un
 	GPUMaterial materials[MAX_UNIQUE_MATERIALS];
 };
 
+/*
+
+	Clustered lighting
+	Functionality for mapping view space positions to light clusters
+
+*/
+
+uint GetLightClusterSliceFromViewDepth(float view_depth)
+{
+	float log_far_near = log(camera.far_plane / camera.near_plane);
+	float slice = log(view_depth) * (float(LIGHT_CLUSTERS_Z) / log_far_near) - (float(LIGHT_CLUSTERS_Z) * log(camera.near_plane) / log_far_near);
+
+	return uint(clamp(slice, 0.0, float(LIGHT_CLUSTERS_Z - 1)));
+}
+
+uint GetLightClusterIndex(vec2 frag_coord, float view_depth)
+{
+	uvec3 cluster = uvec3(
+		min(uint(frag_coord.x * float(LIGHT_CLUSTERS_X) / float(camera.render_width)), LIGHT_CLUSTERS_X - 1),
+		min(uint(frag_coord.y * float(LIGHT_CLUSTERS_Y) / float(camera.render_height)), LIGHT_CLUSTERS_Y - 1),
+		GetLightClusterSliceFromViewDepth(view_depth)
+	);
+
+	return cluster.x + cluster.y * LIGHT_CLUSTERS_X + cluster.z * LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y;
+}
+
 layout(set = DESCRIPTOR_SET_SAMPLED_IMAGE, binding = 0) uniform texture2D g_textures[];
 layout(set = DESCRIPTOR_SET_SAMPLED_IMAGE, binding = 0) uniform textureCube g_cube_textures[];
+layout(set = DESCRIPTOR_SET_SAMPLED_IMAGE, binding = 0) uniform utexture2D g_uint_textures[];
 layout(set = DESCRIPTOR_SET_SAMPLER, binding = 0) uniform sampler g_samplers[];
 //layout(set = DESCRIPTOR_SET_SAMPLER, binding = 0) uniform samplerCube g_cube_samplers[];
 
@@ -123,6 +197,11 @@ vec4 SampleTextureLod(uint tex_idx, uint samp_idx, vec2 tex_coord, float lod)
 	return textureLod(sampler2D(g_textures[tex_idx], g_samplers[samp_idx]), tex_coord, lod);
 }
 
+vec4 SampleTextureGrad(uint tex_idx, uint samp_idx, vec2 tex_coord, vec2 tex_coord_ddx, vec2 tex_coord_ddy)
+{
+	return textureGrad(sampler2D(g_textures[tex_idx], g_samplers[samp_idx]), tex_coord, tex_coord_ddx, tex_coord_ddy);
+}
+
 vec4 SampleTextureCube(uint tex_idx, uint samp_idx, vec3 samp_dir)
 {
 	return texture(samplerCube(g_cube_textures[tex_idx], g_samplers[samp_idx]), samp_dir);
@@ -139,7 +218,28 @@ vec4 SampleTextureCubeLod(uint tex_idx, uint samp_idx, vec3 samp_dir, float lod)
 
 */
 
+// Direction through a texel of a cubemap face, uv is in the [0, 1] range with the origin at the top-left of the face
+// Follows the Vulkan cubemap face layout, so that sampling the cube with the returned direction lands on the same texel
+vec3 GetCubeFaceDirection(uint face, vec2 uv)
+{
+	vec2 st = uv * 2.0 - 1.0;
+	vec3 dir;
+
+	switch (face)
+	{
+	case 0: dir = vec3(1.0, -st.y, -st.x); break;
+	case 1: dir = vec3(-1.0, -st.y, st.x); break;
+	case 2: dir = vec3(st.x, 1.0, st.y); break;
+	case 3: dir = vec3(st.x, -1.0, -st.y); break;
+	case 4: dir = vec3(st.x, -st.y, 1.0); break;
+	default: dir = vec3(-st.x, -st.y, -1.0); break;
+	}
+
+	return normalize(dir);
+}
+
 vec2 Hammersley2D(uint i, uint N) 
+
 {
 	uint bits = (i << 16u) | (i >> 16u);
 	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
@@ -0,0 +1,18 @@
+#version 460
+#include "Common.glsl"
+
+/*
+
+	Writes the motion vectors for temporal anti-aliasing, the depth is written by the fixed function depth test
+
+*/
+
+layout(location = 0) in vec4 clip_pos;
+layout(location = 1) in vec4 prev_clip_pos;
+
+layout(location = 0) out vec2 out_velocity;
+
+void main()
+{
+	out_velocity = GetVelocity(clip_pos, prev_clip_pos);
+}
@@ -7,6 +7,9 @@ layout(std140, push_constant) uniform PushConsts
 	layout(offset = 4) uint vb_index;
 } push;
 
+layout(location = 0) out vec4 clip_pos;
+layout(location = 1) out vec4 prev_clip_pos;
+
 void main()
 {
 	mat4 transform = GetInstanceTransform(push.ib_index, gl_InstanceIndex);
@@ -14,4 +17,7 @@ void main()
 
 	vec4 world_pos = transform * vec4(vertex_pos, 1.0f);
 	gl_Position = camera.proj * camera.view * world_pos;
+
+	clip_pos = camera.unjittered_view_proj * world_pos;
+	prev_clip_pos = camera.prev_view_proj * GetInstancePrevTransform(push.ib_index, gl_InstanceIndex) * vec4(vertex_pos, 1.0f);
 }
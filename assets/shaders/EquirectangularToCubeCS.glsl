@@ -0,0 +1,48 @@
+#version 460
+
+/*
+
+	This compute shader projects an equirectangular map onto a cubemap
+	Used for processing HDR environment maps for image-based lighting into cubemaps
+	Dispatched once per mip, with the Z dimension covering all 6 faces of the cubemap
+
+*/
+
+#include "Common.glsl"
+
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16f) uniform restrict writeonly image2DArray g_cube_outputs[];
+
+layout(std140, push_constant) uniform PushConsts
+{
+	layout(offset = 0) uint src_texture_index;
+	layout(offset = 4) uint src_sampler_index;
+	layout(offset = 8) uint dst_texture_index;
+	layout(offset = 12) uint dst_resolution;
+} push;
+
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+const vec2 INV_ATAN = vec2(0.1591, 0.3183);
+vec2 SampleSphericalMap(vec3 dir)
+{
+	vec2 uv = vec2(atan(dir.z, dir.x), asin(dir.y));
+	uv *= INV_ATAN;
+	uv += 0.5;
+
+	return uv;
+}
+
+void main()
+{
+	uvec3 texel = gl_GlobalInvocationID;
+	if (texel.x >= push.dst_resolution || texel.y >= push.dst_resolution)
+		return;
+
+	vec2 face_uv = (vec2(texel.xy) + 0.5) / float(push.dst_resolution);
+	vec3 dir = GetCubeFaceDirection(texel.z, face_uv);
+
+	vec2 uv = SampleSphericalMap(dir);
+	vec3 sampled_color = SampleTextureLod(push.src_texture_index, push.src_sampler_index, uv, 0.0).rgb;
+
+	imageStore(g_cube_outputs[push.dst_texture_index], ivec3(texel), vec4(sampled_color, 1.0));
+}
@@ -1,9 +1,8 @@
 #version 460
-#extension GL_EXT_nonuniform_qualifier : enable
 
 /*
 
-	This shader generates the BRDF look-up table (BRDF integration map) used in image-based lighting for the specular light
+	Generates a single triangle covering the entire screen, draw with 3 vertices and no vertex or index buffer
 
 */
 
@@ -0,0 +1,60 @@
+#version 460
+
+/*
+
+	This compute shader generates the irradiance map for a given HDR environment map
+	Irradiance maps are used for diffuse IBL, we need to capture the irradiance coming
+	from all possible directions over the hemisphere for any given direction of the cube map (convolution)
+	Dispatched once per mip, with the Z dimension covering all 6 faces of the cubemap
+
+*/
+
+#include "Common.glsl"
+
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16f) uniform restrict writeonly image2DArray g_cube_outputs[];
+
+layout(std140, push_constant) uniform PushConsts
+{
+	layout(offset = 0) uint src_texture_index;
+	layout(offset = 4) uint src_sampler_index;
+	layout(offset = 8) uint dst_texture_index;
+	layout(offset = 12) uint dst_resolution;
+	layout(offset = 16) float delta_phi;
+	layout(offset = 20) float delta_theta;
+} push;
+
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+void main()
+{
+	uvec3 texel = gl_GlobalInvocationID;
+	if (texel.x >= push.dst_resolution || texel.y >= push.dst_resolution)
+		return;
+
+	vec2 face_uv = (vec2(texel.xy) + 0.5) / float(push.dst_resolution);
+	vec3 N = GetCubeFaceDirection(texel.z, face_uv);
+	vec3 up = abs(N.y) < 0.999 ? vec3(0.0, 1.0, 0.0) : vec3(0.0, 0.0, 1.0);
+	vec3 right = normalize(cross(up, N));
+	up = cross(N, right);
+
+	vec3 irradiance = vec3(0.0);
+	uint num_samples = 0;
+
+	// Take a set amount of samples for irradiance cube map
+	// Azimuth, two pi
+	for (float phi = 0.0; phi < TWO_PI; phi += push.delta_phi)
+	{
+		// Zenith, half pi
+		for (float theta = 0.0; theta < HALF_PI; theta += push.delta_theta)
+		{
+			vec3 temp = cos(phi) * right + sin(phi) * up;
+			vec3 sample_dir = cos(theta) * N + sin(theta) * temp;
+			// Weighting the final result by sin(theta) to compensate for the hemisphere having smaller sample areas towards the top
+			irradiance += SampleTextureCubeLod(push.src_texture_index, push.src_sampler_index, sample_dir, 0.0).rgb * cos(theta) * sin(theta);
+
+			num_samples++;
+		}
+	}
+
+	imageStore(g_cube_outputs[push.dst_texture_index], ivec3(texel), vec4(PI * irradiance / float(num_samples), 1.0));
+}
@@ -0,0 +1,73 @@
+#version 460
+
+/*
+
+	This compute shader evaluates the irradiance for each texel of the irradiance cubemap from 9 spherical harmonics coefficients
+	Replaces the brute force hemisphere convolution in IrradianceCubeCS, the convolution with the clamped cosine lobe
+	reduces to a per band scale of the coefficients
+	Source: https://cseweb.ucsd.edu/~ravir/papers/envmap/envmap.pdf
+	Dispatched once per mip, with the Z dimension covering all 6 faces of the cubemap
+
+*/
+
+#include "Common.glsl"
+
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16f) uniform restrict writeonly image2DArray g_cube_outputs[];
+
+layout(set = DESCRIPTOR_SET_STORAGE_BUFFER, binding = 0, std430) readonly buffer IrradianceSHSSBOs
+{
+	vec4 coefficients[];
+} g_irradiance_sh_ssbos[];
+
+layout(std140, push_constant) uniform PushConsts
+{
+	layout(offset = 0) uint src_buffer_index;
+	layout(offset = 4) uint dst_texture_index;
+	layout(offset = 8) uint dst_resolution;
+} push;
+
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// Clamped cosine lobe convolution for each band, divided by PI to match the scale of the brute force irradiance cubemap
+const float SH_BAND_SCALE[3] = float[3](1.0, 2.0 / 3.0, 1.0 / 4.0);
+
+void main()
+{
+	uvec3 texel = gl_GlobalInvocationID;
+	if (texel.x >= push.dst_resolution || texel.y >= push.dst_resolution)
+		return;
+
+	// Combine the partial sums from each of the faces
+	vec3 coefficients[IBL_SH_NUM_COEFFICIENTS];
+	float total_solid_angle = 0.0;
+
+	for (uint i = 0; i < IBL_SH_NUM_COEFFICIENTS; ++i)
+		coefficients[i] = vec3(0.0);
+
+	for (uint face = 0; face < 6; ++face)
+	{
+		for (uint i = 0; i < IBL_SH_NUM_COEFFICIENTS; ++i)
+			coefficients[i] += g_irradiance_sh_ssbos[push.src_buffer_index].coefficients[face * IBL_SH_FACE_STRIDE + i].rgb;
+
+		total_solid_angle += g_irradiance_sh_ssbos[push.src_buffer_index].coefficients[face * IBL_SH_FACE_STRIDE + IBL_SH_NUM_COEFFICIENTS].x;
+	}
+
+	// The texel solid angles are an approximation, normalize so that they add up to the full sphere
+	float normalization = (4.0 * PI) / total_solid_angle;
+
+	vec2 face_uv = (vec2(texel.xy) + 0.5) / float(push.dst_resolution);
+	vec3 dir = GetCubeFaceDirection(texel.z, face_uv);
+
+	vec3 irradiance = coefficients[0] * 0.282095 * SH_BAND_SCALE[0];
+	irradiance += coefficients[1] * 0.488603 * dir.y * SH_BAND_SCALE[1];
+	irradiance += coefficients[2] * 0.488603 * dir.z * SH_BAND_SCALE[1];
+	irradiance += coefficients[3] * 0.488603 * dir.x * SH_BAND_SCALE[1];
+	irradiance += coefficients[4] * 1.092548 * dir.x * dir.y * SH_BAND_SCALE[2];
+	irradiance += coefficients[5] * 1.092548 * dir.y * dir.z * SH_BAND_SCALE[2];
+	irradiance += coefficients[6] * 0.315392 * (3.0 * dir.z * dir.z - 1.0) * SH_BAND_SCALE[2];
+	irradiance += coefficients[7] * 1.092548 * dir.x * dir.z * SH_BAND_SCALE[2];
+	irradiance += coefficients[8] * 0.546274 * (dir.x * dir.x - dir.y * dir.y) * SH_BAND_SCALE[2];
+	irradiance *= normalization;
+
+	imageStore(g_cube_outputs[push.dst_texture_index], ivec3(texel), vec4(max(irradiance, vec3(0.0)), 1.0));
+}
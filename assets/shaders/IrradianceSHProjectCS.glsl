@@ -0,0 +1,99 @@
+#version 460
+
+/*
+
+	This compute shader projects an HDR environment cubemap onto 9 spherical harmonics coefficients (L2)
+	Each workgroup handles one face of the cubemap and writes its partial sum, the faces are combined in IrradianceSHEvaluateCS
+	Source: https://www.ppsloan.org/publications/StupidSH36.pdf
+
+*/
+
+#include "Common.glsl"
+
+layout(set = DESCRIPTOR_SET_STORAGE_BUFFER, binding = 0, std430) restrict writeonly buffer IrradianceSHRWSSBOs
+{
+	vec4 coefficients[];
+} g_irradiance_sh_rw_ssbos[];
+
+layout(std140, push_constant) uniform PushConsts
+{
+	layout(offset = 0) uint src_texture_index;
+	layout(offset = 4) uint src_sampler_index;
+	layout(offset = 8) uint src_mip;
+	layout(offset = 12) uint src_resolution;
+	layout(offset = 16) uint dst_buffer_index;
+} push;
+
+layout(local_size_x = IBL_SH_PROJECT_GROUP_SIZE, local_size_y = IBL_SH_PROJECT_GROUP_SIZE, local_size_z = 1) in;
+
+const uint NUM_THREADS = IBL_SH_PROJECT_GROUP_SIZE * IBL_SH_PROJECT_GROUP_SIZE;
+
+shared vec4 s_coefficients[NUM_THREADS][IBL_SH_FACE_STRIDE];
+
+void EvaluateSHBasis(vec3 dir, out float basis[IBL_SH_NUM_COEFFICIENTS])
+{
+	basis[0] = 0.282095;
+	basis[1] = 0.488603 * dir.y;
+	basis[2] = 0.488603 * dir.z;
+	basis[3] = 0.488603 * dir.x;
+	basis[4] = 1.092548 * dir.x * dir.y;
+	basis[5] = 1.092548 * dir.y * dir.z;
+	basis[6] = 0.315392 * (3.0 * dir.z * dir.z - 1.0);
+	basis[7] = 1.092548 * dir.x * dir.z;
+	basis[8] = 0.546274 * (dir.x * dir.x - dir.y * dir.y);
+}
+
+void main()
+{
+	uint face = gl_WorkGroupID.z;
+	uint thread_index = gl_LocalInvocationIndex;
+
+	for (uint i = 0; i < IBL_SH_FACE_STRIDE; ++i)
+		s_coefficients[thread_index][i] = vec4(0.0);
+
+	// Every thread accumulates a strided subset of the texels on this face
+	float texel_size = 2.0 / float(push.src_resolution);
+
+	for (uint y = gl_LocalInvocationID.y; y < push.src_resolution; y += IBL_SH_PROJECT_GROUP_SIZE)
+	{
+		for (uint x = gl_LocalInvocationID.x; x < push.src_resolution; x += IBL_SH_PROJECT_GROUP_SIZE)
+		{
+			vec2 face_uv = (vec2(x, y) + 0.5) / float(push.src_resolution);
+			vec3 dir = GetCubeFaceDirection(face, face_uv);
+
+			// Solid angle subtended by the texel
+			vec2 st = face_uv * 2.0 - 1.0;
+			float temp = 1.0 + dot(st, st);
+			float solid_angle = (texel_size * texel_size) / (temp * sqrt(temp));
+
+			vec3 radiance = SampleTextureCubeLod(push.src_texture_index, push.src_sampler_index, dir, float(push.src_mip)).rgb;
+
+			float basis[IBL_SH_NUM_COEFFICIENTS];
+			EvaluateSHBasis(dir, basis);
+
+			for (uint i = 0; i < IBL_SH_NUM_COEFFICIENTS; ++i)
+				s_coefficients[thread_index][i].rgb += radiance * basis[i] * solid_angle;
+
+			s_coefficients[thread_index][IBL_SH_NUM_COEFFICIENTS].x += solid_angle;
+		}
+	}
+
+	barrier();
+
+	// Parallel reduction of the per thread partial sums
+	for (uint stride = NUM_THREADS / 2; stride > 0; stride >>= 1)
+	{
+		if (thread_index < stride)
+		{
+			for (uint i = 0; i < IBL_SH_FACE_STRIDE; ++i)
+				s_coefficients[thread_index][i] += s_coefficients[thread_index + stride][i];
+		}
+
+		barrier();
+	}
+
+	if (thread_index < IBL_SH_FACE_STRIDE)
+	{
+		g_irradiance_sh_rw_ssbos[push.dst_buffer_index].coefficients[face * IBL_SH_FACE_STRIDE + thread_index] = s_coefficients[0][thread_index];
+	}
+}
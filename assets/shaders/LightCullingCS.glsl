@@ -0,0 +1,106 @@
+#version 460
+
+#include "Common.glsl"
+
+// Writable alias of the light cluster buffers, only the light culling pass is allowed to write to them
+layout(set = DESCRIPTOR_SET_STORAGE_BUFFER, binding = 0, std430) restrict writeonly buffer LightClusterRWSSBOs
+{
+	uint light_counts[LIGHT_CLUSTERS_TOTAL];
+	uint light_indices[];
+} g_light_cluster_rw_ssbos[];
+
+layout(local_size_x = LIGHT_CULLING_GROUP_SIZE) in;
+
+// View space light bounding spheres (xyz = center, w = radius) for the current batch of lights
+shared vec4 s_light_bounds[LIGHT_CULLING_GROUP_SIZE];
+
+struct ClusterAABB
+{
+	vec3 min;
+	vec3 max;
+};
+
+ClusterAABB GetClusterAABB(uvec3 cluster)
+{
+	// Exponential depth slices, matching GetLightClusterSliceFromViewDepth
+	float far_over_near = camera.far_plane / camera.near_plane;
+	float slice_near = camera.near_plane * pow(far_over_near, float(cluster.z) / float(LIGHT_CLUSTERS_Z));
+	float slice_far = camera.near_plane * pow(far_over_near, float(cluster.z + 1) / float(LIGHT_CLUSTERS_Z));
+
+	// Tile bounds in NDC, unprojected to view space at the near and far depth of the slice
+	vec2 num_clusters = vec2(LIGHT_CLUSTERS_X, LIGHT_CLUSTERS_Y);
+	vec2 ndc_min = (vec2(cluster.xy) / num_clusters) * 2.0 - 1.0;
+	vec2 ndc_max = (vec2(cluster.xy + 1) / num_clusters) * 2.0 - 1.0;
+	vec2 inv_proj_scale = 1.0 / vec2(camera.proj[0][0], camera.proj[1][1]);
+
+	vec2 near_min = ndc_min * inv_proj_scale * slice_near;
+	vec2 near_max = ndc_max * inv_proj_scale * slice_near;
+	vec2 far_min = ndc_min * inv_proj_scale * slice_far;
+	vec2 far_max = ndc_max * inv_proj_scale * slice_far;
+
+	ClusterAABB aabb;
+	aabb.min.xy = min(min(near_min, near_max), min(far_min, far_max));
+	aabb.max.xy = max(max(near_min, near_max), max(far_min, far_max));
+	// View space looks down the negative Z axis
+	aabb.min.z = -slice_far;
+	aabb.max.z = -slice_near;
+
+	return aabb;
+}
+
+bool SphereIntersectsAABB(vec4 sphere, ClusterAABB aabb)
+{
+	vec3 closest_point = clamp(sphere.xyz, aabb.min, aabb.max);
+	vec3 delta = closest_point - sphere.xyz;
+
+	return dot(delta, delta) <= sphere.w * sphere.w;
+}
+
+void main()
+{
+	uint cluster_index = gl_GlobalInvocationID.x;
+	bool is_valid_cluster = cluster_index < LIGHT_CLUSTERS_TOTAL;
+
+	uvec3 cluster = uvec3(
+		cluster_index % LIGHT_CLUSTERS_X,
+		(cluster_index / LIGHT_CLUSTERS_X) % LIGHT_CLUSTERS_Y,
+		cluster_index / (LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y)
+	);
+	ClusterAABB aabb = GetClusterAABB(cluster);
+
+	uint num_cluster_lights = 0;
+	uint cluster_indices_offset = cluster_index * LIGHT_CLUSTER_MAX_LIGHTS;
+
+	// Every thread loads one light into shared memory, after which each thread tests the whole batch against its own cluster
+	for (uint batch_begin = 0; batch_begin < num_area_lights; batch_begin += LIGHT_CULLING_GROUP_SIZE)
+	{
+		uint light_index = batch_begin + gl_LocalInvocationIndex;
+		if (light_index < num_area_lights)
+		{
+			GPUAreaLight area_light = g_area_light_ssbos[area_light_buffer_index].area_lights[light_index];
+			vec3 bounds_center_view = (camera.view * vec4(area_light.bounds_center, 1.0)).xyz;
+			s_light_bounds[gl_LocalInvocationIndex] = vec4(bounds_center_view, area_light.bounds_radius);
+		}
+
+		barrier();
+
+		uint batch_size = min(LIGHT_CULLING_GROUP_SIZE, num_area_lights - batch_begin);
+		for (uint i = 0; is_valid_cluster && i < batch_size; ++i)
+		{
+			if (SphereIntersectsAABB(s_light_bounds[i], aabb))
+			{
+				// Lights that do not fit anymore are still counted, so that the CPU can tell how many were dropped
+				if (num_cluster_lights < LIGHT_CLUSTER_MAX_LIGHTS)
+					g_light_cluster_rw_ssbos[light_cluster_buffer_index].light_indices[cluster_indices_offset + num_cluster_lights] = batch_begin + i;
+				num_cluster_lights++;
+			}
+		}
+
+		barrier();
+	}
+
+	if (is_valid_cluster)
+	{
+		g_light_cluster_rw_ssbos[light_cluster_buffer_index].light_counts[cluster_index] = num_cluster_lights;
+	}
+}
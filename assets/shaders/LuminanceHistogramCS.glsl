@@ -0,0 +1,60 @@
+#version 460
+
+/*
+
+	Builds a histogram of the log luminance of the post-processing source, for the auto exposure
+	Every workgroup first accumulates its tile into a histogram in shared memory, and then adds the non-empty bins to the global histogram
+	Source: https://bruop.github.io/exposure/
+
+*/
+
+#include "Common.glsl"
+
+layout(set = DESCRIPTOR_SET_STORAGE_BUFFER, binding = 0, std430) restrict buffer AutoExposureRWSSBOs
+{
+	AutoExposureData data;
+} g_auto_exposure_rw_ssbos[];
+
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16f) uniform restrict readonly image2D g_inputs[];
+
+layout(std140, push_constant) uniform PushConsts
+{
+	layout(offset = 0) uint src_index;
+	layout(offset = 4) uint src_width;
+	layout(offset = 8) uint src_height;
+	layout(offset = 12) uint dst_buffer_index;
+} push;
+
+layout(local_size_x = LUMINANCE_HISTOGRAM_GROUP_SIZE, local_size_y = LUMINANCE_HISTOGRAM_GROUP_SIZE) in;
+
+shared uint s_histogram[LUMINANCE_HISTOGRAM_NUM_BINS];
+
+const float MIN_LUMINANCE = 0.0001;
+
+uint LuminanceToBin(vec3 color)
+{
+	float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+	if (luminance < MIN_LUMINANCE)
+		return 0;
+
+	float log_luminance = clamp((log2(luminance) - settings.postfx_auto_exposure_min_log_luminance) / settings.postfx_auto_exposure_log_luminance_range, 0.0, 1.0);
+	return uint(log_luminance * float(LUMINANCE_HISTOGRAM_NUM_BINS - 2) + 1.0);
+}
+
+void main()
+{
+	s_histogram[gl_LocalInvocationIndex] = 0;
+	barrier();
+
+	const ivec2 texel_pos = ivec2(gl_GlobalInvocationID.xy);
+	if (all(lessThan(texel_pos, ivec2(push.src_width, push.src_height))))
+	{
+		vec3 color = imageLoad(g_inputs[push.src_index], texel_pos).rgb;
+		atomicAdd(s_histogram[LuminanceToBin(color)], 1);
+	}
+	barrier();
+
+	uint bin_count = s_histogram[gl_LocalInvocationIndex];
+	if (bin_count > 0)
+		atomicAdd(g_auto_exposure_rw_ssbos[push.dst_buffer_index].data.histogram[gl_LocalInvocationIndex], bin_count);
+}
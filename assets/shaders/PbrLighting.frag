@@ -23,458 +23,19 @@ layout(location = 5) in flat uint material_index;
 
 layout(location = 0) out vec4 out_color;
 
-const vec3 falloff = vec3(1.0f, 0.007f, 0.0002f);
-
-const float LUT_SIZE = 64;
-const float LUT_SCALE = (LUT_SIZE - 1.0) / LUT_SIZE;
-const float LUT_BIAS = 0.5 / LUT_SIZE;
-
-struct ViewInfo
-{
-	vec3 pos;
-	vec3 dir;
-};
-
-struct PixelInfo
-{
-	vec3 pos_world;
-
-	vec3 albedo;
-	vec3 normal;
-	float metallic;
-	float roughness;
-
-	bool has_coat;
-	float alpha_coat;
-	vec3 normal_coat;
-	float roughness_coat;
-
-	vec3 f0;
-};
-
-bool TraceShadowRay(vec3 ray_origin, vec3 ray_dir, float tmax)
-{
-	const float tmin = 0.01f;
-	bool occluded = false;
-
-	rayQueryEXT ray_query;
-	rayQueryInitializeEXT(ray_query, g_tlas_scene[push.tlas_index], gl_RayFlagsTerminateOnFirstHitEXT, 0xFF, ray_origin, tmin, ray_dir, tmax);
-	rayQueryProceedEXT(ray_query);
-
-	// Starts the traversal, once the traversal is complete, rayQueryProceedEXT will return false
-	// TODO: Add transparency check, return an occlusion factor (1 - alpha) instead of a bool
-//	while (rayQueryProceedEXT(ray_query))
-//	{
-//	}
-
-	if (rayQueryGetIntersectionTypeEXT(ray_query, true) != gl_RayQueryCommittedIntersectionNoneEXT)
-	{
-		occluded = true;
-	}
-
-	return occluded;
-}
-
-mat3 GetMinvMatrix(float NoV, float roughness, vec2 uv)
-{
-	// Fetch matrix
-	vec4 ltc1 = SampleTexture(ltc1_index, materials[material_index].sampler_index, uv);
-	return mat3(
-		vec3(ltc1.x, 0.0f, ltc1.y),
-		vec3(0.0f,   1.0f, 0.0f),
-		vec3(ltc1.z, 0.0f, ltc1.w)
-	);
-}
-
-vec3 IntegrateEdgeSpecular(vec3 v1, vec3 v2)
-{
-    float x = dot(v1, v2);
-    float y = abs(x);
-	
-	// NOTE: Cubic rational fit, acos does not have enough precision and causes artifacts with high intensity lights and smooth surfaces
-	// Source: https://advances.realtimerendering.com/s2016/s2016_ltc_rnd.pdf (slide 71)
-    float a = 0.8543985 + (0.4965155 + 0.0145206 * y) * y;
-    float b = 3.4175940 + (4.1616724 + y) * y;
-    float v = a / b;
-
-    float theta_sintheta = (x > 0.0) ? v : 0.5 * inversesqrt(max(1.0 - x * x, 1e-7)) - v;
-
-    return cross(v1, v2) * theta_sintheta;
-}
-
-vec3 IntegrateEdgeDiffuse(vec3 v1, vec3 v2)
-{
-	float x = dot(v1, v2);
-	float y = abs(x);
-
-	float theta_sintheta = 1.5708 + (-0.879406 + 0.308609 * y) * y;
-	if (x < 0.0)
-	{
-		theta_sintheta = PI * inversesqrt(max(1.0 - x * x, 1e-7)) - theta_sintheta;
-	}
-
-	return cross(v1, v2) * theta_sintheta;
-}
-
-// Uses Linearly Transformed Cosines approach
-vec3 AreaLightIrradiance(ViewInfo view, vec3 pos_world, vec3 normal, mat3 Minv, vec3 area_light_verts[4], bool two_sided)
-{
-	// Orthonormal basis around surface normal
-	vec3 T1 = normalize(view.dir - normal * dot(view.dir, normal));
-    vec3 T2 = cross(normal, T1);
-
-	// Rotate area light in (T1, T2, N) basis
-    Minv = Minv * transpose(mat3(T1, T2, normal));
-
-	vec3 L[4];
-	L[0] = Minv * (area_light_verts[0] - pos_world);
-	L[1] = Minv * (area_light_verts[1] - pos_world);
-	L[2] = Minv * (area_light_verts[2] - pos_world);
-	L[3] = Minv * (area_light_verts[3] - pos_world);
-
-	// Check if the surface point is behind the light
-	vec3 dir = area_light_verts[0] - pos_world;
-	vec3 light_normal = cross(area_light_verts[1] - area_light_verts[0], area_light_verts[3] - area_light_verts[0]);
-	bool back_face = (dot(dir, light_normal) < 0.0f);
-
-	L[0] = normalize(L[0]);
-	L[1] = normalize(L[1]);
-	L[2] = normalize(L[2]);
-	L[3] = normalize(L[3]);
-
-	vec3 vsum = vec3(0.0);
-	vsum += IntegrateEdgeSpecular(L[0], L[1]);
-	vsum += IntegrateEdgeSpecular(L[1], L[2]);
-	vsum += IntegrateEdgeSpecular(L[2], L[3]);
-	vsum += IntegrateEdgeSpecular(L[3], L[0]);
-
-	// Form factor of the area light polygon
-	float len = length(vsum);
-
-	float z = vsum.z / len;
-	if (back_face)
-	{
-		z = -z;
-	}
-
-	vec2 uv_form_factor = vec2(z * 0.5f + 0.5f, len);
-	uv_form_factor = uv_form_factor * LUT_SCALE + LUT_BIAS;
-
-	// Fetch form factor for the horizon clipping
-	float scale = SampleTexture(ltc2_index, materials[material_index].sampler_index, uv_form_factor).w;
-	float sum = len * scale;
-	if (!back_face && !two_sided)
-	{
-		sum = 0.0f;
-	}
-
-	// Outgoing radiance of the area light towards surface
-	vec3 Lo_i = vec3(sum, sum, sum);
-	return Lo_i;
-}
-
-vec3 ShadePixel(ViewInfo view, PixelInfo pixel)
-{
-	vec3 Lo = vec3(0.0);
-	
-	float NoV = clamp(dot(pixel.normal, view.dir), 0.0f, 1.0f);
-
-	vec3 direct_diffuse = vec3(0.0f);
-	vec3 direct_specular = vec3(0.0f);
-
-	vec3 indirect_diffuse = vec3(0.0f);
-	vec3 indirect_specular = vec3(0.0f);
-	
-	// --------------------------------------------------------------------------------------------------
-	// -------------------------- Direct illumination from area lights ----------------------------------
-	// --------------------------------------------------------------------------------------------------
-
-	if (settings.use_direct_light == 1)
-	{
-		vec2 uv = vec2(pixel.roughness, sqrt(1.0 - NoV));
-		uv = uv * LUT_SCALE + LUT_BIAS;
-
-		mat3 Minv = GetMinvMatrix(NoV, pixel.roughness, uv);
-		vec4 ltc2 = SampleTexture(ltc2_index, materials[material_index].sampler_index, uv);
-
-		for (uint i = 0; i < num_area_lights; ++i)
-		{
-			GPUAreaLight area_light = area_lights[i];
-			vec3 area_light_radiance = area_light.intensity * vec3(area_light.color_red, area_light.color_green, area_light.color_blue);
-			vec3 area_light_verts[4] = { area_light.vert0, area_light.vert1, area_light.vert2, area_light.vert3 };
-
-			vec3 diffuse = AreaLightIrradiance(view, pixel.pos_world, pixel.normal, mat3(1), area_light_verts, area_light.two_sided);
-			diffuse *= pixel.albedo;
-
-			vec3 specular = AreaLightIrradiance(view, pixel.pos_world, pixel.normal, Minv, area_light_verts, area_light.two_sided);
-			specular *= pixel.f0 * ltc2.x + (1.0f - pixel.f0) * ltc2.y;
-
-			if (pixel.has_coat)
-			{
-				float NoVc = max(dot(pixel.normal_coat, view.dir), 0.0);
-				vec3 Fcc = F_SchlickRoughness(NoVc, pixel.f0, pixel.roughness_coat);
-				vec3 attenuation = 1.0 - pixel.alpha_coat * Fcc;
-
-				// UV for Minv needs to be different here than the base layer
-				vec2 uv_coat = vec2(pixel.roughness_coat, sqrt(1.0 - NoVc));
-				uv_coat = uv_coat * LUT_SCALE + LUT_BIAS;
-
-				mat3 Minv_coat = GetMinvMatrix(NoVc, pixel.roughness_coat, uv_coat);
-				vec3 specular_coat = AreaLightIrradiance(view, pixel.pos_world, pixel.normal_coat, Minv_coat, area_light_verts, area_light.two_sided);
-
-				diffuse *= attenuation;
-				specular *= attenuation;
-
-				specular += pixel.alpha_coat * Fcc * specular_coat;
-			}
-
-			diffuse *= area_light_radiance;
-			specular *= area_light_radiance;
-
-			direct_diffuse += diffuse;
-			direct_specular += specular;
-		}
-	}
-	
-	// --------------------------------------------------------------------------------------------------
-	// -------------------------- Indirect illumination from environment (IBL) --------------------------
-	// --------------------------------------------------------------------------------------------------
-
-	if (settings.use_ibl == 1)
-	{
-		vec3 R = reflect(-view.dir, pixel.normal);
-
-		vec2 env_brdf = SampleTexture(push.brdf_lut_index, push.brdf_lut_sampler_index, vec2(NoV, pixel.roughness)).rg;
-		vec3 reflection = SampleTextureCubeLod(push.prefiltered_cubemap_index, push.prefiltered_sampler_index, R, pixel.roughness * push.num_prefiltered_mips).rgb;
-		vec3 irradiance = SampleTextureCube(push.irradiance_cubemap_index, push.irradiance_sampler_index, pixel.normal).rgb;
-
-		vec3 diffuse_color = pixel.albedo * Fd_Lambert();
-		vec3 diffuse = irradiance * diffuse_color;
-
-		vec3 F = F_SchlickRoughness(NoV, pixel.f0, pixel.roughness);
-		// Fss: Single scatter BRDF - Ess: Single scattering directional albedo
-		vec3 FssEss = F * env_brdf.x + env_brdf.y;
-
-		// Take into account clearcoat layer for IBL
-		if (settings.use_ibl_clearcoat == 1 && pixel.has_coat)
-		{
-			float NoVc = max(dot(pixel.normal_coat, view.dir), 0.0);
-			vec3 Fcc = F_SchlickRoughness(NoVc, pixel.f0, pixel.roughness_coat);
-			vec3 attenuation = 1.0 - pixel.alpha_coat * Fcc;
-
-			vec3 Rc = reflect(-view.dir, pixel.normal_coat);
-			vec3 reflection_coat = SampleTextureCubeLod(push.prefiltered_cubemap_index, push.prefiltered_sampler_index, Rc, pixel.roughness_coat * push.num_prefiltered_mips).rgb;
-			vec2 env_brdf_coat = SampleTexture(push.brdf_lut_index, push.brdf_lut_sampler_index, vec2(NoVc, pixel.roughness_coat)).rg;
-			
-			// Take into account energy lost in the clearcoat layer by adjusting the base layer
-			diffuse *= attenuation;
-
-			FssEss *= attenuation;
-			FssEss += pixel.alpha_coat * (Fcc * env_brdf_coat.x + env_brdf_coat.y);
-
-			reflection *= attenuation;
-			reflection += pixel.alpha_coat * reflection_coat;
-
-			env_brdf *= 1.0 - pixel.alpha_coat;
-			env_brdf += pixel.alpha_coat * env_brdf_coat;
-		}
-
-		vec3 kD = vec3(0.0);
-		// Source (Fdez-Agera): https://www.jcgt.org/published/0008/01/03/paper.pdf
-		// This approach simulates the energy lost due do single scattering by adding a second specular lobe for the multiscatter.
-		// Fss + Fms = 1 - This should hold true to achieve the energy conservation we are after
-		// After the first bounce, we treat light as if it will be scattered randomly in all directions.
-		// Therefore we can treat these secondary bounces as uniform energy in all directions
-		// so we represent this as an attenuated form of the cosine-weighted irradiance
-		if (settings.use_ibl_multiscatter == 1)
-		{
-			// Energy lost due to single scattering
-			float Ems = (1.0 - (env_brdf.x + env_brdf.y));
-
-			// On each bounce we lose a fraction of energy due to it escaping the surface or being absorbed
-			// This means that only F_avg energy can participate in the next bounce
-			// F_Avg: Cosine-weighted average of the fresnel term
-			vec3 F_avg = pixel.f0 + (1.0 - pixel.f0) / 21.0;
-
-			// F_avg was not squared in the original paper, however it was later adjusted because the model includes
-			// single scattering events, which are already accounted for in Fss, and we do not want that here
-			// https://blog.selfshadow.com/2018/06/04/multi-faceted-part-2/
-			// https://blog.selfshadow.com/publications/s2017-shading-course/imageworks/s2017_pbs_imageworks_slides_v2.pdf
-			vec3 FmsEms = Ems * FssEss * pow(F_avg, vec3(2.0)) / (1.0 - F_avg * Ems);
-
-			// FmsEms + kD: Fixes energy conservation for dielectrics/non perfect mirrors
-			kD = diffuse_color * (1.0 - FssEss - FmsEms);
-			kD += FmsEms;
-
-			indirect_diffuse = kD * irradiance;
-			indirect_specular = FssEss * reflection;
-		}
-		else
-		{
-			kD = (1.0 - F) * (1.0 - pixel.metallic);
-			indirect_diffuse = kD * diffuse;
-			indirect_specular = FssEss * reflection;
-		}
-
-		if (settings.debug_render_mode == DEBUG_RENDER_MODE_IBL_BRDF_LUT)
-		{
-			Lo = vec3(env_brdf, 0.0);
-		}
-	}
-
-	switch (settings.debug_render_mode)
-	{
-		case DEBUG_RENDER_MODE_NONE:
-		{
-			Lo = direct_specular + direct_diffuse;
-			Lo += indirect_specular + indirect_diffuse;
-		} break;
-		case DEBUG_RENDER_MODE_DIRECT_DIFFUSE:
-		{
-			Lo = direct_diffuse;
-		} break;
-		case DEBUG_RENDER_MODE_DIRECT_SPECULAR:
-		{
-			Lo = direct_specular;
-		} break;
-		case DEBUG_RENDER_MODE_IBL_INDIRECT_DIFFUSE:
-		{
-			Lo = indirect_diffuse;
-		} break;
-		case DEBUG_RENDER_MODE_IBL_INDIRECT_SPECULAR:
-		{
-			Lo = indirect_specular;
-		} break;
-	}
-
-	return Lo;
-}
+#include "PbrLighting.glsl"
 
 void main()
 {
-	// View info for lighting
-	ViewInfo view;
-	view.pos = camera.view_pos.xyz;
-	view.dir = normalize(view.pos - frag_pos.xyz);
-
-	GPUMaterial material = materials[material_index];
-
-	PixelInfo pixel;
-	pixel.has_coat = false;
-	pixel.alpha_coat = 0.0;
-	pixel.normal_coat = vec3(0.0);
-	pixel.roughness_coat = 0.0;
-
-	// Sample default material values
-	pixel.pos_world = frag_pos.xyz;
-	pixel.albedo = SampleTexture(material.albedo_texture_index, material.sampler_index, frag_tex_coord).rgb * material.albedo_factor.rgb;
-	vec3 sampled_normal = SampleTexture(material.normal_texture_index, material.sampler_index, frag_tex_coord).rgb;
-	vec2 sampled_metallic_roughness = SampleTexture(material.metallic_roughness_texture_index, material.sampler_index, frag_tex_coord).bg * vec2(material.metallic_factor, material.roughness_factor);
-	pixel.metallic = sampled_metallic_roughness.x;
-	pixel.roughness = sampled_metallic_roughness.y;
-
-	// Bring sampled normal from tangent to world space
-	mat3 TBN = mat3(frag_tangent, frag_bitangent, frag_normal);
-	sampled_normal = sampled_normal * 2.0 - 1.0;
-	pixel.normal = normalize(TBN * sampled_normal);
-
-	if (settings.use_pbr_clearcoat == 1 && material.has_clearcoat == 1)
-	{
-		pixel.has_coat = true;
-
-		// Sample clearcoat material values
-		pixel.alpha_coat = SampleTexture(material.clearcoat_alpha_texture_index, material.sampler_index, frag_tex_coord).r * material.clearcoat_alpha_factor;
-		vec3 sampled_normal_coat = SampleTexture(material.clearcoat_normal_texture_index, material.sampler_index, frag_tex_coord).rgb;
-		pixel.roughness_coat = SampleTexture(material.clearcoat_roughness_texture_index, material.sampler_index, frag_tex_coord).g * material.clearcoat_roughness_factor;
-		
-		// Bring sampled clearcoat normal from tangent to world space
-		sampled_normal_coat = sampled_normal_coat * 2.0 - 1.0;
-		pixel.normal_coat = normalize(TBN * sampled_normal_coat);
-	}
-
-	// Square the roughness to be perceptually more linear, if the setting is enabled
-	// https://google.github.io/filament/Filament.md.html#materialsystem/parameterization/remapping 4.8.3.3
-	if (settings.use_pbr_squared_roughness == 1)
-	{
-		pixel.roughness = clamp(pixel.roughness, 0.089, 1.0);
-		pixel.roughness = pow(pixel.roughness, 2.0);
-		pixel.roughness_coat = clamp(pixel.roughness_coat, 0.089, 1.0);
-		pixel.roughness_coat = pow(pixel.roughness_coat, 2.0);
-	}
-
-	// Evaluate f0 and energy compensation for direct lighting
-	vec2 env_brdf = SampleTexture(push.brdf_lut_index, push.brdf_lut_sampler_index, vec2(max(dot(pixel.normal, view.dir), 0.0), pixel.roughness)).rg;
-	pixel.f0 = mix(vec3(0.04), pixel.albedo, pixel.metallic);
-
-	// Write final color
-	vec3 color = vec3(0.0f);
-	if (material.blackbody_radiator == 1)
-	{
-		color = material.albedo_factor.xyz * pixel.albedo;
-	}
-	else
-	{
-		color = ShadePixel(view, pixel);
-	}
-
-	// Debug render modes
-	switch (settings.debug_render_mode)
-	{
-		case DEBUG_RENDER_MODE_ALBEDO:
-		{
-			color = pixel.albedo;
-			break;
-		}
-		case DEBUG_RENDER_MODE_VERTEX_NORMAL:
-		{
-			color = abs(frag_normal);
-			break;
-		}
-		case DEBUG_RENDER_MODE_VERTEX_TANGENT:
-		{
-			color = abs(frag_tangent);
-			break;
-		}
-		case DEBUG_RENDER_MODE_VERTEX_BITANGENT:
-		{
-			color = abs(frag_bitangent);
-			break;
-		}
-		case DEBUG_RENDER_MODE_WORLD_NORMAL:
-		{
-			color = abs(pixel.normal);
-			break;
-		}
-		case DEBUG_RENDER_MODE_METALLIC_ROUGHNESS:
-		{
-			color = vec3(0.0, pixel.roughness, pixel.metallic);
-			break;
-		}
-		case DEBUG_RENDER_MODE_CLEARCOAT_ALPHA:
-		{
-			if (material.has_clearcoat == 1)
-				color = vec3(pixel.alpha_coat);
-			else
-				color = vec3(1.0, 0.0, 1.0);
-			break;
-		}
-		case DEBUG_RENDER_MODE_CLEARCOAT_NORMAL:
-		{
-			if (material.has_clearcoat == 1)
-				color = abs(pixel.normal_coat);
-			else
-				color = vec3(1.0, 0.0, 1.0);
-			break;
-		}
-		case DEBUG_RENDER_MODE_CLEARCOAT_ROUGHNESS:
-		{
-			if (material.has_clearcoat == 1)
-				color = vec3(0.0, pixel.roughness_coat, 0.0);
-			else
-				color = vec3(1.0, 0.0, 1.0);
-			break;
-		}
-	}
-
-	out_color = vec4(color, 1.0);
+	SurfaceInfo surface;
+	surface.pos_world = frag_pos.xyz;
+	surface.tex_coord = frag_tex_coord;
+	surface.tex_coord_ddx = dFdx(frag_tex_coord);
+	surface.tex_coord_ddy = dFdy(frag_tex_coord);
+	surface.normal = frag_normal;
+	surface.tangent = frag_tangent;
+	surface.bitangent = frag_bitangent;
+	surface.material_index = material_index;
+
+	out_color = vec4(ShadeSurface(surface), 1.0);
 }
@@ -1,17 +1,46 @@
 #version 460
 
+/*
+
+	Last pass of the post-processing chain, fuses the upscale, bloom composite, exposure, tonemap and sharpening
+	into a single pass, so that the full resolution image is only read and written once
+	The source and bloom texels a workgroup needs are loaded into shared memory once, since neighbouring threads share most of their taps
+
+*/
+
 #include "Common.glsl"
 
-layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16) uniform restrict readonly image2D g_inputs[];
+layout(set = DESCRIPTOR_SET_STORAGE_BUFFER, binding = 0, std430) restrict readonly buffer AutoExposureSSBOs
+{
+	AutoExposureData data;
+} g_auto_exposure_ssbos[];
+
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16f) uniform restrict readonly image2D g_inputs[];
 layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba8) uniform restrict writeonly image2D g_outputs[];
 
 layout(std140, push_constant) uniform PushConsts
 {
 	layout(offset = 0) uint hdr_src_index;
 	layout(offset = 4) uint sdr_dst_index;
+	layout(offset = 8) float sharpness;
+	// Size of the rendered region of the source, the render resolution, or the output resolution if temporal anti-aliasing already upsampled it
+	layout(offset = 12) uint src_width;
+	layout(offset = 16) uint src_height;
+	layout(offset = 20) uint bloom_index;
+	layout(offset = 24) uint bloom_width;
+	layout(offset = 28) uint bloom_height;
+	layout(offset = 32) uint auto_exposure_buffer_index;
 } push;
 
-layout(local_size_x = 8, local_size_y = 8) in;
+// Maximum negative lobe weight of the sharpening filter, from RCAS, keeps the filter from ringing
+const float SHARPEN_LOBE_LIMIT = 0.25 - (1.0 / 16.0);
+
+layout(local_size_x = POST_PROCESS_GROUP_SIZE, local_size_y = POST_PROCESS_GROUP_SIZE) in;
+
+// The source and bloom are at most the size of the output, plus one texel of sharpening or tent filter footprint and one texel of bilinear footprint on each side
+const uint TILE_SIZE = POST_PROCESS_GROUP_SIZE + 4;
+shared vec4 s_hdr_tile[TILE_SIZE][TILE_SIZE];
+shared vec3 s_bloom_tile[TILE_SIZE][TILE_SIZE];
 
 vec3 ApplyExposure(vec3 color, float exposure)
 {
@@ -52,15 +81,163 @@ vec3 LinearToSRGB(vec3 linear, float gamma)
 	return mix(higher, lower, cutoff);
 }
 
+float GetExposure()
+{
+	if (settings.postfx_use_auto_exposure != 0)
+		return g_auto_exposure_ssbos[push.auto_exposure_buffer_index].data.exposure * settings.postfx_exposure;
+
+	return settings.postfx_exposure;
+}
+
+vec3 Tonemap(vec3 hdr_color, float exposure)
+{
+	vec3 color = ApplyExposure(hdr_color, exposure);
+	color = TonemapReinhardLumaWhite(color, settings.postfx_max_white);
+	color = LinearToSRGB(color, settings.postfx_gamma);
+
+	return color;
+}
+
+ivec2 GetTileOrigin(vec2 src_scale)
+{
+	return ivec2(floor((vec2(gl_WorkGroupID.xy * POST_PROCESS_GROUP_SIZE) + 0.5) * src_scale - 1.5));
+}
+
+// The source render targets are allocated at output resolution, but only the top-left src_width x src_height and bloom_width x bloom_height texels are rendered to
+void LoadTiles(ivec2 hdr_tile_origin, ivec2 bloom_tile_origin)
+{
+	ivec2 max_hdr_texel_pos = ivec2(push.src_width, push.src_height) - 1;
+	ivec2 max_bloom_texel_pos = ivec2(push.bloom_width, push.bloom_height) - 1;
+
+	for (uint i = gl_LocalInvocationIndex; i < TILE_SIZE * TILE_SIZE; i += POST_PROCESS_GROUP_SIZE * POST_PROCESS_GROUP_SIZE)
+	{
+		ivec2 tile_pos = ivec2(i % TILE_SIZE, i / TILE_SIZE);
+		s_hdr_tile[tile_pos.y][tile_pos.x] = imageLoad(g_inputs[push.hdr_src_index], clamp(hdr_tile_origin + tile_pos, ivec2(0), max_hdr_texel_pos));
+
+		if (settings.postfx_use_bloom != 0)
+			s_bloom_tile[tile_pos.y][tile_pos.x] = imageLoad(g_inputs[push.bloom_index], clamp(bloom_tile_origin + tile_pos, ivec2(0), max_bloom_texel_pos)).rgb;
+	}
+
+	barrier();
+}
+
+vec4 LoadFromHDRTile(ivec2 tile_pos)
+{
+	tile_pos = clamp(tile_pos, ivec2(0), ivec2(TILE_SIZE - 1));
+	return s_hdr_tile[tile_pos.y][tile_pos.x];
+}
+
+vec3 LoadFromBloomTile(ivec2 tile_pos)
+{
+	tile_pos = clamp(tile_pos, ivec2(0), ivec2(TILE_SIZE - 1));
+	return s_bloom_tile[tile_pos.y][tile_pos.x];
+}
+
+// The source is only bound as a storage image, so the bilinear filter is done by hand
+vec4 SampleHDRBilinear(vec2 src_pos, ivec2 tile_origin)
+{
+	vec2 src_texel = src_pos - 0.5;
+	ivec2 base = ivec2(floor(src_texel)) - tile_origin;
+	vec2 frac = src_texel - floor(src_texel);
+
+	vec4 c00 = LoadFromHDRTile(base);
+	vec4 c10 = LoadFromHDRTile(base + ivec2(1, 0));
+	vec4 c01 = LoadFromHDRTile(base + ivec2(0, 1));
+	vec4 c11 = LoadFromHDRTile(base + ivec2(1, 1));
+
+	return mix(mix(c00, c10, frac.x), mix(c01, c11, frac.x), frac.y);
+}
+
+vec3 SampleBloomBilinear(vec2 bloom_pos, ivec2 tile_origin)
+{
+	vec2 bloom_texel = bloom_pos - 0.5;
+	ivec2 base = ivec2(floor(bloom_texel)) - tile_origin;
+	vec2 frac = bloom_texel - floor(bloom_texel);
+
+	vec3 c00 = LoadFromBloomTile(base);
+	vec3 c10 = LoadFromBloomTile(base + ivec2(1, 0));
+	vec3 c01 = LoadFromBloomTile(base + ivec2(0, 1));
+	vec3 c11 = LoadFromBloomTile(base + ivec2(1, 1));
+
+	return mix(mix(c00, c10, frac.x), mix(c01, c11, frac.x), frac.y);
+}
+
+// Same 3x3 tent filter as the bloom upsample, the first bloom mip is half the size of the source
+vec3 SampleBloomTent(vec2 bloom_pos, ivec2 tile_origin)
+{
+	vec3 result = vec3(0.0);
+	for (int y = -1; y <= 1; ++y)
+	{
+		for (int x = -1; x <= 1; ++x)
+		{
+			float weight = (x == 0 ? 2.0 : 1.0) * (y == 0 ? 2.0 : 1.0);
+			result += SampleBloomBilinear(bloom_pos + vec2(x, y), tile_origin) * weight;
+		}
+	}
+
+	// Every mip of the chain added its own blurred copy of the image on the way up
+	return result / (16.0 * float(BLOOM_NUM_MIPS));
+}
+
+// Bloom is added to the neighbours of the sharpening filter as well, it is smooth enough to use the value at the center for them
+vec3 SampleTonemapped(vec2 src_pos, ivec2 tile_origin, vec3 bloom, float bloom_intensity, float exposure)
+{
+	vec3 hdr_color = SampleHDRBilinear(src_pos, tile_origin).rgb;
+	return clamp(Tonemap(mix(hdr_color, bloom, bloom_intensity), exposure), 0.0, 1.0);
+}
+
 void main()
 {
 	const ivec2 texel_pos = ivec2(gl_GlobalInvocationID.xy);
-	vec4 hdr_color = imageLoad(g_inputs[push.hdr_src_index], texel_pos);
-	vec3 final_color = hdr_color.xyz;
+	const ivec2 output_size = imageSize(g_outputs[push.sdr_dst_index]);
+
+	// Upscale from the source resolution to the output resolution
+	vec2 src_scale = vec2(push.src_width, push.src_height) / vec2(output_size);
+	vec2 bloom_scale = vec2(push.bloom_width, push.bloom_height) / vec2(output_size);
+
+	ivec2 hdr_tile_origin = GetTileOrigin(src_scale);
+	ivec2 bloom_tile_origin = GetTileOrigin(bloom_scale);
+	LoadTiles(hdr_tile_origin, bloom_tile_origin);
+
+	if (any(greaterThanEqual(texel_pos, output_size)))
+		return;
+
+	vec2 src_pos = (vec2(texel_pos) + 0.5) * src_scale;
+	float exposure = GetExposure();
+
+	vec4 hdr_color = SampleHDRBilinear(src_pos, hdr_tile_origin);
+	vec3 bloom = vec3(0.0);
+	float bloom_intensity = 0.0;
+
+	if (settings.postfx_use_bloom != 0)
+	{
+		bloom = SampleBloomTent((vec2(texel_pos) + 0.5) * bloom_scale, bloom_tile_origin);
+		bloom_intensity = settings.postfx_bloom_intensity;
+		hdr_color.rgb = mix(hdr_color.rgb, bloom, bloom_intensity);
+	}
+
+	vec3 final_color = Tonemap(hdr_color.rgb, exposure);
+
+	// Contrast adaptive sharpening of the upscaled result, based on RCAS
+	// The negative lobe on the neighbours, one render resolution texel away, is limited so that the result never leaves their min/max range
+	if (push.sharpness > 0.0)
+	{
+		vec3 center = clamp(final_color, 0.0, 1.0);
+		vec3 north = SampleTonemapped(src_pos + vec2(0.0, -1.0), hdr_tile_origin, bloom, bloom_intensity, exposure);
+		vec3 south = SampleTonemapped(src_pos + vec2(0.0, 1.0), hdr_tile_origin, bloom, bloom_intensity, exposure);
+		vec3 east = SampleTonemapped(src_pos + vec2(1.0, 0.0), hdr_tile_origin, bloom, bloom_intensity, exposure);
+		vec3 west = SampleTonemapped(src_pos + vec2(-1.0, 0.0), hdr_tile_origin, bloom, bloom_intensity, exposure);
+
+		vec3 min_rgb = min(min(north, south), min(east, west));
+		vec3 max_rgb = max(max(north, south), max(east, west));
+
+		vec3 hit_min = min_rgb / (4.0 * max_rgb + 1e-5);
+		vec3 hit_max = (1.0 - max_rgb) / (4.0 * min_rgb - 4.0 - 1e-5);
+		vec3 lobe_rgb = max(-hit_min, hit_max);
+		float lobe = max(-SHARPEN_LOBE_LIMIT, min(max(lobe_rgb.r, max(lobe_rgb.g, lobe_rgb.b)), 0.0)) * push.sharpness;
 
-	final_color = ApplyExposure(final_color.rgb, settings.postfx_exposure);
-	final_color = TonemapReinhardLumaWhite(final_color.rgb, settings.postfx_max_white);
-	final_color = LinearToSRGB(final_color, settings.postfx_gamma);
+		final_color = (lobe * (north + south + east + west) + center) / (4.0 * lobe + 1.0);
+	}
 
 	// Image store always takes in a vec4, but if the destination texture is e.g. format RG16,
 	// then only the RG components will be written and the others ignored
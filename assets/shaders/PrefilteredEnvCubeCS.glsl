@@ -0,0 +1,70 @@
+#version 460
+
+/*
+
+	This compute shader generates a prefiltered map used in image-based lighting for specular lighting from an HDR environment map
+	Dispatched once per mip (roughness level), with the Z dimension covering all 6 faces of the cubemap
+
+*/
+
+#include "BRDF.glsl"
+
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16f) uniform restrict writeonly image2DArray g_cube_outputs[];
+
+layout(std140, push_constant) uniform PushConsts
+{
+	layout(offset = 0) uint src_texture_index;
+	layout(offset = 4) uint src_sampler_index;
+	layout(offset = 8) uint src_resolution;
+	layout(offset = 12) uint dst_texture_index;
+	layout(offset = 16) uint dst_resolution;
+	layout(offset = 20) uint num_samples;
+	layout(offset = 24) float roughness;
+} push;
+
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+void main()
+{
+	uvec3 texel = gl_GlobalInvocationID;
+	if (texel.x >= push.dst_resolution || texel.y >= push.dst_resolution)
+		return;
+
+	vec2 face_uv = (vec2(texel.xy) + 0.5) / float(push.dst_resolution);
+	vec3 normal = GetCubeFaceDirection(texel.z, face_uv);
+	vec3 R = normal;
+	vec3 V = R;
+
+	float total_weight = 0.0;
+	vec3 prefiltered_color = vec3(0.0);
+
+	float resolution = float(push.src_resolution);
+	float omega_p = 4.0 * PI / (6.0 * resolution * resolution);
+
+	for (uint i = 0; i < push.num_samples; ++i)
+	{
+		vec2 Xi = Hammersley2D(i, push.num_samples);
+		vec3 H = ImportanceSampleGGX(Xi, push.roughness, normal);
+		vec3 L = normalize(2.0 * dot(V, H) * H - V);
+
+		float NoL = clamp(dot(normal, L), 0.0, 1.0);
+		if (NoL > 0.0)
+		{
+			// Improvement for bright dots in lower mips
+			// Source: https://chetanjags.wordpress.com/2015/08/26/image-based-lighting/
+			float NoH = clamp(dot(normal, H), 0.0, 1.0);
+			float HoV = clamp(dot(H, V), 0.0, 1.0);
+			float D = D_GGX(NoH, push.roughness);
+			float pdf = (D * NoH / (4.0 * HoV)) + 0.0001;
+
+			float omega_s = 1.0 / (float(push.num_samples) * pdf);
+			float mip = push.roughness == 0.0 ? 0.0 : max(0.5 * log2(omega_s / omega_p) + 1.0, 0.0);
+
+			prefiltered_color += SampleTextureCubeLod(push.src_texture_index, push.src_sampler_index, L, mip).rgb * NoL;
+			total_weight += NoL;
+		}
+	}
+
+	prefiltered_color = prefiltered_color / total_weight;
+	imageStore(g_cube_outputs[push.dst_texture_index], ivec3(texel), vec4(prefiltered_color, 1.0));
+}
@@ -41,7 +41,43 @@ const uint RESERVED_DESCRIPTOR_STORAGE_IMAGE_SDR = 1;
 
 // Max values
 const uint MAX_UNIQUE_MATERIALS = 1000;
-const uint MAX_AREA_LIGHTS = 100;
+const uint MAX_AREA_LIGHTS = 4096;
+
+// Clustered light culling
+// The view frustum is divided into froxels, X and Y are evenly spaced in screen space, Z is sliced exponentially in view space
+const uint LIGHT_CLUSTERS_X = 16;
+const uint LIGHT_CLUSTERS_Y = 9;
+const uint LIGHT_CLUSTERS_Z = 24;
+const uint LIGHT_CLUSTERS_TOTAL = LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y * LIGHT_CLUSTERS_Z;
+// Lights beyond this are dropped from the cluster, the cluster light count still includes them so that the overflow shows up in the renderer stats
+const uint LIGHT_CLUSTER_MAX_LIGHTS = 64;
+const uint LIGHT_CULLING_GROUP_SIZE = 64;
+// Radiance threshold at which an area light no longer contributes to a cluster, used to determine the light range
+const float LIGHT_INFLUENCE_THRESHOLD = 0.01f;
+
+// Spherical harmonics irradiance
+// Each cubemap face projects the environment onto 9 SH coefficients (L2), the faces are summed when evaluating the irradiance
+// Every face writes IBL_SH_NUM_COEFFICIENTS coefficients followed by the total solid angle it covered
+const uint IBL_SH_NUM_COEFFICIENTS = 9;
+const uint IBL_SH_FACE_STRIDE = IBL_SH_NUM_COEFFICIENTS + 1;
+const uint IBL_SH_PROJECT_GROUP_SIZE = 8;
+
+// Visibility buffer
+// Stores the instance index and triangle index for each pixel, pixels not covered by any geometry keep the clear value
+const uint VISIBILITY_BUFFER_CLEAR_VALUE = 0xFFFFFFFF;
+
+// Temporal anti-aliasing
+// Motion vectors are stored in UV units, pixels without geometry keep the clear value and are reprojected with the camera motion only
+const float VELOCITY_BUFFER_CLEAR_VALUE = 1000.0;
+const uint TAA_RESOLVE_GROUP_SIZE = 8;
+
+// Post-processing
+// The luminance histogram has one bin per thread of the histogram and auto exposure workgroups, bin 0 holds the pixels that are too dark to be measured
+const uint LUMINANCE_HISTOGRAM_NUM_BINS = 256;
+const uint LUMINANCE_HISTOGRAM_GROUP_SIZE = 16;
+// Bloom is built from a chain of render targets, each half the size of the previous one, the first is half the size of the post-processing source
+const uint BLOOM_NUM_MIPS = 6;
+const uint POST_PROCESS_GROUP_SIZE = 8;
 
 // Debug render modes
 const uint DEBUG_RENDER_MODE_NONE = 0;
@@ -97,6 +133,14 @@ DECLARE_STRUCT(InstanceData)
 {
 	float transform[4][4];
 	uint material_index;
+
+	// Used by the visibility buffer to pull the vertices of a triangle
+	uint vertex_buffer_index;
+	uint index_buffer_index;
+	uint index_stride;
+
+	// Transform of the same draw list entry in the previous frame, for the motion vectors
+	float prev_transform[4][4];
 };
 
 DECLARE_STRUCT_UBO(RenderSettings)
@@ -116,8 +160,28 @@ DECLARE_STRUCT_UBO(RenderSettings)
 	float postfx_gamma;
 	float postfx_max_white;
 
+	// With auto exposure enabled, the exposure above is applied on top of the measured exposure as exposure compensation
+	uint postfx_use_auto_exposure;
+	float postfx_auto_exposure_min_log_luminance;
+	float postfx_auto_exposure_log_luminance_range;
+	// Rate at which the adapted luminance approaches the measured luminance, per second
+	float postfx_auto_exposure_adaptation_rate;
+
+	uint postfx_use_bloom;
+	float postfx_bloom_intensity;
+
 	uint debug_render_mode;
 	uint white_furnace_test;
+
+	uint use_visibility_buffer;
+};
+
+// Written by the luminance histogram and auto exposure passes, and persists between frames for the eye adaptation
+DECLARE_STRUCT(AutoExposureData)
+{
+	uint histogram[LUMINANCE_HISTOGRAM_NUM_BINS];
+	float adapted_luminance;
+	float exposure;
 };
 
 DECLARE_STRUCT_UBO(GPUCamera)
@@ -125,6 +189,19 @@ DECLARE_STRUCT_UBO(GPUCamera)
 	mat4 view;
 	mat4 proj;
 	vec4 view_pos;
+
+	float near_plane;
+	float far_plane;
+	uint render_width;
+	uint render_height;
+
+	// The projection above is jittered when temporal anti-aliasing is enabled, the motion vectors use the unjittered ones
+	mat4 unjittered_view_proj;
+	mat4 prev_view_proj;
+	// Maps clip space positions of the current frame on the far plane to the previous frame, for pixels without motion vectors
+	mat4 reprojection;
+	// Sub-pixel offset of the projection, in render resolution pixels
+	vec2 jitter;
 };
 
 DECLARE_STRUCT_UBO(GPUMaterial)
@@ -159,6 +236,11 @@ DECLARE_STRUCT_UBO(GPUAreaLight)
 	float color_blue;
 	vec3 vert3;
 	float intensity;
+
+	// Bounding sphere of the light quad, extended by the range at which the light falls off below LIGHT_INFLUENCE_THRESHOLD
+	vec3 bounds_center;
+	float bounds_radius;
+
 	bool two_sided;
 	uint texture_index;
 };
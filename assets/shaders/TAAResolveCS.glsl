@@ -0,0 +1,149 @@
+#version 460
+
+#include "Common.glsl"
+
+/*
+
+	Temporal anti-aliasing resolve, runs at the output resolution and upsamples from the render resolution
+	Every output pixel takes the render resolution sample closest to it, and blends it with the reprojected history
+	The history is clamped to the neighbourhood of the current sample, to reject history that is no longer visible
+
+*/
+
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16f) uniform restrict readonly image2D g_inputs[];
+layout(set = DESCRIPTOR_SET_STORAGE_IMAGE, binding = 0, rgba16f) uniform restrict writeonly image2D g_outputs[];
+
+layout(std140, push_constant) uniform PushConsts
+{
+	layout(offset = 0) uint hdr_src_index;
+	layout(offset = 4) uint velocity_src_index;
+	layout(offset = 8) uint history_src_index;
+	layout(offset = 12) uint history_dst_index;
+	layout(offset = 16) uint history_valid;
+	layout(offset = 20) float blend_factor;
+} push;
+
+// Scales the standard deviation of the neighbourhood, larger values keep more history at the cost of more ghosting
+const float VARIANCE_CLIP_GAMMA = 1.25;
+// Falloff of the weight of the current sample with its distance to the output pixel center, in render resolution pixels
+// Approximates a Blackman-Harris window with a gaussian
+const float SAMPLE_DISTANCE_FALLOFF = 2.29;
+
+layout(local_size_x = TAA_RESOLVE_GROUP_SIZE, local_size_y = TAA_RESOLVE_GROUP_SIZE) in;
+
+vec3 RGBToYCoCg(vec3 rgb)
+{
+	return vec3(
+		0.25 * rgb.r + 0.5 * rgb.g + 0.25 * rgb.b,
+		0.5 * rgb.r - 0.5 * rgb.b,
+		-0.25 * rgb.r + 0.5 * rgb.g - 0.25 * rgb.b
+	);
+}
+
+vec3 YCoCgToRGB(vec3 ycocg)
+{
+	return vec3(
+		ycocg.x + ycocg.y - ycocg.z,
+		ycocg.x + ycocg.z,
+		ycocg.x - ycocg.y - ycocg.z
+	);
+}
+
+// Blending in a tonemapped space keeps very bright samples from dominating the result, which shows up as flickering on highlights
+vec3 TonemapWeight(vec3 color)
+{
+	return color / (1.0 + max(color.r, max(color.g, color.b)));
+}
+
+vec3 InverseTonemapWeight(vec3 color)
+{
+	return color / max(1.0 - max(color.r, max(color.g, color.b)), 1e-5);
+}
+
+// The HDR and velocity render targets are allocated at output resolution, but only the top-left render_width x render_height texels are rendered to
+ivec2 ClampToRenderSize(ivec2 texel_pos)
+{
+	return clamp(texel_pos, ivec2(0), ivec2(camera.render_width, camera.render_height) - 1);
+}
+
+// The history is only bound as a storage image, so the bilinear filter is done by hand
+vec3 SampleHistoryBilinear(vec2 pos, ivec2 history_size)
+{
+	vec2 texel = pos - 0.5;
+	ivec2 base = ivec2(floor(texel));
+	vec2 frac = texel - vec2(base);
+
+	ivec2 max_texel_pos = history_size - 1;
+	vec3 c00 = imageLoad(g_inputs[push.history_src_index], clamp(base, ivec2(0), max_texel_pos)).rgb;
+	vec3 c10 = imageLoad(g_inputs[push.history_src_index], clamp(base + ivec2(1, 0), ivec2(0), max_texel_pos)).rgb;
+	vec3 c01 = imageLoad(g_inputs[push.history_src_index], clamp(base + ivec2(0, 1), ivec2(0), max_texel_pos)).rgb;
+	vec3 c11 = imageLoad(g_inputs[push.history_src_index], clamp(base + ivec2(1, 1), ivec2(0), max_texel_pos)).rgb;
+
+	return mix(mix(c00, c10, frac.x), mix(c01, c11, frac.x), frac.y);
+}
+
+void main()
+{
+	const ivec2 texel_pos = ivec2(gl_GlobalInvocationID.xy);
+	const ivec2 output_size = imageSize(g_outputs[push.history_dst_index]);
+
+	if (any(greaterThanEqual(texel_pos, output_size)))
+		return;
+
+	// The jittered projection shifts the image by the jitter, so render pixel i contains the scene at (i + 0.5 - jitter)
+	// The render pixel closest to this output pixel is then floor(render_pos + jitter)
+	vec2 uv = (vec2(texel_pos) + 0.5) / vec2(output_size);
+	vec2 render_pos = uv * vec2(camera.render_width, camera.render_height);
+	ivec2 sample_pos = ClampToRenderSize(ivec2(floor(render_pos + camera.jitter)));
+	vec2 sample_offset = vec2(sample_pos) + 0.5 - camera.jitter - render_pos;
+
+	vec4 hdr_sample = imageLoad(g_inputs[push.hdr_src_index], sample_pos);
+	vec3 current = TonemapWeight(hdr_sample.rgb);
+
+	// Mean and standard deviation of the 3x3 neighbourhood, for the variance clipping of the history
+	vec3 moment1 = vec3(0.0);
+	vec3 moment2 = vec3(0.0);
+
+	for (int y = -1; y <= 1; ++y)
+	{
+		for (int x = -1; x <= 1; ++x)
+		{
+			vec3 neighbour = RGBToYCoCg(TonemapWeight(imageLoad(g_inputs[push.hdr_src_index], ClampToRenderSize(sample_pos + ivec2(x, y))).rgb));
+			moment1 += neighbour;
+			moment2 += neighbour * neighbour;
+		}
+	}
+
+	vec3 mean = moment1 / 9.0;
+	vec3 std_dev = sqrt(max(moment2 / 9.0 - mean * mean, 0.0));
+	vec3 neighbourhood_min = mean - VARIANCE_CLIP_GAMMA * std_dev;
+	vec3 neighbourhood_max = mean + VARIANCE_CLIP_GAMMA * std_dev;
+
+	// Pixels that no geometry was rendered to have no motion vectors, so those are reprojected with the camera motion only
+	vec2 velocity = texelFetch(g_textures[push.velocity_src_index], sample_pos, 0).rg;
+	vec2 prev_uv;
+
+	if (velocity.x >= VELOCITY_BUFFER_CLEAR_VALUE * 0.5)
+	{
+		vec4 prev_clip_pos = camera.reprojection * vec4(uv * 2.0 - 1.0, 1.0, 1.0);
+		prev_uv = (prev_clip_pos.xy / prev_clip_pos.w) * 0.5 + 0.5;
+	}
+	else
+	{
+		prev_uv = uv - velocity;
+	}
+
+	vec3 result = current;
+
+	if (push.history_valid != 0 && all(greaterThanEqual(prev_uv, vec2(0.0))) && all(lessThanEqual(prev_uv, vec2(1.0))))
+	{
+		vec3 history = RGBToYCoCg(TonemapWeight(SampleHistoryBilinear(prev_uv * vec2(output_size), output_size)));
+		history = YCoCgToRGB(clamp(history, neighbourhood_min, neighbourhood_max));
+
+		// When upsampling, output pixels far from the current sample rely more on the history
+		float blend = push.blend_factor * exp(-SAMPLE_DISTANCE_FALLOFF * dot(sample_offset, sample_offset));
+		result = mix(history, current, blend);
+	}
+
+	imageStore(g_outputs[push.history_dst_index], texel_pos, vec4(InverseTonemapWeight(result), hdr_sample.a));
+}
@@ -0,0 +1,23 @@
+#version 460
+#include "Common.glsl"
+
+/*
+
+	Writes the instance index and triangle index for each visible pixel, which the visibility buffer shading pass
+	uses to reconstruct the vertex attributes of the triangle through vertex pulling
+	Also writes the motion vectors for temporal anti-aliasing
+
+*/
+
+layout(location = 0) flat in uint instance_index;
+layout(location = 1) in vec4 clip_pos;
+layout(location = 2) in vec4 prev_clip_pos;
+
+layout(location = 0) out uvec2 out_visibility;
+layout(location = 1) out vec2 out_velocity;
+
+void main()
+{
+	out_visibility = uvec2(instance_index, gl_PrimitiveID);
+	out_velocity = GetVelocity(clip_pos, prev_clip_pos);
+}
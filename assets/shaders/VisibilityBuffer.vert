@@ -0,0 +1,26 @@
+#version 460
+#include "Common.glsl"
+
+layout(std140, push_constant) uniform PushConsts
+{
+	layout(offset = 0) uint ib_index;
+	layout(offset = 4) uint vb_index;
+} push;
+
+layout(location = 0) flat out uint instance_index;
+layout(location = 1) out vec4 clip_pos;
+layout(location = 2) out vec4 prev_clip_pos;
+
+void main()
+{
+	mat4 transform = GetInstanceTransform(push.ib_index, gl_InstanceIndex);
+	vec3 vertex_pos = GetVertexPos(push.vb_index, gl_VertexIndex);
+
+	vec4 world_pos = transform * vec4(vertex_pos, 1.0f);
+	gl_Position = camera.proj * camera.view * world_pos;
+
+	instance_index = gl_InstanceIndex;
+
+	clip_pos = camera.unjittered_view_proj * world_pos;
+	prev_clip_pos = camera.prev_view_proj * GetInstancePrevTransform(push.ib_index, gl_InstanceIndex) * vec4(vertex_pos, 1.0f);
+}
@@ -0,0 +1,142 @@
+#version 460
+#include "BRDF.glsl"
+
+/*
+
+	Shades each pixel exactly once by reconstructing the surface attributes from the visibility buffer
+	The triangle vertices are pulled from the vertex and index buffers, and the attributes are interpolated using
+	perspective correct barycentrics, which also provide the screen space derivatives for texture sampling
+
+*/
+
+layout(std140, push_constant) uniform constants
+{
+	layout(offset = 8) uint irradiance_cubemap_index;
+	layout(offset = 12) uint irradiance_sampler_index;
+	layout(offset = 16) uint prefiltered_cubemap_index;
+	layout(offset = 20) uint prefiltered_sampler_index;
+	layout(offset = 24) uint num_prefiltered_mips;
+	layout(offset = 28) uint brdf_lut_index;
+	layout(offset = 32) uint brdf_lut_sampler_index;
+	layout(offset = 36) uint tlas_index;
+	layout(offset = 40) uint ib_index;
+	layout(offset = 44) uint visibility_buffer_index;
+} push;
+
+layout(location = 0) in vec2 tex_coord;
+
+layout(location = 0) out vec4 out_color;
+
+#include "PbrLighting.glsl"
+
+struct BarycentricDeriv
+{
+	vec3 lambda;
+	vec3 ddx;
+	vec3 ddy;
+};
+
+// Perspective correct barycentrics and their screen space derivatives from the clip space positions of the triangle
+// Source: http://filmicworlds.com/blog/visibility-buffer-rendering-with-material-graphs/
+BarycentricDeriv CalcBarycentricDeriv(vec4 clip0, vec4 clip1, vec4 clip2, vec2 pixel_ndc, vec2 render_size)
+{
+	BarycentricDeriv result;
+
+	vec3 inv_w = 1.0 / vec3(clip0.w, clip1.w, clip2.w);
+	vec2 ndc0 = clip0.xy * inv_w.x;
+	vec2 ndc1 = clip1.xy * inv_w.y;
+	vec2 ndc2 = clip2.xy * inv_w.z;
+
+	float inv_det = 1.0 / determinant(mat2(ndc2 - ndc1, ndc0 - ndc1));
+	result.ddx = vec3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * inv_det * inv_w;
+	result.ddy = vec3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * inv_det * inv_w;
+	float ddx_sum = dot(result.ddx, vec3(1.0));
+	float ddy_sum = dot(result.ddy, vec3(1.0));
+
+	vec2 delta = pixel_ndc - ndc0;
+	float interp_inv_w = inv_w.x + delta.x * ddx_sum + delta.y * ddy_sum;
+	float interp_w = 1.0 / interp_inv_w;
+
+	result.lambda.x = interp_w * (inv_w.x + delta.x * result.ddx.x + delta.y * result.ddy.x);
+	result.lambda.y = interp_w * (delta.x * result.ddx.y + delta.y * result.ddy.y);
+	result.lambda.z = interp_w * (delta.x * result.ddx.z + delta.y * result.ddy.z);
+
+	// Scale the derivatives from NDC to pixels, and make them perspective correct
+	result.ddx *= 2.0 / render_size.x;
+	result.ddy *= 2.0 / render_size.y;
+	ddx_sum *= 2.0 / render_size.x;
+	ddy_sum *= 2.0 / render_size.y;
+
+	float interp_w_ddx = 1.0 / (interp_inv_w + ddx_sum);
+	float interp_w_ddy = 1.0 / (interp_inv_w + ddy_sum);
+
+	result.ddx = interp_w_ddx * (result.lambda * interp_inv_w + result.ddx) - result.lambda;
+	result.ddy = interp_w_ddy * (result.lambda * interp_inv_w + result.ddy) - result.lambda;
+
+	return result;
+}
+
+vec3 Interpolate(BarycentricDeriv bary, vec3 v0, vec3 v1, vec3 v2)
+{
+	return bary.lambda.x * v0 + bary.lambda.y * v1 + bary.lambda.z * v2;
+}
+
+void main()
+{
+	uvec2 visibility = texelFetch(g_uint_textures[push.visibility_buffer_index], ivec2(gl_FragCoord.xy), 0).rg;
+	if (visibility.x == VISIBILITY_BUFFER_CLEAR_VALUE)
+	{
+		// No geometry covers this pixel, keep the skybox
+		discard;
+	}
+
+	uint instance_index = visibility.x;
+	uint triangle_index = visibility.y;
+
+	InstanceData instance = g_instance_ssbos[push.ib_index].instance_data[instance_index];
+	mat4 transform = GetInstanceTransform(push.ib_index, instance_index);
+
+	// Pull the triangle vertices
+	vec3 world_pos[3];
+	vec4 clip_pos[3];
+	vec2 vertex_tex_coords[3];
+	vec3 vertex_normals[3];
+	vec4 vertex_tangents[3];
+
+	for (uint i = 0; i < 3; ++i)
+	{
+		uint vertex_index = GetVertexIndex(instance.index_buffer_index, instance.index_stride, triangle_index * 3 + i);
+
+		world_pos[i] = (transform * vec4(GetVertexPos(instance.vertex_buffer_index, vertex_index), 1.0)).xyz;
+		clip_pos[i] = camera.proj * camera.view * vec4(world_pos[i], 1.0);
+		vertex_tex_coords[i] = GetVertexTexCoord(instance.vertex_buffer_index, vertex_index);
+		vertex_normals[i] = GetVertexNormal(instance.vertex_buffer_index, vertex_index);
+		vertex_tangents[i] = GetVertexTangent(instance.vertex_buffer_index, vertex_index);
+	}
+
+	vec2 render_size = vec2(camera.render_width, camera.render_height);
+	vec2 pixel_ndc = (gl_FragCoord.xy / render_size) * 2.0 - 1.0;
+	BarycentricDeriv bary = CalcBarycentricDeriv(clip_pos[0], clip_pos[1], clip_pos[2], pixel_ndc, render_size);
+
+	// Interpolate the vertex attributes, in the same way as the forward lighting vertex shader
+	vec3 tex_coords_x = vec3(vertex_tex_coords[0].x, vertex_tex_coords[1].x, vertex_tex_coords[2].x);
+	vec3 tex_coords_y = vec3(vertex_tex_coords[0].y, vertex_tex_coords[1].y, vertex_tex_coords[2].y);
+
+	vec3 vertex_normal = Interpolate(bary, vertex_normals[0], vertex_normals[1], vertex_normals[2]);
+	vec3 vertex_tangent = Interpolate(bary, vertex_tangents[0].xyz, vertex_tangents[1].xyz, vertex_tangents[2].xyz);
+
+	SurfaceInfo surface;
+	surface.pos_world = Interpolate(bary, world_pos[0], world_pos[1], world_pos[2]);
+	surface.tex_coord = vec2(dot(bary.lambda, tex_coords_x), dot(bary.lambda, tex_coords_y));
+	surface.tex_coord_ddx = vec2(dot(bary.ddx, tex_coords_x), dot(bary.ddx, tex_coords_y));
+	surface.tex_coord_ddy = vec2(dot(bary.ddy, tex_coords_x), dot(bary.ddy, tex_coords_y));
+
+	surface.normal = normalize(transform * vec4(vertex_normal, 0.0)).xyz;
+	surface.tangent = normalize(transform * vec4(vertex_tangent, 0.0)).xyz;
+	// NOTE: Re-orthogonalize the tangent (Gram-Schmidt process), see PbrLighting.vert
+	surface.tangent = normalize(surface.tangent - dot(surface.tangent, surface.normal) * surface.normal);
+	surface.bitangent = normalize(cross(surface.normal, surface.tangent)) * (-vertex_tangents[0].w);
+	surface.material_index = instance.material_index;
+
+	out_color = vec4(ShadeSurface(surface), 1.0);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "Entity.h"
+#include "Geometry.h"
+
+/*
+
+	The AABBTree is a dynamic bounding volume hierarchy over entity bounds, used for culling, picking and other spatial queries
+	Leaves are inserted next to the sibling that increases the surface area of the tree the least, and the tree is kept balanced with rotations
+	Leaf bounds are fattened by a margin, so entities that move a little only need their leaf refitted, and are only reinserted
+	once they leave their fattened bounds. Queries test against the fattened bounds, so they can return entities that are just outside
+
+*/
+
+class AABBTree
+{
+public:
+	static constexpr float FAT_AABB_MARGIN = 0.1f;
+
+public:
+	void Insert(EntityHandle entity, const AABB& aabb);
+	void Remove(EntityHandle entity);
+	// Returns true if the entity moved out of its fattened bounds and had to be reinserted
+	bool Update(EntityHandle entity, const AABB& aabb);
+	bool Contains(EntityHandle entity) const;
+
+	// Queries append the entities that pass the test to entities
+	void QueryFrustum(const Frustum& frustum, std::vector<EntityHandle>& entities) const;
+	void QueryOverlap(const AABB& aabb, std::vector<EntityHandle>& entities) const;
+	void QueryRay(const glm::vec3& origin, const glm::vec3& direction, float max_distance, std::vector<EntityHandle>& entities) const;
+	// Returns the entity whose bounds the ray enters first, or an invalid handle if it does not hit anything
+	EntityHandle RayCast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, float* hit_distance = nullptr) const;
+
+	size_t GetSize() const { return m_num_leaves; }
+	uint32_t GetHeight() const;
+	// Checks the links, heights and bounds of every node, used by the tests
+	bool Validate() const;
+
+private:
+	static constexpr uint32_t INVALID_NODE = ~0u;
+	// The tree is balanced, so traversals never get close to this depth
+	static constexpr uint32_t MAX_TRAVERSAL_STACK_SIZE = 256;
+
+	struct Node
+	{
+		AABB aabb;
+
+		// Next free node while the node is on the free list
+		uint32_t parent = INVALID_NODE;
+		uint32_t children[2] = { INVALID_NODE, INVALID_NODE };
+		// Leaves have a height of 0
+		uint32_t height = 0;
+
+		EntityHandle entity;
+
+		bool IsLeaf() const { return children[0] == INVALID_NODE; }
+	};
+
+private:
+	uint32_t AllocateNode();
+	void FreeNode(uint32_t node);
+
+	void InsertLeaf(uint32_t leaf);
+	void RemoveLeaf(uint32_t leaf);
+	// Rotates the subtree if its children differ in height by more than one, returns the node that took its place
+	uint32_t Balance(uint32_t node);
+	void RefitAncestors(uint32_t node);
+
+	uint32_t FindLeaf(EntityHandle entity) const;
+	uint32_t ValidateSubtree(uint32_t node, uint32_t parent, bool& valid) const;
+
+private:
+	std::vector<Node> m_nodes;
+	uint32_t m_root = INVALID_NODE;
+	uint32_t m_free_list = INVALID_NODE;
+	size_t m_num_leaves = 0;
+
+	// Indexed by entity index
+	std::vector<uint32_t> m_entity_to_leaf;
+
+};
@@ -1,9 +1,28 @@
 #pragma once
+#include <filesystem>
 
 namespace Application
 {
 
-	void Init();
+	struct Options
+	{
+		// Renders offscreen without a window, runs the frame benchmark and closes the application once it is done
+		bool headless = false;
+		uint32_t width = 1280;
+		uint32_t height = 720;
+
+		// Warmup frames are rendered before the benchmark starts and are not part of the results
+		uint32_t warmup_frames = 100;
+		uint32_t benchmark_frames = 1000;
+		// Hashes the rendered output every N benchmark frames, 0 disables checksums
+		// Every checksum waits for the GPU to be idle, so this affects the timings of the frame after it
+		uint32_t checksum_interval = 0;
+		std::filesystem::path output_filepath = "benchmarks/benchmark.json";
+		// Loaded instead of the default scene if set, the default scene is used if the file can not be loaded
+		std::filesystem::path scene_filepath;
+	};
+
+	void Init(const Options& options = {});
 	void Exit();
 	void Run();
 
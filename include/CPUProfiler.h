@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+
+	The CPUProfiler records scopes from any thread into per-thread ring buffers, which the main thread drains at the end of every frame
+	Scopes are only recorded while a capture is running or the live view is open, otherwise a scope costs a single atomic load
+	A capture records a number of frames and writes them to a Chrome trace JSON file, which can be opened in chrome://tracing or Perfetto
+
+*/
+
+namespace CPUProfiler
+{
+
+	// Registers the calling thread as the main thread
+	void Init();
+	// Stops recording and waits for scopes that are still being recorded on other threads, the calling thread can not have any scopes open
+	void Exit();
+
+	void BeginFrame();
+	void EndFrame();
+
+	// Captures the number of frames set in the UI, starting at the next BeginFrame
+	void StartCapture();
+	void RenderUI();
+
+	// Nanoseconds since the profiler was initialized
+	int64_t GetTimestamp();
+	// The name needs to outlive the profiler, since only the pointer is stored
+	// Can only be called between a successful AcquireRecording and the matching ReleaseRecording, or from the main thread
+	void RecordScope(const char* name, int64_t begin_timestamp, int64_t end_timestamp);
+
+	// Keeps the profiler alive until the matching ReleaseRecording, returns false if it is not recording, in which case nothing needs to be released
+	bool AcquireRecording();
+	void ReleaseRecording();
+
+	extern std::atomic<bool> is_recording;
+
+	class Scope
+	{
+	public:
+		explicit Scope(const char* name)
+		{
+			if (is_recording.load(std::memory_order_acquire) && AcquireRecording())
+			{
+				m_name = name;
+				m_begin_timestamp = GetTimestamp();
+			}
+		}
+
+		~Scope()
+		{
+			if (m_name)
+			{
+				RecordScope(m_name, m_begin_timestamp, GetTimestamp());
+				ReleaseRecording();
+			}
+		}
+
+		Scope(const Scope& other) = delete;
+		Scope& operator=(const Scope& other) = delete;
+
+	private:
+		const char* m_name = nullptr;
+		int64_t m_begin_timestamp = 0;
+
+	};
+
+}
+
+#ifdef ENABLE_CPU_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) CPUProfiler::Scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#endif
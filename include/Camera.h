@@ -11,6 +11,8 @@ public:
 
 	glm::mat4 GetView() const;
 	float GetVerticalFOV() const;
+	// Ray through a point on the screen, x and y go from -1 to 1, with y pointing down like window coordinates
+	void GetViewRay(float screen_x, float screen_y, float aspect_ratio, glm::vec3& origin, glm::vec3& direction) const;
 
 private:
 	glm::mat4 m_view = glm::identity<glm::mat4>();
@@ -0,0 +1,85 @@
+#pragma once
+
+/*
+
+	The ComponentPool stores one type of component for a set of entities, contiguously, so that systems can iterate over them linearly
+	It is a sparse set: the components and their owning entities are kept in dense arrays, and a sparse array indexed by entity index
+	points into them. Removing a component moves the last component into its place, so the order of components is not stable
+
+*/
+
+template<typename TComponent>
+class ComponentPool
+{
+private:
+	static constexpr uint32_t INVALID_INDEX = ~0u;
+
+public:
+	template<typename... TArgs>
+	TComponent& Add(ResourceHandle_t entity, TArgs&&... args)
+	{
+		VK_ASSERT(VK_RESOURCE_HANDLE_VALID(entity) && "Tried to add a component to an invalid entity");
+		VK_ASSERT(!Find(entity) && "Tried to add a component to an entity that already has one");
+
+		if (entity.index >= m_sparse.size())
+		{
+			m_sparse.resize(entity.index + 1, INVALID_INDEX);
+		}
+
+		m_sparse[entity.index] = (uint32_t)m_components.size();
+		m_entities.push_back(entity);
+
+		return m_components.emplace_back(std::forward<TArgs>(args)...);
+	}
+
+	void Remove(ResourceHandle_t entity)
+	{
+		if (!Find(entity))
+			return;
+
+		uint32_t dense_index = m_sparse[entity.index];
+		uint32_t last_dense_index = (uint32_t)m_components.size() - 1;
+
+		if (dense_index != last_dense_index)
+		{
+			m_components[dense_index] = std::move(m_components[last_dense_index]);
+			m_entities[dense_index] = m_entities[last_dense_index];
+			m_sparse[m_entities[dense_index].index] = dense_index;
+		}
+
+		m_components.pop_back();
+		m_entities.pop_back();
+		m_sparse[entity.index] = INVALID_INDEX;
+	}
+
+	TComponent* Find(ResourceHandle_t entity)
+	{
+		if (!VK_RESOURCE_HANDLE_VALID(entity) || entity.index >= m_sparse.size())
+			return nullptr;
+
+		// The entity stored in the dense array also checks the version, so components of deleted entities are never returned
+		uint32_t dense_index = m_sparse[entity.index];
+		if (dense_index == INVALID_INDEX || !(m_entities[dense_index] == entity))
+			return nullptr;
+
+		return &m_components[dense_index];
+	}
+
+	const TComponent* Find(ResourceHandle_t entity) const
+	{
+		return const_cast<ComponentPool*>(this)->Find(entity);
+	}
+
+	// Components and entities at the same position belong together
+	std::span<TComponent> GetComponents() { return m_components; }
+	std::span<const TComponent> GetComponents() const { return m_components; }
+	std::span<const ResourceHandle_t> GetEntities() const { return m_entities; }
+
+	size_t GetSize() const { return m_components.size(); }
+
+private:
+	std::vector<TComponent> m_components;
+	std::vector<ResourceHandle_t> m_entities;
+	std::vector<uint32_t> m_sparse;
+
+};
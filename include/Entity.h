@@ -2,78 +2,43 @@
 #include "renderer/RenderTypes.h"
 #include "assets/AssetTypes.h"
 
-// Entity interface
-class Entity
-{
-public:
-	Entity(const std::string& label);
+/*
 
-	virtual void Update(float dt) = 0;
-	virtual void Render() = 0;
-	virtual void RenderUI() = 0;
+	Entities are handles into the scene, all of their data lives in components, which the scene stores in a ComponentPool per type
+	Components are plain data, the scene systems iterate over them
 
-protected:
-	std::string m_label = "";
+*/
 
-};
+using EntityHandle = ResourceHandle_t;
 
-class MeshObject : public Entity
+struct TransformComponent
 {
-public:
-	MeshObject(const std::string& label);
-	MeshObject(RenderResourceHandle mesh_handle, const MaterialAsset& material, const glm::mat4& transform, const std::string& label);
-
-	virtual void Update(float dt) override;
-	virtual void Render() override;
-	virtual void RenderUI() override;
-
-private:
-	RenderResourceHandle m_mesh_handle = {};
-	MaterialAsset m_material;
-
-	glm::mat4 m_transform = glm::identity<glm::mat4>();
-	glm::vec3 m_translation = glm::vec3(0.0f);
-	glm::vec3 m_rotation = glm::vec3(0.0f);
-	glm::vec3 m_scale = glm::vec3(1.0f);
-
+	glm::vec3 translation = glm::vec3(0.0f);
+	// Euler angles, in degrees
+	glm::vec3 rotation = glm::vec3(0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
 };
 
-//class Pointlight : public Entity
-//{
-//public:
-//	Pointlight(const glm::vec3& pos, const glm::vec3& color, float intensity, const std::string& label);
-//
-//	virtual void Update(float dt) override;
-//	virtual void Render() override;
-//	virtual void RenderUI() override;
-//
-//private:
-//	glm::vec3 m_position = glm::vec3(0.0f);
-//	glm::vec3 m_color = glm::vec3(1.0f);
-//	float m_intensity = 1.0f;
-//
-//};
-
-class AreaLight : public Entity
+struct MeshComponent
 {
-public:
-	AreaLight(const std::string& label);
-	AreaLight(RenderResourceHandle texture_handle, const glm::mat4& transform, const glm::vec3& color, float intensity, bool two_sided, const std::string& label);
-
-	virtual void Update(float dt) override;
-	virtual void Render() override;
-	virtual void RenderUI() override;
-
-private:
-	RenderResourceHandle m_texture_handle = {};
-
-	glm::mat4 m_transform = glm::identity<glm::mat4>();
-	glm::vec3 m_translation = glm::vec3(0.0f);
-	glm::vec3 m_rotation = glm::vec3(0.0f);
-	glm::vec3 m_scale = glm::vec3(1.0f);
+	RenderResourceHandle mesh_handle;
+	// Owned by the entity, the material is destroyed together with the entity
+	RenderResourceHandle material_handle;
+
+	// The model node and mesh the mesh handle was taken from, so that scene files can reference the mesh through its asset
+	// Invalid for meshes that were not created from a model
+	AssetHandle model_handle;
+	uint32_t node_index = 0;
+	uint32_t node_mesh_index = 0;
+};
 
-	glm::vec3 m_color = glm::vec3(0.0);
-	float m_intensity = 1.0f;
-	bool m_two_sided = false;
+struct AreaLightComponent
+{
+	// The texture handle is resolved from the texture asset when the area light is created
+	AssetHandle texture_asset_handle;
+	RenderResourceHandle texture_handle;
 
+	glm::vec3 color = glm::vec3(1.0f);
+	float intensity = 1.0f;
+	bool two_sided = false;
 };
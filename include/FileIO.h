@@ -17,4 +17,9 @@ namespace FileIO
 	ReadImageResult ReadImage(const std::filesystem::path& filepath);
 	//void WriteImage(const std::filesystem::path& filepath);
 
+	// Returns false if the file does not exist or could not be read
+	bool ReadBinary(const std::filesystem::path& filepath, std::vector<uint8_t>& bytes);
+	// Creates the parent directories if they do not exist yet
+	bool WriteBinary(const std::filesystem::path& filepath, std::span<const uint8_t> bytes);
+
 }
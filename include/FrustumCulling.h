@@ -0,0 +1,37 @@
+#pragma once
+#include "Geometry.h"
+
+/*
+
+	CPU frustum culling of bounding spheres, used to cull the draw list before recording the geometry passes
+	The spheres are stored in SoA layout, so that the kernel tests 8 (AVX2) or 4 (SSE) spheres against a plane at once
+	A sphere is only culled if it is fully behind one of the planes, so the result is conservative, spheres near the corners
+	of the frustum can be kept even though they are outside of it
+
+*/
+
+namespace FrustumCulling
+{
+
+	struct BoundingSpheres
+	{
+		const float* x = nullptr;
+		const float* y = nullptr;
+		const float* z = nullptr;
+		const float* radius = nullptr;
+	};
+
+	// Writes the indices of the visible spheres in [first, first + count) to visible_indices, in increasing order,
+	// visible_indices needs room for count indices, returns the number of visible spheres
+	uint32_t CullSpheres(const Frustum& frustum, const BoundingSpheres& spheres, uint32_t first, uint32_t count, uint32_t* visible_indices);
+	// Plain scalar version of CullSpheres, the SIMD kernel is validated against it
+	uint32_t CullSpheresScalar(const Frustum& frustum, const BoundingSpheres& spheres, uint32_t first, uint32_t count, uint32_t* visible_indices);
+
+	// Below this many spheres per thread, starting a thread costs more than culling the spheres
+	static constexpr uint32_t MIN_SPHERES_PER_THREAD = 16384;
+
+	// Splits the spheres into contiguous ranges that are culled on up to max_threads threads, including the calling thread,
+	// the visible indices of all ranges are compacted into visible_indices in increasing order, same as CullSpheres
+	uint32_t CullSpheresParallel(const Frustum& frustum, const BoundingSpheres& spheres, uint32_t count, uint32_t* visible_indices, uint32_t max_threads);
+
+}
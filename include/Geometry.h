@@ -0,0 +1,91 @@
+#pragma once
+#include <cfloat>
+
+/*
+
+	Bounding volumes used for culling and spatial queries on the CPU
+
+*/
+
+struct AABB
+{
+	// Empty by default, so that growing it by a point or another AABB starts from nothing
+	glm::vec3 min = glm::vec3(FLT_MAX);
+	glm::vec3 max = glm::vec3(-FLT_MAX);
+
+	glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+	glm::vec3 GetExtent() const { return (max - min) * 0.5f; }
+
+	float GetSurfaceArea() const
+	{
+		glm::vec3 size = max - min;
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	bool Contains(const AABB& other) const
+	{
+		return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+	}
+
+	bool Overlaps(const AABB& other) const
+	{
+		return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+	}
+
+	static AABB Union(const AABB& a, const AABB& b)
+	{
+		return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+	}
+
+	// Bounds of the transformed box, which are not tight if the transform rotates it
+	static AABB Transform(const AABB& aabb, const glm::mat4& transform)
+	{
+		glm::vec3 center = glm::vec3(transform * glm::vec4(aabb.GetCenter(), 1.0f));
+		glm::vec3 extent = aabb.GetExtent();
+
+		glm::vec3 transformed_extent =
+			glm::abs(glm::vec3(transform[0])) * extent.x +
+			glm::abs(glm::vec3(transform[1])) * extent.y +
+			glm::abs(glm::vec3(transform[2])) * extent.z;
+
+		return { center - transformed_extent, center + transformed_extent };
+	}
+};
+
+// The planes point inwards, a point is inside a plane if dot(plane.xyz, point) + plane.w >= 0
+struct Frustum
+{
+	enum Plane
+	{
+		PLANE_LEFT,
+		PLANE_RIGHT,
+		PLANE_BOTTOM,
+		PLANE_TOP,
+		PLANE_NEAR,
+		PLANE_FAR,
+		PLANE_NUM_PLANES
+	};
+
+	std::array<glm::vec4, PLANE_NUM_PLANES> planes;
+
+	// Extracts the planes from the rows of a view projection matrix with a zero to one depth range
+	static Frustum FromViewProjection(const glm::mat4& view_projection)
+	{
+		glm::mat4 rows = glm::transpose(view_projection);
+
+		Frustum frustum = {};
+		frustum.planes[PLANE_LEFT] = rows[3] + rows[0];
+		frustum.planes[PLANE_RIGHT] = rows[3] - rows[0];
+		frustum.planes[PLANE_BOTTOM] = rows[3] + rows[1];
+		frustum.planes[PLANE_TOP] = rows[3] - rows[1];
+		frustum.planes[PLANE_NEAR] = rows[2];
+		frustum.planes[PLANE_FAR] = rows[3] - rows[2];
+
+		for (glm::vec4& plane : frustum.planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+
+		return frustum;
+	}
+};
@@ -15,7 +15,7 @@ namespace Input
 
 	enum Button
 	{
-		Button_LeftMouse, Button_RightMouse,
+		Button_LeftMouse, Button_RightMouse, Button_MiddleMouse,
 		NumButtons
 	};
 
@@ -19,6 +19,9 @@
 #include <string>
 #include <set>
 #include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
 /*
 
@@ -40,6 +43,7 @@
 */
 
 #include "Logger.h"
+#include "CPUProfiler.h"
 
 #define VK_KB(x) (x << 10)
 #define VK_MB(x) (x << 20)
@@ -48,6 +52,19 @@
 #define VK_ALIGN_POW2(x, align) ((intptr_t)(x) + ((align) - 1) & (-(intptr_t)(align)))
 #define VK_ALIGN_DOWN_POW2(x, align) ((intptr_t)(x) & (-(intptr_t)(align)))
 
+// FNV-1a, used to key on-disk caches by their contents
+inline uint64_t HashBytes(const void* bytes, size_t num_bytes, uint64_t hash = 0xcbf29ce484222325ull)
+{
+	const uint8_t* bytes_ptr = reinterpret_cast<const uint8_t*>(bytes);
+	for (size_t i = 0; i < num_bytes; ++i)
+	{
+		hash ^= bytes_ptr[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
 #define VK_ASSERT(x) assert(x)
 #define VK_EXCEPT(...) { auto logged_msg = LOG_ERR(__VA_ARGS__); throw std::runtime_error(logged_msg); }
 
@@ -1,28 +1,45 @@
 #pragma once
+#include <bit>
+#include <shared_mutex>
 
-template<typename TResource>
+/*
+
+	The ResourceSlotmap hands out versioned handles to resources, which live in fixed-size pages that are added as the slotmap grows,
+	so pages never move and pointers to resources stay valid until the resource is deleted
+	Slot versions are kept in their own dense array, so validating a handle does not pull the resource into the cache
+	Live slots are tracked in a dense array as well, so ForEach only visits live resources
+
+*/
+
+template<typename TResource, uint32_t PAGE_SIZE = 256>
 class ResourceSlotmap
 {
 public:
 	static constexpr size_t DEFAULT_SLOTMAP_CAPACITY = 1000;
+	// Handle indices of ~0u are invalid, so the last page can not be filled completely
+	static constexpr size_t MAX_SLOTMAP_CAPACITY = (size_t)~0u / PAGE_SIZE * PAGE_SIZE;
+
+	static_assert(std::has_single_bit(PAGE_SIZE), "ResourceSlotmap page size needs to be a power of two");
 
 private:
-	static constexpr uint32_t INVALID_SLOT_INDEX = ~0u;
+	static constexpr uint32_t INVALID_INDEX = ~0u;
 
 public:
+	// The capacity is reserved up front, after that the slotmap grows a page at a time
 	ResourceSlotmap(size_t capacity = DEFAULT_SLOTMAP_CAPACITY)
 	{
-		m_slots.resize(capacity);
-
-		for (size_t i = 0; i < capacity - 1; ++i)
-		{
-			m_slots[i].next_free = i + 1;
-			m_slots[i].version = 0;
-		}
+		Reserve(capacity);
 	}
 
 	~ResourceSlotmap()
 	{
+		if constexpr (!std::is_trivially_destructible_v<TResource>)
+		{
+			for (uint32_t slot_index : m_dense_slots)
+			{
+				GetResource(slot_index)->~TResource();
+			}
+		}
 	}
 
 	ResourceSlotmap(const ResourceSlotmap& other) = delete;
@@ -32,92 +49,282 @@ public:
 
 	ResourceHandle_t Insert(TResource&& resource)
 	{
-		ResourceHandle_t handle = AllocateSlot();
-		m_slots[handle.index].resource = std::move(resource);
-
-		return handle;
+		return Emplace(std::move(resource));
 	}
 
 	template<typename... TArgs>
 	ResourceHandle_t Emplace(TArgs&&... args)
 	{
-		ResourceHandle_t handle = AllocateSlot();
-		new (&m_slots[handle.index].resource) TResource(std::forward<TArgs>(args)...);
+		if (m_free_slots.empty())
+		{
+			AddPage();
+		}
+
+		// The slot is only taken once the resource is constructed, so a throwing constructor does not leak it
+		uint32_t slot_index = m_free_slots.back();
+		new (GetResource(slot_index)) TResource(std::forward<TArgs>(args)...);
+		m_free_slots.pop_back();
+
+		m_slot_to_dense[slot_index] = (uint32_t)m_dense_slots.size();
+		m_dense_slots.push_back(slot_index);
+
+		ResourceHandle_t handle;
+		handle.index = slot_index;
+		handle.version = m_versions[slot_index];
 
 		return handle;
 	}
 
 	TResource* Find(ResourceHandle_t handle)
 	{
-		TResource* resource = nullptr;
+		if (IsLive(handle))
+		{
+			return GetResource(handle.index);
+		}
+
+		return nullptr;
+	}
+
+	const TResource* Find(ResourceHandle_t handle) const
+	{
+		return const_cast<ResourceSlotmap*>(this)->Find(handle);
+	}
+
+	void Delete(ResourceHandle_t handle)
+	{
+		if (!IsLive(handle))
+			return;
+
+		uint32_t slot_index = handle.index;
+
+		// A version of ~0u would make handles to this slot invalid
+		m_versions[slot_index]++;
+		if (m_versions[slot_index] == ~0u)
+			m_versions[slot_index] = 0;
 
-		if (VK_RESOURCE_HANDLE_VALID(handle))
+		if constexpr (!std::is_trivially_destructible_v<TResource>)
 		{
-			Slot& slot = m_slots[handle.index];
+			GetResource(slot_index)->~TResource();
+		}
 
-			if (slot.version == handle.version)
-			{
-				resource = &slot.resource;
-			}
+		// Swap the last live slot into the dense position of the deleted one
+		uint32_t dense_index = m_slot_to_dense[slot_index];
+		uint32_t last_slot_index = m_dense_slots.back();
+		m_dense_slots[dense_index] = last_slot_index;
+		m_slot_to_dense[last_slot_index] = dense_index;
+		m_dense_slots.pop_back();
+
+		m_slot_to_dense[slot_index] = INVALID_INDEX;
+		m_free_slots.push_back(slot_index);
+	}
+
+	// Calls func(ResourceHandle_t, TResource&) for every live resource, the order changes when resources are deleted
+	// Resources can not be inserted or deleted from inside func
+	template<typename TFunc>
+	void ForEach(TFunc&& func)
+	{
+		for (uint32_t slot_index : m_dense_slots)
+		{
+			ResourceHandle_t handle;
+			handle.index = slot_index;
+			handle.version = m_versions[slot_index];
+
+			func(handle, *GetResource(slot_index));
 		}
+	}
 
-		return resource;
+	void Reserve(size_t capacity)
+	{
+		while (GetCapacity() < capacity)
+		{
+			AddPage();
+		}
 	}
 
-	void Delete(ResourceHandle_t handle)
+	size_t GetSize() const { return m_dense_slots.size(); }
+	size_t GetCapacity() const { return m_pages.size() * PAGE_SIZE; }
+
+private:
+	struct Page
 	{
-		if (VK_RESOURCE_HANDLE_VALID(handle))
+		alignas(TResource) std::byte resources[PAGE_SIZE * sizeof(TResource)];
+	};
+
+private:
+	bool IsLive(ResourceHandle_t handle) const
+	{
+		return VK_RESOURCE_HANDLE_VALID(handle) &&
+			handle.index < m_versions.size() &&
+			m_versions[handle.index] == handle.version &&
+			m_slot_to_dense[handle.index] != INVALID_INDEX;
+	}
+
+	TResource* GetResource(uint32_t slot_index)
+	{
+		Page& page = *m_pages[slot_index / PAGE_SIZE];
+		return std::launder(reinterpret_cast<TResource*>(&page.resources[(slot_index % PAGE_SIZE) * sizeof(TResource)]));
+	}
+
+	void AddPage()
+	{
+		size_t first_slot_index = GetCapacity();
+		if (first_slot_index + PAGE_SIZE > MAX_SLOTMAP_CAPACITY)
 		{
-			Slot& slot = m_slots[handle.index];
+			VK_EXCEPT("ResourceSlotmap", "Slotmap ran out of space, it can not grow beyond {} slots", MAX_SLOTMAP_CAPACITY);
+		}
 
-			if (slot.version == handle.version)
-			{
-				slot.version++;
-
-				slot.next_free = m_next_free;
-				m_next_free = handle.index;
-				
-				if constexpr (!std::is_trivially_destructible_v<TResource>)
-				{
-					slot.resource.~TResource();
-				}
-			}
+		// Not value-initialized, resources are only constructed when they are inserted
+		m_pages.emplace_back(new Page);
+		m_versions.resize(first_slot_index + PAGE_SIZE, 0);
+		m_slot_to_dense.resize(first_slot_index + PAGE_SIZE, INVALID_INDEX);
+
+		// Pushed in reverse, so the new slots are handed out in order
+		for (uint32_t i = 0; i < PAGE_SIZE; ++i)
+		{
+			m_free_slots.push_back((uint32_t)(first_slot_index + PAGE_SIZE - 1 - i));
 		}
 	}
 
 private:
-	ResourceHandle_t AllocateSlot()
+	std::vector<std::unique_ptr<Page>> m_pages;
+
+	// Indexed by slot
+	std::vector<uint32_t> m_versions;
+	std::vector<uint32_t> m_slot_to_dense;
+
+	std::vector<uint32_t> m_dense_slots;
+	std::vector<uint32_t> m_free_slots;
+
+};
+
+/*
+
+	Sharded ResourceSlotmap for creating resources from multiple threads, every shard is a ResourceSlotmap behind its own lock
+	Threads create their resources in the shard picked by their thread id, so loader threads rarely contend for the same lock
+	The shard is stored in the low bits of the handle index, so handles stay the same size as the ones from the ResourceSlotmap
+
+*/
+
+template<typename TResource, uint32_t NUM_SHARDS = 8, uint32_t PAGE_SIZE = 256>
+class ShardedResourceSlotmap
+{
+public:
+	static_assert(std::has_single_bit(NUM_SHARDS), "ShardedResourceSlotmap shard count needs to be a power of two");
+
+private:
+	static constexpr uint32_t SHARD_BITS = std::countr_zero(NUM_SHARDS);
+	static constexpr uint32_t MAX_SHARD_INDEX = (~0u >> SHARD_BITS) - 1;
+
+public:
+	ShardedResourceSlotmap() = default;
+
+	ShardedResourceSlotmap(const ShardedResourceSlotmap& other) = delete;
+	ShardedResourceSlotmap(ShardedResourceSlotmap&& other) = delete;
+	const ShardedResourceSlotmap& operator=(const ShardedResourceSlotmap& other) = delete;
+	ShardedResourceSlotmap&& operator=(ShardedResourceSlotmap&& other) = delete;
+
+	ResourceHandle_t Insert(TResource&& resource)
+	{
+		return Emplace(std::move(resource));
+	}
+
+	template<typename... TArgs>
+	ResourceHandle_t Emplace(TArgs&&... args)
 	{
-		if (m_next_free == INVALID_SLOT_INDEX)
+		uint32_t shard_index = GetThreadShardIndex();
+		Shard& shard = m_shards[shard_index];
+
+		std::unique_lock lock(shard.mutex);
+		ResourceHandle_t handle = shard.slotmap.Emplace(std::forward<TArgs>(args)...);
+
+		if (handle.index > MAX_SHARD_INDEX)
 		{
-			// If this happens, we need to abort, or we resize the slotmap
-			VK_EXCEPT("ResourceSlotmap", "Slotmap ran out of space");
+			shard.slotmap.Delete(handle);
+			VK_EXCEPT("ShardedResourceSlotmap", "Slotmap shard {} ran out of space", shard_index);
 		}
-		// Should really not happen, this is a programmatic error
-		VK_ASSERT(m_next_free < (uint32_t)m_slots.size());
 
-		ResourceHandle_t handle;
-		Slot& slot = m_slots[m_next_free];
+		return ToShardedHandle(handle, shard_index);
+	}
 
-		handle.index = m_next_free;
-		handle.version = slot.version;
+	// The returned pointer stays valid until the resource is deleted, but accessing the resource itself is not synchronized
+	TResource* Find(ResourceHandle_t handle)
+	{
+		if (!VK_RESOURCE_HANDLE_VALID(handle))
+			return nullptr;
 
-		m_next_free = slot.next_free;
-		slot.next_free = INVALID_SLOT_INDEX;
+		Shard& shard = m_shards[handle.index & (NUM_SHARDS - 1)];
 
-		return handle;
+		std::shared_lock lock(shard.mutex);
+		return shard.slotmap.Find(ToShardHandle(handle));
 	}
 
-private:
-	struct Slot
+	void Delete(ResourceHandle_t handle)
 	{
-		uint32_t next_free = INVALID_SLOT_INDEX;
-		uint32_t version = 0;
+		if (!VK_RESOURCE_HANDLE_VALID(handle))
+			return;
 
-		TResource resource;
+		Shard& shard = m_shards[handle.index & (NUM_SHARDS - 1)];
+
+		std::unique_lock lock(shard.mutex);
+		shard.slotmap.Delete(ToShardHandle(handle));
+	}
+
+	// Calls func(ResourceHandle_t, TResource&) for every live resource, one shard at a time
+	// The shard is locked while func is called, so func can not call back into the slotmap
+	template<typename TFunc>
+	void ForEach(TFunc&& func)
+	{
+		for (uint32_t shard_index = 0; shard_index < NUM_SHARDS; ++shard_index)
+		{
+			Shard& shard = m_shards[shard_index];
+
+			std::shared_lock lock(shard.mutex);
+			shard.slotmap.ForEach([&func, shard_index](ResourceHandle_t handle, TResource& resource)
+			{
+				func(ToShardedHandle(handle, shard_index), resource);
+			});
+		}
+	}
+
+	size_t GetSize() const
+	{
+		size_t size = 0;
+		for (const Shard& shard : m_shards)
+		{
+			std::shared_lock lock(shard.mutex);
+			size += shard.slotmap.GetSize();
+		}
+
+		return size;
+	}
+
+private:
+	struct Shard
+	{
+		mutable std::shared_mutex mutex;
+		ResourceSlotmap<TResource, PAGE_SIZE> slotmap{ 0 };
 	};
 
-	std::vector<Slot> m_slots;
-	uint32_t m_next_free = 0;
+private:
+	static uint32_t GetThreadShardIndex()
+	{
+		static thread_local uint32_t thread_shard_index = (uint32_t)(std::hash<std::thread::id>()(std::this_thread::get_id()) & (NUM_SHARDS - 1));
+		return thread_shard_index;
+	}
+
+	static ResourceHandle_t ToShardedHandle(ResourceHandle_t handle, uint32_t shard_index)
+	{
+		handle.index = (handle.index << SHARD_BITS) | shard_index;
+		return handle;
+	}
+
+	static ResourceHandle_t ToShardHandle(ResourceHandle_t handle)
+	{
+		handle.index >>= SHARD_BITS;
+		return handle;
+	}
+
+private:
+	std::array<Shard, NUM_SHARDS> m_shards;
 
 };
@@ -1,6 +1,12 @@
 #pragma once
 #include "Camera.h"
 #include "Entity.h"
+#include "ComponentPool.h"
+#include "TransformHierarchy.h"
+#include "AABBTree.h"
+#include "ResourceSlotmap.h"
+
+#include <filesystem>
 
 class Scene
 {
@@ -11,17 +17,94 @@ public:
 	void Render();
 	void RenderUI();
 
-	template<typename T, typename... TArgs>
-	void AddEntity(TArgs&&... args)
-	{
-		m_entities.emplace_back(std::make_unique<T>(std::forward<TArgs>(args)...));
-	}
+	// Transforms are local to the parent entity, or world transforms for entities without a parent
+	EntityHandle CreateEntity(const std::string& name, const glm::mat4& transform, EntityHandle parent = EntityHandle());
+	// The scene takes ownership of the material
+	EntityHandle CreateMeshEntity(const std::string& name, RenderResourceHandle mesh_handle, RenderResourceHandle material_handle,
+		const glm::mat4& transform, EntityHandle parent = EntityHandle());
+	// Every node of the model becomes an entity with the node transform as its local transform, the meshes of a node are its children
+	// Returns an invalid handle if the model asset is not imported
+	EntityHandle CreateModelEntity(AssetHandle model_handle, const glm::mat4& transform, EntityHandle parent = EntityHandle());
+	// The texture is optional, area lights without a valid texture asset are rendered with their color only
+	EntityHandle CreateAreaLightEntity(const std::string& name, AssetHandle texture_handle, const glm::mat4& transform,
+		const glm::vec3& color, float intensity, bool two_sided, EntityHandle parent = EntityHandle());
+	// Destroys the entity together with all of its children
+	void DestroyEntity(EntityHandle entity);
+	void Clear();
+
+	// Scene files store the entities with their names, local transforms, parents, meshes with their material parameters and area lights
+	// Meshes and textures are referenced through their asset handles, so the assets need to be imported before the scene is loaded
+	// Saving skips the write if the file would not change since it was last saved or loaded
+	bool SaveToFile(const std::filesystem::path& filepath);
+	// Replaces all entities in the scene, the scene is left unchanged if the file could not be read or is invalid
+	bool LoadFromFile(const std::filesystem::path& filepath);
+	// Writes the same data as SaveToFile as readable JSON, so that scenes can be compared with a text diff
+	bool ExportToJson(const std::filesystem::path& filepath) const;
+
+	std::vector<uint8_t> Serialize() const;
+	bool Deserialize(std::span<const uint8_t> bytes);
+
+	size_t GetNumEntities() const;
+	size_t GetNumMeshes() const;
+	size_t GetNumAreaLights() const;
+
+	// The entities whose world transform changed during the last Render
+	std::span<const EntityHandle> GetChangedTransforms() const;
+	// World space bounds of all mesh and area light entities, up to date after Render
+	const AABBTree& GetBoundingVolumeHierarchy() const;
+
+	// Returns the mesh or area light entity that the ray hits first, or an invalid handle if it does not hit any, uses the bounds from the last Render
+	// Bounds that contain the ray origin, like the walls of a room that the camera is in, are only picked if the ray does not hit anything else
+	EntityHandle PickEntity(const glm::vec3& origin, const glm::vec3& direction) const;
+	// The selected entity is highlighted in the scene hierarchy, which is opened up to it
+	void SelectEntity(EntityHandle entity);
 
 	Camera& GetActiveCamera();
 	const Camera& GetActiveCamera() const;
 
 private:
+	void CreateModelNodeEntity(const ModelAsset& model_asset, AssetHandle model_handle, uint32_t node_index, EntityHandle parent);
+	void SetLocalTransform(EntityHandle entity, const glm::mat4& transform);
+	void UpdateLocalTransform(EntityHandle entity);
+	// Returns false for entities without a mesh or area light
+	bool GetWorldBounds(EntityHandle entity, AABB& world_bounds) const;
+	void UpdateBounds();
+
+	void RenderMeshes();
+	void RenderAreaLights();
+
+	void RenderEntityUI(EntityHandle entity);
+
+private:
+	struct EntityInfo
+	{
+		std::string name;
+	};
+
 	Camera m_active_camera;
-	std::vector<std::unique_ptr<Entity>> m_entities;
+	ResourceSlotmap<EntityInfo> m_entities;
+
+	// Every entity has a transform, the component holds the editable local transform, the matrices live in the hierarchy
+	ComponentPool<TransformComponent> m_transforms;
+	TransformHierarchy m_transform_hierarchy;
+	ComponentPool<MeshComponent> m_meshes;
+	ComponentPool<AreaLightComponent> m_area_lights;
+	AABBTree m_bounding_volume_hierarchy;
+
+	EntityHandle m_selected_entity;
+	bool m_reveal_selected_entity = false;
+
+	// Filled every frame and submitted to the renderer in one go, kept around so that they do not allocate every frame
+	struct MeshSubmission
+	{
+		std::vector<RenderResourceHandle> mesh_handles;
+		std::vector<RenderResourceHandle> material_handles;
+		std::vector<glm::mat4> transforms;
+	} m_mesh_submission;
+	std::vector<EntityHandle> m_destroyed_entities;
+
+	// Hash of the scene file contents at the last save or load, used to skip saves that would not change the file
+	std::filesystem::path m_saved_filepath;
+	uint64_t m_saved_hash = 0;
 
 };
@@ -0,0 +1,96 @@
+#pragma once
+#include "Entity.h"
+
+/*
+
+	The TransformHierarchy stores the parent/child relations of entities together with their local and world transforms
+	Nodes are kept in depth-first order, so a parent always comes before its children and the subtree of a node is a contiguous range,
+	which lets Update recompute dirty subtrees with a single linear pass in which every parent world transform is already up to date
+	Changing a local transform only marks the node dirty, the world transforms are recomputed in Update, once per frame
+
+*/
+
+class TransformHierarchy
+{
+public:
+	// Entities without a valid parent are inserted as root nodes, children are inserted after the last descendant of their parent
+	void Insert(EntityHandle entity, EntityHandle parent, const glm::mat4& local_transform);
+	// Removes the entity together with all of its descendants, which are appended to removed_entities, parents first
+	void Remove(EntityHandle entity, std::vector<EntityHandle>& removed_entities);
+
+	void SetLocalTransform(EntityHandle entity, const glm::mat4& local_transform);
+	const glm::mat4* GetLocalTransform(EntityHandle entity) const;
+	// Only up to date after Update, for entities whose transform did not change since
+	const glm::mat4* GetWorldTransform(EntityHandle entity) const;
+	EntityHandle GetParent(EntityHandle entity) const;
+
+	// Recomputes the world transforms of all dirty subtrees
+	void Update();
+	// The entities whose world transform was recomputed by the last Update, so that systems can upload or refit only what changed
+	// Can contain entities that were destroyed since
+	std::span<const EntityHandle> GetChangedEntities() const { return m_changed_entities; }
+
+	// Calls func(EntityHandle) for every root entity, in hierarchy order
+	template<typename TFunc>
+	void ForEachRoot(TFunc&& func) const
+	{
+		for (uint32_t node = 0; node < m_entities.size(); node += m_subtree_sizes[node])
+		{
+			func(m_entities[node]);
+		}
+	}
+
+	// Calls func(EntityHandle) for every direct child of the entity, in hierarchy order
+	// The hierarchy can not be changed from inside func
+	template<typename TFunc>
+	void ForEachChild(EntityHandle entity, TFunc&& func) const
+	{
+		uint32_t node = FindNode(entity);
+		if (node == INVALID_NODE)
+			return;
+
+		uint32_t subtree_end = node + m_subtree_sizes[node];
+		for (uint32_t child = node + 1; child < subtree_end; child += m_subtree_sizes[child])
+		{
+			func(m_entities[child]);
+		}
+	}
+
+	// Calls func(EntityHandle entity, EntityHandle parent) for every entity in depth-first order, so parents are visited before their children
+	// The parent is an invalid handle for root entities
+	template<typename TFunc>
+	void ForEach(TFunc&& func) const
+	{
+		for (uint32_t node = 0; node < m_entities.size(); ++node)
+		{
+			func(m_entities[node], m_parents[node] == INVALID_NODE ? EntityHandle() : m_entities[m_parents[node]]);
+		}
+	}
+
+	size_t GetSize() const { return m_entities.size(); }
+
+private:
+	static constexpr uint32_t INVALID_NODE = ~0u;
+
+private:
+	uint32_t FindNode(EntityHandle entity) const;
+	void UpdateEntityToNode(uint32_t first_node);
+
+private:
+	// Indexed by node, in depth-first order
+	std::vector<EntityHandle> m_entities;
+	std::vector<uint32_t> m_parents;
+	// Number of nodes in the subtree of a node, including the node itself
+	std::vector<uint32_t> m_subtree_sizes;
+	std::vector<glm::mat4> m_local_transforms;
+	std::vector<glm::mat4> m_world_transforms;
+	// Set on the node whose local transform changed, Update recomputes the whole subtree below it
+	std::vector<uint8_t> m_dirty;
+	bool m_has_dirty_nodes = false;
+
+	// Indexed by entity index
+	std::vector<uint32_t> m_entity_to_node;
+
+	std::vector<EntityHandle> m_changed_entities;
+
+};
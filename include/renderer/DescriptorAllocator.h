@@ -0,0 +1,121 @@
+#pragma once
+
+/*
+
+	The DescriptorAllocator hands out ranges of descriptor offsets within a single descriptor buffer, it does not touch any GPU memory itself
+	Single descriptors are handed out from chunks taken from the range allocator, a chunk goes back to the range allocator once all of its descriptors are free
+	Ranges are allocated from free blocks kept in two-level segregated fit bins, power-of-two size classes split into linear sub-bins,
+	and merged with their neighbours when freed, both in O(1)
+	Freed descriptors might still be used by frames in flight, so they are only reused after ReleaseFrees is called for the frame they were freed in
+
+*/
+
+class DescriptorAllocator
+{
+public:
+	static constexpr uint32_t INVALID_OFFSET = ~0u;
+	// Single descriptors are taken from the range allocator in chunks, the last chunk with free descriptors is kept even when it is completely free,
+	// so that allocating and freeing a single descriptor does not take and return a chunk every time
+	static constexpr uint32_t SINGLE_DESCRIPTOR_CHUNK_SIZE = 64;
+
+public:
+	DescriptorAllocator() = default;
+	explicit DescriptorAllocator(uint32_t num_descriptors);
+
+	// Returns INVALID_OFFSET if there is no free range large enough
+	uint32_t Allocate(uint32_t num_descriptors);
+	// The descriptors are reused once ReleaseFrees has been called with a finished frame index of at least frame_index
+	void Free(uint32_t offset, uint32_t num_descriptors, uint64_t frame_index);
+	void ReleaseFrees(uint64_t finished_frame_index);
+	// Appends descriptors to the end of the range, existing allocations keep their offsets
+	void Grow(uint32_t num_descriptors);
+
+	uint32_t GetNumDescriptors() const { return m_num_descriptors; }
+	// Does not include descriptors that are waiting to be released
+	uint32_t GetNumFreeDescriptors() const { return m_num_free_descriptors; }
+
+	// Checks that the free blocks and bins are consistent, walks every descriptor, so this is slow
+	bool Validate() const;
+
+private:
+	// Sizes below NUM_SECOND_LEVEL_BINS get an exact bin each, every power-of-two size class above that is split into NUM_SECOND_LEVEL_BINS bins
+	static constexpr uint32_t NUM_SECOND_LEVEL_BITS = 3;
+	static constexpr uint32_t NUM_SECOND_LEVEL_BINS = 1u << NUM_SECOND_LEVEL_BITS;
+	static constexpr uint32_t NUM_FIRST_LEVEL_BINS = 32 - NUM_SECOND_LEVEL_BITS + 1;
+	static constexpr uint32_t NUM_BINS = NUM_FIRST_LEVEL_BINS * NUM_SECOND_LEVEL_BINS;
+
+	enum SingleState : uint8_t
+	{
+		SINGLE_STATE_NONE,
+		SINGLE_STATE_FREE,
+		SINGLE_STATE_ALLOCATED
+	};
+
+	struct SingleChunk
+	{
+		uint32_t offset = 0;
+		uint32_t num_descriptors = 0;
+		uint32_t num_free = 0;
+		uint32_t first_free_single = INVALID_OFFSET;
+
+		// Doubly linked list of the chunks that have free descriptors, indexed by chunk index
+		uint32_t prev_chunk = INVALID_OFFSET;
+		uint32_t next_chunk = INVALID_OFFSET;
+	};
+
+	struct PendingFree
+	{
+		uint32_t offset = 0;
+		uint32_t num_descriptors = 0;
+		uint64_t frame_index = 0;
+	};
+
+private:
+	static uint32_t GetBinIndex(uint32_t num_descriptors);
+	uint32_t FindFreeBlock(uint32_t num_descriptors) const;
+
+	uint32_t AllocateRange(uint32_t num_descriptors);
+	void FreeRange(uint32_t offset, uint32_t num_descriptors);
+
+	uint32_t AllocateSingle();
+	void FreeSingle(uint32_t offset);
+	void AddSingleChunk(uint32_t offset, uint32_t num_descriptors);
+	void ReleaseSingleChunk(uint32_t chunk_index);
+	void LinkSingleChunk(uint32_t chunk_index);
+	void UnlinkSingleChunk(uint32_t chunk_index);
+
+	void SetBlock(uint32_t offset, uint32_t num_descriptors, bool is_free);
+	void AddFreeBlock(uint32_t offset, uint32_t num_descriptors);
+	void RemoveFreeBlock(uint32_t offset);
+
+private:
+	uint32_t m_num_descriptors = 0;
+	uint32_t m_num_free_descriptors = 0;
+
+	// Indexed by descriptor offset, the block size and free flag are only valid at the first descriptor of a block,
+	// the block begin is only valid at the last descriptor of a block, which is used to find the left neighbour when merging
+	std::vector<uint32_t> m_block_size;
+	std::vector<uint32_t> m_block_begin;
+	std::vector<uint8_t> m_block_is_free;
+
+	// Doubly linked free lists per bin, indexed by the first descriptor of a free block
+	std::vector<uint32_t> m_next_free_block;
+	std::vector<uint32_t> m_prev_free_block;
+	std::array<uint32_t, NUM_BINS> m_bin_heads = {};
+	uint32_t m_first_level_mask = 0;
+	std::array<uint32_t, NUM_FIRST_LEVEL_BINS> m_second_level_masks = {};
+
+	std::vector<SingleChunk> m_single_chunks;
+	std::vector<uint32_t> m_free_single_chunk_indices;
+	uint32_t m_single_chunks_with_free_head = INVALID_OFFSET;
+	// The completely free chunk that is kept around, released when a range allocation does not fit otherwise
+	uint32_t m_empty_single_chunk = INVALID_OFFSET;
+
+	// Indexed by descriptor offset, the next free descriptor is only valid for free descriptors in a chunk
+	std::vector<uint32_t> m_single_chunk_index;
+	std::vector<uint32_t> m_next_free_single;
+	std::vector<SingleState> m_single_state;
+
+	std::queue<PendingFree> m_pending_frees;
+
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include "renderer/vulkan/VulkanTypes.h"
+
+/*
+
+	The GPUProfiler writes a begin and end timestamp for every scope recorded during a frame, scopes can be nested
+	Render graph passes and render pass stages are profiled automatically, stages also collect pipeline statistics
+	Results are read back once the frame index comes around again, which is GetNumFramesInFlight frames later,
+	at which point the frame has already finished on the GPU, so reading back the results never stalls
+
+*/
+
+namespace GPUProfiler
+{
+
+	void Init();
+	void Exit();
+
+	// Reads back the results of the frame that last used this frame index and resets its queries,
+	// the GPU needs to have finished that frame, scopes are only recorded between BeginFrame and EndFrame
+	void BeginFrame(uint32_t frame_index);
+	void EndFrame();
+
+	// Pipeline statistics are not collected on the async compute queue, since most of them are graphics only
+	void BeginScope(VulkanCommandBuffer& command_buffer, const std::string& name, bool collect_statistics = false);
+	void EndScope(VulkanCommandBuffer& command_buffer);
+
+	void RenderUI();
+
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include "renderer/vulkan/VulkanTypes.h"
+#include "renderer/vulkan/VulkanBackend.h"
+#include "renderer/RenderTypes.h"
+
+#include <functional>
+
+/*
+
+	The RenderGraph is rebuilt every frame from passes that declare which resources they read and write
+	Compiling the graph culls passes whose outputs are never read, and assigns transient images with
+	non-overlapping lifetimes to the same alias group, so that they can share the same memory
+	Executing the graph records all barriers a pass needs in a single pipeline barrier before the pass runs
+	If there are other passes between the producer and the consumer of a resource, a split barrier is used instead,
+	which is signaled right after the producer and waited on right before the consumer
+
+*/
+
+class RenderGraph
+{
+public:
+	using ResourceID = uint32_t;
+	static constexpr ResourceID INVALID_RESOURCE_ID = UINT32_MAX;
+
+	enum ResourceAccess
+	{
+		RESOURCE_ACCESS_READ = (1 << 0),
+		RESOURCE_ACCESS_WRITE = (1 << 1),
+		RESOURCE_ACCESS_READ_WRITE = RESOURCE_ACCESS_READ | RESOURCE_ACCESS_WRITE
+	};
+
+	struct ImageUsage
+	{
+		ResourceID resource = INVALID_RESOURCE_ID;
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		Flags access = RESOURCE_ACCESS_READ;
+	};
+
+	struct BufferUsage
+	{
+		ResourceID resource = INVALID_RESOURCE_ID;
+		VkAccessFlags2 access_flags = VK_ACCESS_2_NONE;
+		VkPipelineStageFlags2 stage_flags = VK_PIPELINE_STAGE_2_NONE;
+	};
+
+	struct PassInfo
+	{
+		std::string name;
+		std::vector<ImageUsage> images;
+		std::vector<BufferUsage> buffers;
+
+		// Passes with side effects outside of the graph are never culled
+		bool has_side_effects = false;
+		// Compute only passes can be recorded into a separate command buffer for the async compute queue
+		// These should not use transient images, since aliasing barriers only synchronize within a single queue
+		bool async_compute = false;
+		std::function<void(VulkanCommandBuffer&)> execute;
+	};
+
+public:
+	RenderGraph() = default;
+
+	// Destroys the events used for split barriers, the device needs to be idle
+	void Destroy();
+	void Reset();
+
+	// Resources are imported by pointer and only resolved when executing, so they can be recreated after compiling the graph
+	ResourceID ImportImage(const std::string& name, const VulkanImage* image, bool transient);
+	ResourceID ImportBuffer(const std::string& name, const VulkanBuffer* buffer);
+	void MarkOutput(ResourceID resource);
+
+	void AddPass(PassInfo&& pass_info);
+
+	// Returns true if the alias groups changed since the previous compile, in which case the transient images need to be recreated
+	bool Compile();
+	// Passes marked as async compute are recorded into the async command buffer if one is provided, otherwise they run inline
+	void Execute(VulkanCommandBuffer& command_buffer, VulkanCommandBuffer* async_command_buffer = nullptr);
+	// Stages of the graphics command buffer that consume resources written on the async compute queue in the last execute,
+	// the graphics submission needs to wait on the async compute submission at these stages
+	VkPipelineStageFlags2 GetAsyncComputeWaitStages() const;
+
+	const std::vector<std::vector<std::string>>& GetAliasGroups() const;
+	std::string Dump() const;
+
+private:
+	struct Resource
+	{
+		std::string name;
+		const VulkanImage* image = nullptr;
+		const VulkanBuffer* buffer = nullptr;
+
+		bool transient = false;
+		bool output = false;
+
+		// Lifetime in pass indices, only valid if the resource is used by a pass that was not culled
+		uint32_t first_pass = UINT32_MAX;
+		uint32_t last_pass = 0;
+	};
+
+	struct Pass
+	{
+		PassInfo info;
+
+		bool culled = false;
+		uint32_t num_barriers = 0;
+		uint32_t num_split_barriers = 0;
+		bool executed_async = false;
+	};
+
+private:
+	ResourceID AddResource(Resource&& resource);
+	bool IsResourceUsed(ResourceID resource) const;
+	bool DoLifetimesOverlap(ResourceID first, ResourceID second) const;
+
+private:
+	std::vector<Resource> m_resources;
+	std::vector<Pass> m_passes;
+
+	// Alias groups are kept between frames, so that the transient images only need to be recreated when they change
+	std::vector<std::vector<std::string>> m_alias_groups;
+
+	// Events for split barriers, per frame in flight, since they can only be reused once the frame that used them has finished
+	std::array<std::vector<VkEvent>, Vulkan::MAX_FRAMES_IN_FLIGHT> m_events;
+	VkPipelineStageFlags2 m_async_compute_wait_stages = VK_PIPELINE_STAGE_2_NONE;
+
+};
@@ -37,6 +37,8 @@ public:
 
 	struct Stage
 	{
+		// Shown in the GPU profiler
+		std::string name;
 		VulkanPipeline pipeline;
 		Attachment attachments[ATTACHMENT_SLOT_NUM_SLOTS];
 	};
@@ -50,7 +52,10 @@ public:
 	void EndStage(const VulkanCommandBuffer& command_buffer, uint32_t stage_index);
 
 	void SetStageAttachment(uint32_t stage_index, AttachmentSlot slot, const VulkanImageView& attachment_view);
+	// Replaces the pipeline of every stage that uses the old pipeline, the caller is responsible for destroying the old pipeline
+	void ReplacePipeline(const VulkanPipeline& old_pipeline, const VulkanPipeline& new_pipeline);
 	uint32_t GetStageCount();
+	const std::string& GetStageName(uint32_t stage_index) const;
 
 private:
 	std::vector<Stage> m_stages;
@@ -28,6 +28,7 @@ enum TextureFormat
 	TEXTURE_FORMAT_RGBA16_SFLOAT,
 	TEXTURE_FORMAT_RGBA32_SFLOAT,
 	TEXTURE_FORMAT_RG16_SFLOAT,
+	TEXTURE_FORMAT_RG32_UINT,
 	TEXTURE_FORMAT_D32_SFLOAT,
 	TEXTURE_FORMAT_NUM_FORMATS
 };
@@ -60,6 +61,9 @@ struct TextureCreateInfo
 	uint32_t num_mips = 1;
 	uint32_t num_layers = 1;
 
+	// Only set this for textures that the async compute queue uses, concurrent sharing can disable framebuffer and depth compression
+	bool async_compute_shared = false;
+
 	std::string name = "Unnamed Texture";
 };
 
@@ -114,7 +118,9 @@ enum GPUMemoryFlags
 {
 	GPU_MEMORY_DEVICE_LOCAL = 0,
 	GPU_MEMORY_HOST_VISIBLE = (1 << 0),
-	GPU_MEMORY_HOST_COHERENT = (1 << 1)
+	GPU_MEMORY_HOST_COHERENT = (1 << 1),
+	// Host cached memory is much faster to read back from on the CPU
+	GPU_MEMORY_HOST_CACHED = (1 << 2)
 };
 
 enum BufferUsageFlags
@@ -141,6 +147,9 @@ struct BufferCreateInfo
 	Flags memory_flags = GPU_MEMORY_DEVICE_LOCAL;
 	uint64_t size_in_bytes = 0;
 
+	// Only set this for buffers that the async compute queue uses, they are shared between the graphics and compute queue families
+	bool async_compute_shared = false;
+
 	std::string name = "Unnamed Buffer";
 };
 
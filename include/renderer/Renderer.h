@@ -1,5 +1,6 @@
 #pragma once
 #include "renderer/RenderTypes.h"
+#include "Geometry.h"
 
 struct GLFWwindow;
 struct MaterialAsset;
@@ -20,11 +21,31 @@ namespace Renderer
 		RenderResourceHandle skybox_texture_handle;
 	};
 
+	// Waits until the frame slot is no longer in use by the GPU, and for the frame limiter if it is enabled
+	// Sample input after this, so that the camera written in BeginFrame is as recent as possible, BeginFrame calls this if it was not called yet
+	void WaitForFrame();
 	void BeginFrame(const BeginFrameInfo& frame_info);
 	void RenderFrame();
 	void RenderUI();
 	void EndFrame();
 
+	uint32_t GetNumFramesInFlight();
+	// Applied in the next WaitForFrame, clamped to [1, Vulkan::MAX_FRAMES_IN_FLIGHT]
+	void SetNumFramesInFlight(uint32_t num_frames_in_flight);
+	// Time from sampling input to the GPU finishing the frame, of the frame that previously used the current frame index
+	double GetFrameLatencyMs();
+
+	// GPU timings of the frame that previously used the current frame index, so these lag GetNumFramesInFlight frames behind
+	struct GPUFrameTimings
+	{
+		double graphics_ms = 0.0;
+		double async_compute_ms = 0.0;
+	};
+
+	GPUFrameTimings GetGPUFrameTimings();
+	// Hashes the contents of the SDR render target after the last submitted frame, waits for the GPU to be idle
+	uint64_t ReadbackOutputChecksum();
+
 	struct CreateTextureArgs
 	{
 		TextureFormat format = TEXTURE_FORMAT_UNDEFINED;
@@ -59,8 +80,25 @@ namespace Renderer
 
 	RenderResourceHandle CreateMesh(const CreateMeshArgs& args);
 	void DestroyMesh(RenderResourceHandle handle);
-	void SubmitMesh(RenderResourceHandle mesh_handle, const MaterialAsset& material, const glm::mat4& transform);
+	// Bounds of the mesh in object space, invalid handles return the bounds of the unit cube
+	AABB GetMeshBounds(RenderResourceHandle handle);
+
+	// The texture descriptors are looked up when the material is created or edited, so the textures need to outlive the material
+	RenderResourceHandle CreateMaterial(const MaterialAsset& material_asset);
+	void DestroyMaterial(RenderResourceHandle handle);
+	// Copies the current, possibly edited, parameters and textures of the material into material_asset, returns false if the material does not exist
+	bool GetMaterialParameters(RenderResourceHandle handle, MaterialAsset& material_asset);
+	void ImGuiMaterialEditor(RenderResourceHandle material_handle);
+
+	// The instance handle identifies the instance across frames, e.g. the handle of the entity that submits it, an instance that is submitted
+	// with the same handle every frame is only uploaded again when it changes, and its previous transform is used for the motion vectors
+	// Instances with an invalid instance handle are treated as new every frame
+	// Invalid mesh or material handles are replaced by the unit cube mesh or the default material
+	void SubmitMesh(ResourceHandle_t instance_handle, RenderResourceHandle mesh_handle, RenderResourceHandle material_handle, const glm::mat4& transform);
+	// All spans need to have the same size, the meshes end up in consecutive draw list entries
+	void SubmitMeshes(std::span<const ResourceHandle_t> instance_handles, std::span<const RenderResourceHandle> mesh_handles,
+		std::span<const RenderResourceHandle> material_handles, std::span<const glm::mat4> transforms);
 	
-	void SubmitAreaLight(RenderResourceHandle texture_handle, const glm::mat4& transform, const glm::vec3& color, float intensity, bool two_sided);
+	void SubmitAreaLight(ResourceHandle_t instance_handle, RenderResourceHandle texture_handle, const glm::mat4& transform, const glm::vec3& color, float intensity, bool two_sided);
 
 }
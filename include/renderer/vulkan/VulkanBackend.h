@@ -8,10 +8,14 @@ typedef struct GLFWwindow;
 namespace Vulkan
 {
 
-	static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+	// Per-frame resources are allocated for MAX_FRAMES_IN_FLIGHT, the number of frames in flight only changes how many of them are cycled through
+	static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+	static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
 
+	// Runs headless if no window is provided, in which case the output resolution is fixed to the given size
 	void Init(::GLFWwindow* window, uint32_t window_width, uint32_t window_height);
 	void Exit();
+	bool IsHeadless();
 
 	bool BeginFrame();
 	void CopyToBackBuffer(VulkanCommandBuffer& command_buffer, const VulkanImage& src_image);
@@ -23,6 +27,9 @@ namespace Vulkan
 	uint32_t GetCurrentBackBufferIndex();
 	uint32_t GetCurrentFrameIndex();
 	uint32_t GetLastFinishedFrameIndex();
+	// Waits for the device to be idle, the swapchain is recreated at the next BeginFrame since its number of images depends on this
+	void SetNumFramesInFlight(uint32_t num_frames_in_flight);
+	uint32_t GetNumFramesInFlight();
 
 	VulkanCommandQueue GetCommandQueue(VulkanCommandBufferType type);
 
@@ -58,6 +65,22 @@ namespace Vulkan
 
 	VulkanPipeline CreateComputePipeline(const ComputePipelineInfo& info);
 	void DestroyPipeline(const VulkanPipeline& pipeline);
+	// Compiles all shaders in the directory on worker threads, so that pipeline creation only has to look up the SPIR-V
+	// Compiled SPIR-V is cached on disk, keyed by the hash of the preprocessed source and compile options
+	void PrecompileShaders(const char* shader_directory);
+
+	struct ReloadedPipeline
+	{
+		VulkanPipeline old_pipeline;
+		VulkanPipeline new_pipeline;
+	};
+
+	// Watches the shader directory on a background thread and recreates pipelines when their shaders or includes change
+	void EnableShaderHotReload(const char* shader_directory);
+	void DisableShaderHotReload();
+	// Returns the pipelines that were recreated since the last call, these need to be swapped in before recording the frame
+	// The old pipelines are destroyed by the backend once they are no longer in flight
+	std::vector<ReloadedPipeline> GetReloadedPipelines();
 
 	void InitImGui(::GLFWwindow* window);
 	void ExitImGui();
@@ -10,7 +10,8 @@ namespace Vulkan
 
 		VulkanBuffer CreateVertex(uint64_t size_in_bytes, const std::string& name);
 		VulkanBuffer CreateIndex(uint64_t size_in_bytes, const std::string& name);
-		VulkanBuffer CreateAccelerationStructure(uint64_t size_in_bytes, const std::string& name);
+		// BLAS buffers are built on the async compute queue and read by the TLAS build on the graphics queue, so they need to be shared
+		VulkanBuffer CreateAccelerationStructure(uint64_t size_in_bytes, const std::string& name, bool async_compute_shared = false);
 		VulkanBuffer CreateAccelerationStructureScratch(uint64_t size_in_bytes, const std::string& name);
 		VulkanBuffer CreateAccelerationStructureInstances(uint64_t size_in_bytes, const std::string& name);
 
@@ -8,7 +8,8 @@ namespace Vulkan
 	{
 
 		void BeginRecording(const VulkanCommandBuffer& command_buffer);
-		void EndRecording(const VulkanCommandBuffer& command_buffer);
+		// Flushes any barriers that are still pending
+		void EndRecording(VulkanCommandBuffer& command_buffer);
 		void Reset(VulkanCommandBuffer& command_buffer);
 
 		void AddWait(VulkanCommandBuffer& command_buffer, const VulkanFence& fence, VkPipelineStageFlags2 stage_flags, uint64_t fence_value = 0);
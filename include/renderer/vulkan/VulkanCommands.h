@@ -7,7 +7,7 @@ namespace Vulkan
 	namespace Command
 	{
 
-		void BeginRendering(const VulkanCommandBuffer& command_buffer, uint32_t num_color_attachments, const VkRenderingAttachmentInfo* const color_attachments,
+		void BeginRendering(VulkanCommandBuffer& command_buffer, uint32_t num_color_attachments, const VkRenderingAttachmentInfo* const color_attachments,
 			const VkRenderingAttachmentInfo* const depth_attachment, const VkRenderingAttachmentInfo* const stencil_attachment, uint32_t render_width, uint32_t render_height, int32_t offset_x = 0, int32_t offset_y = 0);
 		void EndRendering(const VulkanCommandBuffer& command_buffer);
 		void BindPipeline(VulkanCommandBuffer& command_buffer, const VulkanPipeline& pipeline);
@@ -20,20 +20,42 @@ namespace Vulkan
 		void DrawGeometryIndexed(const VulkanCommandBuffer& command_buffer, const VulkanBuffer* const index_buffer,	VkIndexType index_type, uint32_t num_indices,
 			uint32_t num_instances = 1, uint32_t first_instance = 0, uint32_t first_index = 0, uint32_t vertex_offset = 0);
 
-		void ClearImage(const VulkanCommandBuffer& command_buffer, const VulkanImage& image, const VkClearColorValue& clear_value);
-		void ClearImage(const VulkanCommandBuffer& command_buffer, const VulkanImage& image, const VkClearDepthStencilValue& clear_value);
-		void Dispatch(const VulkanCommandBuffer& command_buffer, uint32_t group_x, uint32_t group_y, uint32_t group_z);
-
-		void CopyBuffers(const VulkanCommandBuffer& command_buffer, const VulkanBuffer& src_buffer, uint64_t src_offset, const VulkanBuffer& dst_buffer, uint64_t dst_offset, uint64_t num_bytes);
-		void CopyFromBuffer(const VulkanCommandBuffer& command_buffer, const VulkanBuffer& src_buffer, uint64_t src_offset, const VulkanImage& dst_image, uint32_t dst_width, uint32_t dst_height);
-		void CopyImages(const VulkanCommandBuffer& command_buffer, const VulkanImage& src_image, const VulkanImage& dst_image);
-		void GenerateMips(const VulkanCommandBuffer& command_buffer, const VulkanImage& image);
-
-		void BufferMemoryBarrier(const VulkanCommandBuffer& command_buffer, const VulkanBufferBarrier& buffer_barrier);
-		void BufferMemoryBarriers(const VulkanCommandBuffer& command_buffer, const std::vector<VulkanBufferBarrier>& buffer_barriers);
-
-		void TransitionLayout(const VulkanCommandBuffer& command_buffer, const VulkanImageBarrier& image_barrier);
-		void TransitionLayouts(const VulkanCommandBuffer& command_buffers, const std::vector<VulkanImageBarrier>& image_barriers);
+		void ClearImage(VulkanCommandBuffer& command_buffer, const VulkanImage& image, const VkClearColorValue& clear_value);
+		void ClearImage(VulkanCommandBuffer& command_buffer, const VulkanImage& image, const VkClearDepthStencilValue& clear_value);
+		void Dispatch(VulkanCommandBuffer& command_buffer, uint32_t group_x, uint32_t group_y, uint32_t group_z);
+
+		void CopyBuffers(VulkanCommandBuffer& command_buffer, const VulkanBuffer& src_buffer, uint64_t src_offset, const VulkanBuffer& dst_buffer, uint64_t dst_offset, uint64_t num_bytes);
+		// Copies all regions with a single command, the region offsets are relative to the source and destination buffers
+		void CopyBuffers(VulkanCommandBuffer& command_buffer, const VulkanBuffer& src_buffer, const VulkanBuffer& dst_buffer, uint32_t num_regions, const VkBufferCopy* regions);
+		void CopyFromBuffer(VulkanCommandBuffer& command_buffer, const VulkanBuffer& src_buffer, uint64_t src_offset, const VulkanImage& dst_image, uint32_t dst_width, uint32_t dst_height,
+			uint32_t dst_mip = 0, uint32_t dst_base_layer = 0, uint32_t dst_num_layers = 1);
+		void CopyToBuffer(VulkanCommandBuffer& command_buffer, const VulkanImage& src_image, uint32_t src_width, uint32_t src_height, const VulkanBuffer& dst_buffer, uint64_t dst_offset,
+			uint32_t src_mip = 0, uint32_t src_base_layer = 0, uint32_t src_num_layers = 1);
+		void CopyImages(VulkanCommandBuffer& command_buffer, const VulkanImage& src_image, const VulkanImage& dst_image);
+		void GenerateMips(VulkanCommandBuffer& command_buffer, const VulkanImage& image);
+
+		// Barriers are not recorded immediately, but queued on the command buffer and merged with other pending barriers
+		// Commands that depend on them flush all pending barriers in a single pipeline barrier first
+		void BufferMemoryBarrier(VulkanCommandBuffer& command_buffer, const VulkanBufferBarrier& buffer_barrier);
+		void BufferMemoryBarriers(VulkanCommandBuffer& command_buffer, const std::vector<VulkanBufferBarrier>& buffer_barriers);
+
+		void TransitionLayout(VulkanCommandBuffer& command_buffer, const VulkanImageBarrier& image_barrier);
+		void TransitionLayouts(VulkanCommandBuffer& command_buffer, const std::vector<VulkanImageBarrier>& image_barriers);
+
+		// Queues raw barriers, the caller is responsible for updating the resource tracker
+		void QueueBarriers(VulkanCommandBuffer& command_buffer, const std::vector<VkImageMemoryBarrier2>& image_barriers, const std::vector<VkBufferMemoryBarrier2>& buffer_barriers);
+		void FlushBarriers(VulkanCommandBuffer& command_buffer);
+
+		// Split barriers signal an event right after the producer, and wait on it right before the consumer, so that the work in between can overlap
+		// The barriers are restricted to the pipeline stages the queue supports when signaling, which is why the split barrier is not const
+		void SignalSplitBarrier(VulkanCommandBuffer& command_buffer, VulkanSplitBarrier& split_barrier);
+		void WaitSplitBarrier(VulkanCommandBuffer& command_buffer, const VulkanSplitBarrier& split_barrier);
+
+		void ResetQueries(const VulkanCommandBuffer& command_buffer, VkQueryPool vk_query_pool, uint32_t first_query, uint32_t num_queries);
+		// Flushes the pending barriers first, so that a begin timestamp is written after the barriers of the work it measures
+		void WriteTimestamp(VulkanCommandBuffer& command_buffer, VkQueryPool vk_query_pool, uint32_t query, VkPipelineStageFlags2 stage_flags);
+		void BeginQuery(const VulkanCommandBuffer& command_buffer, VkQueryPool vk_query_pool, uint32_t query);
+		void EndQuery(const VulkanCommandBuffer& command_buffer, VkQueryPool vk_query_pool, uint32_t query);
 
 	}
 
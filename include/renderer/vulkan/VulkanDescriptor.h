@@ -9,8 +9,13 @@ namespace Vulkan
 
 		void Init();
 		void Exit();
+		// Makes descriptors freed GetNumFramesInFlight frames ago available again, destroys heap buffers that were replaced back then,
+		// and grows heaps that are running low on free descriptors, called at the beginning of every frame
+		void BeginFrame();
 
+		// The frame index selects the per-frame descriptor buffer for uniform buffers, it is ignored for all other types
 		VulkanDescriptorAllocation Allocate(VulkanDescriptorType type, uint32_t num_descriptors = 1, uint32_t frame_index = 0);
+		// The descriptors are not reused until the frames currently in flight have finished
 		void Free(VulkanDescriptorAllocation& alloc, uint32_t frame_index = 0);
 
 		void Write(const VulkanDescriptorAllocation& descriptors, const VulkanBuffer& buffer, uint32_t descriptor_offset = 0);
@@ -19,6 +24,19 @@ namespace Vulkan
 
 		bool IsValid(const VulkanDescriptorAllocation& alloc);
 
+		struct HeapStats
+		{
+			uint32_t num_descriptors = 0;
+			// Does not include descriptors that are waiting for the frames in flight to finish
+			uint32_t num_free_descriptors = 0;
+			uint32_t max_descriptors = 0;
+			uint64_t size_in_bytes = 0;
+		};
+
+		// Uniform buffer stats are for the descriptor buffer of the current frame
+		HeapStats GetHeapStats(VulkanDescriptorType type);
+		const char* GetTypeName(VulkanDescriptorType type);
+
 		std::vector<VkDescriptorSetLayout> GetDescriptorSetLayouts();
 		void BindDescriptors(const VulkanCommandBuffer& command_buffer, const VulkanPipeline& pipeline);
 
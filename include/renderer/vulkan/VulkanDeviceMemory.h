@@ -10,11 +10,23 @@ namespace Vulkan
 
 		VulkanMemory Allocate(const VulkanBuffer& vk_buffer, const BufferCreateInfo& buffer_info);
 		VulkanMemory Allocate(const VulkanImage& vk_image, const TextureCreateInfo& texture_info);
+		// Allocates memory that is not bound to any resource yet, used for resources that share (alias) the same memory
+		VulkanMemory Allocate(const VkMemoryRequirements& memory_req, Flags memory_flags, const std::string& name);
 		void Free(VulkanMemory& device_memory);
 
 		void* Map(const VulkanMemory& device_memory, uint64_t size, uint64_t offset);
 		void Unmap(const VulkanMemory& device_memory);
 
+		struct Stats
+		{
+			uint64_t num_allocations = 0;
+			uint64_t allocated_bytes = 0;
+			uint64_t peak_allocated_bytes = 0;
+		};
+
+		// Counts all device memory allocations made through Allocate, in all memory types
+		Stats GetStats();
+
 	}
 	
 }
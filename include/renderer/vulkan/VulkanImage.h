@@ -8,8 +8,10 @@ namespace Vulkan
 	namespace Image
 	{
 		
-		VulkanImage Create(const TextureCreateInfo& texture_info);
+		// Images created without memory need to be bound with BindMemory before use, and do not own the memory they are bound to
+		VulkanImage Create(const TextureCreateInfo& texture_info, bool allocate_memory = true);
 		void Destroy(VulkanImage& image);
+		void BindMemory(const VulkanImage& image, const VulkanMemory& memory, uint64_t offset = 0);
 
 		VkMemoryRequirements GetMemoryRequirements(const VulkanImage& image);
 
@@ -8,6 +8,9 @@ namespace Vulkan
 	struct VulkanInstance
 	{
 		::GLFWwindow* glfw_window = nullptr;
+		// Without a window there is no surface or swapchain, frames are only rendered into the render targets
+		bool headless = false;
+		VkExtent2D headless_extent = { 0, 0 };
 
 		std::vector<const char*> extensions =
 		{
@@ -33,11 +36,19 @@ namespace Vulkan
 		VkDevice device = VK_NULL_HANDLE;
 		uint32_t current_frame_index = 0;
 		uint32_t last_finished_frame = 0;
+		// Number of frames the CPU is allowed to record ahead of the GPU, at most MAX_FRAMES_IN_FLIGHT
+		uint32_t num_frames_in_flight = 0;
 
 		struct DeviceProperties
 		{
 			uint32_t max_anisotropy;
 			uint32_t descriptor_buffer_offset_alignment;
+			// Nanoseconds per timestamp query tick
+			float timestamp_period;
+			// Pipeline statistics queries are optional, the GPU profiler only collects them if supported
+			bool pipeline_statistics_query;
+			// VK_EXT_calibrated_timestamps is optional, it relates GPU timestamps to CPU time for the latency readout
+			bool calibrated_timestamps;
 		} device_props;
 
 		struct DescriptorSizes
@@ -50,6 +61,25 @@ namespace Vulkan
 			size_t acceleration_structure = 0;
 		} descriptor_sizes;
 
+		// Upper bounds for the descriptor heaps, which are allowed to grow up to the smallest of these for their type
+		struct DescriptorLimits
+		{
+			uint32_t max_per_stage_resources = 0;
+			uint32_t max_storage_buffers = 0;
+			uint32_t max_storage_images = 0;
+			uint32_t max_sampled_images = 0;
+			uint32_t max_samplers = 0;
+			uint32_t max_acceleration_structures = 0;
+
+			uint32_t max_descriptor_buffer_bindings = 0;
+			uint32_t max_resource_descriptor_buffer_bindings = 0;
+			uint32_t max_sampler_descriptor_buffer_bindings = 0;
+			uint64_t max_resource_descriptor_buffer_range = 0;
+			uint64_t max_sampler_descriptor_buffer_range = 0;
+			uint64_t resource_descriptor_buffer_address_space_size = 0;
+			uint64_t sampler_descriptor_buffer_address_space_size = 0;
+		} descriptor_limits;
+
 		struct Swapchain
 		{
 			VkSurfaceKHR surface = VK_NULL_HANDLE;
@@ -58,8 +88,14 @@ namespace Vulkan
 			VkExtent2D extent = { 0, 0 };
 			uint32_t current_image = 0;
 
+			// The present mode that was asked for, and the one that is currently used to present
+			// Switching between present modes that were passed to the swapchain at creation is seamless, any other switch recreates it
 			VkPresentModeKHR desired_present_mode = VK_PRESENT_MODE_FIFO_KHR;
-			bool vsync_enabled = true;
+			VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
+			std::vector<VkPresentModeKHR> supported_present_modes;
+			std::vector<VkPresentModeKHR> compatible_present_modes;
+			// Set when the swapchain needs to be recreated at the start of the next frame
+			bool recreate = false;
 
 			std::vector<VulkanImage> images;
 			std::vector<VulkanFence> image_available_fences;
@@ -70,6 +106,8 @@ namespace Vulkan
 			//VulkanCommandQueue present;
 			VulkanCommandQueue graphics_compute;
 			VulkanCommandQueue transfer;
+			// Async compute, which is a separate queue from graphics_compute but not necessarily from a different queue family
+			VulkanCommandQueue compute;
 		} queues;
 
 		struct Debug
@@ -88,6 +126,7 @@ namespace Vulkan
 			PFN_vkCmdSetDescriptorBufferOffsetsEXT cmd_set_descriptor_buffer_offsets_ext;
 			PFN_vkCmdBindDescriptorBuffersEXT cmd_bind_descriptor_buffers_ext;
 			PFN_vkDebugMarkerSetObjectNameEXT debug_marker_set_object_name_ext;
+			PFN_vkGetCalibratedTimestampsEXT get_calibrated_timestamps_ext;
 
 			struct Raytracing
 			{
@@ -0,0 +1,31 @@
+#pragma once
+#include "renderer/vulkan/VulkanTypes.h"
+
+namespace Vulkan
+{
+
+	namespace Query
+	{
+
+		// The host time domain that std::chrono::steady_clock is built on, QueryPerformanceCounter on Windows and CLOCK_MONOTONIC elsewhere
+#ifdef _WIN32
+		static constexpr VkTimeDomainEXT HOST_TIME_DOMAIN = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+		static constexpr VkTimeDomainEXT HOST_TIME_DOMAIN = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+		VkQueryPool CreatePool(VkQueryType type, uint32_t num_queries, const std::string& name, VkQueryPipelineStatisticFlags statistic_flags = 0);
+		void DestroyPool(VkQueryPool& vk_query_pool);
+		// Resets the queries from the host, none of them can be in use by the GPU
+		void ResetPool(VkQueryPool vk_query_pool, uint32_t first_query, uint32_t num_queries);
+
+		// Does not wait for the results, returns false if any of the queries is not available yet
+		bool GetResults(VkQueryPool vk_query_pool, uint32_t first_query, uint32_t num_queries, uint32_t num_values_per_query, uint64_t* const results);
+		double TimestampsToMs(uint64_t begin_timestamp, uint64_t end_timestamp);
+		// Samples the current GPU timestamp together with the CPU time in one call, returns false if calibrated timestamps are not supported,
+		// or if the driver could not take both samples close enough together
+		bool GetCalibratedTimestamp(uint64_t& gpu_timestamp, std::chrono::steady_clock::time_point& cpu_time);
+
+	}
+
+}
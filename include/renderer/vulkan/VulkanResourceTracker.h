@@ -10,14 +10,16 @@ namespace Vulkan
 		void Init();
 		void Exit();
 
-		void TrackBuffer(const VulkanBuffer& buffer);
+		// Assigns the tracking index of the buffer, which is used for all later lookups
+		void TrackBuffer(VulkanBuffer& buffer);
 		void TrackBufferTemp(const VulkanBuffer& buffer, const VulkanFence& fence, uint64_t fence_value);
 		void RemoveBuffer(const VulkanBuffer& buffer);
 
 		VkBufferMemoryBarrier2 BufferMemoryBarrier(const VulkanBufferBarrier& barrier);
 		void UpdateBufferAccessAndStageFlags(const VulkanBufferBarrier& barrier);
 
-		void TrackImage(const VulkanImage& image, VkImageLayout layout);
+		// Assigns the tracking index of the image, which is used for all later lookups
+		void TrackImage(VulkanImage& image, VkImageLayout layout);
 		void TrackImageTemp(const VulkanImage& image, const VulkanFence& fence, uint64_t fence_value);
 		void RemoveImage(const VulkanImage& image);
 
@@ -14,8 +14,10 @@ namespace Vulkan
 		VulkanImage& GetBackBuffer();
 		VkResult Present(const std::vector<VulkanFence>& wait_fences);
 
-		void SetVSync(bool enabled);
-		bool IsVSyncEnabled();
+		// Unsupported present modes are ignored, see VulkanInstance::Swapchain for when this recreates the swapchain
+		void SetPresentMode(VkPresentModeKHR present_mode);
+		VkPresentModeKHR GetPresentMode();
+		bool IsPresentModeSupported(VkPresentModeKHR present_mode);
 
 	}
 
@@ -16,6 +16,10 @@ namespace Vulkan
 		uint64_t GetFenceValue(const VulkanFence& fence);
 		bool IsFenceCompleted(const VulkanFence& fence);
 
+		// Events are only signaled and waited on from command buffers, used for split barriers
+		VkEvent CreateDeviceEvent(const std::string& name);
+		void DestroyDeviceEvent(VkEvent& vk_event);
+
 	}
 
 }
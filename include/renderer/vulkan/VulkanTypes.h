@@ -36,6 +36,7 @@ enum VulkanCommandBufferType
 {
 	VULKAN_COMMAND_BUFFER_TYPE_GRAPHICS_COMPUTE,
 	VULKAN_COMMAND_BUFFER_TYPE_TRANSFER,
+	VULKAN_COMMAND_BUFFER_TYPE_COMPUTE,
 	VULKAN_COMMAND_BUFFER_TYPE_NUM_TYPES
 };
 
@@ -62,6 +63,20 @@ struct VulkanCommandBuffer
 	VulkanPipeline pipeline_bound;
 
 	std::vector<VulkanFence> wait_fences;
+
+	// Barriers are deferred until the next command that depends on them, so that they are recorded in a single pipeline barrier
+	std::vector<VkImageMemoryBarrier2> pending_image_barriers;
+	std::vector<VkBufferMemoryBarrier2> pending_buffer_barriers;
+};
+
+// Split barriers signal an event after the producing work and only wait on it right before the consuming work,
+// which lets the GPU overlap the work recorded in between with the barrier
+struct VulkanSplitBarrier
+{
+	VkEvent vk_event = VK_NULL_HANDLE;
+
+	std::vector<VkImageMemoryBarrier2> image_barriers;
+	std::vector<VkBufferMemoryBarrier2> buffer_barriers;
 };
 
 // NOTE: The order needs to match the DescriptorSetXYZ consts in assets/shaders/Shared.glsl.h
@@ -83,7 +98,8 @@ struct VulkanDescriptorAllocation
 	uint32_t num_descriptors = 0u;
 	uint32_t descriptor_size_in_bytes = 0u;
 	uint32_t descriptor_offset = 0u;
-	uint8_t* ptr = nullptr;
+	// Only used by uniform buffer descriptors, which are allocated from a descriptor buffer per frame
+	uint32_t frame_index = 0u;
 };
 
 struct VulkanMemory
@@ -91,6 +107,7 @@ struct VulkanMemory
 	VkDeviceMemory vk_device_memory = VK_NULL_HANDLE;
 	VkMemoryPropertyFlags vk_memory_flags = VK_MEMORY_PROPERTY_FLAG_BITS_MAX_ENUM;
 	uint32_t vk_memory_index = 0;
+	uint64_t byte_size = 0;
 };
 
 struct VulkanBuffer
@@ -104,6 +121,9 @@ struct VulkanBuffer
 
 	// NOTE: Only used for raytracing acceleration structures
 	VkAccelerationStructureKHR vk_acceleration_structure = VK_NULL_HANDLE;
+
+	// Slot in the resource tracker, assigned when the buffer starts being tracked
+	uint32_t tracking_index = UINT32_MAX;
 };
 
 struct VulkanBufferBarrier
@@ -130,6 +150,9 @@ struct VulkanImage
 	uint32_t num_mips = 0u;
 	uint32_t num_layers = 0u;
 
+	// Slot in the resource tracker, assigned when the image starts being tracked
+	uint32_t tracking_index = UINT32_MAX;
+
 	// TODO: We can add offsets into the actual buffer here once we have a GPU memory allocator
 };
 
@@ -0,0 +1,575 @@
+#include "Precomp.h"
+#include "AABBTree.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define AABB_TREE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+enum FrustumTestResult
+{
+	FRUSTUM_TEST_OUTSIDE,
+	FRUSTUM_TEST_INTERSECTS,
+	FRUSTUM_TEST_INSIDE
+};
+
+// The frustum planes in SoA layout, padded to 8 planes by repeating the near and far plane, so that a box is tested against 4 planes at once
+// The absolute plane normals are stored as well, those project the box extent onto the plane normal
+struct FrustumPlanesSoA
+{
+	alignas(16) float x[8];
+	alignas(16) float y[8];
+	alignas(16) float z[8];
+	alignas(16) float w[8];
+
+	alignas(16) float abs_x[8];
+	alignas(16) float abs_y[8];
+	alignas(16) float abs_z[8];
+};
+
+static FrustumPlanesSoA ToPlanesSoA(const Frustum& frustum)
+{
+	FrustumPlanesSoA planes = {};
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		const glm::vec4& plane = frustum.planes[i < Frustum::PLANE_NUM_PLANES ? i : i - 4];
+
+		planes.x[i] = plane.x;
+		planes.y[i] = plane.y;
+		planes.z[i] = plane.z;
+		planes.w[i] = plane.w;
+
+		planes.abs_x[i] = std::abs(plane.x);
+		planes.abs_y[i] = std::abs(plane.y);
+		planes.abs_z[i] = std::abs(plane.z);
+	}
+
+	return planes;
+}
+
+static FrustumTestResult TestFrustumAABB(const FrustumPlanesSoA& planes, const AABB& aabb)
+{
+	glm::vec3 center = aabb.GetCenter();
+	glm::vec3 extent = aabb.GetExtent();
+
+	int outside_mask = 0;
+	int intersect_mask = 0;
+
+#if AABB_TREE_SSE
+	__m128 center_x = _mm_set1_ps(center.x);
+	__m128 center_y = _mm_set1_ps(center.y);
+	__m128 center_z = _mm_set1_ps(center.z);
+	__m128 extent_x = _mm_set1_ps(extent.x);
+	__m128 extent_y = _mm_set1_ps(extent.y);
+	__m128 extent_z = _mm_set1_ps(extent.z);
+	__m128 zero = _mm_setzero_ps();
+
+	for (uint32_t i = 0; i < 8; i += 4)
+	{
+		__m128 distance = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_load_ps(&planes.x[i]), center_x),
+			_mm_mul_ps(_mm_load_ps(&planes.y[i]), center_y)), _mm_add_ps(
+			_mm_mul_ps(_mm_load_ps(&planes.z[i]), center_z),
+			_mm_load_ps(&planes.w[i])));
+
+		__m128 radius = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_load_ps(&planes.abs_x[i]), extent_x),
+			_mm_mul_ps(_mm_load_ps(&planes.abs_y[i]), extent_y)),
+			_mm_mul_ps(_mm_load_ps(&planes.abs_z[i]), extent_z));
+
+		outside_mask |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		intersect_mask |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), zero));
+	}
+#else
+	for (uint32_t i = 0; i < Frustum::PLANE_NUM_PLANES; ++i)
+	{
+		float distance = planes.x[i] * center.x + planes.y[i] * center.y + planes.z[i] * center.z + planes.w[i];
+		float radius = planes.abs_x[i] * extent.x + planes.abs_y[i] * extent.y + planes.abs_z[i] * extent.z;
+
+		outside_mask |= distance + radius < 0.0f;
+		intersect_mask |= distance - radius < 0.0f;
+	}
+#endif
+
+	if (outside_mask)
+		return FRUSTUM_TEST_OUTSIDE;
+	if (intersect_mask)
+		return FRUSTUM_TEST_INTERSECTS;
+
+	return FRUSTUM_TEST_INSIDE;
+}
+
+// Slab test, the distance at which the ray enters the box is returned in enter_distance
+static bool IntersectRayAABB(const glm::vec3& origin, const glm::vec3& inv_direction, float max_distance, const AABB& aabb, float& enter_distance)
+{
+	glm::vec3 t0 = (aabb.min - origin) * inv_direction;
+	glm::vec3 t1 = (aabb.max - origin) * inv_direction;
+	glm::vec3 t_min = glm::min(t0, t1);
+	glm::vec3 t_max = glm::max(t0, t1);
+
+	enter_distance = std::max(std::max(t_min.x, t_min.y), std::max(t_min.z, 0.0f));
+	float exit_distance = std::min(std::min(t_max.x, t_max.y), std::min(t_max.z, max_distance));
+
+	return enter_distance <= exit_distance;
+}
+
+void AABBTree::Insert(EntityHandle entity, const AABB& aabb)
+{
+	VK_ASSERT(VK_RESOURCE_HANDLE_VALID(entity) && "Tried to insert an invalid entity into the AABB tree");
+	VK_ASSERT(!Contains(entity) && "Tried to insert an entity into the AABB tree twice");
+
+	uint32_t leaf = AllocateNode();
+	m_nodes[leaf].aabb = { aabb.min - FAT_AABB_MARGIN, aabb.max + FAT_AABB_MARGIN };
+	m_nodes[leaf].entity = entity;
+
+	InsertLeaf(leaf);
+
+	if (entity.index >= m_entity_to_leaf.size())
+	{
+		m_entity_to_leaf.resize(entity.index + 1, INVALID_NODE);
+	}
+	m_entity_to_leaf[entity.index] = leaf;
+	m_num_leaves++;
+}
+
+void AABBTree::Remove(EntityHandle entity)
+{
+	uint32_t leaf = FindLeaf(entity);
+	if (leaf == INVALID_NODE)
+		return;
+
+	RemoveLeaf(leaf);
+	FreeNode(leaf);
+
+	m_entity_to_leaf[entity.index] = INVALID_NODE;
+	m_num_leaves--;
+}
+
+bool AABBTree::Update(EntityHandle entity, const AABB& aabb)
+{
+	uint32_t leaf = FindLeaf(entity);
+	VK_ASSERT(leaf != INVALID_NODE && "Tried to update an entity that is not in the AABB tree");
+
+	if (m_nodes[leaf].aabb.Contains(aabb))
+		return false;
+
+	RemoveLeaf(leaf);
+	m_nodes[leaf].aabb = { aabb.min - FAT_AABB_MARGIN, aabb.max + FAT_AABB_MARGIN };
+	InsertLeaf(leaf);
+
+	return true;
+}
+
+bool AABBTree::Contains(EntityHandle entity) const
+{
+	return FindLeaf(entity) != INVALID_NODE;
+}
+
+void AABBTree::QueryFrustum(const Frustum& frustum, std::vector<EntityHandle>& entities) const
+{
+	PROFILE_FUNCTION();
+
+	if (m_root == INVALID_NODE)
+		return;
+
+	FrustumPlanesSoA planes = ToPlanesSoA(frustum);
+
+	// Nodes that are fully inside the frustum are marked in the top bit, their subtree is added without testing any further
+	static constexpr uint32_t INSIDE_BIT = 1u << 31;
+
+	uint32_t stack[MAX_TRAVERSAL_STACK_SIZE];
+	uint32_t stack_size = 0;
+	stack[stack_size++] = m_root;
+
+	while (stack_size > 0)
+	{
+		uint32_t entry = stack[--stack_size];
+		uint32_t node_index = entry & ~INSIDE_BIT;
+		const Node& node = m_nodes[node_index];
+
+		uint32_t inside_bit = entry & INSIDE_BIT;
+		if (!inside_bit)
+		{
+			FrustumTestResult result = TestFrustumAABB(planes, node.aabb);
+			if (result == FRUSTUM_TEST_OUTSIDE)
+				continue;
+			if (result == FRUSTUM_TEST_INSIDE)
+				inside_bit = INSIDE_BIT;
+		}
+
+		if (node.IsLeaf())
+		{
+			entities.push_back(node.entity);
+			continue;
+		}
+
+		VK_ASSERT(stack_size + 2 <= MAX_TRAVERSAL_STACK_SIZE && "Exceeded the AABB tree traversal stack size");
+		stack[stack_size++] = node.children[0] | inside_bit;
+		stack[stack_size++] = node.children[1] | inside_bit;
+	}
+}
+
+void AABBTree::QueryOverlap(const AABB& aabb, std::vector<EntityHandle>& entities) const
+{
+	if (m_root == INVALID_NODE)
+		return;
+
+	uint32_t stack[MAX_TRAVERSAL_STACK_SIZE];
+	uint32_t stack_size = 0;
+	stack[stack_size++] = m_root;
+
+	while (stack_size > 0)
+	{
+		const Node& node = m_nodes[stack[--stack_size]];
+		if (!node.aabb.Overlaps(aabb))
+			continue;
+
+		if (node.IsLeaf())
+		{
+			entities.push_back(node.entity);
+			continue;
+		}
+
+		VK_ASSERT(stack_size + 2 <= MAX_TRAVERSAL_STACK_SIZE && "Exceeded the AABB tree traversal stack size");
+		stack[stack_size++] = node.children[0];
+		stack[stack_size++] = node.children[1];
+	}
+}
+
+void AABBTree::QueryRay(const glm::vec3& origin, const glm::vec3& direction, float max_distance, std::vector<EntityHandle>& entities) const
+{
+	if (m_root == INVALID_NODE)
+		return;
+
+	glm::vec3 inv_direction = 1.0f / direction;
+
+	uint32_t stack[MAX_TRAVERSAL_STACK_SIZE];
+	uint32_t stack_size = 0;
+	stack[stack_size++] = m_root;
+
+	while (stack_size > 0)
+	{
+		const Node& node = m_nodes[stack[--stack_size]];
+
+		float enter_distance = 0.0f;
+		if (!IntersectRayAABB(origin, inv_direction, max_distance, node.aabb, enter_distance))
+			continue;
+
+		if (node.IsLeaf())
+		{
+			entities.push_back(node.entity);
+			continue;
+		}
+
+		VK_ASSERT(stack_size + 2 <= MAX_TRAVERSAL_STACK_SIZE && "Exceeded the AABB tree traversal stack size");
+		stack[stack_size++] = node.children[0];
+		stack[stack_size++] = node.children[1];
+	}
+}
+
+EntityHandle AABBTree::RayCast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, float* hit_distance) const
+{
+	EntityHandle hit_entity;
+	if (m_root == INVALID_NODE)
+		return hit_entity;
+
+	glm::vec3 inv_direction = 1.0f / direction;
+	float closest_distance = max_distance;
+
+	float root_distance = 0.0f;
+	if (!IntersectRayAABB(origin, inv_direction, closest_distance, m_nodes[m_root].aabb, root_distance))
+		return hit_entity;
+
+	// Every node on the stack is hit by the ray, the closer child is visited first, so that the closest hit shrinks the ray early
+	uint32_t stack[MAX_TRAVERSAL_STACK_SIZE];
+	float stack_distances[MAX_TRAVERSAL_STACK_SIZE];
+	uint32_t stack_size = 0;
+
+	stack[stack_size] = m_root;
+	stack_distances[stack_size++] = root_distance;
+
+	while (stack_size > 0)
+	{
+		stack_size--;
+		const Node& node = m_nodes[stack[stack_size]];
+		if (stack_distances[stack_size] > closest_distance)
+			continue;
+
+		if (node.IsLeaf())
+		{
+			closest_distance = stack_distances[stack_size];
+			hit_entity = node.entity;
+			continue;
+		}
+
+		float child_distances[2] = {};
+		bool child_hits[2] =
+		{
+			IntersectRayAABB(origin, inv_direction, closest_distance, m_nodes[node.children[0]].aabb, child_distances[0]),
+			IntersectRayAABB(origin, inv_direction, closest_distance, m_nodes[node.children[1]].aabb, child_distances[1])
+		};
+
+		uint32_t first_child = child_distances[1] < child_distances[0] ? 1 : 0;
+		uint32_t second_child = 1 - first_child;
+
+		VK_ASSERT(stack_size + 2 <= MAX_TRAVERSAL_STACK_SIZE && "Exceeded the AABB tree traversal stack size");
+		if (child_hits[second_child])
+		{
+			stack[stack_size] = node.children[second_child];
+			stack_distances[stack_size++] = child_distances[second_child];
+		}
+		if (child_hits[first_child])
+		{
+			stack[stack_size] = node.children[first_child];
+			stack_distances[stack_size++] = child_distances[first_child];
+		}
+	}
+
+	if (hit_distance && VK_RESOURCE_HANDLE_VALID(hit_entity))
+		*hit_distance = closest_distance;
+
+	return hit_entity;
+}
+
+uint32_t AABBTree::GetHeight() const
+{
+	return m_root == INVALID_NODE ? 0 : m_nodes[m_root].height;
+}
+
+bool AABBTree::Validate() const
+{
+	bool valid = true;
+	uint32_t num_leaves = m_root == INVALID_NODE ? 0 : ValidateSubtree(m_root, INVALID_NODE, valid);
+
+	return valid && num_leaves == m_num_leaves;
+}
+
+uint32_t AABBTree::AllocateNode()
+{
+	if (m_free_list == INVALID_NODE)
+	{
+		m_nodes.emplace_back();
+		return (uint32_t)m_nodes.size() - 1;
+	}
+
+	uint32_t node = m_free_list;
+	m_free_list = m_nodes[node].parent;
+	m_nodes[node] = Node();
+
+	return node;
+}
+
+void AABBTree::FreeNode(uint32_t node)
+{
+	m_nodes[node].parent = m_free_list;
+	m_nodes[node].entity = EntityHandle();
+	m_free_list = node;
+}
+
+void AABBTree::InsertLeaf(uint32_t leaf)
+{
+	if (m_root == INVALID_NODE)
+	{
+		m_root = leaf;
+		m_nodes[leaf].parent = INVALID_NODE;
+		return;
+	}
+
+	// Descend towards the sibling with the lowest cost, the cost of a node is the surface area it adds to the tree
+	// Every node above the sibling grows to include the leaf, which is the inherited cost of descending further
+	AABB leaf_aabb = m_nodes[leaf].aabb;
+	uint32_t sibling = m_root;
+
+	while (!m_nodes[sibling].IsLeaf())
+	{
+		const Node& node = m_nodes[sibling];
+
+		float area = node.aabb.GetSurfaceArea();
+		float combined_area = AABB::Union(node.aabb, leaf_aabb).GetSurfaceArea();
+
+		// Cost of making the leaf a sibling of this node, which creates a new parent with the combined bounds
+		float cost = 2.0f * combined_area;
+		float inherited_cost = 2.0f * (combined_area - area);
+
+		float child_costs[2] = {};
+		for (uint32_t i = 0; i < 2; ++i)
+		{
+			const Node& child = m_nodes[node.children[i]];
+			float child_combined_area = AABB::Union(child.aabb, leaf_aabb).GetSurfaceArea();
+
+			child_costs[i] = (child.IsLeaf() ? child_combined_area : child_combined_area - child.aabb.GetSurfaceArea()) + inherited_cost;
+		}
+
+		if (cost < child_costs[0] && cost < child_costs[1])
+			break;
+
+		sibling = child_costs[0] < child_costs[1] ? node.children[0] : node.children[1];
+	}
+
+	uint32_t old_parent = m_nodes[sibling].parent;
+	uint32_t new_parent = AllocateNode();
+
+	m_nodes[new_parent].parent = old_parent;
+	m_nodes[new_parent].aabb = AABB::Union(leaf_aabb, m_nodes[sibling].aabb);
+	m_nodes[new_parent].height = m_nodes[sibling].height + 1;
+	m_nodes[new_parent].children[0] = sibling;
+	m_nodes[new_parent].children[1] = leaf;
+
+	if (old_parent != INVALID_NODE)
+	{
+		Node& parent = m_nodes[old_parent];
+		parent.children[parent.children[0] == sibling ? 0 : 1] = new_parent;
+	}
+	else
+	{
+		m_root = new_parent;
+	}
+
+	m_nodes[sibling].parent = new_parent;
+	m_nodes[leaf].parent = new_parent;
+
+	RefitAncestors(m_nodes[leaf].parent);
+}
+
+void AABBTree::RemoveLeaf(uint32_t leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = INVALID_NODE;
+		return;
+	}
+
+	uint32_t parent = m_nodes[leaf].parent;
+	uint32_t grand_parent = m_nodes[parent].parent;
+	uint32_t sibling = m_nodes[parent].children[m_nodes[parent].children[0] == leaf ? 1 : 0];
+
+	// The sibling takes the place of the parent
+	if (grand_parent != INVALID_NODE)
+	{
+		Node& grand_parent_node = m_nodes[grand_parent];
+		grand_parent_node.children[grand_parent_node.children[0] == parent ? 0 : 1] = sibling;
+		m_nodes[sibling].parent = grand_parent;
+		FreeNode(parent);
+
+		RefitAncestors(grand_parent);
+	}
+	else
+	{
+		m_root = sibling;
+		m_nodes[sibling].parent = INVALID_NODE;
+		FreeNode(parent);
+	}
+}
+
+uint32_t AABBTree::Balance(uint32_t index_a)
+{
+	Node& a = m_nodes[index_a];
+	if (a.IsLeaf() || a.height < 2)
+		return index_a;
+
+	uint32_t index_b = a.children[0];
+	uint32_t index_c = a.children[1];
+	Node& b = m_nodes[index_b];
+	Node& c = m_nodes[index_c];
+
+	int32_t balance = (int32_t)c.height - (int32_t)b.height;
+	if (balance >= -1 && balance <= 1)
+		return index_a;
+
+	// The higher child takes the place of a, and a takes the place of the higher grandchild
+	// The lower grandchild moves below a, which keeps the other child
+	uint32_t index_up = balance > 1 ? index_c : index_b;
+	uint32_t index_other = balance > 1 ? index_b : index_c;
+	uint32_t a_child_slot = balance > 1 ? 1 : 0;
+	Node& up = m_nodes[index_up];
+	Node& other = m_nodes[index_other];
+
+	uint32_t index_f = up.children[0];
+	uint32_t index_g = up.children[1];
+	Node& f = m_nodes[index_f];
+	Node& g = m_nodes[index_g];
+
+	up.children[0] = index_a;
+	up.parent = a.parent;
+	a.parent = index_up;
+
+	if (up.parent != INVALID_NODE)
+	{
+		Node& parent = m_nodes[up.parent];
+		parent.children[parent.children[0] == index_a ? 0 : 1] = index_up;
+	}
+	else
+	{
+		m_root = index_up;
+	}
+
+	uint32_t index_keep = f.height > g.height ? index_f : index_g;
+	uint32_t index_move = f.height > g.height ? index_g : index_f;
+	Node& keep = m_nodes[index_keep];
+	Node& move = m_nodes[index_move];
+
+	up.children[1] = index_keep;
+	a.children[a_child_slot] = index_move;
+	move.parent = index_a;
+
+	a.aabb = AABB::Union(other.aabb, move.aabb);
+	a.height = 1 + std::max(other.height, move.height);
+	up.aabb = AABB::Union(a.aabb, keep.aabb);
+	up.height = 1 + std::max(a.height, keep.height);
+
+	return index_up;
+}
+
+void AABBTree::RefitAncestors(uint32_t node)
+{
+	while (node != INVALID_NODE)
+	{
+		node = Balance(node);
+
+		Node& ancestor = m_nodes[node];
+		const Node& child0 = m_nodes[ancestor.children[0]];
+		const Node& child1 = m_nodes[ancestor.children[1]];
+
+		ancestor.aabb = AABB::Union(child0.aabb, child1.aabb);
+		ancestor.height = 1 + std::max(child0.height, child1.height);
+
+		node = ancestor.parent;
+	}
+}
+
+uint32_t AABBTree::FindLeaf(EntityHandle entity) const
+{
+	if (!VK_RESOURCE_HANDLE_VALID(entity) || entity.index >= m_entity_to_leaf.size())
+		return INVALID_NODE;
+
+	// The entity stored in the leaf also checks the version, so leaves of destroyed entities are never returned
+	uint32_t leaf = m_entity_to_leaf[entity.index];
+	if (leaf == INVALID_NODE || !(m_nodes[leaf].entity == entity))
+		return INVALID_NODE;
+
+	return leaf;
+}
+
+uint32_t AABBTree::ValidateSubtree(uint32_t node_index, uint32_t parent, bool& valid) const
+{
+	const Node& node = m_nodes[node_index];
+	if (node.parent != parent)
+		valid = false;
+
+	if (node.IsLeaf())
+	{
+		if (node.height != 0 || FindLeaf(node.entity) != node_index)
+			valid = false;
+
+		return 1;
+	}
+
+	const Node& child0 = m_nodes[node.children[0]];
+	const Node& child1 = m_nodes[node.children[1]];
+
+	if (node.height != 1 + std::max(child0.height, child1.height) ||
+		!node.aabb.Contains(child0.aabb) || !node.aabb.Contains(child1.aabb))
+		valid = false;
+
+	return ValidateSubtree(node.children[0], node_index, valid) + ValidateSubtree(node.children[1], node_index, valid);
+}
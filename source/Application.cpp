@@ -5,6 +5,8 @@
 #include "assets/AssetManager.h"
 #include "Input.h"
 #include "Scene.h"
+#include "FileIO.h"
+#include "renderer/vulkan/VulkanDeviceMemory.h"
 
 #include "GLFW/glfw3.h"
 
@@ -19,6 +21,8 @@ namespace Application
 
 	struct Data
 	{
+		Options options;
+
 		GLFWwindow* window = nullptr;
 		uint32_t window_width = 0;
 		uint32_t window_height = 0;
@@ -38,6 +42,13 @@ namespace Application
 
 	const uint32_t DEFAULT_WINDOW_WIDTH = 1280;
 	const uint32_t DEFAULT_WINDOW_HEIGHT = 720;
+	// Saved and loaded from the File menu
+	const char* SCENE_FILEPATH = "scenes/scene.vkscene";
+
+	// The benchmark camera orbits the center of the scene once over the benchmark frames
+	const float BENCHMARK_CAMERA_ORBIT_RADIUS = 8.0f;
+	const float BENCHMARK_CAMERA_HEIGHT = 2.0f;
+	const float BENCHMARK_CAMERA_VFOV = 60.0f;
 
 	static void FramebufferResizeCallback(GLFWwindow* window, int width, int height)
 	{
@@ -89,44 +100,41 @@ namespace Application
 		}
 	}
 
-	static void SpawnModelNodeEntity(ModelAsset* model_asset, const ModelAsset::Node& node, const glm::mat4& node_transform)
+	static void CreateDefaultScene()
 	{
-		for (uint32_t i = 0; i < node.mesh_render_handles.size(); ++i)
-		{
-			data->active_scene.AddEntity<MeshObject>(node.mesh_render_handles[i], node.materials[i], node_transform, node.mesh_names[i]);
-		}
+		glm::mat4 transform = glm::scale(glm::identity<glm::mat4>(), glm::vec3(1.0f));
+		data->active_scene.CreateModelEntity(data->sponza_mesh, transform);
+		transform = glm::scale(glm::translate(glm::identity<glm::mat4>(), glm::vec3(-2.5f, 1.25f, -0.25f)), glm::vec3(1.0f));
+		data->active_scene.CreateModelEntity(data->model_mesh, transform);
 
-		for (uint32_t i = 0; i < node.children.size(); ++i)
-		{
-			const ModelAsset::Node& child_node = model_asset->nodes[node.children[i]];
-			glm::mat4 child_transform = node_transform * child_node.transform;
+		glm::mat4 area_light_transform = glm::translate(glm::identity<glm::mat4>(), glm::vec3(7.0f, 1.25f, -0.25f));
+		area_light_transform = glm::rotate(area_light_transform, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		area_light_transform = glm::scale(area_light_transform, glm::vec3(2.5f, 1.5f, 1.0f));
+		data->active_scene.CreateAreaLightEntity("AreaLight0", data->tex_kermit, area_light_transform, glm::vec3(1.0f, 0.95f, 0.8f), 5.0f, true);
 
-			SpawnModelNodeEntity(model_asset, child_node, child_transform);
-		}
+		area_light_transform = glm::translate(glm::identity<glm::mat4>(), glm::vec3(-8.0f, 1.25f, -0.25f));
+		area_light_transform = glm::rotate(area_light_transform, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		area_light_transform = glm::scale(area_light_transform, glm::vec3(2.5f, 1.5f, 1.0f));
+		data->active_scene.CreateAreaLightEntity("AreaLight1", AssetHandle(), area_light_transform, glm::vec3(1.0f, 0.95f, 0.8f), 5.0f, true);
 	}
 
-	static void SpawnModelEntity(AssetHandle model_handle, const glm::mat4& transform)
+	void Init(const Options& options)
 	{
-		ModelAsset* model_asset = AssetManager::GetAsset<ModelAsset>(model_handle);
-		if (!model_asset)
-			return;
+		data = new Data();
+		data->options = options;
+		CPUProfiler::Init();
 
-		for (uint32_t i = 0; i < model_asset->root_nodes.size(); ++i)
+		if (options.headless)
 		{
-			const ModelAsset::Node& root_node = model_asset->nodes[model_asset->root_nodes[i]];
-			glm::mat4 root_transform = transform * root_node.transform;
-		
-			SpawnModelNodeEntity(model_asset, root_node, root_transform);
+			data->window_width = options.width;
+			data->window_height = options.height;
+		}
+		else
+		{
+			CreateWindow();
+			Input::Init(data->window);
 		}
-	}
-
-	void Init()
-	{
-		data = new Data();
-
-		CreateWindow();
 
-		Input::Init(data->window);
 		Renderer::Init(data->window, data->window_width, data->window_height);
 
 		AssetManager::Init("assets");
@@ -137,20 +145,14 @@ namespace Application
 		data->sponza_mesh = AssetManager::ImportModel("assets\\models\\gltf\\SponzaOld\\Sponza.gltf");
 		data->model_mesh = AssetManager::ImportModel("assets\\models\\gltf\\ClearCoatSphere\\ClearcoatSphere.gltf");
 
-		glm::mat4 transform = glm::scale(glm::identity<glm::mat4>(), glm::vec3(1.0f));
-		SpawnModelEntity(data->sponza_mesh, transform);
-		transform = glm::scale(glm::translate(glm::identity<glm::mat4>(), glm::vec3(-2.5f, 1.25f, -0.25f)), glm::vec3(1.0f));
-		SpawnModelEntity(data->model_mesh, transform);
-
-		glm::mat4 area_light_transform = glm::translate(glm::identity<glm::mat4>(), glm::vec3(7.0f, 1.25f, -0.25f));
-		area_light_transform = glm::rotate(area_light_transform, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-		area_light_transform = glm::scale(area_light_transform, glm::vec3(2.5f, 1.5f, 1.0f));
-		data->active_scene.AddEntity<AreaLight>(AssetManager::GetAsset<TextureAsset>(data->tex_kermit)->texture_render_handle, area_light_transform, glm::vec3(1.0f, 0.95f, 0.8f), 5.0f, true, "AreaLight0");
+		// Scene files reference the imported assets above, so they can only be loaded after them
+		if (options.scene_filepath.empty() || !data->active_scene.LoadFromFile(options.scene_filepath))
+		{
+			if (!options.scene_filepath.empty())
+				LOG_WARN("Application::Init", "Failed to load scene {}, falling back to the default scene", options.scene_filepath.string());
 
-		area_light_transform = glm::translate(glm::identity<glm::mat4>(), glm::vec3(-8.0f, 1.25f, -0.25f));
-		area_light_transform = glm::rotate(area_light_transform, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-		area_light_transform = glm::scale(area_light_transform, glm::vec3(2.5f, 1.5f, 1.0f));
-		data->active_scene.AddEntity<AreaLight>(RenderResourceHandle(), area_light_transform, glm::vec3(1.0f, 0.95f, 0.8f), 5.0f, true, "AreaLight1");
+			CreateDefaultScene();
+		}
 
 		is_running = true;
 	}
@@ -161,16 +163,56 @@ namespace Application
 
 		AssetManager::Exit();
 		Renderer::Exit();
-		Input::Exit();
 
-		DestroyWindow();
+		if (!data->options.headless)
+		{
+			Input::Exit();
+			DestroyWindow();
+		}
+		CPUProfiler::Exit();
 
 		delete data;
 		data = nullptr;
 	}
 
+	// Picks the entity under the cursor, or in the center of the screen while the camera has captured the cursor
+	static void PickEntity()
+	{
+		int window_width = 0, window_height = 0;
+		glfwGetWindowSize(data->window, &window_width, &window_height);
+		if (window_width == 0 || window_height == 0)
+			return;
+
+		float screen_x = 0.0f, screen_y = 0.0f;
+		if (!Input::IsCursorDisabled())
+		{
+			double mouse_x, mouse_y;
+			Input::GetMousePositionAbs(mouse_x, mouse_y);
+
+			screen_x = 2.0f * (float)mouse_x / window_width - 1.0f;
+			screen_y = 2.0f * (float)mouse_y / window_height - 1.0f;
+		}
+
+		glm::vec3 ray_origin, ray_direction;
+		data->active_scene.GetActiveCamera().GetViewRay(screen_x, screen_y, (float)window_width / window_height, ray_origin, ray_direction);
+		data->active_scene.SelectEntity(data->active_scene.PickEntity(ray_origin, ray_direction));
+	}
+
 	static void Update(float dt)
 	{
+		PROFILE_FUNCTION();
+
+		if (Input::IsKeyPressed(Input::Key_F2, true))
+		{
+			CPUProfiler::StartCapture();
+		}
+
+		// Picks with the camera of the frame that is on screen, before the camera moves
+		if (Input::IsButtonPressed(Input::Button_MiddleMouse, true))
+		{
+			PickEntity();
+		}
+
 		data->active_scene.Update(dt);
 		Input::Update();
 	}
@@ -187,6 +229,7 @@ namespace Application
 			data->active_scene.RenderUI();
 			AssetManager::RenderUI();
 			Renderer::RenderUI();
+			CPUProfiler::RenderUI();
 
 			if (ImGui::Begin("Application", nullptr, ImGuiWindowFlags_MenuBar))
 			{
@@ -194,6 +237,18 @@ namespace Application
 				{
 					if (ImGui::BeginMenu("File"))
 					{
+						if (ImGui::MenuItem("Save scene"))
+						{
+							data->active_scene.SaveToFile(SCENE_FILEPATH);
+						}
+						if (ImGui::MenuItem("Load scene"))
+						{
+							data->active_scene.LoadFromFile(SCENE_FILEPATH);
+						}
+						if (ImGui::MenuItem("Export scene to JSON"))
+						{
+							data->active_scene.ExportToJson(std::filesystem::path(SCENE_FILEPATH).replace_extension(".json"));
+						}
 						if (ImGui::MenuItem("Restart"))
 						{
 							is_running = false;
@@ -217,6 +272,8 @@ namespace Application
 
 	static void Render()
 	{
+		PROFILE_FUNCTION();
+
 		Renderer::BeginFrameInfo frame_info = {};
 		frame_info.camera_view = data->active_scene.GetActiveCamera().GetView();
 		frame_info.camera_vfov = data->active_scene.GetActiveCamera().GetVerticalFOV();
@@ -230,8 +287,140 @@ namespace Application
 		Renderer::EndFrame();
 	}
 
+	struct BenchmarkSamples
+	{
+		std::vector<double> cpu_ms;
+		std::vector<double> gpu_graphics_ms;
+		std::vector<double> gpu_async_compute_ms;
+		std::vector<std::pair<uint32_t, uint64_t>> checksums;
+	};
+
+	static glm::mat4 GetBenchmarkCameraView(uint32_t frame_index, uint32_t num_frames)
+	{
+		float angle = glm::two_pi<float>() * (float)frame_index / (float)std::max(num_frames, 1u);
+		glm::vec3 eye(std::cos(angle) * BENCHMARK_CAMERA_ORBIT_RADIUS, BENCHMARK_CAMERA_HEIGHT, std::sin(angle) * BENCHMARK_CAMERA_ORBIT_RADIUS);
+
+		return glm::lookAt(eye, glm::vec3(0.0f, BENCHMARK_CAMERA_HEIGHT, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+
+	// Writes the average, minimum, maximum and nearest-rank percentiles of the samples as a JSON object
+	static std::string BenchmarkStatsToJson(std::vector<double> samples)
+	{
+		if (samples.empty())
+			return "null";
+
+		std::sort(samples.begin(), samples.end());
+
+		auto percentile = [&samples](double p)
+		{
+			size_t rank = (size_t)std::ceil(p / 100.0 * samples.size());
+			return samples[std::clamp(rank, (size_t)1, samples.size()) - 1];
+		};
+
+		double sum = 0.0;
+		for (double sample : samples)
+			sum += sample;
+
+		return std::format("{{\"avg\":{:.4f},\"min\":{:.4f},\"max\":{:.4f},\"p50\":{:.4f},\"p90\":{:.4f},\"p95\":{:.4f},\"p99\":{:.4f}}}",
+			sum / samples.size(), samples.front(), samples.back(), percentile(50.0), percentile(90.0), percentile(95.0), percentile(99.0));
+	}
+
+	static void WriteBenchmarkResults(const BenchmarkSamples& samples)
+	{
+		const Options& options = data->options;
+		Vulkan::DeviceMemory::Stats memory_stats = Vulkan::DeviceMemory::GetStats();
+
+		std::string json = "{\n";
+		json += std::format("\t\"width\": {},\n\t\"height\": {},\n", options.width, options.height);
+		json += std::format("\t\"warmup_frames\": {},\n\t\"benchmark_frames\": {},\n", options.warmup_frames, options.benchmark_frames);
+		json += std::format("\t\"cpu_frame_ms\": {},\n", BenchmarkStatsToJson(samples.cpu_ms));
+		json += std::format("\t\"gpu_graphics_ms\": {},\n", BenchmarkStatsToJson(samples.gpu_graphics_ms));
+		json += std::format("\t\"gpu_async_compute_ms\": {},\n", BenchmarkStatsToJson(samples.gpu_async_compute_ms));
+		json += std::format("\t\"device_memory\": {{\"num_allocations\":{},\"allocated_bytes\":{},\"peak_allocated_bytes\":{}}},\n",
+			memory_stats.num_allocations, memory_stats.allocated_bytes, memory_stats.peak_allocated_bytes);
+
+		json += "\t\"checksums\": [";
+		for (size_t i = 0; i < samples.checksums.size(); ++i)
+		{
+			// Written as a string, since JSON parsers commonly read numbers as doubles, which cannot hold all 64 bits
+			json += std::format("{}{{\"frame\":{},\"hash\":\"{:016x}\"}}", i == 0 ? "" : ",", samples.checksums[i].first, samples.checksums[i].second);
+		}
+		json += "]\n}\n";
+
+		if (FileIO::WriteBinary(options.output_filepath, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(json.data()), json.size())))
+			LOG_INFO("Application::RunBenchmark", "Wrote benchmark results to {}", options.output_filepath.string());
+		else
+			LOG_WARN("Application::RunBenchmark", "Failed to write benchmark results to {}", options.output_filepath.string());
+	}
+
+	// Renders the scene along a scripted camera path without any input, UI or scene updates, so that every run renders the same frames
+	// GPU timings lag behind by the number of frames in flight, so the benchmark keeps rendering until those have been read back as well
+	static void RunBenchmark()
+	{
+		const Options& options = data->options;
+		uint32_t gpu_timings_latency = Renderer::GetNumFramesInFlight();
+		uint32_t total_frames = options.warmup_frames + options.benchmark_frames + gpu_timings_latency;
+
+		BenchmarkSamples samples;
+		samples.cpu_ms.reserve(options.benchmark_frames);
+		samples.gpu_graphics_ms.reserve(options.benchmark_frames);
+		samples.gpu_async_compute_ms.reserve(options.benchmark_frames);
+
+		LOG_INFO("Application::RunBenchmark", "Running benchmark at {}x{} with {} warmup frames and {} benchmark frames",
+			options.width, options.height, options.warmup_frames, options.benchmark_frames);
+
+		for (uint32_t frame_index = 0; frame_index < total_frames; ++frame_index)
+		{
+			std::chrono::steady_clock::time_point frame_begin = std::chrono::steady_clock::now();
+			CPUProfiler::BeginFrame();
+
+			// Warmup frames render from the start of the path
+			uint32_t path_index = frame_index < options.warmup_frames ? 0 : frame_index - options.warmup_frames;
+
+			Renderer::BeginFrameInfo frame_info = {};
+			frame_info.camera_view = GetBenchmarkCameraView(path_index, options.benchmark_frames);
+			frame_info.camera_vfov = BENCHMARK_CAMERA_VFOV;
+			frame_info.skybox_texture_handle = AssetManager::GetAsset<TextureAsset>(data->tex_hdr)->texture_render_handle;
+			Renderer::BeginFrame(frame_info);
+
+			// The GPU timings read back in BeginFrame belong to the frame rendered gpu_timings_latency frames ago
+			if (frame_index >= options.warmup_frames + gpu_timings_latency)
+			{
+				Renderer::GPUFrameTimings gpu_timings = Renderer::GetGPUFrameTimings();
+				samples.gpu_graphics_ms.push_back(gpu_timings.graphics_ms);
+				samples.gpu_async_compute_ms.push_back(gpu_timings.async_compute_ms);
+			}
+
+			data->active_scene.Render();
+
+			Renderer::RenderFrame();
+			Renderer::EndFrame();
+
+			CPUProfiler::EndFrame();
+			std::chrono::duration<double, std::milli> frame_duration = std::chrono::steady_clock::now() - frame_begin;
+
+			bool is_benchmark_frame = frame_index >= options.warmup_frames && path_index < options.benchmark_frames;
+			if (is_benchmark_frame)
+			{
+				samples.cpu_ms.push_back(frame_duration.count());
+
+				if (options.checksum_interval > 0 && path_index % options.checksum_interval == 0)
+					samples.checksums.emplace_back(path_index, Renderer::ReadbackOutputChecksum());
+			}
+		}
+
+		WriteBenchmarkResults(samples);
+		should_close = true;
+	}
+
 	void Run()
 	{
+		if (data->options.headless)
+		{
+			RunBenchmark();
+			return;
+		}
+
 		std::chrono::high_resolution_clock high_res_clock = {};
 		std::chrono::high_resolution_clock::time_point curr_time = high_res_clock.now();
 		std::chrono::high_resolution_clock::time_point prev_time = high_res_clock.now();
@@ -241,10 +430,16 @@ namespace Application
 			curr_time = high_res_clock.now();
 			data->delta_time = curr_time - prev_time;
 
+			CPUProfiler::BeginFrame();
+
+			// Wait for the frame before polling events, so that the input and camera used by the frame are as recent as possible
+			Renderer::WaitForFrame();
 			PollEvents();
 			Update(data->delta_time.count());
 			Render();
 
+			CPUProfiler::EndFrame();
+
 			prev_time = curr_time;
 		}
 	}
@@ -0,0 +1,399 @@
+#include "Precomp.h"
+#include "CPUProfiler.h"
+#include "FileIO.h"
+
+#include "imgui/imgui.h"
+
+namespace CPUProfiler
+{
+
+	static constexpr uint32_t THREAD_BUFFER_CAPACITY = 16384;
+	static constexpr const char* CAPTURE_DIRECTORY = "captures";
+
+	struct ScopeEvent
+	{
+		const char* name = nullptr;
+		int64_t begin_timestamp = 0;
+		int64_t end_timestamp = 0;
+	};
+
+	struct CapturedEvent
+	{
+		ScopeEvent event;
+		uint32_t thread_index = 0;
+	};
+
+	// Single producer single consumer ring buffer, only the owning thread writes and only the main thread reads
+	struct ThreadBuffer
+	{
+		std::array<ScopeEvent, THREAD_BUFFER_CAPACITY> events;
+		std::atomic<uint64_t> write_index = 0;
+		std::atomic<uint64_t> read_index = 0;
+		std::atomic<uint64_t> num_dropped = 0;
+
+		uint32_t thread_index = 0;
+		std::string thread_name;
+	};
+
+	std::atomic<bool> is_recording = false;
+	// Scopes between AcquireRecording and ReleaseRecording, Exit waits for these before freeing the profiler data
+	static std::atomic<uint32_t> num_recording_scopes = 0;
+
+	// Incremented on every Init, so that threads notice their buffer is gone when the application restarts
+	static std::atomic<uint64_t> instance_id = 0;
+	static thread_local ThreadBuffer* thread_buffer = nullptr;
+	static thread_local uint64_t thread_buffer_instance_id = 0;
+
+	struct Data
+	{
+		uint64_t instance_id = 0;
+		std::chrono::steady_clock::time_point epoch;
+
+		std::mutex thread_buffers_mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> thread_buffers;
+
+		int64_t frame_begin_timestamp = 0;
+
+		struct Capture
+		{
+			uint32_t num_frames = 10;
+			uint32_t num_frames_pending = 0;
+			uint32_t num_frames_remaining = 0;
+			std::vector<CapturedEvent> events;
+			std::string last_filepath;
+		} capture;
+
+		struct LiveView
+		{
+			bool enabled = false;
+			// Main thread events of the last frame, sorted by begin timestamp
+			std::vector<ScopeEvent> frame_events;
+			int64_t frame_begin_timestamp = 0;
+			int64_t frame_end_timestamp = 0;
+		} live_view;
+	} static *data;
+
+	static ThreadBuffer* RegisterThread(const std::string& thread_name)
+	{
+		std::scoped_lock lock(data->thread_buffers_mutex);
+
+		ThreadBuffer* buffer = data->thread_buffers.emplace_back(std::make_unique<ThreadBuffer>()).get();
+		buffer->thread_index = static_cast<uint32_t>(data->thread_buffers.size() - 1);
+		buffer->thread_name = thread_name.empty() ? std::format("Thread {}", buffer->thread_index) : thread_name;
+
+		thread_buffer = buffer;
+		thread_buffer_instance_id = data->instance_id;
+
+		return buffer;
+	}
+
+	static void UpdateIsRecording()
+	{
+		is_recording.store(data->capture.num_frames_remaining > 0 || data->live_view.enabled, std::memory_order_release);
+	}
+
+	static std::string EscapeJsonString(const char* str)
+	{
+		std::string escaped;
+		for (const char* c = str; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+				escaped += '\\';
+			escaped += *c;
+		}
+
+		return escaped;
+	}
+
+	static void WriteChromeTrace()
+	{
+		std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		{
+			std::scoped_lock lock(data->thread_buffers_mutex);
+			for (const auto& buffer : data->thread_buffers)
+			{
+				json += std::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}},\n",
+					buffer->thread_index, EscapeJsonString(buffer->thread_name.c_str()));
+			}
+		}
+
+		int64_t capture_begin_timestamp = INT64_MAX;
+		for (const CapturedEvent& captured : data->capture.events)
+		{
+			capture_begin_timestamp = std::min(capture_begin_timestamp, captured.event.begin_timestamp);
+		}
+
+		// Chrome trace timestamps and durations are in microseconds
+		for (size_t i = 0; i < data->capture.events.size(); ++i)
+		{
+			const CapturedEvent& captured = data->capture.events[i];
+			json += std::format("{{\"name\":\"{}\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}{}\n",
+				EscapeJsonString(captured.event.name), captured.thread_index,
+				(captured.event.begin_timestamp - capture_begin_timestamp) / 1000.0,
+				(captured.event.end_timestamp - captured.event.begin_timestamp) / 1000.0,
+				i + 1 < data->capture.events.size() ? "," : "");
+		}
+
+		json += "]}\n";
+
+		auto now = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+		std::filesystem::path filepath = std::filesystem::path(CAPTURE_DIRECTORY) / std::format("cpu_trace_{:%Y%m%d_%H%M%S}.json", now);
+
+		if (FileIO::WriteBinary(filepath, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(json.data()), json.size())))
+		{
+			data->capture.last_filepath = filepath.string();
+			LOG_INFO("CPUProfiler", "Wrote {} events to {}", data->capture.events.size(), data->capture.last_filepath);
+		}
+		else
+		{
+			LOG_WARN("CPUProfiler", "Failed to write capture to {}", filepath.string());
+		}
+
+		data->capture.events.clear();
+		data->capture.events.shrink_to_fit();
+	}
+
+	// Skips everything that was recorded since the last drain, used when recording starts so that no stale scopes end up in the first frame
+	static void DiscardThreadBuffers()
+	{
+		std::scoped_lock lock(data->thread_buffers_mutex);
+		for (const auto& buffer : data->thread_buffers)
+		{
+			buffer->read_index.store(buffer->write_index.load(std::memory_order_acquire), std::memory_order_release);
+		}
+	}
+
+	// Moves all events recorded since the last drain out of the thread buffers
+	static void DrainThreadBuffers()
+	{
+		bool capturing = data->capture.num_frames_remaining > 0;
+		if (data->live_view.enabled)
+			data->live_view.frame_events.clear();
+
+		std::scoped_lock lock(data->thread_buffers_mutex);
+		for (const auto& buffer : data->thread_buffers)
+		{
+			uint64_t read_index = buffer->read_index.load(std::memory_order_relaxed);
+			uint64_t write_index = buffer->write_index.load(std::memory_order_acquire);
+
+			for (; read_index < write_index; ++read_index)
+			{
+				const ScopeEvent& event = buffer->events[read_index % THREAD_BUFFER_CAPACITY];
+
+				if (capturing)
+					data->capture.events.push_back({ event, buffer->thread_index });
+				if (data->live_view.enabled && buffer->thread_index == 0)
+					data->live_view.frame_events.push_back(event);
+			}
+
+			buffer->read_index.store(read_index, std::memory_order_release);
+		}
+	}
+
+	void Init()
+	{
+		data = new Data();
+		data->instance_id = ++instance_id;
+		data->epoch = std::chrono::steady_clock::now();
+
+		RegisterThread("Main Thread");
+	}
+
+	void Exit()
+	{
+		// Sequentially consistent, so that a thread either sees recording stopped in AcquireRecording, or is seen by the wait below
+		is_recording.store(false, std::memory_order_seq_cst);
+		while (num_recording_scopes.load(std::memory_order_seq_cst) > 0)
+		{
+			std::this_thread::yield();
+		}
+
+		delete data;
+		data = nullptr;
+	}
+
+	void BeginFrame()
+	{
+		if (data->capture.num_frames_pending > 0)
+		{
+			data->capture.num_frames_remaining = data->capture.num_frames_pending;
+			data->capture.num_frames_pending = 0;
+			data->capture.events.clear();
+		}
+
+		bool was_recording = is_recording.load(std::memory_order_acquire);
+		UpdateIsRecording();
+
+		if (!was_recording && is_recording.load(std::memory_order_acquire))
+			DiscardThreadBuffers();
+
+		data->frame_begin_timestamp = GetTimestamp();
+	}
+
+	void EndFrame()
+	{
+		if (!is_recording.load(std::memory_order_acquire))
+			return;
+
+		int64_t frame_end_timestamp = GetTimestamp();
+		RecordScope("Frame", data->frame_begin_timestamp, frame_end_timestamp);
+
+		DrainThreadBuffers();
+
+		if (data->live_view.enabled)
+		{
+			// Parents are recorded after their children, so sort them back into begin order for the flame view
+			std::sort(data->live_view.frame_events.begin(), data->live_view.frame_events.end(), [](const ScopeEvent& lhs, const ScopeEvent& rhs) {
+				return lhs.begin_timestamp < rhs.begin_timestamp || (lhs.begin_timestamp == rhs.begin_timestamp && lhs.end_timestamp > rhs.end_timestamp);
+			});
+			data->live_view.frame_begin_timestamp = data->frame_begin_timestamp;
+			data->live_view.frame_end_timestamp = frame_end_timestamp;
+		}
+
+		if (data->capture.num_frames_remaining > 0 && --data->capture.num_frames_remaining == 0)
+		{
+			WriteChromeTrace();
+		}
+
+		UpdateIsRecording();
+	}
+
+	void StartCapture()
+	{
+		if (data->capture.num_frames_remaining > 0)
+			return;
+
+		data->capture.num_frames_pending = data->capture.num_frames;
+		LOG_INFO("CPUProfiler", "Capturing {} frames", data->capture.num_frames);
+	}
+
+	void RenderUI()
+	{
+		if (ImGui::Begin("CPU Profiler"))
+		{
+			bool capturing = data->capture.num_frames_pending > 0 || data->capture.num_frames_remaining > 0;
+
+			ImGui::BeginDisabled(capturing);
+			ImGui::SliderInt("Capture frames", (int*)&data->capture.num_frames, 1, 300);
+			if (ImGui::Button("Capture (F2)"))
+			{
+				StartCapture();
+			}
+			ImGui::EndDisabled();
+
+			if (capturing)
+				ImGui::Text("Capturing, %u frames remaining", data->capture.num_frames_remaining);
+			else if (!data->capture.last_filepath.empty())
+				ImGui::Text("Last capture: %s", data->capture.last_filepath.c_str());
+
+			uint64_t num_dropped = 0;
+			{
+				std::scoped_lock lock(data->thread_buffers_mutex);
+				for (const auto& buffer : data->thread_buffers)
+				{
+					num_dropped += buffer->num_dropped.load(std::memory_order_relaxed);
+				}
+			}
+			if (num_dropped > 0)
+			{
+				ImGui::Text("Dropped events: %llu", (unsigned long long)num_dropped);
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::SetTooltip("Events are dropped when a thread records more than %u scopes in a single frame", THREAD_BUFFER_CAPACITY);
+				}
+			}
+
+			ImGui::Checkbox("Live view", &data->live_view.enabled);
+			if (ImGui::IsItemHovered())
+			{
+				ImGui::SetTooltip("If enabled, records every frame and shows the scopes of the main thread for the last frame");
+			}
+
+			int64_t frame_duration = data->live_view.frame_end_timestamp - data->live_view.frame_begin_timestamp;
+			if (data->live_view.enabled && frame_duration > 0)
+			{
+				ImGui::Text("Frame: %.3f ms", frame_duration / 1000000.0);
+
+				constexpr float ROW_HEIGHT = 20.0f;
+				ImDrawList* draw_list = ImGui::GetWindowDrawList();
+				ImVec2 origin = ImGui::GetCursorScreenPos();
+				float width = ImGui::GetContentRegionAvail().x;
+				float ns_to_pixels = width / static_cast<float>(frame_duration);
+
+				// The depth of a scope is the number of scopes on the stack that still contain it
+				std::vector<int64_t> end_timestamp_stack;
+				uint32_t max_depth = 0;
+
+				for (const ScopeEvent& event : data->live_view.frame_events)
+				{
+					while (!end_timestamp_stack.empty() && end_timestamp_stack.back() <= event.begin_timestamp)
+						end_timestamp_stack.pop_back();
+
+					uint32_t depth = static_cast<uint32_t>(end_timestamp_stack.size());
+					end_timestamp_stack.push_back(event.end_timestamp);
+					max_depth = std::max(max_depth, depth + 1);
+
+					ImVec2 min = ImVec2(origin.x + (event.begin_timestamp - data->live_view.frame_begin_timestamp) * ns_to_pixels, origin.y + depth * ROW_HEIGHT);
+					ImVec2 max = ImVec2(origin.x + (event.end_timestamp - data->live_view.frame_begin_timestamp) * ns_to_pixels, min.y + ROW_HEIGHT - 1.0f);
+					max.x = std::max(max.x, min.x + 1.0f);
+
+					uint64_t name_hash = HashBytes(event.name, strlen(event.name));
+					ImU32 color = IM_COL32(96 + (name_hash & 0x7f), 96 + ((name_hash >> 8) & 0x7f), 96 + ((name_hash >> 16) & 0x7f), 255);
+					draw_list->AddRectFilled(min, max, color);
+					draw_list->PushClipRect(min, max, true);
+					draw_list->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32(0, 0, 0, 255), event.name);
+					draw_list->PopClipRect();
+
+					if (ImGui::IsMouseHoveringRect(min, max))
+					{
+						ImGui::SetTooltip("%s: %.3f ms", event.name, (event.end_timestamp - event.begin_timestamp) / 1000000.0);
+					}
+				}
+
+				ImGui::Dummy(ImVec2(width, max_depth * ROW_HEIGHT));
+			}
+		}
+		ImGui::End();
+	}
+
+	int64_t GetTimestamp()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - data->epoch).count();
+	}
+
+	bool AcquireRecording()
+	{
+		num_recording_scopes.fetch_add(1, std::memory_order_seq_cst);
+		if (is_recording.load(std::memory_order_seq_cst))
+			return true;
+
+		num_recording_scopes.fetch_sub(1, std::memory_order_release);
+		return false;
+	}
+
+	void ReleaseRecording()
+	{
+		num_recording_scopes.fetch_sub(1, std::memory_order_release);
+	}
+
+	void RecordScope(const char* name, int64_t begin_timestamp, int64_t end_timestamp)
+	{
+		ThreadBuffer* buffer = thread_buffer;
+		if (!buffer || thread_buffer_instance_id != data->instance_id)
+			buffer = RegisterThread("");
+
+		uint64_t write_index = buffer->write_index.load(std::memory_order_relaxed);
+		uint64_t read_index = buffer->read_index.load(std::memory_order_acquire);
+
+		if (write_index - read_index >= THREAD_BUFFER_CAPACITY)
+		{
+			buffer->num_dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		buffer->events[write_index % THREAD_BUFFER_CAPACITY] = { name, begin_timestamp, end_timestamp };
+		buffer->write_index.store(write_index + 1, std::memory_order_release);
+	}
+
+}
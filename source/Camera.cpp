@@ -40,7 +40,7 @@ void Camera::Update(float dt)
 		double scroll_x, scroll_y;
 		Input::GetScrollRel(scroll_x, scroll_y);
 
-		m_speed += scroll_y * std::max(std::sqrtf(m_speed), 0.005f);
+		m_speed += scroll_y * std::max(std::sqrt(m_speed), 0.005f);
 		m_speed = std::max(m_speed, 0.0f);
 	}
 
@@ -61,3 +61,15 @@ float Camera::GetVerticalFOV() const
 {
 	return m_vfov;
 }
+
+void Camera::GetViewRay(float screen_x, float screen_y, float aspect_ratio, glm::vec3& origin, glm::vec3& direction) const
+{
+	glm::mat4 camera_transform = glm::inverse(m_view);
+	float tan_half_vfov = std::tan(glm::radians(m_vfov) * 0.5f);
+
+	// The camera looks down its negative z axis
+	glm::vec3 view_direction = glm::vec3(screen_x * tan_half_vfov * aspect_ratio, -screen_y * tan_half_vfov, -1.0f);
+
+	origin = glm::vec3(camera_transform[3]);
+	direction = glm::normalize(glm::vec3(camera_transform * glm::vec4(view_direction, 0.0f)));
+}
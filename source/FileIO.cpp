@@ -41,4 +41,40 @@ namespace FileIO
 		return result;
 	}
 
+	bool ReadBinary(const std::filesystem::path& filepath, std::vector<uint8_t>& bytes)
+	{
+		std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return false;
+
+		std::streamsize num_bytes = file.tellg();
+		file.seekg(0, std::ios::beg);
+
+		bytes.resize(num_bytes);
+		if (!file.read(reinterpret_cast<char*>(bytes.data()), num_bytes))
+		{
+			LOG_WARN("FileIO::ReadBinary", "Failed to read file: {}", filepath.string());
+			bytes.clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool WriteBinary(const std::filesystem::path& filepath, std::span<const uint8_t> bytes)
+	{
+		std::error_code error;
+		if (filepath.has_parent_path())
+			std::filesystem::create_directories(filepath.parent_path(), error);
+
+		std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open() || !file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size()))
+		{
+			LOG_WARN("FileIO::WriteBinary", "Failed to write file: {}", filepath.string());
+			return false;
+		}
+
+		return true;
+	}
+
 }
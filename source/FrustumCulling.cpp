@@ -0,0 +1,169 @@
+#include "Precomp.h"
+#include "FrustumCulling.h"
+
+#include <bit>
+
+// AVX2 is only used when the compiler targets it (/arch:AVX2), otherwise the SSE kernel is used on x64
+#if defined(__AVX2__)
+#define FRUSTUM_CULLING_AVX2 1
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(__SSE2__)
+#define FRUSTUM_CULLING_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace FrustumCulling
+{
+
+	static bool IsSphereCulled(const Frustum& frustum, float x, float y, float z, float radius)
+	{
+		for (const glm::vec4& plane : frustum.planes)
+		{
+			if (plane.x * x + plane.y * y + plane.z * z + plane.w < -radius)
+				return true;
+		}
+
+		return false;
+	}
+
+	// Appends first + the index of every set bit in the visible mask
+	static uint32_t AppendVisibleIndices(uint32_t visible_mask, uint32_t first, uint32_t* visible_indices)
+	{
+		uint32_t num_visible = 0;
+		while (visible_mask)
+		{
+			visible_indices[num_visible++] = first + (uint32_t)std::countr_zero(visible_mask);
+			visible_mask &= visible_mask - 1;
+		}
+
+		return num_visible;
+	}
+
+	uint32_t CullSpheres(const Frustum& frustum, const BoundingSpheres& spheres, uint32_t first, uint32_t count, uint32_t* visible_indices)
+	{
+		uint32_t num_visible = 0;
+		uint32_t index = first;
+		uint32_t end = first + count;
+
+		// The plane distances are summed in the same order as in the scalar version, and the culled lanes are accumulated with a less-than compare,
+		// so that spheres with NaN coordinates are kept, like in the scalar version
+#if FRUSTUM_CULLING_AVX2
+		__m256 plane_x[Frustum::PLANE_NUM_PLANES], plane_y[Frustum::PLANE_NUM_PLANES], plane_z[Frustum::PLANE_NUM_PLANES], plane_w[Frustum::PLANE_NUM_PLANES];
+		for (uint32_t i = 0; i < Frustum::PLANE_NUM_PLANES; ++i)
+		{
+			plane_x[i] = _mm256_set1_ps(frustum.planes[i].x);
+			plane_y[i] = _mm256_set1_ps(frustum.planes[i].y);
+			plane_z[i] = _mm256_set1_ps(frustum.planes[i].z);
+			plane_w[i] = _mm256_set1_ps(frustum.planes[i].w);
+		}
+
+		for (; index + 8 <= end; index += 8)
+		{
+			__m256 x = _mm256_loadu_ps(&spheres.x[index]);
+			__m256 y = _mm256_loadu_ps(&spheres.y[index]);
+			__m256 z = _mm256_loadu_ps(&spheres.z[index]);
+			__m256 negative_radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&spheres.radius[index]));
+
+			__m256 culled = _mm256_setzero_ps();
+			for (uint32_t i = 0; i < Frustum::PLANE_NUM_PLANES; ++i)
+			{
+				__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane_x[i], x), _mm256_mul_ps(plane_y[i], y)),
+					_mm256_mul_ps(plane_z[i], z)), plane_w[i]);
+				culled = _mm256_or_ps(culled, _mm256_cmp_ps(distance, negative_radius, _CMP_LT_OQ));
+			}
+
+			uint32_t visible_mask = ~(uint32_t)_mm256_movemask_ps(culled) & 0xFF;
+			num_visible += AppendVisibleIndices(visible_mask, index, visible_indices + num_visible);
+		}
+#elif FRUSTUM_CULLING_SSE
+		__m128 plane_x[Frustum::PLANE_NUM_PLANES], plane_y[Frustum::PLANE_NUM_PLANES], plane_z[Frustum::PLANE_NUM_PLANES], plane_w[Frustum::PLANE_NUM_PLANES];
+		for (uint32_t i = 0; i < Frustum::PLANE_NUM_PLANES; ++i)
+		{
+			plane_x[i] = _mm_set1_ps(frustum.planes[i].x);
+			plane_y[i] = _mm_set1_ps(frustum.planes[i].y);
+			plane_z[i] = _mm_set1_ps(frustum.planes[i].z);
+			plane_w[i] = _mm_set1_ps(frustum.planes[i].w);
+		}
+
+		for (; index + 4 <= end; index += 4)
+		{
+			__m128 x = _mm_loadu_ps(&spheres.x[index]);
+			__m128 y = _mm_loadu_ps(&spheres.y[index]);
+			__m128 z = _mm_loadu_ps(&spheres.z[index]);
+			__m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[index]));
+
+			__m128 culled = _mm_setzero_ps();
+			for (uint32_t i = 0; i < Frustum::PLANE_NUM_PLANES; ++i)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x[i], x), _mm_mul_ps(plane_y[i], y)),
+					_mm_mul_ps(plane_z[i], z)), plane_w[i]);
+				culled = _mm_or_ps(culled, _mm_cmplt_ps(distance, negative_radius));
+			}
+
+			uint32_t visible_mask = ~(uint32_t)_mm_movemask_ps(culled) & 0xF;
+			num_visible += AppendVisibleIndices(visible_mask, index, visible_indices + num_visible);
+		}
+#endif
+
+		// Remaining spheres that do not fill a whole SIMD register
+		for (; index < end; ++index)
+		{
+			if (!IsSphereCulled(frustum, spheres.x[index], spheres.y[index], spheres.z[index], spheres.radius[index]))
+				visible_indices[num_visible++] = index;
+		}
+
+		return num_visible;
+	}
+
+	uint32_t CullSpheresScalar(const Frustum& frustum, const BoundingSpheres& spheres, uint32_t first, uint32_t count, uint32_t* visible_indices)
+	{
+		uint32_t num_visible = 0;
+		for (uint32_t index = first; index < first + count; ++index)
+		{
+			if (!IsSphereCulled(frustum, spheres.x[index], spheres.y[index], spheres.z[index], spheres.radius[index]))
+				visible_indices[num_visible++] = index;
+		}
+
+		return num_visible;
+	}
+
+	uint32_t CullSpheresParallel(const Frustum& frustum, const BoundingSpheres& spheres, uint32_t count, uint32_t* visible_indices, uint32_t max_threads)
+	{
+		PROFILE_FUNCTION();
+
+		uint32_t num_threads = std::clamp((count + MIN_SPHERES_PER_THREAD - 1) / MIN_SPHERES_PER_THREAD, 1u, std::max(max_threads, 1u));
+		if (num_threads == 1)
+			return CullSpheres(frustum, spheres, 0, count, visible_indices);
+
+		// Every range writes its visible indices to the start of its own part of visible_indices, since it can never have more visible spheres
+		// than it has spheres, the ranges are then moved down in order to close the gaps between them
+		uint32_t range_size = (count + num_threads - 1) / num_threads;
+		std::vector<uint32_t> num_visible_per_range(num_threads, 0);
+
+		auto cull_range = [&](uint32_t range_index)
+		{
+			uint32_t first = range_index * range_size;
+			uint32_t range_count = std::min(range_size, count - first);
+			num_visible_per_range[range_index] = CullSpheres(frustum, spheres, first, range_count, visible_indices + first);
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(num_threads - 1);
+		for (uint32_t range_index = 1; range_index < num_threads; ++range_index)
+			threads.emplace_back(cull_range, range_index);
+
+		cull_range(0);
+		for (std::thread& thread : threads)
+			thread.join();
+
+		uint32_t num_visible = num_visible_per_range[0];
+		for (uint32_t range_index = 1; range_index < num_threads; ++range_index)
+		{
+			memmove(visible_indices + num_visible, visible_indices + range_index * range_size, num_visible_per_range[range_index] * sizeof(uint32_t));
+			num_visible += num_visible_per_range[range_index];
+		}
+
+		return num_visible;
+	}
+
+}
@@ -47,6 +47,7 @@ namespace Input
 		{
 			{ GLFW_MOUSE_BUTTON_LEFT, Button::Button_LeftMouse },
 			{ GLFW_MOUSE_BUTTON_RIGHT, Button::Button_RightMouse },
+			{ GLFW_MOUSE_BUTTON_MIDDLE, Button::Button_MiddleMouse },
 		};
 		std::unordered_map<Button, State> button_states;
 
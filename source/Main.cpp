@@ -1,16 +1,87 @@
 #include "Precomp.h"
 #include "Application.h"
 
+#include <charconv>
+
+static bool ParseUint(const char* arg, uint32_t& value)
+{
+	const char* arg_end = arg + strlen(arg);
+	auto [ptr, error] = std::from_chars(arg, arg_end, value);
+
+	return error == std::errc() && ptr == arg_end;
+}
+
+// Usage: VulkanRenderer [--headless] [--width N] [--height N] [--warmup N] [--frames N] [--checksums N] [--output FILE] [--scene FILE]
+static Application::Options ParseOptions(int argc, char* argv[])
+{
+	Application::Options options = {};
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		bool parsed = true;
+		if (arg == "--headless")
+		{
+			options.headless = true;
+			continue;
+		}
+		else if (arg == "--width")
+			parsed = value && ParseUint(value, options.width);
+		else if (arg == "--height")
+			parsed = value && ParseUint(value, options.height);
+		else if (arg == "--warmup")
+			parsed = value && ParseUint(value, options.warmup_frames);
+		else if (arg == "--frames")
+			parsed = value && ParseUint(value, options.benchmark_frames);
+		else if (arg == "--checksums")
+			parsed = value && ParseUint(value, options.checksum_interval);
+		else if (arg == "--output")
+		{
+			parsed = value != nullptr;
+			if (parsed)
+				options.output_filepath = value;
+		}
+		else if (arg == "--scene")
+		{
+			parsed = value != nullptr;
+			if (parsed)
+				options.scene_filepath = value;
+		}
+		else
+		{
+			LOG_WARN("Main", "Unknown argument: {}", arg);
+			continue;
+		}
+
+		if (!parsed)
+			LOG_WARN("Main", "Missing or invalid value for argument: {}", arg);
+
+		// Skip the value
+		i++;
+	}
+
+	if (options.width == 0 || options.height == 0)
+	{
+		LOG_WARN("Main", "Invalid resolution {}x{}, falling back to the default", options.width, options.height);
+		options.width = Application::Options().width;
+		options.height = Application::Options().height;
+	}
+
+	return options;
+}
+
 int main(int argc, char* argv[])
 {
-	(void)argc; (void)argv;
+	Application::Options options = ParseOptions(argc, argv);
 
 	while (!Application::ShouldClose())
 	{
-		Application::Init();
+		Application::Init(options);
 		Application::Run();
 		Application::Exit();
 	}
 
 	return 0;
-}
\ No newline at end of file
+}
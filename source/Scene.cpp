@@ -1,9 +1,137 @@
 #include "Precomp.h"
 #include "Scene.h"
-#include "Entity.h"
+#include "renderer/Renderer.h"
+#include "assets/AssetTypes.h"
+#include "assets/AssetManager.h"
+#include "FileIO.h"
 
 #include "imgui/imgui.h"
 
+/*
+
+	Scene file layout, all values are little-endian and every array starts at an 8 byte aligned offset:
+	- Header
+	- Entities, in depth-first hierarchy order, so parents always come before their children
+	- Meshes
+	- Area lights
+	- Names of all entities, not null terminated
+
+	Every record is trivially copyable, so loading reads the file once and walks the arrays in place
+
+*/
+
+namespace SceneFile
+{
+
+	static constexpr uint32_t MAGIC = 0x4E435356; // "VSCN"
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint32_t INVALID_INDEX = ~0u;
+
+	struct Header
+	{
+		uint32_t magic = MAGIC;
+		uint32_t version = VERSION;
+		uint32_t num_entities = 0;
+		uint32_t num_meshes = 0;
+		uint32_t num_area_lights = 0;
+		uint32_t num_name_bytes = 0;
+	};
+
+	struct Entity
+	{
+		// Both are stored, so that loading does not have to decompose the local transform into the editable transform
+		glm::mat4 local_transform;
+		TransformComponent transform;
+
+		uint32_t parent_index = INVALID_INDEX;
+		uint32_t name_offset = 0;
+		uint32_t name_length = 0;
+	};
+
+	struct Mesh
+	{
+		uint64_t model_handle = AssetHandle().value;
+		uint32_t entity_index = 0;
+		uint32_t node_index = 0;
+		uint32_t node_mesh_index = 0;
+
+		// Material parameters override the ones from the model, textures always come from the model
+		uint32_t has_clearcoat = 0;
+		glm::vec4 albedo_factor = glm::vec4(1.0f);
+		float metallic_factor = 1.0f;
+		float roughness_factor = 1.0f;
+		float clearcoat_alpha_factor = 1.0f;
+		float clearcoat_roughness_factor = 1.0f;
+	};
+
+	struct AreaLight
+	{
+		uint64_t texture_handle = AssetHandle().value;
+		uint32_t entity_index = 0;
+		glm::vec3 color = glm::vec3(1.0f);
+		float intensity = 1.0f;
+		uint32_t two_sided = 0;
+	};
+
+	static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<Entity> &&
+		std::is_trivially_copyable_v<Mesh> && std::is_trivially_copyable_v<AreaLight>, "Scene file records need to be trivially copyable");
+
+	static constexpr size_t ARRAY_ALIGNMENT = 8;
+
+	static size_t AlignUp(size_t offset)
+	{
+		return (size_t)VK_ALIGN_POW2(offset, ARRAY_ALIGNMENT);
+	}
+
+	struct Layout
+	{
+		size_t entities_offset = 0;
+		size_t meshes_offset = 0;
+		size_t area_lights_offset = 0;
+		size_t names_offset = 0;
+		size_t num_bytes = 0;
+	};
+
+	static Layout GetLayout(const Header& header)
+	{
+		Layout layout = {};
+		layout.entities_offset = AlignUp(sizeof(Header));
+		layout.meshes_offset = AlignUp(layout.entities_offset + header.num_entities * sizeof(Entity));
+		layout.area_lights_offset = AlignUp(layout.meshes_offset + header.num_meshes * sizeof(Mesh));
+		layout.names_offset = AlignUp(layout.area_lights_offset + header.num_area_lights * sizeof(AreaLight));
+		layout.num_bytes = layout.names_offset + header.num_name_bytes;
+
+		return layout;
+	}
+
+	static std::string EscapeJsonString(std::string_view string)
+	{
+		std::string escaped;
+		escaped.reserve(string.size());
+
+		for (char c : string)
+		{
+			switch (c)
+			{
+			case '"': escaped += "\\\""; break;
+			case '\\': escaped += "\\\\"; break;
+			case '\n': escaped += "\\n"; break;
+			case '\r': escaped += "\\r"; break;
+			case '\t': escaped += "\\t"; break;
+			default:
+				if ((unsigned char)c < 0x20)
+					escaped += std::format("\\u{:04x}", (uint32_t)c);
+				else
+					escaped += c;
+				break;
+			}
+		}
+
+		return escaped;
+	}
+
+}
+
 Scene::Scene()
 {
 	m_active_camera = Camera(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), 60.0f);
@@ -11,20 +139,21 @@ Scene::Scene()
 
 void Scene::Update(float dt)
 {
-	m_active_camera.Update(dt);
+	PROFILE_FUNCTION();
 
-	for (auto& entity : m_entities)
-	{
-		entity->Update(dt);
-	}
+	m_active_camera.Update(dt);
 }
 
 void Scene::Render()
 {
-	for (auto& entity : m_entities)
-	{
-		entity->Render();
-	}
+	PROFILE_FUNCTION();
+
+	// World transforms are brought up to date right before they are used, so that every change made since the last frame is picked up
+	m_transform_hierarchy.Update();
+	UpdateBounds();
+
+	RenderMeshes();
+	RenderAreaLights();
 }
 
 void Scene::RenderUI()
@@ -39,11 +168,11 @@ void Scene::RenderUI()
 				{
 					if (ImGui::MenuItem("Mesh"))
 					{
-						AddEntity<MeshObject>("Mesh");
+						CreateMeshEntity("Mesh", RenderResourceHandle(), Renderer::CreateMaterial(MaterialAsset()), glm::identity<glm::mat4>());
 					}
 					if (ImGui::MenuItem("AreaLight"))
 					{
-						AddEntity<AreaLight>("AreaLight");
+						CreateAreaLightEntity("AreaLight", AssetHandle(), glm::identity<glm::mat4>(), glm::vec3(1.0f), 5.0f, true);
 					}
 					ImGui::EndMenu();
 				}
@@ -54,18 +183,532 @@ void Scene::RenderUI()
 			ImGui::EndMenuBar();
 		}
 
+		ImGui::Text("Bounding volume hierarchy: %zu entities, height %u", m_bounding_volume_hierarchy.GetSize(), m_bounding_volume_hierarchy.GetHeight());
+
+		const EntityInfo* selected_entity_info = m_entities.Find(m_selected_entity);
+		ImGui::Text("Selected entity: %s (middle mouse to pick)", selected_entity_info ? selected_entity_info->name.c_str() : "None");
+
 		// Scene Hierarchy UI
+		if (m_reveal_selected_entity)
+			ImGui::SetNextItemOpen(true);
+
 		if (ImGui::CollapsingHeader("Scene Hierarchy"))
 		{
-			for (auto& entity : m_entities)
+			m_transform_hierarchy.ForEachRoot([this](EntityHandle entity)
 			{
-				entity->RenderUI();
-			}
+				RenderEntityUI(entity);
+			});
+			m_reveal_selected_entity = false;
 		}
 	}
 	ImGui::End();
 }
 
+EntityHandle Scene::CreateEntity(const std::string& name, const glm::mat4& transform, EntityHandle parent)
+{
+	EntityHandle entity = m_entities.Insert({ .name = name });
+
+	m_transforms.Add(entity);
+	m_transform_hierarchy.Insert(entity, parent, transform);
+	SetLocalTransform(entity, transform);
+
+	return entity;
+}
+
+EntityHandle Scene::CreateMeshEntity(const std::string& name, RenderResourceHandle mesh_handle, RenderResourceHandle material_handle,
+	const glm::mat4& transform, EntityHandle parent)
+{
+	EntityHandle entity = CreateEntity(name, transform, parent);
+	m_meshes.Add(entity, mesh_handle, material_handle);
+
+	return entity;
+}
+
+EntityHandle Scene::CreateModelEntity(AssetHandle model_handle, const glm::mat4& transform, EntityHandle parent)
+{
+	const ModelAsset* model_asset = AssetManager::GetAsset<ModelAsset>(model_handle);
+	if (!model_asset)
+		return EntityHandle();
+
+	EntityHandle model_entity = CreateEntity(model_asset->filepath.stem().string(), transform, parent);
+
+	for (uint32_t i = 0; i < model_asset->root_nodes.size(); ++i)
+	{
+		CreateModelNodeEntity(*model_asset, model_handle, model_asset->root_nodes[i], model_entity);
+	}
+
+	return model_entity;
+}
+
+EntityHandle Scene::CreateAreaLightEntity(const std::string& name, AssetHandle texture_handle, const glm::mat4& transform,
+	const glm::vec3& color, float intensity, bool two_sided, EntityHandle parent)
+{
+	RenderResourceHandle texture_render_handle;
+	if (const TextureAsset* texture_asset = AssetManager::GetAsset<TextureAsset>(texture_handle))
+		texture_render_handle = texture_asset->texture_render_handle;
+
+	EntityHandle entity = CreateEntity(name, transform, parent);
+	m_area_lights.Add(entity, texture_handle, texture_render_handle, color, intensity, two_sided);
+
+	return entity;
+}
+
+void Scene::DestroyEntity(EntityHandle entity)
+{
+	if (!m_entities.Find(entity))
+		return;
+
+	m_destroyed_entities.clear();
+	m_transform_hierarchy.Remove(entity, m_destroyed_entities);
+
+	for (EntityHandle destroyed_entity : m_destroyed_entities)
+	{
+		MeshComponent* mesh = m_meshes.Find(destroyed_entity);
+		if (mesh)
+		{
+			Renderer::DestroyMaterial(mesh->material_handle);
+		}
+
+		m_transforms.Remove(destroyed_entity);
+		m_meshes.Remove(destroyed_entity);
+		m_area_lights.Remove(destroyed_entity);
+		m_bounding_volume_hierarchy.Remove(destroyed_entity);
+
+		m_entities.Delete(destroyed_entity);
+	}
+}
+
+void Scene::Clear()
+{
+	for (const MeshComponent& mesh : m_meshes.GetComponents())
+	{
+		Renderer::DestroyMaterial(mesh.material_handle);
+	}
+
+	// Entities are collected first, since the slotmap can not be changed while iterating over it
+	m_destroyed_entities.clear();
+	m_entities.ForEach([this](EntityHandle entity, EntityInfo&)
+	{
+		m_destroyed_entities.push_back(entity);
+	});
+
+	for (EntityHandle entity : m_destroyed_entities)
+	{
+		m_entities.Delete(entity);
+	}
+
+	m_transforms = {};
+	m_transform_hierarchy = {};
+	m_meshes = {};
+	m_area_lights = {};
+	m_bounding_volume_hierarchy = {};
+}
+
+bool Scene::SaveToFile(const std::filesystem::path& filepath)
+{
+	PROFILE_FUNCTION();
+
+	std::vector<uint8_t> bytes = Serialize();
+	uint64_t hash = HashBytes(bytes.data(), bytes.size());
+
+	// Compare against the file on disk as well, so a file that was changed or deleted by something else is still written
+	if (filepath == m_saved_filepath && hash == m_saved_hash && std::filesystem::exists(filepath) &&
+		std::filesystem::file_size(filepath) == bytes.size())
+	{
+		LOG_INFO("Scene::SaveToFile", "Scene did not change since the last save, skipped writing {}", filepath.string());
+		return true;
+	}
+
+	if (!FileIO::WriteBinary(filepath, bytes))
+		return false;
+
+	m_saved_filepath = filepath;
+	m_saved_hash = hash;
+
+	LOG_INFO("Scene::SaveToFile", "Saved scene with {} entities to {}", GetNumEntities(), filepath.string());
+	return true;
+}
+
+bool Scene::LoadFromFile(const std::filesystem::path& filepath)
+{
+	PROFILE_FUNCTION();
+
+	std::vector<uint8_t> bytes;
+	if (!FileIO::ReadBinary(filepath, bytes))
+	{
+		LOG_WARN("Scene::LoadFromFile", "Failed to read scene file: {}", filepath.string());
+		return false;
+	}
+
+	if (!Deserialize(bytes))
+	{
+		LOG_WARN("Scene::LoadFromFile", "Invalid scene file: {}", filepath.string());
+		return false;
+	}
+
+	m_saved_filepath = filepath;
+	m_saved_hash = HashBytes(bytes.data(), bytes.size());
+
+	LOG_INFO("Scene::LoadFromFile", "Loaded scene with {} entities from {}", GetNumEntities(), filepath.string());
+	return true;
+}
+
+bool Scene::ExportToJson(const std::filesystem::path& filepath) const
+{
+	PROFILE_FUNCTION();
+
+	// Goes through the serialized scene, so the JSON always contains exactly what a scene file would
+	std::vector<uint8_t> bytes = Serialize();
+
+	SceneFile::Header header = {};
+	memcpy(&header, bytes.data(), sizeof(header));
+	SceneFile::Layout layout = SceneFile::GetLayout(header);
+
+	const SceneFile::Entity* entities = reinterpret_cast<const SceneFile::Entity*>(bytes.data() + layout.entities_offset);
+	const SceneFile::Mesh* meshes = reinterpret_cast<const SceneFile::Mesh*>(bytes.data() + layout.meshes_offset);
+	const SceneFile::AreaLight* area_lights = reinterpret_cast<const SceneFile::AreaLight*>(bytes.data() + layout.area_lights_offset);
+	const char* names = reinterpret_cast<const char*>(bytes.data() + layout.names_offset);
+
+	auto vec3_to_json = [](const glm::vec3& v)
+	{
+		return std::format("[{},{},{}]", v.x, v.y, v.z);
+	};
+
+	// One entity, mesh or light per line, so that a diff shows exactly which ones changed
+	std::string json = "{\n";
+	json += std::format("\t\"version\": {},\n", header.version);
+
+	json += "\t\"entities\": [\n";
+	for (uint32_t i = 0; i < header.num_entities; ++i)
+	{
+		const SceneFile::Entity& entity = entities[i];
+		std::string_view name(names + entity.name_offset, entity.name_length);
+
+		json += std::format("\t\t{{\"index\":{},\"name\":\"{}\",\"parent\":{},\"translation\":{},\"rotation\":{},\"scale\":{}}}{}\n",
+			i, SceneFile::EscapeJsonString(name), entity.parent_index == SceneFile::INVALID_INDEX ? -1 : (int64_t)entity.parent_index,
+			vec3_to_json(entity.transform.translation), vec3_to_json(entity.transform.rotation), vec3_to_json(entity.transform.scale),
+			i + 1 < header.num_entities ? "," : "");
+	}
+	json += "\t],\n";
+
+	// Asset handles are written as strings, since JSON parsers commonly read numbers as doubles, which cannot hold all 64 bits
+	json += "\t\"meshes\": [\n";
+	for (uint32_t i = 0; i < header.num_meshes; ++i)
+	{
+		const SceneFile::Mesh& mesh = meshes[i];
+		json += std::format("\t\t{{\"entity\":{},\"model\":\"{:016x}\",\"node\":{},\"node_mesh\":{},\"albedo_factor\":[{},{},{},{}],"
+			"\"metallic_factor\":{},\"roughness_factor\":{},\"has_clearcoat\":{},\"clearcoat_alpha_factor\":{},\"clearcoat_roughness_factor\":{}}}{}\n",
+			mesh.entity_index, mesh.model_handle, mesh.node_index, mesh.node_mesh_index,
+			mesh.albedo_factor.x, mesh.albedo_factor.y, mesh.albedo_factor.z, mesh.albedo_factor.w,
+			mesh.metallic_factor, mesh.roughness_factor, mesh.has_clearcoat != 0, mesh.clearcoat_alpha_factor, mesh.clearcoat_roughness_factor,
+			i + 1 < header.num_meshes ? "," : "");
+	}
+	json += "\t],\n";
+
+	json += "\t\"area_lights\": [\n";
+	for (uint32_t i = 0; i < header.num_area_lights; ++i)
+	{
+		const SceneFile::AreaLight& area_light = area_lights[i];
+		json += std::format("\t\t{{\"entity\":{},\"texture\":\"{:016x}\",\"color\":{},\"intensity\":{},\"two_sided\":{}}}{}\n",
+			area_light.entity_index, area_light.texture_handle, vec3_to_json(area_light.color), area_light.intensity, area_light.two_sided != 0,
+			i + 1 < header.num_area_lights ? "," : "");
+	}
+	json += "\t]\n}\n";
+
+	if (!FileIO::WriteBinary(filepath, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(json.data()), json.size())))
+		return false;
+
+	LOG_INFO("Scene::ExportToJson", "Exported scene with {} entities to {}", header.num_entities, filepath.string());
+	return true;
+}
+
+std::vector<uint8_t> Scene::Serialize() const
+{
+	PROFILE_FUNCTION();
+
+	SceneFile::Header header = {};
+	header.num_entities = (uint32_t)m_transform_hierarchy.GetSize();
+	header.num_meshes = (uint32_t)m_meshes.GetSize();
+	header.num_area_lights = (uint32_t)m_area_lights.GetSize();
+
+	std::vector<SceneFile::Entity> entities;
+	entities.reserve(header.num_entities);
+	std::string names;
+
+	// Entities are referenced by their position in the file, indexed by entity index
+	std::vector<uint32_t> entity_to_file_index;
+
+	m_transform_hierarchy.ForEach([&](EntityHandle entity, EntityHandle parent)
+	{
+		const EntityInfo* entity_info = m_entities.Find(entity);
+		const TransformComponent* transform = m_transforms.Find(entity);
+		VK_ASSERT(entity_info && transform && "Entity in the transform hierarchy does not exist or has no transform");
+
+		if (entity.index >= entity_to_file_index.size())
+			entity_to_file_index.resize(entity.index + 1, SceneFile::INVALID_INDEX);
+		entity_to_file_index[entity.index] = (uint32_t)entities.size();
+
+		SceneFile::Entity& file_entity = entities.emplace_back();
+		file_entity.local_transform = *m_transform_hierarchy.GetLocalTransform(entity);
+		file_entity.transform = *transform;
+		file_entity.parent_index = VK_RESOURCE_HANDLE_VALID(parent) ? entity_to_file_index[parent.index] : SceneFile::INVALID_INDEX;
+		file_entity.name_offset = (uint32_t)names.size();
+		file_entity.name_length = (uint32_t)entity_info->name.size();
+
+		names += entity_info->name;
+	});
+	header.num_name_bytes = (uint32_t)names.size();
+
+	SceneFile::Layout layout = SceneFile::GetLayout(header);
+	std::vector<uint8_t> bytes(layout.num_bytes, 0);
+
+	memcpy(bytes.data(), &header, sizeof(header));
+	memcpy(bytes.data() + layout.entities_offset, entities.data(), entities.size() * sizeof(SceneFile::Entity));
+	memcpy(bytes.data() + layout.names_offset, names.data(), names.size());
+
+	std::span<const MeshComponent> meshes = m_meshes.GetComponents();
+	std::span<const EntityHandle> mesh_entities = m_meshes.GetEntities();
+	SceneFile::Mesh* file_meshes = reinterpret_cast<SceneFile::Mesh*>(bytes.data() + layout.meshes_offset);
+
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		MaterialAsset material_asset;
+		Renderer::GetMaterialParameters(meshes[i].material_handle, material_asset);
+
+		SceneFile::Mesh file_mesh = {};
+		file_mesh.model_handle = meshes[i].model_handle.value;
+		file_mesh.entity_index = entity_to_file_index[mesh_entities[i].index];
+		file_mesh.node_index = meshes[i].node_index;
+		file_mesh.node_mesh_index = meshes[i].node_mesh_index;
+		file_mesh.has_clearcoat = material_asset.has_clearcoat;
+		file_mesh.albedo_factor = material_asset.albedo_factor;
+		file_mesh.metallic_factor = material_asset.metallic_factor;
+		file_mesh.roughness_factor = material_asset.roughness_factor;
+		file_mesh.clearcoat_alpha_factor = material_asset.clearcoat_alpha_factor;
+		file_mesh.clearcoat_roughness_factor = material_asset.clearcoat_roughness_factor;
+
+		file_meshes[i] = file_mesh;
+	}
+
+	std::span<const AreaLightComponent> area_lights = m_area_lights.GetComponents();
+	std::span<const EntityHandle> area_light_entities = m_area_lights.GetEntities();
+	SceneFile::AreaLight* file_area_lights = reinterpret_cast<SceneFile::AreaLight*>(bytes.data() + layout.area_lights_offset);
+
+	for (size_t i = 0; i < area_lights.size(); ++i)
+	{
+		SceneFile::AreaLight file_area_light = {};
+		file_area_light.texture_handle = area_lights[i].texture_asset_handle.value;
+		file_area_light.entity_index = entity_to_file_index[area_light_entities[i].index];
+		file_area_light.color = area_lights[i].color;
+		file_area_light.intensity = area_lights[i].intensity;
+		file_area_light.two_sided = area_lights[i].two_sided;
+
+		file_area_lights[i] = file_area_light;
+	}
+
+	return bytes;
+}
+
+bool Scene::Deserialize(std::span<const uint8_t> bytes)
+{
+	PROFILE_FUNCTION();
+
+	SceneFile::Header header = {};
+	if (bytes.size() < sizeof(header))
+		return false;
+
+	memcpy(&header, bytes.data(), sizeof(header));
+	if (header.magic != SceneFile::MAGIC || header.version != SceneFile::VERSION)
+		return false;
+
+	SceneFile::Layout layout = SceneFile::GetLayout(header);
+	if (bytes.size() != layout.num_bytes)
+		return false;
+
+	const SceneFile::Entity* entities = reinterpret_cast<const SceneFile::Entity*>(bytes.data() + layout.entities_offset);
+	const SceneFile::Mesh* meshes = reinterpret_cast<const SceneFile::Mesh*>(bytes.data() + layout.meshes_offset);
+	const SceneFile::AreaLight* area_lights = reinterpret_cast<const SceneFile::AreaLight*>(bytes.data() + layout.area_lights_offset);
+	const char* names = reinterpret_cast<const char*>(bytes.data() + layout.names_offset);
+
+	// Everything is validated before the scene is cleared, so an invalid file leaves the scene unchanged
+	for (uint32_t i = 0; i < header.num_entities; ++i)
+	{
+		const SceneFile::Entity& entity = entities[i];
+		if ((entity.parent_index != SceneFile::INVALID_INDEX && entity.parent_index >= i) ||
+			(uint64_t)entity.name_offset + entity.name_length > header.num_name_bytes)
+			return false;
+	}
+	for (uint32_t i = 0; i < header.num_meshes; ++i)
+	{
+		if (meshes[i].entity_index >= header.num_entities)
+			return false;
+	}
+	for (uint32_t i = 0; i < header.num_area_lights; ++i)
+	{
+		if (area_lights[i].entity_index >= header.num_entities)
+			return false;
+	}
+
+	Clear();
+	m_entities.Reserve(header.num_entities);
+
+	// Parents come before their children, so every entity is appended to the end of the hierarchy
+	std::vector<EntityHandle> file_entities(header.num_entities);
+	for (uint32_t i = 0; i < header.num_entities; ++i)
+	{
+		const SceneFile::Entity& file_entity = entities[i];
+		EntityHandle parent = file_entity.parent_index == SceneFile::INVALID_INDEX ? EntityHandle() : file_entities[file_entity.parent_index];
+
+		EntityHandle entity = m_entities.Insert({ .name = std::string(names + file_entity.name_offset, file_entity.name_length) });
+		m_transforms.Add(entity, file_entity.transform);
+		m_transform_hierarchy.Insert(entity, parent, file_entity.local_transform);
+
+		file_entities[i] = entity;
+	}
+
+	uint32_t num_missing_assets = 0;
+
+	for (uint32_t i = 0; i < header.num_meshes; ++i)
+	{
+		const SceneFile::Mesh& file_mesh = meshes[i];
+		AssetHandle model_handle(file_mesh.model_handle);
+
+		RenderResourceHandle mesh_handle;
+		MaterialAsset material_asset;
+
+		if (VK_RESOURCE_HANDLE_VALID(model_handle))
+		{
+			const ModelAsset* model_asset = AssetManager::GetAsset<ModelAsset>(model_handle);
+			if (model_asset && file_mesh.node_index < model_asset->nodes.size() &&
+				file_mesh.node_mesh_index < model_asset->nodes[file_mesh.node_index].mesh_render_handles.size())
+			{
+				const ModelAsset::Node& node = model_asset->nodes[file_mesh.node_index];
+				mesh_handle = node.mesh_render_handles[file_mesh.node_mesh_index];
+				material_asset = node.materials[file_mesh.node_mesh_index];
+			}
+			else
+			{
+				num_missing_assets++;
+			}
+		}
+
+		material_asset.has_clearcoat = file_mesh.has_clearcoat != 0;
+		material_asset.albedo_factor = file_mesh.albedo_factor;
+		material_asset.metallic_factor = file_mesh.metallic_factor;
+		material_asset.roughness_factor = file_mesh.roughness_factor;
+		material_asset.clearcoat_alpha_factor = file_mesh.clearcoat_alpha_factor;
+		material_asset.clearcoat_roughness_factor = file_mesh.clearcoat_roughness_factor;
+
+		m_meshes.Add(file_entities[file_mesh.entity_index], mesh_handle, Renderer::CreateMaterial(material_asset),
+			model_handle, file_mesh.node_index, file_mesh.node_mesh_index);
+	}
+
+	for (uint32_t i = 0; i < header.num_area_lights; ++i)
+	{
+		const SceneFile::AreaLight& file_area_light = area_lights[i];
+		AssetHandle texture_handle(file_area_light.texture_handle);
+
+		RenderResourceHandle texture_render_handle;
+		if (VK_RESOURCE_HANDLE_VALID(texture_handle))
+		{
+			if (const TextureAsset* texture_asset = AssetManager::GetAsset<TextureAsset>(texture_handle))
+				texture_render_handle = texture_asset->texture_render_handle;
+			else
+				num_missing_assets++;
+		}
+
+		m_area_lights.Add(file_entities[file_area_light.entity_index], texture_handle, texture_render_handle,
+			file_area_light.color, file_area_light.intensity, file_area_light.two_sided != 0);
+	}
+
+	if (num_missing_assets > 0)
+		LOG_WARN("Scene::Deserialize", "{} meshes and area lights reference assets that are not imported, they are loaded without them", num_missing_assets);
+
+	return true;
+}
+
+size_t Scene::GetNumEntities() const
+{
+	return m_entities.GetSize();
+}
+
+size_t Scene::GetNumMeshes() const
+{
+	return m_meshes.GetSize();
+}
+
+size_t Scene::GetNumAreaLights() const
+{
+	return m_area_lights.GetSize();
+}
+
+std::span<const EntityHandle> Scene::GetChangedTransforms() const
+{
+	return m_transform_hierarchy.GetChangedEntities();
+}
+
+const AABBTree& Scene::GetBoundingVolumeHierarchy() const
+{
+	return m_bounding_volume_hierarchy;
+}
+
+static constexpr float PICK_MAX_DISTANCE = 10000.0f;
+
+EntityHandle Scene::PickEntity(const glm::vec3& origin, const glm::vec3& direction) const
+{
+	PROFILE_FUNCTION();
+
+	// The tree stores fattened bounds, and its closest hit would be a box around the camera, so every entity along the ray is tested
+	std::vector<EntityHandle> candidates;
+	m_bounding_volume_hierarchy.QueryRay(origin, direction, PICK_MAX_DISTANCE, candidates);
+
+	glm::vec3 inv_direction = 1.0f / direction;
+
+	EntityHandle closest_entity;
+	float closest_distance = FLT_MAX;
+	EntityHandle enclosing_entity;
+	float enclosing_surface_area = FLT_MAX;
+
+	for (EntityHandle entity : candidates)
+	{
+		AABB bounds;
+		if (!GetWorldBounds(entity, bounds))
+			continue;
+
+		glm::vec3 t0 = (bounds.min - origin) * inv_direction;
+		glm::vec3 t1 = (bounds.max - origin) * inv_direction;
+		glm::vec3 t_min = glm::min(t0, t1);
+		glm::vec3 t_max = glm::max(t0, t1);
+
+		float enter_distance = std::max(std::max(t_min.x, t_min.y), t_min.z);
+		float exit_distance = std::min(std::min(t_max.x, t_max.y), std::min(t_max.z, PICK_MAX_DISTANCE));
+		if (exit_distance < std::max(enter_distance, 0.0f))
+			continue;
+
+		if (enter_distance >= 0.0f)
+		{
+			if (enter_distance < closest_distance)
+			{
+				closest_entity = entity;
+				closest_distance = enter_distance;
+			}
+		}
+		else if (bounds.GetSurfaceArea() < enclosing_surface_area)
+		{
+			enclosing_entity = entity;
+			enclosing_surface_area = bounds.GetSurfaceArea();
+		}
+	}
+
+	return VK_RESOURCE_HANDLE_VALID(closest_entity) ? closest_entity : enclosing_entity;
+}
+
+void Scene::SelectEntity(EntityHandle entity)
+{
+	m_selected_entity = entity;
+	m_reveal_selected_entity = m_entities.Find(entity) != nullptr;
+}
+
 Camera& Scene::GetActiveCamera()
 {
 	return m_active_camera;
@@ -75,3 +718,221 @@ const Camera& Scene::GetActiveCamera() const
 {
 	return m_active_camera;
 }
+
+void Scene::CreateModelNodeEntity(const ModelAsset& model_asset, AssetHandle model_handle, uint32_t node_index, EntityHandle parent)
+{
+	const ModelAsset::Node& node = model_asset.nodes[node_index];
+	EntityHandle node_entity = CreateEntity(std::format("Node {}", node_index), node.transform, parent);
+
+	for (uint32_t i = 0; i < node.mesh_render_handles.size(); ++i)
+	{
+		EntityHandle mesh_entity = CreateMeshEntity(node.mesh_names[i], node.mesh_render_handles[i], Renderer::CreateMaterial(node.materials[i]),
+			glm::identity<glm::mat4>(), node_entity);
+
+		MeshComponent* mesh = m_meshes.Find(mesh_entity);
+		mesh->model_handle = model_handle;
+		mesh->node_index = node_index;
+		mesh->node_mesh_index = i;
+	}
+
+	for (uint32_t i = 0; i < node.children.size(); ++i)
+	{
+		CreateModelNodeEntity(model_asset, model_handle, node.children[i], node_entity);
+	}
+}
+
+void Scene::SetLocalTransform(EntityHandle entity, const glm::mat4& transform)
+{
+	TransformComponent* transform_component = m_transforms.Find(entity);
+	VK_ASSERT(transform_component && "Tried to set the transform of an entity without a transform");
+
+	glm::vec3 skew(0.0f);
+	glm::vec4 perspective(0.0f);
+	glm::quat orientation = {};
+	glm::decompose(transform, transform_component->scale, orientation, transform_component->translation, skew, perspective);
+
+	transform_component->rotation = glm::degrees(glm::eulerAngles(orientation));
+	m_transform_hierarchy.SetLocalTransform(entity, transform);
+}
+
+void Scene::UpdateLocalTransform(EntityHandle entity)
+{
+	const TransformComponent* transform_component = m_transforms.Find(entity);
+	VK_ASSERT(transform_component && "Tried to update the local transform of an entity without a transform");
+
+	glm::mat4 local_transform = glm::translate(glm::identity<glm::mat4>(), transform_component->translation);
+	local_transform = glm::rotate(local_transform, glm::radians(transform_component->rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+	local_transform = glm::rotate(local_transform, glm::radians(transform_component->rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+	local_transform = glm::rotate(local_transform, glm::radians(transform_component->rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+	local_transform = glm::scale(local_transform, transform_component->scale);
+
+	m_transform_hierarchy.SetLocalTransform(entity, local_transform);
+}
+
+bool Scene::GetWorldBounds(EntityHandle entity, AABB& world_bounds) const
+{
+	// Area lights are rendered as a unit quad in the XY plane
+	static const AABB AREA_LIGHT_BOUNDS = { glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec3(0.5f, 0.5f, 0.0f) };
+
+	const glm::mat4* world_transform = m_transform_hierarchy.GetWorldTransform(entity);
+	if (!world_transform)
+		return false;
+
+	AABB local_bounds;
+	if (const MeshComponent* mesh = m_meshes.Find(entity))
+		local_bounds = Renderer::GetMeshBounds(mesh->mesh_handle);
+	else if (m_area_lights.Find(entity))
+		local_bounds = AREA_LIGHT_BOUNDS;
+	else
+		return false;
+
+	world_bounds = AABB::Transform(local_bounds, *world_transform);
+	return true;
+}
+
+void Scene::UpdateBounds()
+{
+	PROFILE_FUNCTION();
+
+	// Only entities whose world transform changed are refitted, which includes every entity created since the last update
+	for (EntityHandle entity : m_transform_hierarchy.GetChangedEntities())
+	{
+		AABB world_bounds;
+		if (!GetWorldBounds(entity, world_bounds))
+			continue;
+
+		if (m_bounding_volume_hierarchy.Contains(entity))
+			m_bounding_volume_hierarchy.Update(entity, world_bounds);
+		else
+			m_bounding_volume_hierarchy.Insert(entity, world_bounds);
+	}
+}
+
+void Scene::RenderMeshes()
+{
+	PROFILE_FUNCTION();
+
+	std::span<const MeshComponent> meshes = m_meshes.GetComponents();
+	std::span<const EntityHandle> mesh_entities = m_meshes.GetEntities();
+
+	m_mesh_submission.mesh_handles.resize(meshes.size());
+	m_mesh_submission.material_handles.resize(meshes.size());
+	m_mesh_submission.transforms.resize(meshes.size());
+
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		m_mesh_submission.mesh_handles[i] = meshes[i].mesh_handle;
+		m_mesh_submission.material_handles[i] = meshes[i].material_handle;
+		m_mesh_submission.transforms[i] = *m_transform_hierarchy.GetWorldTransform(mesh_entities[i]);
+	}
+
+	// The entity handles identify the instances, so that the renderer keeps their instance data when entities are added or removed
+	Renderer::SubmitMeshes(mesh_entities, m_mesh_submission.mesh_handles, m_mesh_submission.material_handles, m_mesh_submission.transforms);
+}
+
+void Scene::RenderAreaLights()
+{
+	PROFILE_FUNCTION();
+
+	std::span<const AreaLightComponent> area_lights = m_area_lights.GetComponents();
+	std::span<const EntityHandle> area_light_entities = m_area_lights.GetEntities();
+
+	for (size_t i = 0; i < area_lights.size(); ++i)
+	{
+		const AreaLightComponent& area_light = area_lights[i];
+		const glm::mat4& transform = *m_transform_hierarchy.GetWorldTransform(area_light_entities[i]);
+
+		Renderer::SubmitAreaLight(area_light_entities[i], area_light.texture_handle, transform, area_light.color, area_light.intensity, area_light.two_sided);
+	}
+}
+
+void Scene::RenderEntityUI(EntityHandle entity)
+{
+	const EntityInfo* entity_info = m_entities.Find(entity);
+	VK_ASSERT(entity_info && "Tried to render the UI of an entity that does not exist");
+
+	ImGui::PushID((int)entity.index);
+
+	// Opens every node on the path from the root to the selected entity
+	if (m_reveal_selected_entity)
+	{
+		for (EntityHandle ancestor = m_selected_entity; VK_RESOURCE_HANDLE_VALID(ancestor); ancestor = m_transform_hierarchy.GetParent(ancestor))
+		{
+			if (ancestor == entity)
+			{
+				ImGui::SetNextItemOpen(true);
+				break;
+			}
+		}
+	}
+
+	ImGuiTreeNodeFlags tree_node_flags = entity == m_selected_entity ? ImGuiTreeNodeFlags_Selected : ImGuiTreeNodeFlags_None;
+	if (ImGui::TreeNodeEx(entity_info->name.c_str(), tree_node_flags))
+	{
+		ImGui::Indent(10.0f);
+
+		TransformComponent* transform = m_transforms.Find(entity);
+		if (transform && ImGui::CollapsingHeader("Transform"))
+		{
+			ImGui::Indent(10.0f);
+
+			bool transform_changed = false;
+			if (ImGui::DragFloat3("Translation", &transform->translation[0], 0.01f, -FLT_MAX, FLT_MAX, "%.2f"))
+			{
+				transform_changed = true;
+			}
+			if (ImGui::DragFloat3("Rotation", &transform->rotation[0], 0.01f, -360.0f, 360.0f, "%.2f"))
+			{
+				transform_changed = true;
+			}
+			if (ImGui::DragFloat3("Scale", &transform->scale[0], 0.01f, 0.001f, 10000.0f, "%.2f"))
+			{
+				transform_changed = true;
+			}
+
+			if (transform_changed)
+			{
+				UpdateLocalTransform(entity);
+			}
+
+			ImGui::Unindent(10.0f);
+		}
+
+		MeshComponent* mesh = m_meshes.Find(entity);
+		if (mesh && ImGui::CollapsingHeader("Material"))
+		{
+			ImGui::Indent(10.0f);
+			Renderer::ImGuiMaterialEditor(mesh->material_handle);
+			ImGui::Unindent(10.0f);
+		}
+
+		AreaLightComponent* area_light = m_area_lights.Find(entity);
+		if (area_light && ImGui::CollapsingHeader("Area light"))
+		{
+			ImGui::Indent(10.0f);
+
+			float texture_preview_width = std::min(ImGui::GetWindowSize().x, 256.0f);
+			float texture_preview_height = std::min(ImGui::GetWindowSize().y, 256.0f);
+
+			if (VK_RESOURCE_HANDLE_VALID(area_light->texture_handle))
+				Renderer::ImGuiImage(area_light->texture_handle, texture_preview_width, texture_preview_height);
+
+			ImGui::ColorEdit3("Color", &area_light->color[0], ImGuiColorEditFlags_DisplayRGB);
+			ImGui::DragFloat("Intensity", &area_light->intensity, 0.01f, 0.0f, 10000.0f, "%.2f");
+			ImGui::Checkbox("Two-sided", &area_light->two_sided);
+
+			ImGui::Unindent(10.0f);
+		}
+
+		ImGui::Unindent(10.0f);
+
+		m_transform_hierarchy.ForEachChild(entity, [this](EntityHandle child)
+		{
+			RenderEntityUI(child);
+		});
+
+		ImGui::TreePop();
+	}
+
+	ImGui::PopID();
+}
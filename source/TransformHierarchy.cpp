@@ -0,0 +1,209 @@
+#include "Precomp.h"
+#include "TransformHierarchy.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TRANSFORM_HIERARCHY_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// glm is not built with GLM_FORCE_INTRINSICS, since that changes the alignment of the math types that are shared with the GPU,
+// so the world transform multiply, which is the hot loop of Update, is done with SSE on unaligned loads instead
+static void MultiplyTransforms(const glm::mat4& parent, const glm::mat4& local, glm::mat4& world)
+{
+#if TRANSFORM_HIERARCHY_SSE
+	__m128 parent_columns[4] =
+	{
+		_mm_loadu_ps(&parent[0][0]),
+		_mm_loadu_ps(&parent[1][0]),
+		_mm_loadu_ps(&parent[2][0]),
+		_mm_loadu_ps(&parent[3][0])
+	};
+
+	for (uint32_t column = 0; column < 4; ++column)
+	{
+		__m128 result = _mm_mul_ps(parent_columns[0], _mm_set1_ps(local[column][0]));
+		result = _mm_add_ps(result, _mm_mul_ps(parent_columns[1], _mm_set1_ps(local[column][1])));
+		result = _mm_add_ps(result, _mm_mul_ps(parent_columns[2], _mm_set1_ps(local[column][2])));
+		result = _mm_add_ps(result, _mm_mul_ps(parent_columns[3], _mm_set1_ps(local[column][3])));
+
+		_mm_storeu_ps(&world[column][0], result);
+	}
+#else
+	world = parent * local;
+#endif
+}
+
+void TransformHierarchy::Insert(EntityHandle entity, EntityHandle parent, const glm::mat4& local_transform)
+{
+	VK_ASSERT(VK_RESOURCE_HANDLE_VALID(entity) && "Tried to insert an invalid entity into the transform hierarchy");
+	VK_ASSERT(FindNode(entity) == INVALID_NODE && "Tried to insert an entity into the transform hierarchy twice");
+
+	uint32_t parent_node = INVALID_NODE;
+	uint32_t node = (uint32_t)m_entities.size();
+
+	if (VK_RESOURCE_HANDLE_VALID(parent))
+	{
+		parent_node = FindNode(parent);
+		VK_ASSERT(parent_node != INVALID_NODE && "Tried to insert an entity into the transform hierarchy with a parent that is not in it");
+
+		node = parent_node + m_subtree_sizes[parent_node];
+	}
+
+	// Nodes after the insertion point move up by one, so their parent indices past it do too
+	for (uint32_t i = node; i < m_parents.size(); ++i)
+	{
+		if (m_parents[i] != INVALID_NODE && m_parents[i] >= node)
+			m_parents[i]++;
+	}
+
+	m_entities.insert(m_entities.begin() + node, entity);
+	m_parents.insert(m_parents.begin() + node, parent_node);
+	m_subtree_sizes.insert(m_subtree_sizes.begin() + node, 1);
+	m_local_transforms.insert(m_local_transforms.begin() + node, local_transform);
+	m_world_transforms.insert(m_world_transforms.begin() + node, local_transform);
+	m_dirty.insert(m_dirty.begin() + node, 1);
+	m_has_dirty_nodes = true;
+
+	for (uint32_t ancestor = parent_node; ancestor != INVALID_NODE; ancestor = m_parents[ancestor])
+	{
+		m_subtree_sizes[ancestor]++;
+	}
+
+	if (entity.index >= m_entity_to_node.size())
+	{
+		m_entity_to_node.resize(entity.index + 1, INVALID_NODE);
+	}
+	UpdateEntityToNode(node);
+}
+
+void TransformHierarchy::Remove(EntityHandle entity, std::vector<EntityHandle>& removed_entities)
+{
+	uint32_t node = FindNode(entity);
+	if (node == INVALID_NODE)
+		return;
+
+	uint32_t subtree_size = m_subtree_sizes[node];
+	uint32_t subtree_end = node + subtree_size;
+
+	for (uint32_t i = node; i < subtree_end; ++i)
+	{
+		removed_entities.push_back(m_entities[i]);
+		m_entity_to_node[m_entities[i].index] = INVALID_NODE;
+	}
+
+	for (uint32_t ancestor = m_parents[node]; ancestor != INVALID_NODE; ancestor = m_parents[ancestor])
+	{
+		m_subtree_sizes[ancestor] -= subtree_size;
+	}
+
+	// Nodes after the removed subtree move down, parents before the subtree keep their index
+	for (uint32_t i = subtree_end; i < m_parents.size(); ++i)
+	{
+		if (m_parents[i] != INVALID_NODE && m_parents[i] >= subtree_end)
+			m_parents[i] -= subtree_size;
+	}
+
+	m_entities.erase(m_entities.begin() + node, m_entities.begin() + subtree_end);
+	m_parents.erase(m_parents.begin() + node, m_parents.begin() + subtree_end);
+	m_subtree_sizes.erase(m_subtree_sizes.begin() + node, m_subtree_sizes.begin() + subtree_end);
+	m_local_transforms.erase(m_local_transforms.begin() + node, m_local_transforms.begin() + subtree_end);
+	m_world_transforms.erase(m_world_transforms.begin() + node, m_world_transforms.begin() + subtree_end);
+	m_dirty.erase(m_dirty.begin() + node, m_dirty.begin() + subtree_end);
+
+	UpdateEntityToNode(node);
+}
+
+void TransformHierarchy::SetLocalTransform(EntityHandle entity, const glm::mat4& local_transform)
+{
+	uint32_t node = FindNode(entity);
+	VK_ASSERT(node != INVALID_NODE && "Tried to set the local transform of an entity that is not in the transform hierarchy");
+
+	m_local_transforms[node] = local_transform;
+	m_dirty[node] = 1;
+	m_has_dirty_nodes = true;
+}
+
+const glm::mat4* TransformHierarchy::GetLocalTransform(EntityHandle entity) const
+{
+	uint32_t node = FindNode(entity);
+	if (node == INVALID_NODE)
+		return nullptr;
+
+	return &m_local_transforms[node];
+}
+
+const glm::mat4* TransformHierarchy::GetWorldTransform(EntityHandle entity) const
+{
+	uint32_t node = FindNode(entity);
+	if (node == INVALID_NODE)
+		return nullptr;
+
+	return &m_world_transforms[node];
+}
+
+EntityHandle TransformHierarchy::GetParent(EntityHandle entity) const
+{
+	uint32_t node = FindNode(entity);
+	if (node == INVALID_NODE || m_parents[node] == INVALID_NODE)
+		return EntityHandle();
+
+	return m_entities[m_parents[node]];
+}
+
+void TransformHierarchy::Update()
+{
+	PROFILE_FUNCTION();
+
+	m_changed_entities.clear();
+	if (!m_has_dirty_nodes)
+		return;
+
+	uint32_t num_nodes = (uint32_t)m_entities.size();
+	for (uint32_t node = 0; node < num_nodes;)
+	{
+		if (!m_dirty[node])
+		{
+			node++;
+			continue;
+		}
+
+		// The whole subtree is recomputed in order, dirty flags of descendants are covered by it as well
+		uint32_t subtree_end = node + m_subtree_sizes[node];
+		for (uint32_t i = node; i < subtree_end; ++i)
+		{
+			uint32_t parent_node = m_parents[i];
+			if (parent_node == INVALID_NODE)
+				m_world_transforms[i] = m_local_transforms[i];
+			else
+				MultiplyTransforms(m_world_transforms[parent_node], m_local_transforms[i], m_world_transforms[i]);
+
+			m_dirty[i] = 0;
+			m_changed_entities.push_back(m_entities[i]);
+		}
+
+		node = subtree_end;
+	}
+
+	m_has_dirty_nodes = false;
+}
+
+uint32_t TransformHierarchy::FindNode(EntityHandle entity) const
+{
+	if (!VK_RESOURCE_HANDLE_VALID(entity) || entity.index >= m_entity_to_node.size())
+		return INVALID_NODE;
+
+	// The entity stored at the node also checks the version, so nodes of destroyed entities are never returned
+	uint32_t node = m_entity_to_node[entity.index];
+	if (node == INVALID_NODE || !(m_entities[node] == entity))
+		return INVALID_NODE;
+
+	return node;
+}
+
+void TransformHierarchy::UpdateEntityToNode(uint32_t first_node)
+{
+	for (uint32_t node = first_node; node < m_entities.size(); ++node)
+	{
+		m_entity_to_node[m_entities[node].index] = node;
+	}
+}
@@ -565,6 +565,8 @@ namespace AssetImporter
 
 	void LoadTexture(TextureAsset& texture_asset)
 	{
+		PROFILE_FUNCTION();
+
 		FileIO::ReadImageResult image = FileIO::ReadImage(texture_asset.filepath);
 
 		Renderer::CreateTextureArgs texture_args = {};
@@ -616,6 +618,8 @@ namespace AssetImporter
 
 	void LoadModel(ModelAsset& model_asset)
 	{
+		PROFILE_FUNCTION();
+
 		ReadGLTFResult gltf = ReadGLTFModel(model_asset.filepath);
 
 		std::vector<MaterialAsset> material_assets = LoadGLTFMaterials(model_asset.filepath, gltf.data);
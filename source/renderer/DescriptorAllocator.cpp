@@ -0,0 +1,477 @@
+#include "Precomp.h"
+#include "renderer/DescriptorAllocator.h"
+
+#include <bit>
+
+DescriptorAllocator::DescriptorAllocator(uint32_t num_descriptors)
+	: m_num_descriptors(num_descriptors)
+{
+	VK_ASSERT(num_descriptors > 0 && "Tried to create a descriptor allocator without any descriptors");
+
+	m_block_size.resize(num_descriptors, 0);
+	m_block_begin.resize(num_descriptors, INVALID_OFFSET);
+	m_block_is_free.resize(num_descriptors, 0);
+	m_next_free_block.resize(num_descriptors, INVALID_OFFSET);
+	m_prev_free_block.resize(num_descriptors, INVALID_OFFSET);
+	m_bin_heads.fill(INVALID_OFFSET);
+	m_single_chunk_index.resize(num_descriptors, INVALID_OFFSET);
+	m_next_free_single.resize(num_descriptors, INVALID_OFFSET);
+	m_single_state.resize(num_descriptors, SINGLE_STATE_NONE);
+
+	AddFreeBlock(0, num_descriptors);
+	m_num_free_descriptors = num_descriptors;
+}
+
+uint32_t DescriptorAllocator::Allocate(uint32_t num_descriptors)
+{
+	VK_ASSERT(num_descriptors > 0 && "Tried to allocate zero descriptors");
+
+	if (num_descriptors == 1)
+		return AllocateSingle();
+
+	uint32_t offset = AllocateRange(num_descriptors);
+
+	// The kept single descriptor chunk might be in the way of the range
+	if (offset == INVALID_OFFSET && m_empty_single_chunk != INVALID_OFFSET)
+	{
+		ReleaseSingleChunk(m_empty_single_chunk);
+		offset = AllocateRange(num_descriptors);
+	}
+
+	return offset;
+}
+
+void DescriptorAllocator::Free(uint32_t offset, uint32_t num_descriptors, uint64_t frame_index)
+{
+	VK_ASSERT(offset + num_descriptors <= m_num_descriptors && "Tried to free descriptors outside of the descriptor allocator");
+	VK_ASSERT((m_pending_frees.empty() || m_pending_frees.back().frame_index <= frame_index) &&
+		"Descriptors have to be freed in frame order");
+
+	m_pending_frees.emplace(offset, num_descriptors, frame_index);
+}
+
+void DescriptorAllocator::ReleaseFrees(uint64_t finished_frame_index)
+{
+	while (!m_pending_frees.empty() && m_pending_frees.front().frame_index <= finished_frame_index)
+	{
+		const PendingFree& pending_free = m_pending_frees.front();
+
+		if (pending_free.num_descriptors == 1)
+		{
+			FreeSingle(pending_free.offset);
+		}
+		else
+		{
+			FreeRange(pending_free.offset, pending_free.num_descriptors);
+		}
+
+		m_pending_frees.pop();
+	}
+}
+
+void DescriptorAllocator::Grow(uint32_t num_descriptors)
+{
+	VK_ASSERT(num_descriptors > m_num_descriptors && "Tried to grow a descriptor allocator to a smaller or equal amount of descriptors");
+
+	uint32_t first_new_descriptor = m_num_descriptors;
+	uint32_t num_new_descriptors = num_descriptors - m_num_descriptors;
+
+	m_block_size.resize(num_descriptors, 0);
+	m_block_begin.resize(num_descriptors, INVALID_OFFSET);
+	m_block_is_free.resize(num_descriptors, 0);
+	m_next_free_block.resize(num_descriptors, INVALID_OFFSET);
+	m_prev_free_block.resize(num_descriptors, INVALID_OFFSET);
+	m_single_chunk_index.resize(num_descriptors, INVALID_OFFSET);
+	m_next_free_single.resize(num_descriptors, INVALID_OFFSET);
+	m_single_state.resize(num_descriptors, SINGLE_STATE_NONE);
+	m_num_descriptors = num_descriptors;
+
+	// The new descriptors are added as an allocated block and then freed, so they merge with a free block at the end of the old range
+	SetBlock(first_new_descriptor, num_new_descriptors, false);
+	FreeRange(first_new_descriptor, num_new_descriptors);
+}
+
+bool DescriptorAllocator::Validate() const
+{
+	uint32_t num_free_block_descriptors = 0;
+	uint32_t num_free_blocks = 0;
+	bool previous_is_free = false;
+
+	// Blocks need to cover all descriptors without gaps, and free blocks should never be adjacent, since they are always merged
+	uint32_t offset = 0;
+	while (offset < m_num_descriptors)
+	{
+		uint32_t num_descriptors = m_block_size[offset];
+		if (num_descriptors == 0 || offset + num_descriptors > m_num_descriptors ||
+			m_block_begin[offset + num_descriptors - 1] != offset)
+			return false;
+
+		bool is_free = m_block_is_free[offset];
+		if (is_free)
+		{
+			if (previous_is_free)
+				return false;
+
+			num_free_block_descriptors += num_descriptors;
+			num_free_blocks++;
+		}
+
+		previous_is_free = is_free;
+		offset += num_descriptors;
+	}
+
+	// Every free block needs to be in the bin matching its size
+	uint32_t num_binned_blocks = 0;
+	for (uint32_t bin = 0; bin < NUM_BINS; ++bin)
+	{
+		uint32_t first_level = bin / NUM_SECOND_LEVEL_BINS;
+		uint32_t second_level = bin % NUM_SECOND_LEVEL_BINS;
+
+		if (((m_second_level_masks[first_level] >> second_level) & 1) != (m_bin_heads[bin] != INVALID_OFFSET) ||
+			((m_first_level_mask >> first_level) & 1) != (m_second_level_masks[first_level] != 0))
+			return false;
+
+		for (uint32_t block = m_bin_heads[bin]; block != INVALID_OFFSET; block = m_next_free_block[block])
+		{
+			if (!m_block_is_free[block] || GetBinIndex(m_block_size[block]) != bin)
+				return false;
+
+			num_binned_blocks++;
+		}
+	}
+
+	// Every free single descriptor needs to be in the free list of a chunk that is in the list of chunks with free descriptors
+	uint32_t num_linked_free_singles = 0;
+	for (uint32_t chunk_index = m_single_chunks_with_free_head; chunk_index != INVALID_OFFSET; chunk_index = m_single_chunks[chunk_index].next_chunk)
+	{
+		const SingleChunk& chunk = m_single_chunks[chunk_index];
+		if (chunk.num_free == 0 || chunk.num_free > chunk.num_descriptors ||
+			(chunk.num_free == chunk.num_descriptors && chunk_index != m_empty_single_chunk))
+			return false;
+
+		uint32_t num_chunk_free_singles = 0;
+		for (uint32_t single = chunk.first_free_single; single != INVALID_OFFSET; single = m_next_free_single[single])
+		{
+			if (m_single_state[single] != SINGLE_STATE_FREE || m_single_chunk_index[single] != chunk_index)
+				return false;
+
+			num_chunk_free_singles++;
+		}
+
+		if (num_chunk_free_singles != chunk.num_free)
+			return false;
+
+		num_linked_free_singles += num_chunk_free_singles;
+	}
+
+	uint32_t num_free_singles = (uint32_t)std::count(m_single_state.begin(), m_single_state.end(), SINGLE_STATE_FREE);
+
+	return num_binned_blocks == num_free_blocks &&
+		num_free_singles == num_linked_free_singles &&
+		num_free_block_descriptors + num_free_singles == m_num_free_descriptors;
+}
+
+uint32_t DescriptorAllocator::GetBinIndex(uint32_t num_descriptors)
+{
+	if (num_descriptors < NUM_SECOND_LEVEL_BINS)
+		return num_descriptors;
+
+	// The first level is the power-of-two size class, the second level the next NUM_SECOND_LEVEL_BITS bits below the top bit
+	uint32_t log2 = (uint32_t)std::bit_width(num_descriptors) - 1;
+	uint32_t first_level = log2 - NUM_SECOND_LEVEL_BITS + 1;
+	uint32_t second_level = (num_descriptors >> (log2 - NUM_SECOND_LEVEL_BITS)) - NUM_SECOND_LEVEL_BINS;
+
+	return first_level * NUM_SECOND_LEVEL_BINS + second_level;
+}
+
+uint32_t DescriptorAllocator::FindFreeBlock(uint32_t num_descriptors) const
+{
+	// Rounding the size up to the next bin boundary means that any block in a bin at or above that bin fits
+	uint64_t rounded_num_descriptors = num_descriptors;
+	if (num_descriptors >= NUM_SECOND_LEVEL_BINS)
+		rounded_num_descriptors += (1ull << (std::bit_width(num_descriptors) - 1 - NUM_SECOND_LEVEL_BITS)) - 1;
+
+	if (rounded_num_descriptors <= UINT32_MAX)
+	{
+		uint32_t min_bin = GetBinIndex((uint32_t)rounded_num_descriptors);
+		uint32_t first_level = min_bin / NUM_SECOND_LEVEL_BINS;
+		uint32_t second_level_mask = m_second_level_masks[first_level] & (~0u << (min_bin % NUM_SECOND_LEVEL_BINS));
+
+		if (!second_level_mask)
+		{
+			uint32_t first_level_mask = first_level + 1 < NUM_FIRST_LEVEL_BINS ? m_first_level_mask & (~0u << (first_level + 1)) : 0;
+			if (first_level_mask)
+			{
+				first_level = std::countr_zero(first_level_mask);
+				second_level_mask = m_second_level_masks[first_level];
+			}
+		}
+
+		if (second_level_mask)
+			return m_bin_heads[first_level * NUM_SECOND_LEVEL_BINS + std::countr_zero(second_level_mask)];
+	}
+
+	// The bin holding the exact size might still have a large enough block, only its head is checked to keep this O(1)
+	// Freed and grown blocks are pushed to the head of their bin, so growing by the requested amount always fits
+	uint32_t block = m_bin_heads[GetBinIndex(num_descriptors)];
+	if (block != INVALID_OFFSET && m_block_size[block] >= num_descriptors)
+		return block;
+
+	return INVALID_OFFSET;
+}
+
+uint32_t DescriptorAllocator::AllocateRange(uint32_t num_descriptors)
+{
+	uint32_t offset = FindFreeBlock(num_descriptors);
+	if (offset == INVALID_OFFSET)
+		return INVALID_OFFSET;
+
+	uint32_t block_size = m_block_size[offset];
+	RemoveFreeBlock(offset);
+
+	// Split off the remainder as a new free block
+	if (block_size > num_descriptors)
+		AddFreeBlock(offset + num_descriptors, block_size - num_descriptors);
+
+	SetBlock(offset, num_descriptors, false);
+	m_num_free_descriptors -= num_descriptors;
+
+	return offset;
+}
+
+void DescriptorAllocator::FreeRange(uint32_t offset, uint32_t num_descriptors)
+{
+	if (m_block_size[offset] != num_descriptors || m_block_is_free[offset])
+	{
+		VK_EXCEPT("DescriptorAllocator::FreeRange", "Tried to free the same descriptor allocation multiple times");
+	}
+
+	m_num_free_descriptors += num_descriptors;
+
+	// Merge with the free block on the right
+	uint32_t right_offset = offset + num_descriptors;
+	if (right_offset < m_num_descriptors && m_block_is_free[right_offset])
+	{
+		num_descriptors += m_block_size[right_offset];
+		RemoveFreeBlock(right_offset);
+		m_block_size[right_offset] = 0;
+	}
+
+	// Merge with the free block on the left
+	if (offset > 0)
+	{
+		uint32_t left_offset = m_block_begin[offset - 1];
+		if (m_block_is_free[left_offset])
+		{
+			num_descriptors += m_block_size[left_offset];
+			RemoveFreeBlock(left_offset);
+			m_block_size[offset] = 0;
+			offset = left_offset;
+		}
+	}
+
+	AddFreeBlock(offset, num_descriptors);
+}
+
+uint32_t DescriptorAllocator::AllocateSingle()
+{
+	if (m_single_chunks_with_free_head == INVALID_OFFSET)
+	{
+		uint32_t chunk_offset = AllocateRange(SINGLE_DESCRIPTOR_CHUNK_SIZE);
+		uint32_t chunk_size = SINGLE_DESCRIPTOR_CHUNK_SIZE;
+
+		// There is no room for a full chunk anymore, so hand out whatever single descriptor is left as a chunk of its own
+		if (chunk_offset == INVALID_OFFSET)
+		{
+			chunk_offset = AllocateRange(1);
+			chunk_size = 1;
+		}
+
+		if (chunk_offset == INVALID_OFFSET)
+			return INVALID_OFFSET;
+
+		AddSingleChunk(chunk_offset, chunk_size);
+	}
+
+	uint32_t chunk_index = m_single_chunks_with_free_head;
+	SingleChunk& chunk = m_single_chunks[chunk_index];
+
+	uint32_t offset = chunk.first_free_single;
+	chunk.first_free_single = m_next_free_single[offset];
+	chunk.num_free--;
+	m_next_free_single[offset] = INVALID_OFFSET;
+
+	if (chunk.num_free == 0)
+		UnlinkSingleChunk(chunk_index);
+	if (chunk_index == m_empty_single_chunk)
+		m_empty_single_chunk = INVALID_OFFSET;
+
+	m_single_state[offset] = SINGLE_STATE_ALLOCATED;
+	m_num_free_descriptors--;
+
+	return offset;
+}
+
+void DescriptorAllocator::FreeSingle(uint32_t offset)
+{
+	if (m_single_state[offset] != SINGLE_STATE_ALLOCATED)
+	{
+		VK_EXCEPT("DescriptorAllocator::FreeSingle", "Tried to free the same descriptor allocation multiple times");
+	}
+
+	uint32_t chunk_index = m_single_chunk_index[offset];
+	SingleChunk& chunk = m_single_chunks[chunk_index];
+
+	m_single_state[offset] = SINGLE_STATE_FREE;
+	m_next_free_single[offset] = chunk.first_free_single;
+	chunk.first_free_single = offset;
+	chunk.num_free++;
+	m_num_free_descriptors++;
+
+	if (chunk.num_free == 1)
+		LinkSingleChunk(chunk_index);
+
+	if (chunk.num_free == chunk.num_descriptors)
+	{
+		// Only the last chunk with free descriptors is kept, any other completely free chunk goes back to the range allocator
+		bool is_last_chunk_with_free = chunk.prev_chunk == INVALID_OFFSET && chunk.next_chunk == INVALID_OFFSET;
+		if (is_last_chunk_with_free)
+			m_empty_single_chunk = chunk_index;
+		else
+			ReleaseSingleChunk(chunk_index);
+	}
+}
+
+void DescriptorAllocator::AddSingleChunk(uint32_t offset, uint32_t num_descriptors)
+{
+	uint32_t chunk_index = (uint32_t)m_single_chunks.size();
+	if (!m_free_single_chunk_indices.empty())
+	{
+		chunk_index = m_free_single_chunk_indices.back();
+		m_free_single_chunk_indices.pop_back();
+	}
+	else
+	{
+		m_single_chunks.emplace_back();
+	}
+
+	SingleChunk& chunk = m_single_chunks[chunk_index];
+	chunk = {};
+	chunk.offset = offset;
+	chunk.num_descriptors = num_descriptors;
+	chunk.num_free = num_descriptors;
+	chunk.first_free_single = offset;
+
+	// Linked front to back, so that the chunk is handed out in order
+	for (uint32_t single = offset; single < offset + num_descriptors; ++single)
+	{
+		m_single_chunk_index[single] = chunk_index;
+		m_next_free_single[single] = single + 1 < offset + num_descriptors ? single + 1 : INVALID_OFFSET;
+		m_single_state[single] = SINGLE_STATE_FREE;
+	}
+
+	LinkSingleChunk(chunk_index);
+
+	// The chunk is still free, its descriptors just moved from the range allocator to the chunk
+	m_num_free_descriptors += num_descriptors;
+}
+
+void DescriptorAllocator::ReleaseSingleChunk(uint32_t chunk_index)
+{
+	SingleChunk& chunk = m_single_chunks[chunk_index];
+	VK_ASSERT(chunk.num_free == chunk.num_descriptors && "Tried to release a single descriptor chunk that still has allocated descriptors");
+
+	UnlinkSingleChunk(chunk_index);
+	if (chunk_index == m_empty_single_chunk)
+		m_empty_single_chunk = INVALID_OFFSET;
+
+	for (uint32_t single = chunk.offset; single < chunk.offset + chunk.num_descriptors; ++single)
+	{
+		m_single_chunk_index[single] = INVALID_OFFSET;
+		m_next_free_single[single] = INVALID_OFFSET;
+		m_single_state[single] = SINGLE_STATE_NONE;
+	}
+
+	// FreeRange counts the descriptors as free again
+	m_num_free_descriptors -= chunk.num_descriptors;
+	FreeRange(chunk.offset, chunk.num_descriptors);
+
+	m_free_single_chunk_indices.push_back(chunk_index);
+}
+
+void DescriptorAllocator::LinkSingleChunk(uint32_t chunk_index)
+{
+	SingleChunk& chunk = m_single_chunks[chunk_index];
+	chunk.prev_chunk = INVALID_OFFSET;
+	chunk.next_chunk = m_single_chunks_with_free_head;
+
+	if (m_single_chunks_with_free_head != INVALID_OFFSET)
+		m_single_chunks[m_single_chunks_with_free_head].prev_chunk = chunk_index;
+
+	m_single_chunks_with_free_head = chunk_index;
+}
+
+void DescriptorAllocator::UnlinkSingleChunk(uint32_t chunk_index)
+{
+	SingleChunk& chunk = m_single_chunks[chunk_index];
+
+	if (chunk.prev_chunk != INVALID_OFFSET)
+		m_single_chunks[chunk.prev_chunk].next_chunk = chunk.next_chunk;
+	else
+		m_single_chunks_with_free_head = chunk.next_chunk;
+
+	if (chunk.next_chunk != INVALID_OFFSET)
+		m_single_chunks[chunk.next_chunk].prev_chunk = chunk.prev_chunk;
+
+	chunk.prev_chunk = INVALID_OFFSET;
+	chunk.next_chunk = INVALID_OFFSET;
+}
+
+void DescriptorAllocator::SetBlock(uint32_t offset, uint32_t num_descriptors, bool is_free)
+{
+	m_block_size[offset] = num_descriptors;
+	m_block_is_free[offset] = is_free ? 1 : 0;
+	m_block_begin[offset + num_descriptors - 1] = offset;
+}
+
+void DescriptorAllocator::AddFreeBlock(uint32_t offset, uint32_t num_descriptors)
+{
+	SetBlock(offset, num_descriptors, true);
+
+	uint32_t bin = GetBinIndex(num_descriptors);
+	m_prev_free_block[offset] = INVALID_OFFSET;
+	m_next_free_block[offset] = m_bin_heads[bin];
+
+	if (m_bin_heads[bin] != INVALID_OFFSET)
+		m_prev_free_block[m_bin_heads[bin]] = offset;
+
+	m_bin_heads[bin] = offset;
+	m_first_level_mask |= 1u << (bin / NUM_SECOND_LEVEL_BINS);
+	m_second_level_masks[bin / NUM_SECOND_LEVEL_BINS] |= 1u << (bin % NUM_SECOND_LEVEL_BINS);
+}
+
+void DescriptorAllocator::RemoveFreeBlock(uint32_t offset)
+{
+	uint32_t bin = GetBinIndex(m_block_size[offset]);
+	uint32_t prev_block = m_prev_free_block[offset];
+	uint32_t next_block = m_next_free_block[offset];
+
+	if (prev_block != INVALID_OFFSET)
+		m_next_free_block[prev_block] = next_block;
+	else
+		m_bin_heads[bin] = next_block;
+
+	if (next_block != INVALID_OFFSET)
+		m_prev_free_block[next_block] = prev_block;
+
+	if (m_bin_heads[bin] == INVALID_OFFSET)
+	{
+		m_second_level_masks[bin / NUM_SECOND_LEVEL_BINS] &= ~(1u << (bin % NUM_SECOND_LEVEL_BINS));
+		if (m_second_level_masks[bin / NUM_SECOND_LEVEL_BINS] == 0)
+			m_first_level_mask &= ~(1u << (bin / NUM_SECOND_LEVEL_BINS));
+	}
+
+	m_block_is_free[offset] = 0;
+	m_prev_free_block[offset] = INVALID_OFFSET;
+	m_next_free_block[offset] = INVALID_OFFSET;
+}
@@ -0,0 +1,371 @@
+#include "Precomp.h"
+#include "renderer/GPUProfiler.h"
+#include "renderer/vulkan/VulkanBackend.h"
+#include "renderer/vulkan/VulkanCommands.h"
+#include "renderer/vulkan/VulkanInstance.h"
+#include "renderer/vulkan/VulkanQuery.h"
+
+#include "imgui/imgui.h"
+
+namespace GPUProfiler
+{
+
+	static constexpr uint32_t MAX_SCOPES_PER_FRAME = 128;
+	static constexpr uint32_t MAX_HISTORY_SAMPLES = 128;
+
+	static constexpr VkQueryPipelineStatisticFlags PIPELINE_STATISTIC_FLAGS =
+		VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+	// The results of a pipeline statistics query are written in the order of the statistic flag bits
+	static constexpr uint32_t NUM_PIPELINE_STATISTICS = 5;
+	static constexpr const char* PIPELINE_STATISTIC_LABELS[NUM_PIPELINE_STATISTICS] =
+	{
+		"Vertex invocations", "Clipping invocations", "Clipping primitives", "Fragment invocations", "Compute invocations"
+	};
+
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct FrameScope
+	{
+		std::string path;
+		std::string name;
+		uint32_t parent = INVALID_INDEX;
+		uint32_t depth = 0;
+		uint32_t statistics_query = INVALID_INDEX;
+		bool async_compute = false;
+	};
+
+	struct Frame
+	{
+		VkQueryPool timestamp_query_pool = VK_NULL_HANDLE;
+		VkQueryPool statistics_query_pool = VK_NULL_HANDLE;
+
+		std::vector<FrameScope> scopes;
+		uint32_t num_statistics_queries = 0;
+	};
+
+	struct ScopeHistory
+	{
+		std::array<double, MAX_HISTORY_SAMPLES> samples_ms = {};
+		uint32_t num_samples = 0;
+		uint32_t next_sample = 0;
+
+		std::array<uint64_t, NUM_PIPELINE_STATISTICS> statistics = {};
+		bool has_statistics = false;
+
+		void AddSample(double ms)
+		{
+			samples_ms[next_sample] = ms;
+			next_sample = (next_sample + 1) % MAX_HISTORY_SAMPLES;
+			num_samples = std::min(num_samples + 1, MAX_HISTORY_SAMPLES);
+		}
+	};
+
+	struct DisplayScope
+	{
+		std::string path;
+		std::string name;
+		uint32_t depth = 0;
+		bool async_compute = false;
+	};
+
+	struct Data
+	{
+		Frame per_frame[Vulkan::MAX_FRAMES_IN_FLIGHT];
+		Frame* current_frame = nullptr;
+
+		// Scopes that are currently open, in the current frame, INVALID_INDEX if the scope was not recorded
+		std::vector<uint32_t> scope_stack;
+
+		// Scope histories are keyed by their full path, so that scopes with the same name under different parents are kept apart
+		std::unordered_map<std::string, ScopeHistory> history;
+		// Scopes of the last frame that was read back, in recording order
+		std::vector<DisplayScope> display_scopes;
+
+		bool collect_statistics = true;
+	} static *data;
+
+	static void ReadFrameResults(Frame& frame)
+	{
+		uint32_t num_scopes = static_cast<uint32_t>(frame.scopes.size());
+		if (num_scopes == 0)
+			return;
+
+		std::vector<uint64_t> timestamps(num_scopes * 2);
+		if (!Vulkan::Query::GetResults(frame.timestamp_query_pool, 0, num_scopes * 2, 1, timestamps.data()))
+			return;
+
+		std::vector<uint64_t> statistics(frame.num_statistics_queries * NUM_PIPELINE_STATISTICS);
+		bool has_statistics = frame.num_statistics_queries > 0 &&
+			Vulkan::Query::GetResults(frame.statistics_query_pool, 0, frame.num_statistics_queries, NUM_PIPELINE_STATISTICS, statistics.data());
+
+		// Scope statistics are summed up into their parents, statistics queries are never nested so nothing is counted twice
+		std::vector<std::array<uint64_t, NUM_PIPELINE_STATISTICS>> scope_statistics(num_scopes);
+		std::vector<bool> scope_has_statistics(num_scopes, false);
+
+		if (has_statistics)
+		{
+			for (uint32_t scope_index = 0; scope_index < num_scopes; ++scope_index)
+			{
+				const FrameScope& scope = frame.scopes[scope_index];
+				if (scope.statistics_query == INVALID_INDEX)
+					continue;
+
+				for (uint32_t parent_index = scope_index; parent_index != INVALID_INDEX; parent_index = frame.scopes[parent_index].parent)
+				{
+					for (uint32_t i = 0; i < NUM_PIPELINE_STATISTICS; ++i)
+					{
+						scope_statistics[parent_index][i] += statistics[scope.statistics_query * NUM_PIPELINE_STATISTICS + i];
+					}
+					scope_has_statistics[parent_index] = true;
+				}
+			}
+		}
+
+		data->display_scopes.clear();
+		data->display_scopes.reserve(num_scopes);
+
+		for (uint32_t scope_index = 0; scope_index < num_scopes; ++scope_index)
+		{
+			const FrameScope& scope = frame.scopes[scope_index];
+
+			ScopeHistory& history = data->history[scope.path];
+			history.AddSample(Vulkan::Query::TimestampsToMs(timestamps[scope_index * 2], timestamps[scope_index * 2 + 1]));
+			history.statistics = scope_statistics[scope_index];
+			history.has_statistics = scope_has_statistics[scope_index];
+
+			data->display_scopes.push_back({ scope.path, scope.name, scope.depth, scope.async_compute });
+		}
+	}
+
+	static void RenderScopeColumns(const DisplayScope& scope)
+	{
+		const ScopeHistory& history = data->history.at(scope.path);
+
+		double last_ms = history.samples_ms[(history.next_sample + MAX_HISTORY_SAMPLES - 1) % MAX_HISTORY_SAMPLES];
+		double avg_ms = 0.0;
+		double min_ms = std::numeric_limits<double>::max();
+		double max_ms = 0.0;
+
+		for (uint32_t i = 0; i < history.num_samples; ++i)
+		{
+			avg_ms += history.samples_ms[i];
+			min_ms = std::min(min_ms, history.samples_ms[i]);
+			max_ms = std::max(max_ms, history.samples_ms[i]);
+		}
+		avg_ms /= std::max(history.num_samples, 1u);
+
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f", last_ms);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f", avg_ms);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f", min_ms);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f", max_ms);
+
+		if (data->collect_statistics)
+		{
+			for (uint32_t i = 0; i < NUM_PIPELINE_STATISTICS; ++i)
+			{
+				ImGui::TableNextColumn();
+				if (history.has_statistics)
+					ImGui::Text("%llu", (unsigned long long)history.statistics[i]);
+			}
+		}
+	}
+
+	// Renders the row of a scope and its children, returns the index of the next scope that is not one of its children
+	static uint32_t RenderScopeRows(uint32_t scope_index)
+	{
+		const DisplayScope& scope = data->display_scopes[scope_index];
+		uint32_t num_scopes = static_cast<uint32_t>(data->display_scopes.size());
+		bool has_children = scope_index + 1 < num_scopes && data->display_scopes[scope_index + 1].depth > scope.depth;
+
+		ImGuiTreeNodeFlags tree_node_flags = ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_DefaultOpen;
+		if (!has_children)
+			tree_node_flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		bool open = ImGui::TreeNodeEx(scope.path.c_str(), tree_node_flags, scope.async_compute ? "%s (async compute)" : "%s", scope.name.c_str());
+		RenderScopeColumns(scope);
+
+		uint32_t next_scope_index = scope_index + 1;
+		if (has_children)
+		{
+			while (next_scope_index < num_scopes && data->display_scopes[next_scope_index].depth > scope.depth)
+			{
+				next_scope_index = open ? RenderScopeRows(next_scope_index) : next_scope_index + 1;
+			}
+
+			if (open)
+				ImGui::TreePop();
+		}
+
+		return next_scope_index;
+	}
+
+	void Init()
+	{
+		data = new Data();
+		data->collect_statistics = vk_inst.device_props.pipeline_statistics_query;
+
+		for (uint32_t frame_index = 0; frame_index < Vulkan::MAX_FRAMES_IN_FLIGHT; ++frame_index)
+		{
+			Frame& frame = data->per_frame[frame_index];
+			frame.timestamp_query_pool = Vulkan::Query::CreatePool(VK_QUERY_TYPE_TIMESTAMP, MAX_SCOPES_PER_FRAME * 2, std::format("GPU Profiler Timestamps {}", frame_index));
+			Vulkan::Query::ResetPool(frame.timestamp_query_pool, 0, MAX_SCOPES_PER_FRAME * 2);
+
+			if (vk_inst.device_props.pipeline_statistics_query)
+			{
+				frame.statistics_query_pool = Vulkan::Query::CreatePool(VK_QUERY_TYPE_PIPELINE_STATISTICS, MAX_SCOPES_PER_FRAME,
+					std::format("GPU Profiler Pipeline Statistics {}", frame_index), PIPELINE_STATISTIC_FLAGS);
+				Vulkan::Query::ResetPool(frame.statistics_query_pool, 0, MAX_SCOPES_PER_FRAME);
+			}
+		}
+	}
+
+	void Exit()
+	{
+		for (uint32_t frame_index = 0; frame_index < Vulkan::MAX_FRAMES_IN_FLIGHT; ++frame_index)
+		{
+			Vulkan::Query::DestroyPool(data->per_frame[frame_index].timestamp_query_pool);
+			Vulkan::Query::DestroyPool(data->per_frame[frame_index].statistics_query_pool);
+		}
+
+		delete data;
+		data = nullptr;
+	}
+
+	void BeginFrame(uint32_t frame_index)
+	{
+		Frame& frame = data->per_frame[frame_index % Vulkan::GetNumFramesInFlight()];
+		ReadFrameResults(frame);
+
+		if (!frame.scopes.empty())
+			Vulkan::Query::ResetPool(frame.timestamp_query_pool, 0, static_cast<uint32_t>(frame.scopes.size()) * 2);
+		if (frame.num_statistics_queries > 0)
+			Vulkan::Query::ResetPool(frame.statistics_query_pool, 0, frame.num_statistics_queries);
+
+		frame.scopes.clear();
+		frame.num_statistics_queries = 0;
+		data->current_frame = &frame;
+	}
+
+	void EndFrame()
+	{
+		VK_ASSERT(data->scope_stack.empty() && "Tried to end the GPU profiler frame while there are still scopes open");
+		data->current_frame = nullptr;
+	}
+
+	void BeginScope(VulkanCommandBuffer& command_buffer, const std::string& name, bool collect_statistics)
+	{
+		Frame* frame = data->current_frame;
+		if (!frame || frame->scopes.size() >= MAX_SCOPES_PER_FRAME)
+		{
+			data->scope_stack.push_back(INVALID_INDEX);
+			return;
+		}
+
+		uint32_t scope_index = static_cast<uint32_t>(frame->scopes.size());
+		FrameScope& scope = frame->scopes.emplace_back();
+		scope.name = name;
+		scope.async_compute = command_buffer.type == VULKAN_COMMAND_BUFFER_TYPE_COMPUTE;
+
+		// Scopes that were not recorded are skipped when looking for the parent, their children end up under the closest recorded scope
+		for (auto it = data->scope_stack.rbegin(); it != data->scope_stack.rend(); ++it)
+		{
+			if (*it != INVALID_INDEX)
+			{
+				scope.parent = *it;
+				break;
+			}
+		}
+
+		if (scope.parent != INVALID_INDEX)
+		{
+			scope.path = frame->scopes[scope.parent].path + "/" + name;
+			scope.depth = frame->scopes[scope.parent].depth + 1;
+		}
+		else
+		{
+			scope.path = name;
+		}
+
+		Vulkan::Command::WriteTimestamp(command_buffer, frame->timestamp_query_pool, scope_index * 2, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT);
+
+		if (collect_statistics && data->collect_statistics && frame->statistics_query_pool && !scope.async_compute)
+		{
+			scope.statistics_query = frame->num_statistics_queries++;
+			Vulkan::Command::BeginQuery(command_buffer, frame->statistics_query_pool, scope.statistics_query);
+		}
+
+		data->scope_stack.push_back(scope_index);
+	}
+
+	void EndScope(VulkanCommandBuffer& command_buffer)
+	{
+		VK_ASSERT(!data->scope_stack.empty() && "Tried to end a GPU profiler scope that was never started");
+
+		uint32_t scope_index = data->scope_stack.back();
+		data->scope_stack.pop_back();
+
+		if (scope_index == INVALID_INDEX)
+			return;
+
+		Frame* frame = data->current_frame;
+		const FrameScope& scope = frame->scopes[scope_index];
+
+		if (scope.statistics_query != INVALID_INDEX)
+			Vulkan::Command::EndQuery(command_buffer, frame->statistics_query_pool, scope.statistics_query);
+
+		Vulkan::Command::WriteTimestamp(command_buffer, frame->timestamp_query_pool, scope_index * 2 + 1, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+	}
+
+	void RenderUI()
+	{
+		ImGui::BeginDisabled(!vk_inst.device_props.pipeline_statistics_query);
+		ImGui::Checkbox("Pipeline statistics", &data->collect_statistics);
+		ImGui::EndDisabled();
+		if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+		{
+			ImGui::SetTooltip(vk_inst.device_props.pipeline_statistics_query ?
+				"If enabled, collects shader invocation and clipping counts for every render pass stage on the graphics queue" :
+				"The device does not support pipeline statistics queries");
+		}
+
+		uint32_t num_columns = 5 + (data->collect_statistics ? NUM_PIPELINE_STATISTICS : 0);
+		ImGuiTableFlags table_flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollX;
+
+		if (ImGui::BeginTable("GPU Profiler", num_columns, table_flags))
+		{
+			ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_NoHide);
+			ImGui::TableSetupColumn("Last (ms)");
+			ImGui::TableSetupColumn("Avg (ms)");
+			ImGui::TableSetupColumn("Min (ms)");
+			ImGui::TableSetupColumn("Max (ms)");
+
+			if (data->collect_statistics)
+			{
+				for (uint32_t i = 0; i < NUM_PIPELINE_STATISTICS; ++i)
+				{
+					ImGui::TableSetupColumn(PIPELINE_STATISTIC_LABELS[i]);
+				}
+			}
+			ImGui::TableHeadersRow();
+
+			uint32_t scope_index = 0;
+			while (scope_index < data->display_scopes.size())
+			{
+				scope_index = RenderScopeRows(scope_index);
+			}
+
+			ImGui::EndTable();
+		}
+	}
+
+}
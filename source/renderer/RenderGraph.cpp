@@ -0,0 +1,575 @@
+#include "Precomp.h"
+#include "renderer/RenderGraph.h"
+#include "renderer/GPUProfiler.h"
+#include "renderer/vulkan/VulkanCommands.h"
+#include "renderer/vulkan/VulkanResourceTracker.h"
+#include "renderer/vulkan/VulkanSync.h"
+#include "renderer/vulkan/VulkanBackend.h"
+#include "renderer/vulkan/VulkanUtils.h"
+
+#include "vulkan/vk_enum_string_helper.h"
+
+static constexpr VkAccessFlags2 WRITE_ACCESS_FLAGS = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+	VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT |
+	VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+
+static inline bool IsWriteAccess(VkAccessFlags2 access_flags)
+{
+	return (access_flags & WRITE_ACCESS_FLAGS) != 0;
+}
+
+static inline bool IsReadAccess(VkAccessFlags2 access_flags)
+{
+	return (access_flags & ~WRITE_ACCESS_FLAGS) != 0;
+}
+
+static inline const char* ResourceAccessToString(Flags access)
+{
+	switch (access)
+	{
+	case RenderGraph::RESOURCE_ACCESS_READ: return "read";
+	case RenderGraph::RESOURCE_ACCESS_WRITE: return "write";
+	case RenderGraph::RESOURCE_ACCESS_READ_WRITE: return "read/write";
+	default: return "none";
+	}
+}
+
+void RenderGraph::Destroy()
+{
+	for (auto& frame_events : m_events)
+	{
+		for (auto& vk_event : frame_events)
+			Vulkan::Sync::DestroyDeviceEvent(vk_event);
+
+		frame_events.clear();
+	}
+}
+
+void RenderGraph::Reset()
+{
+	m_resources.clear();
+	m_passes.clear();
+}
+
+RenderGraph::ResourceID RenderGraph::ImportImage(const std::string& name, const VulkanImage* image, bool transient)
+{
+	return AddResource({ .name = name, .image = image, .transient = transient });
+}
+
+RenderGraph::ResourceID RenderGraph::ImportBuffer(const std::string& name, const VulkanBuffer* buffer)
+{
+	return AddResource({ .name = name, .buffer = buffer });
+}
+
+void RenderGraph::MarkOutput(ResourceID resource)
+{
+	VK_ASSERT(resource < m_resources.size() && "Tried to mark an invalid resource as a render graph output");
+	m_resources[resource].output = true;
+}
+
+void RenderGraph::AddPass(PassInfo&& pass_info)
+{
+	VK_ASSERT(pass_info.execute && "Tried to add a render graph pass without an execute function");
+	m_passes.push_back({ .info = std::move(pass_info) });
+}
+
+bool RenderGraph::Compile()
+{
+	// Walk the passes back to front, a pass is only needed if it writes a resource that is read by a later pass, or is an output of the graph
+	std::vector<bool> needed(m_resources.size(), false);
+	for (ResourceID resource = 0; resource < m_resources.size(); ++resource)
+	{
+		needed[resource] = m_resources[resource].output;
+	}
+
+	for (int32_t pass_index = static_cast<int32_t>(m_passes.size()) - 1; pass_index >= 0; --pass_index)
+	{
+		Pass& pass = m_passes[pass_index];
+		bool pass_needed = pass.info.has_side_effects;
+
+		for (const auto& usage : pass.info.images)
+			pass_needed |= (usage.access & RESOURCE_ACCESS_WRITE) && needed[usage.resource];
+		for (const auto& usage : pass.info.buffers)
+			pass_needed |= IsWriteAccess(usage.access_flags) && needed[usage.resource];
+
+		pass.culled = !pass_needed;
+		if (pass.culled)
+			continue;
+
+		// Resources written by this pass are not needed from earlier passes, unless this pass reads them as well
+		for (const auto& usage : pass.info.images)
+		{
+			if (usage.access & RESOURCE_ACCESS_WRITE)
+				needed[usage.resource] = false;
+		}
+		for (const auto& usage : pass.info.buffers)
+		{
+			if (IsWriteAccess(usage.access_flags))
+				needed[usage.resource] = false;
+		}
+
+		for (const auto& usage : pass.info.images)
+		{
+			if (usage.access & RESOURCE_ACCESS_READ)
+				needed[usage.resource] = true;
+		}
+		for (const auto& usage : pass.info.buffers)
+		{
+			if (IsReadAccess(usage.access_flags))
+				needed[usage.resource] = true;
+		}
+	}
+
+	// Determine the lifetime of each resource from the passes that were not culled
+	for (auto& resource : m_resources)
+	{
+		resource.first_pass = UINT32_MAX;
+		resource.last_pass = 0;
+	}
+
+	for (uint32_t pass_index = 0; pass_index < m_passes.size(); ++pass_index)
+	{
+		const Pass& pass = m_passes[pass_index];
+		if (pass.culled)
+			continue;
+
+		auto extend_lifetime = [this, pass_index](ResourceID id)
+		{
+			m_resources[id].first_pass = std::min(m_resources[id].first_pass, pass_index);
+			m_resources[id].last_pass = std::max(m_resources[id].last_pass, pass_index);
+		};
+
+		for (const auto& usage : pass.info.images)
+			extend_lifetime(usage.resource);
+		for (const auto& usage : pass.info.buffers)
+			extend_lifetime(usage.resource);
+	}
+
+	// Outputs are used after the graph has executed, so they need to stay alive until the end of the frame
+	for (auto& resource : m_resources)
+	{
+		if (resource.output && resource.first_pass != UINT32_MAX)
+			resource.last_pass = static_cast<uint32_t>(m_passes.size());
+	}
+
+	// Greedily assign the transient images to alias groups in order of first use, images that are unused this frame can share memory with any group
+	std::vector<ResourceID> transient_images;
+	for (ResourceID resource = 0; resource < m_resources.size(); ++resource)
+	{
+		if (m_resources[resource].image && m_resources[resource].transient)
+			transient_images.push_back(resource);
+	}
+
+	std::stable_sort(transient_images.begin(), transient_images.end(), [this](ResourceID first, ResourceID second) {
+		return m_resources[first].first_pass < m_resources[second].first_pass;
+	});
+
+	std::vector<std::vector<ResourceID>> alias_groups;
+	for (ResourceID resource : transient_images)
+	{
+		auto group = std::find_if(alias_groups.begin(), alias_groups.end(), [this, resource](const std::vector<ResourceID>& group) {
+			return std::none_of(group.begin(), group.end(), [this, resource](ResourceID other) { return DoLifetimesOverlap(resource, other); });
+		});
+
+		if (group != alias_groups.end())
+			group->push_back(resource);
+		else
+			alias_groups.push_back({ resource });
+	}
+
+	std::vector<std::vector<std::string>> alias_group_names(alias_groups.size());
+	for (size_t group_index = 0; group_index < alias_groups.size(); ++group_index)
+	{
+		for (ResourceID resource : alias_groups[group_index])
+			alias_group_names[group_index].push_back(m_resources[resource].name);
+	}
+
+	bool alias_groups_changed = alias_group_names != m_alias_groups;
+	m_alias_groups = std::move(alias_group_names);
+
+	return alias_groups_changed;
+}
+
+void RenderGraph::Execute(VulkanCommandBuffer& command_buffer, VulkanCommandBuffer* async_command_buffer)
+{
+	struct BufferState
+	{
+		bool accessed = false;
+		VkAccessFlags2 write_access_flags = VK_ACCESS_2_NONE;
+		VkPipelineStageFlags2 write_stage_flags = VK_PIPELINE_STAGE_2_NONE;
+		// Stages that have been made visible to since the last write, and that a new write needs to wait on
+		VkPipelineStageFlags2 read_stage_flags = VK_PIPELINE_STAGE_2_NONE;
+	};
+
+	struct ImageState
+	{
+		bool accessed = false;
+		bool written = false;
+	};
+
+	struct SignaledSplitBarrier
+	{
+		uint32_t consumer_pass = UINT32_MAX;
+		VulkanSplitBarrier split_barrier;
+	};
+
+	std::vector<ImageState> image_states(m_resources.size());
+	std::vector<BufferState> buffer_states(m_resources.size());
+
+	// Builds the barrier for an image usage and updates the resource tracker, returns false if no barrier is needed
+	auto build_image_barrier = [this, &image_states](const ImageUsage& usage, VkImageMemoryBarrier2& image_barrier)
+	{
+		const Resource& resource = m_resources[usage.resource];
+		ImageState& state = image_states[usage.resource];
+
+		VulkanImageBarrier barrier = { .image = *resource.image, .new_layout = usage.layout };
+		bool write = usage.access & RESOURCE_ACCESS_WRITE;
+
+		// Subsequent reads in the same layout do not need another barrier
+		if (state.accessed && !state.written && !write &&
+			Vulkan::ResourceTracker::GetImageLayout(barrier) == usage.layout)
+			return false;
+
+		image_barrier = Vulkan::ResourceTracker::ImageMemoryBarrier(barrier);
+		if (resource.transient && !state.accessed)
+		{
+			// Transient images might share memory with another image that was used before, so wait for all prior work
+			// The contents do not need to be preserved if the first use does not read from it
+			image_barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			image_barrier.srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
+			if (!(usage.access & RESOURCE_ACCESS_READ))
+				image_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		}
+
+		Vulkan::ResourceTracker::UpdateImageAccessAndStageFlags(barrier);
+
+		state.accessed = true;
+		state.written = write;
+
+		return true;
+	};
+
+	// Builds the barrier for a buffer usage and updates the resource tracker, returns false if no barrier is needed
+	auto build_buffer_barrier = [this, &buffer_states](const BufferUsage& usage, VkBufferMemoryBarrier2& buffer_barrier)
+	{
+		const Resource& resource = m_resources[usage.resource];
+		BufferState& state = buffer_states[usage.resource];
+
+		VulkanBufferBarrier barrier = {
+			.buffer = *resource.buffer,
+			.dst_access_flags = usage.access_flags,
+			.dst_stage_flags = usage.stage_flags
+		};
+
+		if (!state.accessed)
+		{
+			// The buffer might still be in use by the previous frame
+			barrier.src_access_flags = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+			barrier.src_stage_flags = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		}
+		else if (IsWriteAccess(usage.access_flags))
+		{
+			// Write after read only needs an execution dependency on the readers, write after write needs the previous write to be made available
+			barrier.src_access_flags = state.write_access_flags;
+			barrier.src_stage_flags = state.write_stage_flags | state.read_stage_flags;
+		}
+		else
+		{
+			if ((state.read_stage_flags & usage.stage_flags) == usage.stage_flags)
+				return false;
+
+			barrier.src_access_flags = state.write_access_flags;
+			barrier.src_stage_flags = state.write_stage_flags;
+		}
+
+		if (barrier.src_stage_flags == VK_PIPELINE_STAGE_2_NONE)
+			return false;
+
+		Vulkan::ResourceTracker::UpdateBufferAccessAndStageFlags(barrier);
+		buffer_barrier = Vulkan::ResourceTracker::BufferMemoryBarrier(barrier);
+
+		state.accessed = true;
+		if (IsWriteAccess(usage.access_flags))
+		{
+			state.write_access_flags = usage.access_flags & WRITE_ACCESS_FLAGS;
+			state.write_stage_flags = usage.stage_flags;
+			state.read_stage_flags = VK_PIPELINE_STAGE_2_NONE;
+		}
+		else
+		{
+			state.read_stage_flags |= usage.stage_flags;
+		}
+
+		return true;
+	};
+
+	std::vector<uint32_t> live_passes;
+	for (uint32_t pass_index = 0; pass_index < m_passes.size(); ++pass_index)
+	{
+		Pass& pass = m_passes[pass_index];
+		pass.executed_async = pass.info.async_compute && async_command_buffer;
+
+		if (!pass.culled)
+			live_passes.push_back(pass_index);
+	}
+
+	// Resources that were last accessed on the async compute queue, graphics passes using them need the graphics submission to wait
+	std::vector<bool> last_accessed_async(m_resources.size(), false);
+	m_async_compute_wait_stages = VK_PIPELINE_STAGE_2_NONE;
+
+	// Finds the next live pass after the given one that uses the resource, and the index of the usage in that pass
+	auto find_next_usage = [this, &live_passes](uint32_t live_index, ResourceID resource, bool image, uint32_t& usage_index) -> uint32_t
+	{
+		for (uint32_t next = live_index + 1; next < live_passes.size(); ++next)
+		{
+			const PassInfo& info = m_passes[live_passes[next]].info;
+
+			if (image)
+			{
+				auto usage = std::find_if(info.images.begin(), info.images.end(), [resource](const ImageUsage& usage) { return usage.resource == resource; });
+				if (usage != info.images.end())
+				{
+					usage_index = static_cast<uint32_t>(usage - info.images.begin());
+					return next;
+				}
+			}
+			else
+			{
+				auto usage = std::find_if(info.buffers.begin(), info.buffers.end(), [resource](const BufferUsage& usage) { return usage.resource == resource; });
+				if (usage != info.buffers.end())
+				{
+					usage_index = static_cast<uint32_t>(usage - info.buffers.begin());
+					return next;
+				}
+			}
+		}
+
+		return UINT32_MAX;
+	};
+
+	// Usages that already had their barrier recorded as part of a split barrier
+	std::vector<std::vector<bool>> split_image_usages(m_passes.size());
+	std::vector<std::vector<bool>> split_buffer_usages(m_passes.size());
+	for (uint32_t pass_index = 0; pass_index < m_passes.size(); ++pass_index)
+	{
+		split_image_usages[pass_index].resize(m_passes[pass_index].info.images.size(), false);
+		split_buffer_usages[pass_index].resize(m_passes[pass_index].info.buffers.size(), false);
+	}
+
+	std::vector<VkEvent>& events = m_events[Vulkan::GetCurrentFrameIndex() % Vulkan::GetNumFramesInFlight()];
+	uint32_t num_events_used = 0;
+
+	std::vector<SignaledSplitBarrier> signaled_split_barriers;
+	std::vector<VkImageMemoryBarrier2> image_barriers;
+	std::vector<VkBufferMemoryBarrier2> buffer_barriers;
+
+	for (uint32_t live_index = 0; live_index < live_passes.size(); ++live_index)
+	{
+		uint32_t pass_index = live_passes[live_index];
+		Pass& pass = m_passes[pass_index];
+		VulkanCommandBuffer& pass_command_buffer = pass.executed_async ? *async_command_buffer : command_buffer;
+
+		for (const auto& usage : pass.info.images)
+		{
+			if (!pass.executed_async && last_accessed_async[usage.resource])
+				m_async_compute_wait_stages |= Vulkan::Util::GetPipelineStageFlagsFromImageLayout(usage.layout);
+			last_accessed_async[usage.resource] = pass.executed_async;
+		}
+		for (const auto& usage : pass.info.buffers)
+		{
+			if (!pass.executed_async && last_accessed_async[usage.resource])
+				m_async_compute_wait_stages |= usage.stage_flags;
+			last_accessed_async[usage.resource] = pass.executed_async;
+		}
+
+		// Wait on the split barriers that were signaled by earlier passes for this pass
+		pass.num_split_barriers = 0;
+		for (const auto& signaled : signaled_split_barriers)
+		{
+			if (signaled.consumer_pass != pass_index)
+				continue;
+
+			Vulkan::Command::WaitSplitBarrier(pass_command_buffer, signaled.split_barrier);
+			pass.num_split_barriers += static_cast<uint32_t>(signaled.split_barrier.image_barriers.size() + signaled.split_barrier.buffer_barriers.size());
+		}
+
+		image_barriers.clear();
+		buffer_barriers.clear();
+
+		for (uint32_t usage_index = 0; usage_index < pass.info.images.size(); ++usage_index)
+		{
+			VkImageMemoryBarrier2 image_barrier;
+			if (!split_image_usages[pass_index][usage_index] && build_image_barrier(pass.info.images[usage_index], image_barrier))
+				image_barriers.push_back(image_barrier);
+		}
+
+		for (uint32_t usage_index = 0; usage_index < pass.info.buffers.size(); ++usage_index)
+		{
+			VkBufferMemoryBarrier2 buffer_barrier;
+			if (!split_buffer_usages[pass_index][usage_index] && build_buffer_barrier(pass.info.buffers[usage_index], buffer_barrier))
+				buffer_barriers.push_back(buffer_barrier);
+		}
+
+		// The barriers are merged with any transitions the pass queues itself, and flushed by the first command that depends on them
+		pass.num_barriers = static_cast<uint32_t>(image_barriers.size() + buffer_barriers.size());
+		Vulkan::Command::QueueBarriers(pass_command_buffer, image_barriers, buffer_barriers);
+
+		GPUProfiler::BeginScope(pass_command_buffer, pass.info.name);
+		pass.info.execute(pass_command_buffer);
+		GPUProfiler::EndScope(pass_command_buffer);
+
+		// If the next pass using a resource is not the next pass that executes, the barrier for it is built right away and signaled after this pass,
+		// so that the other work in between can overlap with the transition, the resource is not touched by that work so its state does not change
+		std::vector<SignaledSplitBarrier> pass_split_barriers;
+		auto get_split_barrier = [&pass_split_barriers](uint32_t consumer_pass) -> VulkanSplitBarrier&
+		{
+			auto split = std::find_if(pass_split_barriers.begin(), pass_split_barriers.end(),
+				[consumer_pass](const SignaledSplitBarrier& split) { return split.consumer_pass == consumer_pass; });
+			if (split != pass_split_barriers.end())
+				return split->split_barrier;
+
+			return pass_split_barriers.emplace_back(SignaledSplitBarrier{ .consumer_pass = consumer_pass }).split_barrier;
+		};
+
+		for (const auto& usage : pass.info.images)
+		{
+			uint32_t next_usage_index = 0;
+			uint32_t next_live_index = find_next_usage(live_index, usage.resource, true, next_usage_index);
+			if (next_live_index == UINT32_MAX || next_live_index == live_index + 1)
+				continue;
+
+			// Events can only be waited on by the queue that signaled them
+			uint32_t consumer_pass = live_passes[next_live_index];
+			if (split_image_usages[consumer_pass][next_usage_index] || m_passes[consumer_pass].executed_async != pass.executed_async)
+				continue;
+
+			VkImageMemoryBarrier2 image_barrier;
+			if (build_image_barrier(m_passes[consumer_pass].info.images[next_usage_index], image_barrier))
+			{
+				get_split_barrier(consumer_pass).image_barriers.push_back(image_barrier);
+				split_image_usages[consumer_pass][next_usage_index] = true;
+			}
+		}
+
+		for (const auto& usage : pass.info.buffers)
+		{
+			uint32_t next_usage_index = 0;
+			uint32_t next_live_index = find_next_usage(live_index, usage.resource, false, next_usage_index);
+			if (next_live_index == UINT32_MAX || next_live_index == live_index + 1)
+				continue;
+
+			uint32_t consumer_pass = live_passes[next_live_index];
+			if (split_buffer_usages[consumer_pass][next_usage_index] || m_passes[consumer_pass].executed_async != pass.executed_async)
+				continue;
+
+			VkBufferMemoryBarrier2 buffer_barrier;
+			if (build_buffer_barrier(m_passes[consumer_pass].info.buffers[next_usage_index], buffer_barrier))
+			{
+				get_split_barrier(consumer_pass).buffer_barriers.push_back(buffer_barrier);
+				split_buffer_usages[consumer_pass][next_usage_index] = true;
+			}
+		}
+
+		if (pass_split_barriers.empty())
+			continue;
+
+		// Anything the pass queued has to be recorded before the event is signaled
+		Vulkan::Command::FlushBarriers(pass_command_buffer);
+
+		for (auto& split : pass_split_barriers)
+		{
+			if (num_events_used == events.size())
+				events.push_back(Vulkan::Sync::CreateDeviceEvent(std::format("Render Graph Split Barrier {}", events.size())));
+
+			split.split_barrier.vk_event = events[num_events_used++];
+			Vulkan::Command::SignalSplitBarrier(pass_command_buffer, split.split_barrier);
+
+			signaled_split_barriers.push_back(std::move(split));
+		}
+	}
+}
+
+VkPipelineStageFlags2 RenderGraph::GetAsyncComputeWaitStages() const
+{
+	return m_async_compute_wait_stages;
+}
+
+const std::vector<std::vector<std::string>>& RenderGraph::GetAliasGroups() const
+{
+	return m_alias_groups;
+}
+
+std::string RenderGraph::Dump() const
+{
+	uint32_t num_culled_passes = static_cast<uint32_t>(std::count_if(m_passes.begin(), m_passes.end(), [](const Pass& pass) { return pass.culled; }));
+
+	std::string dump = std::format("{} passes ({} culled), {} resources, {} alias groups\n",
+		m_passes.size(), num_culled_passes, m_resources.size(), m_alias_groups.size());
+
+	for (uint32_t pass_index = 0; pass_index < m_passes.size(); ++pass_index)
+	{
+		const Pass& pass = m_passes[pass_index];
+		if (pass.culled)
+		{
+			dump += std::format("[{}] {} (culled)\n", pass_index, pass.info.name);
+			continue;
+		}
+
+		dump += std::format("[{}] {} ({} barriers, {} split barriers){}\n", pass_index, pass.info.name, pass.num_barriers, pass.num_split_barriers,
+			pass.executed_async ? " (async compute)" : "");
+
+		for (const auto& usage : pass.info.images)
+		{
+			dump += std::format("    {} {} as {}\n", ResourceAccessToString(usage.access),
+				m_resources[usage.resource].name, string_VkImageLayout(usage.layout));
+		}
+
+		for (const auto& usage : pass.info.buffers)
+		{
+			Flags access = (IsReadAccess(usage.access_flags) ? RESOURCE_ACCESS_READ : 0) | (IsWriteAccess(usage.access_flags) ? RESOURCE_ACCESS_WRITE : 0);
+			dump += std::format("    {} {} in {}\n", ResourceAccessToString(access),
+				m_resources[usage.resource].name, string_VkPipelineStageFlags2(usage.stage_flags));
+		}
+	}
+
+	dump += "Resources\n";
+	for (const auto& resource : m_resources)
+	{
+		if (resource.first_pass == UINT32_MAX)
+			dump += std::format("    {} (unused)\n", resource.name);
+		else
+			dump += std::format("    {} passes {}-{}{}\n", resource.name, resource.first_pass, resource.last_pass, resource.transient ? " (transient)" : "");
+	}
+
+	dump += "Alias groups\n";
+	for (size_t group_index = 0; group_index < m_alias_groups.size(); ++group_index)
+	{
+		std::string names;
+		for (const auto& name : m_alias_groups[group_index])
+			names += names.empty() ? name : ", " + name;
+
+		dump += std::format("    {}: {}\n", group_index, names);
+	}
+
+	return dump;
+}
+
+RenderGraph::ResourceID RenderGraph::AddResource(Resource&& resource)
+{
+	m_resources.push_back(std::move(resource));
+	return static_cast<ResourceID>(m_resources.size() - 1);
+}
+
+bool RenderGraph::IsResourceUsed(ResourceID resource) const
+{
+	return m_resources[resource].first_pass != UINT32_MAX;
+}
+
+bool RenderGraph::DoLifetimesOverlap(ResourceID first, ResourceID second) const
+{
+	if (!IsResourceUsed(first) || !IsResourceUsed(second))
+		return false;
+
+	return m_resources[first].first_pass <= m_resources[second].last_pass &&
+		m_resources[second].first_pass <= m_resources[first].last_pass;
+}
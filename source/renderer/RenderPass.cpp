@@ -55,7 +55,9 @@ void RenderPass::BeginStage(VulkanCommandBuffer& command_buffer, uint32_t stage_
 		}
 	}
 
-	Vulkan::Command::TransitionLayouts(command_buffer, attachment_transitions);
+	// Attachments are usually already transitioned by the render graph before the stage begins
+	if (!attachment_transitions.empty())
+		Vulkan::Command::TransitionLayouts(command_buffer, attachment_transitions);
 
 	if (stage.pipeline.type == VULKAN_PIPELINE_TYPE_GRAPHICS)
 	{
@@ -107,7 +109,21 @@ void RenderPass::SetStageAttachment(uint32_t stage_index, RenderPass::Attachment
 	m_stages[stage_index].attachments[slot].view = attachment_view;
 }
 
+void RenderPass::ReplacePipeline(const VulkanPipeline& old_pipeline, const VulkanPipeline& new_pipeline)
+{
+	for (auto& stage : m_stages)
+	{
+		if (stage.pipeline.vk_pipeline == old_pipeline.vk_pipeline)
+			stage.pipeline = new_pipeline;
+	}
+}
+
 uint32_t RenderPass::GetStageCount()
 {
 	return static_cast<uint32_t>(m_stages.size());
 }
+
+const std::string& RenderPass::GetStageName(uint32_t stage_index) const
+{
+	return m_stages[stage_index].name;
+}
@@ -24,6 +24,7 @@ std::string TextureFormatToString(TextureFormat format)
 		case TEXTURE_FORMAT_RGBA16_SFLOAT: return "RGBA16_SFLOAT";
 		case TEXTURE_FORMAT_RGBA32_SFLOAT: return "RGBA32_SFLOAT";
 		case TEXTURE_FORMAT_RG16_SFLOAT: return "RG16_SFLOAT";
+		case TEXTURE_FORMAT_RG32_UINT: return "RG32_UINT";
 		case TEXTURE_FORMAT_D32_SFLOAT: return "D32_SFLOAT";
 	}
 
@@ -3,6 +3,7 @@
 #include "renderer/vulkan/VulkanBackend.h"
 #include "renderer/vulkan/VulkanSwapChain.h"
 #include "renderer/vulkan/VulkanBuffer.h"
+#include "renderer/vulkan/VulkanDeviceMemory.h"
 #include "renderer/vulkan/VulkanImage.h"
 #include "renderer/vulkan/VulkanImageView.h"
 #include "renderer/vulkan/VulkanCommandQueue.h"
@@ -10,14 +11,19 @@
 #include "renderer/vulkan/VulkanCommandBuffer.h"
 #include "renderer/vulkan/VulkanCommands.h"
 #include "renderer/vulkan/VulkanSync.h"
+#include "renderer/vulkan/VulkanQuery.h"
 #include "renderer/vulkan/VulkanDescriptor.h"
 #include "renderer/vulkan/VulkanRaytracing.h"
 #include "renderer/vulkan/VulkanUtils.h"
 #include "renderer/RenderPass.h"
+#include "renderer/RenderGraph.h"
+#include "renderer/GPUProfiler.h"
 #include "renderer/RingBuffer.h"
+#include "FrustumCulling.h"
 #include "ResourceSlotmap.h"
 #include "Shared.glsl.h"
 #include "assets/AssetTypes.h"
+#include "FileIO.h"
 
 // Used for area lights
 #include "renderer/LTCMatrices.h"
@@ -36,9 +42,11 @@ namespace Renderer
 
 #define RENDER_PASS_BEGIN(render_pass) { RenderPass& current_pass = *render_pass
 #define RENDER_PASS_STAGE_BEGIN(stage_index, command_buffer, render_width, render_height) VK_ASSERT(stage_index < current_pass.GetStageCount() && "Tried to begin more render pass stages than the render pass supports"); \
+	GPUProfiler::BeginScope(command_buffer, current_pass.GetStageName(stage_index), true); \
 	current_pass.BeginStage(command_buffer, stage_index, render_width, render_height)
 #define RENDER_PASS_STAGE_SET_ATTACHMENT(stage_index, attachment_slot, image_view) current_pass.SetStageAttachment(stage_index, attachment_slot, image_view)
-#define RENDER_PASS_STAGE_END(stage_index, command_buffer) current_pass.EndStage(command_buffer, stage_index)
+#define RENDER_PASS_STAGE_END(stage_index, command_buffer) current_pass.EndStage(command_buffer, stage_index); \
+	GPUProfiler::EndScope(command_buffer)
 #define RENDER_PASS_END(render_pass) }
 
 	enum RenderPassStage
@@ -46,17 +54,33 @@ namespace Renderer
 		RENDER_PASS_SKYBOX_STAGE_SKYBOX = 0,
 		RENDER_PASS_SKYBOX_NUM_STAGES = 1,
 
+		RENDER_PASS_LIGHT_CULLING_STAGE_CLUSTER_LIGHTS = 0,
+		RENDER_PASS_LIGHT_CULLING_NUM_STAGES = 1,
+
 		RENDER_PASS_GEOMETRY_STAGE_DEPTH_PREPASS = 0,
 		RENDER_PASS_GEOMETRY_STAGE_LIGHTING = 1,
 		RENDER_PASS_GEOMETRY_NUM_STAGES = 2,
 
-		RENDER_PASS_POST_PROCESS_STAGE_TONEMAP_GAMMA_EXPOSURE = 0,
-		RENDER_PASS_POST_PROCESS_NUM_STAGES = 1,
+		RENDER_PASS_VISIBILITY_BUFFER_STAGE_VISIBILITY = 0,
+		RENDER_PASS_VISIBILITY_BUFFER_STAGE_SHADING = 1,
+		RENDER_PASS_VISIBILITY_BUFFER_NUM_STAGES = 2,
+
+		RENDER_PASS_TAA_STAGE_RESOLVE = 0,
+		RENDER_PASS_TAA_NUM_STAGES = 1,
+
+		RENDER_PASS_POST_PROCESS_STAGE_LUMINANCE_HISTOGRAM = 0,
+		RENDER_PASS_POST_PROCESS_STAGE_AUTO_EXPOSURE = 1,
+		RENDER_PASS_POST_PROCESS_STAGE_BLOOM_DOWNSAMPLE = 2,
+		RENDER_PASS_POST_PROCESS_STAGE_BLOOM_UPSAMPLE = 3,
+		RENDER_PASS_POST_PROCESS_STAGE_TONEMAP_GAMMA_EXPOSURE = 4,
+		RENDER_PASS_POST_PROCESS_NUM_STAGES = 5,
 
 		RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_HDR_CUBEMAP = 0,
 		RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_CUBEMAP = 1,
-		RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_PREFILTERED_CUBEMAP = 2,
-		RENDER_PASS_GEN_IBL_CUBEMAPS_NUM_STAGES = 3,
+		RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_SH_PROJECT = 2,
+		RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_SH_EVALUATE = 3,
+		RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_PREFILTERED_CUBEMAP = 4,
+		RENDER_PASS_GEN_IBL_CUBEMAPS_NUM_STAGES = 5,
 
 		RENDER_PASS_BRDF_LUT_STAGE_BRDF_LUT = 0,
 		RENDER_PASS_BRDF_LUT_NUM_STAGES = 1,
@@ -69,10 +93,18 @@ namespace Renderer
 	static constexpr uint32_t IBL_HDR_CUBEMAP_RESOLUTION = 1024;
 	static constexpr uint32_t IBL_IRRADIANCE_CUBEMAP_RESOLUTION = 64;
 	static constexpr uint32_t IBL_IRRADIANCE_CUBEMAP_SAMPLE_MULTIPLIER = 4;
+	// Replaces the brute force irradiance convolution with a projection onto 9 spherical harmonics coefficients
+	static constexpr bool IBL_IRRADIANCE_USE_SPHERICAL_HARMONICS = true;
+	// Resolution of the hdr cubemap mip that is projected onto the spherical harmonics
+	static constexpr uint32_t IBL_IRRADIANCE_SH_SOURCE_RESOLUTION = 64;
 	static constexpr uint32_t IBL_PREFILTERED_CUBEMAP_RESOLUTION = 1024;
 	static constexpr uint32_t IBL_PREFILTERED_CUBEMAP_NUM_SAMPLES = 32;
 	static constexpr uint32_t IBL_BRDF_LUT_RESOLUTION = 1024;
 	static constexpr uint32_t IBL_BRDF_LUT_SAMPLES = 1024;
+	// Bump whenever the IBL generation changes in a way that invalidates previously cached results
+	static constexpr uint32_t IBL_CACHE_VERSION = 1;
+	static constexpr uint32_t IBL_CACHE_MAGIC = 0x43424C49;
+	static constexpr const char* IBL_CACHE_DIRECTORY = "cache/ibl";
 
 	static constexpr std::array<Vertex, 4> UNIT_QUAD_VERTICES =
 	{
@@ -136,22 +168,6 @@ namespace Renderer
 		20, 22, 21, 23, 21, 22
 	};
 
-	static const std::array<glm::mat4, 6> CUBE_FACING_VIEW_MATRICES =
-	{
-		// POSITIVE_X
-		glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-		// NEGATIVE_X
-		glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-		// POSITIVE_Y
-		glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-		// NEGATIVE_Y
-		glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-		// POSITIVE_Z
-		glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-		// NEGATIVE_Z
-		glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-	};
-
 	struct Texture
 	{
 		TextureCreateInfo texture_info;
@@ -201,25 +217,22 @@ namespace Renderer
 	struct IndexBuffer
 	{
 		VulkanBuffer buffer;
+		VulkanDescriptorAllocation descriptor;
 		VkIndexType index_type = VK_INDEX_TYPE_MAX_ENUM;
+		uint32_t index_stride = 0;
 		uint32_t num_indices = 0;
 	};
 
-	struct InstanceBuffer
-	{
-		RingBuffer::Allocation alloc;
-		VulkanDescriptorAllocation descriptor;
-	};
-
 	struct Mesh
 	{
 		VertexBuffer vertex_buffer;
 		IndexBuffer index_buffer;
 		VulkanBuffer blas_buffer;
+		AABB bounds;
 
 		Mesh() = default;
-		explicit Mesh(const VertexBuffer& vertex_buffer, const IndexBuffer& index_buffer, const VulkanBuffer& blas_buffer)
-			: vertex_buffer(vertex_buffer), index_buffer(index_buffer), blas_buffer(blas_buffer)
+		explicit Mesh(const VertexBuffer& vertex_buffer, const IndexBuffer& index_buffer, const VulkanBuffer& blas_buffer, const AABB& bounds)
+			: vertex_buffer(vertex_buffer), index_buffer(index_buffer), blas_buffer(blas_buffer), bounds(bounds)
 		{
 		}
 
@@ -228,11 +241,34 @@ namespace Renderer
 			Vulkan::Descriptor::Free(vertex_buffer.descriptor);
 			Vulkan::Buffer::Destroy(vertex_buffer.buffer);
 
+			Vulkan::Descriptor::Free(index_buffer.descriptor);
 			Vulkan::Buffer::Destroy(index_buffer.buffer);
 			Vulkan::Buffer::Destroy(blas_buffer);
 		}
 	};
 
+	struct Material
+	{
+		// The source parameters are kept so that the material can be edited, the GPU material is resolved from them whenever they change
+		RenderResourceHandle albedo_texture_handle;
+		RenderResourceHandle normal_texture_handle;
+		RenderResourceHandle metallic_roughness_texture_handle;
+
+		glm::vec4 albedo_factor = glm::vec4(1.0f);
+		float metallic_factor = 1.0f;
+		float roughness_factor = 1.0f;
+
+		bool has_clearcoat = false;
+		RenderResourceHandle clearcoat_alpha_texture_handle;
+		RenderResourceHandle clearcoat_normal_texture_handle;
+		RenderResourceHandle clearcoat_roughness_texture_handle;
+
+		float clearcoat_alpha_factor = 1.0f;
+		float clearcoat_roughness_factor = 1.0f;
+
+		GPUMaterial gpu_material = {};
+	};
+
 	struct RenderTarget
 	{
 		VulkanImage image;
@@ -247,11 +283,117 @@ namespace Renderer
 		}
 	};
 
+	// Instance data of the submitted meshes, kept on the GPU across frames, indexed by instance slot
+	// Instances are identified by the handle they are submitted with, which keeps its slot for as long as it is submitted every frame,
+	// so only the instances whose data changed since the previous frame need to be uploaded again, regardless of the submission order
+	struct InstanceBuffer
+	{
+		static constexpr uint32_t INVALID_SLOT = ~0u;
+
+		struct Slot
+		{
+			// Invalid for instances that were submitted without a handle, those only keep their slot for a single frame
+			ResourceHandle_t handle;
+			uint64_t last_submitted_frame = 0;
+			bool is_used = false;
+		};
+
+		VulkanBuffer buffer;
+		VulkanDescriptorAllocation descriptor;
+
+		// Copy of the instance data that is on the GPU once the pending uploads are done, submitted instances are compared against it
+		std::vector<InstanceData> resident_instances;
+		std::vector<Slot> slots;
+		std::vector<uint32_t> free_slots;
+		// None of the slots from here on are in use
+		uint32_t used_slots_end = 0;
+
+		// Indexed by the slot index of the instance handle
+		std::vector<uint32_t> handle_slots;
+		uint64_t frame_index = 0;
+
+		// Instances that changed since the last upload
+		std::vector<uint32_t> dirty_instances;
+		std::vector<VkBufferCopy> copy_regions;
+
+		void Init(uint32_t num_slots)
+		{
+			resident_instances.resize(num_slots);
+			slots.resize(num_slots);
+
+			// Pushed in reverse, so the lowest slots are handed out first
+			free_slots.reserve(num_slots);
+			for (uint32_t slot = num_slots; slot > 0; --slot)
+				free_slots.push_back(slot - 1);
+		}
+
+		// is_resident is false if the slot was assigned to the handle just now, in which case the resident data in the slot is stale
+		uint32_t AcquireSlot(ResourceHandle_t handle, bool& is_resident)
+		{
+			is_resident = false;
+			if (VK_RESOURCE_HANDLE_VALID(handle))
+			{
+				if (handle.index >= handle_slots.size())
+					handle_slots.resize(handle.index + 1, INVALID_SLOT);
+
+				uint32_t slot = handle_slots[handle.index];
+				if (slot != INVALID_SLOT && slots[slot].handle == handle)
+				{
+					// The same handle was submitted twice in one frame, the second instance gets a slot for this frame only
+					if (slots[slot].last_submitted_frame == frame_index)
+					{
+						handle = ResourceHandle_t();
+					}
+					else
+					{
+						slots[slot].last_submitted_frame = frame_index;
+						is_resident = true;
+						return slot;
+					}
+				}
+			}
+
+			VK_ASSERT(!free_slots.empty() && "Exceeded the maximum amount of instances");
+			uint32_t slot = free_slots.back();
+			free_slots.pop_back();
+
+			slots[slot] = { .handle = handle, .last_submitted_frame = frame_index, .is_used = true };
+			used_slots_end = std::max(used_slots_end, slot + 1);
+
+			if (VK_RESOURCE_HANDLE_VALID(handle))
+				handle_slots[handle.index] = slot;
+
+			return slot;
+		}
+
+		// Called once every instance of the frame was submitted, instances that were not submitted this frame give up their slot
+		void ReleaseUnsubmittedSlots()
+		{
+			for (uint32_t slot = 0; slot < used_slots_end; ++slot)
+			{
+				Slot& instance_slot = slots[slot];
+				bool keeps_slot = VK_RESOURCE_HANDLE_VALID(instance_slot.handle) && instance_slot.last_submitted_frame == frame_index;
+				if (!instance_slot.is_used || keeps_slot)
+					continue;
+
+				if (VK_RESOURCE_HANDLE_VALID(instance_slot.handle) && handle_slots[instance_slot.handle.index] == slot)
+					handle_slots[instance_slot.handle.index] = INVALID_SLOT;
+
+				instance_slot = {};
+				free_slots.push_back(slot);
+			}
+
+			frame_index++;
+		}
+	};
+
 	struct DrawList
 	{
 		struct Entry
 		{
 			uint32_t index = 0;
+			// Slot in the instance buffer, which is also the slot of the material in the material UBO
+			uint32_t instance_index = 0;
 			
 			Mesh* mesh = nullptr;
 			GPUMaterial gpu_material = {};
@@ -261,6 +403,16 @@ namespace Renderer
 		uint32_t next_free_entry = 0;
 		std::array<Entry, MAX_DRAW_LIST_ENTRIES> entries;
 
+		// World space bounding spheres of the entries in SoA layout, for the frustum culling kernel
+		std::array<float, MAX_DRAW_LIST_ENTRIES> bounds_x;
+		std::array<float, MAX_DRAW_LIST_ENTRIES> bounds_y;
+		std::array<float, MAX_DRAW_LIST_ENTRIES> bounds_z;
+		std::array<float, MAX_DRAW_LIST_ENTRIES> bounds_radius;
+
+		// Indices of the entries that survived culling, in increasing order, the geometry passes only draw these
+		uint32_t num_visible_entries = 0;
+		std::array<uint32_t, MAX_DRAW_LIST_ENTRIES> visible_entries;
+
 		Entry& GetNextEntry()
 		{
 			VK_ASSERT(next_free_entry < MAX_DRAW_LIST_ENTRIES &&
@@ -282,13 +434,30 @@ namespace Renderer
 	struct Frame
 	{
 		VulkanCommandBuffer command_buffer;
+		VulkanCommandBuffer async_compute_command_buffer;
 
 		struct Sync
 		{
 			VulkanFence render_finished_fence;
 			uint64_t frame_in_flight_fence_value = 0;
+			uint64_t async_compute_fence_value = 0;
 		} sync;
 
+		// Begin and end timestamps of the graphics and async compute command buffers, read back once the frame has finished
+		struct Timestamps
+		{
+			VkQueryPool query_pool = VK_NULL_HANDLE;
+			bool graphics_written = false;
+			bool async_compute_written = false;
+		} timestamps;
+
+		// Render scale the frame was rendered with, the dynamic resolution relates it to the GPU time of the frame
+		float render_scale = 1.0f;
+
+		// When WaitForFrame returned for this frame, after which the input for the frame is sampled, and when the CPU saw the frame finish on the GPU
+		std::chrono::steady_clock::time_point input_sample_time;
+		std::chrono::steady_clock::time_point finished_time;
+
 		struct UBOs
 		{
 			RingBuffer::Allocation settings_ubo;
@@ -308,40 +477,129 @@ namespace Renderer
 			VulkanBuffer tlas_instance_buffer;
 		} raytracing;
 
-		InstanceBuffer instance_buffer;
+		struct Lights
+		{
+			RingBuffer::Allocation area_light_buffer;
+			VulkanDescriptorAllocation area_light_descriptor;
+		} lights;
+
+		// Per cluster light counts copied back from the light cluster buffer, read once the frame has finished
+		struct LightClusterReadback
+		{
+			VulkanBuffer buffer;
+			const uint32_t* light_counts = nullptr;
+			bool written = false;
+		} light_cluster_readback;
 	};
 
 	struct Data
 	{
 		::GLFWwindow* glfw_window;
 
+		// Render targets are allocated at the output resolution, the frame is rendered into the top-left render resolution sub-rect of them
+		// and upscaled to the output resolution by the post-process pass
 		struct Resolution
 		{
 			uint32_t width = 0;
 			uint32_t height = 0;
 		} render_resolution, output_resolution;
 
+		// Scales the render resolution to reach a target GPU frame time, or to a fixed render scale if disabled
+		struct DynamicResolution
+		{
+			bool enabled = false;
+			float target_gpu_ms = 16.0f;
+			float min_render_scale = 0.5f;
+			// Render resolution relative to the output resolution, at most 1
+			float render_scale = 1.0f;
+			// Sharpening applied after upscaling, 0 disables it
+			float sharpness = 0.0f;
+		} dynamic_resolution;
+
+		// Jitters the projection every frame and accumulates the samples over time into a history at the output resolution
+		// Also upsamples from the render resolution to the output resolution, in which case the post-process pass no longer needs to
+		struct TemporalAA
+		{
+			bool enabled = true;
+			// Weight of the current frame in the history
+			float blend_factor = 0.1f;
+
+			uint32_t jitter_index = 0;
+			glm::vec2 jitter = glm::vec2(0.0f);
+
+			// Unjittered view projection of the previous frame, for the motion vectors
+			glm::mat4 prev_view_proj = glm::identity<glm::mat4>();
+			bool prev_view_proj_valid = false;
+
+			// The history render targets are swapped every frame, the resolve reads from one and writes to the other
+			uint32_t history_index = 0;
+			bool history_valid = false;
+		} taa;
+
 		struct CommandQueues
 		{
 			VulkanCommandQueue graphics_compute;
 			VulkanCommandQueue transfer;
+			VulkanCommandQueue compute;
 		} command_queues;
 
 		struct CommandPools
 		{
 			VulkanCommandPool graphics_compute;
 			VulkanCommandPool transfer;
+			VulkanCommandPool compute;
 		} command_pools;
 
+		// Light culling, IBL generation and BLAS builds can run on the async compute queue, overlapped with the graphics work
+		struct AsyncCompute
+		{
+			// Only available if the device has a separate queue for it, otherwise everything would end up on the same queue anyways
+			bool available = false;
+			bool enabled = false;
+
+			// GPU timings of the last finished frame, the overlap is the time both queues were busy at the same time
+			double graphics_ms = 0.0;
+			double async_compute_ms = 0.0;
+			double overlap_ms = 0.0;
+		} async_compute;
+
 		struct Camera
 		{
 			float near_plane = 0.1f;
 			float far_plane = 10000.0f;
 		} camera_settings;
 
+		// The draw list is culled against the view frustum on the CPU, there is no GPU driven culling path that could do it instead
+		struct Culling
+		{
+			bool enabled = true;
+			uint32_t max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+			// Built from the camera matrices of the current frame
+			Frustum view_frustum;
+		} culling;
+
+		struct FramePacing
+		{
+			// Requested number of frames in flight, applied in WaitForFrame since changing it waits for the device to be idle
+			uint32_t num_frames_in_flight = Vulkan::DEFAULT_FRAMES_IN_FLIGHT;
+			bool waited_for_frame = false;
+
+			// The frame limiter sleeps after waiting for the frame, so that the input is sampled after the sleep instead of before it
+			bool frame_limiter_enabled = false;
+			float frame_limiter_fps = 60.0f;
+			std::chrono::steady_clock::time_point next_frame_time;
+
+			// Time from sampling input for a frame to the GPU finishing that frame, which excludes the presentation engine and display
+			// Without calibrated timestamps this uses the time the CPU saw the frame finish, which is an upper bound
+			double latency_ms = 0.0;
+			bool latency_is_upper_bound = false;
+		} frame_pacing;
+
 		// Resource slotmaps
 		ResourceSlotmap<Texture> texture_slotmap;
 		ResourceSlotmap<Mesh> mesh_slotmap;
+		ResourceSlotmap<Material> material_slotmap;
 
 		// Ring buffer
 		RingBuffer ring_buffer;
@@ -351,7 +609,10 @@ namespace Renderer
 		{
 			// Frame render passes
 			std::unique_ptr<RenderPass> skybox;
+			std::unique_ptr<RenderPass> light_culling;
 			std::unique_ptr<RenderPass> geometry;
+			std::unique_ptr<RenderPass> visibility_buffer;
+			std::unique_ptr<RenderPass> taa;
 			std::unique_ptr<RenderPass> post_process;
 			
 			// Resource processing render passes
@@ -366,9 +627,21 @@ namespace Renderer
 		{
 			RenderTarget hdr;
 			RenderTarget depth;
+			RenderTarget visibility;
+			RenderTarget velocity;
 			RenderTarget sdr;
+			// Not transient, since the history needs to survive until the next frame
+			RenderTarget taa_history[2];
+			// Each bloom mip is a separate render target, half the size of the previous one
+			RenderTarget bloom[BLOOM_NUM_MIPS];
+
+			// Memory shared by the render targets in each alias group of the render graph
+			std::vector<VulkanMemory> alias_memory;
 		} render_targets;
 
+		// Frame render graph, rebuilt every frame
+		RenderGraph render_graph;
+
 		struct IBL
 		{
 			RenderResourceHandle brdf_lut_handle;
@@ -378,8 +651,32 @@ namespace Renderer
 
 		// Draw submission list
 		DrawList draw_list;
+		InstanceBuffer instance_buffer;
 		uint32_t num_area_lights;
 
+		// Per cluster light counts and light index lists, written by the light culling pass and read during lighting
+		struct LightClusters
+		{
+			VulkanBuffer buffer;
+			VulkanDescriptorAllocation descriptor;
+
+			// Read back from the last finished frame, clusters with more than LIGHT_CLUSTER_MAX_LIGHTS lights drop the rest
+			uint32_t max_cluster_lights = 0;
+			uint32_t num_overflowing_clusters = 0;
+			uint32_t num_dropped_lights = 0;
+		} light_clusters;
+
+		// Luminance histogram and adapted luminance, kept on the GPU between frames for the eye adaptation
+		struct AutoExposure
+		{
+			VulkanBuffer buffer;
+			VulkanDescriptorAllocation descriptor;
+
+			// The buffer is cleared by the first frame that uses it, after that the auto exposure pass clears the histogram itself
+			bool cleared = false;
+			std::chrono::steady_clock::time_point prev_frame_time;
+		} auto_exposure;
+
 		// Default resources
 		RenderResourceHandle default_white_texture_handle;
 		RenderResourceHandle default_normal_texture_handle;
@@ -404,18 +701,22 @@ namespace Renderer
 		{
 			uint32_t total_vertex_count = 0;
 			uint32_t total_triangle_count = 0;
+			uint32_t num_uploaded_instances = 0;
+			uint32_t num_visible_instances = 0;
 
 			void Reset()
 			{
 				total_vertex_count = 0;
 				total_triangle_count = 0;
+				num_uploaded_instances = 0;
+				num_visible_instances = 0;
 			}
 		} stats;
 	} static *data;
 
 	static inline Frame* GetFrameCurrent()
 	{
-		return &data->per_frame[Vulkan::GetCurrentFrameIndex() % Vulkan::MAX_FRAMES_IN_FLIGHT];
+		return &data->per_frame[Vulkan::GetCurrentFrameIndex() % Vulkan::GetNumFramesInFlight()];
 	}
 
 	static void CreateSyncObjects()
@@ -426,6 +727,146 @@ namespace Renderer
 			data->per_frame[i].sync.render_finished_fence = Vulkan::Sync::CreateFence(VULKAN_FENCE_TYPE_BINARY);
 		}
 	}
+
+	// Queries 0 and 1 are the graphics begin and end timestamps, 2 and 3 the async compute begin and end timestamps
+	static constexpr uint32_t TIMESTAMP_QUERY_GRAPHICS_BEGIN = 0;
+	static constexpr uint32_t TIMESTAMP_QUERY_ASYNC_COMPUTE_BEGIN = 2;
+	static constexpr uint32_t TIMESTAMP_QUERY_COUNT = 4;
+
+	// The dynamic resolution moves part of the way towards the render scale it wants, since the GPU timings are noisy
+	// and lag the number of frames in flight behind, render scale changes smaller than the minimum step are ignored
+	static constexpr float DYNAMIC_RESOLUTION_DAMPING = 0.2f;
+	static constexpr float DYNAMIC_RESOLUTION_MIN_STEP = 0.01f;
+
+	static void UpdateDynamicResolution(float frame_render_scale, double frame_gpu_ms)
+	{
+		auto& dynamic_resolution = data->dynamic_resolution;
+		if (!dynamic_resolution.enabled || frame_gpu_ms <= 0.0)
+			return;
+
+		// Assumes the GPU time scales with the number of pixels, which is the square of the render scale
+		float wanted_render_scale = frame_render_scale * std::sqrt(static_cast<float>(dynamic_resolution.target_gpu_ms / frame_gpu_ms));
+		wanted_render_scale = std::clamp(wanted_render_scale, dynamic_resolution.min_render_scale, 1.0f);
+
+		float render_scale = dynamic_resolution.render_scale + (wanted_render_scale - dynamic_resolution.render_scale) * DYNAMIC_RESOLUTION_DAMPING;
+		if (std::abs(render_scale - dynamic_resolution.render_scale) >= DYNAMIC_RESOLUTION_MIN_STEP)
+			dynamic_resolution.render_scale = render_scale;
+	}
+
+	// Low discrepancy sequence in [0, 1), the jitter uses bases 2 and 3 so that consecutive samples cover the pixel evenly
+	static float Halton(uint32_t index, uint32_t base)
+	{
+		float result = 0.0f;
+		float fraction = 1.0f;
+
+		while (index > 0)
+		{
+			fraction /= static_cast<float>(base);
+			result += fraction * static_cast<float>(index % base);
+			index /= base;
+		}
+
+		return result;
+	}
+
+	static void ReadFrameTimestamps(Frame* frame)
+	{
+		uint64_t timestamps[TIMESTAMP_QUERY_COUNT] = {};
+
+		if (!frame->timestamps.graphics_written ||
+			!Vulkan::Query::GetResults(frame->timestamps.query_pool, TIMESTAMP_QUERY_GRAPHICS_BEGIN, 2, 1, &timestamps[TIMESTAMP_QUERY_GRAPHICS_BEGIN]))
+			return;
+
+		data->async_compute.graphics_ms = Vulkan::Query::TimestampsToMs(timestamps[0], timestamps[1]);
+		UpdateDynamicResolution(frame->render_scale, data->async_compute.graphics_ms);
+		data->async_compute.async_compute_ms = 0.0;
+		data->async_compute.overlap_ms = 0.0;
+
+		if (frame->timestamps.async_compute_written &&
+			Vulkan::Query::GetResults(frame->timestamps.query_pool, TIMESTAMP_QUERY_ASYNC_COMPUTE_BEGIN, 2, 1, &timestamps[TIMESTAMP_QUERY_ASYNC_COMPUTE_BEGIN]))
+		{
+			data->async_compute.async_compute_ms = Vulkan::Query::TimestampsToMs(timestamps[2], timestamps[3]);
+			data->async_compute.overlap_ms = std::max(0.0, Vulkan::Query::TimestampsToMs(std::max(timestamps[0], timestamps[2]), std::min(timestamps[1], timestamps[3])));
+		}
+
+		// Map the graphics end timestamp to CPU time by sampling the current GPU timestamp together with the CPU time
+		uint64_t gpu_now = 0;
+		std::chrono::steady_clock::time_point cpu_now;
+		std::chrono::steady_clock::time_point gpu_finished_time = frame->finished_time;
+		data->frame_pacing.latency_is_upper_bound = !Vulkan::Query::GetCalibratedTimestamp(gpu_now, cpu_now);
+
+		if (!data->frame_pacing.latency_is_upper_bound)
+		{
+			gpu_finished_time = cpu_now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+				std::chrono::duration<double, std::milli>(Vulkan::Query::TimestampsToMs(timestamps[1], gpu_now)));
+		}
+
+		data->frame_pacing.latency_ms = std::max(0.0, std::chrono::duration<double, std::milli>(gpu_finished_time - frame->input_sample_time).count());
+	}
+
+	static void ReadFrameLightClusters(Frame* frame)
+	{
+		if (!frame->light_cluster_readback.written)
+			return;
+
+		auto& light_clusters = data->light_clusters;
+		light_clusters.max_cluster_lights = 0;
+		light_clusters.num_overflowing_clusters = 0;
+		light_clusters.num_dropped_lights = 0;
+
+		for (uint32_t cluster_index = 0; cluster_index < LIGHT_CLUSTERS_TOTAL; ++cluster_index)
+		{
+			uint32_t num_cluster_lights = frame->light_cluster_readback.light_counts[cluster_index];
+			light_clusters.max_cluster_lights = std::max(light_clusters.max_cluster_lights, num_cluster_lights);
+
+			if (num_cluster_lights > LIGHT_CLUSTER_MAX_LIGHTS)
+			{
+				light_clusters.num_overflowing_clusters++;
+				light_clusters.num_dropped_lights += num_cluster_lights - LIGHT_CLUSTER_MAX_LIGHTS;
+			}
+		}
+	}
+
+	// Sleeping overshoots by up to the scheduler granularity, so the frame limiter sleeps until shortly before the deadline and spins for the rest
+	static constexpr std::chrono::microseconds FRAME_LIMITER_SPIN_DURATION = std::chrono::microseconds(2000);
+
+	static void WaitForFrameLimiter()
+	{
+		auto& pacing = data->frame_pacing;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+		if (!pacing.frame_limiter_enabled || pacing.frame_limiter_fps <= 0.0f)
+		{
+			pacing.next_frame_time = now;
+			return;
+		}
+
+		if (now < pacing.next_frame_time)
+		{
+			if (pacing.next_frame_time - now > FRAME_LIMITER_SPIN_DURATION)
+				std::this_thread::sleep_until(pacing.next_frame_time - FRAME_LIMITER_SPIN_DURATION);
+
+			while (std::chrono::steady_clock::now() < pacing.next_frame_time)
+				std::this_thread::yield();
+
+			now = pacing.next_frame_time;
+		}
+
+		// Frames that are late start a new interval instead of rushing the following frames to catch up
+		pacing.next_frame_time = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>(1.0 / pacing.frame_limiter_fps));
+	}
+
+	// One-off compute work runs on the async compute queue if it is enabled, the callers wait for it to finish
+	static VulkanCommandQueue& GetComputeQueue()
+	{
+		return data->async_compute.enabled ? data->command_queues.compute : data->command_queues.graphics_compute;
+	}
+
+	static VulkanCommandPool& GetComputeCommandPool()
+	{
+		return data->async_compute.enabled ? data->command_pools.compute : data->command_pools.graphics_compute;
+	}
 	
 	static void CreateDefaultSamplers()
 	{
@@ -553,101 +994,253 @@ namespace Renderer
 		data->default_gpu_material.blackbody_radiator = false;
 	}
 
+	static void DestroyRenderTargets()
+	{
+		std::vector<RenderTarget*> render_targets = { &data->render_targets.hdr, &data->render_targets.depth, &data->render_targets.visibility, &data->render_targets.velocity,
+			&data->render_targets.sdr, &data->render_targets.taa_history[0], &data->render_targets.taa_history[1] };
+		for (RenderTarget& bloom_mip : data->render_targets.bloom)
+		{
+			render_targets.push_back(&bloom_mip);
+		}
+
+		for (RenderTarget* render_target : render_targets)
+		{
+			Vulkan::Descriptor::Free(render_target->descriptor);
+			Vulkan::ImageView::Destroy(render_target->view);
+			Vulkan::Image::Destroy(render_target->image);
+		}
+
+		// Aliased render targets do not own their memory, so it can only be freed after all of them are destroyed
+		for (auto& memory : data->render_targets.alias_memory)
+		{
+			Vulkan::DeviceMemory::Free(memory);
+		}
+		data->render_targets.alias_memory.clear();
+	}
+
 	static void CreateRenderTargets()
 	{
-		// Create HDR render target
+		// Remove old render targets
+		DestroyRenderTargets();
+
+		struct RenderTargetInfo
 		{
-			// Remove old HDR render target
-			if (data->render_targets.hdr.image.vk_image)
+			RenderTarget* render_target;
+			TextureCreateInfo texture_info;
+			VulkanDescriptorType descriptor_type;
+			VkImageLayout descriptor_layout;
+		};
+
+		std::vector<RenderTargetInfo> render_target_infos = {
 			{
-				Vulkan::Descriptor::Free(data->render_targets.hdr.descriptor);
-				Vulkan::ImageView::Destroy(data->render_targets.hdr.view);
-				Vulkan::Image::Destroy(data->render_targets.hdr.image);
+				.render_target = &data->render_targets.hdr,
+				.texture_info = {
+					.format = TEXTURE_FORMAT_RGBA16_SFLOAT,
+					.usage_flags = TEXTURE_USAGE_READ_ONLY | TEXTURE_USAGE_RENDER_TARGET,
+					.dimension = TEXTURE_DIMENSION_2D,
+					.width = data->output_resolution.width,
+					.height = data->output_resolution.height,
+					.num_mips = 1,
+					.num_layers = 1,
+					.name = "HDR Render Target"
+				},
+				.descriptor_type = VULKAN_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+				.descriptor_layout = VK_IMAGE_LAYOUT_GENERAL
+			},
+			{
+				.render_target = &data->render_targets.depth,
+				.texture_info = {
+					.format = TEXTURE_FORMAT_D32_SFLOAT,
+					.usage_flags = TEXTURE_USAGE_DEPTH_TARGET,
+					.dimension = TEXTURE_DIMENSION_2D,
+					.width = data->output_resolution.width,
+					.height = data->output_resolution.height,
+					.num_mips = 1,
+					.num_layers = 1,
+					.name = "Depth Render Target"
+				},
+				.descriptor_type = VULKAN_DESCRIPTOR_TYPE_NUM_TYPES
+			},
+			{
+				.render_target = &data->render_targets.visibility,
+				.texture_info = {
+					.format = TEXTURE_FORMAT_RG32_UINT,
+					.usage_flags = TEXTURE_USAGE_SAMPLED | TEXTURE_USAGE_RENDER_TARGET,
+					.dimension = TEXTURE_DIMENSION_2D,
+					.width = data->output_resolution.width,
+					.height = data->output_resolution.height,
+					.num_mips = 1,
+					.num_layers = 1,
+					.name = "Visibility Buffer Render Target"
+				},
+				.descriptor_type = VULKAN_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+				.descriptor_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+			},
+			{
+				.render_target = &data->render_targets.velocity,
+				.texture_info = {
+					.format = TEXTURE_FORMAT_RG16_SFLOAT,
+					.usage_flags = TEXTURE_USAGE_SAMPLED | TEXTURE_USAGE_RENDER_TARGET,
+					.dimension = TEXTURE_DIMENSION_2D,
+					.width = data->output_resolution.width,
+					.height = data->output_resolution.height,
+					.num_mips = 1,
+					.num_layers = 1,
+					.name = "Velocity Render Target"
+				},
+				.descriptor_type = VULKAN_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+				.descriptor_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+			},
+			{
+				.render_target = &data->render_targets.sdr,
+				.texture_info = {
+					.format = TEXTURE_FORMAT_RGBA8_UNORM,
+					.usage_flags = TEXTURE_USAGE_READ_WRITE | TEXTURE_USAGE_RENDER_TARGET | TEXTURE_USAGE_COPY_SRC | TEXTURE_USAGE_COPY_DST,
+					.dimension = TEXTURE_DIMENSION_2D,
+					.width = data->output_resolution.width,
+					.height = data->output_resolution.height,
+					.num_mips = 1,
+					.num_layers = 1,
+					.name = "SDR Render Target"
+				},
+				.descriptor_type = VULKAN_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+				.descriptor_layout = VK_IMAGE_LAYOUT_GENERAL
 			}
+		};
 
-			// Create HDR render target
-			TextureCreateInfo texture_info = {
-				.format = TEXTURE_FORMAT_RGBA16_SFLOAT,
-				.usage_flags = TEXTURE_USAGE_READ_ONLY | TEXTURE_USAGE_RENDER_TARGET,
-				.dimension = TEXTURE_DIMENSION_2D,
-				.width = data->output_resolution.width,
-				.height = data->output_resolution.height,
-				.num_mips = 1,
-				.num_layers = 1,
-				.name = "HDR Render Target"
-			};
-			data->render_targets.hdr.image = Vulkan::Image::Create(texture_info);
+		for (uint32_t i = 0; i < 2; ++i)
+		{
+			render_target_infos.push_back({
+				.render_target = &data->render_targets.taa_history[i],
+				.texture_info = {
+					.format = TEXTURE_FORMAT_RGBA16_SFLOAT,
+					.usage_flags = TEXTURE_USAGE_READ_WRITE,
+					.dimension = TEXTURE_DIMENSION_2D,
+					.width = data->output_resolution.width,
+					.height = data->output_resolution.height,
+					.num_mips = 1,
+					.num_layers = 1,
+					.name = std::format("TAA History Render Target {}", i)
+				},
+				.descriptor_type = VULKAN_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+				.descriptor_layout = VK_IMAGE_LAYOUT_GENERAL
+			});
+		}
 
-			TextureViewCreateInfo view_info = {
-				.format = texture_info.format,
-				.dimension = texture_info.dimension
-			};
-			data->render_targets.hdr.view = Vulkan::ImageView::Create(data->render_targets.hdr.image, view_info);
-			data->render_targets.hdr.descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_STORAGE_IMAGE);
-			Vulkan::Descriptor::Write(data->render_targets.hdr.descriptor, data->render_targets.hdr.view, VK_IMAGE_LAYOUT_GENERAL);
+		// The history render targets were recreated, so their contents are undefined
+		data->taa.history_valid = false;
+
+		for (uint32_t mip = 0; mip < BLOOM_NUM_MIPS; ++mip)
+		{
+			render_target_infos.push_back({
+				.render_target = &data->render_targets.bloom[mip],
+				.texture_info = {
+					.format = TEXTURE_FORMAT_RGBA16_SFLOAT,
+					.usage_flags = TEXTURE_USAGE_READ_WRITE,
+					.dimension = TEXTURE_DIMENSION_2D,
+					.width = std::max(data->output_resolution.width >> (mip + 1), 1u),
+					.height = std::max(data->output_resolution.height >> (mip + 1), 1u),
+					.num_mips = 1,
+					.num_layers = 1,
+					.name = std::format("Bloom Render Target {}", mip)
+				},
+				.descriptor_type = VULKAN_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+				.descriptor_layout = VK_IMAGE_LAYOUT_GENERAL
+			});
+		}
+
+		// Create the images without memory first, the render graph decides which of them can share memory
+		for (auto& info : render_target_infos)
+		{
+			info.render_target->image = Vulkan::Image::Create(info.texture_info, false);
 		}
 
-		// Create depth render target
+		// Render targets that are not part of any alias group yet (before the render graph was compiled for the first time) get their own memory
+		std::vector<std::vector<RenderTargetInfo*>> alias_groups;
+		for (const auto& group_names : data->render_graph.GetAliasGroups())
 		{
-			// Remove old depth render target
-			if (data->render_targets.depth.image.vk_image)
+			std::vector<RenderTargetInfo*>& group = alias_groups.emplace_back();
+			for (const auto& name : group_names)
 			{
-				Vulkan::ImageView::Destroy(data->render_targets.depth.view);
-				Vulkan::Image::Destroy(data->render_targets.depth.image);
+				auto info = std::find_if(render_target_infos.begin(), render_target_infos.end(),
+					[&name](const RenderTargetInfo& target_info) { return target_info.texture_info.name == name; });
+				if (info != render_target_infos.end())
+					group.push_back(&(*info));
 			}
+		}
 
-			// Create SDR render target
-			TextureCreateInfo texture_info = {
-				.format = TEXTURE_FORMAT_D32_SFLOAT,
-				.usage_flags = TEXTURE_USAGE_DEPTH_TARGET,
-				.dimension = TEXTURE_DIMENSION_2D,
-				.width = data->output_resolution.width,
-				.height = data->output_resolution.height,
-				.num_mips = 1,
-				.num_layers = 1,
-				.name = "Depth Render Target"
-			};
-			data->render_targets.depth.image = Vulkan::Image::Create(texture_info);
+		for (auto& info : render_target_infos)
+		{
+			bool in_alias_group = std::any_of(alias_groups.begin(), alias_groups.end(), [&info](const std::vector<RenderTargetInfo*>& group) {
+				return std::find(group.begin(), group.end(), &info) != group.end();
+			});
 
-			TextureViewCreateInfo view_info = {
-				.format = texture_info.format,
-				.dimension = texture_info.dimension
-			};
-			data->render_targets.depth.view = Vulkan::ImageView::Create(data->render_targets.depth.image, view_info);
+			if (!in_alias_group)
+				alias_groups.push_back({ &info });
 		}
 
-		// Create SDR render target
+		for (auto& group : alias_groups)
 		{
-			// Remove old sdr render target
-			if (data->render_targets.sdr.image.vk_image)
+			while (!group.empty())
 			{
-				Vulkan::Descriptor::Free(data->render_targets.sdr.descriptor);
-				Vulkan::ImageView::Destroy(data->render_targets.sdr.view);
-				Vulkan::Image::Destroy(data->render_targets.sdr.image);
-			}
+				// Render targets can only share memory if there is a memory type that all of them support
+				VkMemoryRequirements memory_req = Vulkan::Image::GetMemoryRequirements(group[0]->render_target->image);
+				std::string memory_name = group[0]->texture_info.name;
+				std::vector<RenderTargetInfo*> incompatible;
 
-			TextureCreateInfo texture_info = {
-				.format = TEXTURE_FORMAT_RGBA8_UNORM,
-				.usage_flags = TEXTURE_USAGE_READ_WRITE | TEXTURE_USAGE_RENDER_TARGET | TEXTURE_USAGE_COPY_SRC | TEXTURE_USAGE_COPY_DST,
-				.dimension = TEXTURE_DIMENSION_2D,
-				.width = data->output_resolution.width,
-				.height = data->output_resolution.height,
-				.num_mips = 1,
-				.num_layers = 1,
-				.name = "SDR Render Target"
-			};
-			data->render_targets.sdr.image = Vulkan::Image::Create(texture_info);
+				for (size_t i = 1; i < group.size(); ++i)
+				{
+					VkMemoryRequirements image_memory_req = Vulkan::Image::GetMemoryRequirements(group[i]->render_target->image);
+					if ((memory_req.memoryTypeBits & image_memory_req.memoryTypeBits) == 0)
+					{
+						incompatible.push_back(group[i]);
+						continue;
+					}
+
+					memory_req.size = std::max(memory_req.size, image_memory_req.size);
+					memory_req.alignment = std::max(memory_req.alignment, image_memory_req.alignment);
+					memory_req.memoryTypeBits &= image_memory_req.memoryTypeBits;
+					memory_name += " | " + group[i]->texture_info.name;
+				}
+
+				VulkanMemory memory = Vulkan::DeviceMemory::Allocate(memory_req, GPU_MEMORY_DEVICE_LOCAL, memory_name);
+				data->render_targets.alias_memory.push_back(memory);
+
+				for (RenderTargetInfo* info : group)
+				{
+					if (std::find(incompatible.begin(), incompatible.end(), info) == incompatible.end())
+						Vulkan::Image::BindMemory(info->render_target->image, memory);
+				}
+
+				group = incompatible;
+			}
+		}
 
+		for (auto& info : render_target_infos)
+		{
 			TextureViewCreateInfo view_info = {
-				.format = texture_info.format,
-				.dimension = texture_info.dimension
+				.format = info.texture_info.format,
+				.dimension = info.texture_info.dimension
 			};
-			data->render_targets.sdr.view = Vulkan::ImageView::Create(data->render_targets.sdr.image, view_info);
-			data->render_targets.sdr.descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_STORAGE_IMAGE);
-			Vulkan::Descriptor::Write(data->render_targets.sdr.descriptor, data->render_targets.sdr.view, VK_IMAGE_LAYOUT_GENERAL);
+			info.render_target->view = Vulkan::ImageView::Create(info.render_target->image, view_info);
+
+			if (info.descriptor_type != VULKAN_DESCRIPTOR_TYPE_NUM_TYPES)
+			{
+				info.render_target->descriptor = Vulkan::Descriptor::Allocate(info.descriptor_type);
+				Vulkan::Descriptor::Write(info.render_target->descriptor, info.render_target->view, info.descriptor_layout);
+			}
 		}
 	}
 
+	static std::vector<RenderPass*> GetRenderPasses()
+	{
+		return {
+			data->render_passes.skybox.get(), data->render_passes.light_culling.get(), data->render_passes.geometry.get(),
+			data->render_passes.visibility_buffer.get(), data->render_passes.taa.get(), data->render_passes.post_process.get(), data->render_passes.gen_ibl_cubemaps.get(),
+			data->render_passes.gen_brdf_lut.get(), data->render_passes.imgui.get()
+		};
+	}
+
 	static void CreateRenderPasses()
 	{
 		// Skybox pass
@@ -675,6 +1268,7 @@ namespace Renderer
 			pipeline_info.push_ranges[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
 			RenderPass::Stage& skybox_stage = stages[RENDER_PASS_SKYBOX_STAGE_SKYBOX];
+			skybox_stage.name = "Skybox";
 			skybox_stage.pipeline = Vulkan::CreateGraphicsPipeline(pipeline_info);
 
 			RenderPass::Attachment& skybox_stage_color0 = skybox_stage.attachments[RenderPass::ATTACHMENT_SLOT_COLOR0];
@@ -694,12 +1288,13 @@ namespace Renderer
 			// Depth pre-pass stage
 			{
 				Vulkan::GraphicsPipelineInfo pipeline_info = {};
-				pipeline_info.color_attachment_formats = {};
+				pipeline_info.color_attachment_formats = { TEXTURE_FORMAT_RG16_SFLOAT };
 				pipeline_info.depth_stencil_attachment_format = { TEXTURE_FORMAT_D32_SFLOAT };
 				pipeline_info.depth_test = true;
 				pipeline_info.depth_write = true;
 				pipeline_info.depth_func = VK_COMPARE_OP_LESS_OR_EQUAL;
 				pipeline_info.vs_path = "assets/shaders/DepthPrepass.vert";
+				pipeline_info.fs_path = "assets/shaders/DepthPrepass.frag";
 
 				pipeline_info.push_ranges.resize(1);
 				pipeline_info.push_ranges[0].size = 2 * sizeof(uint32_t);
@@ -707,8 +1302,16 @@ namespace Renderer
 				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
 				RenderPass::Stage& depth_prepass_stage = stages[RENDER_PASS_GEOMETRY_STAGE_DEPTH_PREPASS];
+				depth_prepass_stage.name = "Depth Pre-pass";
 				depth_prepass_stage.pipeline = Vulkan::CreateGraphicsPipeline(pipeline_info);
 
+				RenderPass::Attachment& depth_prepass_color0 = depth_prepass_stage.attachments[RenderPass::ATTACHMENT_SLOT_COLOR0];
+				depth_prepass_color0.info.format = TEXTURE_FORMAT_RG16_SFLOAT;
+				depth_prepass_color0.info.expected_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+				depth_prepass_color0.info.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+				depth_prepass_color0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+				depth_prepass_color0.info.clear_value.color = { VELOCITY_BUFFER_CLEAR_VALUE, VELOCITY_BUFFER_CLEAR_VALUE, 0.0f, 0.0f };
+
 				RenderPass::Attachment& depth_prepass_depth_stencil = depth_prepass_stage.attachments[RenderPass::ATTACHMENT_SLOT_DEPTH_STENCIL];
 				depth_prepass_depth_stencil.info.format = TEXTURE_FORMAT_D32_SFLOAT;
 				depth_prepass_depth_stencil.info.expected_layout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
@@ -738,6 +1341,7 @@ namespace Renderer
 				pipeline_info.push_ranges[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
 				RenderPass::Stage& lighting_stage = stages[RENDER_PASS_GEOMETRY_STAGE_LIGHTING];
+				lighting_stage.name = "Lighting";
 				lighting_stage.pipeline = Vulkan::CreateGraphicsPipeline(pipeline_info);
 
 				RenderPass::Attachment& lighting_stage_color0 = lighting_stage.attachments[RenderPass::ATTACHMENT_SLOT_COLOR0];
@@ -756,118 +1360,378 @@ namespace Renderer
 			data->render_passes.geometry = std::make_unique<RenderPass>(stages);
 		}
 
-		// Post processing pass
-		{
-			std::vector<RenderPass::Stage> stages(RENDER_PASS_POST_PROCESS_NUM_STAGES);
-
-			// Tonemap, gamma correction and exposure stage
-			Vulkan::ComputePipelineInfo pipeline_info = {};
-			pipeline_info.cs_path = "assets/shaders/PostProcessCS.glsl";
-
-			pipeline_info.push_ranges.resize(1);
-			pipeline_info.push_ranges[0].size = 2 * sizeof(uint32_t);
-			pipeline_info.push_ranges[0].offset = 0;
-			pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-
-			RenderPass::Stage& tonemap_stage = stages[RENDER_PASS_POST_PROCESS_STAGE_TONEMAP_GAMMA_EXPOSURE];
-			tonemap_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
-
-			RenderPass::Attachment& tonemap_stage_readonly0 = tonemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_ONLY0];
-			tonemap_stage_readonly0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
-			tonemap_stage_readonly0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
-			tonemap_stage_readonly0.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
-			tonemap_stage_readonly0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
-
-			RenderPass::Attachment& tonemap_stage_readwrite0 = tonemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_WRITE0];
-			tonemap_stage_readwrite0.info.format = TEXTURE_FORMAT_RGBA8_UNORM;
-			tonemap_stage_readwrite0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
-			tonemap_stage_readwrite0.info.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			tonemap_stage_readwrite0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
-			tonemap_stage_readwrite0.info.clear_value.color = { 0.0f, 0.0f, 0.0f, 1.0f };
-
-			data->render_passes.post_process = std::make_unique<RenderPass>(stages);
-		}
-
-		// Generate IBL cubemaps pass
+		// Visibility buffer pass
 		{
-			std::vector<RenderPass::Stage> stages(RENDER_PASS_GEN_IBL_CUBEMAPS_NUM_STAGES);
+			std::vector<RenderPass::Stage> stages(RENDER_PASS_VISIBILITY_BUFFER_NUM_STAGES);
 
-			// Generate HDR cubemap stage
+			// Visibility stage
 			{
 				Vulkan::GraphicsPipelineInfo pipeline_info = {};
-				pipeline_info.color_attachment_formats = { TEXTURE_FORMAT_RGBA16_SFLOAT };
-				pipeline_info.vs_path = "assets/shaders/Cube.vert";
-				pipeline_info.fs_path = "assets/shaders/EquirectangularToCube.frag";
+				pipeline_info.color_attachment_formats = { TEXTURE_FORMAT_RG32_UINT, TEXTURE_FORMAT_RG16_SFLOAT };
+				pipeline_info.depth_stencil_attachment_format = { TEXTURE_FORMAT_D32_SFLOAT };
+				pipeline_info.depth_test = true;
+				pipeline_info.depth_write = true;
+				pipeline_info.depth_func = VK_COMPARE_OP_LESS_OR_EQUAL;
+				pipeline_info.vs_path = "assets/shaders/VisibilityBuffer.vert";
+				pipeline_info.fs_path = "assets/shaders/VisibilityBuffer.frag";
 
-				pipeline_info.push_ranges.resize(2);
-				pipeline_info.push_ranges[0].size = sizeof(glm::mat4) + sizeof(uint32_t);
+				pipeline_info.push_ranges.resize(1);
+				pipeline_info.push_ranges[0].size = 2 * sizeof(uint32_t);
 				pipeline_info.push_ranges[0].offset = 0;
 				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
-				pipeline_info.push_ranges[1].size = 2 * sizeof(uint32_t);
-				pipeline_info.push_ranges[1].offset = pipeline_info.push_ranges[0].size;
-				pipeline_info.push_ranges[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-				RenderPass::Stage& hdr_cubemap_stage = stages[RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_HDR_CUBEMAP];
-				hdr_cubemap_stage.pipeline = Vulkan::CreateGraphicsPipeline(pipeline_info);
-
-				RenderPass::Attachment& hdr_cubemap_color0 = hdr_cubemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_COLOR0];
-				hdr_cubemap_color0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
-				hdr_cubemap_color0.info.expected_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-				hdr_cubemap_color0.info.load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-				hdr_cubemap_color0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+				RenderPass::Stage& visibility_stage = stages[RENDER_PASS_VISIBILITY_BUFFER_STAGE_VISIBILITY];
+				visibility_stage.name = "Visibility";
+				visibility_stage.pipeline = Vulkan::CreateGraphicsPipeline(pipeline_info);
+
+				RenderPass::Attachment& visibility_stage_color0 = visibility_stage.attachments[RenderPass::ATTACHMENT_SLOT_COLOR0];
+				visibility_stage_color0.info.format = TEXTURE_FORMAT_RG32_UINT;
+				visibility_stage_color0.info.expected_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+				visibility_stage_color0.info.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+				visibility_stage_color0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+				visibility_stage_color0.info.clear_value.color.uint32[0] = VISIBILITY_BUFFER_CLEAR_VALUE;
+				visibility_stage_color0.info.clear_value.color.uint32[1] = VISIBILITY_BUFFER_CLEAR_VALUE;
+
+				RenderPass::Attachment& visibility_stage_color1 = visibility_stage.attachments[RenderPass::ATTACHMENT_SLOT_COLOR1];
+				visibility_stage_color1.info.format = TEXTURE_FORMAT_RG16_SFLOAT;
+				visibility_stage_color1.info.expected_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+				visibility_stage_color1.info.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+				visibility_stage_color1.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+				visibility_stage_color1.info.clear_value.color = { VELOCITY_BUFFER_CLEAR_VALUE, VELOCITY_BUFFER_CLEAR_VALUE, 0.0f, 0.0f };
+
+				RenderPass::Attachment& visibility_stage_depth_stencil = visibility_stage.attachments[RenderPass::ATTACHMENT_SLOT_DEPTH_STENCIL];
+				visibility_stage_depth_stencil.info.format = TEXTURE_FORMAT_D32_SFLOAT;
+				visibility_stage_depth_stencil.info.expected_layout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+				visibility_stage_depth_stencil.info.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+				visibility_stage_depth_stencil.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+				visibility_stage_depth_stencil.info.clear_value.depthStencil = { 1.0f, 0 };
 			}
 
-			// Generate irradiance cubemap stage
+			// Shading stage
 			{
 				Vulkan::GraphicsPipelineInfo pipeline_info = {};
 				pipeline_info.color_attachment_formats = { TEXTURE_FORMAT_RGBA16_SFLOAT };
-				pipeline_info.vs_path = "assets/shaders/Cube.vert";
-				pipeline_info.fs_path = "assets/shaders/IrradianceCube.frag";
+				pipeline_info.vs_path = "assets/shaders/Fullscreen.vert";
+				pipeline_info.fs_path = "assets/shaders/VisibilityShading.frag";
 
-				pipeline_info.push_ranges.resize(2);
-				pipeline_info.push_ranges[0].size = sizeof(glm::mat4) + sizeof(uint32_t);
-				pipeline_info.push_ranges[0].offset = 0;
-				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+				// NOTE: Fragment push constants start at the same offset as the forward lighting stage, so both can share the same shading code
+				pipeline_info.push_ranges.resize(1);
+				pipeline_info.push_ranges[0].size = 10 * sizeof(uint32_t);
+				pipeline_info.push_ranges[0].offset = 2 * sizeof(uint32_t);
+				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+				RenderPass::Stage& shading_stage = stages[RENDER_PASS_VISIBILITY_BUFFER_STAGE_SHADING];
+				shading_stage.name = "Shading";
+				shading_stage.pipeline = Vulkan::CreateGraphicsPipeline(pipeline_info);
+
+				RenderPass::Attachment& shading_stage_readonly0 = shading_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_ONLY0];
+				shading_stage_readonly0.info.format = TEXTURE_FORMAT_RG32_UINT;
+				shading_stage_readonly0.info.expected_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				shading_stage_readonly0.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+				shading_stage_readonly0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+
+				RenderPass::Attachment& shading_stage_color0 = shading_stage.attachments[RenderPass::ATTACHMENT_SLOT_COLOR0];
+				shading_stage_color0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+				shading_stage_color0.info.expected_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+				shading_stage_color0.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+				shading_stage_color0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+			}
 
-				pipeline_info.push_ranges[1].size = 2 * sizeof(uint32_t) + 2 * sizeof(float);
-				pipeline_info.push_ranges[1].offset = pipeline_info.push_ranges[0].size;
-				pipeline_info.push_ranges[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+			data->render_passes.visibility_buffer = std::make_unique<RenderPass>(stages);
+		}
 
-				RenderPass::Stage& irradiance_cubemap_stage = stages[RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_CUBEMAP];
-				irradiance_cubemap_stage.pipeline = Vulkan::CreateGraphicsPipeline(pipeline_info);
+		// Light culling pass
+		{
+			std::vector<RenderPass::Stage> stages(RENDER_PASS_LIGHT_CULLING_NUM_STAGES);
+
+			// Assign area lights to froxel clusters stage
+			Vulkan::ComputePipelineInfo pipeline_info = {};
+			pipeline_info.cs_path = "assets/shaders/LightCullingCS.glsl";
+
+			RenderPass::Stage& cluster_lights_stage = stages[RENDER_PASS_LIGHT_CULLING_STAGE_CLUSTER_LIGHTS];
+			cluster_lights_stage.name = "Cluster Lights";
+			cluster_lights_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
+
+			data->render_passes.light_culling = std::make_unique<RenderPass>(stages);
+		}
+
+		// Temporal anti-aliasing pass
+		{
+			std::vector<RenderPass::Stage> stages(RENDER_PASS_TAA_NUM_STAGES);
+
+			// Resolve stage
+			Vulkan::ComputePipelineInfo pipeline_info = {};
+			pipeline_info.cs_path = "assets/shaders/TAAResolveCS.glsl";
+
+			pipeline_info.push_ranges.resize(1);
+			pipeline_info.push_ranges[0].size = 5 * sizeof(uint32_t) + sizeof(float);
+			pipeline_info.push_ranges[0].offset = 0;
+			pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+			RenderPass::Stage& resolve_stage = stages[RENDER_PASS_TAA_STAGE_RESOLVE];
+			resolve_stage.name = "TAA Resolve";
+			resolve_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
+
+			RenderPass::Attachment& resolve_stage_readonly0 = resolve_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_ONLY0];
+			resolve_stage_readonly0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+			resolve_stage_readonly0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
+			resolve_stage_readonly0.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+			resolve_stage_readonly0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+
+			RenderPass::Attachment& resolve_stage_readonly1 = resolve_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_ONLY1];
+			resolve_stage_readonly1.info.format = TEXTURE_FORMAT_RG16_SFLOAT;
+			resolve_stage_readonly1.info.expected_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			resolve_stage_readonly1.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+			resolve_stage_readonly1.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+
+			// The current history is written, the previous history is only read, but there are only two read-only slots
+			RenderPass::Attachment& resolve_stage_readwrite0 = resolve_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_WRITE0];
+			resolve_stage_readwrite0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+			resolve_stage_readwrite0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
+			resolve_stage_readwrite0.info.load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			resolve_stage_readwrite0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+
+			RenderPass::Attachment& resolve_stage_readwrite1 = resolve_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_WRITE1];
+			resolve_stage_readwrite1.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+			resolve_stage_readwrite1.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
+			resolve_stage_readwrite1.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+			resolve_stage_readwrite1.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+
+			data->render_passes.taa = std::make_unique<RenderPass>(stages);
+		}
+
+		// Post processing pass
+		{
+			std::vector<RenderPass::Stage> stages(RENDER_PASS_POST_PROCESS_NUM_STAGES);
+
+			// Luminance histogram stage
+			{
+				Vulkan::ComputePipelineInfo pipeline_info = {};
+				pipeline_info.cs_path = "assets/shaders/LuminanceHistogramCS.glsl";
+
+				pipeline_info.push_ranges.resize(1);
+				pipeline_info.push_ranges[0].size = 4 * sizeof(uint32_t);
+				pipeline_info.push_ranges[0].offset = 0;
+				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+				RenderPass::Stage& histogram_stage = stages[RENDER_PASS_POST_PROCESS_STAGE_LUMINANCE_HISTOGRAM];
+				histogram_stage.name = "Luminance Histogram";
+				histogram_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
 
-				RenderPass::Attachment& irradiance_cubemap_color0 = irradiance_cubemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_COLOR0];
-				irradiance_cubemap_color0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
-				irradiance_cubemap_color0.info.expected_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-				irradiance_cubemap_color0.info.load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-				irradiance_cubemap_color0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+				RenderPass::Attachment& histogram_stage_readonly0 = histogram_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_ONLY0];
+				histogram_stage_readonly0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+				histogram_stage_readonly0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
+				histogram_stage_readonly0.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+				histogram_stage_readonly0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
 			}
 
-			// Generate prefiltered cubemap stage
+			// Auto exposure stage
 			{
-				Vulkan::GraphicsPipelineInfo pipeline_info = {};
-				pipeline_info.color_attachment_formats = { TEXTURE_FORMAT_RGBA16_SFLOAT };
-				pipeline_info.vs_path = "assets/shaders/Cube.vert";
-				pipeline_info.fs_path = "assets/shaders/PrefilteredEnvCube.frag";
+				Vulkan::ComputePipelineInfo pipeline_info = {};
+				pipeline_info.cs_path = "assets/shaders/AutoExposureCS.glsl";
 
-				pipeline_info.push_ranges.resize(2);
-				pipeline_info.push_ranges[0].size = sizeof(glm::mat4) + sizeof(uint32_t);
+				pipeline_info.push_ranges.resize(1);
+				pipeline_info.push_ranges[0].size = 2 * sizeof(uint32_t) + sizeof(float);
 				pipeline_info.push_ranges[0].offset = 0;
-				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
-				pipeline_info.push_ranges[1].size = 3 * sizeof(uint32_t) + sizeof(float);
-				pipeline_info.push_ranges[1].offset = pipeline_info.push_ranges[0].size;
-				pipeline_info.push_ranges[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+				RenderPass::Stage& auto_exposure_stage = stages[RENDER_PASS_POST_PROCESS_STAGE_AUTO_EXPOSURE];
+				auto_exposure_stage.name = "Auto Exposure";
+				auto_exposure_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
+			}
 
-				RenderPass::Stage& prefiltered_cubemap_stage = stages[RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_PREFILTERED_CUBEMAP];
-				prefiltered_cubemap_stage.pipeline = Vulkan::CreateGraphicsPipeline(pipeline_info);
+			// Bloom downsample stage, the bloom mips are transitioned by hand between the dispatches since there are more of them than attachment slots
+			{
+				Vulkan::ComputePipelineInfo pipeline_info = {};
+				pipeline_info.cs_path = "assets/shaders/BloomDownsampleCS.glsl";
+
+				pipeline_info.push_ranges.resize(1);
+				pipeline_info.push_ranges[0].size = 7 * sizeof(uint32_t);
+				pipeline_info.push_ranges[0].offset = 0;
+				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+				RenderPass::Stage& bloom_downsample_stage = stages[RENDER_PASS_POST_PROCESS_STAGE_BLOOM_DOWNSAMPLE];
+				bloom_downsample_stage.name = "Bloom Downsample";
+				bloom_downsample_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
+
+				RenderPass::Attachment& bloom_downsample_stage_readonly0 = bloom_downsample_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_ONLY0];
+				bloom_downsample_stage_readonly0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+				bloom_downsample_stage_readonly0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
+				bloom_downsample_stage_readonly0.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+				bloom_downsample_stage_readonly0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+			}
+
+			// Bloom upsample stage
+			{
+				Vulkan::ComputePipelineInfo pipeline_info = {};
+				pipeline_info.cs_path = "assets/shaders/BloomUpsampleCS.glsl";
+
+				pipeline_info.push_ranges.resize(1);
+				pipeline_info.push_ranges[0].size = 6 * sizeof(uint32_t);
+				pipeline_info.push_ranges[0].offset = 0;
+				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+				RenderPass::Stage& bloom_upsample_stage = stages[RENDER_PASS_POST_PROCESS_STAGE_BLOOM_UPSAMPLE];
+				bloom_upsample_stage.name = "Bloom Upsample";
+				bloom_upsample_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
+			}
+
+			// Bloom composite, tonemap, gamma correction and exposure stage, the first bloom mip is transitioned by the render graph
+			{
+				Vulkan::ComputePipelineInfo pipeline_info = {};
+				pipeline_info.cs_path = "assets/shaders/PostProcessCS.glsl";
+
+				pipeline_info.push_ranges.resize(1);
+				pipeline_info.push_ranges[0].size = 8 * sizeof(uint32_t) + sizeof(float);
+				pipeline_info.push_ranges[0].offset = 0;
+				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+				RenderPass::Stage& tonemap_stage = stages[RENDER_PASS_POST_PROCESS_STAGE_TONEMAP_GAMMA_EXPOSURE];
+				tonemap_stage.name = "Tonemap";
+				tonemap_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
+
+				RenderPass::Attachment& tonemap_stage_readonly0 = tonemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_ONLY0];
+				tonemap_stage_readonly0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+				tonemap_stage_readonly0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
+				tonemap_stage_readonly0.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+				tonemap_stage_readonly0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+
+				RenderPass::Attachment& tonemap_stage_readwrite0 = tonemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_WRITE0];
+				tonemap_stage_readwrite0.info.format = TEXTURE_FORMAT_RGBA8_UNORM;
+				tonemap_stage_readwrite0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
+				tonemap_stage_readwrite0.info.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+				tonemap_stage_readwrite0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+				tonemap_stage_readwrite0.info.clear_value.color = { 0.0f, 0.0f, 0.0f, 1.0f };
+			}
+
+			data->render_passes.post_process = std::make_unique<RenderPass>(stages);
+		}
+
+		// Generate IBL cubemaps pass
+		{
+			std::vector<RenderPass::Stage> stages(RENDER_PASS_GEN_IBL_CUBEMAPS_NUM_STAGES);
+
+			// Generate HDR cubemap stage
+			{
+				Vulkan::ComputePipelineInfo pipeline_info = {};
+				pipeline_info.cs_path = "assets/shaders/EquirectangularToCubeCS.glsl";
+
+				pipeline_info.push_ranges.resize(1);
+				pipeline_info.push_ranges[0].size = 4 * sizeof(uint32_t);
+				pipeline_info.push_ranges[0].offset = 0;
+				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+				RenderPass::Stage& hdr_cubemap_stage = stages[RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_HDR_CUBEMAP];
+				hdr_cubemap_stage.name = "HDR Cubemap";
+				hdr_cubemap_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
+
+				RenderPass::Attachment& hdr_cubemap_readonly0 = hdr_cubemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_ONLY0];
+				hdr_cubemap_readonly0.info.format = TEXTURE_FORMAT_RGBA32_SFLOAT;
+				hdr_cubemap_readonly0.info.expected_layout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+				hdr_cubemap_readonly0.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+				hdr_cubemap_readonly0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+
+				RenderPass::Attachment& hdr_cubemap_readwrite0 = hdr_cubemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_WRITE0];
+				hdr_cubemap_readwrite0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+				hdr_cubemap_readwrite0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
+				hdr_cubemap_readwrite0.info.load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				hdr_cubemap_readwrite0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+			}
+
+			// Generate irradiance cubemap stage
+			{
+				Vulkan::ComputePipelineInfo pipeline_info = {};
+				pipeline_info.cs_path = "assets/shaders/IrradianceCubeCS.glsl";
+
+				pipeline_info.push_ranges.resize(1);
+				pipeline_info.push_ranges[0].size = 4 * sizeof(uint32_t) + 2 * sizeof(float);
+				pipeline_info.push_ranges[0].offset = 0;
+				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+				RenderPass::Stage& irradiance_cubemap_stage = stages[RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_CUBEMAP];
+				irradiance_cubemap_stage.name = "Irradiance Cubemap";
+				irradiance_cubemap_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
+
+				RenderPass::Attachment& irradiance_cubemap_readonly0 = irradiance_cubemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_ONLY0];
+				irradiance_cubemap_readonly0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+				irradiance_cubemap_readonly0.info.expected_layout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+				irradiance_cubemap_readonly0.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+				irradiance_cubemap_readonly0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+
+				RenderPass::Attachment& irradiance_cubemap_readwrite0 = irradiance_cubemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_WRITE0];
+				irradiance_cubemap_readwrite0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+				irradiance_cubemap_readwrite0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
+				irradiance_cubemap_readwrite0.info.load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				irradiance_cubemap_readwrite0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+			}
+
+			// Project hdr cubemap onto spherical harmonics stage
+			{
+				Vulkan::ComputePipelineInfo pipeline_info = {};
+				pipeline_info.cs_path = "assets/shaders/IrradianceSHProjectCS.glsl";
 
-				RenderPass::Attachment& prefiltered_cubemap_color0 = prefiltered_cubemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_COLOR0];
-				prefiltered_cubemap_color0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
-				prefiltered_cubemap_color0.info.expected_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-				prefiltered_cubemap_color0.info.load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-				prefiltered_cubemap_color0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+				pipeline_info.push_ranges.resize(1);
+				pipeline_info.push_ranges[0].size = 5 * sizeof(uint32_t);
+				pipeline_info.push_ranges[0].offset = 0;
+				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+				RenderPass::Stage& sh_project_stage = stages[RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_SH_PROJECT];
+				sh_project_stage.name = "Irradiance SH Project";
+				sh_project_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
+
+				RenderPass::Attachment& sh_project_readonly0 = sh_project_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_ONLY0];
+				sh_project_readonly0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+				sh_project_readonly0.info.expected_layout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+				sh_project_readonly0.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+				sh_project_readonly0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+			}
+
+			// Evaluate spherical harmonics into irradiance cubemap stage
+			{
+				Vulkan::ComputePipelineInfo pipeline_info = {};
+				pipeline_info.cs_path = "assets/shaders/IrradianceSHEvaluateCS.glsl";
+
+				pipeline_info.push_ranges.resize(1);
+				pipeline_info.push_ranges[0].size = 3 * sizeof(uint32_t);
+				pipeline_info.push_ranges[0].offset = 0;
+				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+				RenderPass::Stage& sh_evaluate_stage = stages[RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_SH_EVALUATE];
+				sh_evaluate_stage.name = "Irradiance SH Evaluate";
+				sh_evaluate_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
+
+				RenderPass::Attachment& sh_evaluate_readwrite0 = sh_evaluate_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_WRITE0];
+				sh_evaluate_readwrite0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+				sh_evaluate_readwrite0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
+				sh_evaluate_readwrite0.info.load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				sh_evaluate_readwrite0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+			}
+
+			// Generate prefiltered cubemap stage
+			{
+				Vulkan::ComputePipelineInfo pipeline_info = {};
+				pipeline_info.cs_path = "assets/shaders/PrefilteredEnvCubeCS.glsl";
+
+				pipeline_info.push_ranges.resize(1);
+				pipeline_info.push_ranges[0].size = 6 * sizeof(uint32_t) + sizeof(float);
+				pipeline_info.push_ranges[0].offset = 0;
+				pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+				RenderPass::Stage& prefiltered_cubemap_stage = stages[RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_PREFILTERED_CUBEMAP];
+				prefiltered_cubemap_stage.name = "Prefiltered Cubemap";
+				prefiltered_cubemap_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
+
+				RenderPass::Attachment& prefiltered_cubemap_readonly0 = prefiltered_cubemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_ONLY0];
+				prefiltered_cubemap_readonly0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+				prefiltered_cubemap_readonly0.info.expected_layout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+				prefiltered_cubemap_readonly0.info.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+				prefiltered_cubemap_readonly0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+
+				RenderPass::Attachment& prefiltered_cubemap_readwrite0 = prefiltered_cubemap_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_WRITE0];
+				prefiltered_cubemap_readwrite0.info.format = TEXTURE_FORMAT_RGBA16_SFLOAT;
+				prefiltered_cubemap_readwrite0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
+				prefiltered_cubemap_readwrite0.info.load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				prefiltered_cubemap_readwrite0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
 			}
 
 			data->render_passes.gen_ibl_cubemaps = std::make_unique<RenderPass>(stages);
@@ -878,25 +1742,23 @@ namespace Renderer
 			std::vector<RenderPass::Stage> stages(RENDER_PASS_BRDF_LUT_NUM_STAGES);
 
 			// BRDF LUT stage
-			Vulkan::GraphicsPipelineInfo pipeline_info = {};
-			pipeline_info.color_attachment_formats = { TEXTURE_FORMAT_RG16_SFLOAT };
-			pipeline_info.vs_path = "assets/shaders/BRDF_LUT.vert";
-			pipeline_info.fs_path = "assets/shaders/BRDF_LUT.frag";
+			Vulkan::ComputePipelineInfo pipeline_info = {};
+			pipeline_info.cs_path = "assets/shaders/BRDF_LUTCS.glsl";
 
 			pipeline_info.push_ranges.resize(1);
-			pipeline_info.push_ranges[0].size = sizeof(uint32_t);
+			pipeline_info.push_ranges[0].size = 3 * sizeof(uint32_t);
 			pipeline_info.push_ranges[0].offset = 0;
-			pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+			pipeline_info.push_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
 			RenderPass::Stage& brdf_lut_stage = stages[RENDER_PASS_BRDF_LUT_STAGE_BRDF_LUT];
-			brdf_lut_stage.pipeline = Vulkan::CreateGraphicsPipeline(pipeline_info);
+			brdf_lut_stage.name = "BRDF LUT";
+			brdf_lut_stage.pipeline = Vulkan::CreateComputePipeline(pipeline_info);
 			
-			RenderPass::Attachment& brdf_lut_color0 = brdf_lut_stage.attachments[RenderPass::ATTACHMENT_SLOT_COLOR0];
-			brdf_lut_color0.info.format = TEXTURE_FORMAT_RG16_SFLOAT;
-			brdf_lut_color0.info.expected_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-			brdf_lut_color0.info.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			brdf_lut_color0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
-			brdf_lut_color0.info.clear_value = { 0.0f, 0.0f, 0.0f, 1.0f };
+			RenderPass::Attachment& brdf_lut_readwrite0 = brdf_lut_stage.attachments[RenderPass::ATTACHMENT_SLOT_READ_WRITE0];
+			brdf_lut_readwrite0.info.format = TEXTURE_FORMAT_RG16_SFLOAT;
+			brdf_lut_readwrite0.info.expected_layout = VK_IMAGE_LAYOUT_GENERAL;
+			brdf_lut_readwrite0.info.load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			brdf_lut_readwrite0.info.store_op = VK_ATTACHMENT_STORE_OP_STORE;
 
 			data->render_passes.gen_brdf_lut = std::make_unique<RenderPass>(stages);
 		}
@@ -905,6 +1767,7 @@ namespace Renderer
 		{
 			std::vector<RenderPass::Stage> stages(RENDER_PASS_IMGUI_NUM_STAGES);
 			RenderPass::Stage& imgui_stage = stages[RENDER_PASS_IMGUI_STAGE_IMGUI];
+			imgui_stage.name = "Dear ImGui";
 			imgui_stage.pipeline.type = VULKAN_PIPELINE_TYPE_GRAPHICS;
 
 			RenderPass::Attachment& imgui_color0 = imgui_stage.attachments[RenderPass::ATTACHMENT_SLOT_COLOR0];
@@ -917,411 +1780,602 @@ namespace Renderer
 		}
 	}
 
-	static RenderResourceHandle GenerateIBLCubemaps(RenderResourceHandle src_texture_handle)
+	struct IBLCacheHeader
 	{
-		VulkanCommandBuffer command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(data->command_pools.graphics_compute);
+		uint32_t magic = IBL_CACHE_MAGIC;
+		uint32_t version = IBL_CACHE_VERSION;
+		uint64_t key = 0;
+		uint64_t num_bytes = 0;
+	};
+
+	static std::filesystem::path GetIBLCacheFilepath(const std::string& name, uint64_t cache_key)
+	{
+		return std::filesystem::path(IBL_CACHE_DIRECTORY) / std::format("{}_{:016x}.bin", name, cache_key);
+	}
+
+	static uint64_t GetIBLTexelByteSize(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TEXTURE_FORMAT_RGBA16_SFLOAT:
+			return 8;
+		case TEXTURE_FORMAT_RG16_SFLOAT:
+			return 4;
+		default:
+			VK_EXCEPT("Renderer::GetIBLTexelByteSize", "IBL texture format is not supported by the IBL cache");
+		}
+	}
+
+	static uint64_t GetIBLTextureByteSize(const TextureCreateInfo& texture_info)
+	{
+		uint64_t num_bytes = 0;
+		for (uint32_t mip = 0; mip < texture_info.num_mips; ++mip)
+		{
+			uint64_t mip_width = std::max(texture_info.width >> mip, 1u);
+			uint64_t mip_height = std::max(texture_info.height >> mip, 1u);
+			num_bytes += mip_width * mip_height * texture_info.num_layers * GetIBLTexelByteSize(texture_info.format);
+		}
+
+		return num_bytes;
+	}
+
+	static uint64_t GetIBLTexturesByteSize(const std::vector<const Texture*>& textures)
+	{
+		uint64_t num_bytes = 0;
+		for (const Texture* texture : textures)
+		{
+			num_bytes += GetIBLTextureByteSize(texture->texture_info);
+		}
+
+		return num_bytes;
+	}
+
+	static RenderResourceHandle CreateIBLTexture(const TextureCreateInfo& texture_info)
+	{
+		VulkanImage image = Vulkan::Image::Create(texture_info);
+
+		TextureViewCreateInfo view_info = {
+			.format = texture_info.format,
+			.dimension = texture_info.dimension
+		};
+		VulkanImageView view = Vulkan::ImageView::Create(image, view_info);
+		VulkanDescriptorAllocation descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+		Vulkan::Descriptor::Write(descriptor, view, VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL);
+
+		return data->texture_slotmap.Emplace(texture_info, image, view, descriptor, data->ibl_sampler);
+	}
+
+	static TextureCreateInfo GetIBLCubemapCreateInfo(uint32_t resolution, const std::string& name)
+	{
+		// Written by compute shaders as storage images, copied from and to for the IBL cache
+		TextureCreateInfo texture_info = {
+			.format = TEXTURE_FORMAT_RGBA16_SFLOAT,
+			.usage_flags = TEXTURE_USAGE_READ_WRITE | TEXTURE_USAGE_SAMPLED | TEXTURE_USAGE_COPY_SRC | TEXTURE_USAGE_COPY_DST,
+			.dimension = TEXTURE_DIMENSION_CUBE,
+			.width = resolution,
+			.height = resolution,
+			.num_mips = (uint32_t)std::floor(std::log2(resolution)) + 1,
+			.num_layers = 6,
+			// Generated on the async compute queue
+			.async_compute_shared = true,
+			.name = name
+		};
+
+		return texture_info;
+	}
+
+	// Creates a storage image view for each mip of the cubemap, with the faces viewed as a 2D array so that a single dispatch can write all faces
+	// The storage image descriptor for a mip is located at descriptor_offset + mip
+	static VulkanDescriptorAllocation CreateCubemapMipStorageDescriptors(const Texture* cubemap, std::vector<VulkanImageView>& mip_views)
+	{
+		VulkanDescriptorAllocation descriptors = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_STORAGE_IMAGE, cubemap->texture_info.num_mips);
+
+		for (uint32_t mip = 0; mip < cubemap->texture_info.num_mips; ++mip)
+		{
+			TextureViewCreateInfo mip_view_info = {};
+			mip_view_info.format = cubemap->texture_info.format;
+			mip_view_info.dimension = TEXTURE_DIMENSION_2D;
+			mip_view_info.base_mip = mip;
+			mip_view_info.num_mips = 1;
+			mip_view_info.base_layer = 0;
+			mip_view_info.num_layers = 6;
+
+			mip_views.push_back(Vulkan::ImageView::Create(cubemap->image, mip_view_info));
+			Vulkan::Descriptor::Write(descriptors, mip_views.back(), VK_IMAGE_LAYOUT_GENERAL, mip);
+		}
+
+		return descriptors;
+	}
+
+	static VulkanBuffer CreateIBLCacheStagingBuffer(uint64_t num_bytes)
+	{
+		BufferCreateInfo buffer_info = {};
+		buffer_info.size_in_bytes = num_bytes;
+		buffer_info.usage_flags = BUFFER_USAGE_STAGING | BUFFER_USAGE_COPY_DST;
+		// The buffer is read back on the CPU when writing the cache, which is very slow from uncached memory
+		buffer_info.memory_flags = GPU_MEMORY_HOST_VISIBLE | GPU_MEMORY_HOST_COHERENT | GPU_MEMORY_HOST_CACHED;
+		buffer_info.name = "IBL Cache Staging Buffer";
+
+		return Vulkan::Buffer::Create(buffer_info);
+	}
+
+	// Copies all mips and layers of the textures into the buffer, tightly packed in the same order as the textures
+	// The textures are left in READ_ONLY_OPTIMAL
+	static void CopyIBLTexturesToBuffer(VulkanCommandBuffer& command_buffer, const std::vector<const Texture*>& textures, const VulkanBuffer& buffer)
+	{
+		uint64_t buffer_offset = 0;
+
+		for (const Texture* texture : textures)
+		{
+			const TextureCreateInfo& texture_info = texture->texture_info;
+			uint64_t texel_size = GetIBLTexelByteSize(texture_info.format);
+
+			Vulkan::Command::TransitionLayout(command_buffer, { .image = texture->image, .new_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL });
+
+			for (uint32_t mip = 0; mip < texture_info.num_mips; ++mip)
+			{
+				uint32_t mip_width = std::max(texture_info.width >> mip, 1u);
+				uint32_t mip_height = std::max(texture_info.height >> mip, 1u);
+
+				Vulkan::Command::CopyToBuffer(command_buffer, texture->image, mip_width, mip_height, buffer, buffer_offset, mip, 0, texture_info.num_layers);
+				buffer_offset += mip_width * mip_height * texture_info.num_layers * texel_size;
+			}
+
+			Vulkan::Command::TransitionLayout(command_buffer, { .image = texture->image, .new_layout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL });
+		}
+
+		Vulkan::Command::BufferMemoryBarrier(command_buffer, {
+			.buffer = buffer,
+			.src_access_flags = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			.src_stage_flags = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+			.dst_access_flags = VK_ACCESS_2_HOST_READ_BIT,
+			.dst_stage_flags = VK_PIPELINE_STAGE_2_HOST_BIT
+		});
+	}
+
+	// Inverse of CopyIBLTexturesToBuffer, the textures are left in READ_ONLY_OPTIMAL
+	static void CopyIBLTexturesFromBuffer(VulkanCommandBuffer& command_buffer, const std::vector<const Texture*>& textures, const VulkanBuffer& buffer)
+	{
+		uint64_t buffer_offset = 0;
+
+		for (const Texture* texture : textures)
+		{
+			const TextureCreateInfo& texture_info = texture->texture_info;
+			uint64_t texel_size = GetIBLTexelByteSize(texture_info.format);
+
+			Vulkan::Command::TransitionLayout(command_buffer, { .image = texture->image, .new_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL });
+
+			for (uint32_t mip = 0; mip < texture_info.num_mips; ++mip)
+			{
+				uint32_t mip_width = std::max(texture_info.width >> mip, 1u);
+				uint32_t mip_height = std::max(texture_info.height >> mip, 1u);
+
+				Vulkan::Command::CopyFromBuffer(command_buffer, buffer, buffer_offset, texture->image, mip_width, mip_height, mip, 0, texture_info.num_layers);
+				buffer_offset += mip_width * mip_height * texture_info.num_layers * texel_size;
+			}
+
+			Vulkan::Command::TransitionLayout(command_buffer, { .image = texture->image, .new_layout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL });
+		}
+	}
+
+	// Fills the textures with the contents of the cache file, returns false if the cache file is missing or stale
+	static bool LoadIBLTexturesFromCache(const std::filesystem::path& filepath, uint64_t cache_key, const std::vector<const Texture*>& textures)
+	{
+		std::vector<uint8_t> cache_bytes;
+		if (!FileIO::ReadBinary(filepath, cache_bytes))
+			return false;
+
+		uint64_t num_bytes = GetIBLTexturesByteSize(textures);
+
+		IBLCacheHeader header = {};
+		if (cache_bytes.size() >= sizeof(IBLCacheHeader))
+			memcpy(&header, cache_bytes.data(), sizeof(IBLCacheHeader));
+
+		if (cache_bytes.size() != sizeof(IBLCacheHeader) + num_bytes || header.magic != IBL_CACHE_MAGIC ||
+			header.version != IBL_CACHE_VERSION || header.key != cache_key || header.num_bytes != num_bytes)
+		{
+			LOG_WARN("Renderer::LoadIBLTexturesFromCache", "Ignoring stale IBL cache file: {}", filepath.string());
+			return false;
+		}
+
+		VulkanBuffer staging_buffer = CreateIBLCacheStagingBuffer(num_bytes);
+		void* staging_ptr = Vulkan::DeviceMemory::Map(staging_buffer.memory, num_bytes, 0);
+		memcpy(staging_ptr, cache_bytes.data() + sizeof(IBLCacheHeader), num_bytes);
+		Vulkan::DeviceMemory::Unmap(staging_buffer.memory);
+
+		VulkanCommandPool& command_pool = GetComputeCommandPool();
+		VulkanCommandBuffer command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(command_pool);
 		Vulkan::CommandBuffer::BeginRecording(command_buffer);
 
-		const Mesh* unit_cube_mesh = data->mesh_slotmap.Find(data->unit_cube_mesh_handle);
-		VK_ASSERT(unit_cube_mesh && "Unit cube mesh is invalid");
+		CopyIBLTexturesFromBuffer(command_buffer, textures, staging_buffer);
+
+		Vulkan::CommandBuffer::EndRecording(command_buffer);
+		Vulkan::CommandQueue::ExecuteBlocking(GetComputeQueue(), command_buffer);
+		Vulkan::CommandBuffer::Reset(command_buffer);
+		Vulkan::CommandPool::FreeCommandBuffer(command_pool, command_buffer);
+
+		Vulkan::Buffer::Destroy(staging_buffer);
+		return true;
+	}
+
+	// Writes the staging buffer filled by CopyIBLTexturesToBuffer to the cache file, the copy needs to have finished executing
+	static void SaveIBLCache(const std::filesystem::path& filepath, uint64_t cache_key, const VulkanBuffer& staging_buffer, uint64_t num_bytes)
+	{
+		IBLCacheHeader header = {};
+		header.key = cache_key;
+		header.num_bytes = num_bytes;
+
+		std::vector<uint8_t> cache_bytes(sizeof(IBLCacheHeader) + num_bytes);
+		memcpy(cache_bytes.data(), &header, sizeof(IBLCacheHeader));
+
+		void* staging_ptr = Vulkan::DeviceMemory::Map(staging_buffer.memory, num_bytes, 0);
+		memcpy(cache_bytes.data() + sizeof(IBLCacheHeader), staging_ptr, num_bytes);
+		Vulkan::DeviceMemory::Unmap(staging_buffer.memory);
+
+		if (FileIO::WriteBinary(filepath, cache_bytes))
+			LOG_INFO("Renderer::SaveIBLCache", "Saved IBL cache file: {}", filepath.string());
+	}
+
+	static RenderResourceHandle GenerateIBLCubemaps(RenderResourceHandle src_texture_handle, uint64_t src_hash)
+	{
+		RenderResourceHandle hdr_cubemap_handle = CreateIBLTexture(GetIBLCubemapCreateInfo(IBL_HDR_CUBEMAP_RESOLUTION, "HDR Environment Cubemap"));
+		RenderResourceHandle irradiance_cubemap_handle = CreateIBLTexture(GetIBLCubemapCreateInfo(IBL_IRRADIANCE_CUBEMAP_RESOLUTION, "Irradiance Cubemap"));
+		RenderResourceHandle prefiltered_cubemap_handle = CreateIBLTexture(GetIBLCubemapCreateInfo(IBL_PREFILTERED_CUBEMAP_RESOLUTION, "Prefiltered Cubemap"));
 
 		Texture* hdr_equirect_texture = data->texture_slotmap.Find(src_texture_handle);
-		RenderResourceHandle hdr_cubemap_handle, irradiance_cubemap_handle, prefiltered_cubemap_handle;
-		Texture* hdr_cubemap, *irradiance_cubemap, *prefiltered_cubemap;
+		Texture* hdr_cubemap = data->texture_slotmap.Find(hdr_cubemap_handle);
+		Texture* irradiance_cubemap = data->texture_slotmap.Find(irradiance_cubemap_handle);
+		Texture* prefiltered_cubemap = data->texture_slotmap.Find(prefiltered_cubemap_handle);
+
+		// Append the irradiance cubemap and prefiltered cubemap to the hdr cubemap texture
+		hdr_cubemap->next = irradiance_cubemap_handle;
+		irradiance_cubemap->next = prefiltered_cubemap_handle;
+
+		// The cache key covers the source pixels and every parameter that affects the generated cubemaps
+		uint32_t cache_params[] = {
+			IBL_CACHE_VERSION, hdr_equirect_texture->texture_info.width, hdr_equirect_texture->texture_info.height,
+			IBL_HDR_CUBEMAP_RESOLUTION, IBL_IRRADIANCE_CUBEMAP_RESOLUTION, IBL_IRRADIANCE_CUBEMAP_SAMPLE_MULTIPLIER,
+			IBL_IRRADIANCE_USE_SPHERICAL_HARMONICS ? 1u : 0u, IBL_IRRADIANCE_SH_SOURCE_RESOLUTION,
+			IBL_PREFILTERED_CUBEMAP_RESOLUTION, IBL_PREFILTERED_CUBEMAP_NUM_SAMPLES
+		};
+		uint64_t cache_key = HashBytes(cache_params, sizeof(cache_params), src_hash);
+		std::filesystem::path cache_filepath = GetIBLCacheFilepath("environment", cache_key);
+
+		std::vector<const Texture*> ibl_textures = { hdr_cubemap, irradiance_cubemap, prefiltered_cubemap };
+		if (LoadIBLTexturesFromCache(cache_filepath, cache_key, ibl_textures))
+		{
+			LOG_INFO("Renderer::GenerateIBLCubemaps", "Loaded IBL cubemaps from cache: {}", cache_filepath.string());
+			return hdr_cubemap_handle;
+		}
+
+		std::chrono::high_resolution_clock::time_point generate_begin = std::chrono::high_resolution_clock::now();
+
+		VulkanCommandPool& command_pool = GetComputeCommandPool();
+		VulkanCommandBuffer command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(command_pool);
+		Vulkan::CommandBuffer::BeginRecording(command_buffer);
 
 		std::vector<VulkanImageView> temporary_image_views;
+		VulkanDescriptorAllocation hdr_cubemap_mip_descriptors = CreateCubemapMipStorageDescriptors(hdr_cubemap, temporary_image_views);
+		VulkanDescriptorAllocation irradiance_cubemap_mip_descriptors = CreateCubemapMipStorageDescriptors(irradiance_cubemap, temporary_image_views);
+		VulkanDescriptorAllocation prefiltered_cubemap_mip_descriptors = CreateCubemapMipStorageDescriptors(prefiltered_cubemap, temporary_image_views);
+
+		// Per face partial sums of the spherical harmonics coefficients, summed when evaluating the irradiance
+		VulkanBuffer sh_coefficient_buffer;
+		VulkanDescriptorAllocation sh_coefficient_descriptor;
+
+		if (IBL_IRRADIANCE_USE_SPHERICAL_HARMONICS)
+		{
+			BufferCreateInfo sh_buffer_info = {};
+			sh_buffer_info.size_in_bytes = 6 * IBL_SH_FACE_STRIDE * sizeof(glm::vec4);
+			sh_buffer_info.usage_flags = BUFFER_USAGE_READ_WRITE;
+			sh_buffer_info.memory_flags = GPU_MEMORY_DEVICE_LOCAL;
+			sh_buffer_info.name = "Irradiance SH Coefficients";
+
+			sh_coefficient_buffer = Vulkan::Buffer::Create(sh_buffer_info);
+			sh_coefficient_descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+			Vulkan::Descriptor::Write(sh_coefficient_descriptor, sh_coefficient_buffer);
+		}
 
 		// ----------------------------------------------------------------------------------------------------------------
-		// Generate IBL cubemaps Pass (3 stages)
-		// 1 - Render equirectangular texture to hdr environment cubemap
-		// 2 - Render irradiance cubemap from hdr environment cubemap
-		// 3 - Render prefiltered cubemap from hdr environment cubemap
+		// Generate IBL cubemaps Pass (5 stages)
+		// Every stage dispatches once per mip, covering all 6 faces of the cubemap in the Z dimension
+		// 1 - Project equirectangular texture onto the hdr environment cubemap
+		// 2 - Convolve the hdr environment cubemap into the irradiance cubemap
+		// 3 - Or: project the hdr environment cubemap onto spherical harmonics
+		// 4 - And evaluate the spherical harmonics into the irradiance cubemap
+		// 5 - Prefilter the hdr environment cubemap into the prefiltered cubemap, one roughness level per mip
 
 		RENDER_PASS_BEGIN(data->render_passes.gen_ibl_cubemaps);
 		{
 			// ----------------------------------------------------------------------------------------------------------------
-			// 1 - Render equirectangular texture to hdr environment cubemap
+			// 1 - Project equirectangular texture onto the hdr environment cubemap
 
 			{
-				// Create hdr environment cubemap
-				uint32_t num_cube_mips = (uint32_t)std::floor(std::log2(std::max(IBL_HDR_CUBEMAP_RESOLUTION, IBL_HDR_CUBEMAP_RESOLUTION))) + 1;
-				TextureCreateInfo texture_info = {
-					.format = TEXTURE_FORMAT_RGBA16_SFLOAT,
-					.usage_flags = TEXTURE_USAGE_RENDER_TARGET | TEXTURE_USAGE_SAMPLED,
-					.dimension = TEXTURE_DIMENSION_CUBE,
-					.width = IBL_HDR_CUBEMAP_RESOLUTION,
-					.height = IBL_HDR_CUBEMAP_RESOLUTION,
-					.num_mips = num_cube_mips,
-					.num_layers = 6,
-					.name = "HDR Environment Cubemap",
-				};
-				VulkanImage hdr_cubemap_image = Vulkan::Image::Create(texture_info);
-
-				TextureViewCreateInfo view_info = {
-					.format = texture_info.format,
-					.dimension = texture_info.dimension
-				};
-				VulkanImageView hdr_cubemap_view = Vulkan::ImageView::Create(hdr_cubemap_image, view_info);
-				VulkanDescriptorAllocation hdr_cubemap_descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
-				Vulkan::Descriptor::Write(hdr_cubemap_descriptor, hdr_cubemap_view, VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL);
+				RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_HDR_CUBEMAP, RenderPass::ATTACHMENT_SLOT_READ_ONLY0, hdr_equirect_texture->view);
+				RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_HDR_CUBEMAP, RenderPass::ATTACHMENT_SLOT_READ_WRITE0, hdr_cubemap->view);
 
-				hdr_cubemap_handle = data->texture_slotmap.Emplace(texture_info, hdr_cubemap_image, hdr_cubemap_view, hdr_cubemap_descriptor, data->ibl_sampler);
-				hdr_cubemap = data->texture_slotmap.Find(hdr_cubemap_handle);
-
-				// Render all 6 faces of the cube map using 6 different camera view matrices
-				VkViewport viewport = {};
-				viewport.x = 0.0f, viewport.y = 0.0f;
-				viewport.minDepth = 0.0f, viewport.maxDepth = 1.0f;
-
-				VkRect2D scissor_rect = { 0, 0, IBL_HDR_CUBEMAP_RESOLUTION, IBL_HDR_CUBEMAP_RESOLUTION };
+				RENDER_PASS_STAGE_BEGIN(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_HDR_CUBEMAP, command_buffer, IBL_HDR_CUBEMAP_RESOLUTION, IBL_HDR_CUBEMAP_RESOLUTION);
 
 				struct PushConsts
 				{
-					glm::mat4 view_projection;
-					uint32_t vb_index;
-
 					uint32_t src_texture_index;
 					uint32_t src_sampler_index;
+					uint32_t dst_texture_index;
+					uint32_t dst_resolution;
 				} push_consts;
 
-				push_consts.vb_index = unit_cube_mesh->vertex_buffer.descriptor.descriptor_offset;
-
 				push_consts.src_texture_index = hdr_equirect_texture->view_descriptor.descriptor_offset;
 				push_consts.src_sampler_index = hdr_equirect_texture->sampler.descriptor.descriptor_offset;
 
-				for (uint32_t mip = 0; mip < num_cube_mips; ++mip)
+				for (uint32_t mip = 0; mip < hdr_cubemap->texture_info.num_mips; ++mip)
 				{
-					for (uint32_t face = 0; face < 6; ++face)
-					{
-						uint32_t render_width = static_cast<float>(IBL_HDR_CUBEMAP_RESOLUTION) * std::pow(0.5f, mip);
-						uint32_t render_height = static_cast<float>(IBL_HDR_CUBEMAP_RESOLUTION) * std::pow(0.5f, mip);
-
-						// Render current face to the offscreen render target
-						TextureViewCreateInfo face_view_info = {};
-						face_view_info.format = texture_info.format;
-						face_view_info.dimension = TEXTURE_DIMENSION_2D;
-						face_view_info.base_mip = mip;
-						face_view_info.num_mips = 1;
-						face_view_info.base_layer = face;
-						face_view_info.num_layers = 1;
+					push_consts.dst_texture_index = hdr_cubemap_mip_descriptors.descriptor_offset + mip;
+					push_consts.dst_resolution = std::max(IBL_HDR_CUBEMAP_RESOLUTION >> mip, 1u);
 
-						temporary_image_views.push_back(Vulkan::ImageView::Create(hdr_cubemap_image, face_view_info));
-						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_HDR_CUBEMAP, RenderPass::ATTACHMENT_SLOT_COLOR0, temporary_image_views.back());
+					Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConsts), &push_consts);
 
-						RENDER_PASS_STAGE_BEGIN(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_HDR_CUBEMAP, command_buffer, render_width, render_height);
+					uint32_t dispatch_xy = VK_ALIGN_POW2(push_consts.dst_resolution, 8) / 8;
+					Vulkan::Command::Dispatch(command_buffer, dispatch_xy, dispatch_xy, 6);
+				}
 
-						viewport.width = render_width;
-						viewport.height = render_height;
+				RENDER_PASS_STAGE_END(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_HDR_CUBEMAP, command_buffer);
+			}
 
-						scissor_rect.extent.width = render_width;
-						scissor_rect.extent.height = render_height;
+			// ----------------------------------------------------------------------------------------------------------------
+			// 2, 3, 4 - Generate the irradiance cubemap from the hdr environment cubemap
 
-						Vulkan::Command::SetViewport(command_buffer, 0, 1, &viewport);
-						Vulkan::Command::SetScissor(command_buffer, 0, 1, &scissor_rect);
+			if (IBL_IRRADIANCE_USE_SPHERICAL_HARMONICS)
+			{
+				// Project onto spherical harmonics, one workgroup per face
+				{
+					RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_SH_PROJECT, RenderPass::ATTACHMENT_SLOT_READ_ONLY0, hdr_cubemap->view);
 
-						push_consts.view_projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 512.0f) * CUBE_FACING_VIEW_MATRICES[face];
+					RENDER_PASS_STAGE_BEGIN(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_SH_PROJECT, command_buffer, IBL_IRRADIANCE_SH_SOURCE_RESOLUTION, IBL_IRRADIANCE_SH_SOURCE_RESOLUTION);
 
-						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4) + sizeof(uint32_t), &push_consts.view_projection);
-						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(glm::mat4) + sizeof(uint32_t), 2 * sizeof(uint32_t), &push_consts.src_texture_index);
+					struct PushConsts
+					{
+						uint32_t src_texture_index;
+						uint32_t src_sampler_index;
+						uint32_t src_mip;
+						uint32_t src_resolution;
+						uint32_t dst_buffer_index;
+					} push_consts;
+
+					push_consts.src_texture_index = hdr_cubemap->view_descriptor.descriptor_offset;
+					push_consts.src_sampler_index = hdr_cubemap->sampler.descriptor.descriptor_offset;
+					push_consts.src_mip = (uint32_t)std::log2(IBL_HDR_CUBEMAP_RESOLUTION / IBL_IRRADIANCE_SH_SOURCE_RESOLUTION);
+					push_consts.src_resolution = IBL_IRRADIANCE_SH_SOURCE_RESOLUTION;
+					push_consts.dst_buffer_index = sh_coefficient_descriptor.descriptor_offset;
+
+					Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConsts), &push_consts);
+					Vulkan::Command::Dispatch(command_buffer, 1, 1, 6);
+
+					RENDER_PASS_STAGE_END(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_SH_PROJECT, command_buffer);
+				}
 
-						Vulkan::Command::DrawGeometryIndexed(command_buffer, &unit_cube_mesh->index_buffer.buffer,
-							unit_cube_mesh->index_buffer.index_type, unit_cube_mesh->index_buffer.num_indices);
+				Vulkan::Command::BufferMemoryBarrier(command_buffer, {
+					.buffer = sh_coefficient_buffer,
+					.src_access_flags = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+					.src_stage_flags = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+					.dst_access_flags = VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+					.dst_stage_flags = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT
+				});
 
-						RENDER_PASS_STAGE_END(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_HDR_CUBEMAP, command_buffer);
-					}
-				}
+				// Evaluate the spherical harmonics for every texel of the irradiance cubemap
+				{
+					RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_SH_EVALUATE, RenderPass::ATTACHMENT_SLOT_READ_WRITE0, irradiance_cubemap->view);
 
-				Vulkan::Command::TransitionLayout(command_buffer, { .image = hdr_cubemap_image, .new_layout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL });
-			}
+					RENDER_PASS_STAGE_BEGIN(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_SH_EVALUATE, command_buffer, IBL_IRRADIANCE_CUBEMAP_RESOLUTION, IBL_IRRADIANCE_CUBEMAP_RESOLUTION);
 
-			// ----------------------------------------------------------------------------------------------------------------
-			// 2 - Render irradiance cubemap from hdr environment cubemap
+					struct PushConsts
+					{
+						uint32_t src_buffer_index;
+						uint32_t dst_texture_index;
+						uint32_t dst_resolution;
+					} push_consts;
 
-			{
-				// Create irradiance cubemap
-				uint32_t num_cube_mips = (uint32_t)std::floor(std::log2(std::max(IBL_IRRADIANCE_CUBEMAP_RESOLUTION, IBL_IRRADIANCE_CUBEMAP_RESOLUTION))) + 1;
-				TextureCreateInfo texture_info = {
-					.format = TEXTURE_FORMAT_RGBA16_SFLOAT,
-					.usage_flags = TEXTURE_USAGE_RENDER_TARGET | TEXTURE_USAGE_SAMPLED,
-					.dimension = TEXTURE_DIMENSION_CUBE,
-					.width = IBL_IRRADIANCE_CUBEMAP_RESOLUTION,
-					.height = IBL_IRRADIANCE_CUBEMAP_RESOLUTION,
-					.num_mips = num_cube_mips,
-					.num_layers = 6,
-					.name = "Irradiance Cubemap"
-				};
+					push_consts.src_buffer_index = sh_coefficient_descriptor.descriptor_offset;
 
-				VulkanImage irradiance_cubemap_image = Vulkan::Image::Create(texture_info);
+					for (uint32_t mip = 0; mip < irradiance_cubemap->texture_info.num_mips; ++mip)
+					{
+						push_consts.dst_texture_index = irradiance_cubemap_mip_descriptors.descriptor_offset + mip;
+						push_consts.dst_resolution = std::max(IBL_IRRADIANCE_CUBEMAP_RESOLUTION >> mip, 1u);
 
-				TextureViewCreateInfo view_info = {
-					.format = texture_info.format,
-					.dimension = texture_info.dimension
-				};
-				VulkanImageView irradiance_cubemap_view = Vulkan::ImageView::Create(irradiance_cubemap_image, view_info);
-				VulkanDescriptorAllocation irradiance_cubemap_descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
-				Vulkan::Descriptor::Write(irradiance_cubemap_descriptor, irradiance_cubemap_view, VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL);
+						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConsts), &push_consts);
 
-				irradiance_cubemap_handle = data->texture_slotmap.Emplace(texture_info, irradiance_cubemap_image, irradiance_cubemap_view, irradiance_cubemap_descriptor, data->ibl_sampler);
-				irradiance_cubemap = data->texture_slotmap.Find(irradiance_cubemap_handle);
+						uint32_t dispatch_xy = VK_ALIGN_POW2(push_consts.dst_resolution, 8) / 8;
+						Vulkan::Command::Dispatch(command_buffer, dispatch_xy, dispatch_xy, 6);
+					}
 
-				// Render all 6 faces of the cube map using 6 different camera view matrices
-				VkViewport viewport = {};
-				viewport.x = 0.0f, viewport.y = 0.0f;
-				viewport.minDepth = 0.0f, viewport.maxDepth = 1.0f;
+					RENDER_PASS_STAGE_END(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_SH_EVALUATE, command_buffer);
+				}
+			}
+			else
+			{
+				RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_CUBEMAP, RenderPass::ATTACHMENT_SLOT_READ_ONLY0, hdr_cubemap->view);
+				RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_CUBEMAP, RenderPass::ATTACHMENT_SLOT_READ_WRITE0, irradiance_cubemap->view);
 
-				VkRect2D scissor_rect = {};
-				scissor_rect.offset.x = 0, scissor_rect.offset.y = 0;
+				RENDER_PASS_STAGE_BEGIN(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_CUBEMAP, command_buffer, IBL_IRRADIANCE_CUBEMAP_RESOLUTION, IBL_IRRADIANCE_CUBEMAP_RESOLUTION);
 
 				struct PushConsts
 				{
-					glm::mat4 view_projection;
-					uint32_t vb_index;
-
 					uint32_t src_texture_index;
 					uint32_t src_sampler_index;
+					uint32_t dst_texture_index;
+					uint32_t dst_resolution;
 					float delta_phi = (2.0f * glm::pi<float>()) / 180.0f;
 					float delta_theta = (0.5f * glm::pi<float>()) / 64.0f;
 				} push_consts;
 
-				push_consts.vb_index = unit_cube_mesh->vertex_buffer.descriptor.descriptor_offset;
-
-				push_consts.delta_phi /= IBL_IRRADIANCE_CUBEMAP_SAMPLE_MULTIPLIER;
-				push_consts.delta_theta /= IBL_IRRADIANCE_CUBEMAP_SAMPLE_MULTIPLIER;
 				push_consts.src_texture_index = hdr_cubemap->view_descriptor.descriptor_offset;
 				push_consts.src_sampler_index = hdr_cubemap->sampler.descriptor.descriptor_offset;
+				push_consts.delta_phi /= IBL_IRRADIANCE_CUBEMAP_SAMPLE_MULTIPLIER;
+				push_consts.delta_theta /= IBL_IRRADIANCE_CUBEMAP_SAMPLE_MULTIPLIER;
 
-				for (uint32_t mip = 0; mip < num_cube_mips; ++mip)
+				for (uint32_t mip = 0; mip < irradiance_cubemap->texture_info.num_mips; ++mip)
 				{
-					for (uint32_t face = 0; face < 6; ++face)
-					{
-						uint32_t render_width = static_cast<float>(IBL_IRRADIANCE_CUBEMAP_RESOLUTION) * std::pow(0.5f, mip);
-						uint32_t render_height = static_cast<float>(IBL_IRRADIANCE_CUBEMAP_RESOLUTION) * std::pow(0.5f, mip);
-
-						// Render current face to the offscreen render target
-						TextureViewCreateInfo face_view_info = {};
-						face_view_info.format = texture_info.format;
-						face_view_info.dimension = TEXTURE_DIMENSION_2D;
-						face_view_info.base_mip = mip;
-						face_view_info.num_mips = 1;
-						face_view_info.base_layer = face;
-						face_view_info.num_layers = 1;
-
-						temporary_image_views.push_back(Vulkan::ImageView::Create(irradiance_cubemap_image, face_view_info));
-						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_CUBEMAP, RenderPass::ATTACHMENT_SLOT_COLOR0, temporary_image_views.back());
+					push_consts.dst_texture_index = irradiance_cubemap_mip_descriptors.descriptor_offset + mip;
+					push_consts.dst_resolution = std::max(IBL_IRRADIANCE_CUBEMAP_RESOLUTION >> mip, 1u);
 
-						RENDER_PASS_STAGE_BEGIN(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_CUBEMAP, command_buffer, render_width, render_height);
-
-						viewport.width = render_width;
-						viewport.height = render_height;
-
-						scissor_rect.extent.width = render_width;
-						scissor_rect.extent.height = render_height;
-
-						Vulkan::Command::SetViewport(command_buffer, 0, 1, &viewport);
-						Vulkan::Command::SetScissor(command_buffer, 0, 1, &scissor_rect);
+					Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConsts), &push_consts);
 
-						push_consts.view_projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 512.0f) * CUBE_FACING_VIEW_MATRICES[face];
-
-						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4) + sizeof(uint32_t), &push_consts.view_projection);
-						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(glm::mat4) + sizeof(uint32_t), 2 * sizeof(uint32_t) + 2 * sizeof(float), &push_consts.src_texture_index);
-
-						Vulkan::Command::DrawGeometryIndexed(command_buffer, &unit_cube_mesh->index_buffer.buffer,
-							unit_cube_mesh->index_buffer.index_type, unit_cube_mesh->index_buffer.num_indices);
-
-						RENDER_PASS_STAGE_END(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_CUBEMAP, command_buffer);
-					}
+					uint32_t dispatch_xy = VK_ALIGN_POW2(push_consts.dst_resolution, 8) / 8;
+					Vulkan::Command::Dispatch(command_buffer, dispatch_xy, dispatch_xy, 6);
 				}
 
-				Vulkan::Command::TransitionLayout(command_buffer, { .image = irradiance_cubemap_image, .new_layout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL });
+				RENDER_PASS_STAGE_END(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_IRRADIANCE_CUBEMAP, command_buffer);
 			}
 
 			// ----------------------------------------------------------------------------------------------------------------
-			// 3 - Render prefiltered cubemap from hdr environment cubemap
+			// 5 - Prefilter the hdr environment cubemap into the prefiltered cubemap
 
 			{
-				// Create prefiltered cubemap
-				uint32_t num_cube_mips = (uint32_t)std::floor(std::log2(std::max(IBL_PREFILTERED_CUBEMAP_RESOLUTION, IBL_PREFILTERED_CUBEMAP_RESOLUTION))) + 1;
-				TextureCreateInfo texture_info = {
-					.format = TEXTURE_FORMAT_RGBA16_SFLOAT,
-					.usage_flags = TEXTURE_USAGE_RENDER_TARGET | TEXTURE_USAGE_SAMPLED,
-					.dimension = TEXTURE_DIMENSION_CUBE,
-					.width = IBL_PREFILTERED_CUBEMAP_RESOLUTION,
-					.height = IBL_PREFILTERED_CUBEMAP_RESOLUTION,
-					.num_mips = num_cube_mips,
-					.num_layers = 6,
-					.name = "Prefiltered Cubemap",
-				};
-
-				VulkanImage prefiltered_cubemap_image = Vulkan::Image::Create(texture_info);
-
-				TextureViewCreateInfo view_info = {
-					.format = texture_info.format,
-					.dimension = texture_info.dimension
-				};
-				VulkanImageView prefiltered_cubemap_view = Vulkan::ImageView::Create(prefiltered_cubemap_image, view_info);
-				VulkanDescriptorAllocation prefiltered_descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
-				Vulkan::Descriptor::Write(prefiltered_descriptor, prefiltered_cubemap_view, VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL);
-
-				prefiltered_cubemap_handle = data->texture_slotmap.Emplace(texture_info, prefiltered_cubemap_image, prefiltered_cubemap_view, prefiltered_descriptor, data->ibl_sampler);
-				prefiltered_cubemap = data->texture_slotmap.Find(prefiltered_cubemap_handle);
+				RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_PREFILTERED_CUBEMAP, RenderPass::ATTACHMENT_SLOT_READ_ONLY0, hdr_cubemap->view);
+				RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_PREFILTERED_CUBEMAP, RenderPass::ATTACHMENT_SLOT_READ_WRITE0, prefiltered_cubemap->view);
 
-				VkViewport viewport = {};
-				viewport.x = 0.0f, viewport.y = 0.0f;
-				viewport.minDepth = 0.0f, viewport.maxDepth = 1.0f;
-
-				VkRect2D scissor_rect = { 0, 0, IBL_PREFILTERED_CUBEMAP_RESOLUTION, IBL_PREFILTERED_CUBEMAP_RESOLUTION };
+				RENDER_PASS_STAGE_BEGIN(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_PREFILTERED_CUBEMAP, command_buffer, IBL_PREFILTERED_CUBEMAP_RESOLUTION, IBL_PREFILTERED_CUBEMAP_RESOLUTION);
 
 				struct PushConsts
 				{
-					glm::mat4 view_projection;
-					uint32_t vb_index;
-
 					uint32_t src_texture_index;
 					uint32_t src_sampler_index;
+					uint32_t src_resolution;
+					uint32_t dst_texture_index;
+					uint32_t dst_resolution;
 					uint32_t num_samples = IBL_PREFILTERED_CUBEMAP_NUM_SAMPLES;
 					float roughness;
 				} push_consts;
 
-				push_consts.vb_index = unit_cube_mesh->vertex_buffer.descriptor.descriptor_offset;
-
 				push_consts.src_texture_index = hdr_cubemap->view_descriptor.descriptor_offset;
 				push_consts.src_sampler_index = hdr_cubemap->sampler.descriptor.descriptor_offset;
+				push_consts.src_resolution = IBL_HDR_CUBEMAP_RESOLUTION;
 
+				uint32_t num_cube_mips = prefiltered_cubemap->texture_info.num_mips;
 				for (uint32_t mip = 0; mip < num_cube_mips; ++mip)
 				{
-					uint32_t render_width = static_cast<float>(IBL_PREFILTERED_CUBEMAP_RESOLUTION) * std::pow(0.5f, mip);
-					uint32_t render_height = static_cast<float>(IBL_PREFILTERED_CUBEMAP_RESOLUTION) * std::pow(0.5f, mip);
-
-					for (uint32_t face = 0; face < 6; ++face)
-					{
-						TextureViewCreateInfo face_view_info = {};
-						face_view_info.format = texture_info.format;
-						face_view_info.dimension = TEXTURE_DIMENSION_2D;
-						face_view_info.base_mip = mip;
-						face_view_info.num_mips = 1;
-						face_view_info.base_layer = face;
-						face_view_info.num_layers = 1;
-
-						temporary_image_views.push_back(Vulkan::ImageView::Create(prefiltered_cubemap_image, face_view_info));
-						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_PREFILTERED_CUBEMAP, RenderPass::ATTACHMENT_SLOT_COLOR0, temporary_image_views.back());
-
-						RENDER_PASS_STAGE_BEGIN(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_PREFILTERED_CUBEMAP, command_buffer, render_width, render_height);
-						{
-							viewport.width = render_width;
-							viewport.height = render_height;
-
-							scissor_rect.extent.width = render_width;
-							scissor_rect.extent.height = render_height;
-
-							Vulkan::Command::SetViewport(command_buffer, 0, 1, &viewport);
-							Vulkan::Command::SetScissor(command_buffer, 0, 1, &scissor_rect);
+					push_consts.dst_texture_index = prefiltered_cubemap_mip_descriptors.descriptor_offset + mip;
+					push_consts.dst_resolution = std::max(IBL_PREFILTERED_CUBEMAP_RESOLUTION >> mip, 1u);
+					push_consts.roughness = (float)mip / (float)(num_cube_mips - 1);
 
-							push_consts.view_projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 512.0f) * CUBE_FACING_VIEW_MATRICES[face];
-							push_consts.roughness = (float)mip / (float)(num_cube_mips - 1);
+					Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConsts), &push_consts);
 
-							Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4) + sizeof(uint32_t), &push_consts.view_projection);
-							Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(glm::mat4) + sizeof(uint32_t), 3 * sizeof(uint32_t) + sizeof(float), &push_consts.src_texture_index);
-
-							Vulkan::Command::DrawGeometryIndexed(command_buffer, &unit_cube_mesh->index_buffer.buffer,
-								unit_cube_mesh->index_buffer.index_type, unit_cube_mesh->index_buffer.num_indices);
-						}
-						RENDER_PASS_STAGE_END(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_PREFILTERED_CUBEMAP, command_buffer, data->render_passes.gen_prefiltered_cube);
-					}
+					uint32_t dispatch_xy = VK_ALIGN_POW2(push_consts.dst_resolution, 8) / 8;
+					Vulkan::Command::Dispatch(command_buffer, dispatch_xy, dispatch_xy, 6);
 				}
 
-				Vulkan::Command::TransitionLayout(command_buffer, { .image = prefiltered_cubemap_image, .new_layout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL });
+				RENDER_PASS_STAGE_END(RENDER_PASS_GEN_IBL_CUBEMAPS_STAGE_PREFILTERED_CUBEMAP, command_buffer);
 			}
 		}
 		RENDER_PASS_END(data->render_passes.gen_ibl_cubemaps);
 
+		// Read back the generated cubemaps so that they can be written to the cache, this also transitions them to READ_ONLY_OPTIMAL
+		uint64_t cache_num_bytes = GetIBLTexturesByteSize(ibl_textures);
+		VulkanBuffer cache_staging_buffer = CreateIBLCacheStagingBuffer(cache_num_bytes);
+		CopyIBLTexturesToBuffer(command_buffer, ibl_textures, cache_staging_buffer);
+
 		Vulkan::CommandBuffer::EndRecording(command_buffer);
-		Vulkan::CommandQueue::ExecuteBlocking(data->command_queues.graphics_compute, command_buffer);
+		Vulkan::CommandQueue::ExecuteBlocking(GetComputeQueue(), command_buffer);
 		Vulkan::CommandBuffer::Reset(command_buffer);
-		Vulkan::CommandPool::FreeCommandBuffer(data->command_pools.graphics_compute, command_buffer);
+		Vulkan::CommandPool::FreeCommandBuffer(command_pool, command_buffer);
+
+		std::chrono::duration<float, std::milli> generate_duration = std::chrono::high_resolution_clock::now() - generate_begin;
+		LOG_INFO("Renderer::GenerateIBLCubemaps", "Generated IBL cubemaps in {:.2f} ms", generate_duration.count());
+
+		SaveIBLCache(cache_filepath, cache_key, cache_staging_buffer, cache_num_bytes);
+		Vulkan::Buffer::Destroy(cache_staging_buffer);
+
+		// Free temporary resources
+		if (IBL_IRRADIANCE_USE_SPHERICAL_HARMONICS)
+		{
+			Vulkan::Descriptor::Free(sh_coefficient_descriptor);
+			Vulkan::Buffer::Destroy(sh_coefficient_buffer);
+		}
+
+		Vulkan::Descriptor::Free(hdr_cubemap_mip_descriptors);
+		Vulkan::Descriptor::Free(irradiance_cubemap_mip_descriptors);
+		Vulkan::Descriptor::Free(prefiltered_cubemap_mip_descriptors);
 
-		// Free temporary image views
 		for (auto& temp_view : temporary_image_views)
 		{
 			Vulkan::ImageView::Destroy(temp_view);
 		}
 
-		// Append the irradiance cubemap and prefiltered cubemap to the hdr cubemap texture
-		hdr_cubemap->next = irradiance_cubemap_handle;
-		irradiance_cubemap->next = prefiltered_cubemap_handle;
-
 		return hdr_cubemap_handle;
 	}
 
 	static void GenerateBRDF_LUT()
 	{
-		VulkanCommandBuffer command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(data->command_pools.graphics_compute);
-		Vulkan::CommandBuffer::BeginRecording(command_buffer);
-
 		// Create the BRDF LUT
 		TextureCreateInfo texture_info = {
 			.format = TEXTURE_FORMAT_RG16_SFLOAT,
-			.usage_flags = TEXTURE_USAGE_RENDER_TARGET | TEXTURE_USAGE_SAMPLED,
+			.usage_flags = TEXTURE_USAGE_READ_WRITE | TEXTURE_USAGE_SAMPLED | TEXTURE_USAGE_COPY_SRC | TEXTURE_USAGE_COPY_DST,
 			.dimension = TEXTURE_DIMENSION_2D,
 			.width = IBL_BRDF_LUT_RESOLUTION,
 			.height = IBL_BRDF_LUT_RESOLUTION,
 			.num_mips = 1,
 			.num_layers = 1,
+			// Generated on the async compute queue
+			.async_compute_shared = true,
 			.name = "BRDF LUT"
 		};
 
-		VulkanImage brdf_lut = Vulkan::Image::Create(texture_info);
+		data->ibl.brdf_lut_handle = CreateIBLTexture(texture_info);
+		Texture* brdf_lut = data->texture_slotmap.Find(data->ibl.brdf_lut_handle);
 
-		TextureViewCreateInfo view_info = {
-			.format = texture_info.format,
-			.dimension = texture_info.dimension
-		};
-		VulkanImageView brdf_lut_view = Vulkan::ImageView::Create(brdf_lut, view_info);
-		VulkanDescriptorAllocation brdf_lut_descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
-		Vulkan::Descriptor::Write(brdf_lut_descriptor, brdf_lut_view, VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL);
+		// The BRDF LUT does not depend on any input, so it is only keyed on its parameters
+		uint32_t cache_params[] = { IBL_CACHE_VERSION, IBL_BRDF_LUT_RESOLUTION, IBL_BRDF_LUT_SAMPLES };
+		uint64_t cache_key = HashBytes(cache_params, sizeof(cache_params));
+		std::filesystem::path cache_filepath = GetIBLCacheFilepath("brdf_lut", cache_key);
 
-		data->ibl.brdf_lut_handle = data->texture_slotmap.Emplace(texture_info, brdf_lut, brdf_lut_view, brdf_lut_descriptor, data->ibl_sampler);
-		
-		VkViewport viewport = {};
-		viewport.x = 0.0f, viewport.y = 0.0f;
-		viewport.minDepth = 0.0f, viewport.maxDepth = 1.0f;
+		std::vector<const Texture*> ibl_textures = { brdf_lut };
+		if (LoadIBLTexturesFromCache(cache_filepath, cache_key, ibl_textures))
+		{
+			LOG_INFO("Renderer::GenerateBRDF_LUT", "Loaded BRDF LUT from cache: {}", cache_filepath.string());
+			return;
+		}
 
-		VkRect2D scissor_rect = {};
-		scissor_rect.offset.x = 0.0f, scissor_rect.offset.y = 0.0f;
+		VulkanDescriptorAllocation brdf_lut_storage_descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+		Vulkan::Descriptor::Write(brdf_lut_storage_descriptor, brdf_lut->view, VK_IMAGE_LAYOUT_GENERAL);
+
+		VulkanCommandPool& command_pool = GetComputeCommandPool();
+		VulkanCommandBuffer command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(command_pool);
+		Vulkan::CommandBuffer::BeginRecording(command_buffer);
 
 		struct PushConsts
 		{
 			uint32_t num_samples = IBL_BRDF_LUT_SAMPLES;
+			uint32_t dst_texture_index;
+			uint32_t dst_resolution = IBL_BRDF_LUT_RESOLUTION;
 		} push_consts;
 
-		uint32_t render_width = IBL_BRDF_LUT_RESOLUTION;
-		uint32_t render_height = IBL_BRDF_LUT_RESOLUTION;
+		push_consts.dst_texture_index = brdf_lut_storage_descriptor.descriptor_offset;
 
 		RENDER_PASS_BEGIN(data->render_passes.gen_brdf_lut);
-		RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_BRDF_LUT_STAGE_BRDF_LUT, RenderPass::ATTACHMENT_SLOT_COLOR0, brdf_lut_view);
-		RENDER_PASS_STAGE_BEGIN(RENDER_PASS_BRDF_LUT_STAGE_BRDF_LUT, command_buffer, render_width, render_height);
-
-		viewport.width = render_width;
-		viewport.height = render_height;
-
-		scissor_rect.extent.width = render_width;
-		scissor_rect.extent.height = render_height;
+		RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_BRDF_LUT_STAGE_BRDF_LUT, RenderPass::ATTACHMENT_SLOT_READ_WRITE0, brdf_lut->view);
+		RENDER_PASS_STAGE_BEGIN(RENDER_PASS_BRDF_LUT_STAGE_BRDF_LUT, command_buffer, IBL_BRDF_LUT_RESOLUTION, IBL_BRDF_LUT_RESOLUTION);
 
-		Vulkan::Command::SetViewport(command_buffer, 0, 1, &viewport);
-		Vulkan::Command::SetScissor(command_buffer, 0, 1, &scissor_rect);
+		Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConsts), &push_consts);
 
-		Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t), &push_consts);
-
-		Vulkan::Command::DrawGeometry(command_buffer, 3);
+		uint32_t dispatch_xy = VK_ALIGN_POW2(IBL_BRDF_LUT_RESOLUTION, 8) / 8;
+		Vulkan::Command::Dispatch(command_buffer, dispatch_xy, dispatch_xy, 1);
 
 		RENDER_PASS_STAGE_END(RENDER_PASS_BRDF_LUT_STAGE_BRDF_LUT, command_buffer);
 		RENDER_PASS_END(data->render_passes.gen_brdf_lut);
 
-		Vulkan::Command::TransitionLayout(command_buffer, { .image = brdf_lut, .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+		// Read back the BRDF LUT so that it can be written to the cache, this also transitions it to READ_ONLY_OPTIMAL
+		uint64_t cache_num_bytes = GetIBLTexturesByteSize(ibl_textures);
+		VulkanBuffer cache_staging_buffer = CreateIBLCacheStagingBuffer(cache_num_bytes);
+		CopyIBLTexturesToBuffer(command_buffer, ibl_textures, cache_staging_buffer);
 
 		Vulkan::CommandBuffer::EndRecording(command_buffer);
-		Vulkan::CommandQueue::ExecuteBlocking(data->command_queues.graphics_compute, command_buffer);
+		Vulkan::CommandQueue::ExecuteBlocking(GetComputeQueue(), command_buffer);
 		Vulkan::CommandBuffer::Reset(command_buffer);
-		Vulkan::CommandPool::FreeCommandBuffer(data->command_pools.graphics_compute, command_buffer);
+		Vulkan::CommandPool::FreeCommandBuffer(command_pool, command_buffer);
+
+		SaveIBLCache(cache_filepath, cache_key, cache_staging_buffer, cache_num_bytes);
+		Vulkan::Buffer::Destroy(cache_staging_buffer);
+
+		Vulkan::Descriptor::Free(brdf_lut_storage_descriptor);
 	}
 
 	void Init(::GLFWwindow* window, uint32_t window_width, uint32_t window_height)
@@ -1330,44 +2384,118 @@ namespace Renderer
 
 		data = new Data();
 		data->glfw_window = window;
+		GPUProfiler::Init();
 
 		data->render_resolution = { window_width, window_height };
 		data->output_resolution = { window_width, window_height };
 
 		data->command_queues.graphics_compute = Vulkan::GetCommandQueue(VULKAN_COMMAND_BUFFER_TYPE_GRAPHICS_COMPUTE);
 		data->command_queues.transfer = Vulkan::GetCommandQueue(VULKAN_COMMAND_BUFFER_TYPE_TRANSFER);
+		data->command_queues.compute = Vulkan::GetCommandQueue(VULKAN_COMMAND_BUFFER_TYPE_COMPUTE);
 
 		data->command_pools.graphics_compute = Vulkan::CommandPool::Create(data->command_queues.graphics_compute);
 		data->command_pools.transfer = Vulkan::CommandPool::Create(data->command_queues.transfer);
+		data->command_pools.compute = Vulkan::CommandPool::Create(data->command_queues.compute);
+
+		data->async_compute.available = data->command_queues.compute.vk_queue != data->command_queues.graphics_compute.vk_queue;
+		data->async_compute.enabled = data->async_compute.available;
 
 		CreateRenderTargets();
+
+		// Shaders are compiled in parallel up front, pipeline creation then hits the SPIR-V and pipeline caches
+		std::chrono::high_resolution_clock::time_point pipelines_begin = std::chrono::high_resolution_clock::now();
+		Vulkan::PrecompileShaders("assets/shaders");
 		CreateRenderPasses();
+
+		std::chrono::duration<float, std::milli> pipelines_duration = std::chrono::high_resolution_clock::now() - pipelines_begin;
+		LOG_INFO("Renderer::Init", "Created render pass pipelines in {:.2f} ms", pipelines_duration.count());
+
+		// Headless runs are used for benchmarking, where shaders should not change halfway through
+		if (!Vulkan::IsHeadless())
+			Vulkan::EnableShaderHotReload("assets/shaders");
+
 		CreateSyncObjects();
 
-		// Init Dear ImGui
-		Vulkan::InitImGui(window);
+		if (!Vulkan::IsHeadless())
+		{
+			// Init Dear ImGui
+			Vulkan::InitImGui(window);
 
-		// Upload imgui font
-		VulkanCommandBuffer command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(data->command_pools.graphics_compute);
-		Vulkan::CommandBuffer::BeginRecording(command_buffer);
+			// Upload imgui font
+			VulkanCommandBuffer command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(data->command_pools.graphics_compute);
+			Vulkan::CommandBuffer::BeginRecording(command_buffer);
 
-		ImGui_ImplVulkan_CreateFontsTexture(command_buffer.vk_command_buffer);
+			ImGui_ImplVulkan_CreateFontsTexture(command_buffer.vk_command_buffer);
 
-		Vulkan::CommandBuffer::EndRecording(command_buffer);
-		Vulkan::CommandQueue::ExecuteBlocking(data->command_queues.graphics_compute, command_buffer);
+			Vulkan::CommandBuffer::EndRecording(command_buffer);
+			Vulkan::CommandQueue::ExecuteBlocking(data->command_queues.graphics_compute, command_buffer);
 
-		ImGui_ImplVulkan_DestroyFontUploadObjects();
+			ImGui_ImplVulkan_DestroyFontUploadObjects();
 
-		Vulkan::CommandBuffer::Reset(command_buffer);
-		Vulkan::CommandPool::FreeCommandBuffer(data->command_pools.graphics_compute, command_buffer);
+			Vulkan::CommandBuffer::Reset(command_buffer);
+			Vulkan::CommandPool::FreeCommandBuffer(data->command_pools.graphics_compute, command_buffer);
+		}
 
 		for (uint32_t frame_index = 0; frame_index < Vulkan::MAX_FRAMES_IN_FLIGHT; ++frame_index)
 		{
 			data->per_frame[frame_index].command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(data->command_pools.graphics_compute);
+			data->per_frame[frame_index].async_compute_command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(data->command_pools.compute);
+			data->per_frame[frame_index].timestamps.query_pool = Vulkan::Query::CreatePool(VK_QUERY_TYPE_TIMESTAMP, TIMESTAMP_QUERY_COUNT, std::format("Frame Timestamps {}", frame_index));
 			data->per_frame[frame_index].ubos.descriptors = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_UNIFORM_BUFFER, RESERVED_DESCRIPTOR_UBO_COUNT, frame_index);
 			data->per_frame[frame_index].raytracing.tlas_descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE, 1, frame_index);
 		}
 
+		// Light cluster buffer, holds a light count for each cluster followed by the light index lists for each cluster
+		BufferCreateInfo light_cluster_buffer_info = {};
+		light_cluster_buffer_info.usage_flags = BUFFER_USAGE_READ_WRITE | BUFFER_USAGE_COPY_SRC;
+		light_cluster_buffer_info.memory_flags = GPU_MEMORY_DEVICE_LOCAL;
+		light_cluster_buffer_info.size_in_bytes = (LIGHT_CLUSTERS_TOTAL + LIGHT_CLUSTERS_TOTAL * LIGHT_CLUSTER_MAX_LIGHTS) * sizeof(uint32_t);
+		// Written by light culling on the async compute queue
+		light_cluster_buffer_info.async_compute_shared = true;
+		light_cluster_buffer_info.name = "Light Cluster Buffer";
+
+		data->light_clusters.buffer = Vulkan::Buffer::Create(light_cluster_buffer_info);
+		data->light_clusters.descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		Vulkan::Descriptor::Write(data->light_clusters.descriptor, data->light_clusters.buffer);
+
+		// The light counts are copied back every frame, so that the renderer stats can show clusters that dropped lights
+		for (uint32_t frame_index = 0; frame_index < Vulkan::MAX_FRAMES_IN_FLIGHT; ++frame_index)
+		{
+			BufferCreateInfo readback_buffer_info = {};
+			readback_buffer_info.usage_flags = BUFFER_USAGE_STAGING | BUFFER_USAGE_COPY_DST;
+			readback_buffer_info.memory_flags = GPU_MEMORY_HOST_VISIBLE | GPU_MEMORY_HOST_COHERENT | GPU_MEMORY_HOST_CACHED;
+			readback_buffer_info.size_in_bytes = LIGHT_CLUSTERS_TOTAL * sizeof(uint32_t);
+			readback_buffer_info.async_compute_shared = true;
+			readback_buffer_info.name = std::format("Light Cluster Readback Buffer {}", frame_index);
+
+			Frame::LightClusterReadback& readback = data->per_frame[frame_index].light_cluster_readback;
+			readback.buffer = Vulkan::Buffer::Create(readback_buffer_info);
+			readback.light_counts = reinterpret_cast<const uint32_t*>(Vulkan::DeviceMemory::Map(readback.buffer.memory, readback_buffer_info.size_in_bytes, 0));
+		}
+
+		// Auto exposure buffer, holds the luminance histogram followed by the adapted luminance and exposure
+		BufferCreateInfo auto_exposure_buffer_info = {};
+		auto_exposure_buffer_info.usage_flags = BUFFER_USAGE_READ_WRITE | BUFFER_USAGE_COPY_DST;
+		auto_exposure_buffer_info.memory_flags = GPU_MEMORY_DEVICE_LOCAL;
+		auto_exposure_buffer_info.size_in_bytes = sizeof(AutoExposureData);
+		auto_exposure_buffer_info.name = "Auto Exposure Buffer";
+
+		data->auto_exposure.buffer = Vulkan::Buffer::Create(auto_exposure_buffer_info);
+		data->auto_exposure.descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		Vulkan::Descriptor::Write(data->auto_exposure.descriptor, data->auto_exposure.buffer);
+
+		// Instance buffer, the descriptor stays the same for its whole lifetime
+		BufferCreateInfo instance_buffer_info = {};
+		instance_buffer_info.usage_flags = BUFFER_USAGE_READ_ONLY | BUFFER_USAGE_COPY_DST;
+		instance_buffer_info.memory_flags = GPU_MEMORY_DEVICE_LOCAL;
+		instance_buffer_info.size_in_bytes = sizeof(InstanceData) * MAX_DRAW_LIST_ENTRIES;
+		instance_buffer_info.name = "Instance Buffer";
+
+		data->instance_buffer.buffer = Vulkan::Buffer::Create(instance_buffer_info);
+		data->instance_buffer.descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		Vulkan::Descriptor::Write(data->instance_buffer.descriptor, data->instance_buffer.buffer);
+		data->instance_buffer.Init(MAX_DRAW_LIST_ENTRIES);
+
 		CreateDefaultMeshes();
 		CreateDefaultSamplers();
 		CreateDefaultTextures();
@@ -1390,34 +2518,70 @@ namespace Renderer
 		data->settings.postfx_gamma = 2.2f;
 		data->settings.postfx_max_white = 100.0f;
 
+		data->settings.postfx_use_auto_exposure = true;
+		data->settings.postfx_auto_exposure_min_log_luminance = -10.0f;
+		data->settings.postfx_auto_exposure_log_luminance_range = 22.0f;
+		data->settings.postfx_auto_exposure_adaptation_rate = 1.5f;
+
+		data->settings.postfx_use_bloom = true;
+		data->settings.postfx_bloom_intensity = 0.04f;
+
 		data->settings.debug_render_mode = DEBUG_RENDER_MODE_NONE;
 		data->settings.white_furnace_test = false;
+
+		data->settings.use_visibility_buffer = false;
 	}
 
 	void Exit()
 	{
+		bool headless = Vulkan::IsHeadless();
+
+		// Stop reloading shaders first, so that no pipelines are created while the render passes are destroyed
+		if (!headless)
+			Vulkan::DisableShaderHotReload();
+
 		// Wait for GPU to be idle before we start the cleanup
 		Vulkan::WaitDeviceIdle();
 
-		Vulkan::ExitImGui();
+		if (!headless)
+			Vulkan::ExitImGui();
 
 		Vulkan::DestroySampler(data->default_sampler);
 		Vulkan::DestroySampler(data->ibl_sampler);
+
+		Vulkan::Descriptor::Free(data->light_clusters.descriptor);
+		Vulkan::Buffer::Destroy(data->light_clusters.buffer);
+
+		Vulkan::Descriptor::Free(data->auto_exposure.descriptor);
+		Vulkan::Buffer::Destroy(data->auto_exposure.buffer);
+
+		Vulkan::Descriptor::Free(data->instance_buffer.descriptor);
+		Vulkan::Buffer::Destroy(data->instance_buffer.buffer);
+
+		DestroyRenderTargets();
+		data->render_graph.Destroy();
+		GPUProfiler::Exit();
 		
 		for (uint32_t frame_index = 0; frame_index < Vulkan::MAX_FRAMES_IN_FLIGHT; ++frame_index)
 		{
 			Vulkan::Descriptor::Free(data->per_frame[frame_index].raytracing.tlas_descriptor, frame_index);
 			Vulkan::Descriptor::Free(data->per_frame[frame_index].ubos.descriptors, frame_index);
 			Vulkan::CommandPool::FreeCommandBuffer(data->command_pools.graphics_compute, data->per_frame[frame_index].command_buffer);
+			Vulkan::CommandPool::FreeCommandBuffer(data->command_pools.compute, data->per_frame[frame_index].async_compute_command_buffer);
+			Vulkan::Query::DestroyPool(data->per_frame[frame_index].timestamps.query_pool);
 			Vulkan::Sync::DestroyFence(data->per_frame[frame_index].sync.render_finished_fence);
 
 			Vulkan::Buffer::Destroy(data->per_frame[frame_index].raytracing.tlas);
 			Vulkan::Buffer::Destroy(data->per_frame[frame_index].raytracing.tlas_scratch);
 			Vulkan::Buffer::Destroy(data->per_frame[frame_index].raytracing.tlas_instance_buffer);
+
+			Vulkan::DeviceMemory::Unmap(data->per_frame[frame_index].light_cluster_readback.buffer.memory);
+			Vulkan::Buffer::Destroy(data->per_frame[frame_index].light_cluster_readback.buffer);
 		}
 
 		Vulkan::CommandPool::Destroy(data->command_pools.graphics_compute);
 		Vulkan::CommandPool::Destroy(data->command_pools.transfer);
+		Vulkan::CommandPool::Destroy(data->command_pools.compute);
 
 		// Clean up the renderer data
 		delete data;
@@ -1427,15 +2591,69 @@ namespace Renderer
 		Vulkan::Exit();
 	}
 
-	void BeginFrame(const BeginFrameInfo& frame_info)
+	void WaitForFrame()
 	{
+		PROFILE_FUNCTION();
+
+		if (data->frame_pacing.waited_for_frame)
+			return;
+
+		// The frame slot depends on the number of frames in flight, so it has to be changed before picking the current frame
+		if (data->frame_pacing.num_frames_in_flight != Vulkan::GetNumFramesInFlight())
+		{
+			Vulkan::SetNumFramesInFlight(data->frame_pacing.num_frames_in_flight);
+
+			// Slots that were not cycled through before hold timestamps of frames from long ago, which would show up as a latency spike
+			for (Frame& slot : data->per_frame)
+			{
+				slot.timestamps.graphics_written = false;
+			}
+		}
+
 		Frame* frame = GetFrameCurrent();
 
-		// Wait for the current frame to finish rendering, reset command buffer and begin recording
+		// Wait for the frame that previously used this slot to finish rendering
 		Vulkan::CommandQueue::WaitFenceValue(data->command_queues.graphics_compute, frame->sync.frame_in_flight_fence_value);
+		Vulkan::CommandQueue::WaitFenceValue(data->command_queues.compute, frame->sync.async_compute_fence_value);
+		frame->finished_time = std::chrono::steady_clock::now();
+		ReadFrameTimestamps(frame);
+		ReadFrameLightClusters(frame);
+
+		WaitForFrameLimiter();
+
+		frame->input_sample_time = std::chrono::steady_clock::now();
+		data->frame_pacing.waited_for_frame = true;
+	}
+
+	void BeginFrame(const BeginFrameInfo& frame_info)
+	{
+		PROFILE_FUNCTION();
+
+		WaitForFrame();
+		data->frame_pacing.waited_for_frame = false;
+
+		// Reset command buffer and begin recording
+		Frame* frame = GetFrameCurrent();
+		GPUProfiler::BeginFrame(Vulkan::GetCurrentFrameIndex());
+
 		Vulkan::CommandBuffer::Reset(frame->command_buffer);
+		Vulkan::CommandBuffer::Reset(frame->async_compute_command_buffer);
 		Vulkan::CommandBuffer::BeginRecording(frame->command_buffer);
 
+		Vulkan::Command::ResetQueries(frame->command_buffer, frame->timestamps.query_pool, TIMESTAMP_QUERY_GRAPHICS_BEGIN, 2);
+		Vulkan::Command::WriteTimestamp(frame->command_buffer, frame->timestamps.query_pool, TIMESTAMP_QUERY_GRAPHICS_BEGIN, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT);
+		frame->timestamps.graphics_written = true;
+		frame->timestamps.async_compute_written = false;
+
+		// Swap in the pipelines recompiled by shader hot reload, before any of them are recorded for this frame
+		for (const auto& reloaded_pipeline : Vulkan::GetReloadedPipelines())
+		{
+			for (RenderPass* render_pass : GetRenderPasses())
+			{
+				render_pass->ReplacePipeline(reloaded_pipeline.old_pipeline, reloaded_pipeline.new_pipeline);
+			}
+		}
+
 		// Release TLAS buffers
 		Vulkan::Buffer::Destroy(frame->raytracing.tlas);
 		Vulkan::Buffer::Destroy(frame->raytracing.tlas_scratch);
@@ -1452,18 +2670,58 @@ namespace Renderer
 			return;
 		}
 
+		// The render targets do not need to be recreated when the render resolution changes, only the sub-rect that is rendered to changes
+		frame->render_scale = std::clamp(data->dynamic_resolution.render_scale, data->dynamic_resolution.min_render_scale, 1.0f);
+		data->render_resolution.width = std::max(1u, static_cast<uint32_t>(data->output_resolution.width * frame->render_scale + 0.5f));
+		data->render_resolution.height = std::max(1u, static_cast<uint32_t>(data->output_resolution.height * frame->render_scale + 0.5f));
+
 		// Set UBO data for the current frame, like camera data and settings
+		// The aspect ratio is taken from the output resolution, since rounding the render resolution would make it change with the render scale
 		GPUCamera camera_data = {};
 		camera_data.view = frame_info.camera_view;
 		camera_data.proj = glm::perspectiveFov(glm::radians(frame_info.camera_vfov),
-			(float)data->render_resolution.width, (float)data->render_resolution.height, data->camera_settings.near_plane, data->camera_settings.far_plane);
+			(float)data->output_resolution.width, (float)data->output_resolution.height, data->camera_settings.near_plane, data->camera_settings.far_plane);
 		camera_data.proj[1][1] *= -1.0f;
 		camera_data.view_pos = glm::inverse(frame_info.camera_view)[3];
+		camera_data.near_plane = data->camera_settings.near_plane;
+		camera_data.far_plane = data->camera_settings.far_plane;
+		camera_data.render_width = data->render_resolution.width;
+		camera_data.render_height = data->render_resolution.height;
+
+		// The motion vectors and culling use the unjittered projection, so that the jitter does not show up as motion
+		glm::mat4 unjittered_view_proj = camera_data.proj * camera_data.view;
+		if (!data->taa.prev_view_proj_valid)
+			data->taa.prev_view_proj = unjittered_view_proj;
+
+		camera_data.unjittered_view_proj = unjittered_view_proj;
+		camera_data.prev_view_proj = data->taa.prev_view_proj;
+		camera_data.reprojection = data->taa.prev_view_proj * glm::inverse(unjittered_view_proj);
+
+		data->taa.jitter = glm::vec2(0.0f);
+		if (data->taa.enabled)
+		{
+			// Every output pixel should get a few samples within the jitter sequence, so the sequence is longer when upsampling more
+			float upscale_factor = 1.0f / frame->render_scale;
+			uint32_t num_jitter_phases = std::clamp(static_cast<uint32_t>(8.0f * upscale_factor * upscale_factor), 8u, 64u);
+
+			data->taa.jitter_index = (data->taa.jitter_index + 1) % num_jitter_phases;
+			data->taa.jitter = glm::vec2(Halton(data->taa.jitter_index + 1, 2), Halton(data->taa.jitter_index + 1, 3)) - 0.5f;
+
+			// Offsets the projected positions by the jitter, in render resolution pixels
+			glm::vec3 jitter_ndc = glm::vec3(2.0f * data->taa.jitter.x / data->render_resolution.width, 2.0f * data->taa.jitter.y / data->render_resolution.height, 0.0f);
+			camera_data.proj = glm::translate(glm::identity<glm::mat4>(), jitter_ndc) * camera_data.proj;
+		}
+		camera_data.jitter = data->taa.jitter;
+
+		data->taa.prev_view_proj = unjittered_view_proj;
+		data->taa.prev_view_proj_valid = true;
+
+		data->culling.view_frustum = Frustum::FromViewProjection(unjittered_view_proj);
 
 		// Allocate frame UBOs from ring buffer
 		frame->ubos.settings_ubo = data->ring_buffer.Allocate(sizeof(RenderSettings), alignof(RenderSettings));
 		frame->ubos.camera_ubo = data->ring_buffer.Allocate(sizeof(GPUCamera), alignof(GPUCamera));
-		frame->ubos.light_ubo = data->ring_buffer.Allocate(3 * sizeof(uint32_t) + sizeof(GPUAreaLight) * MAX_AREA_LIGHTS);
+		frame->ubos.light_ubo = data->ring_buffer.Allocate(5 * sizeof(uint32_t));
 		frame->ubos.material_ubo = data->ring_buffer.Allocate(sizeof(GPUMaterial) * MAX_UNIQUE_MATERIALS);
 
 		// Write UBO descriptors
@@ -1476,14 +2734,14 @@ namespace Renderer
 		frame->ubos.camera_ubo.WriteBuffer(0, sizeof(GPUCamera), &camera_data);
 		frame->ubos.settings_ubo.WriteBuffer(0, sizeof(data->settings), &data->settings);
 
-		// Free the previous instance buffer descriptor if valid
-		if (Vulkan::Descriptor::IsValid(frame->instance_buffer.descriptor))
-			Vulkan::Descriptor::Free(frame->instance_buffer.descriptor);
+		// Free the previous area light buffer descriptor if valid
+		if (Vulkan::Descriptor::IsValid(frame->lights.area_light_descriptor))
+			Vulkan::Descriptor::Free(frame->lights.area_light_descriptor);
 
-		// Allocate instance buffer from ring buffer and allocate/write the descriptor
-		frame->instance_buffer.alloc = data->ring_buffer.Allocate(sizeof(InstanceData) * MAX_DRAW_LIST_ENTRIES);
-		frame->instance_buffer.descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_STORAGE_BUFFER);
-		Vulkan::Descriptor::Write(frame->instance_buffer.descriptor, frame->instance_buffer.alloc.buffer);
+		// Allocate area light buffer from ring buffer and allocate/write the descriptor
+		frame->lights.area_light_buffer = data->ring_buffer.Allocate(sizeof(GPUAreaLight) * MAX_AREA_LIGHTS, alignof(GPUAreaLight));
+		frame->lights.area_light_descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		Vulkan::Descriptor::Write(frame->lights.area_light_descriptor, frame->lights.area_light_buffer.buffer);
 
 		// If white furnace test is enabled or the skybox texture is invalid,
 		// we want to use the white furnace environment map to render instead of the one passed in
@@ -1496,8 +2754,18 @@ namespace Renderer
 
 	void RenderFrame()
 	{
+		PROFILE_FUNCTION();
+
 		Frame* frame = GetFrameCurrent();
 
+		bool use_async_compute = data->async_compute.enabled;
+		if (use_async_compute)
+		{
+			Vulkan::CommandBuffer::BeginRecording(frame->async_compute_command_buffer);
+			Vulkan::Command::ResetQueries(frame->async_compute_command_buffer, frame->timestamps.query_pool, TIMESTAMP_QUERY_ASYNC_COMPUTE_BEGIN, 2);
+			Vulkan::Command::WriteTimestamp(frame->async_compute_command_buffer, frame->timestamps.query_pool, TIMESTAMP_QUERY_ASYNC_COMPUTE_BEGIN, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT);
+		}
+
 		// Before we start rendering anything, we need to build the TLAS for the current frame
 		uint32_t num_blas_meshes = data->draw_list.next_free_entry;
 		std::vector<VulkanBuffer> mesh_blas_buffers(num_blas_meshes);
@@ -1516,6 +2784,22 @@ namespace Renderer
 			num_blas_meshes, mesh_blas_buffers.data(), mesh_transforms.data(), "TLAS Scene");
 		Vulkan::Descriptor::Write(frame->raytracing.tlas_descriptor, frame->raytracing.tlas);
 
+		// Cull the draw list against the view frustum, the TLAS above still contains every entry, since rays can hit meshes outside of it
+		DrawList& draw_list = data->draw_list;
+		if (data->culling.enabled)
+		{
+			FrustumCulling::BoundingSpheres bounding_spheres = { draw_list.bounds_x.data(), draw_list.bounds_y.data(), draw_list.bounds_z.data(), draw_list.bounds_radius.data() };
+			draw_list.num_visible_entries = FrustumCulling::CullSpheresParallel(data->culling.view_frustum, bounding_spheres,
+				draw_list.next_free_entry, draw_list.visible_entries.data(), data->culling.max_threads);
+		}
+		else
+		{
+			for (uint32_t i = 0; i < draw_list.next_free_entry; ++i)
+				draw_list.visible_entries[i] = i;
+			draw_list.num_visible_entries = draw_list.next_free_entry;
+		}
+		data->stats.num_visible_instances = draw_list.num_visible_entries;
+
 		// Update number of lights in the light ubo
 		Texture* ltc1_texture = data->texture_slotmap.Find(data->ltc_matrices_texture_handle);
 		Texture* ltc2_texture = data->texture_slotmap.Find(data->ltc_ggx_fresnel_sphere_clipping_texture_handle);
@@ -1523,6 +2807,8 @@ namespace Renderer
 		frame->ubos.light_ubo.WriteBuffer(0, sizeof(uint32_t), &data->num_area_lights);
 		frame->ubos.light_ubo.WriteBuffer(sizeof(uint32_t), sizeof(uint32_t), &ltc1_texture->view_descriptor.descriptor_offset);
 		frame->ubos.light_ubo.WriteBuffer(2 * sizeof(uint32_t), sizeof(uint32_t), &ltc2_texture->view_descriptor.descriptor_offset);
+		frame->ubos.light_ubo.WriteBuffer(3 * sizeof(uint32_t), sizeof(uint32_t), &frame->lights.area_light_descriptor.descriptor_offset);
+		frame->ubos.light_ubo.WriteBuffer(4 * sizeof(uint32_t), sizeof(uint32_t), &data->light_clusters.descriptor.descriptor_offset);
 
 		// Viewport and scissor rect
 		VkViewport viewport = {};
@@ -1537,210 +2823,989 @@ namespace Renderer
 		scissor_rect.offset = { 0, 0 };
 		scissor_rect.extent = { data->render_resolution.width, data->render_resolution.height };
 
+		// ----------------------------------------------------------------------------------------------------------------
+		// Render graph
+		// The passes below declare the resources they read and write, the render graph then culls passes whose outputs are not used,
+		// places the barriers between passes, and assigns transient render targets with non-overlapping lifetimes to shared memory
+
+		data->render_graph.Reset();
+
+		RenderGraph::ResourceID hdr_id = data->render_graph.ImportImage("HDR Render Target", &data->render_targets.hdr.image, true);
+		RenderGraph::ResourceID depth_id = data->render_graph.ImportImage("Depth Render Target", &data->render_targets.depth.image, true);
+		RenderGraph::ResourceID visibility_id = data->render_graph.ImportImage("Visibility Buffer Render Target", &data->render_targets.visibility.image, true);
+		RenderGraph::ResourceID velocity_id = data->render_graph.ImportImage("Velocity Render Target", &data->render_targets.velocity.image, true);
+		RenderGraph::ResourceID sdr_id = data->render_graph.ImportImage("SDR Render Target", &data->render_targets.sdr.image, true);
+
+		// The TAA history is read in the next frame, so it can not share memory with the other render targets
+		uint32_t taa_history_src_index = data->taa.history_index;
+		uint32_t taa_history_dst_index = (data->taa.history_index + 1) % 2;
+		RenderTarget& taa_history_src = data->render_targets.taa_history[taa_history_src_index];
+		RenderTarget& taa_history_dst = data->render_targets.taa_history[taa_history_dst_index];
+		RenderGraph::ResourceID taa_history_src_id = data->render_graph.ImportImage(std::format("TAA History Render Target {}", taa_history_src_index), &taa_history_src.image, false);
+		RenderGraph::ResourceID taa_history_dst_id = data->render_graph.ImportImage(std::format("TAA History Render Target {}", taa_history_dst_index), &taa_history_dst.image, false);
+		RenderGraph::ResourceID light_clusters_id = data->render_graph.ImportBuffer("Light Clusters", &data->light_clusters.buffer);
+		RenderGraph::ResourceID instance_buffer_id = data->render_graph.ImportBuffer("Instance Buffer", &data->instance_buffer.buffer);
+		RenderGraph::ResourceID auto_exposure_buffer_id = data->render_graph.ImportBuffer("Auto Exposure Buffer", &data->auto_exposure.buffer);
+
+		std::array<RenderGraph::ResourceID, BLOOM_NUM_MIPS> bloom_ids;
+		for (uint32_t mip = 0; mip < BLOOM_NUM_MIPS; ++mip)
+		{
+			bloom_ids[mip] = data->render_graph.ImportImage(std::format("Bloom Render Target {}", mip), &data->render_targets.bloom[mip].image, true);
+		}
+
+		// The SDR render target is used after the graph by the Dear ImGui pass and copied to the back buffer
+		data->render_graph.MarkOutput(sdr_id);
+
+		// ----------------------------------------------------------------------------------------------------------------
+		// Instance Upload Pass
+		// 1 - Copy the instances that changed since the previous frame into the instance buffer, runs of consecutive instances are copied as one region
+
+		InstanceBuffer& instance_buffer = data->instance_buffer;
+		if (!instance_buffer.dirty_instances.empty())
+		{
+			std::sort(instance_buffer.dirty_instances.begin(), instance_buffer.dirty_instances.end());
+
+			RingBuffer::Allocation instance_staging = data->ring_buffer.Allocate(instance_buffer.dirty_instances.size() * sizeof(InstanceData));
+			uint64_t staging_offset = 0;
+
+			instance_buffer.copy_regions.clear();
+			for (size_t i = 0; i < instance_buffer.dirty_instances.size();)
+			{
+				uint32_t first_instance = instance_buffer.dirty_instances[i];
+				uint32_t num_instances = 1;
+
+				while (i + num_instances < instance_buffer.dirty_instances.size() &&
+					instance_buffer.dirty_instances[i + num_instances] == first_instance + num_instances)
+				{
+					num_instances++;
+				}
+
+				uint64_t num_bytes = num_instances * sizeof(InstanceData);
+				instance_staging.WriteBuffer(staging_offset, num_bytes, &instance_buffer.resident_instances[first_instance]);
+				instance_buffer.copy_regions.push_back({ .srcOffset = staging_offset, .dstOffset = first_instance * sizeof(InstanceData), .size = num_bytes });
+
+				staging_offset += num_bytes;
+				i += num_instances;
+			}
+
+			data->stats.num_uploaded_instances = (uint32_t)instance_buffer.dirty_instances.size();
+			instance_buffer.dirty_instances.clear();
+
+			data->render_graph.AddPass({
+				.name = "Instance Upload",
+				.buffers = {
+					{ instance_buffer_id, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT }
+				},
+				// The resident instances already assume the upload happened, so it can never be culled
+				.has_side_effects = true,
+				.execute = [&, instance_staging](VulkanCommandBuffer& command_buffer)
+				{
+					Vulkan::Command::CopyBuffers(command_buffer, instance_staging.buffer, instance_buffer.buffer,
+						(uint32_t)instance_buffer.copy_regions.size(), instance_buffer.copy_regions.data());
+				}
+			});
+		}
+
 		// ----------------------------------------------------------------------------------------------------------------
 		// Skybox Pass (1 stage)
 		// 1 - Render the skybox cube
 
-		RENDER_PASS_BEGIN(data->render_passes.skybox);
-		{
-			RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_SKYBOX_STAGE_SKYBOX, RenderPass::ATTACHMENT_SLOT_COLOR0, data->render_targets.hdr.view);
+		data->render_graph.AddPass({
+			.name = "Skybox",
+			.images = {
+				{ hdr_id, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, RenderGraph::RESOURCE_ACCESS_WRITE }
+			},
+			.execute = [&](VulkanCommandBuffer& command_buffer)
+			{
+				RENDER_PASS_BEGIN(data->render_passes.skybox);
+				{
+					RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_SKYBOX_STAGE_SKYBOX, RenderPass::ATTACHMENT_SLOT_COLOR0, data->render_targets.hdr.view);
 			
-			RENDER_PASS_STAGE_BEGIN(RENDER_PASS_SKYBOX_STAGE_SKYBOX, frame->command_buffer, data->render_resolution.width, data->render_resolution.height);
+					RENDER_PASS_STAGE_BEGIN(RENDER_PASS_SKYBOX_STAGE_SKYBOX, command_buffer, data->render_resolution.width, data->render_resolution.height);
+
+					Vulkan::Command::SetViewport(command_buffer, 0, 1, &viewport);
+					Vulkan::Command::SetScissor(command_buffer, 0, 1, &scissor_rect);
+
+					struct PushConsts
+					{
+						uint32_t vb_index;
+
+						uint32_t env_texture_index;
+						uint32_t env_sampler_index;
+					} push_consts;
+
+					const Texture* skybox_texture = data->texture_slotmap.Find(data->skybox_texture_handle);
+					VK_ASSERT(skybox_texture && "Skybox cubemap is invalid for currently selected skybox");
+
+					const Mesh* unit_cube_mesh = data->mesh_slotmap.Find(data->unit_cube_mesh_handle);
+
+					push_consts.vb_index = unit_cube_mesh->vertex_buffer.descriptor.descriptor_offset;
+					Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &push_consts.vb_index);
+
+					push_consts.env_texture_index = skybox_texture->view_descriptor.descriptor_offset;
+					push_consts.env_sampler_index = data->default_sampler.descriptor.descriptor_offset;
+					Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(uint32_t), 2 * sizeof(uint32_t), &push_consts.env_texture_index);
+
+					Vulkan::Command::DrawGeometryIndexed(command_buffer, &unit_cube_mesh->index_buffer.buffer,
+						unit_cube_mesh->index_buffer.index_type, unit_cube_mesh->index_buffer.num_indices);
+
+					RENDER_PASS_STAGE_END(RENDER_PASS_SKYBOX_STAGE_SKYBOX, command_buffer);
+				}
+				RENDER_PASS_END(data->render_passes.skybox);
+			}
+		});
+
+		// ----------------------------------------------------------------------------------------------------------------
+		// Light Culling Pass (1 stage)
+		// 1 - Assign the area lights to the froxel clusters they influence
+
+		data->render_graph.AddPass({
+			.name = "Light Culling",
+			.buffers = {
+				{ light_clusters_id, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT }
+			},
+			// Only depends on the lights and the camera, so it can overlap with the skybox and the depth pre-pass
+			.async_compute = true,
+			.execute = [&](VulkanCommandBuffer& command_buffer)
+			{
+				RENDER_PASS_BEGIN(data->render_passes.light_culling);
+				{
+					RENDER_PASS_STAGE_BEGIN(RENDER_PASS_LIGHT_CULLING_STAGE_CLUSTER_LIGHTS, command_buffer, data->render_resolution.width, data->render_resolution.height);
+
+					uint32_t dispatch_x = VK_ALIGN_POW2(LIGHT_CLUSTERS_TOTAL, LIGHT_CULLING_GROUP_SIZE) / LIGHT_CULLING_GROUP_SIZE;
+					Vulkan::Command::Dispatch(command_buffer, dispatch_x, 1, 1);
+
+					RENDER_PASS_STAGE_END(RENDER_PASS_LIGHT_CULLING_STAGE_CLUSTER_LIGHTS, command_buffer);
+				}
+				RENDER_PASS_END(data->render_passes.light_culling);
+			}
+		});
+
+		data->render_graph.AddPass({
+			.name = "Light Cluster Readback",
+			.buffers = {
+				{ light_clusters_id, VK_ACCESS_2_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT }
+			},
+			// The light counts are read on the CPU once the frame has finished, so it can never be culled
+			.has_side_effects = true,
+			.async_compute = true,
+			.execute = [&, frame](VulkanCommandBuffer& command_buffer)
+			{
+				const VulkanBuffer& readback_buffer = frame->light_cluster_readback.buffer;
+				Vulkan::Command::CopyBuffers(command_buffer, data->light_clusters.buffer, 0, readback_buffer, 0, LIGHT_CLUSTERS_TOTAL * sizeof(uint32_t));
+
+				Vulkan::Command::BufferMemoryBarrier(command_buffer, {
+					.buffer = readback_buffer,
+					.src_access_flags = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+					.src_stage_flags = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+					.dst_access_flags = VK_ACCESS_2_HOST_READ_BIT,
+					.dst_stage_flags = VK_PIPELINE_STAGE_2_HOST_BIT
+				});
+				Vulkan::Command::FlushBarriers(command_buffer);
+			}
+		});
+		frame->light_cluster_readback.written = true;
+
+		// ----------------------------------------------------------------------------------------------------------------
+		// Geometry Pass (2 stages)
+		// 1 - Depth pre-pass stage
+		// 2 - Render geometry and evaluate lighting
+		// 3 - TODO: Transparent objects forward rendering stage
+
+		if (!data->settings.use_visibility_buffer)
+		{
+			data->render_graph.AddPass({
+				.name = "Depth Prepass",
+				.images = {
+					{ depth_id, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, RenderGraph::RESOURCE_ACCESS_WRITE },
+					{ velocity_id, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, RenderGraph::RESOURCE_ACCESS_WRITE }
+				},
+				.buffers = {
+					{ instance_buffer_id, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT }
+				},
+				.execute = [&](VulkanCommandBuffer& command_buffer)
+				{
+					RENDER_PASS_BEGIN(data->render_passes.geometry);
+					{
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEOMETRY_STAGE_DEPTH_PREPASS, RenderPass::ATTACHMENT_SLOT_COLOR0, data->render_targets.velocity.view);
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEOMETRY_STAGE_DEPTH_PREPASS, RenderPass::ATTACHMENT_SLOT_DEPTH_STENCIL, data->render_targets.depth.view);
+
+						RENDER_PASS_STAGE_BEGIN(RENDER_PASS_GEOMETRY_STAGE_DEPTH_PREPASS, command_buffer, data->render_resolution.width, data->render_resolution.height);
+
+						Vulkan::Command::SetViewport(command_buffer, 0, 1, &viewport);
+						Vulkan::Command::SetScissor(command_buffer, 0, 1, &scissor_rect);
+
+						struct PushConsts
+						{
+							uint32_t ib_index;
+							uint32_t vb_index;
+						} push;
+
+						push.ib_index = data->instance_buffer.descriptor.descriptor_offset;
+						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &push.ib_index);
+
+						for (uint32_t visible_index = 0; visible_index < data->draw_list.num_visible_entries; ++visible_index)
+						{
+							uint32_t i = data->draw_list.visible_entries[visible_index];
+
+							// NOTE: When we do vertex pulling instead, we can store the vertex/index buffer descriptor indices inside the instance data
+							// And then we could simply render all meshes with a single draw call
+							const DrawList::Entry& entry = data->draw_list.entries[i];
+							VK_ASSERT(entry.mesh && "Tried to render a mesh with an invalid mesh handle");
+
+							push.vb_index = entry.mesh->vertex_buffer.descriptor.descriptor_offset;
+							Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_VERTEX_BIT, sizeof(uint32_t), sizeof(uint32_t), &push.vb_index);
+
+							Vulkan::Command::DrawGeometryIndexed(command_buffer, &entry.mesh->index_buffer.buffer,
+								entry.mesh->index_buffer.index_type, entry.mesh->index_buffer.num_indices, 1, entry.instance_index);
+						}
+
+						RENDER_PASS_STAGE_END(RENDER_PASS_GEOMETRY_STAGE_DEPTH_PREPASS, command_buffer);
+					}
+					RENDER_PASS_END(data->render_passes.geometry);
+				}
+			});
+
+			data->render_graph.AddPass({
+				.name = "Forward Lighting",
+				.images = {
+					{ hdr_id, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, RenderGraph::RESOURCE_ACCESS_READ_WRITE },
+					{ depth_id, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, RenderGraph::RESOURCE_ACCESS_READ }
+				},
+				.buffers = {
+					{ light_clusters_id, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT },
+					{ instance_buffer_id, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT }
+				},
+				.execute = [&](VulkanCommandBuffer& command_buffer)
+				{
+					RENDER_PASS_BEGIN(data->render_passes.geometry);
+					{
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEOMETRY_STAGE_LIGHTING, RenderPass::ATTACHMENT_SLOT_COLOR0, data->render_targets.hdr.view);
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEOMETRY_STAGE_LIGHTING, RenderPass::ATTACHMENT_SLOT_DEPTH_STENCIL, data->render_targets.depth.view);
+
+						RENDER_PASS_STAGE_BEGIN(RENDER_PASS_GEOMETRY_STAGE_LIGHTING, command_buffer, data->render_resolution.width, data->render_resolution.height);
+
+						// Viewport and scissor
+						Vulkan::Command::SetViewport(command_buffer, 0, 1, &viewport);
+						Vulkan::Command::SetScissor(command_buffer, 0, 1, &scissor_rect);
+
+						const Texture* skybox_texture = data->texture_slotmap.Find(data->skybox_texture_handle);
+						VK_ASSERT(skybox_texture && "Skybox cubemap is invalid for currently selected skybox");
+
+						const Texture* irradiance_cubemap = data->texture_slotmap.Find(skybox_texture->next);
+						VK_ASSERT(irradiance_cubemap && "Irradiance cubemap is invalid for currently selected skybox");
+
+						const Texture* prefiltered_cubemap = data->texture_slotmap.Find(irradiance_cubemap->next);
+						VK_ASSERT(prefiltered_cubemap && "Prefiltered cubemap is invalid for currently selected skybox");
+
+						const Texture* brdf_lut = data->texture_slotmap.Find(data->ibl.brdf_lut_handle);
+						VK_ASSERT(brdf_lut && "BRDF LUT is invalid");
+
+						// Push constants
+						struct PushConsts
+						{
+							uint32_t ib_index;
+							uint32_t vb_index;
+
+							uint32_t irradiance_cubemap_index;
+							uint32_t irradiance_sampler_index;
+							uint32_t prefiltered_cubemap_index;
+							uint32_t prefiltered_sampler_index;
+							uint32_t num_prefiltered_mips;
+							uint32_t brdf_lut_index;
+							uint32_t brdf_lut_sampler_index;
+							uint32_t tlas_index;
+						} push_consts;
+
+						push_consts.ib_index = data->instance_buffer.descriptor.descriptor_offset;
+						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &push_consts.ib_index);
+
+						push_consts.irradiance_cubemap_index = irradiance_cubemap->view_descriptor.descriptor_offset;
+						push_consts.irradiance_sampler_index = irradiance_cubemap->sampler.descriptor.descriptor_offset;
+						push_consts.prefiltered_cubemap_index = prefiltered_cubemap->view_descriptor.descriptor_offset;
+						push_consts.prefiltered_sampler_index = prefiltered_cubemap->sampler.descriptor.descriptor_offset;
+						push_consts.num_prefiltered_mips = prefiltered_cubemap->view.num_mips - 1;
+						push_consts.brdf_lut_index = brdf_lut->view_descriptor.descriptor_offset;
+						push_consts.brdf_lut_sampler_index = brdf_lut->sampler.descriptor.descriptor_offset;
+						push_consts.tlas_index = frame->raytracing.tlas_descriptor.descriptor_offset;
+
+						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_FRAGMENT_BIT, 2 * sizeof(uint32_t), 8 * sizeof(uint32_t), &push_consts.irradiance_cubemap_index);
+
+						for (uint32_t visible_index = 0; visible_index < data->draw_list.num_visible_entries; ++visible_index)
+						{
+							uint32_t i = data->draw_list.visible_entries[visible_index];
+							const DrawList::Entry& entry = data->draw_list.entries[i];
+							VK_ASSERT(entry.mesh && "Tried to render a mesh with an invalid mesh handle");
+
+							push_consts.vb_index = entry.mesh->vertex_buffer.descriptor.descriptor_offset;
+							Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_VERTEX_BIT, sizeof(uint32_t), sizeof(uint32_t), &push_consts.vb_index);
+					
+							Vulkan::Command::DrawGeometryIndexed(command_buffer, &entry.mesh->index_buffer.buffer,
+								entry.mesh->index_buffer.index_type, entry.mesh->index_buffer.num_indices, 1, entry.instance_index);
+
+							data->stats.total_vertex_count += entry.mesh->vertex_buffer.buffer.size_in_bytes / sizeof(Vertex);
+							data->stats.total_triangle_count += entry.mesh->index_buffer.num_indices / 3;
+						}
+
+						RENDER_PASS_STAGE_END(RENDER_PASS_GEOMETRY_STAGE_LIGHTING, command_buffer);
+					}
+					RENDER_PASS_END(data->render_passes.geometry);
+				}
+			});
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------
+		// Visibility Buffer Pass (2 stages)
+		// 1 - Render the instance and triangle index of each visible pixel into the visibility buffer
+		// 2 - Reconstruct the surface attributes from the visibility buffer and evaluate lighting once per pixel
+
+		if (data->settings.use_visibility_buffer)
+		{
+			data->render_graph.AddPass({
+				.name = "Visibility",
+				.images = {
+					{ visibility_id, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, RenderGraph::RESOURCE_ACCESS_WRITE },
+					{ velocity_id, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, RenderGraph::RESOURCE_ACCESS_WRITE },
+					{ depth_id, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, RenderGraph::RESOURCE_ACCESS_WRITE }
+				},
+				.buffers = {
+					{ instance_buffer_id, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT }
+				},
+				.execute = [&](VulkanCommandBuffer& command_buffer)
+				{
+					RENDER_PASS_BEGIN(data->render_passes.visibility_buffer);
+					{
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_VISIBILITY_BUFFER_STAGE_VISIBILITY, RenderPass::ATTACHMENT_SLOT_COLOR0, data->render_targets.visibility.view);
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_VISIBILITY_BUFFER_STAGE_VISIBILITY, RenderPass::ATTACHMENT_SLOT_COLOR1, data->render_targets.velocity.view);
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_VISIBILITY_BUFFER_STAGE_VISIBILITY, RenderPass::ATTACHMENT_SLOT_DEPTH_STENCIL, data->render_targets.depth.view);
+
+						RENDER_PASS_STAGE_BEGIN(RENDER_PASS_VISIBILITY_BUFFER_STAGE_VISIBILITY, command_buffer, data->render_resolution.width, data->render_resolution.height);
+
+						Vulkan::Command::SetViewport(command_buffer, 0, 1, &viewport);
+						Vulkan::Command::SetScissor(command_buffer, 0, 1, &scissor_rect);
+
+						struct PushConsts
+						{
+							uint32_t ib_index;
+							uint32_t vb_index;
+						} push;
+
+						push.ib_index = data->instance_buffer.descriptor.descriptor_offset;
+						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &push.ib_index);
+
+						for (uint32_t visible_index = 0; visible_index < data->draw_list.num_visible_entries; ++visible_index)
+						{
+							uint32_t i = data->draw_list.visible_entries[visible_index];
+							const DrawList::Entry& entry = data->draw_list.entries[i];
+							VK_ASSERT(entry.mesh && "Tried to render a mesh with an invalid mesh handle");
+
+							push.vb_index = entry.mesh->vertex_buffer.descriptor.descriptor_offset;
+							Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_VERTEX_BIT, sizeof(uint32_t), sizeof(uint32_t), &push.vb_index);
+
+							Vulkan::Command::DrawGeometryIndexed(command_buffer, &entry.mesh->index_buffer.buffer,
+								entry.mesh->index_buffer.index_type, entry.mesh->index_buffer.num_indices, 1, entry.instance_index);
+
+							data->stats.total_vertex_count += entry.mesh->vertex_buffer.buffer.size_in_bytes / sizeof(Vertex);
+							data->stats.total_triangle_count += entry.mesh->index_buffer.num_indices / 3;
+						}
+
+						RENDER_PASS_STAGE_END(RENDER_PASS_VISIBILITY_BUFFER_STAGE_VISIBILITY, command_buffer);
+					}
+					RENDER_PASS_END(data->render_passes.visibility_buffer);
+				}
+			});
+
+			data->render_graph.AddPass({
+				.name = "Visibility Shading",
+				.images = {
+					{ visibility_id, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, RenderGraph::RESOURCE_ACCESS_READ },
+					{ hdr_id, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, RenderGraph::RESOURCE_ACCESS_READ_WRITE }
+				},
+				.buffers = {
+					{ light_clusters_id, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT },
+					{ instance_buffer_id, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT }
+				},
+				.execute = [&](VulkanCommandBuffer& command_buffer)
+				{
+					RENDER_PASS_BEGIN(data->render_passes.visibility_buffer);
+					{
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_VISIBILITY_BUFFER_STAGE_SHADING, RenderPass::ATTACHMENT_SLOT_READ_ONLY0, data->render_targets.visibility.view);
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_VISIBILITY_BUFFER_STAGE_SHADING, RenderPass::ATTACHMENT_SLOT_COLOR0, data->render_targets.hdr.view);
+
+						RENDER_PASS_STAGE_BEGIN(RENDER_PASS_VISIBILITY_BUFFER_STAGE_SHADING, command_buffer, data->render_resolution.width, data->render_resolution.height);
+
+						Vulkan::Command::SetViewport(command_buffer, 0, 1, &viewport);
+						Vulkan::Command::SetScissor(command_buffer, 0, 1, &scissor_rect);
+
+						const Texture* skybox_texture = data->texture_slotmap.Find(data->skybox_texture_handle);
+						VK_ASSERT(skybox_texture && "Skybox cubemap is invalid for currently selected skybox");
+
+						const Texture* irradiance_cubemap = data->texture_slotmap.Find(skybox_texture->next);
+						VK_ASSERT(irradiance_cubemap && "Irradiance cubemap is invalid for currently selected skybox");
+
+						const Texture* prefiltered_cubemap = data->texture_slotmap.Find(irradiance_cubemap->next);
+						VK_ASSERT(prefiltered_cubemap && "Prefiltered cubemap is invalid for currently selected skybox");
+
+						const Texture* brdf_lut = data->texture_slotmap.Find(data->ibl.brdf_lut_handle);
+						VK_ASSERT(brdf_lut && "BRDF LUT is invalid");
+
+						// Push constants, the offsets match the fragment push constants of the forward lighting stage
+						struct PushConsts
+						{
+							uint32_t irradiance_cubemap_index;
+							uint32_t irradiance_sampler_index;
+							uint32_t prefiltered_cubemap_index;
+							uint32_t prefiltered_sampler_index;
+							uint32_t num_prefiltered_mips;
+							uint32_t brdf_lut_index;
+							uint32_t brdf_lut_sampler_index;
+							uint32_t tlas_index;
+							uint32_t ib_index;
+							uint32_t visibility_buffer_index;
+						} push_consts;
+
+						push_consts.irradiance_cubemap_index = irradiance_cubemap->view_descriptor.descriptor_offset;
+						push_consts.irradiance_sampler_index = irradiance_cubemap->sampler.descriptor.descriptor_offset;
+						push_consts.prefiltered_cubemap_index = prefiltered_cubemap->view_descriptor.descriptor_offset;
+						push_consts.prefiltered_sampler_index = prefiltered_cubemap->sampler.descriptor.descriptor_offset;
+						push_consts.num_prefiltered_mips = prefiltered_cubemap->view.num_mips - 1;
+						push_consts.brdf_lut_index = brdf_lut->view_descriptor.descriptor_offset;
+						push_consts.brdf_lut_sampler_index = brdf_lut->sampler.descriptor.descriptor_offset;
+						push_consts.tlas_index = frame->raytracing.tlas_descriptor.descriptor_offset;
+						push_consts.ib_index = data->instance_buffer.descriptor.descriptor_offset;
+						push_consts.visibility_buffer_index = data->render_targets.visibility.descriptor.descriptor_offset;
+
+						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_FRAGMENT_BIT, 2 * sizeof(uint32_t), sizeof(PushConsts), &push_consts);
+
+						// Full screen triangle
+						Vulkan::Command::DrawGeometry(command_buffer, 3);
+
+						RENDER_PASS_STAGE_END(RENDER_PASS_VISIBILITY_BUFFER_STAGE_SHADING, command_buffer);
+					}
+					RENDER_PASS_END(data->render_passes.visibility_buffer);
+				}
+			});
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------
+		// Temporal Anti-aliasing Pass (1 stage)
+		// 1 - Blend the current frame into the reprojected history, upsampling from the render resolution to the output resolution
+
+		bool use_taa = data->taa.enabled;
+		if (use_taa)
+		{
+			data->render_graph.AddPass({
+				.name = "TAA Resolve",
+				.images = {
+					{ hdr_id, VK_IMAGE_LAYOUT_GENERAL, RenderGraph::RESOURCE_ACCESS_READ },
+					{ velocity_id, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, RenderGraph::RESOURCE_ACCESS_READ },
+					{ taa_history_src_id, VK_IMAGE_LAYOUT_GENERAL, RenderGraph::RESOURCE_ACCESS_READ },
+					{ taa_history_dst_id, VK_IMAGE_LAYOUT_GENERAL, RenderGraph::RESOURCE_ACCESS_WRITE }
+				},
+				.execute = [&](VulkanCommandBuffer& command_buffer)
+				{
+					RENDER_PASS_BEGIN(data->render_passes.taa);
+					{
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_TAA_STAGE_RESOLVE, RenderPass::ATTACHMENT_SLOT_READ_ONLY0, data->render_targets.hdr.view);
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_TAA_STAGE_RESOLVE, RenderPass::ATTACHMENT_SLOT_READ_ONLY1, data->render_targets.velocity.view);
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_TAA_STAGE_RESOLVE, RenderPass::ATTACHMENT_SLOT_READ_WRITE0, taa_history_dst.view);
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_TAA_STAGE_RESOLVE, RenderPass::ATTACHMENT_SLOT_READ_WRITE1, taa_history_src.view);
+
+						RENDER_PASS_STAGE_BEGIN(RENDER_PASS_TAA_STAGE_RESOLVE, command_buffer, data->output_resolution.width, data->output_resolution.height);
+
+						struct PushConsts
+						{
+							uint32_t hdr_src_index;
+							uint32_t velocity_src_index;
+							uint32_t history_src_index;
+							uint32_t history_dst_index;
+							uint32_t history_valid;
+							float blend_factor;
+						} push_consts;
+
+						push_consts.hdr_src_index = data->render_targets.hdr.descriptor.descriptor_offset;
+						push_consts.velocity_src_index = data->render_targets.velocity.descriptor.descriptor_offset;
+						push_consts.history_src_index = taa_history_src.descriptor.descriptor_offset;
+						push_consts.history_dst_index = taa_history_dst.descriptor.descriptor_offset;
+						push_consts.history_valid = data->taa.history_valid;
+						push_consts.blend_factor = data->taa.blend_factor;
+
+						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConsts), &push_consts);
+
+						uint32_t dispatch_x = VK_ALIGN_POW2(data->output_resolution.width, TAA_RESOLVE_GROUP_SIZE) / TAA_RESOLVE_GROUP_SIZE;
+						uint32_t dispatch_y = VK_ALIGN_POW2(data->output_resolution.height, TAA_RESOLVE_GROUP_SIZE) / TAA_RESOLVE_GROUP_SIZE;
+						Vulkan::Command::Dispatch(command_buffer, dispatch_x, dispatch_y, 1);
+
+						RENDER_PASS_STAGE_END(RENDER_PASS_TAA_STAGE_RESOLVE, command_buffer);
+					}
+					RENDER_PASS_END(data->render_passes.taa);
+				}
+			});
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------
+		// Post-process Pass (5 stages)
+		// 1 - Build the luminance histogram of the source
+		// 2 - Reduce the histogram to the average luminance, adapt to it and derive the exposure
+		// 3 - Downsample the source into the bloom mip chain
+		// 4 - Upsample and accumulate the bloom mip chain back up to the first mip
+		// 5 - Upscale, bloom composite, exposure, tonemapping, gamma correction and sharpening, fused into one pass
+
+		// With temporal anti-aliasing the history is already at the output resolution, otherwise this upscales from the render resolution
+		RenderTarget& post_process_src = use_taa ? taa_history_dst : data->render_targets.hdr;
+		RenderGraph::ResourceID post_process_src_id = use_taa ? taa_history_dst_id : hdr_id;
+		Data::Resolution post_process_src_resolution = use_taa ? data->output_resolution : data->render_resolution;
+
+		// The bloom mips are allocated relative to the output resolution, but only the part that matches the source resolution is used
+		std::array<Data::Resolution, BLOOM_NUM_MIPS> bloom_resolutions;
+		for (uint32_t mip = 0; mip < BLOOM_NUM_MIPS; ++mip)
+		{
+			bloom_resolutions[mip].width = std::max(post_process_src_resolution.width >> (mip + 1), 1u);
+			bloom_resolutions[mip].height = std::max(post_process_src_resolution.height >> (mip + 1), 1u);
+		}
+
+		bool use_auto_exposure = data->settings.postfx_use_auto_exposure;
+		bool use_bloom = data->settings.postfx_use_bloom;
+
+		std::chrono::steady_clock::time_point frame_time = std::chrono::steady_clock::now();
+		float auto_exposure_delta_time = data->auto_exposure.prev_frame_time == std::chrono::steady_clock::time_point() ? 0.0f :
+			std::chrono::duration<float>(frame_time - data->auto_exposure.prev_frame_time).count();
+		data->auto_exposure.prev_frame_time = frame_time;
+
+		if (use_auto_exposure)
+		{
+			if (!data->auto_exposure.cleared)
+			{
+				AutoExposureData cleared_auto_exposure = {};
+				RingBuffer::Allocation auto_exposure_staging = data->ring_buffer.Allocate(sizeof(AutoExposureData));
+				auto_exposure_staging.WriteBuffer(0, sizeof(AutoExposureData), &cleared_auto_exposure);
+
+				data->render_graph.AddPass({
+					.name = "Auto Exposure Clear",
+					.buffers = {
+						{ auto_exposure_buffer_id, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT }
+					},
+					// The buffer is only cleared once, so it can never be culled
+					.has_side_effects = true,
+					.execute = [&, auto_exposure_staging](VulkanCommandBuffer& command_buffer)
+					{
+						Vulkan::Command::CopyBuffers(command_buffer, auto_exposure_staging.buffer, 0, data->auto_exposure.buffer, 0, sizeof(AutoExposureData));
+					}
+				});
+
+				data->auto_exposure.cleared = true;
+			}
+
+			data->render_graph.AddPass({
+				.name = "Luminance Histogram",
+				.images = {
+					{ post_process_src_id, VK_IMAGE_LAYOUT_GENERAL, RenderGraph::RESOURCE_ACCESS_READ }
+				},
+				.buffers = {
+					{ auto_exposure_buffer_id, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT }
+				},
+				.execute = [&](VulkanCommandBuffer& command_buffer)
+				{
+					RENDER_PASS_BEGIN(data->render_passes.post_process);
+					{
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_POST_PROCESS_STAGE_LUMINANCE_HISTOGRAM, RenderPass::ATTACHMENT_SLOT_READ_ONLY0, post_process_src.view);
+
+						RENDER_PASS_STAGE_BEGIN(RENDER_PASS_POST_PROCESS_STAGE_LUMINANCE_HISTOGRAM, command_buffer, post_process_src_resolution.width, post_process_src_resolution.height);
+
+						struct PushConsts
+						{
+							uint32_t src_index;
+							uint32_t src_width;
+							uint32_t src_height;
+							uint32_t dst_buffer_index;
+						} push_consts;
+
+						push_consts.src_index = post_process_src.descriptor.descriptor_offset;
+						push_consts.src_width = post_process_src_resolution.width;
+						push_consts.src_height = post_process_src_resolution.height;
+						push_consts.dst_buffer_index = data->auto_exposure.descriptor.descriptor_offset;
+
+						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConsts), &push_consts);
+
+						uint32_t dispatch_x = VK_ALIGN_POW2(post_process_src_resolution.width, LUMINANCE_HISTOGRAM_GROUP_SIZE) / LUMINANCE_HISTOGRAM_GROUP_SIZE;
+						uint32_t dispatch_y = VK_ALIGN_POW2(post_process_src_resolution.height, LUMINANCE_HISTOGRAM_GROUP_SIZE) / LUMINANCE_HISTOGRAM_GROUP_SIZE;
+						Vulkan::Command::Dispatch(command_buffer, dispatch_x, dispatch_y, 1);
+
+						RENDER_PASS_STAGE_END(RENDER_PASS_POST_PROCESS_STAGE_LUMINANCE_HISTOGRAM, command_buffer);
+					}
+					RENDER_PASS_END(data->render_passes.post_process);
+				}
+			});
+
+			data->render_graph.AddPass({
+				.name = "Auto Exposure",
+				.buffers = {
+					{ auto_exposure_buffer_id, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT }
+				},
+				.execute = [&](VulkanCommandBuffer& command_buffer)
+				{
+					RENDER_PASS_BEGIN(data->render_passes.post_process);
+					{
+						RENDER_PASS_STAGE_BEGIN(RENDER_PASS_POST_PROCESS_STAGE_AUTO_EXPOSURE, command_buffer, LUMINANCE_HISTOGRAM_NUM_BINS, 1);
+
+						struct PushConsts
+						{
+							uint32_t buffer_index;
+							uint32_t num_pixels;
+							float delta_time;
+						} push_consts;
+
+						push_consts.buffer_index = data->auto_exposure.descriptor.descriptor_offset;
+						push_consts.num_pixels = post_process_src_resolution.width * post_process_src_resolution.height;
+						push_consts.delta_time = auto_exposure_delta_time;
+
+						Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConsts), &push_consts);
+						Vulkan::Command::Dispatch(command_buffer, 1, 1, 1);
+
+						RENDER_PASS_STAGE_END(RENDER_PASS_POST_PROCESS_STAGE_AUTO_EXPOSURE, command_buffer);
+					}
+					RENDER_PASS_END(data->render_passes.post_process);
+				}
+			});
+		}
+
+		if (use_bloom)
+		{
+			std::vector<RenderGraph::ImageUsage> bloom_images = { { post_process_src_id, VK_IMAGE_LAYOUT_GENERAL, RenderGraph::RESOURCE_ACCESS_READ } };
+			for (uint32_t mip = 0; mip < BLOOM_NUM_MIPS; ++mip)
+			{
+				bloom_images.push_back({ bloom_ids[mip], VK_IMAGE_LAYOUT_GENERAL, RenderGraph::RESOURCE_ACCESS_READ_WRITE });
+			}
+
+			data->render_graph.AddPass({
+				.name = "Bloom",
+				.images = bloom_images,
+				.execute = [&](VulkanCommandBuffer& command_buffer)
+				{
+					RENDER_PASS_BEGIN(data->render_passes.post_process);
+					{
+						struct PushConsts
+						{
+							uint32_t src_index;
+							uint32_t dst_index;
+							uint32_t src_width;
+							uint32_t src_height;
+							uint32_t dst_width;
+							uint32_t dst_height;
+							uint32_t use_karis_average;
+						} push_consts;
+
+						// Each mip reads the previous one, so the previous one needs a barrier after it was written
+						RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_POST_PROCESS_STAGE_BLOOM_DOWNSAMPLE, RenderPass::ATTACHMENT_SLOT_READ_ONLY0, post_process_src.view);
+						RENDER_PASS_STAGE_BEGIN(RENDER_PASS_POST_PROCESS_STAGE_BLOOM_DOWNSAMPLE, command_buffer, bloom_resolutions[0].width, bloom_resolutions[0].height);
+
+						for (uint32_t mip = 0; mip < BLOOM_NUM_MIPS; ++mip)
+						{
+							const RenderTarget& src = mip == 0 ? post_process_src : data->render_targets.bloom[mip - 1];
+							const Data::Resolution& src_resolution = mip == 0 ? post_process_src_resolution : bloom_resolutions[mip - 1];
+
+							push_consts.src_index = src.descriptor.descriptor_offset;
+							push_consts.dst_index = data->render_targets.bloom[mip].descriptor.descriptor_offset;
+							push_consts.src_width = src_resolution.width;
+							push_consts.src_height = src_resolution.height;
+							push_consts.dst_width = bloom_resolutions[mip].width;
+							push_consts.dst_height = bloom_resolutions[mip].height;
+							push_consts.use_karis_average = mip == 0;
+
+							Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConsts), &push_consts);
 
-			Vulkan::Command::SetViewport(frame->command_buffer, 0, 1, &viewport);
-			Vulkan::Command::SetScissor(frame->command_buffer, 0, 1, &scissor_rect);
+							uint32_t dispatch_x = VK_ALIGN_POW2(bloom_resolutions[mip].width, POST_PROCESS_GROUP_SIZE) / POST_PROCESS_GROUP_SIZE;
+							uint32_t dispatch_y = VK_ALIGN_POW2(bloom_resolutions[mip].height, POST_PROCESS_GROUP_SIZE) / POST_PROCESS_GROUP_SIZE;
+							Vulkan::Command::Dispatch(command_buffer, dispatch_x, dispatch_y, 1);
 
-			struct PushConsts
-			{
-				uint32_t vb_index;
+							Vulkan::Command::TransitionLayout(command_buffer, { .image = data->render_targets.bloom[mip].image, .new_layout = VK_IMAGE_LAYOUT_GENERAL });
+						}
 
-				uint32_t env_texture_index;
-				uint32_t env_sampler_index;
-			} push_consts;
+						RENDER_PASS_STAGE_END(RENDER_PASS_POST_PROCESS_STAGE_BLOOM_DOWNSAMPLE, command_buffer);
 
-			const Texture* skybox_texture = data->texture_slotmap.Find(data->skybox_texture_handle);
-			VK_ASSERT(skybox_texture && "Skybox cubemap is invalid for currently selected skybox");
+						RENDER_PASS_STAGE_BEGIN(RENDER_PASS_POST_PROCESS_STAGE_BLOOM_UPSAMPLE, command_buffer, bloom_resolutions[0].width, bloom_resolutions[0].height);
 
-			const Mesh* unit_cube_mesh = data->mesh_slotmap.Find(data->unit_cube_mesh_handle);
+						for (uint32_t mip = BLOOM_NUM_MIPS - 1; mip > 0; --mip)
+						{
+							push_consts.src_index = data->render_targets.bloom[mip].descriptor.descriptor_offset;
+							push_consts.dst_index = data->render_targets.bloom[mip - 1].descriptor.descriptor_offset;
+							push_consts.src_width = bloom_resolutions[mip].width;
+							push_consts.src_height = bloom_resolutions[mip].height;
+							push_consts.dst_width = bloom_resolutions[mip - 1].width;
+							push_consts.dst_height = bloom_resolutions[mip - 1].height;
 
-			push_consts.vb_index = unit_cube_mesh->vertex_buffer.descriptor.descriptor_offset;
-			Vulkan::Command::PushConstants(frame->command_buffer, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &push_consts.vb_index);
+							Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, 6 * sizeof(uint32_t), &push_consts);
 
-			push_consts.env_texture_index = skybox_texture->view_descriptor.descriptor_offset;
-			push_consts.env_sampler_index = data->default_sampler.descriptor.descriptor_offset;
-			Vulkan::Command::PushConstants(frame->command_buffer, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(uint32_t), 2 * sizeof(uint32_t), &push_consts.env_texture_index);
+							uint32_t dispatch_x = VK_ALIGN_POW2(bloom_resolutions[mip - 1].width, POST_PROCESS_GROUP_SIZE) / POST_PROCESS_GROUP_SIZE;
+							uint32_t dispatch_y = VK_ALIGN_POW2(bloom_resolutions[mip - 1].height, POST_PROCESS_GROUP_SIZE) / POST_PROCESS_GROUP_SIZE;
+							Vulkan::Command::Dispatch(command_buffer, dispatch_x, dispatch_y, 1);
 
-			Vulkan::Command::DrawGeometryIndexed(frame->command_buffer, &unit_cube_mesh->index_buffer.buffer,
-				unit_cube_mesh->index_buffer.index_type, unit_cube_mesh->index_buffer.num_indices);
+							Vulkan::Command::TransitionLayout(command_buffer, { .image = data->render_targets.bloom[mip - 1].image, .new_layout = VK_IMAGE_LAYOUT_GENERAL });
+						}
 
-			RENDER_PASS_STAGE_END(RENDER_PASS_SKYBOX_STAGE_SKYBOX, frame->command_buffer);
+						RENDER_PASS_STAGE_END(RENDER_PASS_POST_PROCESS_STAGE_BLOOM_UPSAMPLE, command_buffer);
+					}
+					RENDER_PASS_END(data->render_passes.post_process);
+				}
+			});
 		}
-		RENDER_PASS_END(data->render_passes.skybox);
-
-		// ----------------------------------------------------------------------------------------------------------------
-		// Geometry Pass (1 stage)
-		// 1 - Depth pre-pass stage
-		// 2 - Render geometry and evaluate lighting
-		// 3 - TODO: Transparent objects forward rendering stage
 
-		RENDER_PASS_BEGIN(data->render_passes.geometry);
-		{
-			// Depth pre-pass stage
+		std::vector<RenderGraph::ImageUsage> post_process_images = {
+			{ post_process_src_id, VK_IMAGE_LAYOUT_GENERAL, RenderGraph::RESOURCE_ACCESS_READ },
+			{ sdr_id, VK_IMAGE_LAYOUT_GENERAL, RenderGraph::RESOURCE_ACCESS_WRITE }
+		};
+		if (use_bloom)
+			post_process_images.push_back({ bloom_ids[0], VK_IMAGE_LAYOUT_GENERAL, RenderGraph::RESOURCE_ACCESS_READ });
+
+		std::vector<RenderGraph::BufferUsage> post_process_buffers;
+		if (use_auto_exposure)
+			post_process_buffers.push_back({ auto_exposure_buffer_id, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT });
+
+		data->render_graph.AddPass({
+			.name = "Post Process",
+			.images = post_process_images,
+			.buffers = post_process_buffers,
+			.execute = [&](VulkanCommandBuffer& command_buffer)
 			{
-				RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEOMETRY_STAGE_DEPTH_PREPASS, RenderPass::ATTACHMENT_SLOT_DEPTH_STENCIL, data->render_targets.depth.view);
+				RENDER_PASS_BEGIN(data->render_passes.post_process);
+				{
+					RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_POST_PROCESS_STAGE_TONEMAP_GAMMA_EXPOSURE, RenderPass::ATTACHMENT_SLOT_READ_ONLY0, post_process_src.view);
+					RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_POST_PROCESS_STAGE_TONEMAP_GAMMA_EXPOSURE, RenderPass::ATTACHMENT_SLOT_READ_WRITE0, data->render_targets.sdr.view);
 
-				RENDER_PASS_STAGE_BEGIN(RENDER_PASS_GEOMETRY_STAGE_DEPTH_PREPASS, frame->command_buffer, data->render_resolution.width, data->render_resolution.height);
+					// Runs at the output resolution, upscaling from the render resolution
+					RENDER_PASS_STAGE_BEGIN(RENDER_PASS_POST_PROCESS_STAGE_TONEMAP_GAMMA_EXPOSURE, command_buffer, data->output_resolution.width, data->output_resolution.height);
 
-				Vulkan::Command::SetViewport(frame->command_buffer, 0, 1, &viewport);
-				Vulkan::Command::SetScissor(frame->command_buffer, 0, 1, &scissor_rect);
+					struct PushConsts
+					{
+						uint32_t hdr_src_index;
+						uint32_t sdr_dst_index;
+						float sharpness;
+						uint32_t src_width;
+						uint32_t src_height;
+						uint32_t bloom_index;
+						uint32_t bloom_width;
+						uint32_t bloom_height;
+						uint32_t auto_exposure_buffer_index;
+					} push_consts;
+
+					push_consts.hdr_src_index = post_process_src.descriptor.descriptor_offset;
+					push_consts.sdr_dst_index = data->render_targets.sdr.descriptor.descriptor_offset;
+					push_consts.sharpness = data->dynamic_resolution.sharpness;
+					push_consts.src_width = post_process_src_resolution.width;
+					push_consts.src_height = post_process_src_resolution.height;
+					push_consts.bloom_index = data->render_targets.bloom[0].descriptor.descriptor_offset;
+					push_consts.bloom_width = bloom_resolutions[0].width;
+					push_consts.bloom_height = bloom_resolutions[0].height;
+					push_consts.auto_exposure_buffer_index = data->auto_exposure.descriptor.descriptor_offset;
+
+					Vulkan::Command::PushConstants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConsts), &push_consts);
+
+					uint32_t dispatch_x = VK_ALIGN_POW2(data->output_resolution.width, POST_PROCESS_GROUP_SIZE) / POST_PROCESS_GROUP_SIZE;
+					uint32_t dispatch_y = VK_ALIGN_POW2(data->output_resolution.height, POST_PROCESS_GROUP_SIZE) / POST_PROCESS_GROUP_SIZE;
+					Vulkan::Command::Dispatch(command_buffer, dispatch_x, dispatch_y, 1);
+
+					RENDER_PASS_STAGE_END(RENDER_PASS_POST_PROCESS_STAGE_TONEMAP_GAMMA_EXPOSURE, command_buffer);
+				}
+				RENDER_PASS_END(data->render_passes.post_process);
+			}
+		});
 
-				struct PushConsts
-				{
-					uint32_t ib_index;
-					uint32_t vb_index;
-				} push;
+		if (data->render_graph.Compile())
+		{
+			// The alias groups changed, so the render targets need to be recreated with the new memory layout
+			// Render targets are only referenced by the graph through pointers, so recording below picks up the new ones
+			Vulkan::WaitDeviceIdle();
+			CreateRenderTargets();
+		}
 
-				push.ib_index = frame->instance_buffer.descriptor.descriptor_offset;
-				Vulkan::Command::PushConstants(frame->command_buffer, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &push.ib_index);
+		data->render_graph.Execute(frame->command_buffer, use_async_compute ? &frame->async_compute_command_buffer : nullptr);
 
-				for (uint32_t i = 0; i < data->draw_list.next_free_entry; ++i)
-				{
-					// NOTE: When we do vertex pulling instead, we can store the vertex/index buffer descriptor indices inside the instance data
-					// And then we could simply render all meshes with a single draw call
-					const DrawList::Entry& entry = data->draw_list.entries[i];
-					VK_ASSERT(entry.mesh && "Tried to render a mesh with an invalid mesh handle");
+		// The history written this frame is read by the next frame, a history that was not written this frame is stale once TAA is enabled again
+		if (use_taa)
+			data->taa.history_index = taa_history_dst_index;
+		data->taa.history_valid = use_taa;
 
-					push.vb_index = entry.mesh->vertex_buffer.descriptor.descriptor_offset;
-					Vulkan::Command::PushConstants(frame->command_buffer, VK_SHADER_STAGE_VERTEX_BIT, sizeof(uint32_t), sizeof(uint32_t), &push.vb_index);
+		if (use_async_compute)
+		{
+			Vulkan::Command::WriteTimestamp(frame->async_compute_command_buffer, frame->timestamps.query_pool, TIMESTAMP_QUERY_ASYNC_COMPUTE_BEGIN + 1, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+
+			// The previous frame might still be reading the light clusters on the graphics queue, so wait for its submission before overwriting them
+			Vulkan::CommandBuffer::AddWait(frame->async_compute_command_buffer, data->command_queues.graphics_compute.fence,
+				VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, data->command_queues.graphics_compute.fence.fence_value);
+			Vulkan::CommandBuffer::EndRecording(frame->async_compute_command_buffer);
+			frame->sync.async_compute_fence_value = Vulkan::CommandQueue::Execute(data->command_queues.compute, frame->async_compute_command_buffer);
+			frame->timestamps.async_compute_written = true;
+
+			// The graphics submission of this frame waits on the async compute work only at the stages that consume its results
+			VkPipelineStageFlags2 wait_stages = data->render_graph.GetAsyncComputeWaitStages();
+			if (wait_stages != VK_PIPELINE_STAGE_2_NONE)
+			{
+				Vulkan::CommandBuffer::AddWait(frame->command_buffer, data->command_queues.compute.fence, wait_stages, data->command_queues.compute.fence.fence_value);
+			}
+		}
+	}
 
-					Vulkan::Command::DrawGeometryIndexed(frame->command_buffer, &entry.mesh->index_buffer.buffer,
-						entry.mesh->index_buffer.index_type, entry.mesh->index_buffer.num_indices, 1, i);
+	void RenderUI()
+	{
+		if (ImGui::Begin("Renderer"))
+		{
+			ImGui::Text("Total vertex count: %u", data->stats.total_vertex_count);
+			ImGui::Text("Total triangle count: %u", data->stats.total_triangle_count);
+			ImGui::Text("Uploaded instances: %u", data->stats.num_uploaded_instances);
+			ImGui::Text("Visible instances: %u / %u", data->stats.num_visible_instances, data->draw_list.next_free_entry);
+			ImGui::Text("Max lights per cluster: %u / %u", data->light_clusters.max_cluster_lights, LIGHT_CLUSTER_MAX_LIGHTS);
+			if (data->light_clusters.num_overflowing_clusters > 0)
+			{
+				ImGui::Text("Overflowing light clusters: %u, %u lights dropped", data->light_clusters.num_overflowing_clusters, data->light_clusters.num_dropped_lights);
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::SetTooltip("Clusters only hold %u lights, the lights after that are not evaluated for the pixels in the cluster", LIGHT_CLUSTER_MAX_LIGHTS);
 				}
-
-				RENDER_PASS_STAGE_END(RENDER_PASS_GEOMETRY_STAGE_DEPTH_PREPASS, frame->command_buffer);
 			}
 
-			// Geometry and lighting stage
+			ImGui::SetNextItemOpen(false, ImGuiCond_Once);
+			if (ImGui::CollapsingHeader("GPU Profiler"))
 			{
-				RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEOMETRY_STAGE_LIGHTING, RenderPass::ATTACHMENT_SLOT_COLOR0, data->render_targets.hdr.view);
-				RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_GEOMETRY_STAGE_LIGHTING, RenderPass::ATTACHMENT_SLOT_DEPTH_STENCIL, data->render_targets.depth.view);
+				ImGui::Indent(10.0f);
+				GPUProfiler::RenderUI();
+				ImGui::Unindent(10.0f);
+			}
 
-				RENDER_PASS_STAGE_BEGIN(RENDER_PASS_GEOMETRY_STAGE_LIGHTING, frame->command_buffer, data->render_resolution.width, data->render_resolution.height);
+			ImGui::SetNextItemOpen(false, ImGuiCond_Once);
+			if (ImGui::CollapsingHeader("Descriptor heaps"))
+			{
+				ImGui::Indent(10.0f);
 
-				// Viewport and scissor
-				Vulkan::Command::SetViewport(frame->command_buffer, 0, 1, &viewport);
-				Vulkan::Command::SetScissor(frame->command_buffer, 0, 1, &scissor_rect);
+				ImGuiTableFlags table_flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable;
+				if (ImGui::BeginTable("Descriptor heaps", 4, table_flags))
+				{
+					ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_NoHide);
+					ImGui::TableSetupColumn("Used / Capacity");
+					ImGui::TableSetupColumn("Max");
+					ImGui::TableSetupColumn("Size (KiB)");
+					ImGui::TableHeadersRow();
 
-				const Texture* skybox_texture = data->texture_slotmap.Find(data->skybox_texture_handle);
-				VK_ASSERT(skybox_texture && "Skybox cubemap is invalid for currently selected skybox");
+					for (uint32_t type = 0; type < VULKAN_DESCRIPTOR_TYPE_NUM_TYPES; ++type)
+					{
+						Vulkan::Descriptor::HeapStats heap_stats = Vulkan::Descriptor::GetHeapStats((VulkanDescriptorType)type);
+						uint32_t num_used_descriptors = heap_stats.num_descriptors - heap_stats.num_free_descriptors;
 
-				const Texture* irradiance_cubemap = data->texture_slotmap.Find(skybox_texture->next);
-				VK_ASSERT(irradiance_cubemap && "Irradiance cubemap is invalid for currently selected skybox");
+						ImGui::TableNextRow();
+						ImGui::TableNextColumn();
+						ImGui::TextUnformatted(Vulkan::Descriptor::GetTypeName((VulkanDescriptorType)type));
 
-				const Texture* prefiltered_cubemap = data->texture_slotmap.Find(irradiance_cubemap->next);
-				VK_ASSERT(prefiltered_cubemap && "Prefiltered cubemap is invalid for currently selected skybox");
+						ImGui::TableNextColumn();
+						std::string utilization_label = std::format("{} / {}", num_used_descriptors, heap_stats.num_descriptors);
+						ImGui::ProgressBar((float)num_used_descriptors / (float)heap_stats.num_descriptors, ImVec2(-FLT_MIN, 0.0f), utilization_label.c_str());
 
-				const Texture* brdf_lut = data->texture_slotmap.Find(data->ibl.brdf_lut_handle);
-				VK_ASSERT(brdf_lut && "BRDF LUT is invalid");
+						ImGui::TableNextColumn();
+						ImGui::Text("%u", heap_stats.max_descriptors);
+						ImGui::TableNextColumn();
+						ImGui::Text("%.1f", (float)heap_stats.size_in_bytes / 1024.0f);
+					}
 
-				// Push constants
-				struct PushConsts
-				{
-					uint32_t ib_index;
-					uint32_t vb_index;
-
-					uint32_t irradiance_cubemap_index;
-					uint32_t irradiance_sampler_index;
-					uint32_t prefiltered_cubemap_index;
-					uint32_t prefiltered_sampler_index;
-					uint32_t num_prefiltered_mips;
-					uint32_t brdf_lut_index;
-					uint32_t brdf_lut_sampler_index;
-					uint32_t tlas_index;
-				} push_consts;
+					ImGui::EndTable();
+				}
 
-				push_consts.ib_index = frame->instance_buffer.descriptor.descriptor_offset;
-				Vulkan::Command::PushConstants(frame->command_buffer, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &push_consts.ib_index);
+				ImGui::Unindent(10.0f);
+			}
 
-				push_consts.irradiance_cubemap_index = irradiance_cubemap->view_descriptor.descriptor_offset;
-				push_consts.irradiance_sampler_index = irradiance_cubemap->sampler.descriptor.descriptor_offset;
-				push_consts.prefiltered_cubemap_index = prefiltered_cubemap->view_descriptor.descriptor_offset;
-				push_consts.prefiltered_sampler_index = prefiltered_cubemap->sampler.descriptor.descriptor_offset;
-				push_consts.num_prefiltered_mips = prefiltered_cubemap->view.num_mips - 1;
-				push_consts.brdf_lut_index = brdf_lut->view_descriptor.descriptor_offset;
-				push_consts.brdf_lut_sampler_index = brdf_lut->sampler.descriptor.descriptor_offset;
-				push_consts.tlas_index = frame->raytracing.tlas_descriptor.descriptor_offset;
+			ImGui::SetNextItemOpen(true, ImGuiCond_Once);
+			if (ImGui::CollapsingHeader("Settings"))
+			{
+				ImGui::Indent(10.0f);
 
-				Vulkan::Command::PushConstants(frame->command_buffer, VK_SHADER_STAGE_FRAGMENT_BIT, 2 * sizeof(uint32_t), 8 * sizeof(uint32_t), &push_consts.irradiance_cubemap_index);
+				// ------------------------------------------------------------------------------------------------------
+				// Frame pacing settings
 
-				for (uint32_t i = 0; i < data->draw_list.next_free_entry; ++i)
+				struct PresentModeOption
 				{
-					const DrawList::Entry& entry = data->draw_list.entries[i];
-					VK_ASSERT(entry.mesh && "Tried to render a mesh with an invalid mesh handle");
+					VkPresentModeKHR present_mode;
+					const char* label;
+				};
 
-					push_consts.vb_index = entry.mesh->vertex_buffer.descriptor.descriptor_offset;
-					Vulkan::Command::PushConstants(frame->command_buffer, VK_SHADER_STAGE_VERTEX_BIT, sizeof(uint32_t), sizeof(uint32_t), &push_consts.vb_index);
-					
-					Vulkan::Command::DrawGeometryIndexed(frame->command_buffer, &entry.mesh->index_buffer.buffer,
-						entry.mesh->index_buffer.index_type, entry.mesh->index_buffer.num_indices, 1, i);
+				static constexpr PresentModeOption PRESENT_MODE_OPTIONS[] =
+				{
+					{ VK_PRESENT_MODE_FIFO_KHR, "FIFO (VSync)" },
+					{ VK_PRESENT_MODE_FIFO_RELAXED_KHR, "FIFO relaxed" },
+					{ VK_PRESENT_MODE_MAILBOX_KHR, "Mailbox" },
+					{ VK_PRESENT_MODE_IMMEDIATE_KHR, "Immediate" }
+				};
 
-					data->stats.total_vertex_count += entry.mesh->vertex_buffer.buffer.size_in_bytes / sizeof(Vertex);
-					data->stats.total_triangle_count += entry.mesh->index_buffer.num_indices / 3;
+				VkPresentModeKHR current_present_mode = Vulkan::SwapChain::GetPresentMode();
+				const char* current_present_mode_label = "Unknown";
+				for (const PresentModeOption& option : PRESENT_MODE_OPTIONS)
+				{
+					if (option.present_mode == current_present_mode)
+						current_present_mode_label = option.label;
 				}
 
-				RENDER_PASS_STAGE_END(RENDER_PASS_GEOMETRY_STAGE_LIGHTING, frame->command_buffer);
-			}
-		}
-		RENDER_PASS_END(data->render_passes.geometry);
-
-		// ----------------------------------------------------------------------------------------------------------------
-		// Post-process Pass (1 stage)
-		// 1 - Tonemapping, gamma correction, exposure
-
-		RENDER_PASS_BEGIN(data->render_passes.post_process);
-		{
-			RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_POST_PROCESS_STAGE_TONEMAP_GAMMA_EXPOSURE, RenderPass::ATTACHMENT_SLOT_READ_ONLY0, data->render_targets.hdr.view);
-			RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_POST_PROCESS_STAGE_TONEMAP_GAMMA_EXPOSURE, RenderPass::ATTACHMENT_SLOT_READ_WRITE0, data->render_targets.sdr.view);
-
-			RENDER_PASS_STAGE_BEGIN(RENDER_PASS_POST_PROCESS_STAGE_TONEMAP_GAMMA_EXPOSURE, frame->command_buffer, data->render_resolution.width, data->render_resolution.height);
-
-			struct PushConsts
-			{
-				uint32_t hdr_src_index;
-				uint32_t sdr_dst_index;
-			} push_consts;
+				if (ImGui::BeginCombo("Present mode", current_present_mode_label))
+				{
+					for (const PresentModeOption& option : PRESENT_MODE_OPTIONS)
+					{
+						ImGui::BeginDisabled(!Vulkan::SwapChain::IsPresentModeSupported(option.present_mode));
+						if (ImGui::Selectable(option.label, option.present_mode == current_present_mode))
+						{
+							Vulkan::SwapChain::SetPresentMode(option.present_mode);
+						}
+						ImGui::EndDisabled();
+					}
 
-			push_consts.hdr_src_index = data->render_targets.hdr.descriptor.descriptor_offset;
-			push_consts.sdr_dst_index = data->render_targets.sdr.descriptor.descriptor_offset;
+					ImGui::EndCombo();
+				}
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::SetTooltip("Switching between FIFO and mailbox is seamless, the other present modes recreate the swapchain");
+				}
 
-			Vulkan::Command::PushConstants(frame->command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, 0, 2 * sizeof(uint32_t), &push_consts);
+				int32_t num_frames_in_flight = static_cast<int32_t>(data->frame_pacing.num_frames_in_flight);
+				if (ImGui::SliderInt("Frames in flight", &num_frames_in_flight, 1, static_cast<int32_t>(Vulkan::MAX_FRAMES_IN_FLIGHT)))
+				{
+					SetNumFramesInFlight(static_cast<uint32_t>(num_frames_in_flight));
+				}
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::SetTooltip("Fewer frames in flight lowers the latency, but gives the CPU and GPU less room to overlap their work");
+				}
 
-			uint32_t dispatch_x = VK_ALIGN_POW2(data->render_resolution.width, 8) / 8;
-			uint32_t dispatch_y = VK_ALIGN_POW2(data->render_resolution.height, 8) / 8;
-			Vulkan::Command::Dispatch(frame->command_buffer, dispatch_x, dispatch_y, 1);
+				ImGui::Checkbox("Frame limiter", &data->frame_pacing.frame_limiter_enabled);
+				ImGui::BeginDisabled(!data->frame_pacing.frame_limiter_enabled);
+				ImGui::DragFloat("Frame limiter FPS", &data->frame_pacing.frame_limiter_fps, 1.0f, 10.0f, 1000.0f, "%.0f");
+				ImGui::EndDisabled();
 
-			RENDER_PASS_STAGE_END(RENDER_PASS_POST_PROCESS_STAGE_TONEMAP_GAMMA_EXPOSURE, frame->command_buffer);
-		}
-		RENDER_PASS_END(data->render_passes.post_process);
-	}
+				ImGui::Text("Input to GPU finished: %s%.3f ms", data->frame_pacing.latency_is_upper_bound ? "<= " : "", data->frame_pacing.latency_ms);
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::SetTooltip(data->frame_pacing.latency_is_upper_bound ?
+						"Time from sampling input until the CPU saw the frame finish on the GPU, calibrated timestamps are not supported or were not precise enough this frame" :
+						"Time from sampling input until the GPU finished the frame, measured with calibrated timestamps");
+				}
 
-	void RenderUI()
-	{
-		if (ImGui::Begin("Renderer"))
-		{
-			ImGui::Text("Total vertex count: %u", data->stats.total_vertex_count);
-			ImGui::Text("Total triangle count: %u", data->stats.total_triangle_count);
+				ImGui::Checkbox("Frustum culling", &data->culling.enabled);
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::SetTooltip("If enabled, the bounding spheres of all submitted meshes are culled against the view frustum on the CPU, and only the visible meshes are drawn");
+				}
 
-			ImGui::SetNextItemOpen(true, ImGuiCond_Once);
-			if (ImGui::CollapsingHeader("Settings"))
-			{
-				ImGui::Indent(10.0f);
+				ImGui::Checkbox("Use visibility buffer", (bool*)&data->settings.use_visibility_buffer);
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::SetTooltip("If enabled, renders instance and triangle indices into a visibility buffer and shades each pixel once in a full screen pass, instead of forward shading with a depth pre-pass");
+				}
 
-				bool vsync = Vulkan::SwapChain::IsVSyncEnabled();
-				if (ImGui::Checkbox("VSync", &vsync))
+				ImGui::BeginDisabled(!data->async_compute.available);
+				ImGui::Checkbox("Async compute", &data->async_compute.enabled);
+				ImGui::EndDisabled();
+				if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
 				{
-					Vulkan::SwapChain::SetVSync(vsync);
+					ImGui::SetTooltip(data->async_compute.available ?
+						"If enabled, light culling, IBL generation and BLAS builds run on a dedicated compute queue, overlapping with graphics work" :
+						"The device does not expose a separate compute queue");
 				}
+				ImGui::Text("GPU graphics: %.3f ms", data->async_compute.graphics_ms);
+				ImGui::Text("GPU async compute: %.3f ms", data->async_compute.async_compute_ms);
+				ImGui::Text("GPU overlap: %.3f ms", data->async_compute.overlap_ms);
 
 				// ------------------------------------------------------------------------------------------------------
 				// Debug settings
@@ -1859,6 +3924,63 @@ namespace Renderer
 					ImGui::Unindent(10.0f);
 				}
 
+				// ------------------------------------------------------------------------------------------------------
+				// Resolution settings
+
+				ImGui::SetNextItemOpen(false, ImGuiCond_Once);
+				if (ImGui::CollapsingHeader("Resolution"))
+				{
+					ImGui::Indent(10.0f);
+
+					ImGui::Text("Render resolution: %ux%u", data->render_resolution.width, data->render_resolution.height);
+					ImGui::Text("Output resolution: %ux%u", data->output_resolution.width, data->output_resolution.height);
+
+					ImGui::Checkbox("Dynamic resolution", &data->dynamic_resolution.enabled);
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::SetTooltip("If enabled, the render scale is adjusted every frame to reach the target GPU frame time");
+					}
+
+					ImGui::BeginDisabled(!data->dynamic_resolution.enabled);
+					ImGui::DragFloat("Target GPU time", &data->dynamic_resolution.target_gpu_ms, 0.1f, 1.0f, 100.0f, "%.1f ms");
+					ImGui::SliderFloat("Min render scale", &data->dynamic_resolution.min_render_scale, 0.25f, 1.0f, "%.2f");
+					ImGui::EndDisabled();
+
+					ImGui::BeginDisabled(data->dynamic_resolution.enabled);
+					ImGui::SliderFloat("Render scale", &data->dynamic_resolution.render_scale, data->dynamic_resolution.min_render_scale, 1.0f, "%.2f");
+					ImGui::EndDisabled();
+
+					ImGui::SliderFloat("Sharpness", &data->dynamic_resolution.sharpness, 0.0f, 1.0f, "%.2f");
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::SetTooltip("Contrast adaptive sharpening applied after upscaling, based on FSR1 RCAS");
+					}
+
+					ImGui::Unindent(10.0f);
+				}
+
+				if (ImGui::CollapsingHeader("Anti-aliasing"))
+				{
+					ImGui::Indent(10.0f);
+
+					ImGui::Checkbox("Temporal anti-aliasing", &data->taa.enabled);
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::SetTooltip("Jitters the camera every frame and accumulates the frames over time, also upsamples when the render scale is below 1");
+					}
+
+					ImGui::BeginDisabled(!data->taa.enabled);
+					ImGui::SliderFloat("Blend factor", &data->taa.blend_factor, 0.01f, 1.0f, "%.2f");
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::SetTooltip("Weight of the current frame, lower values are smoother but ghost more");
+					}
+					ImGui::Text("Jitter: (%.3f, %.3f)", data->taa.jitter.x, data->taa.jitter.y);
+					ImGui::EndDisabled();
+
+					ImGui::Unindent(10.0f);
+				}
+
 				// ------------------------------------------------------------------------------------------------------
 				// Post-processing settings
 
@@ -1868,9 +3990,35 @@ namespace Renderer
 					ImGui::Indent(10.0f);
 
 					ImGui::SliderFloat("Exposure", &data->settings.postfx_exposure, 0.001f, 20.0f, "%.2f");
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::SetTooltip("If auto exposure is enabled, this is applied on top of the adapted exposure as exposure compensation");
+					}
 					ImGui::SliderFloat("Gamma", &data->settings.postfx_gamma, 0.001f, 20.0f, "%.2f");
 					ImGui::SliderFloat("Max white", &data->settings.postfx_max_white, 0.1f, 1000.0f, "%.2f");
 
+					ImGui::Checkbox("Auto exposure", (bool*)&data->settings.postfx_use_auto_exposure);
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::SetTooltip("Adapts the exposure to the average scene luminance, taken from a luminance histogram of the frame");
+					}
+					if (data->settings.postfx_use_auto_exposure)
+					{
+						ImGui::SliderFloat("Min log luminance", &data->settings.postfx_auto_exposure_min_log_luminance, -20.0f, 0.0f, "%.1f");
+						ImGui::SliderFloat("Log luminance range", &data->settings.postfx_auto_exposure_log_luminance_range, 1.0f, 40.0f, "%.1f");
+						ImGui::SliderFloat("Adaptation rate", &data->settings.postfx_auto_exposure_adaptation_rate, 0.01f, 10.0f, "%.2f");
+						if (ImGui::IsItemHovered())
+						{
+							ImGui::SetTooltip("How fast the exposure adapts to changes in scene luminance, per second");
+						}
+					}
+
+					ImGui::Checkbox("Bloom", (bool*)&data->settings.postfx_use_bloom);
+					if (data->settings.postfx_use_bloom)
+					{
+						ImGui::SliderFloat("Bloom intensity", &data->settings.postfx_bloom_intensity, 0.0f, 1.0f, "%.3f");
+					}
+
 					ImGui::Unindent(10.0f);
 				}
 
@@ -1890,39 +4038,66 @@ namespace Renderer
 
 				ImGui::Unindent(10.0f);
 			}
+
+			ImGui::SetNextItemOpen(false, ImGuiCond_Once);
+			if (ImGui::CollapsingHeader("Render graph"))
+			{
+				ImGui::Indent(10.0f);
+
+				// Passes, their resource usages and barriers, resource lifetimes and alias groups of the last compiled render graph
+				std::string render_graph_dump = data->render_graph.Dump();
+				ImGui::TextUnformatted(render_graph_dump.c_str());
+
+				if (ImGui::Button("Log render graph"))
+				{
+					LOG_INFO("Renderer::RenderUI", "Render graph:\n{}", render_graph_dump);
+				}
+
+				ImGui::Unindent(10.0f);
+			}
 		}
 		ImGui::End();
 	}
 
 	void EndFrame()
 	{
+		PROFILE_FUNCTION();
+
 		Frame* frame = GetFrameCurrent();
+		bool headless = Vulkan::IsHeadless();
 
 		// ----------------------------------------------------------------------------------------------------------------
 		// Dear ImGui Pass (1 stage)
 		// 1 - Dear ImGui
 
-		RENDER_PASS_BEGIN(data->render_passes.imgui);
+		if (!headless)
 		{
-			RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_IMGUI_STAGE_IMGUI, RenderPass::ATTACHMENT_SLOT_COLOR0, data->render_targets.sdr.view);
+			RENDER_PASS_BEGIN(data->render_passes.imgui);
+			{
+				RENDER_PASS_STAGE_SET_ATTACHMENT(RENDER_PASS_IMGUI_STAGE_IMGUI, RenderPass::ATTACHMENT_SLOT_COLOR0, data->render_targets.sdr.view);
 
-			RENDER_PASS_STAGE_BEGIN(RENDER_PASS_IMGUI_STAGE_IMGUI, frame->command_buffer, data->render_resolution.width, data->render_resolution.height);
+				RENDER_PASS_STAGE_BEGIN(RENDER_PASS_IMGUI_STAGE_IMGUI, frame->command_buffer, data->output_resolution.width, data->output_resolution.height);
 
-			ImGui::Render();
-			ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), frame->command_buffer.vk_command_buffer, nullptr);
+				ImGui::Render();
+				ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), frame->command_buffer.vk_command_buffer, nullptr);
 
-			ImGui::EndFrame();
+				ImGui::EndFrame();
 
-			RENDER_PASS_STAGE_END(RENDER_PASS_IMGUI_STAGE_IMGUI, frame->command_buffer);
+				RENDER_PASS_STAGE_END(RENDER_PASS_IMGUI_STAGE_IMGUI, frame->command_buffer);
+			}
+			RENDER_PASS_END(data->render_passes.imgui);
 		}
-		RENDER_PASS_END(data->render_passes.imgui);
 
 		// Copy the final rendered frame to the back buffer
 		Vulkan::CopyToBackBuffer(frame->command_buffer, data->render_targets.sdr.image);
 
 		// End recording commands, execute command buffer
+		GPUProfiler::EndFrame();
+		Vulkan::Command::WriteTimestamp(frame->command_buffer, frame->timestamps.query_pool, TIMESTAMP_QUERY_GRAPHICS_BEGIN + 1, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
 		Vulkan::CommandBuffer::EndRecording(frame->command_buffer);
-		frame->sync.frame_in_flight_fence_value = Vulkan::CommandQueue::Execute(data->command_queues.graphics_compute, frame->command_buffer, 1, &frame->sync.render_finished_fence);
+		// Nothing waits on the render finished fence when running headless, since there is no present
+		frame->sync.frame_in_flight_fence_value = Vulkan::CommandQueue::Execute(data->command_queues.graphics_compute, frame->command_buffer,
+			headless ? 0 : 1, headless ? nullptr : &frame->sync.render_finished_fence);
 
 		// Vulkan backend end frame, does the swapchain present
 		bool resized = Vulkan::EndFrame(frame->sync.render_finished_fence);
@@ -1930,6 +4105,7 @@ namespace Renderer
 		// Reset per-frame statistics, draw list, and other data
 		data->stats.Reset();
 		data->draw_list.Reset();
+		data->instance_buffer.ReleaseUnsubmittedSlots();
 		data->num_area_lights = 0;
 
 		if (resized)
@@ -1941,6 +4117,69 @@ namespace Renderer
 		}
 	}
 
+	uint32_t GetNumFramesInFlight()
+	{
+		return Vulkan::GetNumFramesInFlight();
+	}
+
+	void SetNumFramesInFlight(uint32_t num_frames_in_flight)
+	{
+		data->frame_pacing.num_frames_in_flight = std::clamp(num_frames_in_flight, 1u, Vulkan::MAX_FRAMES_IN_FLIGHT);
+	}
+
+	double GetFrameLatencyMs()
+	{
+		return data->frame_pacing.latency_ms;
+	}
+
+	GPUFrameTimings GetGPUFrameTimings()
+	{
+		return { data->async_compute.graphics_ms, data->async_compute.async_compute_ms };
+	}
+
+	uint64_t ReadbackOutputChecksum()
+	{
+		PROFILE_FUNCTION();
+
+		Vulkan::WaitDeviceIdle();
+
+		const VulkanImage& sdr_image = data->render_targets.sdr.image;
+		uint64_t num_bytes = (uint64_t)sdr_image.width * sdr_image.height * 4;
+
+		BufferCreateInfo buffer_info = {};
+		buffer_info.size_in_bytes = num_bytes;
+		buffer_info.usage_flags = BUFFER_USAGE_STAGING | BUFFER_USAGE_COPY_DST;
+		buffer_info.memory_flags = GPU_MEMORY_HOST_VISIBLE | GPU_MEMORY_HOST_COHERENT | GPU_MEMORY_HOST_CACHED;
+		buffer_info.name = "Output Readback Staging Buffer";
+
+		VulkanBuffer staging_buffer = Vulkan::Buffer::Create(buffer_info);
+
+		VulkanCommandBuffer command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(data->command_pools.graphics_compute);
+		Vulkan::CommandBuffer::BeginRecording(command_buffer);
+
+		Vulkan::Command::TransitionLayout(command_buffer, { .image = sdr_image, .new_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL });
+		Vulkan::Command::CopyToBuffer(command_buffer, sdr_image, sdr_image.width, sdr_image.height, staging_buffer, 0);
+		Vulkan::Command::BufferMemoryBarrier(command_buffer, {
+			.buffer = staging_buffer,
+			.src_access_flags = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			.src_stage_flags = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+			.dst_access_flags = VK_ACCESS_2_HOST_READ_BIT,
+			.dst_stage_flags = VK_PIPELINE_STAGE_2_HOST_BIT
+		});
+
+		Vulkan::CommandBuffer::EndRecording(command_buffer);
+		Vulkan::CommandQueue::ExecuteBlocking(data->command_queues.graphics_compute, command_buffer);
+		Vulkan::CommandBuffer::Reset(command_buffer);
+		Vulkan::CommandPool::FreeCommandBuffer(data->command_pools.graphics_compute, command_buffer);
+
+		void* staging_ptr = Vulkan::DeviceMemory::Map(staging_buffer.memory, num_bytes, 0);
+		uint64_t checksum = HashBytes(staging_ptr, num_bytes);
+		Vulkan::DeviceMemory::Unmap(staging_buffer.memory);
+
+		Vulkan::Buffer::Destroy(staging_buffer);
+		return checksum;
+	}
+
 	RenderResourceHandle CreateTexture(const CreateTextureArgs& args)
 	{
 		VulkanCommandBuffer command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(data->command_pools.graphics_compute);
@@ -1960,6 +4199,8 @@ namespace Renderer
 			.height = args.height,
 			.num_mips = num_mips,
 			.num_layers = 1,
+			// Environment maps are the input of the IBL generation on the async compute queue
+			.async_compute_shared = args.is_environment_map,
 			.name = args.name,
 		};
 
@@ -2006,8 +4247,9 @@ namespace Renderer
 		{
 			RenderResourceHandle original_texture_handle = texture_handle;
 
-			// Generate IBL cubemaps from the original equirectangular cubemap
-			texture_handle = GenerateIBLCubemaps(original_texture_handle);
+			// Generate IBL cubemaps from the original equirectangular cubemap, or load them from the cache if they were generated before
+			uint64_t src_hash = HashBytes(args.pixel_bytes.data(), args.pixel_bytes.size());
+			texture_handle = GenerateIBLCubemaps(original_texture_handle, src_hash);
 
 			// Destroy the original equirectangular hdr environment texture
 			data->texture_slotmap.Delete(original_texture_handle);
@@ -2051,6 +4293,8 @@ namespace Renderer
 		// Determine vertex and index buffer byte size
 		VkDeviceSize vb_size = args.vertices_bytes.size();
 		VkDeviceSize ib_size = args.indices_bytes.size();
+		// The index buffer is also read as 32-bit words through a storage buffer by the visibility buffer, so it needs to be padded to 4 bytes
+		VkDeviceSize ib_size_aligned = VK_ALIGN_POW2(ib_size, 4);
 
 		// Allocate from ring buffer and write data to it
 		RingBuffer::Allocation staging = data->ring_buffer.Allocate(vb_size + ib_size);
@@ -2064,12 +4308,16 @@ namespace Renderer
 		Vulkan::Descriptor::Write(vertex_buffer.descriptor, vertex_buffer.buffer);
 
 		IndexBuffer index_buffer = {};
-		index_buffer.buffer = Vulkan::Buffer::CreateIndex(ib_size, "Index Buffer " + args.name);
+		index_buffer.buffer = Vulkan::Buffer::CreateIndex(ib_size_aligned, "Index Buffer " + args.name);
+		index_buffer.descriptor = Vulkan::Descriptor::Allocate(VULKAN_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		Vulkan::Descriptor::Write(index_buffer.descriptor, index_buffer.buffer);
 		index_buffer.index_type = Vulkan::Util::ToVkIndexType(args.index_stride);
+		index_buffer.index_stride = args.index_stride;
 		index_buffer.num_indices = args.num_indices;
 
 		// Copy staging buffer data into vertex and index buffers
-		VulkanCommandBuffer command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(data->command_pools.graphics_compute);
+		VulkanCommandPool& command_pool = GetComputeCommandPool();
+		VulkanCommandBuffer command_buffer = Vulkan::CommandPool::AllocateCommandBuffer(command_pool);
 		Vulkan::CommandBuffer::BeginRecording(command_buffer);
 
 		Vulkan::Command::CopyBuffers(command_buffer, staging.buffer, 0, vertex_buffer.buffer, 0, vb_size);
@@ -2088,24 +4336,36 @@ namespace Renderer
 		VulkanBuffer blas_buffer = Vulkan::Raytracing::BuildBLAS(command_buffer, vertex_buffer.buffer, index_buffer.buffer, blas_scratch_buffer,
 			args.num_vertices, sizeof(Vertex), args.num_indices / 3, Vulkan::Util::ToVkIndexType(args.index_stride), "BLAS " + args.name);
 
+		// On the async compute queue the graphics stages are removed from these barriers, the blocking submission covers them instead
 		std::vector<VulkanBufferBarrier> acceleration_structure_build_to_vertex_index_barriers =
 		{
 			{ vertex_buffer.buffer, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-			  VK_ACCESS_2_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT },
+			  VK_ACCESS_2_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT },
 			{ index_buffer.buffer, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-			  VK_ACCESS_2_INDEX_READ_BIT, VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT }
+			  VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT }
 		};
-		Vulkan::Command::BufferMemoryBarriers(command_buffer, copy_to_acceleration_structure_build_barriers);
+		Vulkan::Command::BufferMemoryBarriers(command_buffer, acceleration_structure_build_to_vertex_index_barriers);
 
 		Vulkan::CommandBuffer::EndRecording(command_buffer);
-		Vulkan::CommandQueue::ExecuteBlocking(data->command_queues.graphics_compute, command_buffer);
+		Vulkan::CommandQueue::ExecuteBlocking(GetComputeQueue(), command_buffer);
 		Vulkan::CommandBuffer::Reset(command_buffer);
-		Vulkan::CommandPool::FreeCommandBuffer(data->command_pools.graphics_compute, command_buffer);
+		Vulkan::CommandPool::FreeCommandBuffer(command_pool, command_buffer);
 
 		Vulkan::Buffer::Destroy(blas_scratch_buffer);
 
+		// The bounds are kept on the CPU for culling and spatial queries, the position is the first member of every vertex
+		AABB bounds = {};
+		for (uint32_t i = 0; i < args.num_vertices; ++i)
+		{
+			glm::vec3 pos;
+			memcpy(&pos, args.vertices_bytes.data() + i * args.vertex_stride, sizeof(pos));
+
+			bounds.min = glm::min(bounds.min, pos);
+			bounds.max = glm::max(bounds.max, pos);
+		}
+
 		return data->mesh_slotmap.Emplace(
-			vertex_buffer, index_buffer, blas_buffer
+			vertex_buffer, index_buffer, blas_buffer, bounds
 		);
 	}
 
@@ -2114,64 +4374,218 @@ namespace Renderer
 		data->mesh_slotmap.Delete(handle);
 	}
 
-	void SubmitMesh(RenderResourceHandle mesh_handle, const MaterialAsset& material, const glm::mat4& transform)
+	AABB GetMeshBounds(RenderResourceHandle handle)
 	{
-		DrawList::Entry& entry = data->draw_list.GetNextEntry();
-		// Get the mesh from the slotmap. If it does not exist/is invalid, use the unit cube mesh as a default placeholder
-		entry.mesh = data->mesh_slotmap.Find(mesh_handle);
-		if (!entry.mesh)
-			entry.mesh = data->mesh_slotmap.Find(data->unit_cube_mesh_handle);
+		Mesh* mesh = data->mesh_slotmap.Find(handle);
+		if (!mesh)
+			mesh = data->mesh_slotmap.Find(data->unit_cube_mesh_handle);
 
-		memcpy(&entry.instance_data.transform, &transform[0][0], sizeof(glm::mat4));
-		entry.instance_data.material_index = entry.index;
+		return mesh->bounds;
+	}
 
-		// Write mesh transform to the instance buffer for the currently active frame
-		Frame* frame = GetFrameCurrent();
-		frame->instance_buffer.alloc.WriteBuffer(sizeof(InstanceData) * entry.index, sizeof(InstanceData), &entry.instance_data);
-		entry.gpu_material = data->default_gpu_material;
+	static void ResolveGPUMaterial(Material& material)
+	{
+		// Textures that do not exist fall back to the textures of the default material
+		material.gpu_material = data->default_gpu_material;
 
-		// Write material data to the material UBO
-		Texture* albedo_texture = data->texture_slotmap.Find(material.tex_albedo_render_handle);
+		const Texture* albedo_texture = data->texture_slotmap.Find(material.albedo_texture_handle);
 		if (albedo_texture)
-			entry.gpu_material.albedo_texture_index = albedo_texture->view_descriptor.descriptor_offset;
+			material.gpu_material.albedo_texture_index = albedo_texture->view_descriptor.descriptor_offset;
 
-		Texture* normal_texture = data->texture_slotmap.Find(material.tex_normal_render_handle);
+		const Texture* normal_texture = data->texture_slotmap.Find(material.normal_texture_handle);
 		if (normal_texture)
-			entry.gpu_material.normal_texture_index = normal_texture->view_descriptor.descriptor_offset;
+			material.gpu_material.normal_texture_index = normal_texture->view_descriptor.descriptor_offset;
 
-		Texture* metallic_roughness_texture = data->texture_slotmap.Find(material.tex_metal_rough_render_handle);
+		const Texture* metallic_roughness_texture = data->texture_slotmap.Find(material.metallic_roughness_texture_handle);
 		if (metallic_roughness_texture)
-			entry.gpu_material.metallic_roughness_texture_index = metallic_roughness_texture->view_descriptor.descriptor_offset;
+			material.gpu_material.metallic_roughness_texture_index = metallic_roughness_texture->view_descriptor.descriptor_offset;
 
-		entry.gpu_material.albedo_factor = material.albedo_factor;
-		entry.gpu_material.metallic_factor = material.metallic_factor;
-		entry.gpu_material.roughness_factor = material.roughness_factor;
+		material.gpu_material.albedo_factor = material.albedo_factor;
+		material.gpu_material.metallic_factor = material.metallic_factor;
+		material.gpu_material.roughness_factor = material.roughness_factor;
 
-		entry.gpu_material.has_clearcoat = material.has_clearcoat ? 1 : 0;
+		material.gpu_material.has_clearcoat = material.has_clearcoat ? 1 : 0;
 
-		Texture* clearcoat_alpha_texture = data->texture_slotmap.Find(material.tex_cc_alpha_render_handle);
+		const Texture* clearcoat_alpha_texture = data->texture_slotmap.Find(material.clearcoat_alpha_texture_handle);
 		if (clearcoat_alpha_texture)
-			entry.gpu_material.clearcoat_alpha_texture_index = clearcoat_alpha_texture->view_descriptor.descriptor_offset;
+			material.gpu_material.clearcoat_alpha_texture_index = clearcoat_alpha_texture->view_descriptor.descriptor_offset;
 
-		Texture* clearcoat_normal_texture = data->texture_slotmap.Find(material.tex_cc_normal_render_handle);
+		const Texture* clearcoat_normal_texture = data->texture_slotmap.Find(material.clearcoat_normal_texture_handle);
 		if (clearcoat_normal_texture)
-			entry.gpu_material.clearcoat_normal_texture_index = clearcoat_normal_texture->view_descriptor.descriptor_offset;
+			material.gpu_material.clearcoat_normal_texture_index = clearcoat_normal_texture->view_descriptor.descriptor_offset;
 
-		Texture* clearcoat_roughness_texture = data->texture_slotmap.Find(material.tex_cc_rough_render_handle);
+		const Texture* clearcoat_roughness_texture = data->texture_slotmap.Find(material.clearcoat_roughness_texture_handle);
 		if (clearcoat_roughness_texture)
-			entry.gpu_material.clearcoat_roughness_texture_index = clearcoat_roughness_texture->view_descriptor.descriptor_offset;
+			material.gpu_material.clearcoat_roughness_texture_index = clearcoat_roughness_texture->view_descriptor.descriptor_offset;
 
-		entry.gpu_material.clearcoat_alpha_factor = material.clearcoat_alpha_factor;
-		entry.gpu_material.clearcoat_roughness_factor = material.clearcoat_roughness_factor;
+		material.gpu_material.clearcoat_alpha_factor = material.clearcoat_alpha_factor;
+		material.gpu_material.clearcoat_roughness_factor = material.clearcoat_roughness_factor;
 
 		// Default sampler
-		entry.gpu_material.sampler_index = data->default_sampler.descriptor.descriptor_offset;
+		material.gpu_material.sampler_index = data->default_sampler.descriptor.descriptor_offset;
+	}
 
-		// Write material data to the material ubo for the currently active frame
-		frame->ubos.material_ubo.WriteBuffer(sizeof(GPUMaterial) * entry.index, sizeof(GPUMaterial), &entry.gpu_material);
+	RenderResourceHandle CreateMaterial(const MaterialAsset& material_asset)
+	{
+		Material material = {};
+		material.albedo_texture_handle = material_asset.tex_albedo_render_handle;
+		material.normal_texture_handle = material_asset.tex_normal_render_handle;
+		material.metallic_roughness_texture_handle = material_asset.tex_metal_rough_render_handle;
+
+		material.albedo_factor = material_asset.albedo_factor;
+		material.metallic_factor = material_asset.metallic_factor;
+		material.roughness_factor = material_asset.roughness_factor;
+
+		material.has_clearcoat = material_asset.has_clearcoat;
+		material.clearcoat_alpha_texture_handle = material_asset.tex_cc_alpha_render_handle;
+		material.clearcoat_normal_texture_handle = material_asset.tex_cc_normal_render_handle;
+		material.clearcoat_roughness_texture_handle = material_asset.tex_cc_rough_render_handle;
+
+		material.clearcoat_alpha_factor = material_asset.clearcoat_alpha_factor;
+		material.clearcoat_roughness_factor = material_asset.clearcoat_roughness_factor;
+
+		ResolveGPUMaterial(material);
+		return data->material_slotmap.Insert(std::move(material));
+	}
+
+	void DestroyMaterial(RenderResourceHandle handle)
+	{
+		data->material_slotmap.Delete(handle);
+	}
+
+	bool GetMaterialParameters(RenderResourceHandle handle, MaterialAsset& material_asset)
+	{
+		const Material* material = data->material_slotmap.Find(handle);
+		if (!material)
+			return false;
+
+		material_asset.tex_albedo_render_handle = material->albedo_texture_handle;
+		material_asset.tex_normal_render_handle = material->normal_texture_handle;
+		material_asset.tex_metal_rough_render_handle = material->metallic_roughness_texture_handle;
+
+		material_asset.albedo_factor = material->albedo_factor;
+		material_asset.metallic_factor = material->metallic_factor;
+		material_asset.roughness_factor = material->roughness_factor;
+
+		material_asset.has_clearcoat = material->has_clearcoat;
+		material_asset.tex_cc_alpha_render_handle = material->clearcoat_alpha_texture_handle;
+		material_asset.tex_cc_normal_render_handle = material->clearcoat_normal_texture_handle;
+		material_asset.tex_cc_rough_render_handle = material->clearcoat_roughness_texture_handle;
+
+		material_asset.clearcoat_alpha_factor = material->clearcoat_alpha_factor;
+		material_asset.clearcoat_roughness_factor = material->clearcoat_roughness_factor;
+
+		return true;
+	}
+
+	void ImGuiMaterialEditor(RenderResourceHandle material_handle)
+	{
+		Material* material = data->material_slotmap.Find(material_handle);
+		if (!material)
+			return;
+
+		float texture_preview_width = std::min(ImGui::GetWindowSize().x, 256.0f);
+		float texture_preview_height = std::min(ImGui::GetWindowSize().y, 256.0f);
+		bool material_changed = false;
+
+		if (VK_RESOURCE_HANDLE_VALID(material->albedo_texture_handle))
+			ImGuiImage(material->albedo_texture_handle, texture_preview_width, texture_preview_height);
+		material_changed |= ImGui::ColorEdit3("Albedo factor", &material->albedo_factor.x, ImGuiColorEditFlags_DisplayRGB);
+
+		if (VK_RESOURCE_HANDLE_VALID(material->normal_texture_handle))
+			ImGuiImage(material->normal_texture_handle, texture_preview_width, texture_preview_height);
+
+		if (VK_RESOURCE_HANDLE_VALID(material->metallic_roughness_texture_handle))
+			ImGuiImage(material->metallic_roughness_texture_handle, texture_preview_width, texture_preview_height);
+		material_changed |= ImGui::SliderFloat("Metallic factor", &material->metallic_factor, 0.0f, 1.0f);
+		material_changed |= ImGui::SliderFloat("Roughness factor", &material->roughness_factor, 0.0f, 1.0f);
+
+		material_changed |= ImGui::Checkbox("Clearcoat", &material->has_clearcoat);
+		if (VK_RESOURCE_HANDLE_VALID(material->clearcoat_alpha_texture_handle))
+			ImGuiImage(material->clearcoat_alpha_texture_handle, texture_preview_width, texture_preview_height);
+		material_changed |= ImGui::SliderFloat("Clearcoat alpha factor", &material->clearcoat_alpha_factor, 0.0f, 1.0f);
+		if (VK_RESOURCE_HANDLE_VALID(material->clearcoat_normal_texture_handle))
+			ImGuiImage(material->clearcoat_normal_texture_handle, texture_preview_width, texture_preview_height);
+		if (VK_RESOURCE_HANDLE_VALID(material->clearcoat_roughness_texture_handle))
+			ImGuiImage(material->clearcoat_roughness_texture_handle, texture_preview_width, texture_preview_height);
+		material_changed |= ImGui::SliderFloat("Clearcoat roughness factor", &material->clearcoat_roughness_factor, 0.0f, 1.0f);
+
+		if (material_changed)
+			ResolveGPUMaterial(*material);
+	}
+
+	// The previous transform is taken from the resident instance, so it is the transform the same instance handle was submitted with in the previous frame
+	// An instance that stops moving is uploaded once more, after which its previous transform matches its current transform
+	static void WriteInstanceData(DrawList::Entry& entry, ResourceHandle_t instance_handle)
+	{
+		InstanceBuffer& instance_buffer = data->instance_buffer;
+		bool is_resident = false;
+		entry.instance_index = instance_buffer.AcquireSlot(instance_handle, is_resident);
+		entry.instance_data.material_index = entry.instance_index;
+
+		InstanceData& resident_instance = instance_buffer.resident_instances[entry.instance_index];
+		InstanceData instance_data = entry.instance_data;
+		memcpy(&instance_data.prev_transform, is_resident ? &resident_instance.transform : &instance_data.transform, sizeof(instance_data.prev_transform));
+
+		if (is_resident && memcmp(&resident_instance, &instance_data, sizeof(InstanceData)) == 0)
+			return;
+
+		resident_instance = instance_data;
+		instance_buffer.dirty_instances.push_back(entry.instance_index);
+	}
+
+	// The bounding sphere encloses the local bounds of the mesh, scaled by the largest axis scale of the transform
+	static void WriteBoundingSphere(const DrawList::Entry& entry, const glm::mat4& transform)
+	{
+		glm::vec3 center = glm::vec3(transform * glm::vec4(entry.mesh->bounds.GetCenter(), 1.0f));
+		float max_scale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+
+		data->draw_list.bounds_x[entry.index] = center.x;
+		data->draw_list.bounds_y[entry.index] = center.y;
+		data->draw_list.bounds_z[entry.index] = center.z;
+		data->draw_list.bounds_radius[entry.index] = glm::length(entry.mesh->bounds.GetExtent()) * max_scale;
+	}
+
+	void SubmitMesh(ResourceHandle_t instance_handle, RenderResourceHandle mesh_handle, RenderResourceHandle material_handle, const glm::mat4& transform)
+	{
+		SubmitMeshes({ &instance_handle, 1 }, { &mesh_handle, 1 }, { &material_handle, 1 }, { &transform, 1 });
+	}
+
+	void SubmitMeshes(std::span<const ResourceHandle_t> instance_handles, std::span<const RenderResourceHandle> mesh_handles,
+		std::span<const RenderResourceHandle> material_handles, std::span<const glm::mat4> transforms)
+	{
+		PROFILE_FUNCTION();
+
+		VK_ASSERT(instance_handles.size() == mesh_handles.size() && mesh_handles.size() == material_handles.size() && mesh_handles.size() == transforms.size() &&
+			"Tried to submit meshes with a different amount of instance handles, mesh handles, material handles and transforms");
+
+		// If a mesh does not exist/is invalid, use the unit cube mesh as a default placeholder
+		Mesh* default_mesh = data->mesh_slotmap.Find(data->unit_cube_mesh_handle);
+		Frame* frame = GetFrameCurrent();
+
+		for (size_t i = 0; i < mesh_handles.size(); ++i)
+		{
+			DrawList::Entry& entry = data->draw_list.GetNextEntry();
+			entry.mesh = data->mesh_slotmap.Find(mesh_handles[i]);
+			if (!entry.mesh)
+				entry.mesh = default_mesh;
+
+			memcpy(&entry.instance_data.transform, &transforms[i][0][0], sizeof(glm::mat4));
+			entry.instance_data.vertex_buffer_index = entry.mesh->vertex_buffer.descriptor.descriptor_offset;
+			entry.instance_data.index_buffer_index = entry.mesh->index_buffer.descriptor.descriptor_offset;
+			entry.instance_data.index_stride = entry.mesh->index_buffer.index_stride;
+
+			const Material* material = data->material_slotmap.Find(material_handles[i]);
+			entry.gpu_material = material ? material->gpu_material : data->default_gpu_material;
+
+			// Only instances that changed are uploaded, the material data is written for the currently active frame
+			WriteInstanceData(entry, instance_handles[i]);
+			WriteBoundingSphere(entry, transforms[i]);
+			frame->ubos.material_ubo.WriteBuffer(sizeof(GPUMaterial) * entry.instance_index, sizeof(GPUMaterial), &entry.gpu_material);
+		}
 	}
 
-	void SubmitAreaLight(RenderResourceHandle texture_handle, const glm::mat4& transform, const glm::vec3& color, float intensity, bool two_sided)
+	void SubmitAreaLight(ResourceHandle_t instance_handle, RenderResourceHandle texture_handle, const glm::mat4& transform, const glm::vec3& color, float intensity, bool two_sided)
 	{
 		VK_ASSERT(data->num_area_lights < MAX_AREA_LIGHTS && "Exceeded the maximum amount of area lights");
 
@@ -2180,10 +4594,14 @@ namespace Renderer
 		entry.mesh = data->mesh_slotmap.Find(data->unit_quad_mesh_handle);
 
 		memcpy(&entry.instance_data.transform, &transform[0][0], sizeof(glm::mat4));
-		entry.instance_data.material_index = entry.index;
+		entry.instance_data.vertex_buffer_index = entry.mesh->vertex_buffer.descriptor.descriptor_offset;
+		entry.instance_data.index_buffer_index = entry.mesh->index_buffer.descriptor.descriptor_offset;
+		entry.instance_data.index_stride = entry.mesh->index_buffer.index_stride;
+
+		WriteInstanceData(entry, instance_handle);
+		WriteBoundingSphere(entry, transform);
 
 		Frame* frame = GetFrameCurrent();
-		frame->instance_buffer.alloc.WriteBuffer(sizeof(InstanceData) * entry.index, sizeof(InstanceData), &entry.instance_data);
 
 		entry.gpu_material = data->default_gpu_material;
 		entry.gpu_material.albedo_factor = glm::vec4(color * intensity, 1.0f);
@@ -2193,9 +4611,9 @@ namespace Renderer
 			entry.gpu_material.albedo_texture_index = albedo_texture->view_descriptor.descriptor_offset;
 
 		// Write material data to the material ubo for the currently active frame
-		frame->ubos.material_ubo.WriteBuffer(sizeof(GPUMaterial) * entry.index, sizeof(GPUMaterial), &entry.gpu_material);
+		frame->ubos.material_ubo.WriteBuffer(sizeof(GPUMaterial) * entry.instance_index, sizeof(GPUMaterial), &entry.gpu_material);
 
-		// Add GPU data representation for the area light to the light UBO
+		// Add GPU data representation for the area light to the area light buffer
 		glm::vec3 quad_points[4] =
 		{
 			glm::vec3(UNIT_QUAD_VERTICES[0].pos[0], UNIT_QUAD_VERTICES[0].pos[1], UNIT_QUAD_VERTICES[0].pos[2]),
@@ -2218,7 +4636,21 @@ namespace Renderer
 		if (albedo_texture)
 			gpu_area_light.texture_index = albedo_texture->view_descriptor.descriptor_offset;
 
-		frame->ubos.light_ubo.WriteBuffer(4 * sizeof(uint32_t) + data->num_area_lights * sizeof(GPUAreaLight), sizeof(GPUAreaLight), &gpu_area_light);
+		// Bounding sphere used for light culling, the range is the distance at which the light falls below the influence threshold
+		// Irradiance from the quad falls off roughly like a point light with the power of the whole quad: E = (I * A) / d^2
+		glm::vec3 edge0 = gpu_area_light.vert1 - gpu_area_light.vert0;
+		glm::vec3 edge1 = gpu_area_light.vert3 - gpu_area_light.vert0;
+		float quad_area = glm::length(glm::cross(edge0, edge1));
+		float max_radiance = intensity * glm::max(color.r, glm::max(color.g, color.b));
+		float light_range = glm::sqrt(max_radiance * quad_area / LIGHT_INFLUENCE_THRESHOLD);
+
+		gpu_area_light.bounds_center = (gpu_area_light.vert0 + gpu_area_light.vert1 + gpu_area_light.vert2 + gpu_area_light.vert3) * 0.25f;
+		gpu_area_light.bounds_radius = glm::max(
+			glm::max(glm::distance(gpu_area_light.bounds_center, gpu_area_light.vert0), glm::distance(gpu_area_light.bounds_center, gpu_area_light.vert1)),
+			glm::max(glm::distance(gpu_area_light.bounds_center, gpu_area_light.vert2), glm::distance(gpu_area_light.bounds_center, gpu_area_light.vert3))
+		) + light_range;
+
+		frame->lights.area_light_buffer.WriteBuffer(data->num_area_lights * sizeof(GPUAreaLight), sizeof(GPUAreaLight), &gpu_area_light);
 		data->num_area_lights++;
 	}
 
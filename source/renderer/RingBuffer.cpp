@@ -14,9 +14,11 @@ RingBuffer::RingBuffer(uint64_t byte_size)
 	// Create vulkan buffer
 	BufferCreateInfo buffer_info = {};
 	buffer_info.size_in_bytes = byte_size;
-	// Ring buffer is used for transferring data (STAGING), uniform buffers (UNIFORM), and instance buffers (READ_ONLY)
+	// Ring buffer is used for transferring data (STAGING), uniform buffers (UNIFORM), and per-frame storage buffers like the area lights (READ_ONLY)
 	buffer_info.usage_flags = BUFFER_USAGE_STAGING | BUFFER_USAGE_UNIFORM | BUFFER_USAGE_READ_ONLY;
 	buffer_info.memory_flags = GPU_MEMORY_HOST_VISIBLE | GPU_MEMORY_HOST_COHERENT;
+	// The async compute queue reads the per-frame constants and area lights for light culling, and the staging data for mesh uploads
+	buffer_info.async_compute_shared = true;
 	buffer_info.name = "Ring Buffer";
 
 	m_buffer = Vulkan::Buffer::Create(buffer_info);
@@ -66,6 +68,7 @@ RingBuffer::Allocation RingBuffer::Allocate(uint64_t num_bytes, uint16_t align)
 	alloc.buffer.vk_buffer = m_buffer.vk_buffer;
 	alloc.buffer.memory = m_buffer.memory;
 	alloc.buffer.vk_usage_flags = m_buffer.vk_usage_flags;
+	alloc.buffer.tracking_index = m_buffer.tracking_index;
 	alloc.buffer.offset_in_bytes = static_cast<uint64_t>(alloc_ptr_begin - m_ptr_begin);
 	alloc.buffer.size_in_bytes = num_bytes;
 	alloc.ptr_begin = alloc_ptr_begin;
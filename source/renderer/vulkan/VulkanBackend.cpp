@@ -8,7 +8,9 @@
 #include "renderer/vulkan/VulkanCommands.h"
 #include "renderer/vulkan/VulkanDescriptor.h"
 #include "renderer/vulkan/VulkanUtils.h"
+#include "renderer/vulkan/VulkanQuery.h"
 #include "renderer/vulkan/VulkanResourceTracker.h"
+#include "FileIO.h"
 
 #include "shaderc/shaderc.hpp"
 
@@ -70,10 +72,15 @@ namespace Vulkan
 
 	static std::vector<const char*> GetRequiredExtensions()
 	{
-		uint32_t glfw_extension_count = 0;
-		const char** glfw_extensions;
-		glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
-		std::vector<const char*> extensions(glfw_extensions, glfw_extensions + glfw_extension_count);
+		std::vector<const char*> extensions;
+
+		if (!vk_inst.headless)
+		{
+			uint32_t glfw_extension_count = 0;
+			const char** glfw_extensions;
+			glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+			extensions.assign(glfw_extensions, glfw_extensions + glfw_extension_count);
+		}
 
 #ifdef ENABLE_VK_DEBUG_LAYER
 		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -165,6 +172,66 @@ namespace Vulkan
 #endif
 	}
 
+	// Higher is better, any device type is accepted so that software rasterizers can be used when running headless
+	static uint32_t GetPhysicalDeviceTypeRank(VkPhysicalDeviceType device_type)
+	{
+		switch (device_type)
+		{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+			return 4;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+			return 3;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+			return 2;
+		case VK_PHYSICAL_DEVICE_TYPE_CPU:
+			return 1;
+		default:
+			return 0;
+		}
+	}
+
+	// Calibrated timestamps are optional, they are only enabled if the device can sample its own timestamp domain together with the host domain of steady_clock
+	static void CheckCalibratedTimestampSupport()
+	{
+		uint32_t extension_count = 0;
+		vkEnumerateDeviceExtensionProperties(vk_inst.physical_device, nullptr, &extension_count, nullptr);
+
+		std::vector<VkExtensionProperties> available_extensions(extension_count);
+		vkEnumerateDeviceExtensionProperties(vk_inst.physical_device, nullptr, &extension_count, available_extensions.data());
+
+		bool extension_available = std::any_of(available_extensions.begin(), available_extensions.end(), [](const VkExtensionProperties& extension)
+		{
+			return strcmp(extension.extensionName, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0;
+		});
+
+		auto get_time_domains = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)vkGetInstanceProcAddr(vk_inst.instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT");
+		if (!extension_available || !get_time_domains)
+		{
+			LOG_INFO("Vulkan", "Calibrated timestamps are not supported");
+			return;
+		}
+
+		uint32_t time_domain_count = 0;
+		VkCheckResult(get_time_domains(vk_inst.physical_device, &time_domain_count, nullptr));
+
+		std::vector<VkTimeDomainEXT> time_domains(time_domain_count);
+		VkCheckResult(get_time_domains(vk_inst.physical_device, &time_domain_count, time_domains.data()));
+
+		if (std::find(time_domains.begin(), time_domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) == time_domains.end())
+		{
+			LOG_INFO("Vulkan", "Calibrated timestamps do not support the device time domain");
+			return;
+		}
+		if (std::find(time_domains.begin(), time_domains.end(), Vulkan::Query::HOST_TIME_DOMAIN) == time_domains.end())
+		{
+			LOG_INFO("Vulkan", "Calibrated timestamps do not support the host time domain");
+			return;
+		}
+
+		vk_inst.extensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+		vk_inst.device_props.calibrated_timestamps = true;
+	}
+
 	static void CreatePhysicalDevice()
 	{
 		uint32_t device_count = 0;
@@ -177,6 +244,13 @@ namespace Vulkan
 		std::vector<VkPhysicalDevice> devices(device_count);
 		vkEnumeratePhysicalDevices(vk_inst.instance, &device_count, devices.data());
 
+		// There is nothing to present to when running headless
+		if (vk_inst.headless)
+		{
+			std::erase_if(vk_inst.extensions, [](const char* extension) { return strcmp(extension, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0; });
+		}
+
+		uint32_t best_device_rank = 0;
 		for (const auto& device : devices)
 		{
 			uint32_t extension_count = 0;
@@ -193,7 +267,9 @@ namespace Vulkan
 			}
 
 			// Request Physical Device Properties
+			VkPhysicalDeviceAccelerationStructurePropertiesKHR acceleration_structure_properties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR };
 			VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptor_buffer_properties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT };
+			descriptor_buffer_properties.pNext = &acceleration_structure_properties;
 			VkPhysicalDeviceExternalMemoryHostPropertiesEXT external_memory_host_properties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT };
 			external_memory_host_properties.pNext = &descriptor_buffer_properties;
 
@@ -223,12 +299,22 @@ namespace Vulkan
 			
 			vkGetPhysicalDeviceFeatures2(device, &device_features2);
 
-			if (device_properties2.properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU &&
+			uint32_t device_rank = GetPhysicalDeviceTypeRank(device_properties2.properties.deviceType) + 1;
+
+			if (device_rank > best_device_rank &&
 				required_extensions.empty() &&
 				device_features2.features.samplerAnisotropy &&
+				// Required for gl_PrimitiveID in fragment shaders, used by the visibility buffer
+				device_features2.features.geometryShader &&
+				// Required for the rg16f storage image written by the BRDF LUT compute shader
+				device_features2.features.shaderStorageImageExtendedFormats &&
 				vulkan12_features.bufferDeviceAddress &&
 				vulkan12_features.bufferDeviceAddressCaptureReplay &&
 				vulkan12_features.timelineSemaphore &&
+				vulkan12_features.hostQueryReset &&
+				// Required for the descriptor heaps, which only fill part of the descriptors declared in their set layouts
+				vulkan12_features.descriptorBindingVariableDescriptorCount &&
+				vulkan12_features.descriptorBindingPartiallyBound &&
 				vulkan13_features.dynamicRendering &&
 				vulkan13_features.maintenance4 &&
 				vulkan13_features.synchronization2 &&
@@ -239,9 +325,13 @@ namespace Vulkan
 				ray_query_features.rayQuery)
 			{
 				vk_inst.physical_device = device;
+				best_device_rank = device_rank;
+				LOG_INFO("Vulkan", "Found suitable device: {}", device_properties2.properties.deviceName);
 
 				vk_inst.device_props.max_anisotropy = device_properties2.properties.limits.maxSamplerAnisotropy;
 				vk_inst.device_props.descriptor_buffer_offset_alignment = descriptor_buffer_properties.descriptorBufferOffsetAlignment;
+				vk_inst.device_props.timestamp_period = device_properties2.properties.limits.timestampPeriod;
+				vk_inst.device_props.pipeline_statistics_query = device_features2.features.pipelineStatisticsQuery;
 
 				vk_inst.descriptor_sizes.uniform_buffer = descriptor_buffer_properties.uniformBufferDescriptorSize;
 				vk_inst.descriptor_sizes.storage_buffer = descriptor_buffer_properties.storageBufferDescriptorSize;
@@ -250,9 +340,24 @@ namespace Vulkan
 				vk_inst.descriptor_sizes.sampler = descriptor_buffer_properties.samplerDescriptorSize;
 				vk_inst.descriptor_sizes.acceleration_structure = descriptor_buffer_properties.accelerationStructureDescriptorSize;
 
-				vk_inst.debug.min_imported_host_pointer_alignment = external_memory_host_properties.minImportedHostPointerAlignment;
+				const VkPhysicalDeviceLimits& limits = device_properties2.properties.limits;
+				vk_inst.descriptor_limits.max_per_stage_resources = limits.maxPerStageResources;
+				vk_inst.descriptor_limits.max_storage_buffers = std::min(limits.maxPerStageDescriptorStorageBuffers, limits.maxDescriptorSetStorageBuffers);
+				vk_inst.descriptor_limits.max_storage_images = std::min(limits.maxPerStageDescriptorStorageImages, limits.maxDescriptorSetStorageImages);
+				vk_inst.descriptor_limits.max_sampled_images = std::min(limits.maxPerStageDescriptorSampledImages, limits.maxDescriptorSetSampledImages);
+				vk_inst.descriptor_limits.max_samplers = std::min(limits.maxPerStageDescriptorSamplers, limits.maxDescriptorSetSamplers);
+				vk_inst.descriptor_limits.max_acceleration_structures = std::min(acceleration_structure_properties.maxPerStageDescriptorAccelerationStructures,
+					acceleration_structure_properties.maxDescriptorSetAccelerationStructures);
+
+				vk_inst.descriptor_limits.max_descriptor_buffer_bindings = descriptor_buffer_properties.maxDescriptorBufferBindings;
+				vk_inst.descriptor_limits.max_resource_descriptor_buffer_bindings = descriptor_buffer_properties.maxResourceDescriptorBufferBindings;
+				vk_inst.descriptor_limits.max_sampler_descriptor_buffer_bindings = descriptor_buffer_properties.maxSamplerDescriptorBufferBindings;
+				vk_inst.descriptor_limits.max_resource_descriptor_buffer_range = descriptor_buffer_properties.maxResourceDescriptorBufferRange;
+				vk_inst.descriptor_limits.max_sampler_descriptor_buffer_range = descriptor_buffer_properties.maxSamplerDescriptorBufferRange;
+				vk_inst.descriptor_limits.resource_descriptor_buffer_address_space_size = descriptor_buffer_properties.resourceDescriptorBufferAddressSpaceSize;
+				vk_inst.descriptor_limits.sampler_descriptor_buffer_address_space_size = descriptor_buffer_properties.samplerDescriptorBufferAddressSpaceSize;
 
-				break;
+				vk_inst.debug.min_imported_host_pointer_alignment = external_memory_host_properties.minImportedHostPointerAlignment;
 			}
 		}
 
@@ -260,9 +365,11 @@ namespace Vulkan
 		{
 			VK_EXCEPT("Vulkan", "No suitable GPU device found");
 		}
+
+		CheckCalibratedTimestampSupport();
 	}
 
-	static void FindQueueIndices()
+	static void FindQueueIndices(uint32_t& compute_queue_index)
 	{
 		uint32_t queue_family_count = 0;
 		vkGetPhysicalDeviceQueueFamilyProperties(vk_inst.physical_device, &queue_family_count, nullptr);
@@ -274,7 +381,8 @@ namespace Vulkan
 		for (const auto& queue_family : queue_families)
 		{
 			VkBool32 present_supported = false;
-			VkCheckResult(vkGetPhysicalDeviceSurfaceSupportKHR(vk_inst.physical_device, i, vk_inst.swapchain.surface, &present_supported));
+			if (!vk_inst.headless)
+				VkCheckResult(vkGetPhysicalDeviceSurfaceSupportKHR(vk_inst.physical_device, i, vk_inst.swapchain.surface, &present_supported));
 
 			/*if (present_supported)
 			{
@@ -283,40 +391,65 @@ namespace Vulkan
 			// Check queue for graphics and compute capabilities
 			if ((queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
 				(queue_family.queueFlags & VK_QUEUE_COMPUTE_BIT) &&
-				(queue_family.timestampValidBits > 0))
+				(queue_family.timestampValidBits > 0) &&
+				vk_inst.queues.graphics_compute.queue_family_index == ~0u)
 			{
 				vk_inst.queues.graphics_compute.queue_family_index = i;
 			}
-			if (queue_family.queueFlags & VK_QUEUE_TRANSFER_BIT)
+			if ((queue_family.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+				vk_inst.queues.transfer.queue_family_index == ~0u)
 			{
 				vk_inst.queues.transfer.queue_family_index = i;
 			}
-
-			if (//vk_inst.queues.present.vk_queue_index != ~0u &&
-				vk_inst.queues.graphics_compute.queue_family_index != ~0u &&
-				vk_inst.queues.transfer.queue_family_index != ~0u)
-				break;
+			// Prefer a dedicated compute queue family for async compute, since these map to separate hardware queues
+			if ((queue_family.queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+				!(queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+				(queue_family.timestampValidBits > 0) &&
+				vk_inst.queues.compute.queue_family_index == ~0u)
+			{
+				vk_inst.queues.compute.queue_family_index = i;
+			}
 
 			i++;
 		}
+
+		// Without a dedicated compute family, use a second queue from the graphics family if there is one,
+		// otherwise async compute work is submitted to the same queue as the graphics work
+		compute_queue_index = 0;
+		if (vk_inst.queues.compute.queue_family_index == ~0u)
+		{
+			vk_inst.queues.compute.queue_family_index = vk_inst.queues.graphics_compute.queue_family_index;
+			compute_queue_index = std::min(1u, queue_families[vk_inst.queues.graphics_compute.queue_family_index].queueCount - 1);
+		}
+
+		LOG_INFO("Vulkan", "Async compute uses queue {} of queue family {}{}", compute_queue_index, vk_inst.queues.compute.queue_family_index,
+			vk_inst.queues.compute.queue_family_index != vk_inst.queues.graphics_compute.queue_family_index ? " (dedicated compute family)" : "");
 	}
 
 	static void CreateDevice()
 	{
-		FindQueueIndices();
+		uint32_t compute_queue_index = 0;
+		FindQueueIndices(compute_queue_index);
+
+		// Number of queues to create for each unique queue family
+		std::unordered_map<uint32_t, uint32_t> queue_family_counts;
+		for (uint32_t queue_family : { //vk_inst.queues.present.vk_queue_index,
+			vk_inst.queues.graphics_compute.queue_family_index, vk_inst.queues.transfer.queue_family_index })
+		{
+			queue_family_counts[queue_family] = std::max(queue_family_counts[queue_family], 1u);
+		}
+		queue_family_counts[vk_inst.queues.compute.queue_family_index] = std::max(queue_family_counts[vk_inst.queues.compute.queue_family_index], compute_queue_index + 1);
 
 		std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
-		std::set<uint32_t> unique_queue_families = { //vk_inst.queues.present.vk_queue_index,
-			vk_inst.queues.graphics_compute.queue_family_index, vk_inst.queues.transfer.queue_family_index };
-		float queue_priority = 1.0;
+		float queue_priorities[] = { 1.0f, 1.0f };
 
-		for (uint32_t queue_family : unique_queue_families)
+		for (const auto& [queue_family, queue_count] : queue_family_counts)
 		{
 			VkDeviceQueueCreateInfo& queue_create_info = queue_create_infos.emplace_back();
 			queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 			queue_create_info.queueFamilyIndex = queue_family;
-			queue_create_info.queueCount = 1;
-			queue_create_info.pQueuePriorities = &queue_priority;
+			queue_create_info.queueCount = queue_count;
+			queue_create_info.pQueuePriorities = queue_priorities;
 		}
 
 		VkDeviceCreateInfo device_create_info = {};
@@ -368,6 +501,7 @@ namespace Vulkan
 		//vk_inst.queues.present = CreateCommandQueue(vk_inst.queues.present.vk_queue_index, 0);
 		vk_inst.queues.graphics_compute = CommandQueue::Create(VULKAN_COMMAND_BUFFER_TYPE_GRAPHICS_COMPUTE, vk_inst.queues.graphics_compute.queue_family_index, 0);
 		vk_inst.queues.transfer = CommandQueue::Create(VULKAN_COMMAND_BUFFER_TYPE_TRANSFER, vk_inst.queues.transfer.queue_family_index, 0);
+		vk_inst.queues.compute = CommandQueue::Create(VULKAN_COMMAND_BUFFER_TYPE_COMPUTE, vk_inst.queues.compute.queue_family_index, compute_queue_index);
 
 		// Load function pointers for extensions
 		LoadVulkanFunction<PFN_vkGetDescriptorEXT>("vkGetDescriptorEXT", vk_inst.pFunc.get_descriptor_ext);
@@ -382,6 +516,9 @@ namespace Vulkan
 		LoadVulkanFunction<PFN_vkGetAccelerationStructureBuildSizesKHR>("vkGetAccelerationStructureBuildSizesKHR", vk_inst.pFunc.raytracing.get_acceleration_structure_build_sizes);
 		LoadVulkanFunction<PFN_vkGetAccelerationStructureDeviceAddressKHR>("vkGetAccelerationStructureDeviceAddressKHR", vk_inst.pFunc.raytracing.get_acceleration_structure_device_address);
 
+		if (vk_inst.device_props.calibrated_timestamps)
+			LoadVulkanFunction<PFN_vkGetCalibratedTimestampsEXT>("vkGetCalibratedTimestampsEXT", vk_inst.pFunc.get_calibrated_timestamps_ext);
+
 #ifdef _DEBUG
 		LoadVulkanFunction<PFN_vkDebugMarkerSetObjectNameEXT>("vkSetDebugUtilsObjectNameEXT", vk_inst.pFunc.debug_marker_set_object_name_ext);
 #endif
@@ -415,9 +552,87 @@ namespace Vulkan
 		return buffer;
 	}
 
+	static constexpr uint32_t SHADER_CACHE_VERSION = 1;
+	static constexpr const char* SHADER_CACHE_DIRECTORY = "cache/shaders";
+	static constexpr const char* PIPELINE_CACHE_FILEPATH = "cache/pipeline_cache.bin";
+	static constexpr std::chrono::milliseconds SHADER_HOT_RELOAD_POLL_INTERVAL = std::chrono::milliseconds(250);
+
+	// The create info is kept around for every pipeline, so that it can be recreated when one of its shaders changes
+	struct ReloadablePipeline
+	{
+		VulkanPipeline pipeline;
+		GraphicsPipelineInfo graphics_info;
+		ComputePipelineInfo compute_info;
+	};
+
+	struct RetiredPipeline
+	{
+		VulkanPipeline pipeline;
+		uint32_t frame_index = 0;
+	};
+
+	struct Data
+	{
+		struct ShaderCompiler
+		{
+			// The compiler itself is thread-safe, the caches below are guarded by the mutex
+			shaderc::Compiler compiler;
+			std::mutex mutex;
+
+			// Source files are read once and shared between all shaders that include them
+			std::unordered_map<std::string, std::vector<char>> source_files;
+			// SPIR-V binaries keyed by the hash of the preprocessed source and compile options
+			std::unordered_map<uint64_t, std::vector<uint32_t>> spirv_binaries;
+			// Files included by each shader, recorded while preprocessing
+			std::unordered_map<std::string, std::vector<std::string>> dependencies;
+
+			uint32_t num_cache_hits = 0;
+			uint32_t num_cache_misses = 0;
+		} shader_compiler;
+
+		VkPipelineCache vk_pipeline_cache = VK_NULL_HANDLE;
+
+		struct ShaderHotReload
+		{
+			std::thread thread;
+			std::atomic<bool> running = false;
+
+			// Guards the pipelines and the reloaded pipelines, since the hot reload thread creates new pipelines in the background
+			std::mutex mutex;
+			std::unordered_map<VkPipeline, ReloadablePipeline> pipelines;
+			std::vector<ReloadedPipeline> reloaded_pipelines;
+
+			// Only accessed from the main thread
+			std::vector<RetiredPipeline> retired_pipelines;
+		} shader_hot_reload;
+	} static* data;
+
+	static std::vector<char> ReadShaderSourceFile(const std::string& filepath)
+	{
+		{
+			std::scoped_lock lock(data->shader_compiler.mutex);
+
+			auto source_file = data->shader_compiler.source_files.find(filepath);
+			if (source_file != data->shader_compiler.source_files.end())
+				return source_file->second;
+		}
+
+		std::vector<char> source_text = ReadFile(filepath.c_str());
+
+		std::scoped_lock lock(data->shader_compiler.mutex);
+		data->shader_compiler.source_files.emplace(filepath, source_text);
+
+		return source_text;
+	}
+
 	class ShadercIncluder : public shaderc::CompileOptions::IncluderInterface
 	{
 	public:
+		explicit ShadercIncluder(std::vector<std::string>* dependencies = nullptr)
+			: m_dependencies(dependencies)
+		{
+		}
+
 		virtual shaderc_include_result* GetInclude(const char* requested_source, shaderc_include_type type,
 			const char* requesting_source, size_t include_depth) override
 		{
@@ -429,7 +644,10 @@ namespace Vulkan
 			result->source_name_length = strlen(requested_source);
 
 			std::string requested_source_filepath = MakeRequestedFilepath(requested_source);
-			std::vector<char> requested_source_text = ReadFile(requested_source_filepath.c_str());
+			std::vector<char> requested_source_text = ReadShaderSourceFile(requested_source_filepath);
+
+			if (m_dependencies)
+				m_dependencies->push_back(requested_source_filepath);
 
 			result->content = new char[requested_source_text.size()];
 			memcpy((void*)result->content, requested_source_text.data(), requested_source_text.size());
@@ -441,7 +659,7 @@ namespace Vulkan
 		// Handles shaderc_include_result_release_fn callbacks.
 		virtual void ReleaseInclude(shaderc_include_result* data) override
 		{
-			delete data->content;
+			delete[] data->content;
 			delete data;
 		}
 
@@ -464,22 +682,12 @@ namespace Vulkan
 
 	private:
 		std::string m_include_directory = "";
+		std::vector<std::string>* m_dependencies = nullptr;
 
 	};
 
-	struct Data
+	static shaderc::CompileOptions GetShaderCompileOptions(std::vector<std::string>* dependencies = nullptr)
 	{
-		struct ShaderCompiler
-		{
-			shaderc::Compiler compiler;
-			ShadercIncluder includer;
-		} shader_compiler;
-	} static* data;
-
-	static std::vector<uint32_t> CompileShader(const char* filepath, shaderc_shader_kind shader_type)
-	{
-		auto shader_text = ReadFile(filepath);
-
 		shaderc::CompileOptions compile_options = {};
 #ifdef _DEBUG
 		compile_options.SetOptimizationLevel(shaderc_optimization_level_zero);
@@ -488,19 +696,182 @@ namespace Vulkan
 #else
 		compile_options.SetOptimizationLevel(shaderc_optimization_level_performance);
 #endif
-		compile_options.SetIncluder(std::make_unique<ShadercIncluder>());
+		compile_options.SetIncluder(std::make_unique<ShadercIncluder>(dependencies));
 		compile_options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
 		compile_options.SetTargetSpirv(shaderc_spirv_version_1_6);
 
+		return compile_options;
+	}
+
+	static uint64_t GetShaderCacheKey(const std::string& preprocessed_text, shaderc_shader_kind shader_type)
+	{
+		// Everything that can change the SPIR-V output, besides the preprocessed source, needs to be part of the key
+		struct CacheKeyParams
+		{
+			uint32_t cache_version = SHADER_CACHE_VERSION;
+			uint32_t shader_type = 0;
+#ifdef _DEBUG
+			uint32_t debug = 1;
+#else
+			uint32_t debug = 0;
+#endif
+			uint32_t target_env = shaderc_env_version_vulkan_1_3;
+			uint32_t target_spirv = shaderc_spirv_version_1_6;
+		} cache_key_params;
+		cache_key_params.shader_type = (uint32_t)shader_type;
+
+		uint64_t cache_key = HashBytes(&cache_key_params, sizeof(cache_key_params));
+		return HashBytes(preprocessed_text.data(), preprocessed_text.size(), cache_key);
+	}
+
+	static std::filesystem::path GetShaderCacheFilepath(uint64_t cache_key)
+	{
+		return std::filesystem::path(SHADER_CACHE_DIRECTORY) / std::format("{:016x}.spv", cache_key);
+	}
+
+	// Returns false and fills in the error message if the shader failed to compile, safe to call from multiple threads
+	// The shader is preprocessed first, so that the SPIR-V can be looked up in the cache by the hash of its full source
+	static bool CompileShader(const char* filepath, shaderc_shader_kind shader_type, std::vector<uint32_t>& spirv, std::string& error_message)
+	{
+		PROFILE_FUNCTION();
+
+		std::vector<char> shader_text = ReadShaderSourceFile(filepath);
+		std::vector<std::string> dependencies;
+
+		shaderc::PreprocessedSourceCompilationResult preprocess_result = data->shader_compiler.compiler.PreprocessGlsl(
+			shader_text.data(), shader_text.size(), shader_type, filepath, GetShaderCompileOptions(&dependencies));
+
+		{
+			std::scoped_lock lock(data->shader_compiler.mutex);
+			data->shader_compiler.dependencies[filepath] = dependencies;
+		}
+
+		if (preprocess_result.GetCompilationStatus() != shaderc_compilation_status_success)
+		{
+			error_message = preprocess_result.GetErrorMessage();
+			return false;
+		}
+
+		std::string preprocessed_text(preprocess_result.begin(), preprocess_result.end());
+		uint64_t cache_key = GetShaderCacheKey(preprocessed_text, shader_type);
+
+		{
+			std::scoped_lock lock(data->shader_compiler.mutex);
+
+			auto spirv_binary = data->shader_compiler.spirv_binaries.find(cache_key);
+			if (spirv_binary != data->shader_compiler.spirv_binaries.end())
+			{
+				spirv = spirv_binary->second;
+				return true;
+			}
+		}
+
+		std::filesystem::path cache_filepath = GetShaderCacheFilepath(cache_key);
+		std::vector<uint8_t> cached_bytes;
+
+		if (FileIO::ReadBinary(cache_filepath, cached_bytes) && cached_bytes.size() > 0 && cached_bytes.size() % sizeof(uint32_t) == 0)
+		{
+			spirv.resize(cached_bytes.size() / sizeof(uint32_t));
+			memcpy(spirv.data(), cached_bytes.data(), cached_bytes.size());
+
+			std::scoped_lock lock(data->shader_compiler.mutex);
+			data->shader_compiler.spirv_binaries.emplace(cache_key, spirv);
+			data->shader_compiler.num_cache_hits++;
+
+			return true;
+		}
+
 		shaderc::SpvCompilationResult shader_compile_result = data->shader_compiler.compiler.CompileGlslToSpv(
-			shader_text.data(), shader_text.size(), shader_type, filepath, "main", compile_options);
+			preprocessed_text.data(), preprocessed_text.size(), shader_type, filepath, "main", GetShaderCompileOptions());
 
 		if (shader_compile_result.GetCompilationStatus() != shaderc_compilation_status_success)
 		{
-			VK_EXCEPT("Vulkan", shader_compile_result.GetErrorMessage());
+			error_message = shader_compile_result.GetErrorMessage();
+			return false;
 		}
 
-		return { shader_compile_result.begin(), shader_compile_result.end() };
+		spirv.assign(shader_compile_result.begin(), shader_compile_result.end());
+		FileIO::WriteBinary(cache_filepath, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(spirv.data()), spirv.size() * sizeof(uint32_t)));
+
+		std::scoped_lock lock(data->shader_compiler.mutex);
+		data->shader_compiler.spirv_binaries.emplace(cache_key, spirv);
+		data->shader_compiler.num_cache_misses++;
+
+		return true;
+	}
+
+	static std::vector<uint32_t> CompileShader(const char* filepath, shaderc_shader_kind shader_type)
+	{
+		std::vector<uint32_t> spirv;
+		std::string error_message;
+
+		if (!CompileShader(filepath, shader_type, spirv, error_message))
+		{
+			VK_EXCEPT("Vulkan", error_message);
+		}
+
+		return spirv;
+	}
+
+	// Shader stages are derived from the file naming convention: *.vert, *.frag and *CS.glsl
+	static bool GetShaderKindFromFilepath(const std::filesystem::path& filepath, shaderc_shader_kind& shader_type)
+	{
+		std::string extension = filepath.extension().string();
+		std::string stem = filepath.stem().string();
+
+		if (extension == ".vert")
+			shader_type = shaderc_vertex_shader;
+		else if (extension == ".frag")
+			shader_type = shaderc_fragment_shader;
+		else if (extension == ".glsl" && stem.ends_with("CS"))
+			shader_type = shaderc_compute_shader;
+		else
+			return false;
+
+		return true;
+	}
+
+	static void CreatePipelineCache()
+	{
+		VkPhysicalDeviceProperties device_properties = {};
+		vkGetPhysicalDeviceProperties(vk_inst.physical_device, &device_properties);
+
+		// Only hand the cached data to the driver if it was created by the same device and driver
+		std::vector<uint8_t> cache_bytes;
+		if (FileIO::ReadBinary(PIPELINE_CACHE_FILEPATH, cache_bytes))
+		{
+			VkPipelineCacheHeaderVersionOne cache_header = {};
+			if (cache_bytes.size() >= sizeof(VkPipelineCacheHeaderVersionOne))
+				memcpy(&cache_header, cache_bytes.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+
+			if (cache_header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+				cache_header.vendorID != device_properties.vendorID ||
+				cache_header.deviceID != device_properties.deviceID ||
+				memcmp(cache_header.pipelineCacheUUID, device_properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+			{
+				LOG_WARN("Vulkan", "Ignoring pipeline cache created by a different device or driver: {}", PIPELINE_CACHE_FILEPATH);
+				cache_bytes.clear();
+			}
+		}
+
+		VkPipelineCacheCreateInfo pipeline_cache_info = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+		pipeline_cache_info.initialDataSize = cache_bytes.size();
+		pipeline_cache_info.pInitialData = cache_bytes.data();
+
+		VkCheckResult(vkCreatePipelineCache(vk_inst.device, &pipeline_cache_info, nullptr, &data->vk_pipeline_cache));
+	}
+
+	static void DestroyPipelineCache()
+	{
+		size_t num_bytes = 0;
+		VkCheckResult(vkGetPipelineCacheData(vk_inst.device, data->vk_pipeline_cache, &num_bytes, nullptr));
+
+		std::vector<uint8_t> cache_bytes(num_bytes);
+		VkCheckResult(vkGetPipelineCacheData(vk_inst.device, data->vk_pipeline_cache, &num_bytes, cache_bytes.data()));
+		cache_bytes.resize(num_bytes);
+
+		FileIO::WriteBinary(PIPELINE_CACHE_FILEPATH, cache_bytes);
+		vkDestroyPipelineCache(vk_inst.device, data->vk_pipeline_cache, nullptr);
 	}
 
 	static VkShaderModule CreateShaderModule(const std::vector<uint32_t>& code)
@@ -518,11 +889,13 @@ namespace Vulkan
 
 	static void ResizeOutputResolution()
 	{
+		// Only blocks while the window is minimized, so that recreating the swapchain for a new present mode does not wait for an event
 		int32_t window_width = 0, window_height = 0;
+		glfwGetFramebufferSize(vk_inst.glfw_window, &window_width, &window_height);
 		while (window_width == 0 || window_height == 0)
 		{
-			glfwGetFramebufferSize(vk_inst.glfw_window, &window_width, &window_height);
 			glfwWaitEvents();
+			glfwGetFramebufferSize(vk_inst.glfw_window, &window_width, &window_height);
 		}
 
 		uint32_t new_output_width = static_cast<uint32_t>(window_width);
@@ -540,19 +913,26 @@ namespace Vulkan
 
 	void Init(::GLFWwindow* window, uint32_t window_width, uint32_t window_height)
 	{
+		vk_inst.headless = window == nullptr;
+		vk_inst.headless_extent = { window_width, window_height };
+		vk_inst.num_frames_in_flight = DEFAULT_FRAMES_IN_FLIGHT;
+
 		CreateInstance();
 		EnableValidationLayers();
 
-		VkCheckResult(glfwCreateWindowSurface(vk_inst.instance, window, nullptr, &vk_inst.swapchain.surface));
+		if (!vk_inst.headless)
+			VkCheckResult(glfwCreateWindowSurface(vk_inst.instance, window, nullptr, &vk_inst.swapchain.surface));
 		ResourceTracker::Init();
 
 		CreatePhysicalDevice();
 		CreateDevice();
-		SwapChain::Create(window_width, window_height);
+		if (!vk_inst.headless)
+			SwapChain::Create(window_width, window_height);
 
 		Descriptor::Init();
 
 		data = new Data();
+		CreatePipelineCache();
 	}
 
 	void Exit()
@@ -560,15 +940,31 @@ namespace Vulkan
 		//vkQueueWaitIdle(vk_inst.queues.present.vk_queue);
 		vkQueueWaitIdle(vk_inst.queues.graphics_compute.vk_queue);
 		vkQueueWaitIdle(vk_inst.queues.transfer.vk_queue);
+		vkQueueWaitIdle(vk_inst.queues.compute.vk_queue);
 
 		CommandQueue::Destroy(vk_inst.queues.graphics_compute);
 		CommandQueue::Destroy(vk_inst.queues.transfer);
+		CommandQueue::Destroy(vk_inst.queues.compute);
 
+		// Destroy the pipelines left over from shader hot reload, which are not owned by any render pass
+		for (const auto& retired_pipeline : data->shader_hot_reload.retired_pipelines)
+		{
+			DestroyPipeline(retired_pipeline.pipeline);
+		}
+		for (const auto& reloaded_pipeline : data->shader_hot_reload.reloaded_pipelines)
+		{
+			DestroyPipeline(reloaded_pipeline.new_pipeline);
+		}
+
+		DestroyPipelineCache();
 		delete data;
 
 		Descriptor::Exit();
-		SwapChain::Destroy();
-		vkDestroySurfaceKHR(vk_inst.instance, vk_inst.swapchain.surface, nullptr);
+		if (!vk_inst.headless)
+		{
+			SwapChain::Destroy();
+			vkDestroySurfaceKHR(vk_inst.instance, vk_inst.swapchain.surface, nullptr);
+		}
 
 #ifdef ENABLE_VK_DEBUG_LAYER
 		auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(vk_inst.instance, "vkDestroyDebugUtilsMessengerEXT");
@@ -586,13 +982,42 @@ namespace Vulkan
 		ResourceTracker::Exit();
 	}
 
+	bool IsHeadless()
+	{
+		return vk_inst.headless;
+	}
+
 	bool BeginFrame()
 	{
+		// The swapchain was flagged for recreation, because of a present mode or frames in flight change
+		if (!vk_inst.headless && vk_inst.swapchain.recreate)
+		{
+			VkExtent2D previous_extent = vk_inst.swapchain.extent;
+			ResizeOutputResolution();
+
+			if (vk_inst.swapchain.extent.width != previous_extent.width ||
+				vk_inst.swapchain.extent.height != previous_extent.height)
+			{
+				return true;
+			}
+		}
+
 		// Get the next available image from the swapchain
-		VkResult result = Vulkan::SwapChain::AcquireNextImage();
+		VkResult result = vk_inst.headless ? VK_SUCCESS : Vulkan::SwapChain::AcquireNextImage();
 
 		// Release all temporary resources from the resource tracker
 		ResourceTracker::ReleaseStaleTempResources();
+		Descriptor::BeginFrame();
+
+		// Destroy pipelines that were replaced by shader hot reload and are no longer in flight
+		std::erase_if(data->shader_hot_reload.retired_pipelines, [](const RetiredPipeline& retired_pipeline)
+		{
+			if (GetLastFinishedFrameIndex() < retired_pipeline.frame_index)
+				return false;
+
+			DestroyPipeline(retired_pipeline.pipeline);
+			return true;
+		});
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
@@ -604,6 +1029,9 @@ namespace Vulkan
 			VkCheckResult(result);
 		}
 
+		if (vk_inst.headless)
+			return false;
+
 		// ImGui (backends) new frame
 		ImGui_ImplGlfw_NewFrame();
 		ImGui_ImplVulkan_NewFrame();
@@ -614,6 +1042,9 @@ namespace Vulkan
 
 	void CopyToBackBuffer(VulkanCommandBuffer& command_buffer, const VulkanImage& src_image)
 	{
+		if (vk_inst.headless)
+			return;
+
 		VulkanImage& backbuffer_image = Vulkan::SwapChain::GetBackBuffer();
 
 		// Transition SDR render target and swapchain image to TRANSFER_SRC and TRANSFER_DST
@@ -633,13 +1064,19 @@ namespace Vulkan
 		// Add wait to command buffer to wait for an available image from the swapchain
 		Vulkan::CommandBuffer::AddWait(
 			command_buffer,
-			vk_inst.swapchain.image_available_fences[vk_inst.current_frame_index % MAX_FRAMES_IN_FLIGHT],
+			vk_inst.swapchain.image_available_fences[vk_inst.current_frame_index % vk_inst.num_frames_in_flight],
 			VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
 		);
 	}
 
 	bool EndFrame(const VulkanFence& present_wait_fence)
 	{
+		if (vk_inst.headless)
+		{
+			vk_inst.current_frame_index++;
+			return false;
+		}
+
 		// Present, wait fence waits for the rendering to be finished before presenting
 		VkResult result = Vulkan::SwapChain::Present({ present_wait_fence });
 
@@ -664,8 +1101,9 @@ namespace Vulkan
 
 	void GetOutputResolution(uint32_t& output_width, uint32_t& output_height)
 	{
-		output_width = vk_inst.swapchain.extent.width;
-		output_height = vk_inst.swapchain.extent.height;
+		VkExtent2D output_extent = vk_inst.headless ? vk_inst.headless_extent : vk_inst.swapchain.extent;
+		output_width = output_extent.width;
+		output_height = output_extent.height;
 	}
 
 	uint32_t GetCurrentBackBufferIndex()
@@ -681,7 +1119,25 @@ namespace Vulkan
 	uint32_t GetLastFinishedFrameIndex()
 	{
 		// TODO: Could probably use a fence value here instead that signals the finish of a frame
-		return std::max(0, (int32_t)vk_inst.current_frame_index - (int32_t)Vulkan::MAX_FRAMES_IN_FLIGHT);
+		return std::max(0, (int32_t)vk_inst.current_frame_index - (int32_t)vk_inst.num_frames_in_flight);
+	}
+
+	void SetNumFramesInFlight(uint32_t num_frames_in_flight)
+	{
+		num_frames_in_flight = std::clamp(num_frames_in_flight, 1u, MAX_FRAMES_IN_FLIGHT);
+		if (num_frames_in_flight == vk_inst.num_frames_in_flight)
+			return;
+
+		// The frame slots are indexed by the frame index modulo the number of frames in flight, so changing it is only safe while nothing is in flight
+		WaitDeviceIdle();
+
+		vk_inst.num_frames_in_flight = num_frames_in_flight;
+		vk_inst.swapchain.recreate = !vk_inst.headless;
+	}
+
+	uint32_t GetNumFramesInFlight()
+	{
+		return vk_inst.num_frames_in_flight;
 	}
 
 	VulkanCommandQueue GetCommandQueue(VulkanCommandBufferType type)
@@ -692,6 +1148,8 @@ namespace Vulkan
 			return vk_inst.queues.graphics_compute;
 		case VULKAN_COMMAND_BUFFER_TYPE_TRANSFER:
 			return vk_inst.queues.transfer;
+		case VULKAN_COMMAND_BUFFER_TYPE_COMPUTE:
+			return vk_inst.queues.compute;
 		default:
 			VK_EXCEPT("Vulkan::GetCommandQueue", "Tried to retrieve a command queue for an unknown type");
 		}
@@ -751,21 +1209,25 @@ namespace Vulkan
 
 	VulkanPipeline CreateGraphicsPipeline(const GraphicsPipelineInfo& info)
 	{
-		VkPipelineLayout vk_pipeline_layout = CreatePipelineLayout(info.push_ranges);
-
 		// TODO: Vulkan extension for shader objects? No longer need to make compiled pipeline states then
 		// https://www.khronos.org/blog/you-can-use-vulkan-without-pipelines-today
+		// NOTE: Shaders are compiled before creating any Vulkan objects, so that nothing leaks when compilation throws (e.g. during shader hot reload)
 		std::vector<uint32_t> vert_spirv;
 		VkShaderModule vert_shader_module = VK_NULL_HANDLE;
 
 		std::vector<uint32_t> frag_spirv;
 		VkShaderModule frag_shader_module = VK_NULL_HANDLE;
 
+		if (info.vs_path)
+			vert_spirv = CompileShader(info.vs_path, shaderc_vertex_shader);
+		if (info.fs_path)
+			frag_spirv = CompileShader(info.fs_path, shaderc_fragment_shader);
+
+		VkPipelineLayout vk_pipeline_layout = CreatePipelineLayout(info.push_ranges);
 		std::vector<VkPipelineShaderStageCreateInfo> shader_stage_infos;
 
 		if (info.vs_path)
 		{
-			vert_spirv = CompileShader(info.vs_path, shaderc_vertex_shader);
 			vert_shader_module = CreateShaderModule(vert_spirv);
 
 			VkPipelineShaderStageCreateInfo vert_shader_stage_info = {};
@@ -778,7 +1240,6 @@ namespace Vulkan
 		}
 		if (info.fs_path)
 		{
-			frag_spirv = CompileShader(info.fs_path, shaderc_fragment_shader);
 			frag_shader_module = CreateShaderModule(frag_spirv);
 
 			VkPipelineShaderStageCreateInfo frag_shader_stage_info = {};
@@ -909,7 +1370,7 @@ namespace Vulkan
 		pipeline_info.pNext = &pipeline_rendering_info;
 
 		VkPipeline vk_pipeline = VK_NULL_HANDLE;
-		VkCheckResult(vkCreateGraphicsPipelines(vk_inst.device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &vk_pipeline));
+		VkCheckResult(vkCreateGraphicsPipelines(vk_inst.device, data->vk_pipeline_cache, 1, &pipeline_info, nullptr, &vk_pipeline));
 
 		vkDestroyShaderModule(vk_inst.device, frag_shader_module, nullptr);
 		vkDestroyShaderModule(vk_inst.device, vert_shader_module, nullptr);
@@ -919,14 +1380,16 @@ namespace Vulkan
 		pipeline.vk_pipeline = vk_pipeline;
 		pipeline.vk_pipeline_layout = vk_pipeline_layout;
 
+		std::scoped_lock lock(data->shader_hot_reload.mutex);
+		data->shader_hot_reload.pipelines.emplace(vk_pipeline, ReloadablePipeline{ .pipeline = pipeline, .graphics_info = info });
+
 		return pipeline;
 	}
 
 	VulkanPipeline CreateComputePipeline(const ComputePipelineInfo& info)
 	{
-		VkPipelineLayout vk_pipeline_layout = CreatePipelineLayout(info.push_ranges);
-
 		std::vector<uint32_t> compute_spv = CompileShader(info.cs_path, shaderc_compute_shader);
+		VkPipelineLayout vk_pipeline_layout = CreatePipelineLayout(info.push_ranges);
 		VkShaderModule compute_shader_module = CreateShaderModule(compute_spv);
 
 		VkPipelineShaderStageCreateInfo compute_shader_stage_info = {};
@@ -942,7 +1405,7 @@ namespace Vulkan
 		pipeline_info.flags = VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
 
 		VkPipeline vk_pipeline = VK_NULL_HANDLE;
-		VkCheckResult(vkCreateComputePipelines(vk_inst.device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &vk_pipeline));
+		VkCheckResult(vkCreateComputePipelines(vk_inst.device, data->vk_pipeline_cache, 1, &pipeline_info, nullptr, &vk_pipeline));
 
 		vkDestroyShaderModule(vk_inst.device, compute_shader_module, nullptr);
 
@@ -951,15 +1414,251 @@ namespace Vulkan
 		pipeline.vk_pipeline = vk_pipeline;
 		pipeline.vk_pipeline_layout = vk_pipeline_layout;
 
+		std::scoped_lock lock(data->shader_hot_reload.mutex);
+		data->shader_hot_reload.pipelines.emplace(vk_pipeline, ReloadablePipeline{ .pipeline = pipeline, .compute_info = info });
+
 		return pipeline;
 	}
 
 	void DestroyPipeline(const VulkanPipeline& pipeline)
 	{
+		{
+			std::scoped_lock lock(data->shader_hot_reload.mutex);
+			data->shader_hot_reload.pipelines.erase(pipeline.vk_pipeline);
+		}
+
 		vkDestroyPipelineLayout(vk_inst.device, pipeline.vk_pipeline_layout, nullptr);
 		vkDestroyPipeline(vk_inst.device, pipeline.vk_pipeline, nullptr);
 	}
 
+	void PrecompileShaders(const char* shader_directory)
+	{
+		std::chrono::high_resolution_clock::time_point compile_begin = std::chrono::high_resolution_clock::now();
+
+		struct ShaderCompileJob
+		{
+			std::string filepath;
+			shaderc_shader_kind shader_type;
+
+			bool success = false;
+			std::string error_message;
+		};
+
+		std::vector<ShaderCompileJob> compile_jobs;
+		for (const auto& entry : std::filesystem::directory_iterator(shader_directory))
+		{
+			shaderc_shader_kind shader_type;
+			if (entry.is_regular_file() && GetShaderKindFromFilepath(entry.path(), shader_type))
+			{
+				// Use the same path format as the pipeline infos, since the include directory is derived from it
+				compile_jobs.push_back({ .filepath = entry.path().generic_string(), .shader_type = shader_type });
+			}
+		}
+
+		uint32_t num_cache_hits = data->shader_compiler.num_cache_hits;
+		uint32_t num_cache_misses = data->shader_compiler.num_cache_misses;
+
+		// Worker threads pull jobs until there are none left, the results end up in the SPIR-V cache
+		std::atomic<uint32_t> next_job_index = 0;
+		auto compile_worker = [&compile_jobs, &next_job_index]()
+		{
+			for (uint32_t job_index = next_job_index++; job_index < compile_jobs.size(); job_index = next_job_index++)
+			{
+				ShaderCompileJob& job = compile_jobs[job_index];
+				std::vector<uint32_t> spirv;
+
+				try
+				{
+					job.success = CompileShader(job.filepath.c_str(), job.shader_type, spirv, job.error_message);
+				}
+				catch (const std::exception& e)
+				{
+					job.error_message = e.what();
+				}
+			}
+		};
+
+		uint32_t num_threads = std::min(std::max(std::thread::hardware_concurrency(), 1u), (uint32_t)compile_jobs.size());
+		std::vector<std::thread> compile_threads;
+
+		for (uint32_t i = 0; i < num_threads; ++i)
+		{
+			compile_threads.emplace_back(compile_worker);
+		}
+		for (auto& compile_thread : compile_threads)
+		{
+			compile_thread.join();
+		}
+
+		// Failed shaders are not fatal here, they will throw when the pipeline that uses them is created
+		for (const auto& job : compile_jobs)
+		{
+			if (!job.success)
+				LOG_WARN("Vulkan::PrecompileShaders", "Failed to compile shader {}: {}", job.filepath, job.error_message);
+		}
+
+		std::chrono::duration<float, std::milli> compile_duration = std::chrono::high_resolution_clock::now() - compile_begin;
+		LOG_INFO("Vulkan::PrecompileShaders", "Precompiled {} shaders on {} threads in {:.2f} ms ({} cache hits, {} cache misses)",
+			compile_jobs.size(), num_threads, compile_duration.count(),
+			data->shader_compiler.num_cache_hits - num_cache_hits, data->shader_compiler.num_cache_misses - num_cache_misses);
+	}
+
+	static bool PipelineUsesShaders(const ReloadablePipeline& reloadable_pipeline, const std::set<std::string>& shader_filepaths)
+	{
+		auto uses_shader = [&shader_filepaths](const char* filepath)
+		{
+			return filepath && shader_filepaths.contains(filepath);
+		};
+
+		if (reloadable_pipeline.pipeline.type == VULKAN_PIPELINE_TYPE_GRAPHICS)
+			return uses_shader(reloadable_pipeline.graphics_info.vs_path) || uses_shader(reloadable_pipeline.graphics_info.fs_path);
+		else
+			return uses_shader(reloadable_pipeline.compute_info.cs_path);
+	}
+
+	// Polls the shader directory and its subdirectories for modified files, and recreates every pipeline that uses a modified shader or one of its includes
+	// The new pipelines are handed to the renderer through GetReloadedPipelines, pipelines that fail to compile keep running the old version
+	static void ShaderHotReloadThread(std::filesystem::path shader_directory)
+	{
+		std::unordered_map<std::string, std::filesystem::file_time_type> write_times;
+		bool initial_scan = true;
+
+		while (data->shader_hot_reload.running)
+		{
+			// Editors may hold the file while saving, in which case we pick up the change on the next poll
+			std::error_code error;
+			std::set<std::string> changed_files;
+
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(shader_directory, std::filesystem::directory_options::skip_permission_denied, error))
+			{
+				std::filesystem::file_time_type write_time = entry.last_write_time(error);
+				if (error || !entry.is_regular_file(error))
+					continue;
+
+				std::string filepath = entry.path().generic_string();
+				auto tracked_write_time = write_times.find(filepath);
+
+				if (tracked_write_time == write_times.end() || tracked_write_time->second != write_time)
+				{
+					write_times[filepath] = write_time;
+					if (!initial_scan)
+						changed_files.insert(filepath);
+				}
+			}
+
+			initial_scan = false;
+
+			if (!changed_files.empty())
+			{
+				// Drop the stale sources from the cache, and find every shader that includes one of the changed files
+				std::set<std::string> changed_shaders = changed_files;
+				{
+					std::scoped_lock lock(data->shader_compiler.mutex);
+
+					for (const auto& changed_file : changed_files)
+					{
+						data->shader_compiler.source_files.erase(changed_file);
+					}
+
+					for (const auto& [shader_filepath, dependencies] : data->shader_compiler.dependencies)
+					{
+						for (const auto& dependency : dependencies)
+						{
+							if (changed_files.contains(dependency))
+								changed_shaders.insert(shader_filepath);
+						}
+					}
+				}
+
+				std::vector<ReloadablePipeline> changed_pipelines;
+				{
+					std::scoped_lock lock(data->shader_hot_reload.mutex);
+
+					for (const auto& [vk_pipeline, reloadable_pipeline] : data->shader_hot_reload.pipelines)
+					{
+						if (PipelineUsesShaders(reloadable_pipeline, changed_shaders))
+							changed_pipelines.push_back(reloadable_pipeline);
+					}
+				}
+
+				for (const auto& reloadable_pipeline : changed_pipelines)
+				{
+					const char* filepath = reloadable_pipeline.pipeline.type == VULKAN_PIPELINE_TYPE_GRAPHICS ?
+						reloadable_pipeline.graphics_info.fs_path : reloadable_pipeline.compute_info.cs_path;
+					if (!filepath)
+						filepath = reloadable_pipeline.graphics_info.vs_path;
+
+					VulkanPipeline new_pipeline;
+					try
+					{
+						if (reloadable_pipeline.pipeline.type == VULKAN_PIPELINE_TYPE_GRAPHICS)
+							new_pipeline = CreateGraphicsPipeline(reloadable_pipeline.graphics_info);
+						else
+							new_pipeline = CreateComputePipeline(reloadable_pipeline.compute_info);
+					}
+					catch (const std::exception&)
+					{
+						LOG_WARN("Vulkan::ShaderHotReload", "Failed to reload pipeline for {}, keeping the previous version", filepath);
+						continue;
+					}
+
+					bool old_pipeline_alive = false;
+					{
+						std::scoped_lock lock(data->shader_hot_reload.mutex);
+
+						// The old pipeline is no longer reloadable, the new pipeline replaces it
+						old_pipeline_alive = data->shader_hot_reload.pipelines.erase(reloadable_pipeline.pipeline.vk_pipeline) > 0;
+						if (old_pipeline_alive)
+							data->shader_hot_reload.reloaded_pipelines.push_back({ reloadable_pipeline.pipeline, new_pipeline });
+					}
+
+					if (old_pipeline_alive)
+						LOG_INFO("Vulkan::ShaderHotReload", "Reloaded pipeline for {}", filepath);
+					else
+						DestroyPipeline(new_pipeline);
+				}
+			}
+
+			std::this_thread::sleep_for(SHADER_HOT_RELOAD_POLL_INTERVAL);
+		}
+	}
+
+	void EnableShaderHotReload(const char* shader_directory)
+	{
+		if (data->shader_hot_reload.running)
+			return;
+
+		data->shader_hot_reload.running = true;
+		data->shader_hot_reload.thread = std::thread(ShaderHotReloadThread, std::filesystem::path(shader_directory));
+	}
+
+	void DisableShaderHotReload()
+	{
+		if (!data->shader_hot_reload.running)
+			return;
+
+		data->shader_hot_reload.running = false;
+		data->shader_hot_reload.thread.join();
+	}
+
+	std::vector<ReloadedPipeline> GetReloadedPipelines()
+	{
+		std::vector<ReloadedPipeline> reloaded_pipelines;
+		{
+			std::scoped_lock lock(data->shader_hot_reload.mutex);
+			reloaded_pipelines.swap(data->shader_hot_reload.reloaded_pipelines);
+		}
+
+		// The caller swaps the pipelines before recording the current frame, so the old pipelines
+		// can be destroyed once all frames up to and including the current frame have finished
+		for (const auto& reloaded_pipeline : reloaded_pipelines)
+		{
+			data->shader_hot_reload.retired_pipelines.push_back({ reloaded_pipeline.old_pipeline, vk_inst.current_frame_index });
+		}
+
+		return reloaded_pipelines;
+	}
+
 	void InitImGui(::GLFWwindow* window)
 	{
 		vk_inst.glfw_window = window;
@@ -991,9 +1690,10 @@ namespace Vulkan
 		init_info.Device = vk_inst.device;
 		init_info.QueueFamily = vk_inst.queues.graphics_compute.queue_family_index;
 		init_info.Queue = vk_inst.queues.graphics_compute.vk_queue;
-		init_info.PipelineCache = VK_NULL_HANDLE;
+		init_info.PipelineCache = data->vk_pipeline_cache;
 		init_info.DescriptorPool = vk_inst.imgui.descriptor_pool;
-		init_info.MinImageCount = Vulkan::MAX_FRAMES_IN_FLIGHT;
+		// ImGui cycles through a vertex buffer per image count, so it needs one for every frame that can be in flight
+		init_info.MinImageCount = 2;
 		init_info.ImageCount = Vulkan::MAX_FRAMES_IN_FLIGHT;
 		init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
 		init_info.Allocator = nullptr;
@@ -1014,6 +1714,9 @@ namespace Vulkan
 
 	VkDescriptorSet AddImGuiTexture(VkImage image, VkImageView image_view, VkSampler sampler)
 	{
+		if (vk_inst.headless)
+			return VK_NULL_HANDLE;
+
 		return ImGui_ImplVulkan_AddTexture(sampler, image_view, VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL);
 	}
 
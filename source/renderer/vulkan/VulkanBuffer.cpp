@@ -18,6 +18,8 @@ namespace Vulkan
 			buffer_info.usage_flags = BUFFER_USAGE_COPY_DST | BUFFER_USAGE_READ_ONLY |
 				BUFFER_USAGE_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_INPUT;
 			buffer_info.memory_flags = GPU_MEMORY_DEVICE_LOCAL;
+			// Uploaded and used as BLAS build input on the async compute queue
+			buffer_info.async_compute_shared = true;
 			buffer_info.name = name;
 
 			return Create(buffer_info);
@@ -27,20 +29,23 @@ namespace Vulkan
 		{
 			BufferCreateInfo buffer_info = {};
 			buffer_info.size_in_bytes = size_in_bytes;
-			buffer_info.usage_flags = BUFFER_USAGE_COPY_DST | BUFFER_USAGE_INDEX |
+			buffer_info.usage_flags = BUFFER_USAGE_COPY_DST | BUFFER_USAGE_INDEX | BUFFER_USAGE_READ_ONLY |
 				BUFFER_USAGE_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_INPUT;
 			buffer_info.memory_flags = GPU_MEMORY_DEVICE_LOCAL;
+			// Uploaded and used as BLAS build input on the async compute queue
+			buffer_info.async_compute_shared = true;
 			buffer_info.name = name;
 
 			return Create(buffer_info);
 		}
 
-		VulkanBuffer CreateAccelerationStructure(uint64_t size_in_bytes, const std::string& name)
+		VulkanBuffer CreateAccelerationStructure(uint64_t size_in_bytes, const std::string& name, bool async_compute_shared)
 		{
 			BufferCreateInfo buffer_info = {};
 			buffer_info.size_in_bytes = size_in_bytes;
 			buffer_info.usage_flags = BUFFER_USAGE_RAYTRACING_ACCELERATION_STRUCTURE;
 			buffer_info.memory_flags = GPU_MEMORY_DEVICE_LOCAL;
+			buffer_info.async_compute_shared = async_compute_shared;
 			buffer_info.name = name;
 
 			return Create(buffer_info);
@@ -77,6 +82,15 @@ namespace Vulkan
 			vk_buffer_info.usage = vk_usage_flags;
 			vk_buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+			// Buffers used by both the graphics and the async compute queue use concurrent sharing, which avoids queue family ownership transfers
+			uint32_t queue_family_indices[] = { vk_inst.queues.graphics_compute.queue_family_index, vk_inst.queues.compute.queue_family_index };
+			if (buffer_info.async_compute_shared && queue_family_indices[0] != queue_family_indices[1])
+			{
+				vk_buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+				vk_buffer_info.queueFamilyIndexCount = 2;
+				vk_buffer_info.pQueueFamilyIndices = queue_family_indices;
+			}
+
 			VkBuffer vk_buffer = VK_NULL_HANDLE;
 			VkCheckResult(vkCreateBuffer(vk_inst.device, &vk_buffer_info, nullptr, &vk_buffer));
 			Vulkan::DebugNameObject((uint64_t)vk_buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, buffer_info.name);
@@ -1,6 +1,7 @@
 #include "Precomp.h"
 #include "renderer/vulkan/VulkanCommandBuffer.h"
 #include "renderer/vulkan/VulkanInstance.h"
+#include "renderer/vulkan/VulkanCommands.h"
 
 namespace Vulkan
 {
@@ -17,14 +18,17 @@ namespace Vulkan
 			vkBeginCommandBuffer(command_buffer.vk_command_buffer, &begin_info);
 		}
 
-		void EndRecording(const VulkanCommandBuffer& command_buffer)
+		void EndRecording(VulkanCommandBuffer& command_buffer)
 		{
+			Command::FlushBarriers(command_buffer);
 			vkEndCommandBuffer(command_buffer.vk_command_buffer);
 		}
 
 		void Reset(VulkanCommandBuffer& command_buffer)
 		{
 			command_buffer.wait_fences.clear();
+			command_buffer.pending_image_barriers.clear();
+			command_buffer.pending_buffer_barriers.clear();
 			vkResetCommandBuffer(command_buffer.vk_command_buffer, 0);
 		}
 
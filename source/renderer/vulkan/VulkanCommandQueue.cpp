@@ -14,12 +14,12 @@ namespace Vulkan
 		VulkanCommandQueue Create(VulkanCommandBufferType type, uint32_t queue_family_index, uint32_t queue_index)
 		{
 			VkQueue vk_queue;
-			vkGetDeviceQueue(vk_inst.device, queue_index, 0, &vk_queue);
+			vkGetDeviceQueue(vk_inst.device, queue_family_index, queue_index, &vk_queue);
 
 			VulkanCommandQueue command_queue = {};
 			command_queue.type = type;
 			command_queue.vk_queue = vk_queue;
-			command_queue.queue_family_index = queue_index;
+			command_queue.queue_family_index = queue_family_index;
 			command_queue.fence = Sync::CreateFence(VULKAN_FENCE_TYPE_TIMELINE, 0);
 
 			return command_queue;
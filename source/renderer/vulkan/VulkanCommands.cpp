@@ -15,9 +15,11 @@ namespace Vulkan
 	namespace Command
 	{
 
-		void BeginRendering(const VulkanCommandBuffer& command_buffer, uint32_t num_color_attachments, const VkRenderingAttachmentInfo* const color_attachments, 
+		void BeginRendering(VulkanCommandBuffer& command_buffer, uint32_t num_color_attachments, const VkRenderingAttachmentInfo* const color_attachments, 
 			const VkRenderingAttachmentInfo* const depth_attachment, const VkRenderingAttachmentInfo* const stencil_attachment, uint32_t render_width, uint32_t render_height, int32_t offset_x, int32_t offset_y)
 		{
+			FlushBarriers(command_buffer);
+
 			VkRenderingInfo rendering_info = { VK_STRUCTURE_TYPE_RENDERING_INFO };
 			rendering_info.colorAttachmentCount = num_color_attachments;
 			rendering_info.pColorAttachments = color_attachments;
@@ -76,8 +78,10 @@ namespace Vulkan
 			vkCmdDrawIndexed(command_buffer.vk_command_buffer, num_indices, num_instances, first_index, vertex_offset, first_instance);
 		}
 
-		void ClearImage(const VulkanCommandBuffer& command_buffer, const VulkanImage& image, const VkClearColorValue& clear_value)
+		void ClearImage(VulkanCommandBuffer& command_buffer, const VulkanImage& image, const VkClearColorValue& clear_value)
 		{
+			FlushBarriers(command_buffer);
+
 			VkImageSubresourceRange subresource_range = {};
 			subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 			subresource_range.baseMipLevel = 0;
@@ -86,11 +90,13 @@ namespace Vulkan
 			subresource_range.layerCount = image.num_layers;
 
 			vkCmdClearColorImage(command_buffer.vk_command_buffer, image.vk_image,
-				ResourceTracker::GetImageLayout({ .image = image.vk_image }), &clear_value, 1, &subresource_range);
+				ResourceTracker::GetImageLayout({ .image = image }), &clear_value, 1, &subresource_range);
 		}
 
-		void ClearImage(const VulkanCommandBuffer& command_buffer, const VulkanImage& image, const VkClearDepthStencilValue& clear_value)
+		void ClearImage(VulkanCommandBuffer& command_buffer, const VulkanImage& image, const VkClearDepthStencilValue& clear_value)
 		{
+			FlushBarriers(command_buffer);
+
 			VkImageSubresourceRange subresource_range = {};
 			subresource_range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
 			subresource_range.baseMipLevel = 0;
@@ -99,16 +105,20 @@ namespace Vulkan
 			subresource_range.layerCount = image.num_layers;
 
 			vkCmdClearDepthStencilImage(command_buffer.vk_command_buffer, image.vk_image,
-				ResourceTracker::GetImageLayout({ .image = image.vk_image }), &clear_value, 1, &subresource_range);
+				ResourceTracker::GetImageLayout({ .image = image }), &clear_value, 1, &subresource_range);
 		}
 
-		void Dispatch(const VulkanCommandBuffer& command_buffer, uint32_t group_x, uint32_t group_y, uint32_t group_z)
+		void Dispatch(VulkanCommandBuffer& command_buffer, uint32_t group_x, uint32_t group_y, uint32_t group_z)
 		{
+			FlushBarriers(command_buffer);
+
 			vkCmdDispatch(command_buffer.vk_command_buffer, group_x, group_y, group_z);
 		}
 
-		void CopyBuffers(const VulkanCommandBuffer& command_buffer, const VulkanBuffer& src_buffer, uint64_t src_offset, const VulkanBuffer& dst_buffer, uint64_t dst_offset, uint64_t num_bytes)
+		void CopyBuffers(VulkanCommandBuffer& command_buffer, const VulkanBuffer& src_buffer, uint64_t src_offset, const VulkanBuffer& dst_buffer, uint64_t dst_offset, uint64_t num_bytes)
 		{
+			FlushBarriers(command_buffer);
+
 			VkBufferCopy copy_region = {};
 			copy_region.srcOffset = src_buffer.offset_in_bytes + src_offset;
 			copy_region.dstOffset = dst_buffer.offset_in_bytes + dst_offset;
@@ -117,8 +127,25 @@ namespace Vulkan
 			vkCmdCopyBuffer(command_buffer.vk_command_buffer, src_buffer.vk_buffer, dst_buffer.vk_buffer, 1, &copy_region);
 		}
 
-		void CopyFromBuffer(const VulkanCommandBuffer& command_buffer, const VulkanBuffer& src_buffer, uint64_t src_offset, const VulkanImage& dst_image, uint32_t dst_width, uint32_t dst_height)
+		void CopyBuffers(VulkanCommandBuffer& command_buffer, const VulkanBuffer& src_buffer, const VulkanBuffer& dst_buffer, uint32_t num_regions, const VkBufferCopy* regions)
 		{
+			FlushBarriers(command_buffer);
+
+			std::vector<VkBufferCopy> copy_regions(regions, regions + num_regions);
+			for (VkBufferCopy& copy_region : copy_regions)
+			{
+				copy_region.srcOffset += src_buffer.offset_in_bytes;
+				copy_region.dstOffset += dst_buffer.offset_in_bytes;
+			}
+
+			vkCmdCopyBuffer(command_buffer.vk_command_buffer, src_buffer.vk_buffer, dst_buffer.vk_buffer, num_regions, copy_regions.data());
+		}
+
+		void CopyFromBuffer(VulkanCommandBuffer& command_buffer, const VulkanBuffer& src_buffer, uint64_t src_offset, const VulkanImage& dst_image, uint32_t dst_width, uint32_t dst_height,
+			uint32_t dst_mip, uint32_t dst_base_layer, uint32_t dst_num_layers)
+		{
+			FlushBarriers(command_buffer);
+
 			VkBufferImageCopy2 buffer_image_copy = { VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2 };
 			buffer_image_copy.bufferOffset = src_offset;
 			buffer_image_copy.bufferImageHeight = 0;
@@ -128,22 +155,52 @@ namespace Vulkan
 			buffer_image_copy.imageOffset = { 0, 0, 0 };
 
 			buffer_image_copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			buffer_image_copy.imageSubresource.mipLevel = 0;
-			buffer_image_copy.imageSubresource.baseArrayLayer = 0;
-			buffer_image_copy.imageSubresource.layerCount = 1;
+			buffer_image_copy.imageSubresource.mipLevel = dst_mip;
+			buffer_image_copy.imageSubresource.baseArrayLayer = dst_base_layer;
+			buffer_image_copy.imageSubresource.layerCount = dst_num_layers;
 
 			VkCopyBufferToImageInfo2 copy_buffer_image_info = { VK_STRUCTURE_TYPE_COPY_BUFFER_TO_IMAGE_INFO_2 };
 			copy_buffer_image_info.srcBuffer = src_buffer.vk_buffer;
 			copy_buffer_image_info.dstImage = dst_image.vk_image;
-			copy_buffer_image_info.dstImageLayout = ResourceTracker::GetImageLayout({ dst_image.vk_image });
+			copy_buffer_image_info.dstImageLayout = ResourceTracker::GetImageLayout({ .image = dst_image });
 			copy_buffer_image_info.regionCount = 1;
 			copy_buffer_image_info.pRegions = &buffer_image_copy;
 
 			vkCmdCopyBufferToImage2(command_buffer.vk_command_buffer, &copy_buffer_image_info);
 		}
 
-		void CopyImages(const VulkanCommandBuffer& command_buffer, const VulkanImage& src_image, const VulkanImage& dst_image)
+		void CopyToBuffer(VulkanCommandBuffer& command_buffer, const VulkanImage& src_image, uint32_t src_width, uint32_t src_height, const VulkanBuffer& dst_buffer, uint64_t dst_offset,
+			uint32_t src_mip, uint32_t src_base_layer, uint32_t src_num_layers)
 		{
+			FlushBarriers(command_buffer);
+
+			VkBufferImageCopy2 buffer_image_copy = { VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2 };
+			buffer_image_copy.bufferOffset = dst_offset;
+			buffer_image_copy.bufferImageHeight = 0;
+			buffer_image_copy.bufferRowLength = 0;
+
+			buffer_image_copy.imageExtent = { src_width, src_height, 1 };
+			buffer_image_copy.imageOffset = { 0, 0, 0 };
+
+			buffer_image_copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			buffer_image_copy.imageSubresource.mipLevel = src_mip;
+			buffer_image_copy.imageSubresource.baseArrayLayer = src_base_layer;
+			buffer_image_copy.imageSubresource.layerCount = src_num_layers;
+
+			VkCopyImageToBufferInfo2 copy_image_buffer_info = { VK_STRUCTURE_TYPE_COPY_IMAGE_TO_BUFFER_INFO_2 };
+			copy_image_buffer_info.srcImage = src_image.vk_image;
+			copy_image_buffer_info.srcImageLayout = ResourceTracker::GetImageLayout({ .image = src_image });
+			copy_image_buffer_info.dstBuffer = dst_buffer.vk_buffer;
+			copy_image_buffer_info.regionCount = 1;
+			copy_image_buffer_info.pRegions = &buffer_image_copy;
+
+			vkCmdCopyImageToBuffer2(command_buffer.vk_command_buffer, &copy_image_buffer_info);
+		}
+
+		void CopyImages(VulkanCommandBuffer& command_buffer, const VulkanImage& src_image, const VulkanImage& dst_image)
+		{
+			FlushBarriers(command_buffer);
+
 			// We use vkCmdBlitImage here to have format conversions done automatically for us
 			// E.g. R8G8B8A8 to B8G8R8A8
 			VulkanImage swapchain_image = vk_inst.swapchain.images[vk_inst.swapchain.current_image];
@@ -171,8 +228,10 @@ namespace Vulkan
 			);
 		}
 
-		void GenerateMips(const VulkanCommandBuffer& command_buffer, const VulkanImage& image)
+		void GenerateMips(VulkanCommandBuffer& command_buffer, const VulkanImage& image)
 		{
+			FlushBarriers(command_buffer);
+
 			VkFormatProperties format_properties;
 			vkGetPhysicalDeviceFormatProperties(vk_inst.physical_device, image.vk_format, &format_properties);
 
@@ -181,8 +240,7 @@ namespace Vulkan
 				VK_EXCEPT("Vulkan", "Texture image format does not support linear filter in blitting operation");
 			}
 
-			VkImageMemoryBarrier barrier = {};
-			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			VkImageMemoryBarrier2 barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
 			barrier.image = image.vk_image;
 			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -196,18 +254,17 @@ namespace Vulkan
 
 			for (uint32_t i = 1; i < image.num_mips; ++i)
 			{
+				// The transition of the previous mip to read only is still pending, and gets recorded together with this one
 				barrier.subresourceRange.baseMipLevel = i - 1;
 				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 				barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-				barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-				vkCmdPipelineBarrier(command_buffer.vk_command_buffer,
-					VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-					0, nullptr,
-					0, nullptr,
-					1, &barrier
-				);
+				barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+				barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+				barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+				barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+
+				QueueBarriers(command_buffer, { barrier }, {});
+				FlushBarriers(command_buffer);
 
 				VkImageBlit blit = {};
 				blit.srcOffsets[0] = { 0, 0, 0 };
@@ -232,15 +289,12 @@ namespace Vulkan
 
 				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 				barrier.newLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-				barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-				vkCmdPipelineBarrier(command_buffer.vk_command_buffer,
-					VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-					0, nullptr,
-					0, nullptr,
-					1, &barrier
-				);
+				barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+				barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+				barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+				barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+
+				QueueBarriers(command_buffer, { barrier }, {});
 
 				if (mip_width > 1) mip_width /= 2;
 				if (mip_height > 1) mip_height /= 2;
@@ -249,15 +303,12 @@ namespace Vulkan
 			barrier.subresourceRange.baseMipLevel = image.num_mips - 1;
 			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 			barrier.newLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-			vkCmdPipelineBarrier(command_buffer.vk_command_buffer,
-				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-				0, nullptr,
-				0, nullptr,
-				1, &barrier
-			);
+			barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+			barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+
+			QueueBarriers(command_buffer, { barrier }, {});
 
 			VulkanImageBarrier layout_info = {};
 			layout_info.image = image;
@@ -265,12 +316,12 @@ namespace Vulkan
 			ResourceTracker::UpdateImageAccessAndStageFlags(layout_info);
 		}
 
-		void BufferMemoryBarrier(const VulkanCommandBuffer& command_buffer, const VulkanBufferBarrier& buffer_barrier)
+		void BufferMemoryBarrier(VulkanCommandBuffer& command_buffer, const VulkanBufferBarrier& buffer_barrier)
 		{
 			BufferMemoryBarriers(command_buffer, { buffer_barrier });
 		}
 
-		void BufferMemoryBarriers(const VulkanCommandBuffer& command_buffer, const std::vector<VulkanBufferBarrier>& buffer_barriers)
+		void BufferMemoryBarriers(VulkanCommandBuffer& command_buffer, const std::vector<VulkanBufferBarrier>& buffer_barriers)
 		{
 			std::vector<VkBufferMemoryBarrier2> vk_buffer_memory_barriers(buffer_barriers.size());
 
@@ -280,20 +331,15 @@ namespace Vulkan
 				ResourceTracker::UpdateBufferAccessAndStageFlags(buffer_barriers[i]);
 			}
 
-			VkDependencyInfo dependency_info = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
-			dependency_info.bufferMemoryBarrierCount = static_cast<uint32_t>(vk_buffer_memory_barriers.size());
-			dependency_info.pBufferMemoryBarriers = vk_buffer_memory_barriers.data();
-			dependency_info.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-			vkCmdPipelineBarrier2(command_buffer.vk_command_buffer, &dependency_info);
+			QueueBarriers(command_buffer, {}, vk_buffer_memory_barriers);
 		}
 
-		void TransitionLayout(const VulkanCommandBuffer& command_buffer, const VulkanImageBarrier& image_barrier)
+		void TransitionLayout(VulkanCommandBuffer& command_buffer, const VulkanImageBarrier& image_barrier)
 		{
 			TransitionLayouts(command_buffer, { image_barrier });
 		}
 
-		void TransitionLayouts(const VulkanCommandBuffer& command_buffer, const std::vector<VulkanImageBarrier>& image_barriers)
+		void TransitionLayouts(VulkanCommandBuffer& command_buffer, const std::vector<VulkanImageBarrier>& image_barriers)
 		{
 			std::vector<VkImageMemoryBarrier2> vk_image_memory_barriers(image_barriers.size());
 
@@ -303,12 +349,198 @@ namespace Vulkan
 				ResourceTracker::UpdateImageAccessAndStageFlags(image_barriers[i]);
 			}
 
+			QueueBarriers(command_buffer, vk_image_memory_barriers, {});
+		}
+
+		// Compute queues do not support the graphics pipeline stages, so these are removed from barriers recorded for them
+		static constexpr VkPipelineStageFlags2 GRAPHICS_ONLY_STAGE_FLAGS = VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT |
+			VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_TESSELLATION_CONTROL_SHADER_BIT |
+			VK_PIPELINE_STAGE_2_TESSELLATION_EVALUATION_SHADER_BIT | VK_PIPELINE_STAGE_2_GEOMETRY_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT |
+			VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT |
+			VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT;
+		static constexpr VkAccessFlags2 GRAPHICS_ONLY_ACCESS_FLAGS = VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT |
+			VK_ACCESS_2_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+			VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		static void RestrictToQueue(const VulkanCommandBuffer& command_buffer, VkPipelineStageFlags2& stage_flags, VkAccessFlags2& access_flags)
+		{
+			if (command_buffer.type != VULKAN_COMMAND_BUFFER_TYPE_COMPUTE)
+				return;
+
+			stage_flags &= ~GRAPHICS_ONLY_STAGE_FLAGS;
+			access_flags &= ~GRAPHICS_ONLY_ACCESS_FLAGS;
+
+			if (stage_flags == VK_PIPELINE_STAGE_2_NONE)
+				access_flags = VK_ACCESS_2_NONE;
+		}
+
+		template<typename TBarrier>
+		static void RestrictBarrierToQueue(const VulkanCommandBuffer& command_buffer, TBarrier& barrier)
+		{
+			RestrictToQueue(command_buffer, barrier.srcStageMask, barrier.srcAccessMask);
+			RestrictToQueue(command_buffer, barrier.dstStageMask, barrier.dstAccessMask);
+		}
+
+		static bool DoRangesOverlap(uint32_t first_base, uint32_t first_count, uint32_t second_base, uint32_t second_count)
+		{
+			return first_base < second_base + second_count && second_base < first_base + first_count;
+		}
+
+		static bool DoSubresourceRangesOverlap(const VkImageSubresourceRange& first, const VkImageSubresourceRange& second)
+		{
+			return DoRangesOverlap(first.baseMipLevel, first.levelCount, second.baseMipLevel, second.levelCount) &&
+				DoRangesOverlap(first.baseArrayLayer, first.layerCount, second.baseArrayLayer, second.layerCount);
+		}
+
+		static bool IsSameSubresourceRange(const VkImageSubresourceRange& first, const VkImageSubresourceRange& second)
+		{
+			return first.aspectMask == second.aspectMask && first.baseMipLevel == second.baseMipLevel && first.levelCount == second.levelCount &&
+				first.baseArrayLayer == second.baseArrayLayer && first.layerCount == second.layerCount;
+		}
+
+		static void QueueImageBarrier(VulkanCommandBuffer& command_buffer, VkImageMemoryBarrier2 barrier)
+		{
+			RestrictBarrierToQueue(command_buffer, barrier);
+
+			for (auto& pending : command_buffer.pending_image_barriers)
+			{
+				if (pending.image != barrier.image || !DoSubresourceRangesOverlap(pending.subresourceRange, barrier.subresourceRange))
+					continue;
+
+				if (IsSameSubresourceRange(pending.subresourceRange, barrier.subresourceRange))
+				{
+					// No work is recorded in between, so the pending transition can go straight to the new layout
+					// The source of the new barrier only refers to the pending transition, so the pending source scope is kept
+					pending.newLayout = barrier.newLayout;
+					pending.dstAccessMask = barrier.dstAccessMask;
+					pending.dstStageMask = barrier.dstStageMask;
+					return;
+				}
+
+				// Barriers within a single pipeline barrier are not ordered, so partially overlapping transitions have to be recorded separately
+				FlushBarriers(command_buffer);
+				break;
+			}
+
+			command_buffer.pending_image_barriers.push_back(barrier);
+		}
+
+		static void QueueBufferBarrier(VulkanCommandBuffer& command_buffer, VkBufferMemoryBarrier2 barrier)
+		{
+			RestrictBarrierToQueue(command_buffer, barrier);
+
+			for (auto& pending : command_buffer.pending_buffer_barriers)
+			{
+				if (pending.buffer != barrier.buffer)
+					continue;
+
+				if (pending.offset == barrier.offset && pending.size == barrier.size)
+				{
+					pending.srcAccessMask |= barrier.srcAccessMask;
+					pending.srcStageMask |= barrier.srcStageMask;
+					pending.dstAccessMask |= barrier.dstAccessMask;
+					pending.dstStageMask |= barrier.dstStageMask;
+					return;
+				}
+
+				// Conservatively treat different ranges of the same buffer as overlapping
+				FlushBarriers(command_buffer);
+				break;
+			}
+
+			command_buffer.pending_buffer_barriers.push_back(barrier);
+		}
+
+		void QueueBarriers(VulkanCommandBuffer& command_buffer, const std::vector<VkImageMemoryBarrier2>& image_barriers, const std::vector<VkBufferMemoryBarrier2>& buffer_barriers)
+		{
+			for (const auto& image_barrier : image_barriers)
+				QueueImageBarrier(command_buffer, image_barrier);
+
+			for (const auto& buffer_barrier : buffer_barriers)
+				QueueBufferBarrier(command_buffer, buffer_barrier);
+		}
+
+		void FlushBarriers(VulkanCommandBuffer& command_buffer)
+		{
+			if (command_buffer.pending_image_barriers.empty() && command_buffer.pending_buffer_barriers.empty())
+				return;
+
 			VkDependencyInfo dependency_info = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
-			dependency_info.imageMemoryBarrierCount = static_cast<uint32_t>(vk_image_memory_barriers.size());
-			dependency_info.pImageMemoryBarriers = vk_image_memory_barriers.data();
-			dependency_info.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+			dependency_info.imageMemoryBarrierCount = static_cast<uint32_t>(command_buffer.pending_image_barriers.size());
+			dependency_info.pImageMemoryBarriers = command_buffer.pending_image_barriers.data();
+			dependency_info.bufferMemoryBarrierCount = static_cast<uint32_t>(command_buffer.pending_buffer_barriers.size());
+			dependency_info.pBufferMemoryBarriers = command_buffer.pending_buffer_barriers.data();
 
 			vkCmdPipelineBarrier2(command_buffer.vk_command_buffer, &dependency_info);
+
+			command_buffer.pending_image_barriers.clear();
+			command_buffer.pending_buffer_barriers.clear();
+		}
+
+		void SignalSplitBarrier(VulkanCommandBuffer& command_buffer, VulkanSplitBarrier& split_barrier)
+		{
+			VK_ASSERT(split_barrier.vk_event && "Tried to signal a split barrier without an event");
+
+			for (auto& image_barrier : split_barrier.image_barriers)
+				RestrictBarrierToQueue(command_buffer, image_barrier);
+			for (auto& buffer_barrier : split_barrier.buffer_barriers)
+				RestrictBarrierToQueue(command_buffer, buffer_barrier);
+
+			VkDependencyInfo dependency_info = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+			dependency_info.imageMemoryBarrierCount = static_cast<uint32_t>(split_barrier.image_barriers.size());
+			dependency_info.pImageMemoryBarriers = split_barrier.image_barriers.data();
+			dependency_info.bufferMemoryBarrierCount = static_cast<uint32_t>(split_barrier.buffer_barriers.size());
+			dependency_info.pBufferMemoryBarriers = split_barrier.buffer_barriers.data();
+
+			vkCmdSetEvent2(command_buffer.vk_command_buffer, split_barrier.vk_event, &dependency_info);
+		}
+
+		void WaitSplitBarrier(VulkanCommandBuffer& command_buffer, const VulkanSplitBarrier& split_barrier)
+		{
+			VK_ASSERT(split_barrier.vk_event && "Tried to wait on a split barrier without an event");
+
+			// The dependency info needs to match the one the event was signaled with
+			VkDependencyInfo dependency_info = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+			dependency_info.imageMemoryBarrierCount = static_cast<uint32_t>(split_barrier.image_barriers.size());
+			dependency_info.pImageMemoryBarriers = split_barrier.image_barriers.data();
+			dependency_info.bufferMemoryBarrierCount = static_cast<uint32_t>(split_barrier.buffer_barriers.size());
+			dependency_info.pBufferMemoryBarriers = split_barrier.buffer_barriers.data();
+
+			vkCmdWaitEvents2(command_buffer.vk_command_buffer, 1, &split_barrier.vk_event, &dependency_info);
+
+			// Reset the event once the waiting stages are done, so that it can be signaled again next time
+			VkPipelineStageFlags2 dst_stage_flags = VK_PIPELINE_STAGE_2_NONE;
+			for (const auto& image_barrier : split_barrier.image_barriers)
+				dst_stage_flags |= image_barrier.dstStageMask;
+			for (const auto& buffer_barrier : split_barrier.buffer_barriers)
+				dst_stage_flags |= buffer_barrier.dstStageMask;
+
+			if (dst_stage_flags == VK_PIPELINE_STAGE_2_NONE)
+				dst_stage_flags = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+			vkCmdResetEvent2(command_buffer.vk_command_buffer, split_barrier.vk_event, dst_stage_flags);
+		}
+
+		void ResetQueries(const VulkanCommandBuffer& command_buffer, VkQueryPool vk_query_pool, uint32_t first_query, uint32_t num_queries)
+		{
+			vkCmdResetQueryPool(command_buffer.vk_command_buffer, vk_query_pool, first_query, num_queries);
+		}
+
+		void WriteTimestamp(VulkanCommandBuffer& command_buffer, VkQueryPool vk_query_pool, uint32_t query, VkPipelineStageFlags2 stage_flags)
+		{
+			FlushBarriers(command_buffer);
+
+			vkCmdWriteTimestamp2(command_buffer.vk_command_buffer, stage_flags, vk_query_pool, query);
+		}
+
+		void BeginQuery(const VulkanCommandBuffer& command_buffer, VkQueryPool vk_query_pool, uint32_t query)
+		{
+			vkCmdBeginQuery(command_buffer.vk_command_buffer, vk_query_pool, query, 0);
+		}
+
+		void EndQuery(const VulkanCommandBuffer& command_buffer, VkQueryPool vk_query_pool, uint32_t query)
+		{
+			vkCmdEndQuery(command_buffer.vk_command_buffer, vk_query_pool, query);
 		}
 
 	}
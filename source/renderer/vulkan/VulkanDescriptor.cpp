@@ -5,6 +5,7 @@
 #include "renderer/vulkan/VulkanDeviceMemory.h"
 #include "renderer/vulkan/VulkanBackend.h"
 #include "renderer/vulkan/VulkanUtils.h"
+#include "renderer/DescriptorAllocator.h"
 #include "Shared.glsl.h"
 
 namespace Vulkan
@@ -17,15 +18,22 @@ namespace Vulkan
 			============================ PRIVATE FUNCTIONS =================================
 		*/
 
-		static constexpr uint32_t DESCRIPTOR_BUFFER_DEFAULT_DESCRIPTOR_COUNT = 16384;
-
-		struct FreeDescriptorBlock
+		// The descriptor heaps start out at these sizes and grow when they run out, up to the device limits for their type
+		static constexpr std::array<uint32_t, VULKAN_DESCRIPTOR_TYPE_NUM_TYPES> DESCRIPTOR_HEAP_INITIAL_DESCRIPTOR_COUNT =
 		{
-			uint32_t num_descriptors = 0;
-			uint32_t descriptor_offset = 0;
-
-			FreeDescriptorBlock* ptr_next = nullptr;
+			RESERVED_DESCRIPTOR_UBO_COUNT,	// Uniform buffers, these have a fixed binding each and never grow
+			8192,							// Storage buffers
+			1024,							// Storage images
+			16384,							// Sampled images
+			64,								// Samplers
+			16								// Acceleration structures
 		};
+		// Some devices report limits of up to UINT32_MAX, the allocator bookkeeping grows with the heap size, so the heaps are capped regardless
+		static constexpr uint32_t DESCRIPTOR_HEAP_MAX_DESCRIPTOR_COUNT = 1u << 20;
+		// Heaps are grown at the beginning of a frame once less than 1 / DIVISOR of their descriptors is free
+		static constexpr uint32_t DESCRIPTOR_HEAP_GROW_FREE_DIVISOR = 8;
+		// Storage buffers, storage images and sampled images share the per-stage resource limit with the uniform buffers
+		static constexpr uint32_t NUM_RESOURCE_DESCRIPTOR_HEAPS = 3;
 
 		struct DescriptorBuffer
 		{
@@ -36,14 +44,31 @@ namespace Vulkan
 			VkDescriptorSetLayout vk_descriptor_set_layout = VK_NULL_HANDLE;
 
 			uint32_t num_descriptors = 0;
+			uint32_t max_descriptors = 0;
 			uint32_t descriptor_size_in_bytes = 0;
 
-			FreeDescriptorBlock* head = nullptr;
+			DescriptorAllocator allocator;
+		};
+
+		// The buffer of a heap before it grew, which is destroyed once the frames that could have it bound are finished
+		struct RetiredDescriptorBuffer
+		{
+			VulkanBuffer buffer;
+			uint8_t* ptr_mem = nullptr;
+
+			VulkanDescriptorType type = VULKAN_DESCRIPTOR_TYPE_NUM_TYPES;
+			uint32_t num_descriptors = 0;
+			uint32_t frame_index = 0;
+
+			// Command buffers recorded earlier in the frame the heap grew in still have this buffer bound,
+			// so descriptors written during the rest of that frame are written to both buffers
+			bool mirror_writes = false;
 		};
 
 		struct Data
 		{
 			std::array<DescriptorBuffer, MAX_FRAMES_IN_FLIGHT + VULKAN_DESCRIPTOR_TYPE_NUM_TYPES - 1> descriptor_buffers;
+			std::vector<RetiredDescriptorBuffer> retired_buffers;
 		} static data;
 
 		static VkDescriptorType GetVkDescriptorType(VulkanDescriptorType type)
@@ -105,6 +130,128 @@ namespace Vulkan
 			}
 		}
 
+		static uint32_t GetDescriptorHeapMaxDescriptorCount(VulkanDescriptorType type)
+		{
+			uint32_t max_type_descriptors = 0;
+			switch (type)
+			{
+			case VULKAN_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+				return RESERVED_DESCRIPTOR_UBO_COUNT;
+			case VULKAN_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+				max_type_descriptors = vk_inst.descriptor_limits.max_storage_buffers;
+				break;
+			case VULKAN_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+				max_type_descriptors = vk_inst.descriptor_limits.max_storage_images;
+				break;
+			case VULKAN_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+				max_type_descriptors = vk_inst.descriptor_limits.max_sampled_images;
+				break;
+			case VULKAN_DESCRIPTOR_TYPE_SAMPLER:
+				max_type_descriptors = vk_inst.descriptor_limits.max_samplers;
+				break;
+			case VULKAN_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE:
+				max_type_descriptors = vk_inst.descriptor_limits.max_acceleration_structures;
+				break;
+			default:
+				VK_EXCEPT("Descriptor::GetDescriptorHeapMaxDescriptorCount", "Tried to get the maximum descriptor count for an unknown descriptor type");
+			}
+
+			uint64_t max_descriptors = std::min(max_type_descriptors, DESCRIPTOR_HEAP_MAX_DESCRIPTOR_COUNT);
+			uint64_t descriptor_size = GetDescriptorTypeByteSize(type);
+
+			if (type == VULKAN_DESCRIPTOR_TYPE_SAMPLER)
+			{
+				// A heap and the buffer it replaced exist at the same time while growing, so a heap can only take up half of the address space
+				max_descriptors = std::min(max_descriptors, vk_inst.descriptor_limits.max_sampler_descriptor_buffer_range / descriptor_size);
+				max_descriptors = std::min(max_descriptors, vk_inst.descriptor_limits.sampler_descriptor_buffer_address_space_size / 2 / descriptor_size);
+			}
+			else
+			{
+				// All resource descriptor buffers share the address space, so each heap gets an equal share of it
+				uint64_t num_resource_descriptor_buffers = data.descriptor_buffers.size() - 1;
+				max_descriptors = std::min(max_descriptors, vk_inst.descriptor_limits.max_resource_descriptor_buffer_range / descriptor_size);
+				max_descriptors = std::min(max_descriptors,
+					vk_inst.descriptor_limits.resource_descriptor_buffer_address_space_size / 2 / num_resource_descriptor_buffers / descriptor_size);
+
+				if (type != VULKAN_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE)
+				{
+					uint64_t max_per_stage_resources = vk_inst.descriptor_limits.max_per_stage_resources - RESERVED_DESCRIPTOR_UBO_COUNT;
+					max_descriptors = std::min(max_descriptors, max_per_stage_resources / NUM_RESOURCE_DESCRIPTOR_HEAPS);
+				}
+			}
+
+			return (uint32_t)max_descriptors;
+		}
+
+		static void CreateDescriptorHeapBuffer(DescriptorBuffer& descriptor_buffer, uint64_t size_in_bytes)
+		{
+			Flags buffer_usage_flags = descriptor_buffer.type != VULKAN_DESCRIPTOR_TYPE_SAMPLER ? BUFFER_USAGE_RESOURCE_DESCRIPTORS : BUFFER_USAGE_SAMPLER_DESCRIPTORS;
+			BufferCreateInfo buffer_info = {
+				.usage_flags = buffer_usage_flags,
+				.memory_flags = GPU_MEMORY_HOST_VISIBLE | GPU_MEMORY_HOST_COHERENT,
+				.size_in_bytes = size_in_bytes,
+				// Bound on both the graphics and the async compute queue
+				.async_compute_shared = true,
+				.name = "Descriptor Buffer"
+			};
+
+			descriptor_buffer.buffer = Buffer::Create(buffer_info);
+			descriptor_buffer.ptr_mem = reinterpret_cast<uint8_t*>(DeviceMemory::Map(descriptor_buffer.buffer.memory, size_in_bytes, 0));
+		}
+
+		static void DestroyRetiredDescriptorBuffer(RetiredDescriptorBuffer& retired_buffer)
+		{
+			DeviceMemory::Unmap(retired_buffer.buffer.memory);
+			Buffer::Destroy(retired_buffer.buffer);
+		}
+
+		// Replaces the heap buffer with a larger one holding a copy of all descriptors, the new buffer is picked up by the next BindDescriptors
+		// Returns false if the heap can not grow to at least min_num_descriptors
+		static bool GrowDescriptorBuffer(DescriptorBuffer& descriptor_buffer, uint32_t min_num_descriptors, bool mirror_writes)
+		{
+			uint32_t num_descriptors = std::min(std::max(descriptor_buffer.num_descriptors * 2, min_num_descriptors), descriptor_buffer.max_descriptors);
+			if (num_descriptors < min_num_descriptors || num_descriptors <= descriptor_buffer.num_descriptors)
+				return false;
+
+			RetiredDescriptorBuffer retired_buffer = {};
+			retired_buffer.buffer = descriptor_buffer.buffer;
+			retired_buffer.ptr_mem = descriptor_buffer.ptr_mem;
+			retired_buffer.type = descriptor_buffer.type;
+			retired_buffer.num_descriptors = descriptor_buffer.num_descriptors;
+			retired_buffer.frame_index = GetCurrentFrameIndex();
+			retired_buffer.mirror_writes = mirror_writes;
+
+			CreateDescriptorHeapBuffer(descriptor_buffer, (uint64_t)num_descriptors * descriptor_buffer.descriptor_size_in_bytes);
+			memcpy(descriptor_buffer.ptr_mem, retired_buffer.ptr_mem, (size_t)retired_buffer.num_descriptors * descriptor_buffer.descriptor_size_in_bytes);
+			data.retired_buffers.push_back(retired_buffer);
+
+			LOG_INFO("Descriptor", "Grew the {} descriptor heap from {} to {} descriptors",
+				GetTypeName(descriptor_buffer.type), descriptor_buffer.num_descriptors, num_descriptors);
+
+			descriptor_buffer.num_descriptors = num_descriptors;
+			descriptor_buffer.allocator.Grow(num_descriptors);
+
+			return true;
+		}
+
+		static void WriteDescriptor(const VulkanDescriptorAllocation& descriptors, uint32_t descriptor_offset, const VkDescriptorGetInfoEXT& descriptor_info)
+		{
+			const DescriptorBuffer& descriptor_buffer = GetDescriptorBuffer(descriptors.type, descriptors.frame_index);
+			size_t byte_offset = (size_t)(descriptors.descriptor_offset + descriptor_offset) * descriptors.descriptor_size_in_bytes;
+			uint8_t* ptr_descriptor = descriptor_buffer.ptr_mem + byte_offset;
+
+			vk_inst.pFunc.get_descriptor_ext(vk_inst.device, &descriptor_info, descriptors.descriptor_size_in_bytes, ptr_descriptor);
+
+			for (const RetiredDescriptorBuffer& retired_buffer : data.retired_buffers)
+			{
+				if (retired_buffer.mirror_writes && retired_buffer.type == descriptors.type &&
+					byte_offset < (size_t)retired_buffer.num_descriptors * descriptors.descriptor_size_in_bytes)
+				{
+					memcpy(retired_buffer.ptr_mem + byte_offset, ptr_descriptor, descriptors.descriptor_size_in_bytes);
+				}
+			}
+		}
+
 		static VkDescriptorBufferBindingInfoEXT GetDescriptorBufferBindingInfo(VulkanDescriptorType type, uint32_t frame_index)
 		{
 			const DescriptorBuffer& descriptor_buffer = GetDescriptorBuffer(type, frame_index);
@@ -125,16 +272,19 @@ namespace Vulkan
 		{
 			uint32_t current_type = VULKAN_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 
-			// Create the descriptor type buffers and their free lists from which we will allocate
+			// Create the descriptor type buffers and their allocators
 			for (uint32_t buffer = 0; buffer < data.descriptor_buffers.size(); ++buffer)
 			{
 				// Create the descriptor set layout
 				std::vector<VkDescriptorSetLayoutBinding> bindings;
+				std::vector<VkDescriptorBindingFlags> binding_flags;
 				uint32_t num_descriptors_in_buffer = 0;
+				uint32_t max_descriptors_in_buffer = 0;
 
 				if (buffer < MAX_FRAMES_IN_FLIGHT)
 				{
 					num_descriptors_in_buffer = RESERVED_DESCRIPTOR_UBO_COUNT;
+					max_descriptors_in_buffer = RESERVED_DESCRIPTOR_UBO_COUNT;
 					bindings.resize(num_descriptors_in_buffer);
 
 					for (uint32_t ubo = 0; ubo < bindings.size(); ++ubo)
@@ -148,20 +298,24 @@ namespace Vulkan
 				}
 				else
 				{
-					num_descriptors_in_buffer = DESCRIPTOR_BUFFER_DEFAULT_DESCRIPTOR_COUNT;
 					current_type++;
+					max_descriptors_in_buffer = GetDescriptorHeapMaxDescriptorCount((VulkanDescriptorType)current_type);
+					num_descriptors_in_buffer = std::min(DESCRIPTOR_HEAP_INITIAL_DESCRIPTOR_COUNT[current_type], max_descriptors_in_buffer);
 
+					// The layout declares the maximum heap size, the buffer only holds the descriptors the heap has grown to so far
 					bindings.resize(1);
 					bindings[0].binding = 0;
-					bindings[0].descriptorCount = num_descriptors_in_buffer;
+					bindings[0].descriptorCount = max_descriptors_in_buffer;
 					bindings[0].descriptorType = GetVkDescriptorType((VulkanDescriptorType)current_type);
 					bindings[0].pImmutableSamplers = nullptr;
 					bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+
+					binding_flags.push_back(VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
 				}
 
 				VkDescriptorSetLayoutBindingFlagsCreateInfo binding_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO };
-				binding_info.bindingCount = 0;
-				binding_info.pBindingFlags = nullptr;
+				binding_info.bindingCount = static_cast<uint32_t>(binding_flags.size());
+				binding_info.pBindingFlags = binding_flags.data();
 
 				VkDescriptorSetLayoutCreateInfo layout_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
 				layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
@@ -172,216 +326,132 @@ namespace Vulkan
 				VkDescriptorSetLayout vk_descriptor_set_layout = VK_NULL_HANDLE;
 				Vulkan::VkCheckResult(vkCreateDescriptorSetLayout(vk_inst.device, &layout_info, nullptr, &vk_descriptor_set_layout));
 
+				// For a variable descriptor count binding, the layout size assumes the maximum count, the heap buffer only needs the current count
 				uint64_t descriptor_layout_byte_size;
 				vk_inst.pFunc.get_descriptor_set_layout_size_ext(vk_inst.device, vk_descriptor_set_layout, &descriptor_layout_byte_size);
-
-				// Create the underlying descriptor buffer resource
-				Flags buffer_usage_flags = current_type != VULKAN_DESCRIPTOR_TYPE_SAMPLER ? BUFFER_USAGE_RESOURCE_DESCRIPTORS : BUFFER_USAGE_SAMPLER_DESCRIPTORS;
-				BufferCreateInfo buffer_info = {
-					.usage_flags = buffer_usage_flags,
-					.memory_flags = GPU_MEMORY_HOST_VISIBLE | GPU_MEMORY_HOST_COHERENT,
-					.size_in_bytes = descriptor_layout_byte_size,
-					.name = "Descriptor Buffer"
-				};
+				if (buffer >= MAX_FRAMES_IN_FLIGHT)
+				{
+					descriptor_layout_byte_size = (uint64_t)num_descriptors_in_buffer * GetDescriptorTypeByteSize((VulkanDescriptorType)current_type);
+				}
 
 				// Create the descriptor buffer
 				DescriptorBuffer& descriptor_buffer = data.descriptor_buffers[buffer];
-				descriptor_buffer.buffer = Buffer::Create(buffer_info);
-				descriptor_buffer.ptr_mem = reinterpret_cast<uint8_t*>(DeviceMemory::Map(descriptor_buffer.buffer.memory, descriptor_layout_byte_size, 0));
 				descriptor_buffer.type = (VulkanDescriptorType)current_type;
 				descriptor_buffer.vk_descriptor_set_layout = vk_descriptor_set_layout;
+				CreateDescriptorHeapBuffer(descriptor_buffer, descriptor_layout_byte_size);
 
 				descriptor_buffer.num_descriptors = num_descriptors_in_buffer;
+				descriptor_buffer.max_descriptors = max_descriptors_in_buffer;
 				descriptor_buffer.descriptor_size_in_bytes = GetDescriptorTypeByteSize(descriptor_buffer.type);
 
-				// Allocate the head of the free-list for this descriptor buffer
-				FreeDescriptorBlock* head = new FreeDescriptorBlock();
-				head->num_descriptors = descriptor_buffer.num_descriptors;
-				head->descriptor_offset = 0;
-				head->ptr_next = nullptr;
-				descriptor_buffer.head = head;
+				descriptor_buffer.allocator = DescriptorAllocator(descriptor_buffer.num_descriptors);
 			}
 		}
 
-		static uint32_t AllocateDescriptors(VulkanDescriptorType type, uint32_t num_descriptors, uint32_t frame_index)
-		{
-			DescriptorBuffer& descriptor_buffer = GetDescriptorBuffer(type, frame_index);
-			FreeDescriptorBlock* previous_block = nullptr;
-			FreeDescriptorBlock* free_block = descriptor_buffer.head;
+		/*
+			============================ PUBLIC INTERFACE FUNCTIONS =================================
+		*/
 
-			while (free_block)
+		void Init()
+		{
+			// Every descriptor type is bound as a separate descriptor buffer, of which only the sampler one holds sampler descriptors
+			uint32_t num_descriptor_buffer_bindings = VULKAN_DESCRIPTOR_TYPE_NUM_TYPES;
+			if (num_descriptor_buffer_bindings > vk_inst.descriptor_limits.max_descriptor_buffer_bindings ||
+				num_descriptor_buffer_bindings - 1 > vk_inst.descriptor_limits.max_resource_descriptor_buffer_bindings ||
+				vk_inst.descriptor_limits.max_sampler_descriptor_buffer_bindings < 1)
 			{
-				// Free block fits the allocation request perfectly
-				if (free_block->num_descriptors == num_descriptors)
-				{
-					uint32_t alloc_offset = 0;
-
-					// Point the previous block to the next block of the current block
-					if (previous_block)
-					{
-						previous_block->ptr_next = free_block->ptr_next;
-						alloc_offset = free_block->descriptor_offset;
-						delete free_block;
-					}
-					// Point the descriptor buffer head to the next block of the current block
-					else
-					{
-						alloc_offset = descriptor_buffer.head->descriptor_offset;
-						descriptor_buffer.head = free_block->ptr_next;
-						delete free_block;
-					}
-
-					return alloc_offset;
-				}
-				// Free block can fit the allocation, resize it
-				else if (free_block->num_descriptors > num_descriptors)
-				{
-					uint32_t alloc_offset = free_block->descriptor_offset;
-					free_block->num_descriptors -= num_descriptors;
-					free_block->descriptor_offset += num_descriptors;
-
-					return alloc_offset;
-				}
-
-				previous_block = free_block;
-				free_block = free_block->ptr_next;
+				VK_EXCEPT("Descriptor::Init", "The device does not support binding {} descriptor buffers at the same time", num_descriptor_buffer_bindings);
 			}
 
-			VK_EXCEPT("Descriptor::AllocateDescriptors", "Could not find a free block large enough to fit the requested amount of descriptors");
-			return UINT64_MAX;
+			CreateDescriptorBuffers();
 		}
 
-		static void FreeDescriptors(VulkanDescriptorType type, uint32_t offset_in_descriptors, uint32_t num_descriptors, uint32_t frame_index)
+		void Exit()
 		{
-			DescriptorBuffer& descriptor_buffer = GetDescriptorBuffer(type, frame_index);
-			FreeDescriptorBlock* previous_block = nullptr;
-			FreeDescriptorBlock* free_block = descriptor_buffer.head;
-
-			if (!free_block)
+			for (uint32_t i = 0; i < data.descriptor_buffers.size(); ++i)
 			{
-				// If there is no free block at all, it means that the whole freelist is allocated/occupied
-				// So we need to create a new free block at the head
-				FreeDescriptorBlock* new_block = new FreeDescriptorBlock();
-				new_block->num_descriptors = num_descriptors;
-				new_block->descriptor_offset = offset_in_descriptors;
-				new_block->ptr_next = nullptr;
-
-				descriptor_buffer.head = new_block;
-				return;
+				DescriptorBuffer& descriptor_buffer = data.descriptor_buffers[i];
+				descriptor_buffer.allocator = DescriptorAllocator();
+
+				vkDestroyDescriptorSetLayout(vk_inst.device, descriptor_buffer.vk_descriptor_set_layout, nullptr);
+				Vulkan::DeviceMemory::Unmap(descriptor_buffer.buffer.memory);
+				Vulkan::Buffer::Destroy(descriptor_buffer.buffer);
 			}
 
-			while (free_block)
+			for (RetiredDescriptorBuffer& retired_buffer : data.retired_buffers)
 			{
-				// If the current free block is on the left of the descriptors to be freed,
-				// the descriptors to be freed can be appended to the right of it
-				if (free_block->descriptor_offset + free_block->num_descriptors == offset_in_descriptors)
-				{
-					free_block->num_descriptors += num_descriptors;
+				DestroyRetiredDescriptorBuffer(retired_buffer);
+			}
+			data.retired_buffers.clear();
+		}
 
-					// If the free block after our merged one is now directly adjacent, merge it in as well
-					if (free_block->ptr_next &&
-						free_block->ptr_next->descriptor_offset == free_block->descriptor_offset + free_block->num_descriptors)
-					{
-						free_block->num_descriptors += free_block->ptr_next->num_descriptors;
-						FreeDescriptorBlock* next_block = free_block->ptr_next;
-						free_block->ptr_next = next_block->ptr_next;
-					}
+		void BeginFrame()
+		{
+			// Descriptors freed and heap buffers replaced during a frame can still be used by that frame and the frames in flight before it
+			uint32_t current_frame_index = GetCurrentFrameIndex();
+			uint32_t num_frames_in_flight = GetNumFramesInFlight();
+			if (current_frame_index >= num_frames_in_flight)
+			{
+				uint32_t finished_frame_index = current_frame_index - num_frames_in_flight;
 
-					return;
-				}
-				// Need a new free descriptor block to be inserted
-				else if (free_block->descriptor_offset > offset_in_descriptors)
+				for (DescriptorBuffer& descriptor_buffer : data.descriptor_buffers)
 				{
-					FreeDescriptorBlock* new_block = new FreeDescriptorBlock();
-					new_block->num_descriptors = num_descriptors;
-					new_block->descriptor_offset = offset_in_descriptors;
+					descriptor_buffer.allocator.ReleaseFrees(finished_frame_index);
+				}
 
-					// If there is a previous block, append the new block to the chain
-					if (previous_block)
-					{
-						previous_block->ptr_next = new_block;
-						new_block->ptr_next = free_block;
-					}
-					// If there is no previous block, append the new block to the head
-					else
-					{
-						new_block->ptr_next = free_block;
-						descriptor_buffer.head = new_block;
-					}
+				std::erase_if(data.retired_buffers, [finished_frame_index](RetiredDescriptorBuffer& retired_buffer)
+				{
+					if (retired_buffer.frame_index > finished_frame_index)
+						return false;
 
-					// Check if the new block and the block after can be merged
-					if (new_block->ptr_next &&
-						new_block->descriptor_offset + new_block->num_descriptors == new_block->ptr_next->descriptor_offset)
-					{
-						new_block->num_descriptors += new_block->ptr_next->num_descriptors;
-						FreeDescriptorBlock* next_block = new_block->ptr_next;
-						new_block->ptr_next = next_block->ptr_next;
-						delete next_block;
-					}
+					DestroyRetiredDescriptorBuffer(retired_buffer);
+					return true;
+				});
+			}
 
-					// Check if the new block and the block before can be merged
-					if (previous_block &&
-						previous_block->descriptor_offset + previous_block->num_descriptors == new_block->descriptor_offset)
-					{
-						previous_block->num_descriptors += new_block->num_descriptors;
-						previous_block->ptr_next = new_block->ptr_next;
-						delete new_block;
-					}
+			// Nothing has been recorded yet this frame, so every command buffer will bind the current heap buffers
+			for (RetiredDescriptorBuffer& retired_buffer : data.retired_buffers)
+			{
+				retired_buffer.mirror_writes = false;
+			}
 
-					return;
-				}
-				else if (free_block->descriptor_offset == offset_in_descriptors)
+			// Grow heaps that are running low here, so that they rarely have to grow halfway through recording a frame
+			for (uint32_t buffer = MAX_FRAMES_IN_FLIGHT; buffer < data.descriptor_buffers.size(); ++buffer)
+			{
+				DescriptorBuffer& descriptor_buffer = data.descriptor_buffers[buffer];
+				if (descriptor_buffer.allocator.GetNumFreeDescriptors() < descriptor_buffer.num_descriptors / DESCRIPTOR_HEAP_GROW_FREE_DIVISOR)
 				{
-					VK_EXCEPT("Descriptor::FreeDescriptors", "Tried to free the same descriptor allocation multiple times");
+					GrowDescriptorBuffer(descriptor_buffer, descriptor_buffer.num_descriptors + 1, false);
 				}
-
-				previous_block = free_block;
-				free_block = free_block->ptr_next;
 			}
-
-			VK_EXCEPT("Descriptor::FreeDescriptors", "Unable to free descriptor block, which should always be possible");
 		}
 
-		/*
-			============================ PUBLIC INTERFACE FUNCTIONS =================================
-		*/
-
-		void Init()
+		VulkanDescriptorAllocation Allocate(VulkanDescriptorType type, uint32_t num_descriptors, uint32_t frame_index)
 		{
-			CreateDescriptorBuffers();
-		}
+			DescriptorBuffer& descriptor_buffer = GetDescriptorBuffer(type, frame_index);
 
-		void Exit()
-		{
-			for (uint32_t i = 0; i < data.descriptor_buffers.size(); ++i)
+			uint32_t descriptor_offset = descriptor_buffer.allocator.Allocate(num_descriptors);
+			if (descriptor_offset == DescriptorAllocator::INVALID_OFFSET)
 			{
-				DescriptorBuffer& descriptor_buffer = data.descriptor_buffers[i];
-				FreeDescriptorBlock* current_block = descriptor_buffer.head;
-
-				while (current_block)
+				// Growing by at least the requested amount guarantees a fit, since the new descriptors are appended to the end of the heap
+				if (GrowDescriptorBuffer(descriptor_buffer, descriptor_buffer.num_descriptors + num_descriptors, true))
 				{
-					// Free all free blocks remaining in the descriptor buffers
-					FreeDescriptorBlock* next_block = current_block->ptr_next;
-					delete current_block;
-					current_block = next_block;
+					descriptor_offset = descriptor_buffer.allocator.Allocate(num_descriptors);
 				}
-
-				vkDestroyDescriptorSetLayout(vk_inst.device, descriptor_buffer.vk_descriptor_set_layout, nullptr);
-				Vulkan::DeviceMemory::Unmap(descriptor_buffer.buffer.memory);
-				Vulkan::Buffer::Destroy(descriptor_buffer.buffer);
 			}
-		}
 
-		VulkanDescriptorAllocation Allocate(VulkanDescriptorType type, uint32_t num_descriptors, uint32_t frame_index)
-		{
-			const DescriptorBuffer& descriptor_buffer = GetDescriptorBuffer(type, frame_index);
+			if (descriptor_offset == DescriptorAllocator::INVALID_OFFSET)
+			{
+				VK_EXCEPT("Descriptor::Allocate", "Could not allocate {} descriptors, the {} descriptor heap is full at {} descriptors",
+					num_descriptors, GetTypeName(type), descriptor_buffer.num_descriptors);
+			}
 
 			VulkanDescriptorAllocation alloc = {};
 			alloc.type = type;
 			alloc.num_descriptors = num_descriptors;
 			alloc.descriptor_size_in_bytes = GetDescriptorTypeByteSize(type);
-			alloc.descriptor_offset = AllocateDescriptors(type, num_descriptors, frame_index);
-			alloc.ptr = descriptor_buffer.ptr_mem + alloc.descriptor_offset * alloc.descriptor_size_in_bytes;
+			alloc.descriptor_offset = descriptor_offset;
+			alloc.frame_index = type == VULKAN_DESCRIPTOR_TYPE_UNIFORM_BUFFER ? frame_index : 0;
 
 			return alloc;
 		}
@@ -391,14 +461,12 @@ namespace Vulkan
 			if (!IsValid(alloc))
 				return;
 
-			FreeDescriptors(alloc.type, alloc.descriptor_offset, alloc.num_descriptors, frame_index);
+			GetDescriptorBuffer(alloc.type, frame_index).allocator.Free(alloc.descriptor_offset, alloc.num_descriptors, GetCurrentFrameIndex());
 			alloc = {};
 		}
 
 		void Write(const VulkanDescriptorAllocation& descriptors, const VulkanBuffer& buffer, uint32_t descriptor_offset)
 		{
-			uint8_t* ptr_descriptor = descriptors.ptr + descriptor_offset * descriptors.descriptor_size_in_bytes;
-
 			VkDescriptorGetInfoEXT descriptor_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT };
 			descriptor_info.type = GetVkDescriptorType(descriptors.type);
 
@@ -430,17 +498,13 @@ namespace Vulkan
 				VK_EXCEPT("Descriptor::Write", "Tried to write a buffer descriptor for an invalid descriptor type");
 			}
 
-			size_t descriptor_size = GetDescriptorTypeByteSize(descriptors.type);
-			vk_inst.pFunc.get_descriptor_ext(vk_inst.device, &descriptor_info, descriptor_size, ptr_descriptor);
+			WriteDescriptor(descriptors, descriptor_offset, descriptor_info);
 		}
 
 		void Write(const VulkanDescriptorAllocation& descriptors, const VulkanImageView& view, VkImageLayout layout, uint32_t descriptor_offset)
 		{
-			uint8_t* ptr_descriptor = descriptors.ptr + descriptor_offset * descriptors.descriptor_size_in_bytes;
-
 			VkDescriptorGetInfoEXT descriptor_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT };
 			descriptor_info.type = GetVkDescriptorType(descriptors.type);
-			size_t descriptor_size = GetDescriptorTypeByteSize(descriptors.type);
 
 			VkDescriptorImageInfo descriptor_image_info = {};
 			descriptor_image_info.imageView = view.vk_image_view;
@@ -461,13 +525,11 @@ namespace Vulkan
 				VK_EXCEPT("Descriptor::Write", "Tried to write an image descriptor for an invalid descriptor type");
 			}
 
-			vk_inst.pFunc.get_descriptor_ext(vk_inst.device, &descriptor_info, descriptor_size, ptr_descriptor);
+			WriteDescriptor(descriptors, descriptor_offset, descriptor_info);
 		}
 
 		void Write(const VulkanDescriptorAllocation& descriptors, const VulkanSampler& sampler, uint32_t descriptor_offset)
 		{
-			uint8_t* ptr_descriptor = descriptors.ptr + descriptor_offset * descriptors.descriptor_size_in_bytes;
-
 			VkDescriptorGetInfoEXT descriptor_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT };
 			descriptor_info.type = GetVkDescriptorType(descriptors.type);
 
@@ -481,8 +543,7 @@ namespace Vulkan
 				VK_EXCEPT("Descriptor::Write", "Tried to write a sampler descriptor for an invalid descriptor type");
 			}
 
-			size_t descriptor_size = GetDescriptorTypeByteSize(descriptors.type);
-			vk_inst.pFunc.get_descriptor_ext(vk_inst.device, &descriptor_info, descriptor_size, ptr_descriptor);
+			WriteDescriptor(descriptors, descriptor_offset, descriptor_info);
 		}
 
 		bool IsValid(const VulkanDescriptorAllocation& alloc)
@@ -490,11 +551,44 @@ namespace Vulkan
 			return (
 				alloc.type != VULKAN_DESCRIPTOR_TYPE_NUM_TYPES &&
 				alloc.num_descriptors > 0 &&
-				alloc.descriptor_size_in_bytes > 0 &&
-				alloc.ptr
+				alloc.descriptor_size_in_bytes > 0
 			);
 		}
 
+		HeapStats GetHeapStats(VulkanDescriptorType type)
+		{
+			const DescriptorBuffer& descriptor_buffer = GetDescriptorBuffer(type, Vulkan::GetCurrentFrameIndex() % Vulkan::GetNumFramesInFlight());
+
+			HeapStats stats = {};
+			stats.num_descriptors = descriptor_buffer.num_descriptors;
+			stats.num_free_descriptors = descriptor_buffer.allocator.GetNumFreeDescriptors();
+			stats.max_descriptors = descriptor_buffer.max_descriptors;
+			stats.size_in_bytes = (uint64_t)descriptor_buffer.num_descriptors * descriptor_buffer.descriptor_size_in_bytes;
+
+			return stats;
+		}
+
+		const char* GetTypeName(VulkanDescriptorType type)
+		{
+			switch (type)
+			{
+			case VULKAN_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+				return "Uniform buffer";
+			case VULKAN_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+				return "Storage buffer";
+			case VULKAN_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+				return "Storage image";
+			case VULKAN_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+				return "Sampled image";
+			case VULKAN_DESCRIPTOR_TYPE_SAMPLER:
+				return "Sampler";
+			case VULKAN_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE:
+				return "Acceleration structure";
+			default:
+				VK_EXCEPT("Descriptor::GetTypeName", "Tried to get the name of an unknown descriptor type");
+			}
+		}
+
 		std::vector<VkDescriptorSetLayout> GetDescriptorSetLayouts()
 		{
 			std::vector<VkDescriptorSetLayout> descriptor_set_layouts;
@@ -515,7 +609,7 @@ namespace Vulkan
 			// Bind the descriptor buffers
 			std::vector<VkDescriptorBufferBindingInfoEXT> descriptor_buffer_binding_infos(VULKAN_DESCRIPTOR_TYPE_NUM_TYPES);
 			for (uint32_t i = 0; i < VULKAN_DESCRIPTOR_TYPE_NUM_TYPES; ++i)
-				descriptor_buffer_binding_infos[i] = GetDescriptorBufferBindingInfo((VulkanDescriptorType)i, Vulkan::GetCurrentFrameIndex() % MAX_FRAMES_IN_FLIGHT);
+				descriptor_buffer_binding_infos[i] = GetDescriptorBufferBindingInfo((VulkanDescriptorType)i, Vulkan::GetCurrentFrameIndex() % Vulkan::GetNumFramesInFlight());
 
 			vk_inst.pFunc.cmd_bind_descriptor_buffers_ext(command_buffer.vk_command_buffer,
 				static_cast<uint32_t>(descriptor_buffer_binding_infos.size()), descriptor_buffer_binding_infos.data());
@@ -9,6 +9,15 @@ namespace Vulkan
 	namespace DeviceMemory
 	{
 
+		static Stats stats;
+
+		static void TrackAllocation(uint64_t byte_size)
+		{
+			stats.num_allocations++;
+			stats.allocated_bytes += byte_size;
+			stats.peak_allocated_bytes = std::max(stats.peak_allocated_bytes, stats.allocated_bytes);
+		}
+
 		VulkanMemory Allocate(const VulkanBuffer& buffer, const BufferCreateInfo& buffer_info)
 		{
 			VkMemoryRequirements mem_req = {};
@@ -33,7 +42,9 @@ namespace Vulkan
 			memory.vk_device_memory = vk_device_memory;
 			memory.vk_memory_flags = Util::ToVkMemoryPropertyFlags(buffer_info.memory_flags);
 			memory.vk_memory_index = alloc_info.memoryTypeIndex;
+			memory.byte_size = alloc_info.allocationSize;
 
+			TrackAllocation(memory.byte_size);
 			return memory;
 		}
 
@@ -61,7 +72,30 @@ namespace Vulkan
 			memory.vk_device_memory = vk_device_memory;
 			memory.vk_memory_flags = Util::ToVkMemoryPropertyFlags(GPU_MEMORY_DEVICE_LOCAL);
 			memory.vk_memory_index = alloc_info.memoryTypeIndex;
+			memory.byte_size = alloc_info.allocationSize;
+
+			TrackAllocation(memory.byte_size);
+			return memory;
+		}
+
+		VulkanMemory Allocate(const VkMemoryRequirements& memory_req, Flags memory_flags, const std::string& name)
+		{
+			VkMemoryAllocateInfo alloc_info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+			alloc_info.allocationSize = memory_req.size;
+			alloc_info.memoryTypeIndex = Util::FindMemoryType(memory_req.memoryTypeBits, Util::ToVkMemoryPropertyFlags(memory_flags));
+
+			VkDeviceMemory vk_device_memory = VK_NULL_HANDLE;
+			VkCheckResult(vkAllocateMemory(vk_inst.device, &alloc_info, nullptr, &vk_device_memory));
+
+			Vulkan::DebugNameObject((uint64_t)vk_device_memory, VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT, name);
+
+			VulkanMemory memory = {};
+			memory.vk_device_memory = vk_device_memory;
+			memory.vk_memory_flags = Util::ToVkMemoryPropertyFlags(memory_flags);
+			memory.vk_memory_index = alloc_info.memoryTypeIndex;
+			memory.byte_size = alloc_info.allocationSize;
 
+			TrackAllocation(memory.byte_size);
 			return memory;
 		}
 
@@ -71,6 +105,9 @@ namespace Vulkan
 				return;
 
 			vkFreeMemory(vk_inst.device, memory.vk_device_memory, nullptr);
+			stats.num_allocations--;
+			stats.allocated_bytes -= memory.byte_size;
+
 			memory = {};
 		}
 
@@ -87,6 +124,11 @@ namespace Vulkan
 			vkUnmapMemory(vk_inst.device, memory.vk_device_memory);
 		}
 
+		Stats GetStats()
+		{
+			return stats;
+		}
+
 	}
 
 }
@@ -11,7 +11,7 @@ namespace Vulkan
 	namespace Image
 	{
 
-		VulkanImage Create(const TextureCreateInfo& texture_info)
+		VulkanImage Create(const TextureCreateInfo& texture_info, bool allocate_memory)
 		{
 			VkImageCreateInfo vk_image_info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
 			vk_image_info.imageType = VK_IMAGE_TYPE_2D;
@@ -26,6 +26,15 @@ namespace Vulkan
 			vk_image_info.usage = Util::ToVkImageUsageFlags(texture_info.usage_flags);
 			vk_image_info.samples = VK_SAMPLE_COUNT_1_BIT;
 			vk_image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			// Textures used by both the graphics and the async compute queue use concurrent sharing, which avoids queue family ownership transfers
+			uint32_t queue_family_indices[] = { vk_inst.queues.graphics_compute.queue_family_index, vk_inst.queues.compute.queue_family_index };
+			if (texture_info.async_compute_shared && queue_family_indices[0] != queue_family_indices[1])
+			{
+				vk_image_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+				vk_image_info.queueFamilyIndexCount = 2;
+				vk_image_info.pQueueFamilyIndices = queue_family_indices;
+			}
 			vk_image_info.flags = texture_info.dimension == TEXTURE_DIMENSION_CUBE ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
 
 			VkImage vk_image = VK_NULL_HANDLE;
@@ -40,7 +49,8 @@ namespace Vulkan
 			image.depth = vk_image_info.extent.depth;
 			image.num_mips = vk_image_info.mipLevels;
 			image.num_layers = vk_image_info.arrayLayers;
-			image.memory = DeviceMemory::Allocate(image, texture_info);
+			if (allocate_memory)
+				image.memory = DeviceMemory::Allocate(image, texture_info);
 
 			ResourceTracker::TrackImage(image, vk_image_info.initialLayout);
 
@@ -60,6 +70,12 @@ namespace Vulkan
 			image = {};
 		}
 
+		void BindMemory(const VulkanImage& image, const VulkanMemory& memory, uint64_t offset)
+		{
+			VK_ASSERT(!image.memory.vk_device_memory && "Tried to bind memory to an image that already owns its memory");
+			VkCheckResult(vkBindImageMemory(vk_inst.device, image.vk_image, memory.vk_device_memory, offset));
+		}
+
 		VkMemoryRequirements GetMemoryRequirements(const VulkanImage& image)
 		{
 			VkMemoryRequirements2 memory_req = { VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2 };
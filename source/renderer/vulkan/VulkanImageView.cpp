@@ -11,9 +11,13 @@ namespace Vulkan
 
 		VulkanImageView Create(const VulkanImage& image, const TextureViewCreateInfo& texture_view_info)
 		{
+			uint32_t num_layers = texture_view_info.num_layers == UINT32_MAX ? image.num_layers : texture_view_info.num_layers;
+			// A cube consumes 6 layers, it only becomes a cube array if the view contains more than one cube
+			uint32_t num_view_layers = texture_view_info.dimension == TEXTURE_DIMENSION_CUBE ? num_layers / 6 : num_layers;
+
 			VkImageViewCreateInfo vk_view_info = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
 			vk_view_info.image = image.vk_image;
-			vk_view_info.viewType = Util::ToVkViewType(texture_view_info.dimension);
+			vk_view_info.viewType = Util::ToVkViewType(texture_view_info.dimension, num_view_layers);
 			vk_view_info.format = Util::ToVkFormat(texture_view_info.format);
 			//vk_view_info.components.r = VK_COMPONENT_SWIZZLE_R;
 			//vk_view_info.components.g = VK_COMPONENT_SWIZZLE_G;
@@ -28,7 +32,7 @@ namespace Vulkan
 			vk_view_info.subresourceRange.baseMipLevel = texture_view_info.base_mip;
 			vk_view_info.subresourceRange.levelCount = texture_view_info.num_mips == UINT32_MAX ? image.num_mips : texture_view_info.num_mips;
 			vk_view_info.subresourceRange.baseArrayLayer = texture_view_info.base_layer;
-			vk_view_info.subresourceRange.layerCount = texture_view_info.num_layers == UINT32_MAX ? image.num_layers : texture_view_info.num_layers;
+			vk_view_info.subresourceRange.layerCount = num_layers;
 			vk_view_info.flags = 0;
 
 			VkImageView vk_image_view = VK_NULL_HANDLE;
@@ -37,7 +41,7 @@ namespace Vulkan
 			VulkanImageView image_view = {};
 			image_view.image = image;
 			image_view.vk_image_view = vk_image_view;
-			image_view.vk_image_view_type = Util::ToVkViewType(texture_view_info.dimension);
+			image_view.vk_image_view_type = vk_view_info.viewType;
 			image_view.base_mip = vk_view_info.subresourceRange.baseMipLevel;
 			image_view.num_mips = vk_view_info.subresourceRange.levelCount;
 			image_view.base_layer = vk_view_info.subresourceRange.baseArrayLayer;
@@ -0,0 +1,119 @@
+#include "Precomp.h"
+#include "renderer/vulkan/VulkanQuery.h"
+#include "renderer/vulkan/VulkanInstance.h"
+#include "renderer/vulkan/VulkanUtils.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace Vulkan
+{
+
+	namespace Query
+	{
+
+		VkQueryPool CreatePool(VkQueryType type, uint32_t num_queries, const std::string& name, VkQueryPipelineStatisticFlags statistic_flags)
+		{
+			VkQueryPoolCreateInfo query_pool_info = { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+			query_pool_info.queryType = type;
+			query_pool_info.queryCount = num_queries;
+			query_pool_info.pipelineStatistics = statistic_flags;
+
+			VkQueryPool vk_query_pool = VK_NULL_HANDLE;
+			VkCheckResult(vkCreateQueryPool(vk_inst.device, &query_pool_info, nullptr, &vk_query_pool));
+			Vulkan::DebugNameObject((uint64_t)vk_query_pool, VK_DEBUG_REPORT_OBJECT_TYPE_QUERY_POOL_EXT, name.c_str());
+
+			return vk_query_pool;
+		}
+
+		void DestroyPool(VkQueryPool& vk_query_pool)
+		{
+			if (!vk_query_pool)
+				return;
+
+			vkDestroyQueryPool(vk_inst.device, vk_query_pool, nullptr);
+			vk_query_pool = VK_NULL_HANDLE;
+		}
+
+		void ResetPool(VkQueryPool vk_query_pool, uint32_t first_query, uint32_t num_queries)
+		{
+			vkResetQueryPool(vk_inst.device, vk_query_pool, first_query, num_queries);
+		}
+
+		bool GetResults(VkQueryPool vk_query_pool, uint32_t first_query, uint32_t num_queries, uint32_t num_values_per_query, uint64_t* const results)
+		{
+			VkResult result = vkGetQueryPoolResults(vk_inst.device, vk_query_pool, first_query, num_queries,
+				num_queries * num_values_per_query * sizeof(uint64_t), results, num_values_per_query * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+			if (result == VK_NOT_READY)
+				return false;
+
+			VkCheckResult(result);
+			return true;
+		}
+
+		double TimestampsToMs(uint64_t begin_timestamp, uint64_t end_timestamp)
+		{
+			if (end_timestamp <= begin_timestamp)
+				return 0.0;
+
+			return static_cast<double>(end_timestamp - begin_timestamp) * vk_inst.device_props.timestamp_period / 1000000.0;
+		}
+
+		// Host timestamps are in the units of HOST_TIME_DOMAIN, which has the same epoch as std::chrono::steady_clock
+		static std::chrono::steady_clock::time_point HostTimestampToSteadyClock(uint64_t host_timestamp)
+		{
+#ifdef _WIN32
+			static const uint64_t qpc_frequency = []()
+			{
+				LARGE_INTEGER frequency = {};
+				QueryPerformanceFrequency(&frequency);
+				return (uint64_t)frequency.QuadPart;
+			}();
+
+			// Split into whole seconds and the remainder, like steady_clock does, so that the conversion to nanoseconds does not overflow
+			std::chrono::nanoseconds time_since_epoch((host_timestamp / qpc_frequency) * 1000000000ull + (host_timestamp % qpc_frequency) * 1000000000ull / qpc_frequency);
+#else
+			std::chrono::nanoseconds time_since_epoch(host_timestamp);
+#endif
+			return std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(time_since_epoch));
+		}
+
+		// The driver reports how far apart the samples of one call can be, samples that exceed this are taken again, and dropped if none of them are precise enough
+		static constexpr uint64_t CALIBRATED_TIMESTAMP_MAX_DEVIATION_NS = 100000;
+		static constexpr uint32_t CALIBRATED_TIMESTAMP_MAX_ATTEMPTS = 4;
+
+		bool GetCalibratedTimestamp(uint64_t& gpu_timestamp, std::chrono::steady_clock::time_point& cpu_time)
+		{
+			if (!vk_inst.device_props.calibrated_timestamps)
+				return false;
+
+			VkCalibratedTimestampInfoEXT timestamp_infos[2] = {};
+			timestamp_infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+			timestamp_infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+			timestamp_infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+			timestamp_infos[1].timeDomain = HOST_TIME_DOMAIN;
+
+			for (uint32_t attempt = 0; attempt < CALIBRATED_TIMESTAMP_MAX_ATTEMPTS; ++attempt)
+			{
+				uint64_t timestamps[2] = {};
+				uint64_t max_deviation = 0;
+				VkCheckResult(vk_inst.pFunc.get_calibrated_timestamps_ext(vk_inst.device, 2, timestamp_infos, timestamps, &max_deviation));
+
+				if (max_deviation <= CALIBRATED_TIMESTAMP_MAX_DEVIATION_NS)
+				{
+					gpu_timestamp = timestamps[0];
+					cpu_time = HostTimestampToSteadyClock(timestamps[1]);
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	}
+
+}
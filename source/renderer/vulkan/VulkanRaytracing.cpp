@@ -4,6 +4,7 @@
 #include "renderer/vulkan/VulkanInstance.h"
 #include "renderer/vulkan/VulkanBuffer.h"
 #include "renderer/vulkan/VulkanDeviceMemory.h"
+#include "renderer/vulkan/VulkanCommands.h"
 
 namespace Vulkan
 {
@@ -11,7 +12,7 @@ namespace Vulkan
 	namespace Raytracing
 	{
 
-		VulkanBuffer BuildBLAS(const VulkanCommandBuffer& command_buffer, const VulkanBuffer& vertex_buffer, const VulkanBuffer& index_buffer, VulkanBuffer& scratch_buffer,
+		VulkanBuffer BuildBLAS(VulkanCommandBuffer& command_buffer, const VulkanBuffer& vertex_buffer, const VulkanBuffer& index_buffer, VulkanBuffer& scratch_buffer,
 			uint32_t num_vertices, uint32_t vertex_stride, uint32_t num_triangles, VkIndexType index_type, const std::string& name)
 		{
 			/*VkTransformMatrixKHR transform = {
@@ -57,7 +58,7 @@ namespace Vulkan
 				VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR, &blas_build_info, &num_triangles, &blas_build_sizes);
 
 			// Create the BLAS buffer
-			VulkanBuffer blas_buffer = Buffer::CreateAccelerationStructure(blas_build_sizes.accelerationStructureSize, name);
+			VulkanBuffer blas_buffer = Buffer::CreateAccelerationStructure(blas_build_sizes.accelerationStructureSize, name, true);
 
 			VkAccelerationStructureCreateInfoKHR acceleration_structure_info = { VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR };
 			acceleration_structure_info.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
@@ -83,6 +84,8 @@ namespace Vulkan
 			build_range_info.transformOffset = 0;
 			std::vector<VkAccelerationStructureBuildRangeInfoKHR*> build_range_infos = { &build_range_info };
 
+			Command::FlushBarriers(command_buffer);
+
 			// Do the actual command for building the acceleration structure
 			vk_inst.pFunc.raytracing.cmd_build_acceleration_structures(
 				command_buffer.vk_command_buffer,
@@ -94,11 +97,9 @@ namespace Vulkan
 			return blas_buffer;
 		}
 
-		VulkanBuffer BuildTLAS(const VulkanCommandBuffer& command_buffer, VulkanBuffer& scratch_buffer, VulkanBuffer& instance_buffer,
-			uint32_t num_blas, const VulkanBuffer* const blas_buffers, const VkTransformMatrixKHR* const blas_transforms, const std::string& name)
+		void PackTLASInstances(uint32_t num_blas, const VulkanBuffer* const blas_buffers, const VkTransformMatrixKHR* const blas_transforms,
+			VkAccelerationStructureInstanceKHR* const instances)
 		{
-			// Get the acceleration structure geometry data for each BLAS
-			std::vector<VkAccelerationStructureInstanceKHR> instances(num_blas);
 			for (uint32_t i = 0; i < num_blas; ++i)
 			{
 				VkAccelerationStructureInstanceKHR& instance = instances[i];
@@ -109,6 +110,14 @@ namespace Vulkan
 				instance.instanceShaderBindingTableRecordOffset = 0;
 				instance.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
 			}
+		}
+
+		VulkanBuffer BuildTLAS(VulkanCommandBuffer& command_buffer, VulkanBuffer& scratch_buffer, VulkanBuffer& instance_buffer,
+			uint32_t num_blas, const VulkanBuffer* const blas_buffers, const VkTransformMatrixKHR* const blas_transforms, const std::string& name)
+		{
+			// Get the acceleration structure geometry data for each BLAS
+			std::vector<VkAccelerationStructureInstanceKHR> instances(num_blas);
+			PackTLASInstances(num_blas, blas_buffers, blas_transforms, instances.data());
 			
 			// Create the instance buffer and write the BLAS instances
 			uint64_t instance_buffer_byte_size = num_blas * sizeof(VkAccelerationStructureInstanceKHR);
@@ -168,6 +177,8 @@ namespace Vulkan
 			build_range_info.transformOffset = 0;
 			std::vector<VkAccelerationStructureBuildRangeInfoKHR*> build_range_infos = { &build_range_info };
 
+			Command::FlushBarriers(command_buffer);
+
 			vk_inst.pFunc.raytracing.cmd_build_acceleration_structures(
 				command_buffer.vk_command_buffer,
 				1,
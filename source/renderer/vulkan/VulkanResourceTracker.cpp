@@ -30,12 +30,45 @@ namespace Vulkan
 			VulkanFence fence;
 		};
 
+		// Tracked resources are stored in flat arrays indexed by the tracking index stored in the buffer or image itself,
+		// removed slots are kept in a free list and reused by the next resource that starts being tracked
 		struct Data
 		{
-			std::unordered_map<VkBuffer, TrackedBuffer> tracked_buffers;
-			std::unordered_map<VkImage, TrackedImage> tracked_images;
+			std::vector<TrackedBuffer> tracked_buffers;
+			std::vector<uint32_t> free_buffer_indices;
+
+			std::vector<TrackedImage> tracked_images;
+			std::vector<uint32_t> free_image_indices;
 		} static* data;
 
+		template<typename T>
+		static uint32_t AllocateTrackingIndex(std::vector<T>& tracked, std::vector<uint32_t>& free_indices)
+		{
+			if (free_indices.empty())
+			{
+				tracked.emplace_back();
+				return static_cast<uint32_t>(tracked.size() - 1);
+			}
+
+			uint32_t index = free_indices.back();
+			free_indices.pop_back();
+			return index;
+		}
+
+		static TrackedBuffer& GetTrackedBuffer(const VulkanBuffer& buffer)
+		{
+			VK_ASSERT(buffer.tracking_index < data->tracked_buffers.size() &&
+				data->tracked_buffers[buffer.tracking_index].buffer.vk_buffer == buffer.vk_buffer && "Tried to access a buffer that has not been tracked");
+			return data->tracked_buffers[buffer.tracking_index];
+		}
+
+		static TrackedImage& GetTrackedImage(const VulkanImage& image)
+		{
+			VK_ASSERT(image.tracking_index < data->tracked_images.size() &&
+				data->tracked_images[image.tracking_index].image.vk_image == image.vk_image && "Tried to access an image that has not been tracked");
+			return data->tracked_images[image.tracking_index];
+		}
+
 		void Init()
 		{
 			data = new Data();
@@ -46,32 +79,28 @@ namespace Vulkan
 			delete data;
 		}
 
-		void TrackBuffer(const VulkanBuffer& buffer)
+		void TrackBuffer(VulkanBuffer& buffer)
 		{
-			auto tracked = data->tracked_buffers.find(buffer.vk_buffer);
-			VK_ASSERT(tracked == data->tracked_buffers.end() && "Tracked a buffer that was already being tracked");
+			VK_ASSERT(buffer.tracking_index == UINT32_MAX && "Tracked a buffer that was already being tracked");
 
-			if (tracked == data->tracked_buffers.end())
-			{
-				data->tracked_buffers.emplace(buffer.vk_buffer, TrackedBuffer{ .buffer = buffer });
-			}
+			buffer.tracking_index = AllocateTrackingIndex(data->tracked_buffers, data->free_buffer_indices);
+			data->tracked_buffers[buffer.tracking_index] = TrackedBuffer{ .buffer = buffer };
 		}
 
 		void TrackBufferTemp(const VulkanBuffer& buffer, const VulkanFence& fence, uint64_t fence_value)
 		{
-			auto tracked = data->tracked_buffers.find(buffer.vk_buffer);
-			VK_ASSERT(tracked != data->tracked_buffers.end() && "Tried to add temporary tracking to a buffer that was not previously tracked");
-
-			tracked->second.fence = fence;
-			tracked->second.fence.fence_value = fence_value;
+			TrackedBuffer& tracked_buffer = GetTrackedBuffer(buffer);
+			tracked_buffer.fence = fence;
+			tracked_buffer.fence.fence_value = fence_value;
 		}
 
 		void RemoveBuffer(const VulkanBuffer& buffer)
 		{
-			VK_ASSERT(data->tracked_buffers.find(buffer.vk_buffer) != data->tracked_buffers.end() &&
-				"Tried to remove a buffer from being tracked that was already not tracked");
+			// NOTE: The buffer might be a reference to the tracked buffer itself, so the index needs to be read before the slot is cleared
+			uint32_t tracking_index = buffer.tracking_index;
+			GetTrackedBuffer(buffer) = {};
 
-			data->tracked_buffers.erase(buffer.vk_buffer);
+			data->free_buffer_indices.push_back(tracking_index);
 		}
 
 		VkBufferMemoryBarrier2 BufferMemoryBarrier(const VulkanBufferBarrier& barrier)
@@ -94,50 +123,42 @@ namespace Vulkan
 
 		void UpdateBufferAccessAndStageFlags(const VulkanBufferBarrier& barrier)
 		{
-			auto tracked = data->tracked_buffers.find(barrier.buffer.vk_buffer);
-			VK_ASSERT(tracked != data->tracked_buffers.end() && "Tried to update access and stage flags for a buffer that has not been tracked");
-
-			tracked->second.last_access_flags = barrier.dst_access_flags;
-			tracked->second.last_stage_flags = barrier.dst_stage_flags;
+			TrackedBuffer& tracked_buffer = GetTrackedBuffer(barrier.buffer);
+			tracked_buffer.last_access_flags = barrier.dst_access_flags;
+			tracked_buffer.last_stage_flags = barrier.dst_stage_flags;
 		}
 
-		void TrackImage(const VulkanImage& image, VkImageLayout layout)
+		void TrackImage(VulkanImage& image, VkImageLayout layout)
 		{
-			auto tracked = data->tracked_images.find(image.vk_image);
-			VK_ASSERT(tracked == data->tracked_images.end() && "Tracked an image that was already being tracked");
-
-			if (tracked == data->tracked_images.end())
-			{
-				data->tracked_images.emplace(image.vk_image, TrackedImage{
-						.image = image,
-						.last_stage_flags = VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
-						.layout = layout
-					}
-				);
-			}
+			VK_ASSERT(image.tracking_index == UINT32_MAX && "Tracked an image that was already being tracked");
+
+			image.tracking_index = AllocateTrackingIndex(data->tracked_images, data->free_image_indices);
+			data->tracked_images[image.tracking_index] = TrackedImage{
+				.image = image,
+				.last_stage_flags = VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
+				.layout = layout
+			};
 		}
 
 		void TrackImageTemp(const VulkanImage& image, const VulkanFence& fence, uint64_t fence_value)
 		{
-			auto tracked = data->tracked_images.find(image.vk_image);
-			VK_ASSERT(tracked != data->tracked_images.end() && "Tried to add temporary tracking to an image that was not previously tracked");
-			
-			tracked->second.fence = fence;
-			tracked->second.fence.fence_value = fence_value;
+			TrackedImage& tracked_image = GetTrackedImage(image);
+			tracked_image.fence = fence;
+			tracked_image.fence.fence_value = fence_value;
 		}
 
 		void RemoveImage(const VulkanImage& image)
 		{
-			VK_ASSERT(data->tracked_images.find(image.vk_image) != data->tracked_images.end() &&
-				"Tried to remove an image from being tracked that was already not tracked");
+			// NOTE: The image might be a reference to the tracked image itself, so the index needs to be read before the slot is cleared
+			uint32_t tracking_index = image.tracking_index;
+			GetTrackedImage(image) = {};
 
-			data->tracked_images.erase(image.vk_image);
+			data->free_image_indices.push_back(tracking_index);
 		}
 
 		VkImageMemoryBarrier2 ImageMemoryBarrier(const VulkanImageBarrier& barrier)
 		{
-			VK_ASSERT(data->tracked_images.find(barrier.image.vk_image) != data->tracked_images.end() && "Tried to create an image memory barrier for an image that has not been tracked");
-			auto& tracked_image = data->tracked_images.at(barrier.image.vk_image);
+			TrackedImage& tracked_image = GetTrackedImage(barrier.image);
 
 			uint32_t num_mips = barrier.num_mips == UINT32_MAX ? tracked_image.image.num_mips : barrier.num_mips;
 			uint32_t num_layers = barrier.num_layers == UINT32_MAX ? tracked_image.image.num_layers : barrier.num_layers;
@@ -178,8 +199,7 @@ namespace Vulkan
 
 		void UpdateImageAccessAndStageFlags(const VulkanImageBarrier& barrier)
 		{
-			VK_ASSERT(data->tracked_images.find(barrier.image.vk_image) != data->tracked_images.end() && "Tried to create an image memory barrier for an image that has not been tracked");
-			auto& tracked_image = data->tracked_images.at(barrier.image.vk_image);
+			TrackedImage& tracked_image = GetTrackedImage(barrier.image);
 
 			uint32_t num_mips = barrier.num_mips == UINT32_MAX ? tracked_image.image.num_mips : barrier.num_mips;
 			uint32_t num_layers = barrier.num_layers == UINT32_MAX ? tracked_image.image.num_layers : barrier.num_layers;
@@ -213,8 +233,7 @@ namespace Vulkan
 
 		VkImageLayout GetImageLayout(const VulkanImageBarrier& barrier)
 		{
-			VK_ASSERT(data->tracked_images.find(barrier.image.vk_image) != data->tracked_images.end() && "Tried to retrieve the image layout for an image that has not been tracked");
-			auto& tracked_image = data->tracked_images.at(barrier.image.vk_image);
+			TrackedImage& tracked_image = GetTrackedImage(barrier.image);
 
 			uint32_t num_mips = barrier.num_mips == UINT32_MAX ? tracked_image.image.num_mips : barrier.num_mips;
 			uint32_t num_layers = barrier.num_layers == UINT32_MAX ? tracked_image.image.num_layers : barrier.num_layers;
@@ -248,21 +267,23 @@ namespace Vulkan
 
 		void ReleaseStaleTempResources()
 		{
-			for (auto it = data->tracked_buffers.begin(); it != data->tracked_buffers.end(); ++it)
+			for (uint32_t i = 0; i < data->tracked_buffers.size(); ++i)
 			{
-				if (it->second.fence.vk_semaphore &&
-					it->second.fence.fence_value <= Vulkan::Sync::GetFenceValue(it->second.fence))
+				const TrackedBuffer& tracked_buffer = data->tracked_buffers[i];
+				if (tracked_buffer.fence.vk_semaphore &&
+					tracked_buffer.fence.fence_value <= Vulkan::Sync::GetFenceValue(tracked_buffer.fence))
 				{
-					it = data->tracked_buffers.erase(it);
+					RemoveBuffer(tracked_buffer.buffer);
 				}
 			}
 
-			for (auto it = data->tracked_images.begin(); it != data->tracked_images.end(); ++it)
+			for (uint32_t i = 0; i < data->tracked_images.size(); ++i)
 			{
-				if (it->second.fence.vk_semaphore &&
-					it->second.fence.fence_value <= Vulkan::Sync::GetFenceValue(it->second.fence))
+				const TrackedImage& tracked_image = data->tracked_images[i];
+				if (tracked_image.fence.vk_semaphore &&
+					tracked_image.fence.fence_value <= Vulkan::Sync::GetFenceValue(tracked_image.fence))
 				{
-					it = data->tracked_images.erase(it);
+					RemoveImage(tracked_image.image);
 				}
 			}
 		}
@@ -103,7 +103,8 @@ namespace Vulkan
 			VkSurfaceFormatKHR surface_format = ChooseSwapChainFormat(swapchain_support.formats);
 			VkExtent2D extent = ChooseSwapChainExtent(output_width, output_height, swapchain_support.capabilities);
 
-			uint32_t image_count = swapchain_support.capabilities.minImageCount;
+			// One more image than frames in flight, so that the CPU can record a new frame while the others are queued for presentation
+			uint32_t image_count = std::max(swapchain_support.capabilities.minImageCount, vk_inst.num_frames_in_flight + 1);
 			if (swapchain_support.capabilities.maxImageCount > 0 && image_count > swapchain_support.capabilities.maxImageCount)
 			{
 				image_count = swapchain_support.capabilities.maxImageCount;
@@ -138,11 +139,26 @@ namespace Vulkan
 
 			create_info.preTransform = swapchain_support.capabilities.currentTransform;
 			create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-			create_info.presentMode = vk_inst.swapchain.desired_present_mode;
+			vk_inst.swapchain.supported_present_modes = swapchain_support.present_modes;
+			if (!IsPresentModeSupported(vk_inst.swapchain.desired_present_mode))
+			{
+				// FIFO is the only present mode that is required to be supported
+				vk_inst.swapchain.desired_present_mode = VK_PRESENT_MODE_FIFO_KHR;
+			}
+			vk_inst.swapchain.present_mode = vk_inst.swapchain.desired_present_mode;
+
+			create_info.presentMode = vk_inst.swapchain.present_mode;
 			create_info.clipped = VK_TRUE;
 			create_info.oldSwapchain = VK_NULL_HANDLE;
 
-			std::vector<VkPresentModeKHR> present_modes = { VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_MAILBOX_KHR };
+			// FIFO and MAILBOX can be switched between without recreating the swapchain, the tearing present modes need their own swapchain
+			std::vector<VkPresentModeKHR>& present_modes = vk_inst.swapchain.compatible_present_modes;
+			present_modes = { vk_inst.swapchain.present_mode };
+			if (vk_inst.swapchain.present_mode == VK_PRESENT_MODE_FIFO_KHR && IsPresentModeSupported(VK_PRESENT_MODE_MAILBOX_KHR))
+				present_modes.push_back(VK_PRESENT_MODE_MAILBOX_KHR);
+			else if (vk_inst.swapchain.present_mode == VK_PRESENT_MODE_MAILBOX_KHR)
+				present_modes.push_back(VK_PRESENT_MODE_FIFO_KHR);
+
 			VkSwapchainPresentModesCreateInfoEXT present_modes_create_info = { VK_STRUCTURE_TYPE_SWAPCHAIN_PRESENT_MODES_CREATE_INFO_EXT };
 			present_modes_create_info.presentModeCount = static_cast<uint32_t>(present_modes.size());
 			present_modes_create_info.pPresentModes = present_modes.data();
@@ -153,20 +169,26 @@ namespace Vulkan
 			// If pSwapchainImages is nullptr, it will instead return the pSwapchainImageCount, so we query this first
 			VkCheckResult(vkGetSwapchainImagesKHR(vk_inst.device, vk_inst.swapchain.swapchain, &image_count, nullptr));
 
-			std::vector<VkImage> vk_swapchain_images(Vulkan::MAX_FRAMES_IN_FLIGHT);
+			std::vector<VkImage> vk_swapchain_images(image_count);
 			VkCheckResult(vkGetSwapchainImagesKHR(vk_inst.device, vk_inst.swapchain.swapchain, &image_count, vk_swapchain_images.data()));
 
 			vk_inst.swapchain.extent = extent;
 			vk_inst.swapchain.format = create_info.imageFormat;
 
-			vk_inst.swapchain.image_available_fences.resize(MAX_FRAMES_IN_FLIGHT);
-			vk_inst.swapchain.images.resize(image_count);
+			vk_inst.swapchain.recreate = false;
 
+			// The image available fences are indexed by frame, the images by the index returned from acquire
+			vk_inst.swapchain.image_available_fences.resize(MAX_FRAMES_IN_FLIGHT);
 			for (size_t i = 0; i < Vulkan::MAX_FRAMES_IN_FLIGHT; ++i)
 			{
 				vk_inst.swapchain.image_available_fences[i] = Sync::CreateFence(VULKAN_FENCE_TYPE_BINARY);
+			}
 
+			vk_inst.swapchain.images.resize(image_count);
+			for (size_t i = 0; i < image_count; ++i)
+			{
 				VulkanImage& swapchain_image = vk_inst.swapchain.images[i];
+				swapchain_image = {};
 				swapchain_image.vk_image = vk_swapchain_images[i];
 				swapchain_image.memory = {};
 				swapchain_image.vk_format = vk_inst.swapchain.format;
@@ -182,9 +204,12 @@ namespace Vulkan
 
 		void Destroy()
 		{
-			for (size_t i = 0; i < Vulkan::MAX_FRAMES_IN_FLIGHT; ++i)
+			for (size_t i = 0; i < vk_inst.swapchain.images.size(); ++i)
 			{
 				ResourceTracker::RemoveImage(vk_inst.swapchain.images[i]);
+			}
+			for (size_t i = 0; i < vk_inst.swapchain.image_available_fences.size(); ++i)
+			{
 				Sync::DestroyFence(vk_inst.swapchain.image_available_fences[i]);
 			}
 
@@ -194,7 +219,7 @@ namespace Vulkan
 		VkResult AcquireNextImage()
 		{
 			VkResult image_result = vkAcquireNextImageKHR(vk_inst.device, vk_inst.swapchain.swapchain, UINT64_MAX,
-				vk_inst.swapchain.image_available_fences[vk_inst.current_frame_index % MAX_FRAMES_IN_FLIGHT].vk_semaphore, VK_NULL_HANDLE, &vk_inst.swapchain.current_image);
+				vk_inst.swapchain.image_available_fences[vk_inst.current_frame_index % vk_inst.num_frames_in_flight].vk_semaphore, VK_NULL_HANDLE, &vk_inst.swapchain.current_image);
 
 			return image_result;
 		}
@@ -224,7 +249,7 @@ namespace Vulkan
 
 			VkSwapchainPresentModeInfoEXT present_mode_info = { VK_STRUCTURE_TYPE_SWAPCHAIN_PRESENT_MODE_INFO_EXT };
 			present_mode_info.swapchainCount = 1;
-			present_mode_info.pPresentModes = &vk_inst.swapchain.desired_present_mode;
+			present_mode_info.pPresentModes = &vk_inst.swapchain.present_mode;
 			present_mode_info.pNext = nullptr;
 
 			present_info.pNext = &present_mode_info;
@@ -233,24 +258,39 @@ namespace Vulkan
 			return present_result;
 		}
 
-		void SetVSync(bool enabled)
+		void SetPresentMode(VkPresentModeKHR present_mode)
 		{
-			bool changed = vk_inst.swapchain.vsync_enabled != enabled;
+			if (present_mode == vk_inst.swapchain.desired_present_mode)
+				return;
 
-			if (changed)
+			if (!IsPresentModeSupported(present_mode))
 			{
-				vk_inst.swapchain.vsync_enabled = enabled;
+				LOG_WARN("Vulkan::SwapChain", "Present mode {} is not supported by the surface", (uint32_t)present_mode);
+				return;
+			}
 
-				if (vk_inst.swapchain.vsync_enabled)
-					vk_inst.swapchain.desired_present_mode = VK_PRESENT_MODE_FIFO_KHR;
-				else
-					vk_inst.swapchain.desired_present_mode = VK_PRESENT_MODE_MAILBOX_KHR;
+			vk_inst.swapchain.desired_present_mode = present_mode;
+
+			const std::vector<VkPresentModeKHR>& compatible_modes = vk_inst.swapchain.compatible_present_modes;
+			if (std::find(compatible_modes.begin(), compatible_modes.end(), present_mode) != compatible_modes.end())
+			{
+				vk_inst.swapchain.present_mode = present_mode;
 			}
+			else
+			{
+				vk_inst.swapchain.recreate = true;
+			}
+		}
+
+		VkPresentModeKHR GetPresentMode()
+		{
+			return vk_inst.swapchain.desired_present_mode;
 		}
 
-		bool IsVSyncEnabled()
+		bool IsPresentModeSupported(VkPresentModeKHR present_mode)
 		{
-			return vk_inst.swapchain.vsync_enabled;
+			const std::vector<VkPresentModeKHR>& supported_modes = vk_inst.swapchain.supported_present_modes;
+			return std::find(supported_modes.begin(), supported_modes.end(), present_mode) != supported_modes.end();
 		}
 
 	}
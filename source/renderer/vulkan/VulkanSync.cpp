@@ -66,6 +66,27 @@ namespace Vulkan
 			return (fence.fence_value >= GetFenceValue(fence));
 		}
 
+		VkEvent CreateDeviceEvent(const std::string& name)
+		{
+			VkEventCreateInfo event_info = { VK_STRUCTURE_TYPE_EVENT_CREATE_INFO };
+			event_info.flags = VK_EVENT_CREATE_DEVICE_ONLY_BIT;
+
+			VkEvent vk_event = VK_NULL_HANDLE;
+			VkCheckResult(vkCreateEvent(vk_inst.device, &event_info, nullptr, &vk_event));
+			Vulkan::DebugNameObject((uint64_t)vk_event, VK_DEBUG_REPORT_OBJECT_TYPE_EVENT_EXT, name.c_str());
+
+			return vk_event;
+		}
+
+		void DestroyDeviceEvent(VkEvent& vk_event)
+		{
+			if (!vk_event)
+				return;
+
+			vkDestroyEvent(vk_inst.device, vk_event, nullptr);
+			vk_event = VK_NULL_HANDLE;
+		}
+
 	}
 
 }
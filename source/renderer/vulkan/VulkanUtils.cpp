@@ -57,6 +57,8 @@ namespace Vulkan
 				vk_mem_property_flags |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
 			if (memory_flags & GPU_MEMORY_HOST_COHERENT)
 				vk_mem_property_flags |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			if (memory_flags & GPU_MEMORY_HOST_CACHED)
+				vk_mem_property_flags |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
 
 			return vk_mem_property_flags;
 		}
@@ -126,6 +128,8 @@ namespace Vulkan
 				return VK_FORMAT_R32G32B32A32_SFLOAT;
 			case TEXTURE_FORMAT_RG16_SFLOAT:
 				return VK_FORMAT_R16G16_SFLOAT;
+			case TEXTURE_FORMAT_RG32_UINT:
+				return VK_FORMAT_R32G32_UINT;
 			case TEXTURE_FORMAT_D32_SFLOAT:
 				return VK_FORMAT_D32_SFLOAT;
 			}
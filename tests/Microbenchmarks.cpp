@@ -0,0 +1,513 @@
+#include "Precomp.h"
+#include "TestData.h"
+#include "ResourceSlotmap.h"
+#include "FileIO.h"
+#include "renderer/Renderer.h"
+#include "renderer/RingBuffer.h"
+#include "renderer/DescriptorAllocator.h"
+#include "renderer/vulkan/VulkanRaytracing.h"
+#include "renderer/vulkan/VulkanInstance.h"
+#include "AABBTree.h"
+#include "FrustumCulling.h"
+#include "Scene.h"
+#include "assets/AssetTypes.h"
+
+#include <random>
+#include <functional>
+
+/*
+
+	Micro-benchmarks for the hot CPU paths of the renderer data structures, reporting the time and number of heap allocations per operation
+	This is a separate executable that does not need a Vulkan device, the backend calls are mocked in VulkanMocks.cpp and RendererMocks.cpp
+
+	Usage: Microbenchmarks [--output FILE]
+
+*/
+
+// Heap allocations are counted by replacing the global operator new, which costs a single relaxed atomic load while nothing is measured
+static std::atomic<bool> count_heap_allocations = false;
+static std::atomic<uint64_t> num_heap_allocations = 0;
+
+void* operator new(std::size_t num_bytes)
+{
+	if (count_heap_allocations.load(std::memory_order_relaxed))
+		num_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+
+	void* ptr = malloc(num_bytes > 0 ? num_bytes : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+void* operator new[](std::size_t num_bytes)
+{
+	return operator new(num_bytes);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	free(ptr);
+}
+
+namespace Microbenchmarks
+{
+
+	static constexpr uint64_t NUM_OPS_SCALES[] = { 10000, 100000, 1000000 };
+
+	struct Result
+	{
+		std::string name;
+		uint64_t num_ops = 0;
+		double total_ms = 0.0;
+		uint64_t num_heap_allocations = 0;
+	};
+
+	static std::vector<Result> results;
+	// Written to after every benchmark that only reads, so that the compiler cannot remove the reads
+	static volatile uint64_t benchmark_sink = 0;
+
+	// Calls the function once, which should do num_ops operations, and records how long it took and how many heap allocations it made
+	static void Measure(const std::string& name, uint64_t num_ops, const std::function<void()>& func)
+	{
+		num_heap_allocations.store(0, std::memory_order_relaxed);
+		count_heap_allocations.store(true, std::memory_order_relaxed);
+
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		func();
+		std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - begin;
+
+		count_heap_allocations.store(false, std::memory_order_relaxed);
+
+		Result result = {};
+		result.name = name;
+		result.num_ops = std::max<uint64_t>(num_ops, 1);
+		result.total_ms = duration.count();
+		result.num_heap_allocations = num_heap_allocations.load(std::memory_order_relaxed);
+
+		LOG_INFO("Microbenchmarks", "{}: {:.2f} ns/op, {} heap allocations", result.name,
+			result.total_ms * 1000000.0 / result.num_ops, result.num_heap_allocations);
+		results.push_back(result);
+	}
+
+	static void RunSlotmapBenchmarks()
+	{
+		for (uint64_t num_ops : NUM_OPS_SCALES)
+		{
+			ResourceSlotmap<uint64_t> slotmap(num_ops);
+			std::vector<ResourceHandle_t> handles(num_ops);
+
+			Measure(std::format("ResourceSlotmap::Insert ({})", num_ops), num_ops, [&]()
+			{
+				for (uint64_t i = 0; i < num_ops; ++i)
+					handles[i] = slotmap.Emplace(i);
+			});
+
+			std::shuffle(handles.begin(), handles.end(), std::mt19937(TestData::RANDOM_SEED));
+
+			Measure(std::format("ResourceSlotmap::Find, random order ({})", num_ops), num_ops, [&]()
+			{
+				uint64_t sum = 0;
+				for (uint64_t i = 0; i < num_ops; ++i)
+					sum += *slotmap.Find(handles[i]);
+
+				benchmark_sink = sum;
+			});
+
+			Measure(std::format("ResourceSlotmap::Delete, random order ({})", num_ops), num_ops, [&]()
+			{
+				for (uint64_t i = 0; i < num_ops; ++i)
+					slotmap.Delete(handles[i]);
+			});
+
+			// Half full slotmap where random resources are replaced, which scatters the free-list over the slots
+			uint64_t num_live = num_ops / 2;
+			for (uint64_t i = 0; i < num_live; ++i)
+				handles[i] = slotmap.Emplace(i);
+
+			std::vector<uint32_t> random_numbers = TestData::GenerateRandomNumbers(num_ops);
+
+			Measure(std::format("ResourceSlotmap::Delete + Insert, random ({})", num_ops), num_ops, [&]()
+			{
+				for (uint64_t i = 0; i < num_ops; ++i)
+				{
+					uint64_t live_index = random_numbers[i] % num_live;
+					slotmap.Delete(handles[live_index]);
+					handles[live_index] = slotmap.Emplace(i);
+				}
+			});
+
+			Measure(std::format("ResourceSlotmap::ForEach, half full ({})", num_live), num_live, [&]()
+			{
+				uint64_t sum = 0;
+				slotmap.ForEach([&sum](ResourceHandle_t, uint64_t& resource)
+				{
+					sum += resource;
+				});
+
+				benchmark_sink = sum;
+			});
+		}
+
+		// Without a reserved capacity, so every page is added while inserting
+		for (uint64_t num_ops : NUM_OPS_SCALES)
+		{
+			ResourceSlotmap<uint64_t> slotmap(0);
+
+			Measure(std::format("ResourceSlotmap::Insert, growing from empty ({})", num_ops), num_ops, [&]()
+			{
+				for (uint64_t i = 0; i < num_ops; ++i)
+					slotmap.Emplace(i);
+			});
+		}
+
+		// Loader threads creating resources at the same time, the measured time includes starting and joining the threads
+		uint32_t num_threads = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+		for (uint64_t num_ops : NUM_OPS_SCALES)
+		{
+			ShardedResourceSlotmap<uint64_t> slotmap;
+			uint64_t num_ops_per_thread = num_ops / num_threads;
+
+			Measure(std::format("ShardedResourceSlotmap::Insert, {} threads ({})", num_threads, num_ops), num_ops_per_thread * num_threads, [&]()
+			{
+				std::vector<std::thread> threads;
+				for (uint32_t thread = 0; thread < num_threads; ++thread)
+				{
+					threads.emplace_back([&slotmap, num_ops_per_thread]()
+					{
+						for (uint64_t i = 0; i < num_ops_per_thread; ++i)
+							slotmap.Emplace(i);
+					});
+				}
+
+				for (std::thread& thread : threads)
+					thread.join();
+			});
+
+			if (slotmap.GetSize() != num_ops_per_thread * num_threads)
+			{
+				VK_EXCEPT("Microbenchmarks", "Sharded slotmap holds {} resources after inserting {}", slotmap.GetSize(), num_ops_per_thread * num_threads);
+			}
+		}
+	}
+
+	static constexpr uint32_t RING_BUFFER_NUM_FRAMES_IN_FLIGHT = 2;
+	static constexpr uint64_t RING_BUFFER_NUM_OPS_PER_FRAME = 256;
+
+	static void RunRingBufferBenchmarks()
+	{
+		// Smaller than the renderer's ring buffer, so that it wraps around a number of times at the larger scales
+		// The mocked frame index is advanced every RING_BUFFER_NUM_OPS_PER_FRAME allocations, so flushing frees the allocations
+		// of the frames that have finished on the mocked GPU, and the ones still in flight have to be kept like in the renderer
+		RingBuffer ring_buffer(VK_MB(64ull));
+		Vulkan::vk_inst.num_frames_in_flight = RING_BUFFER_NUM_FRAMES_IN_FLIGHT;
+
+		for (uint64_t num_ops : NUM_OPS_SCALES)
+		{
+			std::vector<uint32_t> random_numbers = TestData::GenerateRandomNumbers(num_ops);
+
+			Measure(std::format("RingBuffer::Allocate, 16 to 4096 bytes ({})", num_ops), num_ops, [&]()
+			{
+				for (uint64_t i = 0; i < num_ops; ++i)
+				{
+					if (i % RING_BUFFER_NUM_OPS_PER_FRAME == 0)
+						Vulkan::vk_inst.current_frame_index++;
+
+					uint64_t num_bytes = 16 + random_numbers[i] % 4081;
+					ring_buffer.Allocate(num_bytes);
+				}
+			});
+		}
+
+		Vulkan::vk_inst.current_frame_index = 0;
+		Vulkan::vk_inst.num_frames_in_flight = 0;
+	}
+
+	static constexpr uint32_t DESCRIPTOR_ALLOCATOR_NUM_DESCRIPTORS = 16384;
+
+	static void RunDescriptorAllocatorBenchmarks()
+	{
+		for (uint64_t num_ops : NUM_OPS_SCALES)
+		{
+			std::vector<uint32_t> random_numbers = TestData::GenerateRandomNumbers(num_ops);
+			DescriptorAllocator allocator(DESCRIPTOR_ALLOCATOR_NUM_DESCRIPTORS);
+
+			Measure(std::format("DescriptorAllocator::Allocate/Free, random ({})", num_ops), num_ops, [&]()
+			{
+				TestData::SimulateDescriptorAllocations<false>(allocator, random_numbers);
+			});
+		}
+	}
+
+	static constexpr uint32_t AABB_TREE_NUM_INSTANCES = 100000;
+	static constexpr uint32_t AABB_TREE_NUM_FRUSTUM_QUERIES = 100;
+	static constexpr uint32_t AABB_TREE_NUM_RAY_QUERIES = 10000;
+	static constexpr uint32_t AABB_TREE_NUM_OVERLAP_QUERIES = 10000;
+
+	static void RunAABBTreeBenchmarks()
+	{
+		std::mt19937 rng(TestData::RANDOM_SEED);
+
+		std::vector<AABB> aabbs = TestData::GenerateRandomAABBs(rng, AABB_TREE_NUM_INSTANCES);
+		TestData::AABBTreeQueries queries = TestData::GenerateAABBTreeQueries(rng, AABB_TREE_NUM_FRUSTUM_QUERIES, AABB_TREE_NUM_OVERLAP_QUERIES, AABB_TREE_NUM_RAY_QUERIES);
+
+		std::vector<AABB> moved_aabbs = aabbs;
+		for (AABB& aabb : moved_aabbs)
+		{
+			glm::vec3 offset = TestData::RandomVec3(rng, -TestData::MAX_REFIT_OFFSET, TestData::MAX_REFIT_OFFSET);
+			aabb.min += offset;
+			aabb.max += offset;
+		}
+
+		std::vector<AABB> reinserted_aabbs = moved_aabbs;
+		for (AABB& aabb : reinserted_aabbs)
+		{
+			glm::vec3 offset = glm::normalize(TestData::RandomVec3(rng, -1.0f, 1.0f)) * TestData::REINSERT_OFFSET;
+			aabb.min += offset;
+			aabb.max += offset;
+		}
+
+		AABBTree tree;
+		Measure(std::format("AABBTree::Insert, build ({})", AABB_TREE_NUM_INSTANCES), AABB_TREE_NUM_INSTANCES, [&]()
+		{
+			for (uint32_t i = 0; i < AABB_TREE_NUM_INSTANCES; ++i)
+				tree.Insert(EntityHandle(i), aabbs[i]);
+		});
+
+		// Small moves stay inside the fattened bounds and large moves leave them, so the two paths of Update are measured separately
+		uint64_t num_reinserted = 0;
+		Measure(std::format("AABBTree::Update, inside the fattened bounds ({})", AABB_TREE_NUM_INSTANCES), AABB_TREE_NUM_INSTANCES, [&]()
+		{
+			for (uint32_t i = 0; i < AABB_TREE_NUM_INSTANCES; ++i)
+				num_reinserted += tree.Update(EntityHandle(i), moved_aabbs[i]);
+		});
+
+		if (num_reinserted != 0)
+		{
+			VK_EXCEPT("Microbenchmarks", "AABB tree reinserted {} of {} entities that stayed inside their fattened bounds", num_reinserted, AABB_TREE_NUM_INSTANCES);
+		}
+
+		Measure(std::format("AABBTree::Update, reinsert after leaving the fattened bounds ({})", AABB_TREE_NUM_INSTANCES), AABB_TREE_NUM_INSTANCES, [&]()
+		{
+			for (uint32_t i = 0; i < AABB_TREE_NUM_INSTANCES; ++i)
+				num_reinserted += tree.Update(EntityHandle(i), reinserted_aabbs[i]);
+		});
+
+		if (num_reinserted != AABB_TREE_NUM_INSTANCES)
+		{
+			VK_EXCEPT("Microbenchmarks", "AABB tree reinserted {} of {} entities that left their fattened bounds", num_reinserted, AABB_TREE_NUM_INSTANCES);
+		}
+		LOG_INFO("Microbenchmarks", "AABB tree height after reinserting every entity: {}", tree.GetHeight());
+
+		std::vector<EntityHandle> entities;
+		entities.reserve(AABB_TREE_NUM_INSTANCES);
+
+		uint64_t num_returned = 0;
+		Measure(std::format("AABBTree::QueryFrustum ({} entities)", AABB_TREE_NUM_INSTANCES), AABB_TREE_NUM_FRUSTUM_QUERIES, [&]()
+		{
+			for (const Frustum& frustum : queries.frustums)
+			{
+				entities.clear();
+				tree.QueryFrustum(frustum, entities);
+				num_returned += entities.size();
+			}
+		});
+		Measure(std::format("AABBTree::QueryOverlap ({} entities)", AABB_TREE_NUM_INSTANCES), AABB_TREE_NUM_OVERLAP_QUERIES, [&]()
+		{
+			for (const AABB& aabb : queries.overlap_aabbs)
+			{
+				entities.clear();
+				tree.QueryOverlap(aabb, entities);
+				num_returned += entities.size();
+			}
+		});
+		Measure(std::format("AABBTree::RayCast ({} entities)", AABB_TREE_NUM_INSTANCES), AABB_TREE_NUM_RAY_QUERIES, [&]()
+		{
+			for (uint32_t i = 0; i < AABB_TREE_NUM_RAY_QUERIES; ++i)
+				num_returned += tree.RayCast(queries.ray_origins[i], queries.ray_directions[i], TestData::RAY_LENGTH).index;
+		});
+		benchmark_sink = num_returned;
+	}
+
+	static constexpr uint32_t FRUSTUM_CULLING_NUM_FRUSTUMS = 10;
+	static constexpr uint32_t FRUSTUM_CULLING_MAX_THREADS = 8;
+
+	static void RunFrustumCullingBenchmarks()
+	{
+		std::mt19937 rng(TestData::RANDOM_SEED);
+
+		TestData::AABBTreeQueries queries = TestData::GenerateAABBTreeQueries(rng, FRUSTUM_CULLING_NUM_FRUSTUMS, 0, 0);
+		for (uint64_t num_ops : NUM_OPS_SCALES)
+		{
+			TestData::SoABoundingSpheres spheres = TestData::GenerateRandomBoundingSpheres(rng, (uint32_t)num_ops);
+			std::vector<uint32_t> visible_indices(num_ops);
+			uint64_t num_visible = 0;
+
+			Measure(std::format("FrustumCulling::CullSpheresScalar ({})", num_ops), num_ops * FRUSTUM_CULLING_NUM_FRUSTUMS, [&]()
+			{
+				for (const Frustum& frustum : queries.frustums)
+					num_visible += FrustumCulling::CullSpheresScalar(frustum, spheres.Get(), 0, (uint32_t)num_ops, visible_indices.data());
+			});
+			Measure(std::format("FrustumCulling::CullSpheres ({})", num_ops), num_ops * FRUSTUM_CULLING_NUM_FRUSTUMS, [&]()
+			{
+				for (const Frustum& frustum : queries.frustums)
+					num_visible += FrustumCulling::CullSpheres(frustum, spheres.Get(), 0, (uint32_t)num_ops, visible_indices.data());
+			});
+			Measure(std::format("FrustumCulling::CullSpheresParallel, up to {} threads ({})", FRUSTUM_CULLING_MAX_THREADS, num_ops), num_ops * FRUSTUM_CULLING_NUM_FRUSTUMS, [&]()
+			{
+				for (const Frustum& frustum : queries.frustums)
+					num_visible += FrustumCulling::CullSpheresParallel(frustum, spheres.Get(), (uint32_t)num_ops, visible_indices.data(), FRUSTUM_CULLING_MAX_THREADS);
+			});
+
+			benchmark_sink = num_visible;
+		}
+	}
+
+	static constexpr uint32_t SCENE_SERIALIZATION_NUM_ENTITIES = 50000;
+
+	static void RunSceneSerializationBenchmarks(const std::filesystem::path& output_filepath)
+	{
+		std::mt19937 rng(TestData::RANDOM_SEED);
+		std::filesystem::path scene_filepath = output_filepath.parent_path() / "microbenchmark_scene.vkscene";
+		std::filesystem::path json_filepath = output_filepath.parent_path() / "microbenchmark_scene.json";
+
+		Scene scene;
+		TestData::CreateRandomScene(scene, rng, SCENE_SERIALIZATION_NUM_ENTITIES);
+		std::vector<uint8_t> bytes = scene.Serialize();
+
+		Measure(std::format("Scene::Serialize ({} entities)", SCENE_SERIALIZATION_NUM_ENTITIES), SCENE_SERIALIZATION_NUM_ENTITIES, [&]()
+		{
+			bytes = scene.Serialize();
+		});
+		Measure(std::format("Scene::SaveToFile ({} entities)", SCENE_SERIALIZATION_NUM_ENTITIES), SCENE_SERIALIZATION_NUM_ENTITIES, [&]()
+		{
+			scene.SaveToFile(scene_filepath);
+		});
+		Measure(std::format("Scene::SaveToFile, unchanged ({} entities)", SCENE_SERIALIZATION_NUM_ENTITIES), SCENE_SERIALIZATION_NUM_ENTITIES, [&]()
+		{
+			scene.SaveToFile(scene_filepath);
+		});
+		Measure(std::format("Scene::ExportToJson ({} entities)", SCENE_SERIALIZATION_NUM_ENTITIES), SCENE_SERIALIZATION_NUM_ENTITIES, [&]()
+		{
+			scene.ExportToJson(json_filepath);
+		});
+		Measure(std::format("Scene::Deserialize ({} entities)", SCENE_SERIALIZATION_NUM_ENTITIES), SCENE_SERIALIZATION_NUM_ENTITIES, [&]()
+		{
+			scene.Deserialize(bytes);
+		});
+		Measure(std::format("Scene::LoadFromFile ({} entities)", SCENE_SERIALIZATION_NUM_ENTITIES), SCENE_SERIALIZATION_NUM_ENTITIES, [&]()
+		{
+			scene.LoadFromFile(scene_filepath);
+		});
+		benchmark_sink = scene.GetNumEntities();
+
+		scene.Clear();
+
+		std::error_code error;
+		std::filesystem::remove(scene_filepath, error);
+		std::filesystem::remove(json_filepath, error);
+	}
+
+	// Packs a full draw list worth of instances, the same way RenderFrame gathers the BLAS buffers and transforms before building the TLAS
+	// The device address lookup of every BLAS is mocked, so this only measures the packing itself
+	static constexpr uint32_t TLAS_NUM_INSTANCES = 10000;
+	static constexpr uint32_t TLAS_NUM_PACKS = 100;
+
+	static void RunTLASPackingBenchmarks()
+	{
+		std::mt19937 rng(TestData::RANDOM_SEED);
+
+		std::vector<VulkanBuffer> blas_buffers(TLAS_NUM_INSTANCES);
+		std::vector<VkTransformMatrixKHR> blas_transforms(TLAS_NUM_INSTANCES);
+		std::vector<VkAccelerationStructureInstanceKHR> tlas_instances(TLAS_NUM_INSTANCES);
+
+		for (uint32_t i = 0; i < TLAS_NUM_INSTANCES; ++i)
+		{
+			glm::mat4 transform = glm::translate(glm::identity<glm::mat4>(), TestData::RandomVec3(rng, -TestData::WORLD_EXTENT, TestData::WORLD_EXTENT));
+			transform = glm::transpose(transform);
+			memcpy(&blas_transforms[i], &transform, sizeof(VkTransformMatrixKHR));
+		}
+
+		Measure(std::format("Vulkan::Raytracing::PackTLASInstances ({})", TLAS_NUM_PACKS * TLAS_NUM_INSTANCES), TLAS_NUM_PACKS * TLAS_NUM_INSTANCES, [&]()
+		{
+			for (uint32_t pack = 0; pack < TLAS_NUM_PACKS; ++pack)
+				Vulkan::Raytracing::PackTLASInstances(TLAS_NUM_INSTANCES, blas_buffers.data(), blas_transforms.data(), tlas_instances.data());
+		});
+		benchmark_sink = tlas_instances.back().accelerationStructureReference;
+	}
+
+	static void WriteResults(const std::filesystem::path& output_filepath)
+	{
+		std::string json = "{\n\t\"results\": [\n";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const Result& result = results[i];
+			json += std::format("\t\t{{\"name\":\"{}\",\"num_ops\":{},\"total_ms\":{:.4f},\"ns_per_op\":{:.4f},\"heap_allocations\":{},\"heap_allocations_per_op\":{:.6f}}}{}\n",
+				result.name, result.num_ops, result.total_ms, result.total_ms * 1000000.0 / result.num_ops,
+				result.num_heap_allocations, (double)result.num_heap_allocations / result.num_ops, i + 1 < results.size() ? "," : "");
+		}
+		json += "\t]\n}\n";
+
+		if (FileIO::WriteBinary(output_filepath, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(json.data()), json.size())))
+			LOG_INFO("Microbenchmarks", "Wrote micro-benchmark results to {}", output_filepath.string());
+		else
+			LOG_WARN("Microbenchmarks", "Failed to write micro-benchmark results to {}", output_filepath.string());
+	}
+
+	static void Run(const std::filesystem::path& output_filepath)
+	{
+		results.clear();
+
+		RunSlotmapBenchmarks();
+		RunRingBufferBenchmarks();
+		RunDescriptorAllocatorBenchmarks();
+		RunAABBTreeBenchmarks();
+		RunFrustumCullingBenchmarks();
+		RunSceneSerializationBenchmarks(output_filepath);
+		RunTLASPackingBenchmarks();
+
+		WriteResults(output_filepath);
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	std::filesystem::path output_filepath = "benchmarks/microbenchmarks.json";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--output" && i + 1 < argc)
+			output_filepath = argv[++i];
+		else
+			LOG_WARN("Microbenchmarks", "Unknown argument: {}", arg);
+	}
+
+	try
+	{
+		Microbenchmarks::Run(output_filepath);
+	}
+	catch (const std::exception&)
+	{
+		// The exception has already been logged by VK_EXCEPT
+		return 1;
+	}
+
+	return 0;
+}
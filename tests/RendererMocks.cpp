@@ -0,0 +1,106 @@
+#include "Precomp.h"
+#include "renderer/Renderer.h"
+#include "assets/AssetManager.h"
+#include "ResourceSlotmap.h"
+#include "Input.h"
+
+/*
+
+	Stand-ins for the renderer, asset manager and input that the scene calls into, so that the scene can be created,
+	updated and serialized without a window or Vulkan device
+	Materials keep their parameters, so that a scene still serializes the same after being loaded again, nothing is drawn
+
+*/
+
+namespace Renderer
+{
+
+	static ResourceSlotmap<MaterialAsset> material_slotmap;
+
+	void ImGuiImage(RenderResourceHandle, float, float)
+	{
+	}
+
+	AABB GetMeshBounds(RenderResourceHandle)
+	{
+		// Same as the unit cube that the renderer falls back to
+		return { glm::vec3(-0.5f), glm::vec3(0.5f) };
+	}
+
+	RenderResourceHandle CreateMaterial(const MaterialAsset& material_asset)
+	{
+		return material_slotmap.Emplace(material_asset);
+	}
+
+	void DestroyMaterial(RenderResourceHandle handle)
+	{
+		material_slotmap.Delete(handle);
+	}
+
+	bool GetMaterialParameters(RenderResourceHandle handle, MaterialAsset& material_asset)
+	{
+		const MaterialAsset* material = material_slotmap.Find(handle);
+		if (!material)
+			return false;
+
+		material_asset = *material;
+		return true;
+	}
+
+	void ImGuiMaterialEditor(RenderResourceHandle)
+	{
+	}
+
+	void SubmitMeshes(std::span<const ResourceHandle_t>, std::span<const RenderResourceHandle>, std::span<const RenderResourceHandle>, std::span<const glm::mat4>)
+	{
+	}
+
+	void SubmitAreaLight(ResourceHandle_t, RenderResourceHandle, const glm::mat4&, const glm::vec3&, float, bool)
+	{
+	}
+
+}
+
+namespace AssetManager
+{
+
+	template<>
+	TextureAsset* GetAsset(AssetHandle)
+	{
+		return nullptr;
+	}
+
+	template<>
+	ModelAsset* GetAsset(AssetHandle)
+	{
+		return nullptr;
+	}
+
+}
+
+namespace Input
+{
+
+	float GetInputAxis1D(Key, Key)
+	{
+		return 0.0f;
+	}
+
+	void GetMousePositionRel(double& x, double& y)
+	{
+		x = 0.0;
+		y = 0.0;
+	}
+
+	void GetScrollRel(double& x, double& y)
+	{
+		x = 0.0;
+		y = 0.0;
+	}
+
+	bool IsCursorDisabled()
+	{
+		return false;
+	}
+
+}
@@ -0,0 +1,122 @@
+#include "Precomp.h"
+#include "TestData.h"
+#include "Scene.h"
+#include "renderer/Renderer.h"
+#include "assets/AssetTypes.h"
+
+namespace TestData
+{
+
+	std::vector<uint32_t> GenerateRandomNumbers(uint64_t count)
+	{
+		std::mt19937 rng(RANDOM_SEED);
+
+		std::vector<uint32_t> random_numbers(count);
+		for (uint32_t& random_number : random_numbers)
+			random_number = rng();
+
+		return random_numbers;
+	}
+
+	glm::vec3 RandomVec3(std::mt19937& rng, float min, float max)
+	{
+		std::uniform_real_distribution<float> distribution(min, max);
+
+		float x = distribution(rng);
+		float y = distribution(rng);
+		float z = distribution(rng);
+
+		return glm::vec3(x, y, z);
+	}
+
+	std::vector<AABB> GenerateRandomAABBs(std::mt19937& rng, uint32_t count)
+	{
+		std::vector<AABB> aabbs(count);
+		for (AABB& aabb : aabbs)
+		{
+			glm::vec3 center = RandomVec3(rng, -WORLD_EXTENT, WORLD_EXTENT);
+			glm::vec3 extent = RandomVec3(rng, MIN_INSTANCE_EXTENT, MAX_INSTANCE_EXTENT);
+			aabb = { center - extent, center + extent };
+		}
+
+		return aabbs;
+	}
+
+	AABBTreeQueries GenerateAABBTreeQueries(std::mt19937& rng, uint32_t num_frustums, uint32_t num_overlaps, uint32_t num_rays)
+	{
+		AABBTreeQueries queries = {};
+		for (uint32_t i = 0; i < num_frustums; ++i)
+		{
+			glm::vec3 eye = RandomVec3(rng, -WORLD_EXTENT, WORLD_EXTENT);
+			glm::vec3 target = RandomVec3(rng, -WORLD_EXTENT, WORLD_EXTENT);
+
+			glm::mat4 view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+			glm::mat4 proj = glm::perspectiveFov(glm::radians(60.0f), 1920.0f, 1080.0f, 0.1f, WORLD_EXTENT);
+			queries.frustums.push_back(Frustum::FromViewProjection(proj * view));
+		}
+		for (uint32_t i = 0; i < num_overlaps; ++i)
+		{
+			glm::vec3 center = RandomVec3(rng, -WORLD_EXTENT, WORLD_EXTENT);
+			queries.overlap_aabbs.push_back({ center - QUERY_EXTENT, center + QUERY_EXTENT });
+		}
+		for (uint32_t i = 0; i < num_rays; ++i)
+		{
+			queries.ray_origins.push_back(RandomVec3(rng, -WORLD_EXTENT, WORLD_EXTENT));
+			queries.ray_directions.push_back(glm::normalize(RandomVec3(rng, -1.0f, 1.0f)));
+		}
+
+		return queries;
+	}
+
+	SoABoundingSpheres GenerateRandomBoundingSpheres(std::mt19937& rng, uint32_t count)
+	{
+		std::uniform_real_distribution<float> radius_distribution(MIN_INSTANCE_EXTENT, MAX_INSTANCE_EXTENT);
+
+		SoABoundingSpheres spheres;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			glm::vec3 center = RandomVec3(rng, -WORLD_EXTENT, WORLD_EXTENT);
+			spheres.x.push_back(center.x);
+			spheres.y.push_back(center.y);
+			spheres.z.push_back(center.z);
+			spheres.radius.push_back(radius_distribution(rng));
+		}
+
+		return spheres;
+	}
+
+
+	void CreateRandomScene(Scene& scene, std::mt19937& rng, uint32_t num_entities)
+	{
+		std::uniform_real_distribution<float> unorm_distribution(0.0f, 1.0f);
+		EntityHandle group_entity;
+
+		for (uint32_t i = 0; i < num_entities; ++i)
+		{
+			glm::mat4 transform = glm::translate(glm::identity<glm::mat4>(), RandomVec3(rng, -WORLD_EXTENT, WORLD_EXTENT));
+			transform = glm::rotate(transform, unorm_distribution(rng) * glm::two_pi<float>(), glm::normalize(RandomVec3(rng, 0.1f, 1.0f)));
+			transform = glm::scale(transform, RandomVec3(rng, MIN_INSTANCE_EXTENT, MAX_INSTANCE_EXTENT));
+
+			uint32_t group_index = i % SCENE_GROUP_SIZE;
+			if (group_index == 0)
+			{
+				group_entity = scene.CreateEntity(std::format("Group {}", i / SCENE_GROUP_SIZE), transform);
+			}
+			else if (group_index == SCENE_GROUP_SIZE - 1)
+			{
+				glm::vec3 color = RandomVec3(rng, 0.0f, 1.0f);
+				scene.CreateAreaLightEntity(std::format("AreaLight {}", i), AssetHandle(), transform, color, unorm_distribution(rng) * 10.0f, i % 2 == 0, group_entity);
+			}
+			else
+			{
+				MaterialAsset material_asset;
+				material_asset.albedo_factor = glm::vec4(RandomVec3(rng, 0.0f, 1.0f), 1.0f);
+				material_asset.metallic_factor = unorm_distribution(rng);
+				material_asset.roughness_factor = unorm_distribution(rng);
+
+				scene.CreateMeshEntity(std::format("Mesh {}", i), RenderResourceHandle(), Renderer::CreateMaterial(material_asset), transform, group_entity);
+			}
+		}
+	}
+
+}
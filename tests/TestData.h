@@ -0,0 +1,190 @@
+#pragma once
+#include "renderer/DescriptorAllocator.h"
+#include "FrustumCulling.h"
+#include "AABBTree.h"
+#include "Geometry.h"
+
+#include <random>
+
+class Scene;
+
+/*
+
+	Deterministic random data shared by the tests and the micro-benchmarks
+	Every run uses the same seed, so that failures can be reproduced and benchmark results can be compared between runs
+
+*/
+
+namespace TestData
+{
+
+	static constexpr uint32_t RANDOM_SEED = 1337;
+
+	std::vector<uint32_t> GenerateRandomNumbers(uint64_t count);
+
+	// Instances are scattered through a cube around the origin, the queries look into it from random positions inside of it
+	static constexpr float WORLD_EXTENT = 500.0f;
+	static constexpr float MIN_INSTANCE_EXTENT = 0.5f;
+	static constexpr float MAX_INSTANCE_EXTENT = 5.0f;
+	// Instances moved by at most MAX_REFIT_OFFSET on every axis stay inside the fattened bounds of the AABB tree and keep their leaf,
+	// instances moved by REINSERT_OFFSET in any direction always leave them and have to be reinserted
+	static constexpr float MAX_REFIT_OFFSET = 0.8f * AABBTree::FAT_AABB_MARGIN;
+	static constexpr float REINSERT_OFFSET = 10.0f * AABBTree::FAT_AABB_MARGIN;
+	static constexpr float QUERY_EXTENT = 25.0f;
+	static constexpr float RAY_LENGTH = 1000.0f;
+
+	struct AABBTreeQueries
+	{
+		std::vector<Frustum> frustums;
+		std::vector<AABB> overlap_aabbs;
+		std::vector<glm::vec3> ray_origins;
+		std::vector<glm::vec3> ray_directions;
+	};
+
+	glm::vec3 RandomVec3(std::mt19937& rng, float min, float max);
+	std::vector<AABB> GenerateRandomAABBs(std::mt19937& rng, uint32_t count);
+	AABBTreeQueries GenerateAABBTreeQueries(std::mt19937& rng, uint32_t num_frustums, uint32_t num_overlaps, uint32_t num_rays);
+
+	// Bounding spheres in the layout the culling kernels read, scattered through the same world as the AABBs
+	struct SoABoundingSpheres
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		std::vector<float> radius;
+
+		FrustumCulling::BoundingSpheres Get() const { return { x.data(), y.data(), z.data(), radius.data() }; }
+	};
+
+	SoABoundingSpheres GenerateRandomBoundingSpheres(std::mt19937& rng, uint32_t count);
+
+	// Every group has one root entity with meshes and an area light as its children
+	static constexpr uint32_t SCENE_GROUP_SIZE = 10;
+
+	void CreateRandomScene(Scene& scene, std::mt19937& rng, uint32_t num_entities);
+
+	// Mirrors a descriptor buffer, a simulated frame ends every NUM_OPS_PER_FRAME operations, after which the frees of the frame
+	// NUM_FRAMES_IN_FLIGHT frames ago are released, like Vulkan::Descriptor does at the beginning of every frame
+	static constexpr uint32_t DESCRIPTOR_ALLOCATOR_MAX_LIVE_ALLOCATIONS = 2048;
+	static constexpr uint32_t DESCRIPTOR_ALLOCATOR_MAX_RANGE_SIZE = 8;
+	static constexpr uint32_t DESCRIPTOR_ALLOCATOR_NUM_OPS_PER_FRAME = 256;
+	static constexpr uint32_t DESCRIPTOR_ALLOCATOR_NUM_FRAMES_IN_FLIGHT = 2;
+
+	struct DescriptorRange
+	{
+		uint32_t offset = 0;
+		uint32_t num_descriptors = 0;
+	};
+
+	// Most allocations are single descriptors, every fourth allocation is a range, frees pick a random live allocation
+	// When the allocator runs out of descriptors it doubles in size, like a descriptor heap
+	// When validating, every descriptor is tracked to check that live and pending allocations never overlap with new allocations
+	template<bool VALIDATE>
+	void SimulateDescriptorAllocations(DescriptorAllocator& allocator, const std::vector<uint32_t>& random_numbers)
+	{
+		std::vector<DescriptorRange> live_ranges;
+		live_ranges.reserve(DESCRIPTOR_ALLOCATOR_MAX_LIVE_ALLOCATIONS);
+
+		std::vector<uint8_t> is_owned;
+		std::queue<std::pair<uint64_t, DescriptorRange>> pending_frees;
+		if constexpr (VALIDATE)
+			is_owned.resize(allocator.GetNumDescriptors(), 0);
+
+		uint64_t frame_index = 0;
+		for (size_t i = 0; i < random_numbers.size(); ++i)
+		{
+			uint32_t random_number = random_numbers[i];
+			bool allocate = live_ranges.empty() || (live_ranges.size() < DESCRIPTOR_ALLOCATOR_MAX_LIVE_ALLOCATIONS && (random_number & 1));
+
+			if (allocate)
+			{
+				bool is_range = ((random_number >> 1) & 3) == 0;
+				uint32_t num_descriptors = is_range ? 2 + (random_number >> 3) % (DESCRIPTOR_ALLOCATOR_MAX_RANGE_SIZE - 1) : 1;
+
+				DescriptorRange range = { allocator.Allocate(num_descriptors), num_descriptors };
+				if (range.offset == DescriptorAllocator::INVALID_OFFSET)
+				{
+					allocator.Grow(allocator.GetNumDescriptors() * 2);
+					if constexpr (VALIDATE)
+					{
+						is_owned.resize(allocator.GetNumDescriptors(), 0);
+						if (!allocator.Validate())
+						{
+							VK_EXCEPT("DescriptorAllocator", "Descriptor allocator is inconsistent after growing to {} descriptors", allocator.GetNumDescriptors());
+						}
+					}
+
+					range.offset = allocator.Allocate(num_descriptors);
+					if (range.offset == DescriptorAllocator::INVALID_OFFSET)
+					{
+						VK_EXCEPT("DescriptorAllocator", "Descriptor allocator ran out of descriptors after growing");
+					}
+				}
+
+				if constexpr (VALIDATE)
+				{
+					for (uint32_t descriptor = range.offset; descriptor < range.offset + range.num_descriptors; ++descriptor)
+					{
+						if (is_owned[descriptor])
+						{
+							VK_EXCEPT("DescriptorAllocator", "Descriptor allocator handed out descriptor {} while it was still in use", descriptor);
+						}
+						is_owned[descriptor] = 1;
+					}
+				}
+
+				live_ranges.push_back(range);
+			}
+			else
+			{
+				size_t live_index = (random_number >> 1) % live_ranges.size();
+				DescriptorRange range = live_ranges[live_index];
+				allocator.Free(range.offset, range.num_descriptors, frame_index);
+
+				if constexpr (VALIDATE)
+					pending_frees.emplace(frame_index, range);
+
+				live_ranges[live_index] = live_ranges.back();
+				live_ranges.pop_back();
+			}
+
+			if ((i + 1) % DESCRIPTOR_ALLOCATOR_NUM_OPS_PER_FRAME == 0)
+			{
+				frame_index++;
+				if (frame_index >= DESCRIPTOR_ALLOCATOR_NUM_FRAMES_IN_FLIGHT)
+				{
+					uint64_t finished_frame_index = frame_index - DESCRIPTOR_ALLOCATOR_NUM_FRAMES_IN_FLIGHT;
+					allocator.ReleaseFrees(finished_frame_index);
+
+					if constexpr (VALIDATE)
+					{
+						while (!pending_frees.empty() && pending_frees.front().first <= finished_frame_index)
+						{
+							const DescriptorRange& range = pending_frees.front().second;
+							std::fill_n(is_owned.begin() + range.offset, range.num_descriptors, 0);
+							pending_frees.pop();
+						}
+
+						if (!allocator.Validate())
+						{
+							VK_EXCEPT("DescriptorAllocator", "Descriptor allocator is inconsistent after frame {}", frame_index);
+						}
+					}
+				}
+			}
+		}
+
+		for (const DescriptorRange& range : live_ranges)
+			allocator.Free(range.offset, range.num_descriptors, frame_index);
+		allocator.ReleaseFrees(frame_index);
+
+		if constexpr (VALIDATE)
+		{
+			if (!allocator.Validate() || allocator.GetNumFreeDescriptors() != allocator.GetNumDescriptors())
+			{
+				VK_EXCEPT("DescriptorAllocator", "Descriptor allocator did not return to its initial state after freeing everything");
+			}
+		}
+	}
+
+}
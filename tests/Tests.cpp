@@ -0,0 +1,393 @@
+#include "Precomp.h"
+#include "TestData.h"
+#include "renderer/DescriptorAllocator.h"
+#include "AABBTree.h"
+#include "Scene.h"
+#include "renderer/Renderer.h"
+
+/*
+
+	Randomized correctness tests for the renderer data structures, which run without a GPU or window
+	Every test throws through VK_EXCEPT on the first mismatch, the process exits with a non-zero code if any test failed
+
+	Usage: Tests [TEST...], runs all tests if no test names are given
+
+*/
+
+namespace Tests
+{
+
+	// Starts out small, so that the allocator has to grow like the descriptor heaps do
+	static constexpr uint32_t DESCRIPTOR_ALLOCATOR_NUM_DESCRIPTORS = 256;
+	static constexpr uint64_t DESCRIPTOR_ALLOCATOR_NUM_OPS = 100000;
+
+	static void TestDescriptorAllocator()
+	{
+		DescriptorAllocator allocator(DESCRIPTOR_ALLOCATOR_NUM_DESCRIPTORS);
+		TestData::SimulateDescriptorAllocations<true>(allocator, TestData::GenerateRandomNumbers(DESCRIPTOR_ALLOCATOR_NUM_OPS));
+
+		// Single descriptor chunks go back to the range allocator once they are free, so everything fits in one range again
+		if (allocator.Allocate(allocator.GetNumDescriptors()) != 0 || !allocator.Validate())
+		{
+			VK_EXCEPT("DescriptorAllocator", "Descriptor allocator could not allocate all {} descriptors as one range after freeing everything", allocator.GetNumDescriptors());
+		}
+
+		LOG_INFO("Tests", "Descriptor allocator stayed consistent for {} random allocations and frees, growing to {} descriptors",
+			DESCRIPTOR_ALLOCATOR_NUM_OPS, allocator.GetNumDescriptors());
+	}
+
+	static AABB GetFatAABB(const AABB& aabb)
+	{
+		return { aabb.min - AABBTree::FAT_AABB_MARGIN, aabb.max + AABBTree::FAT_AABB_MARGIN };
+	}
+
+	// Checks every query against a brute force loop over the fattened bounds, which is what the tree stores in its leaves
+	static void ValidateAABBTree(const AABBTree& tree, const std::vector<AABB>& fat_aabbs, const TestData::AABBTreeQueries& queries)
+	{
+		if (!tree.Validate() || tree.GetSize() != fat_aabbs.size())
+		{
+			VK_EXCEPT("AABBTree", "AABB tree is inconsistent");
+		}
+
+		std::vector<EntityHandle> entities;
+		std::vector<uint8_t> is_returned(fat_aabbs.size());
+
+		// is_consistent(aabb, is_returned) checks a single entity against the query
+		auto check_returned = [&](const char* query_name, uint32_t query_index, auto&& is_consistent)
+		{
+			std::fill(is_returned.begin(), is_returned.end(), 0);
+			for (EntityHandle entity : entities)
+			{
+				if (is_returned[entity.index]++)
+				{
+					VK_EXCEPT("AABBTree", "AABB tree {} query {} returned entity {} more than once", query_name, query_index, entity.index);
+				}
+			}
+
+			for (uint32_t i = 0; i < fat_aabbs.size(); ++i)
+			{
+				if (!is_consistent(fat_aabbs[i], is_returned[i] != 0))
+				{
+					VK_EXCEPT("AABBTree", "AABB tree {} query {} does not match the brute force result for entity {}", query_name, query_index, i);
+				}
+			}
+		};
+
+		for (uint32_t i = 0; i < queries.frustums.size(); ++i)
+		{
+			const Frustum& frustum = queries.frustums[i];
+			entities.clear();
+			tree.QueryFrustum(frustum, entities);
+
+			// The tree evaluates the planes in a different order, so entities that are within rounding distance of a plane can go either way
+			check_returned("frustum", i, [&](const AABB& aabb, bool is_returned)
+			{
+				float min_distance = FLT_MAX;
+				for (const glm::vec4& plane : frustum.planes)
+				{
+					glm::vec3 normal = glm::vec3(plane);
+					min_distance = std::min(min_distance, glm::dot(normal, aabb.GetCenter()) + plane.w + glm::dot(glm::abs(normal), aabb.GetExtent()));
+				}
+				return std::abs(min_distance) < 0.001f || (min_distance >= 0.0f) == is_returned;
+			});
+		}
+
+		for (uint32_t i = 0; i < queries.overlap_aabbs.size(); ++i)
+		{
+			entities.clear();
+			tree.QueryOverlap(queries.overlap_aabbs[i], entities);
+
+			check_returned("overlap", i, [&](const AABB& aabb, bool is_returned)
+			{
+				return aabb.Overlaps(queries.overlap_aabbs[i]) == is_returned;
+			});
+		}
+
+		for (uint32_t i = 0; i < queries.ray_origins.size(); ++i)
+		{
+			const glm::vec3& origin = queries.ray_origins[i];
+			glm::vec3 inv_direction = 1.0f / queries.ray_directions[i];
+
+			float closest_distance = TestData::RAY_LENGTH;
+			bool is_hit = false;
+			auto intersect_ray = [&](const AABB& aabb, float& enter_distance)
+			{
+				glm::vec3 t0 = (aabb.min - origin) * inv_direction;
+				glm::vec3 t1 = (aabb.max - origin) * inv_direction;
+				glm::vec3 t_min = glm::min(t0, t1);
+				glm::vec3 t_max = glm::max(t0, t1);
+
+				enter_distance = std::max(std::max(t_min.x, t_min.y), std::max(t_min.z, 0.0f));
+				return enter_distance <= std::min(std::min(t_max.x, t_max.y), std::min(t_max.z, TestData::RAY_LENGTH));
+			};
+
+			entities.clear();
+			tree.QueryRay(origin, queries.ray_directions[i], TestData::RAY_LENGTH, entities);
+
+			check_returned("ray", i, [&](const AABB& aabb, bool is_returned)
+			{
+				float enter_distance = 0.0f;
+				if (!intersect_ray(aabb, enter_distance))
+					return !is_returned;
+
+				is_hit = true;
+				closest_distance = std::min(closest_distance, enter_distance);
+				return is_returned;
+			});
+
+			float hit_distance = 0.0f;
+			EntityHandle hit_entity = tree.RayCast(origin, queries.ray_directions[i], TestData::RAY_LENGTH, &hit_distance);
+			if (is_hit != VK_RESOURCE_HANDLE_VALID(hit_entity) || (is_hit && std::abs(hit_distance - closest_distance) > 0.001f))
+			{
+				VK_EXCEPT("AABBTree", "AABB tree ray cast {} does not match the brute force closest hit", i);
+			}
+		}
+	}
+
+	// Every query is checked after building, after small and large moves, and after removing and reinserting part of the entities
+	static constexpr uint32_t AABB_TREE_NUM_INSTANCES = 10000;
+
+	static void TestAABBTree()
+	{
+		std::mt19937 rng(TestData::RANDOM_SEED);
+		std::vector<AABB> aabbs = TestData::GenerateRandomAABBs(rng, AABB_TREE_NUM_INSTANCES);
+		TestData::AABBTreeQueries queries = TestData::GenerateAABBTreeQueries(rng, 100, 1000, 1000);
+
+		// Entities that stay inside their fattened bounds keep them, so the expected bounds are tracked next to the tree
+		std::vector<AABB> fat_aabbs(aabbs.size());
+
+		AABBTree tree;
+		for (uint32_t i = 0; i < aabbs.size(); ++i)
+		{
+			tree.Insert(EntityHandle(i), aabbs[i]);
+			fat_aabbs[i] = GetFatAABB(aabbs[i]);
+		}
+		ValidateAABBTree(tree, fat_aabbs, queries);
+
+		for (uint32_t i = 0; i < aabbs.size(); ++i)
+		{
+			glm::vec3 offset = TestData::RandomVec3(rng, -TestData::MAX_REFIT_OFFSET, TestData::MAX_REFIT_OFFSET);
+			aabbs[i].min += offset;
+			aabbs[i].max += offset;
+
+			if (tree.Update(EntityHandle(i), aabbs[i]))
+			{
+				VK_EXCEPT("AABBTree", "AABB tree reinserted entity {} which stayed inside its fattened bounds", i);
+			}
+		}
+		ValidateAABBTree(tree, fat_aabbs, queries);
+
+		// Every other entity is moved out of its fattened bounds
+		for (uint32_t i = 0; i < aabbs.size(); i += 2)
+		{
+			glm::vec3 offset = glm::normalize(TestData::RandomVec3(rng, -1.0f, 1.0f)) * TestData::REINSERT_OFFSET;
+			aabbs[i].min += offset;
+			aabbs[i].max += offset;
+
+			if (!tree.Update(EntityHandle(i), aabbs[i]))
+			{
+				VK_EXCEPT("AABBTree", "AABB tree did not reinsert entity {} which left its fattened bounds", i);
+			}
+			fat_aabbs[i] = GetFatAABB(aabbs[i]);
+		}
+		ValidateAABBTree(tree, fat_aabbs, queries);
+
+		std::vector<AABB> new_aabbs = TestData::GenerateRandomAABBs(rng, (uint32_t)aabbs.size());
+		for (uint32_t i = 0; i < aabbs.size(); i += 3)
+			tree.Remove(EntityHandle(i));
+		for (uint32_t i = 0; i < aabbs.size(); i += 3)
+		{
+			tree.Insert(EntityHandle(i), new_aabbs[i]);
+			fat_aabbs[i] = GetFatAABB(new_aabbs[i]);
+		}
+		ValidateAABBTree(tree, fat_aabbs, queries);
+
+		LOG_INFO("Tests", "AABB tree queries match brute force for {} entities, height {}", AABB_TREE_NUM_INSTANCES, tree.GetHeight());
+	}
+
+	// The SIMD kernels need to be conservative, they may never cull a sphere that the scalar reference keeps
+	// Both sum the plane distances in the same order, so the results are expected to match exactly
+	static void ValidateFrustumCulling(std::span<const uint32_t> reference_indices, std::span<const uint32_t> visible_indices, const char* kernel_name)
+	{
+		size_t num_compared = std::min(reference_indices.size(), visible_indices.size());
+		for (size_t i = 0; i < num_compared; ++i)
+		{
+			if (visible_indices[i] > reference_indices[i])
+			{
+				VK_EXCEPT("FrustumCulling", "{} culled sphere {} which the scalar reference keeps", kernel_name, reference_indices[i]);
+			}
+			if (visible_indices[i] < reference_indices[i])
+			{
+				VK_EXCEPT("FrustumCulling", "{} kept sphere {} which the scalar reference culls", kernel_name, visible_indices[i]);
+			}
+		}
+
+		if (visible_indices.size() < reference_indices.size())
+		{
+			VK_EXCEPT("FrustumCulling", "{} culled sphere {} which the scalar reference keeps", kernel_name, reference_indices[num_compared]);
+		}
+		if (visible_indices.size() > reference_indices.size())
+		{
+			VK_EXCEPT("FrustumCulling", "{} kept sphere {} which the scalar reference culls", kernel_name, visible_indices[num_compared]);
+		}
+	}
+
+	// The sphere count is not a multiple of 8, so that the scalar tail of the SIMD kernels is covered too
+	static constexpr uint32_t FRUSTUM_CULLING_NUM_SPHERES = 100003;
+	static constexpr uint32_t FRUSTUM_CULLING_NUM_FRUSTUMS = 100;
+	static constexpr uint32_t FRUSTUM_CULLING_MAX_THREADS = 8;
+
+	static void TestFrustumCulling()
+	{
+		std::mt19937 rng(TestData::RANDOM_SEED);
+		TestData::SoABoundingSpheres spheres = TestData::GenerateRandomBoundingSpheres(rng, FRUSTUM_CULLING_NUM_SPHERES);
+		TestData::AABBTreeQueries queries = TestData::GenerateAABBTreeQueries(rng, FRUSTUM_CULLING_NUM_FRUSTUMS, 0, 0);
+
+		std::vector<uint32_t> reference_indices(FRUSTUM_CULLING_NUM_SPHERES);
+		std::vector<uint32_t> visible_indices(FRUSTUM_CULLING_NUM_SPHERES);
+
+		for (const Frustum& frustum : queries.frustums)
+		{
+			uint32_t num_reference = FrustumCulling::CullSpheresScalar(frustum, spheres.Get(), 0, FRUSTUM_CULLING_NUM_SPHERES, reference_indices.data());
+			std::span<const uint32_t> reference = { reference_indices.data(), num_reference };
+
+			uint32_t num_visible = FrustumCulling::CullSpheres(frustum, spheres.Get(), 0, FRUSTUM_CULLING_NUM_SPHERES, visible_indices.data());
+			ValidateFrustumCulling(reference, { visible_indices.data(), num_visible }, "FrustumCulling::CullSpheres");
+
+			num_visible = FrustumCulling::CullSpheresParallel(frustum, spheres.Get(), FRUSTUM_CULLING_NUM_SPHERES, visible_indices.data(), FRUSTUM_CULLING_MAX_THREADS);
+			ValidateFrustumCulling(reference, { visible_indices.data(), num_visible }, "FrustumCulling::CullSpheresParallel");
+		}
+
+		LOG_INFO("Tests", "Frustum culling kernels match the scalar reference for {} spheres and {} frustums", FRUSTUM_CULLING_NUM_SPHERES, FRUSTUM_CULLING_NUM_FRUSTUMS);
+	}
+
+	// A scene that is loaded and serialized again has to produce exactly the same bytes
+	static constexpr uint32_t SCENE_NUM_ENTITIES = 10000;
+
+	static void TestScene()
+	{
+		std::mt19937 rng(TestData::RANDOM_SEED);
+
+		Scene scene;
+		TestData::CreateRandomScene(scene, rng, SCENE_NUM_ENTITIES);
+		std::vector<uint8_t> bytes = scene.Serialize();
+
+		Scene loaded_scene;
+		if (!loaded_scene.Deserialize(bytes))
+		{
+			VK_EXCEPT("Scene", "Scene::Deserialize rejected a scene that was just serialized");
+		}
+		if (loaded_scene.GetNumEntities() != scene.GetNumEntities() || loaded_scene.GetNumMeshes() != scene.GetNumMeshes() ||
+			loaded_scene.GetNumAreaLights() != scene.GetNumAreaLights())
+		{
+			VK_EXCEPT("Scene", "Scene::Deserialize loaded {} entities, {} meshes and {} area lights, expected {}, {} and {}",
+				loaded_scene.GetNumEntities(), loaded_scene.GetNumMeshes(), loaded_scene.GetNumAreaLights(),
+				scene.GetNumEntities(), scene.GetNumMeshes(), scene.GetNumAreaLights());
+		}
+		if (loaded_scene.Serialize() != bytes)
+		{
+			VK_EXCEPT("Scene", "Scene serialization round trip does not reproduce the same scene file");
+		}
+
+		loaded_scene.Clear();
+		scene.Clear();
+
+		LOG_INFO("Tests", "Scene serialization round trip matches for {} entities", SCENE_NUM_ENTITIES);
+	}
+
+	// The mocked renderer gives every mesh the bounds of the unit cube, the camera stands inside of a large mesh, like the walls of a room
+	static void TestScenePicking()
+	{
+		Scene scene;
+		EntityHandle room_entity = scene.CreateMeshEntity("Room", RenderResourceHandle(), Renderer::CreateMaterial(MaterialAsset()),
+			glm::scale(glm::identity<glm::mat4>(), glm::vec3(100.0f)));
+
+		EntityHandle row_entity = scene.CreateEntity("Row", glm::translate(glm::identity<glm::mat4>(), glm::vec3(0.0f, 0.0f, -5.0f)));
+		std::vector<EntityHandle> mesh_entities;
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			glm::mat4 transform = glm::translate(glm::identity<glm::mat4>(), glm::vec3(0.0f, 0.0f, -5.0f * i));
+			mesh_entities.push_back(scene.CreateMeshEntity(std::format("Mesh {}", i), RenderResourceHandle(), Renderer::CreateMaterial(MaterialAsset()), transform, row_entity));
+		}
+		scene.Render();
+
+		Camera camera(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), 60.0f);
+		glm::vec3 origin, direction;
+		camera.GetViewRay(0.0f, 0.0f, 16.0f / 9.0f, origin, direction);
+		if (glm::length(origin) > 0.001f || glm::length(direction - glm::vec3(0.0f, 0.0f, -1.0f)) > 0.001f)
+		{
+			VK_EXCEPT("Scene", "Camera::GetViewRay does not go through the center of the screen along the view direction");
+		}
+
+		if (!(scene.PickEntity(origin, direction) == mesh_entities[0]))
+		{
+			VK_EXCEPT("Scene", "Scene::PickEntity did not pick the closest mesh in front of the camera");
+		}
+		if (!(scene.PickEntity(origin, -direction) == room_entity))
+		{
+			VK_EXCEPT("Scene", "Scene::PickEntity did not fall back to the mesh around the camera");
+		}
+
+		// Destroyed entities are removed from the tree, so the ray goes on to the next mesh
+		scene.DestroyEntity(mesh_entities[0]);
+		scene.Render();
+		if (!(scene.PickEntity(origin, direction) == mesh_entities[1]))
+		{
+			VK_EXCEPT("Scene", "Scene::PickEntity picked an entity that was destroyed");
+		}
+
+		scene.Clear();
+		LOG_INFO("Tests", "Scene picking returns the closest entity");
+	}
+
+	struct Test
+	{
+		const char* name;
+		void(*func)();
+	};
+
+	static constexpr Test TESTS[] =
+	{
+		{ "DescriptorAllocator", TestDescriptorAllocator },
+		{ "AABBTree", TestAABBTree },
+		{ "FrustumCulling", TestFrustumCulling },
+		{ "Scene", TestScene },
+		{ "ScenePicking", TestScenePicking },
+	};
+
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string_view> test_names(argv + 1, argv + argc);
+	uint32_t num_run = 0;
+	uint32_t num_failed = 0;
+
+	for (const Tests::Test& test : Tests::TESTS)
+	{
+		if (!test_names.empty() && std::find(test_names.begin(), test_names.end(), test.name) == test_names.end())
+			continue;
+
+		num_run++;
+		try
+		{
+			test.func();
+			LOG_INFO("Tests", "{} passed", test.name);
+		}
+		catch (const std::exception&)
+		{
+			// The reason has already been logged by VK_EXCEPT
+			LOG_ERR("Tests", "{} failed", test.name);
+			num_failed++;
+		}
+	}
+
+	if (num_run < std::max<size_t>(test_names.size(), 1))
+	{
+		LOG_ERR("Tests", "Ran {} tests, some of the requested tests do not exist", num_run);
+		return 1;
+	}
+
+	LOG_INFO("Tests", "{} of {} tests passed", num_run - num_failed, num_run);
+	return num_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+#include "Precomp.h"
+#include "renderer/vulkan/VulkanUtils.h"
+#include "renderer/vulkan/VulkanInstance.h"
+#include "renderer/vulkan/VulkanBackend.h"
+#include "renderer/vulkan/VulkanBuffer.h"
+#include "renderer/vulkan/VulkanDeviceMemory.h"
+#include "renderer/vulkan/VulkanCommands.h"
+
+/*
+
+	Stand-ins for the parts of the Vulkan backend that the CPU-side renderer code calls into, so that the ring buffer
+	and the TLAS instance packing can be linked and measured without a Vulkan device
+	Buffers live in host memory, the mocked device memory handle points at the host allocation
+
+*/
+
+namespace Vulkan
+{
+
+	VulkanInstance vk_inst;
+
+	void VkCheckResult(VkResult result)
+	{
+		if (result != VK_SUCCESS)
+		{
+			VK_EXCEPT("Vulkan", string_VkResult(result));
+		}
+	}
+
+	uint32_t GetCurrentFrameIndex()
+	{
+		return vk_inst.current_frame_index;
+	}
+
+	uint32_t GetLastFinishedFrameIndex()
+	{
+		return std::max(0, (int32_t)vk_inst.current_frame_index - (int32_t)vk_inst.num_frames_in_flight);
+	}
+
+	namespace Buffer
+	{
+
+		VulkanBuffer CreateAccelerationStructure(uint64_t size_in_bytes, const std::string& name, bool async_compute_shared)
+		{
+			BufferCreateInfo buffer_info = {};
+			buffer_info.size_in_bytes = size_in_bytes;
+			buffer_info.async_compute_shared = async_compute_shared;
+			buffer_info.name = name;
+
+			return Create(buffer_info);
+		}
+
+		VulkanBuffer CreateAccelerationStructureScratch(uint64_t size_in_bytes, const std::string& name)
+		{
+			BufferCreateInfo buffer_info = {};
+			buffer_info.size_in_bytes = size_in_bytes;
+			buffer_info.name = name;
+
+			return Create(buffer_info);
+		}
+
+		VulkanBuffer CreateAccelerationStructureInstances(uint64_t size_in_bytes, const std::string& name)
+		{
+			BufferCreateInfo buffer_info = {};
+			buffer_info.size_in_bytes = size_in_bytes;
+			buffer_info.memory_flags = GPU_MEMORY_HOST_VISIBLE | GPU_MEMORY_HOST_COHERENT;
+			buffer_info.name = name;
+
+			return Create(buffer_info);
+		}
+
+		VulkanBuffer Create(const BufferCreateInfo& buffer_info)
+		{
+			VulkanBuffer buffer = {};
+			buffer.size_in_bytes = buffer_info.size_in_bytes;
+			buffer.memory.vk_device_memory = reinterpret_cast<VkDeviceMemory>(new uint8_t[buffer_info.size_in_bytes]);
+			buffer.memory.byte_size = buffer_info.size_in_bytes;
+
+			return buffer;
+		}
+
+		void Destroy(VulkanBuffer& buffer)
+		{
+			delete[] reinterpret_cast<uint8_t*>(buffer.memory.vk_device_memory);
+			buffer = {};
+		}
+
+	}
+
+	namespace DeviceMemory
+	{
+
+		void* Map(const VulkanMemory& device_memory, uint64_t size, uint64_t offset)
+		{
+			VK_ASSERT(offset + size <= device_memory.byte_size && "Tried to map memory outside of the device memory");
+			return reinterpret_cast<uint8_t*>(device_memory.vk_device_memory) + offset;
+		}
+
+		void Unmap(const VulkanMemory&)
+		{
+		}
+
+	}
+
+	namespace Command
+	{
+
+		void FlushBarriers(VulkanCommandBuffer&)
+		{
+		}
+
+	}
+
+	namespace Util
+	{
+
+		VkDeviceAddress GetBufferDeviceAddress(const VulkanBuffer& buffer)
+		{
+			return reinterpret_cast<VkDeviceAddress>(buffer.memory.vk_device_memory) + buffer.offset_in_bytes;
+		}
+
+		VkDeviceAddress GetAccelerationStructureDeviceAddress(VkAccelerationStructureKHR acceleration_structure)
+		{
+			return reinterpret_cast<VkDeviceAddress>(acceleration_structure);
+		}
+
+	}
+
+}